@@ -48,13 +48,13 @@
 #ifdef HAVE_LIBACL
 
 static int CheckPosixLinuxAccessACEs(EvalContext *ctx, Rlist *aces, AclMethod method, const char *file_path,
-                                     Attributes a, const Promise *pp, PromiseResult *result);
+                                     const Attributes *a, const Promise *pp, PromiseResult *result);
 static int CheckPosixLinuxDefaultACEs(EvalContext *ctx, Rlist *aces, AclMethod method, AclDefault acl_default,
-                                      const char *file_path, Attributes a, const Promise *pp, PromiseResult *result);
-static int CheckPosixLinuxACEs(EvalContext *ctx, Rlist *aces, AclMethod method, const char *file_path, acl_type_t acl_type, Attributes a,
+                                      const char *file_path, const Attributes *a, const Promise *pp, PromiseResult *result);
+static int CheckPosixLinuxACEs(EvalContext *ctx, Rlist *aces, AclMethod method, const char *file_path, acl_type_t acl_type, const Attributes *a,
                                const Promise *pp, PromiseResult *result);
-static int CheckDefaultEqualsAccessACL(EvalContext *ctx, const char *file_path, Attributes a, const Promise *pp, PromiseResult *result);
-static int CheckDefaultClearACL(EvalContext *ctx, const char *file_path, Attributes a, const Promise *pp, PromiseResult *result);
+static int CheckDefaultEqualsAccessACL(EvalContext *ctx, const char *file_path, const Attributes *a, const Promise *pp, PromiseResult *result);
+static int CheckDefaultClearACL(EvalContext *ctx, const char *file_path, const Attributes *a, const Promise *pp, PromiseResult *result);
 static int ParseEntityPosixLinux(char **str, acl_entry_t ace, int *is_mask);
 static int ParseModePosixLinux(char *mode, acl_permset_t old_perms);
 static acl_entry_t FindACE(acl_t acl, acl_entry_t ace_find);
@@ -63,7 +63,7 @@ static int ACECount(acl_t acl);
 static int PermsetEquals(acl_permset_t first, acl_permset_t second);
 
 
-PromiseResult CheckPosixLinuxACL(EvalContext *ctx, const char *file_path, Acl acl, Attributes a, const Promise *pp)
+PromiseResult CheckPosixLinuxACL(EvalContext *ctx, const char *file_path, Acl acl, const Attributes *a, const Promise *pp)
 {
     PromiseResult result = PROMISE_RESULT_NOOP;
 
@@ -88,13 +88,13 @@ PromiseResult CheckPosixLinuxACL(EvalContext *ctx, const char *file_path, Acl ac
 }
 
 static int CheckPosixLinuxAccessACEs(EvalContext *ctx, Rlist *aces, AclMethod method, const char *file_path,
-                                     Attributes a, const Promise *pp, PromiseResult *result)
+                                     const Attributes *a, const Promise *pp, PromiseResult *result)
 {
     return CheckPosixLinuxACEs(ctx, aces, method, file_path, ACL_TYPE_ACCESS, a, pp, result);
 }
 
 static int CheckPosixLinuxDefaultACEs(EvalContext *ctx, Rlist *aces, AclMethod method, AclDefault acl_default,
-                                      const char *file_path, Attributes a, const Promise *pp, PromiseResult *result)
+                                      const char *file_path, const Attributes *a, const Promise *pp, PromiseResult *result)
 {
     int retval;
 
@@ -135,7 +135,7 @@ static int CheckPosixLinuxDefaultACEs(EvalContext *ctx, Rlist *aces, AclMethod m
    set on the given file. If it doesn't, the ACL on the file is updated.
 */
 
-static int CheckPosixLinuxACEs(EvalContext *ctx, Rlist *aces, AclMethod method, const char *file_path, acl_type_t acl_type, Attributes a,
+static int CheckPosixLinuxACEs(EvalContext *ctx, Rlist *aces, AclMethod method, const char *file_path, acl_type_t acl_type, const Attributes *a,
                                const Promise *pp, PromiseResult *result)
 {
     acl_t acl_existing;
@@ -329,7 +329,7 @@ static int CheckPosixLinuxACEs(EvalContext *ctx, Rlist *aces, AclMethod method,
     if (retv == 1)              // existing and new acl differ, update existing
     {
 
-        switch (a.transaction.action)
+        switch (a->transaction.action)
         {
         case cfa_warn:
 
@@ -402,7 +402,7 @@ static int CheckPosixLinuxACEs(EvalContext *ctx, Rlist *aces, AclMethod method,
   Returns 0 on success and -1 on failure.
  */
 
-static int CheckDefaultEqualsAccessACL(EvalContext *ctx, const char *file_path, Attributes a, const Promise *pp, PromiseResult *result)
+static int CheckDefaultEqualsAccessACL(EvalContext *ctx, const char *file_path, const Attributes *a, const Promise *pp, PromiseResult *result)
 {
     acl_t acl_access;
     acl_t acl_default;
@@ -438,7 +438,7 @@ static int CheckDefaultEqualsAccessACL(EvalContext *ctx, const char *file_path,
 
     case 1:                    // set access ACL as default ACL
 
-        switch (a.transaction.action)
+        switch (a->transaction.action)
         {
         case cfa_warn:
 
@@ -492,7 +492,7 @@ static int CheckDefaultEqualsAccessACL(EvalContext *ctx, const char *file_path,
   Checks if the default ACL is empty. If not, it is cleared.
 */
 
-int CheckDefaultClearACL(EvalContext *ctx, const char *file_path, Attributes a, const Promise *pp, PromiseResult *result)
+int CheckDefaultClearACL(EvalContext *ctx, const char *file_path, const Attributes *a, const Promise *pp, PromiseResult *result)
 {
     acl_t acl_existing;
     acl_t acl_empty;
@@ -532,7 +532,7 @@ int CheckDefaultClearACL(EvalContext *ctx, const char *file_path, Attributes a,
             break;
         }
 
-        switch (a.transaction.action)
+        switch (a->transaction.action)
         {
         case cfa_warn:
 
@@ -1137,7 +1137,7 @@ static int ParseModePosixLinux(char *mode, acl_permset_t perms)
 
 #else /* !HAVE_LIBACL */
 
-PromiseResult CheckPosixLinuxACL(EvalContext *ctx, ARG_UNUSED const char *file_path, ARG_UNUSED Acl acl, Attributes a, const Promise *pp)
+PromiseResult CheckPosixLinuxACL(EvalContext *ctx, ARG_UNUSED const char *file_path, ARG_UNUSED Acl acl, const Attributes *a, const Promise *pp)
 {
     cfPS(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_FAIL, pp, a,
          "Posix ACLs are not supported on this Linux system - install the Posix acl library");
@@ -28,7 +28,7 @@ ENTERPRISE_FUNC_8ARG_DEFINE_STUB(PromiseResult, LogFileChange,
                                  ARG_UNUSED EvalContext *, ctx,
                                  ARG_UNUSED const char *, file,
                                  ARG_UNUSED int, change,
-                                 ARG_UNUSED Attributes, a,
+                                 ARG_UNUSED const Attributes *, a,
                                  ARG_UNUSED const Promise *, pp,
                                  ARG_UNUSED CopyRegularFileFunction, CopyRegularFilePtr,
                                  ARG_UNUSED const char *, destination,
@@ -32,7 +32,7 @@
 #include <generic_agent.h>
 
 #if defined(__MINGW32__)
-PromiseResult VerifyRegistryPromise(EvalContext *ctx, Attributes a, const Promise *pp);
+PromiseResult VerifyRegistryPromise(EvalContext *ctx, const Attributes *a, const Promise *pp);
 #endif
 
 typedef bool (*CopyRegularFileFunction)(EvalContext *ctx,
@@ -40,7 +40,7 @@ typedef bool (*CopyRegularFileFunction)(EvalContext *ctx,
                                        const char *dest,
                                        struct stat sstat,
                                        struct stat dstat,
-                                       Attributes attr,
+                                       const Attributes *attr,
                                        const Promise *pp,
                                        CompressedArray **inode_cache,
                                        AgentConnection *conn,
@@ -50,7 +50,7 @@ ENTERPRISE_FUNC_8ARG_DECLARE(PromiseResult, LogFileChange,
                              EvalContext *, ctx,
                              const char *, file,
                              int, change,
-                             Attributes, a,
+                             const Attributes *, a,
                              const Promise *, pp,
                              CopyRegularFileFunction, CopyRegularFilePtr,
                              const char *, destination, DeleteCompressedArrayFunction, DeleteCompressedArrayPtr);
@@ -27,9 +27,9 @@
 
 #ifdef __MINGW32__
 
-PromiseResult VerifyWindowsService(EvalContext *ctx, Attributes a, Promise *pp);
+PromiseResult VerifyWindowsService(EvalContext *ctx, const Attributes *a, Promise *pp);
 PromiseResult Nova_CheckNtACL(EvalContext *ctx, const char *file_path, Acl acl,
-                              Attributes a, const Promise *pp);
+                              const Attributes *a, const Promise *pp);
 
 #endif // __MINGW32__
 
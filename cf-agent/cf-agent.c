@@ -57,6 +57,7 @@
 #include <matching.h>
 #include <match_scope.h>
 #include <instrumentation.h>
+#include <profiler.h>
 #include <promises.h>
 #include <unix.h>
 #include <attributes.h>
@@ -78,6 +79,7 @@
 #include <buffer.h>
 #include <loading.h>
 #include <conn_cache.h>                 /* ConnCache_Init,ConnCache_Destroy */
+#include <download_cache.h>
 #include <net.h>
 #include <package_module.h>
 #include <string_lib.h>
@@ -105,6 +107,7 @@ static const Rlist *ACCESSLIST = NULL; /* GLOBAL_P */
 
 static int CFA_BACKGROUND = 0; /* GLOBAL_X */
 static int CFA_BACKGROUND_LIMIT = 1; /* GLOBAL_P */
+static size_t SETTLED_PROMISES_SKIPPED = 0; /* GLOBAL_X */
 
 static Item *PROCESSREFRESH = NULL; /* GLOBAL_P */
 
@@ -147,6 +150,8 @@ static bool VerifyBootstrap(void);
 static void KeepPromiseBundles(EvalContext *ctx, const Policy *policy, GenericAgentConfig *config);
 static void KeepPromises(EvalContext *ctx, const Policy *policy, GenericAgentConfig *config);
 static int NoteBundleCompliance(const Bundle *bundle, int save_pr_kept, int save_pr_repaired, int save_pr_notkept, struct timespec start);
+static bool CanSettle(TypeSequence type);
+static void NoteSettledPromises(const Bundle *bundle, size_t skipped);
 static void AllClassesReport(const EvalContext *ctx);
 static bool HasAvahiSupport(void);
 static int AutomaticBootstrap(GenericAgentConfig *config);
@@ -191,6 +196,7 @@ static const struct option OPTIONS[] =
     {"log-modules", required_argument, 0, 0},
     {"show-evaluated-classes", optional_argument, 0, 0 },
     {"show-evaluated-vars", optional_argument, 0, 0 },
+    {"profile", no_argument, 0, 0 },
     {NULL, 0, 0, '\0'}
 };
 
@@ -218,6 +224,7 @@ static const char *const HINTS[] =
     "Enable even more detailed debug logging for specific areas of the implementation. Use together with '-d'. Use --log-modules=help for a list of available modules",
     "Show *final* evaluated classes, including those defined in common bundles in policy. Optionally can take a regular expression.",
     "Show *final* evaluated variables, including those defined without dependency to user-defined classes in policy. Optionally can take a regular expression.",
+    "Profile policy evaluation, writing flame graph input and a summary of the slowest promises and functions to the profile directory under the state directory",
     NULL
 };
 
@@ -255,7 +262,9 @@ int main(int argc, char *argv[])
     ThisAgentInit();
 
     BeginAudit();
+    DownloadCache_Init();
     KeepPromises(ctx, policy, config);
+    DownloadCache_Destroy();
 
     if (ALLCLASSESREPORT)
     {
@@ -297,6 +306,9 @@ int main(int argc, char *argv[])
 
     Nova_NoteAgentExecutionPerformance(config->input_file, start);
 
+    ProfilerWrite("cf-agent");
+    ProfilerStop();
+
     GenericAgentFinalize(ctx, config);
 
 #ifdef HAVE_LIBXML2
@@ -580,6 +592,10 @@ static GenericAgentConfig *CheckOpts(int argc, char **argv)
                 }
                 config->agent_specific.agent.show_evaluated_variables = xstrdup(optarg);
             }
+            else if (strcmp(OPTIONS[longopt_idx].name, "profile") == 0)
+            {
+                ProfilerStart();
+            }
     break;
 
         default:
@@ -1079,6 +1095,20 @@ static void KeepControlPromises(EvalContext *ctx, const Policy *policy, GenericA
                 continue;
             }
 
+            if (strcmp(cp->lval, CFA_CONTROLBODY[AGENT_CONTROL_CONCURRENT_COMMANDS].lval) == 0)
+            {
+                int concurrent_commands = IntFromString(value);
+                if (concurrent_commands == CF_NOINT || concurrent_commands < 1)
+                {
+                    Log(LOG_LEVEL_ERR, "Invalid value for concurrent_commands in agent control promise (%s)",
+                        (const char *) value);
+                    concurrent_commands = 1;
+                }
+                Log(LOG_LEVEL_VERBOSE, "Setting concurrent_commands to %d", concurrent_commands);
+                SetMaxConcurrentCommands(concurrent_commands);
+                continue;
+            }
+
             if (strcmp(cp->lval, CFA_CONTROLBODY[AGENT_CONTROL_ENVIRONMENT].lval) == 0)
             {
                 Log(LOG_LEVEL_VERBOSE, "Setting environment variables from ...");
@@ -1292,6 +1322,9 @@ static void KeepPromiseBundles(EvalContext *ctx, const Policy *policy, GenericAg
     }
 
     RlistDestroy(bundlesequence);
+
+    Log(LOG_LEVEL_VERBOSE, "Skipped %zu evaluations of promises that were already settled",
+        SETTLED_PROMISES_SKIPPED);
 }
 
 static void AllClassesReport(const EvalContext *ctx)
@@ -1335,6 +1368,12 @@ PromiseResult ScheduleAgentOperations(EvalContext *ctx, const Bundle *bp)
 
     PromiseResult result = PROMISE_RESULT_SKIPPED;
 
+    /* Promises KEPT in an earlier pass -> what they read then. Only for
+     * promise types that read nothing but variables and classes, evaluating
+     * them again gives the same result until some of it changes. */
+    Map *settled = MapNew(NULL, NULL, NULL, PromiseReadsDestroy_untyped);
+    size_t settled_skipped = 0;
+
     for (int pass = 1; pass < CF_DONEPASSES; pass++)
     {
         for (TypeSequence type = 0; AGENT_TYPESEQUENCE[type] != NULL; type++)
@@ -1360,18 +1399,61 @@ PromiseResult ScheduleAgentOperations(EvalContext *ctx, const Bundle *bp)
 
                 EvalContextSetPass(ctx, pass);
 
-                PromiseResult promise_result = ExpandPromise(ctx, pp, KeepAgentPromise, NULL);
+                if (type == TYPE_SEQUENCE_COMMANDS)
+                {
+                    result = PromiseResultUpdate(result, CollectConcurrentCommands(ctx, pp));
+                }
+
+                PromiseResult promise_result;
+                if (CanSettle(type))
+                {
+                    PromiseReads *reads = MapGet(settled, pp);
+                    if (reads != NULL && !EvalContextPromiseReadsChanged(ctx, reads))
+                    {
+                        settled_skipped++;
+                        continue;
+                    }
+                    if (reads == NULL)
+                    {
+                        reads = PromiseReadsNew();
+                        MapInsert(settled, pp, reads);
+                    }
+
+                    EvalContextPushPromiseReads(ctx, reads);
+                    promise_result = ExpandPromise(ctx, pp, KeepAgentPromise, NULL);
+                    EvalContextPopPromiseReads(ctx);
+
+                    if (promise_result != PROMISE_RESULT_NOOP)
+                    {
+                        MapRemove(settled, pp);
+                    }
+                }
+                else
+                {
+                    promise_result = ExpandPromise(ctx, pp, KeepAgentPromise, NULL);
+                }
                 result = PromiseResultUpdate(result, promise_result);
 
                 if (Abort(ctx))
                 {
+                    if (type == TYPE_SEQUENCE_COMMANDS)
+                    {
+                        result = PromiseResultUpdate(result, CollectConcurrentCommands(ctx, NULL));
+                    }
                     DeleteTypeContext(ctx, type);
                     EvalContextStackPopFrame(ctx);
+                    MapDestroy(settled);
+                    NoteSettledPromises(bp, settled_skipped);
                     NoteBundleCompliance(bp, save_pr_kept, save_pr_repaired, save_pr_notkept, start);
                     return result;
                 }
             }
 
+            if (type == TYPE_SEQUENCE_COMMANDS)
+            {
+                result = PromiseResultUpdate(result, CollectConcurrentCommands(ctx, NULL));
+            }
+
             DeleteTypeContext(ctx, type);
             EvalContextStackPopFrame(ctx);
 
@@ -1383,6 +1465,8 @@ PromiseResult ScheduleAgentOperations(EvalContext *ctx, const Bundle *bp)
         }
     }
 
+    MapDestroy(settled);
+    NoteSettledPromises(bp, settled_skipped);
     NoteBundleCompliance(bp, save_pr_kept, save_pr_repaired, save_pr_notkept, start);
     return result;
 }
@@ -1927,6 +2011,32 @@ static bool VerifyBootstrap(void)
 /* Compliance comp                                            */
 /**************************************************************/
 
+/* Promises of other types verify system state, which can change between
+ * passes without any variable or class changing. */
+static bool CanSettle(TypeSequence type)
+{
+    switch (type)
+    {
+    case TYPE_SEQUENCE_META:
+    case TYPE_SEQUENCE_VARS:
+    case TYPE_SEQUENCE_DEFAULTS:
+    case TYPE_SEQUENCE_CONTEXTS:
+        return true;
+    default:
+        return false;
+    }
+}
+
+static void NoteSettledPromises(const Bundle *bundle, size_t skipped)
+{
+    if (skipped > 0)
+    {
+        SETTLED_PROMISES_SKIPPED += skipped;
+        Log(LOG_LEVEL_VERBOSE, "A: Evaluations of settled promises skipped in '%s' = %zu",
+            bundle->name, skipped);
+    }
+}
+
 static int NoteBundleCompliance(const Bundle *bundle, int save_pr_kept, int save_pr_repaired, int save_pr_notkept, struct timespec start)
 {
     double delta_pr_kept, delta_pr_repaired, delta_pr_notkept;
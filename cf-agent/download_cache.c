@@ -0,0 +1,262 @@
+/*
+   Copyright 2018 Northern.tech AS
+
+   This file is part of CFEngine 3 - written and maintained by Northern.tech AS.
+
+   This program is free software; you can redistribute it and/or modify it
+   under the terms of the GNU General Public License as published by the
+   Free Software Foundation; version 3.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA
+
+  To the extent this program is licensed as part of the Enterprise
+  versions of CFEngine, the applicable Commercial Open Source License
+  (COSL) may apply to this file if you as a licensee so wish it. See
+  included file COSL.txt.
+*/
+
+#include <download_cache.h>
+
+#include <map.h>
+#include <alloc.h>
+#include <logging.h>
+#include <file_lib.h>                              /* DeleteDirectoryTree */
+#include <dir.h>                                   /* DirOpen */
+#include <files_copy.h>                            /* CopyRegularFileDisk */
+#include <files_hashes.h>                          /* HashFile */
+#include <known_dirs.h>                            /* GetStateDir */
+#include <string_lib.h>                            /* StringToLong */
+#include <cf3.extern.h>                            /* CF_DEFAULT_DIGEST */
+
+
+/**
+   Per-run cache of files fetched from remote servers, currently only used
+   by files promises with copy_from in cf-agent.
+
+   The spool directory is private to the agent process that created it and
+   is removed in DownloadCache_Destroy(). Spooled files are never linked
+   into place, they are always copied out, so that permissions, ownership
+   and later edits of the destination can not alter the spool.
+
+   Spools of runs that are gone are removed when the next run starts:
+   those of crashed runs, and those created by background children, which
+   the creating process never removes.
+
+   @note THREAD-SAFETY: no, like the rest of the files promise code. Forked
+         background children may add entries of their own, but only the
+         creating process removes the spool.
+*/
+
+#define SPOOL_PREFIX "download_spool."
+
+
+static StringMap *download_index = NULL;    /* source key -> spool path */
+static char *spool_dir = NULL;
+static pid_t spool_owner = -1;
+static bool spool_created = false;
+
+static size_t stats_hits = 0;
+static size_t stats_stored = 0;
+
+
+static bool SpoolOwnerIsGone(pid_t pid)
+{
+#ifdef __MINGW32__
+    UNUSED(pid);
+    return false;                    /* no way to tell, keep the spool */
+#else
+    return kill(pid, 0) == -1 && errno == ESRCH;
+#endif
+}
+
+/**
+ * Remove the spools of agent processes that are not running anymore.
+ */
+static void DownloadCacheRemoveStaleSpools(void)
+{
+    const char *state_dir = GetStateDir();
+    Dir *dirh = DirOpen(state_dir);
+    if (dirh == NULL)
+    {
+        return;
+    }
+
+    const struct dirent *dirp;
+    while ((dirp = DirRead(dirh)) != NULL)
+    {
+        if (strncmp(dirp->d_name, SPOOL_PREFIX, strlen(SPOOL_PREFIX)) != 0)
+        {
+            continue;
+        }
+
+        long pid;
+        if (StringToLong(dirp->d_name + strlen(SPOOL_PREFIX), &pid) != 0 ||
+            pid <= 0 || pid == (long) getpid() || !SpoolOwnerIsGone((pid_t) pid))
+        {
+            continue;
+        }
+
+        char *stale;
+        xasprintf(&stale, "%s%c%s", state_dir, FILE_SEPARATOR, dirp->d_name);
+        if (DeleteDirectoryTree(stale) && rmdir(stale) == 0)
+        {
+            Log(LOG_LEVEL_VERBOSE, "Removed stale download spool '%s'", stale);
+        }
+        else
+        {
+            Log(LOG_LEVEL_VERBOSE,
+                "Unable to remove stale download spool '%s' (rmdir: %s)",
+                stale, GetErrorStr());
+        }
+        free(stale);
+    }
+
+    DirClose(dirh);
+}
+
+void DownloadCache_Init()
+{
+    assert(download_index == NULL);
+
+    DownloadCacheRemoveStaleSpools();
+
+    download_index = StringMapNew();
+    xasprintf(&spool_dir, "%s%c" SPOOL_PREFIX "%ju", GetStateDir(),
+              FILE_SEPARATOR, (uintmax_t) getpid());
+    spool_owner = getpid();
+    spool_created = false;
+    stats_hits = 0;
+    stats_stored = 0;
+}
+
+void DownloadCache_Destroy()
+{
+    if (download_index == NULL)
+    {
+        return;
+    }
+
+    Log(LOG_LEVEL_VERBOSE,
+        "Download cache: %zu files spooled, %zu downloads avoided",
+        stats_stored, stats_hits);
+
+    if (spool_created && getpid() == spool_owner)
+    {
+        if (!DeleteDirectoryTree(spool_dir) || rmdir(spool_dir) == -1)
+        {
+            Log(LOG_LEVEL_VERBOSE,
+                "Unable to remove download spool '%s' (rmdir: %s)",
+                spool_dir, GetErrorStr());
+        }
+    }
+
+    StringMapDestroy(download_index);
+    download_index = NULL;
+    free(spool_dir);
+    spool_dir = NULL;
+}
+
+static char *DownloadCacheKey(const char *server, const char *port,
+                              const char *source, const struct stat *sstat)
+{
+    char *key;
+    xasprintf(&key, "%s:%s:%jd:%jd:%s",
+              server, (port != NULL) ? port : "",
+              (intmax_t) sstat->st_size, (intmax_t) sstat->st_mtime,
+              source);
+    return key;
+}
+
+/**
+ * @brief Copy a previously downloaded instance of #source into #dest.
+ * @return true if #dest was created from the spool, false if the caller
+ *         needs to download the file itself.
+ */
+bool DownloadCache_Fetch(const char *server, const char *port,
+                         const char *source, const struct stat *sstat,
+                         const char *dest)
+{
+    if (download_index == NULL)
+    {
+        return false;
+    }
+
+    char *key = DownloadCacheKey(server, port, source, sstat);
+    const char *spooled = StringMapGet(download_index, key);
+
+    bool ok = false;
+    if (spooled != NULL)
+    {
+        ok = CopyRegularFileDisk(spooled, dest);
+        if (ok)
+        {
+            Log(LOG_LEVEL_VERBOSE,
+                "Copied '%s' from the download spool instead of fetching it"
+                " again from '%s'", source, server);
+            stats_hits++;
+        }
+        else
+        {
+            /* Something happened to the spool, forget about the entry. */
+            StringMapRemove(download_index, key);
+        }
+    }
+
+    free(key);
+    return ok;
+}
+
+/**
+ * @brief Remember the freshly downloaded file #downloaded as the contents
+ *        of #source on #server, as of remote stat #sstat.
+ */
+void DownloadCache_Store(const char *server, const char *port,
+                         const char *source, const struct stat *sstat,
+                         const char *downloaded)
+{
+    if (download_index == NULL)
+    {
+        return;
+    }
+
+    if (!spool_created)
+    {
+        if (mkdir(spool_dir, 0700) == -1 && errno != EEXIST)
+        {
+            Log(LOG_LEVEL_VERBOSE,
+                "Unable to create download spool '%s' (mkdir: %s)",
+                spool_dir, GetErrorStr());
+            return;
+        }
+        spool_created = true;
+    }
+
+    unsigned char digest[EVP_MAX_MD_SIZE + 1];
+    char digest_str[CF_HOSTKEY_STRING_SIZE];
+    HashFile(downloaded, digest, CF_DEFAULT_DIGEST);
+    HashPrintSafe(digest_str, sizeof(digest_str), digest,
+                  CF_DEFAULT_DIGEST, false);
+
+    char *spooled;
+    xasprintf(&spooled, "%s%c%s", spool_dir, FILE_SEPARATOR, digest_str);
+
+    /* Identical contents may already be spooled for another source. */
+    struct stat sb;
+    if (lstat(spooled, &sb) == -1 &&
+        !CopyRegularFileDisk(downloaded, spooled))
+    {
+        free(spooled);
+        return;
+    }
+
+    StringMapInsert(download_index,
+                    DownloadCacheKey(server, port, source, sstat), spooled);
+    stats_stored++;
+}
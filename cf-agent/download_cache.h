@@ -0,0 +1,49 @@
+/*
+   Copyright 2018 Northern.tech AS
+
+   This file is part of CFEngine 3 - written and maintained by Northern.tech AS.
+
+   This program is free software; you can redistribute it and/or modify it
+   under the terms of the GNU General Public License as published by the
+   Free Software Foundation; version 3.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA
+
+  To the extent this program is licensed as part of the Enterprise
+  versions of CFEngine, the applicable Commercial Open Source License
+  (COSL) may apply to this file if you as a licensee so wish it. See
+  included file COSL.txt.
+*/
+
+#ifndef CFENGINE_DOWNLOAD_CACHE_H
+#define CFENGINE_DOWNLOAD_CACHE_H
+
+#include <platform.h>
+
+/**
+ * Per-run spool of files downloaded by copy_from promises, so that several
+ * promises copying the same remote source only transfer it once.
+ *
+ * Entries are keyed by (server, port, remote path, remote size, remote
+ * mtime), and the spooled contents are stored by digest so identical
+ * contents from different sources share a single spool file.
+ */
+
+void DownloadCache_Init(void);
+void DownloadCache_Destroy(void);
+
+bool DownloadCache_Fetch(const char *server, const char *port,
+                         const char *source, const struct stat *sstat,
+                         const char *dest);
+void DownloadCache_Store(const char *server, const char *port,
+                         const char *source, const struct stat *sstat,
+                         const char *downloaded);
+
+#endif
@@ -36,7 +36,7 @@
 
 /*****************************************************************************/
 
-EditContext *NewEditContext(char *filename, Attributes a)
+EditContext *NewEditContext(char *filename, const Attributes *a)
 {
     EditContext *ec;
 
@@ -51,19 +51,19 @@ EditContext *NewEditContext(char *filename, Attributes a)
     ec->filename = filename;
     ec->new_line_mode = FileNewLineMode(filename);
 
-    if (a.haveeditline)
+    if (a->haveeditline)
     {
-        if (!LoadFileAsItemList(&(ec->file_start), filename, a.edits))
+        if (!LoadFileAsItemList(&(ec->file_start), filename, a->edits))
         {
             free(ec);
             return NULL;
         }
     }
 
-    if (a.haveeditxml)
+    if (a->haveeditxml)
     {
 #ifdef HAVE_LIBXML2
-        if (!LoadFileAsXmlDoc(&(ec->xmldoc), filename, a.edits))
+        if (!LoadFileAsXmlDoc(&(ec->xmldoc), filename, a->edits))
         {
             free(ec);
             return NULL;
@@ -75,7 +75,7 @@ EditContext *NewEditContext(char *filename, Attributes a)
 #endif
     }
 
-    if (a.edits.empty_before_use)
+    if (a->edits.empty_before_use)
     {
         Log(LOG_LEVEL_VERBOSE, "Build file model from a blank slate (emptying)");
         DeleteItemList(ec->file_start);
@@ -87,7 +87,7 @@ EditContext *NewEditContext(char *filename, Attributes a)
 
 /*****************************************************************************/
 
-void FinishEditContext(EvalContext *ctx, EditContext *ec, Attributes a, const Promise *pp,
+void FinishEditContext(EvalContext *ctx, EditContext *ec, const Attributes *a, const Promise *pp,
                        PromiseResult *result)
 {
     if (*result == PROMISE_RESULT_NOOP || *result == PROMISE_RESULT_CHANGE)
@@ -102,7 +102,7 @@ void FinishEditContext(EvalContext *ctx, EditContext *ec, Attributes a, const Pr
         goto end;
     }
 
-    if (DONTDO || (a.transaction.action == cfa_warn))
+    if (DONTDO || (a->transaction.action == cfa_warn))
     {
         if (ec &&
             !CompareToFile(ctx, ec->file_start, ec->filename, a, pp, result) &&
@@ -122,7 +122,7 @@ void FinishEditContext(EvalContext *ctx, EditContext *ec, Attributes a, const Pr
     }
     else if (ec && (ec->num_edits > 0))
     {
-        if (a.haveeditline || a.edit_template || a.edit_template_string)
+        if (a->haveeditline || a->edit_template || a->edit_template_string)
         {
             if (CompareToFile(ctx, ec->file_start, ec->filename, a, pp, result))
             {
@@ -143,10 +143,10 @@ void FinishEditContext(EvalContext *ctx, EditContext *ec, Attributes a, const Pr
             }
         }
 
-        if (a.haveeditxml)
+        if (a->haveeditxml)
         {
 #ifdef HAVE_LIBXML2
-            if (XmlCompareToFile(ec->xmldoc, ec->filename, a.edits))
+            if (XmlCompareToFile(ec->xmldoc, ec->filename, a->edits))
             {
                 if (ec)
                 {
@@ -254,7 +254,7 @@ static bool SaveXmlCallback(const char *dest_filename, void *param,
 
 /*********************************************************************/
 
-bool SaveXmlDocAsFile(xmlDocPtr doc, const char *file, Attributes a, NewLineMode new_line_mode)
+bool SaveXmlDocAsFile(xmlDocPtr doc, const char *file, const Attributes *a, NewLineMode new_line_mode)
 {
     return SaveAsFile(&SaveXmlCallback, doc, file, a, new_line_mode);
 }
@@ -80,28 +80,28 @@ static PromiseResult VerifyLineDeletions(EvalContext *ctx, const Promise *pp, Ed
 static PromiseResult VerifyColumnEdits(EvalContext *ctx, const Promise *pp, EditContext *edcontext);
 static PromiseResult VerifyPatterns(EvalContext *ctx, const Promise *pp, EditContext *edcontext);
 static PromiseResult VerifyLineInsertions(EvalContext *ctx, const Promise *pp, EditContext *edcontext);
-static int InsertMultipleLinesToRegion(EvalContext *ctx, Item **start, Item *begin_ptr, Item *end_ptr, Attributes a, const Promise *pp, EditContext *edcontext, PromiseResult *result);
-static int InsertMultipleLinesAtLocation(EvalContext *ctx, Item **start, Item *begin_ptr, Item *end_ptr, Item *location, Item *prev, Attributes a, const Promise *pp, EditContext *edcontext, PromiseResult *result);
-static int DeletePromisedLinesMatching(EvalContext *ctx, Item **start, Item *begin, Item *end, Attributes a, const Promise *pp, EditContext *edcontext, PromiseResult *result);
-static int InsertLineAtLocation(EvalContext *ctx, char *newline, Item **start, Item *location, Item *prev, Attributes a, const Promise *pp, EditContext *edcontext, PromiseResult *result);
-static int InsertCompoundLineAtLocation(EvalContext *ctx, char *newline, Item **start, Item *begin_ptr, Item *end_ptr, Item *location, Item *prev, Attributes a, const Promise *pp, EditContext *edcontext, PromiseResult *result);
-static int ReplacePatterns(EvalContext *ctx, Item *start, Item *end, Attributes a, const Promise *pp, EditContext *edcontext, PromiseResult *result);
-static int EditColumns(EvalContext *ctx, Item *file_start, Item *file_end, Attributes a, const Promise *pp, EditContext *edcontext, PromiseResult *result);
-static int EditLineByColumn(EvalContext *ctx, Rlist **columns, Attributes a, const Promise *pp, EditContext *edcontext, PromiseResult *result);
-static int DoEditColumn(Rlist **columns, Attributes a, EditContext *edcontext);
-static int SanityCheckInsertions(Attributes a);
-static int SanityCheckDeletions(Attributes a, const Promise *pp);
-static int SelectLine(EvalContext *ctx, const char *line, Attributes a);
+static int InsertMultipleLinesToRegion(EvalContext *ctx, Item **start, Item *begin_ptr, Item *end_ptr, const Attributes *a, const Promise *pp, EditContext *edcontext, PromiseResult *result);
+static int InsertMultipleLinesAtLocation(EvalContext *ctx, Item **start, Item *begin_ptr, Item *end_ptr, Item *location, Item *prev, const Attributes *a, const Promise *pp, EditContext *edcontext, PromiseResult *result);
+static int DeletePromisedLinesMatching(EvalContext *ctx, Item **start, Item *begin, Item *end, const Attributes *a, const Promise *pp, EditContext *edcontext, PromiseResult *result);
+static int InsertLineAtLocation(EvalContext *ctx, char *newline, Item **start, Item *location, Item *prev, const Attributes *a, const Promise *pp, EditContext *edcontext, PromiseResult *result);
+static int InsertCompoundLineAtLocation(EvalContext *ctx, char *newline, Item **start, Item *begin_ptr, Item *end_ptr, Item *location, Item *prev, const Attributes *a, const Promise *pp, EditContext *edcontext, PromiseResult *result);
+static int ReplacePatterns(EvalContext *ctx, Item *start, Item *end, const Attributes *a, const Promise *pp, EditContext *edcontext, PromiseResult *result);
+static int EditColumns(EvalContext *ctx, Item *file_start, Item *file_end, const Attributes *a, const Promise *pp, EditContext *edcontext, PromiseResult *result);
+static int EditLineByColumn(EvalContext *ctx, Rlist **columns, const Attributes *a, const Promise *pp, EditContext *edcontext, PromiseResult *result);
+static int DoEditColumn(Rlist **columns, const Attributes *a, EditContext *edcontext);
+static int SanityCheckInsertions(const Attributes *a);
+static int SanityCheckDeletions(const Attributes *a, const Promise *pp);
+static int SelectLine(EvalContext *ctx, const char *line, const Attributes *a);
 static int NotAnchored(char *s);
-static int SelectRegion(EvalContext *ctx, Item *start, Item **begin_ptr, Item **end_ptr, Attributes a, EditContext *edcontext);
+static int SelectRegion(EvalContext *ctx, Item *start, Item **begin_ptr, Item **end_ptr, const Attributes *a, EditContext *edcontext);
 static int MultiLineString(char *s);
-static int InsertFileAtLocation(EvalContext *ctx, Item **start, Item *begin_ptr, Item *end_ptr, Item *location, Item *prev, Attributes a, const Promise *pp, EditContext *edcontext, PromiseResult *result);
+static int InsertFileAtLocation(EvalContext *ctx, Item **start, Item *begin_ptr, Item *end_ptr, Item *location, Item *prev, const Attributes *a, const Promise *pp, EditContext *edcontext, PromiseResult *result);
 
 /*****************************************************************************/
 /* Level                                                                     */
 /*****************************************************************************/
 
-int ScheduleEditLineOperations(EvalContext *ctx, const Bundle *bp, Attributes a, const Promise *parentp, EditContext *edcontext)
+int ScheduleEditLineOperations(EvalContext *ctx, const Bundle *bp, const Attributes *a, const Promise *parentp, EditContext *edcontext)
 {
     enum editlinetypesequence type;
     char lockname[CF_BUFSIZE];
@@ -111,7 +111,7 @@ int ScheduleEditLineOperations(EvalContext *ctx, const Bundle *bp, Attributes a,
     assert(strcmp(bp->type, "edit_line") == 0);
 
     snprintf(lockname, CF_BUFSIZE - 1, "masterfilelock-%s", edcontext->filename);
-    thislock = AcquireLock(ctx, lockname, VUQNAME, CFSTARTTIME, a.transaction, parentp, true);
+    thislock = AcquireLock(ctx, lockname, VUQNAME, CFSTARTTIME, a->transaction, parentp, true);
 
     if (thislock.lock == NULL)
     {
@@ -154,12 +154,12 @@ int ScheduleEditLineOperations(EvalContext *ctx, const Bundle *bp, Attributes a,
 
 /*****************************************************************************/
 
-Bundle *MakeTemporaryBundleFromTemplate(EvalContext *ctx, Policy *policy, Attributes a, const Promise *pp, PromiseResult *result)
+Bundle *MakeTemporaryBundleFromTemplate(EvalContext *ctx, Policy *policy, const Attributes *a, const Promise *pp, PromiseResult *result)
 {
     FILE *fp = NULL;
-    if ((fp = safe_fopen(a.edit_template, "rt" )) == NULL)
+    if ((fp = safe_fopen(a->edit_template, "rt" )) == NULL)
     {
-        cfPS(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_INTERRUPTED, pp, a, "Unable to open template file '%s' to make '%s'", a.edit_template, pp->promiser);
+        cfPS(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_INTERRUPTED, pp, a, "Unable to open template file '%s' to make '%s'", a->edit_template, pp->promiser);
         *result = PromiseResultUpdate(*result, PROMISE_RESULT_INTERRUPTED);
         return NULL;
     }
@@ -167,7 +167,7 @@ Bundle *MakeTemporaryBundleFromTemplate(EvalContext *ctx, Policy *policy, Attrib
     Bundle *bp = NULL;
     {
         char bundlename[CF_MAXVARSIZE];
-        snprintf(bundlename, CF_MAXVARSIZE, "temp_cf_bundle_%s", CanonifyName(a.edit_template));
+        snprintf(bundlename, CF_MAXVARSIZE, "temp_cf_bundle_%s", CanonifyName(a->edit_template));
 
         bp = PolicyAppendBundle(policy, "default", bundlename, "edit_line", NULL, NULL);
     }
@@ -215,7 +215,7 @@ Bundle *MakeTemporaryBundleFromTemplate(EvalContext *ctx, Policy *policy, Attrib
 
                 if (strcmp(brack, "%]") != 0)
                 {
-                    cfPS(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_INTERRUPTED, pp, a, "Template file '%s' syntax error, missing close \"%%]\" at line %d", a.edit_template, lineno);
+                    cfPS(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_INTERRUPTED, pp, a, "Template file '%s' syntax error, missing close \"%%]\" at line %d", a->edit_template, lineno);
                     *result = PromiseResultUpdate(*result, PROMISE_RESULT_INTERRUPTED);
                     return NULL;
                 }
@@ -225,7 +225,7 @@ Bundle *MakeTemporaryBundleFromTemplate(EvalContext *ctx, Policy *policy, Attrib
                     PrependItem(&stack, context, NULL);
                     if (++level > 1)
                     {
-                        cfPS(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_INTERRUPTED, pp, a, "Template file '%s' contains nested blocks which are not allowed, near line %d", a.edit_template, lineno);
+                        cfPS(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_INTERRUPTED, pp, a, "Template file '%s' contains nested blocks which are not allowed, near line %d", a->edit_template, lineno);
                         *result = PromiseResultUpdate(*result, PROMISE_RESULT_INTERRUPTED);
                         return NULL;
                     }
@@ -357,9 +357,9 @@ static PromiseResult VerifyLineDeletions(EvalContext *ctx, const Promise *pp, Ed
     Attributes a = GetDeletionAttributes(ctx, pp);
     a.transaction.ifelapsed = CF_EDIT_IFELAPSED;
 
-    if (!SanityCheckDeletions(a, pp))
+    if (!SanityCheckDeletions(&a, pp))
     {
-        cfPS(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_INTERRUPTED, pp, a, "The promised line deletion '%s' is inconsistent", pp->promiser);
+        cfPS(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_INTERRUPTED, pp, &a, "The promised line deletion '%s' is inconsistent", pp->promiser);
         return PROMISE_RESULT_INTERRUPTED;
     }
 
@@ -371,17 +371,17 @@ static PromiseResult VerifyLineDeletions(EvalContext *ctx, const Promise *pp, Ed
         begin_ptr = NULL;
         end_ptr = NULL;
     }
-    else if (!SelectRegion(ctx, *start, &begin_ptr, &end_ptr, a, edcontext))
+    else if (!SelectRegion(ctx, *start, &begin_ptr, &end_ptr, &a, edcontext))
     {
         if (a.region.include_end || a.region.include_start)
         {
-            cfPS(ctx, LOG_LEVEL_INFO, PROMISE_RESULT_INTERRUPTED, pp, a,
+            cfPS(ctx, LOG_LEVEL_INFO, PROMISE_RESULT_INTERRUPTED, pp, &a,
                  "The promised line deletion '%s' could not select an edit region in '%s' (this is a good thing, as policy suggests deleting the markers)",
                  pp->promiser, edcontext->filename);
         }
         else
         {
-            cfPS(ctx, LOG_LEVEL_INFO, PROMISE_RESULT_INTERRUPTED, pp, a,
+            cfPS(ctx, LOG_LEVEL_INFO, PROMISE_RESULT_INTERRUPTED, pp, &a,
                  "The promised line deletion '%s' could not select an edit region in '%s' (but the delimiters were expected in the file)",
                  pp->promiser, edcontext->filename);
         }
@@ -390,7 +390,7 @@ static PromiseResult VerifyLineDeletions(EvalContext *ctx, const Promise *pp, Ed
     }
     if (!end_ptr && a.region.select_end && !a.region.select_end_match_eof)
     {
-        cfPS(ctx, LOG_LEVEL_VERBOSE, PROMISE_RESULT_INTERRUPTED, pp, a,
+        cfPS(ctx, LOG_LEVEL_VERBOSE, PROMISE_RESULT_INTERRUPTED, pp, &a,
             "The promised end pattern '%s' was not found when selecting region to delete in '%s'",
              a.region.select_end, edcontext->filename);
         result = PromiseResultUpdate(result, PROMISE_RESULT_INTERRUPTED);
@@ -405,7 +405,7 @@ static PromiseResult VerifyLineDeletions(EvalContext *ctx, const Promise *pp, Ed
         return PROMISE_RESULT_SKIPPED;
     }
 
-    if (DeletePromisedLinesMatching(ctx, start, begin_ptr, end_ptr, a, pp, edcontext, &result))
+    if (DeletePromisedLinesMatching(ctx, start, begin_ptr, end_ptr, &a, pp, edcontext, &result))
     {
         (edcontext->num_edits)++;
     }
@@ -429,21 +429,21 @@ static PromiseResult VerifyColumnEdits(EvalContext *ctx, const Promise *pp, Edit
 
     if (a.column.column_separator == NULL)
     {
-        cfPS(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_WARN, pp, a, "No field_separator in promise to edit by column for '%s'", pp->promiser);
+        cfPS(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_WARN, pp, &a, "No field_separator in promise to edit by column for '%s'", pp->promiser);
         PromiseRef(LOG_LEVEL_ERR, pp);
         return PROMISE_RESULT_WARN;
     }
 
     if (a.column.select_column <= 0)
     {
-        cfPS(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_WARN, pp, a, "No select_field in promise to edit '%s'", pp->promiser);
+        cfPS(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_WARN, pp, &a, "No select_field in promise to edit '%s'", pp->promiser);
         PromiseRef(LOG_LEVEL_ERR, pp);
         return PROMISE_RESULT_WARN;
     }
 
     if (!a.column.column_value)
     {
-        cfPS(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_WARN, pp, a, "No field_value is promised to column_edit '%s'", pp->promiser);
+        cfPS(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_WARN, pp, &a, "No field_value is promised to column_edit '%s'", pp->promiser);
         PromiseRef(LOG_LEVEL_ERR, pp);
         return PROMISE_RESULT_WARN;
     }
@@ -456,9 +456,9 @@ static PromiseResult VerifyColumnEdits(EvalContext *ctx, const Promise *pp, Edit
         begin_ptr = *start;
         end_ptr = NULL;         // EndOfList(*start);
     }
-    else if (!SelectRegion(ctx, *start, &begin_ptr, &end_ptr, a, edcontext))
+    else if (!SelectRegion(ctx, *start, &begin_ptr, &end_ptr, &a, edcontext))
     {
-        cfPS(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_INTERRUPTED, pp, a, "The promised column edit '%s' could not select an edit region in '%s'",
+        cfPS(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_INTERRUPTED, pp, &a, "The promised column edit '%s' could not select an edit region in '%s'",
              pp->promiser, edcontext->filename);
         result = PromiseResultUpdate(result, PROMISE_RESULT_INTERRUPTED);
         return result;
@@ -473,7 +473,7 @@ static PromiseResult VerifyColumnEdits(EvalContext *ctx, const Promise *pp, Edit
         return PROMISE_RESULT_SKIPPED;
     }
 
-    if (EditColumns(ctx, begin_ptr, end_ptr, a, pp, edcontext, &result))
+    if (EditColumns(ctx, begin_ptr, end_ptr, &a, pp, edcontext, &result))
     {
         (edcontext->num_edits)++;
     }
@@ -501,7 +501,7 @@ static PromiseResult VerifyPatterns(EvalContext *ctx, const Promise *pp, EditCon
 
     if (!a.replace.replace_value)
     {
-        cfPS(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_INTERRUPTED, pp, a, "The promised pattern replace '%s' had no replacement string",
+        cfPS(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_INTERRUPTED, pp, &a, "The promised pattern replace '%s' had no replacement string",
              pp->promiser);
         return PROMISE_RESULT_INTERRUPTED;
     }
@@ -512,9 +512,9 @@ static PromiseResult VerifyPatterns(EvalContext *ctx, const Promise *pp, EditCon
         begin_ptr = *start;
         end_ptr = NULL;         //EndOfList(*start);
     }
-    else if (!SelectRegion(ctx, *start, &begin_ptr, &end_ptr, a, edcontext))
+    else if (!SelectRegion(ctx, *start, &begin_ptr, &end_ptr, &a, edcontext))
     {
-        cfPS(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_INTERRUPTED, pp, a,
+        cfPS(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_INTERRUPTED, pp, &a,
              "The promised pattern replace '%s' could not select an edit region in '%s'", pp->promiser,
              edcontext->filename);
         result = PromiseResultUpdate(result, PROMISE_RESULT_INTERRUPTED);
@@ -531,7 +531,7 @@ static PromiseResult VerifyPatterns(EvalContext *ctx, const Promise *pp, EditCon
 
 /* Make sure back references are expanded */
 
-    if (ReplacePatterns(ctx, begin_ptr, end_ptr, a, pp, edcontext, &result))
+    if (ReplacePatterns(ctx, begin_ptr, end_ptr, &a, pp, edcontext, &result))
     {
         (edcontext->num_edits)++;
     }
@@ -660,9 +660,9 @@ static PromiseResult VerifyLineInsertions(EvalContext *ctx, const Promise *pp, E
     int allow_multi_lines = a.sourcetype && strcmp(a.sourcetype, "preserve_all_lines") == 0;
     a.transaction.ifelapsed = CF_EDIT_IFELAPSED;
 
-    if (!SanityCheckInsertions(a))
+    if (!SanityCheckInsertions(&a))
     {
-        cfPS(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_INTERRUPTED, pp, a, "The promised line insertion '%s' breaks its own promises",
+        cfPS(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_INTERRUPTED, pp, &a, "The promised line insertion '%s' breaks its own promises",
              pp->promiser);
         return PROMISE_RESULT_INTERRUPTED;
     }
@@ -676,9 +676,9 @@ static PromiseResult VerifyLineInsertions(EvalContext *ctx, const Promise *pp, E
         begin_ptr = *start;
         end_ptr = NULL;         //EndOfList(*start);
     }
-    else if (!SelectRegion(ctx, *start, &begin_ptr, &end_ptr, a, edcontext))
+    else if (!SelectRegion(ctx, *start, &begin_ptr, &end_ptr, &a, edcontext))
     {
-        cfPS(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_INTERRUPTED, pp, a,
+        cfPS(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_INTERRUPTED, pp, &a,
              "The promised line insertion '%s' could not select an edit region in '%s'",
              pp->promiser, edcontext->filename);
         result = PromiseResultUpdate(result, PROMISE_RESULT_INTERRUPTED);
@@ -687,7 +687,7 @@ static PromiseResult VerifyLineInsertions(EvalContext *ctx, const Promise *pp, E
 
     if (!end_ptr && a.region.select_end && !a.region.select_end_match_eof)
     {
-        cfPS(ctx, LOG_LEVEL_VERBOSE, PROMISE_RESULT_INTERRUPTED, pp, a,
+        cfPS(ctx, LOG_LEVEL_VERBOSE, PROMISE_RESULT_INTERRUPTED, pp, &a,
             "The promised end pattern '%s' was not found when selecting region to insert in '%s'",
              a.region.select_end, edcontext->filename);
         result = PromiseResultUpdate(result, PROMISE_RESULT_INTERRUPTED);
@@ -714,7 +714,7 @@ static PromiseResult VerifyLineInsertions(EvalContext *ctx, const Promise *pp, E
 
     if (a.location.line_matching == NULL)
     {
-        if (InsertMultipleLinesToRegion(ctx, start, begin_ptr, end_ptr, a, pp, edcontext, &result))
+        if (InsertMultipleLinesToRegion(ctx, start, begin_ptr, end_ptr, &a, pp, edcontext, &result))
         {
             (edcontext->num_edits)++;
         }
@@ -723,13 +723,13 @@ static PromiseResult VerifyLineInsertions(EvalContext *ctx, const Promise *pp, E
     {
         if (!SelectItemMatching(ctx, *start, a.location.line_matching, begin_ptr, end_ptr, &match, &prev, a.location.first_last))
         {
-            cfPS(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_INTERRUPTED, pp, a, "The promised line insertion '%s' could not select a locator matching regex '%s' in '%s'", pp->promiser, a.location.line_matching, edcontext->filename);
+            cfPS(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_INTERRUPTED, pp, &a, "The promised line insertion '%s' could not select a locator matching regex '%s' in '%s'", pp->promiser, a.location.line_matching, edcontext->filename);
             result = PromiseResultUpdate(result, PROMISE_RESULT_INTERRUPTED);
             YieldCurrentLock(thislock);
             return result;
         }
 
-        if (InsertMultipleLinesAtLocation(ctx, start, begin_ptr, end_ptr, match, prev, a, pp, edcontext, &result))
+        if (InsertMultipleLinesAtLocation(ctx, start, begin_ptr, end_ptr, match, prev, &a, pp, edcontext, &result))
         {
             (edcontext->num_edits)++;
         }
@@ -746,7 +746,7 @@ static PromiseResult VerifyLineInsertions(EvalContext *ctx, const Promise *pp, E
 
 static int SelectRegion(EvalContext *ctx, Item *start,
                         Item **begin_ptr, Item **end_ptr,
-                        Attributes a, EditContext *edcontext)
+                        const Attributes *a, EditContext *edcontext)
 /*
 
 This should provide pointers to the first and last line of text that include the
@@ -761,17 +761,17 @@ If no such region matches, begin_ptr and end_ptr should point to NULL
 
     for (ip = start; ip != NULL; ip = ip->next)
     {
-        if (a.region.select_start)
+        if (a->region.select_start)
         {
-            if (!beg && FullTextMatch(ctx, a.region.select_start, ip->name))
+            if (!beg && FullTextMatch(ctx, a->region.select_start, ip->name))
             {
-                if (!a.region.include_start)
+                if (!a->region.include_start)
                 {
                     if (ip->next == NULL)
                     {
                         Log(LOG_LEVEL_VERBOSE,
                              "The promised start pattern '%s' found an empty region at the end of file '%s'",
-                             a.region.select_start, edcontext->filename);
+                             a->region.select_start, edcontext->filename);
                         return false;
                     }
                 }
@@ -781,9 +781,9 @@ If no such region matches, begin_ptr and end_ptr should point to NULL
             }
         }
 
-        if (a.region.select_end && beg)
+        if (a->region.select_end && beg)
         {
-            if (!end && FullTextMatch(ctx, a.region.select_end, ip->name))
+            if (!end && FullTextMatch(ctx, a->region.select_end, ip->name))
             {
                 end = ip;
                 break;
@@ -796,11 +796,11 @@ If no such region matches, begin_ptr and end_ptr should point to NULL
         }
     }
 
-    if (!beg && a.region.select_start)
+    if (!beg && a->region.select_start)
     {
         Log(LOG_LEVEL_VERBOSE,
              "The promised start pattern '%s' was not found when selecting edit region in '%s'",
-             a.region.select_start, edcontext->filename);
+             a->region.select_start, edcontext->filename);
         return false;
     }
 
@@ -882,11 +882,11 @@ bad:
 
 /*****************************************************************************/
 
-static int InsertMultipleLinesToRegion(EvalContext *ctx, Item **start, Item *begin_ptr, Item *end_ptr, Attributes a,
+static int InsertMultipleLinesToRegion(EvalContext *ctx, Item **start, Item *begin_ptr, Item *end_ptr, const Attributes *a,
                                        const Promise *pp, EditContext *edcontext, PromiseResult *result)
 {
     Item *ip, *prev = NULL;
-    int allow_multi_lines = a.sourcetype && strcmp(a.sourcetype, "preserve_all_lines") == 0;
+    int allow_multi_lines = a->sourcetype && strcmp(a->sourcetype, "preserve_all_lines") == 0;
 
     // Insert at the start of the file
 
@@ -897,7 +897,7 @@ static int InsertMultipleLinesToRegion(EvalContext *ctx, Item **start, Item *beg
 
     // Insert at the start of the region
 
-    if (a.location.before_after == EDIT_ORDER_BEFORE)
+    if (a->location.before_after == EDIT_ORDER_BEFORE)
     {
         /* As region was already selected by SelectRegion() and we know
          * what are the region boundaries (begin_ptr and end_ptr) there
@@ -915,7 +915,7 @@ static int InsertMultipleLinesToRegion(EvalContext *ctx, Item **start, Item *beg
 
     // Insert at the end of the region / else end of the file
 
-    if (a.location.before_after == EDIT_ORDER_AFTER)
+    if (a->location.before_after == EDIT_ORDER_AFTER)
     {
         /* As region was already selected by SelectRegion() and we know
          * what are the region boundaries (begin_ptr and end_ptr) there
@@ -951,13 +951,13 @@ static int InsertMultipleLinesToRegion(EvalContext *ctx, Item **start, Item *beg
 /***************************************************************************/
 
 static int InsertMultipleLinesAtLocation(EvalContext *ctx, Item **start, Item *begin_ptr, Item *end_ptr, Item *location,
-                                         Item *prev, Attributes a, const Promise *pp, EditContext *edcontext, PromiseResult *result)
+                                         Item *prev, const Attributes *a, const Promise *pp, EditContext *edcontext, PromiseResult *result)
 
 // Promises to insert a possibly multi-line promiser at the specificed location convergently,
 // i.e. no insertion will be made if a neighbouring line matches
 
 {
-    int isfileinsert = a.sourcetype && (strcmp(a.sourcetype, "file") == 0 || strcmp(a.sourcetype, "file_preserve_block") == 0);
+    int isfileinsert = a->sourcetype && (strcmp(a->sourcetype, "file") == 0 || strcmp(a->sourcetype, "file_preserve_block") == 0);
 
     if (isfileinsert)
     {
@@ -972,7 +972,7 @@ static int InsertMultipleLinesAtLocation(EvalContext *ctx, Item **start, Item *b
 
 /***************************************************************************/
 
-static int DeletePromisedLinesMatching(EvalContext *ctx, Item **start, Item *begin, Item *end, Attributes a,
+static int DeletePromisedLinesMatching(EvalContext *ctx, Item **start, Item *begin, Item *end, const Attributes *a,
                                        const Promise *pp, EditContext *edcontext, PromiseResult *result)
 {
     Item *ip, *np = NULL, *lp, *initiator = begin, *terminator = NULL;
@@ -991,7 +991,7 @@ static int DeletePromisedLinesMatching(EvalContext *ctx, Item **start, Item *beg
     }
     else
     {
-        if (a.region.include_start)
+        if (a->region.include_start)
         {
             initiator = begin;
         }
@@ -1007,7 +1007,7 @@ static int DeletePromisedLinesMatching(EvalContext *ctx, Item **start, Item *beg
     }
     else
     {
-        if (a.region.include_end)
+        if (a->region.include_end)
         {
             terminator = end->next;
         }
@@ -1021,7 +1021,7 @@ static int DeletePromisedLinesMatching(EvalContext *ctx, Item **start, Item *beg
 
     for (ip = initiator; ip != terminator && ip != NULL; ip = np)
     {
-        if (a.not_matching)
+        if (a->not_matching)
         {
             matches = !MatchRegion(ctx, pp->promiser, ip, terminator, true);
         }
@@ -1049,7 +1049,7 @@ static int DeletePromisedLinesMatching(EvalContext *ctx, Item **start, Item *beg
         {
             Log(LOG_LEVEL_VERBOSE, "Delete chunk of %d lines", matches);
 
-            if (a.transaction.action == cfa_warn)
+            if (a->transaction.action == cfa_warn)
             {
                 cfPS(ctx, LOG_LEVEL_WARNING, PROMISE_RESULT_WARN, pp, a,
                      "Need to delete line '%s' from %s - but only a warning was promised", ip->name,
@@ -1122,7 +1122,7 @@ static int DeletePromisedLinesMatching(EvalContext *ctx, Item **start, Item *beg
 
 /********************************************************************/
 
-static int ReplacePatterns(EvalContext *ctx, Item *file_start, Item *file_end, Attributes a,
+static int ReplacePatterns(EvalContext *ctx, Item *file_start, Item *file_end, const Attributes *a,
                            const Promise *pp, EditContext *edcontext, PromiseResult *result)
 {
     char line_buff[CF_EXPANDSIZE];
@@ -1131,7 +1131,7 @@ static int ReplacePatterns(EvalContext *ctx, Item *file_start, Item *file_end, A
     Item *ip;
     int notfound = true, cutoff = 1, replaced = false;
 
-    if (a.replace.occurrences && (strcmp(a.replace.occurrences, "first") == 0))
+    if (a->replace.occurrences && (strcmp(a->replace.occurrences, "first") == 0))
     {
         Log(LOG_LEVEL_WARNING, "Setting replace-occurrences policy to 'first' is not convergent");
         once_only = true;
@@ -1166,7 +1166,7 @@ static int ReplacePatterns(EvalContext *ctx, Item *file_start, Item *file_end, A
 
             match_len = end_off - start_off;
             BufferClear(replace);
-            ExpandScalar(ctx, PromiseGetBundle(pp)->ns, PromiseGetBundle(pp)->name, a.replace.replace_value, replace);
+            ExpandScalar(ctx, PromiseGetBundle(pp)->ns, PromiseGetBundle(pp)->name, a->replace.replace_value, replace);
 
             Log(LOG_LEVEL_VERBOSE, "Verifying replacement of '%s' with '%s', cutoff %d", pp->promiser, BufferData(replace),
                   cutoff);
@@ -1201,7 +1201,7 @@ static int ReplacePatterns(EvalContext *ctx, Item *file_start, Item *file_end, A
             break;
         }
 
-        if (a.transaction.action == cfa_warn)
+        if (a->transaction.action == cfa_warn)
         {
             cfPS(ctx, LOG_LEVEL_WARNING, PROMISE_RESULT_WARN, pp, a,
                  "Need to replace line '%s' in '%s' - but only a warning was promised", pp->promiser,
@@ -1253,7 +1253,7 @@ static int ReplacePatterns(EvalContext *ctx, Item *file_start, Item *file_end, A
 
 /********************************************************************/
 
-static int EditColumns(EvalContext *ctx, Item *file_start, Item *file_end, Attributes a,
+static int EditColumns(EvalContext *ctx, Item *file_start, Item *file_end, const Attributes *a,
                        const Promise *pp, EditContext *edcontext, PromiseResult *result)
 {
     char separator[CF_MAXVARSIZE];
@@ -1282,10 +1282,10 @@ static int EditColumns(EvalContext *ctx, Item *file_start, Item *file_end, Attri
             Log(LOG_LEVEL_VERBOSE, "Matched line '%s'", ip->name);
         }
 
-        if (!BlockTextMatch(ctx, a.column.column_separator, ip->name, &s, &e))
+        if (!BlockTextMatch(ctx, a->column.column_separator, ip->name, &s, &e))
         {
             cfPS(ctx, LOG_LEVEL_VERBOSE, PROMISE_RESULT_INTERRUPTED, pp, a, "Field edit, no fields found by promised pattern '%s' in '%s'",
-                 a.column.column_separator, edcontext->filename);
+                 a->column.column_separator, edcontext->filename);
             *result = PromiseResultUpdate(*result, PROMISE_RESULT_INTERRUPTED);
             return false;
         }
@@ -1298,7 +1298,7 @@ static int EditColumns(EvalContext *ctx, Item *file_start, Item *file_end, Attri
 
         strlcpy(separator, ip->name + s, e - s + 1);
 
-        columns = RlistFromSplitRegex(ip->name, a.column.column_separator, CF_INFINITY, a.column.blanks_ok);
+        columns = RlistFromSplitRegex(ip->name, a->column.column_separator, CF_INFINITY, a->column.blanks_ok);
         retval = EditLineByColumn(ctx, &columns, a, pp, edcontext, result);
 
         if (retval)
@@ -1315,7 +1315,7 @@ static int EditColumns(EvalContext *ctx, Item *file_start, Item *file_end, Attri
 
 /***************************************************************************/
 
-static int SanityCheckInsertions(Attributes a)
+static int SanityCheckInsertions(const Attributes *a)
 {
     long not = 0;
     long with = 0;
@@ -1323,34 +1323,34 @@ static int SanityCheckInsertions(Attributes a)
     Rlist *rp;
     InsertMatchType opt;
     int exact = false, ignore_something = false;
-    int preserve_block = a.sourcetype && strcmp(a.sourcetype, "preserve_block") == 0;
+    int preserve_block = a->sourcetype && strcmp(a->sourcetype, "preserve_block") == 0;
 
-    if (a.line_select.startwith_from_list)
+    if (a->line_select.startwith_from_list)
     {
         with++;
     }
 
-    if (a.line_select.not_startwith_from_list)
+    if (a->line_select.not_startwith_from_list)
     {
         not++;
     }
 
-    if (a.line_select.match_from_list)
+    if (a->line_select.match_from_list)
     {
         with++;
     }
 
-    if (a.line_select.not_match_from_list)
+    if (a->line_select.not_match_from_list)
     {
         not++;
     }
 
-    if (a.line_select.contains_from_list)
+    if (a->line_select.contains_from_list)
     {
         with++;
     }
 
-    if (a.line_select.not_contains_from_list)
+    if (a->line_select.not_contains_from_list)
     {
         not++;
     }
@@ -1369,7 +1369,7 @@ static int SanityCheckInsertions(Attributes a)
         ok = false;
     }
 
-    for (rp = a.insert_match; rp != NULL; rp = rp->next)
+    for (rp = a->insert_match; rp != NULL; rp = rp->next)
     {
         opt = InsertMatchTypeFromString(RlistScalarValue(rp));
 
@@ -1401,11 +1401,11 @@ static int SanityCheckInsertions(Attributes a)
 
 /***************************************************************************/
 
-static int SanityCheckDeletions(Attributes a, const Promise *pp)
+static int SanityCheckDeletions(const Attributes *a, const Promise *pp)
 {
     if (MultiLineString(pp->promiser))
     {
-        if (a.not_matching)
+        if (a->not_matching)
         {
             Log(LOG_LEVEL_ERR,
                   "Makes no sense to promise multi-line delete with not_matching. Cannot be satisfied for all lines as a block.");
@@ -1621,12 +1621,12 @@ static int IsItemInRegion(EvalContext *ctx, const char *item, const Item *begin_
 /***************************************************************************/
 
 static int InsertFileAtLocation(EvalContext *ctx, Item **start, Item *begin_ptr, Item *end_ptr, Item *location,
-                                Item *prev, Attributes a, const Promise *pp, EditContext *edcontext, PromiseResult *result)
+                                Item *prev, const Attributes *a, const Promise *pp, EditContext *edcontext, PromiseResult *result)
 {
     FILE *fin;
     int retval = false;
     Item *loc = NULL;
-    int preserve_block = a.sourcetype && strcmp(a.sourcetype, "file_preserve_block") == 0;
+    int preserve_block = a->sourcetype && strcmp(a->sourcetype, "file_preserve_block") == 0;
 
     if ((fin = safe_fopen(pp->promiser, "rt")) == NULL)
     {
@@ -1643,7 +1643,7 @@ static int InsertFileAtLocation(EvalContext *ctx, Item **start, Item *begin_ptr,
     while (CfReadLine(&buf, &buf_size, fin) != -1)
     {
         BufferClear(exp);
-        if (a.expandvars)
+        if (a->expandvars)
         {
             ExpandScalar(ctx, PromiseGetBundle(pp)->ns, PromiseGetBundle(pp)->name, buf, exp);
         }
@@ -1657,7 +1657,7 @@ static int InsertFileAtLocation(EvalContext *ctx, Item **start, Item *begin_ptr,
             continue;
         }
 
-        if (!preserve_block && IsItemInRegion(ctx, BufferData(exp), begin_ptr, end_ptr, a.insert_match, pp))
+        if (!preserve_block && IsItemInRegion(ctx, BufferData(exp), begin_ptr, end_ptr, a->insert_match, pp))
         {
             cfPS(ctx, LOG_LEVEL_VERBOSE, PROMISE_RESULT_NOOP, pp, a,
                  "Promised file line '%s' exists within file %s (promise kept)", BufferData(exp), edcontext->filename);
@@ -1672,7 +1672,7 @@ static int InsertFileAtLocation(EvalContext *ctx, Item **start, Item *begin_ptr,
         {
             // If we are inserting a preserved block before, need to flip the implied order after the first insertion
             // to get the order of the block right
-            //a.location.before_after = cfe_after;
+            //a->location.before_after = cfe_after;
         }
 
         if (prev)
@@ -1718,12 +1718,12 @@ static int InsertFileAtLocation(EvalContext *ctx, Item **start, Item *begin_ptr,
 /***************************************************************************/
 
 static int InsertCompoundLineAtLocation(EvalContext *ctx, char *chunk, Item **start, Item *begin_ptr, Item *end_ptr,
-                                        Item *location, Item *prev, Attributes a, const Promise *pp, EditContext *edcontext,
+                                        Item *location, Item *prev, const Attributes *a, const Promise *pp, EditContext *edcontext,
                                         PromiseResult *result)
 {
     bool retval = false;
-    int preserve_all_lines = a.sourcetype && strcmp(a.sourcetype, "preserve_all_lines") == 0;
-    int preserve_block = a.sourcetype && (preserve_all_lines || strcmp(a.sourcetype, "preserve_block") == 0 || strcmp(a.sourcetype, "file_preserve_block") == 0);
+    int preserve_all_lines = a->sourcetype && strcmp(a->sourcetype, "preserve_all_lines") == 0;
+    int preserve_block = a->sourcetype && (preserve_all_lines || strcmp(a->sourcetype, "preserve_block") == 0 || strcmp(a->sourcetype, "file_preserve_block") == 0);
 
     if (!preserve_all_lines && MatchRegion(ctx, chunk, location, NULL, false))
     {
@@ -1752,7 +1752,7 @@ static int InsertCompoundLineAtLocation(EvalContext *ctx, char *chunk, Item **st
             continue;
         }
 
-        if (!preserve_block && IsItemInRegion(ctx, buf, begin_ptr, end_ptr, a.insert_match, pp))
+        if (!preserve_block && IsItemInRegion(ctx, buf, begin_ptr, end_ptr, a->insert_match, pp))
         {
             cfPS(ctx, LOG_LEVEL_VERBOSE, PROMISE_RESULT_NOOP, pp, a, "Promised chunk '%s' exists within selected region of %s (promise kept)", pp->promiser, edcontext->filename);
             continue;
@@ -1760,11 +1760,11 @@ static int InsertCompoundLineAtLocation(EvalContext *ctx, char *chunk, Item **st
 
         retval |= InsertLineAtLocation(ctx, buf, start, location, prev, a, pp, edcontext, result);
 
-        if (preserve_block && a.location.before_after == EDIT_ORDER_BEFORE && location == NULL && prev == NULL)
+        if (preserve_block && a->location.before_after == EDIT_ORDER_BEFORE && location == NULL && prev == NULL)
         {
             // If we are inserting a preserved block before, need to flip the implied order after the first insertion
             // to get the order of the block right
-            // a.location.before_after = cfe_after;
+            // a->location.before_after = cfe_after;
             location = *start;
         }
 
@@ -1832,20 +1832,20 @@ static int NeighbourItemMatches(EvalContext *ctx, const Item *file_start, const
     return false;
 }
 
-static int InsertLineAtLocation(EvalContext *ctx, char *newline, Item **start, Item *location, Item *prev, Attributes a,
+static int InsertLineAtLocation(EvalContext *ctx, char *newline, Item **start, Item *location, Item *prev, const Attributes *a,
                                 const Promise *pp, EditContext *edcontext, PromiseResult *result)
 
 /* Check line neighbourhood in whole file to avoid edge effects, iff we are not preseving block structure */
 
-{   int preserve_block = a.sourcetype && strcmp(a.sourcetype, "preserve_block") == 0;
+{   int preserve_block = a->sourcetype && strcmp(a->sourcetype, "preserve_block") == 0;
 
     if (!prev)      /* Insert at first line */
     {
-        if (a.location.before_after == EDIT_ORDER_BEFORE)
+        if (a->location.before_after == EDIT_ORDER_BEFORE)
         {
             if (*start == NULL)
             {
-                if (a.transaction.action == cfa_warn)
+                if (a->transaction.action == cfa_warn)
                 {
                     cfPS(ctx, LOG_LEVEL_WARNING, PROMISE_RESULT_WARN, pp, a,
                          "Need to insert the promised line '%s' in %s - but only a warning was promised", newline,
@@ -1866,7 +1866,7 @@ static int InsertLineAtLocation(EvalContext *ctx, char *newline, Item **start, I
 
             if (strcmp((*start)->name, newline) != 0)
             {
-                if (a.transaction.action == cfa_warn)
+                if (a->transaction.action == cfa_warn)
                 {
                     cfPS(ctx, LOG_LEVEL_WARNING, PROMISE_RESULT_WARN, pp, a,
                          "Need to prepend the promised line '%s' to %s - but only a warning was promised",
@@ -1893,9 +1893,9 @@ static int InsertLineAtLocation(EvalContext *ctx, char *newline, Item **start, I
         }
     }
 
-    if (a.location.before_after == EDIT_ORDER_BEFORE)
+    if (a->location.before_after == EDIT_ORDER_BEFORE)
     {
-        if (!preserve_block && NeighbourItemMatches(ctx, *start, location, newline, EDIT_ORDER_BEFORE, a.insert_match, pp))
+        if (!preserve_block && NeighbourItemMatches(ctx, *start, location, newline, EDIT_ORDER_BEFORE, a->insert_match, pp))
         {
             cfPS(ctx, LOG_LEVEL_VERBOSE, PROMISE_RESULT_NOOP, pp, a, "Promised line '%s' exists before locator in (promise kept)",
                  newline);
@@ -1903,7 +1903,7 @@ static int InsertLineAtLocation(EvalContext *ctx, char *newline, Item **start, I
         }
         else
         {
-            if (a.transaction.action == cfa_warn)
+            if (a->transaction.action == cfa_warn)
             {
                 cfPS(ctx, LOG_LEVEL_WARNING, PROMISE_RESULT_WARN, pp, a,
                      "Need to insert line '%s' into '%s' but only a warning was promised", newline,
@@ -1924,7 +1924,7 @@ static int InsertLineAtLocation(EvalContext *ctx, char *newline, Item **start, I
     }
     else
     {
-        if (!preserve_block && NeighbourItemMatches(ctx, *start, location, newline, EDIT_ORDER_AFTER, a.insert_match, pp))
+        if (!preserve_block && NeighbourItemMatches(ctx, *start, location, newline, EDIT_ORDER_AFTER, a->insert_match, pp))
         {
             cfPS(ctx, LOG_LEVEL_VERBOSE, PROMISE_RESULT_NOOP, pp, a, "Promised line '%s' exists after locator (promise kept)",
                  newline);
@@ -1932,7 +1932,7 @@ static int InsertLineAtLocation(EvalContext *ctx, char *newline, Item **start, I
         }
         else
         {
-            if (a.transaction.action == cfa_warn)
+            if (a->transaction.action == cfa_warn)
             {
                 cfPS(ctx, LOG_LEVEL_WARNING, PROMISE_RESULT_WARN, pp, a,
                      "Need to insert line '%s' in '%s' but only a warning was promised", newline, edcontext->filename);
@@ -1954,7 +1954,7 @@ static int InsertLineAtLocation(EvalContext *ctx, char *newline, Item **start, I
 
 /***************************************************************************/
 
-static int EditLineByColumn(EvalContext *ctx, Rlist **columns, Attributes a,
+static int EditLineByColumn(EvalContext *ctx, Rlist **columns, const Attributes *a,
                             const Promise *pp, EditContext *edcontext, PromiseResult *result)
 {
     Rlist *rp, *this_column = NULL;
@@ -1967,26 +1967,26 @@ static int EditLineByColumn(EvalContext *ctx, Rlist **columns, Attributes a,
     {
         count++;
 
-        if (count == a.column.select_column)
+        if (count == a->column.select_column)
         {
             Log(LOG_LEVEL_VERBOSE, "Stopped at field %d", count);
             break;
         }
     }
 
-    if (a.column.select_column > count)
+    if (a->column.select_column > count)
     {
-        if (!a.column.extend_columns)
+        if (!a->column.extend_columns)
         {
             cfPS(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_INTERRUPTED, pp, a,
                  "The file %s has only %d fields, but there is a promise for field %d", edcontext->filename, count,
-                 a.column.select_column);
+                 a->column.select_column);
             *result = PromiseResultUpdate(*result, PROMISE_RESULT_INTERRUPTED);
             return false;
         }
         else
         {
-            for (i = 0; i < (a.column.select_column - count); i++)
+            for (i = 0; i < (a->column.select_column - count); i++)
             {
                 RlistAppendScalar(columns, "");
             }
@@ -1996,7 +1996,7 @@ static int EditLineByColumn(EvalContext *ctx, Rlist **columns, Attributes a,
             for (rp = *columns; rp != NULL; rp = rp->next)
             {
                 count++;
-                if (count == a.column.select_column)
+                if (count == a->column.select_column)
                 {
                     Log(LOG_LEVEL_VERBOSE, "Stopped at column/field %d", count);
                     break;
@@ -2005,13 +2005,13 @@ static int EditLineByColumn(EvalContext *ctx, Rlist **columns, Attributes a,
         }
     }
 
-    if (a.column.value_separator != '\0')
+    if (a->column.value_separator != '\0')
     {
         /* internal separator, single char so split again */
 
-        if (strstr(RlistScalarValue(rp), a.column.column_value) || strcmp(RlistScalarValue(rp), a.column.column_value) != 0) 
+        if (strstr(RlistScalarValue(rp), a->column.column_value) || strcmp(RlistScalarValue(rp), a->column.column_value) != 0) 
         {
-            this_column = RlistFromSplitString(RlistScalarValue(rp), a.column.value_separator);
+            this_column = RlistFromSplitString(RlistScalarValue(rp), a->column.value_separator);
             retval = DoEditColumn(&this_column, a, edcontext);
         }
         else
@@ -2021,7 +2021,7 @@ static int EditLineByColumn(EvalContext *ctx, Rlist **columns, Attributes a,
 
         if (retval)
         {
-            if (a.transaction.action == cfa_warn)
+            if (a->transaction.action == cfa_warn)
             {
                 cfPS(ctx, LOG_LEVEL_WARNING, PROMISE_RESULT_WARN, pp, a, "Need to edit field in %s but only warning promised",
                      edcontext->filename);
@@ -2034,7 +2034,7 @@ static int EditLineByColumn(EvalContext *ctx, Rlist **columns, Attributes a,
                 *result = PromiseResultUpdate(*result, PROMISE_RESULT_CHANGE);
                 (edcontext->num_edits)++;
                 free(RlistScalarValue(rp));
-                sep[0] = a.column.value_separator;
+                sep[0] = a->column.value_separator;
                 sep[1] = '\0';
                 rp->val.item = Rlist2String(this_column, sep);
             }
@@ -2051,9 +2051,9 @@ static int EditLineByColumn(EvalContext *ctx, Rlist **columns, Attributes a,
     {
         /* No separator, so we set the whole field to the value */
 
-        if (a.column.column_operation && strcmp(a.column.column_operation, "delete") == 0)
+        if (a->column.column_operation && strcmp(a->column.column_operation, "delete") == 0)
         {
-            if (a.transaction.action == cfa_warn)
+            if (a->transaction.action == cfa_warn)
             {
                 cfPS(ctx, LOG_LEVEL_WARNING, PROMISE_RESULT_WARN, pp, a,
                      "Need to delete field field value %s in %s but only a warning was promised", RlistScalarValue(rp),
@@ -2074,28 +2074,28 @@ static int EditLineByColumn(EvalContext *ctx, Rlist **columns, Attributes a,
         }
         else
         {
-            if (a.transaction.action == cfa_warn)
+            if (a->transaction.action == cfa_warn)
             {
                 cfPS(ctx, LOG_LEVEL_WARNING, PROMISE_RESULT_WARN, pp, a,
                      "Need to set column field value %s to %s in %s but only a warning was promised",
-                     RlistScalarValue(rp), a.column.column_value, edcontext->filename);
+                     RlistScalarValue(rp), a->column.column_value, edcontext->filename);
                 *result = PromiseResultUpdate(*result, PROMISE_RESULT_WARN);
                 return false;
             }
             else
             {
                 cfPS(ctx, LOG_LEVEL_INFO, PROMISE_RESULT_CHANGE, pp, a, "Setting whole column field value %s to %s in %s",
-                     RlistScalarValue(rp), a.column.column_value, edcontext->filename);
+                     RlistScalarValue(rp), a->column.column_value, edcontext->filename);
                 *result = PromiseResultUpdate(*result, PROMISE_RESULT_CHANGE);
                 free(rp->val.item);
-                rp->val.item = xstrdup(a.column.column_value);
+                rp->val.item = xstrdup(a->column.column_value);
                 (edcontext->num_edits)++;
                 return true;
             }
         }
     }
 
-    cfPS(ctx, LOG_LEVEL_VERBOSE, PROMISE_RESULT_NOOP, pp, a, "No need to edit column field value %s in %s", a.column.column_value,
+    cfPS(ctx, LOG_LEVEL_VERBOSE, PROMISE_RESULT_NOOP, pp, a, "No need to edit column field value %s in %s", a->column.column_value,
          edcontext->filename);
 
     return false;
@@ -2103,13 +2103,13 @@ static int EditLineByColumn(EvalContext *ctx, Rlist **columns, Attributes a,
 
 /***************************************************************************/
 
-static int SelectLine(EvalContext *ctx, const char *line, Attributes a)
+static int SelectLine(EvalContext *ctx, const char *line, const Attributes *a)
 {
     Rlist *rp, *c;
     int s, e;
     char *selector;
 
-    if ((c = a.line_select.startwith_from_list))
+    if ((c = a->line_select.startwith_from_list))
     {
         for (rp = c; rp != NULL; rp = rp->next)
         {
@@ -2124,7 +2124,7 @@ static int SelectLine(EvalContext *ctx, const char *line, Attributes a)
         return false;
     }
 
-    if ((c = a.line_select.not_startwith_from_list))
+    if ((c = a->line_select.not_startwith_from_list))
     {
         for (rp = c; rp != NULL; rp = rp->next)
         {
@@ -2139,7 +2139,7 @@ static int SelectLine(EvalContext *ctx, const char *line, Attributes a)
         return true;
     }
 
-    if ((c = a.line_select.match_from_list))
+    if ((c = a->line_select.match_from_list))
     {
         for (rp = c; rp != NULL; rp = rp->next)
         {
@@ -2154,7 +2154,7 @@ static int SelectLine(EvalContext *ctx, const char *line, Attributes a)
         return false;
     }
 
-    if ((c = a.line_select.not_match_from_list))
+    if ((c = a->line_select.not_match_from_list))
     {
         for (rp = c; rp != NULL; rp = rp->next)
         {
@@ -2169,7 +2169,7 @@ static int SelectLine(EvalContext *ctx, const char *line, Attributes a)
         return true;
     }
 
-    if ((c = a.line_select.contains_from_list))
+    if ((c = a->line_select.contains_from_list))
     {
         for (rp = c; rp != NULL; rp = rp->next)
         {
@@ -2184,7 +2184,7 @@ static int SelectLine(EvalContext *ctx, const char *line, Attributes a)
         return false;
     }
 
-    if ((c = a.line_select.not_contains_from_list))
+    if ((c = a->line_select.not_contains_from_list))
     {
         for (rp = c; rp != NULL; rp = rp->next)
         {
@@ -2206,16 +2206,16 @@ static int SelectLine(EvalContext *ctx, const char *line, Attributes a)
 /* Level                                                                   */
 /***************************************************************************/
 
-static int DoEditColumn(Rlist **columns, Attributes a, EditContext *edcontext)
+static int DoEditColumn(Rlist **columns, const Attributes *a, EditContext *edcontext)
 {
     Rlist *rp, *found;
     int retval = false;
 
-    if (a.column.column_operation && (strcmp(a.column.column_operation, "delete") == 0))
+    if (a->column.column_operation && (strcmp(a->column.column_operation, "delete") == 0))
     {
-        while ((found = RlistKeyIn(*columns, a.column.column_value)))
+        while ((found = RlistKeyIn(*columns, a->column.column_value)))
         {
-            Log(LOG_LEVEL_INFO, "Deleting column field sub-value '%s' in '%s'", a.column.column_value,
+            Log(LOG_LEVEL_INFO, "Deleting column field sub-value '%s' in '%s'", a->column.column_value,
                   edcontext->filename);
             RlistDestroyEntry(columns, found);
             retval = true;
@@ -2224,33 +2224,33 @@ static int DoEditColumn(Rlist **columns, Attributes a, EditContext *edcontext)
         return retval;
     }
 
-    if (a.column.column_operation && strcmp(a.column.column_operation, "set") == 0)
+    if (a->column.column_operation && strcmp(a->column.column_operation, "set") == 0)
     {
         int length = RlistLen(*columns);
-        if (length == 1 && strcmp(RlistScalarValue(*columns), a.column.column_value) == 0)
+        if (length == 1 && strcmp(RlistScalarValue(*columns), a->column.column_value) == 0)
         {
             Log(LOG_LEVEL_VERBOSE, "Field sub-value set as promised");
             return false;
         }
-        else if (length == 0 && strcmp("", a.column.column_value) == 0)
+        else if (length == 0 && strcmp("", a->column.column_value) == 0)
         {
             Log(LOG_LEVEL_VERBOSE, "Empty field sub-value set as promised");
             return false;
         }
 
-        Log(LOG_LEVEL_INFO, "Setting field sub-value '%s' in '%s'", a.column.column_value, edcontext->filename);
+        Log(LOG_LEVEL_INFO, "Setting field sub-value '%s' in '%s'", a->column.column_value, edcontext->filename);
         RlistDestroy(*columns);
         *columns = NULL;
-        RlistPrependScalarIdemp(columns, a.column.column_value);
+        RlistPrependScalarIdemp(columns, a->column.column_value);
 
         return true;
     }
 
-    if (a.column.column_operation && strcmp(a.column.column_operation, "prepend") == 0)
+    if (a->column.column_operation && strcmp(a->column.column_operation, "prepend") == 0)
     {
-        if (RlistPrependScalarIdemp(columns, a.column.column_value))
+        if (RlistPrependScalarIdemp(columns, a->column.column_value))
         {
-            Log(LOG_LEVEL_INFO, "Prepending field sub-value '%s' in '%s'", a.column.column_value, edcontext->filename);
+            Log(LOG_LEVEL_INFO, "Prepending field sub-value '%s' in '%s'", a->column.column_value, edcontext->filename);
             return true;
         }
         else
@@ -2259,9 +2259,9 @@ static int DoEditColumn(Rlist **columns, Attributes a, EditContext *edcontext)
         }
     }
 
-    if (a.column.column_operation && strcmp(a.column.column_operation, "alphanum") == 0)
+    if (a->column.column_operation && strcmp(a->column.column_operation, "alphanum") == 0)
     {
-        if (RlistPrependScalarIdemp(columns, a.column.column_value))
+        if (RlistPrependScalarIdemp(columns, a->column.column_value))
         {
             retval = true;
         }
@@ -2273,7 +2273,7 @@ static int DoEditColumn(Rlist **columns, Attributes a, EditContext *edcontext)
 
 /* default operation is append */
 
-    if (RlistAppendScalarIdemp(columns, a.column.column_value))
+    if (RlistAppendScalarIdemp(columns, a->column.column_value))
     {
         return true;
     }
@@ -70,56 +70,56 @@ static const char *const EDITXMLTYPESEQUENCE[] =
 
 static PromiseResult KeepEditXmlPromise(EvalContext *ctx, const Promise *pp, void *param);
 #ifdef HAVE_LIBXML2
-static bool VerifyXPathBuild(EvalContext *ctx, Attributes a, const Promise *pp, EditContext *edcontext, PromiseResult *result);
-static PromiseResult VerifyTreeDeletions(EvalContext *ctx, Attributes a, const Promise *pp, EditContext *edcontext);
-static PromiseResult VerifyTreeInsertions(EvalContext *ctx, Attributes a, const Promise *pp, EditContext *edcontext);
-static PromiseResult VerifyAttributeDeletions(EvalContext *ctx, Attributes a, const Promise *pp, EditContext *edcontext);
-static PromiseResult VerifyAttributeSet(EvalContext *ctx, Attributes a, const Promise *pp, EditContext *edcontext);
-static PromiseResult VerifyTextDeletions(EvalContext *ctx, Attributes a, const Promise *pp, EditContext *edcontext);
-static PromiseResult VerifyTextSet(EvalContext *ctx, Attributes a, const Promise *pp, EditContext *edcontext);
-static PromiseResult VerifyTextInsertions(EvalContext *ctx, Attributes a, const Promise *pp, EditContext *edcontext);
-static bool XmlSelectNode(EvalContext *ctx, char *xpath, xmlDocPtr doc, xmlNodePtr *docnode, Attributes a, const Promise *pp, EditContext *edcontext, PromiseResult *result);
-static bool BuildXPathInFile(EvalContext *ctx, char xpath[CF_BUFSIZE], xmlDocPtr doc, Attributes a, const Promise *pp, EditContext *edcontext, PromiseResult *result);
-static bool BuildXPathInNode(EvalContext *ctx, char xpath[CF_BUFSIZE], xmlDocPtr doc, Attributes a, const Promise *pp, EditContext *edcontext, PromiseResult *result);
-static bool DeleteTreeInNode(EvalContext *ctx, char *tree, xmlDocPtr doc, xmlNodePtr docnode, Attributes a, const Promise *pp, EditContext *edcontext, PromiseResult *result);
-static bool InsertTreeInFile(EvalContext *ctx, char *root, xmlDocPtr doc, Attributes a, const Promise *pp, EditContext *edcontext, PromiseResult *result);
-static bool InsertTreeInNode(EvalContext *ctx, char *tree, xmlDocPtr doc, xmlNodePtr docnode, Attributes a, const Promise *pp, EditContext *edcontext, PromiseResult *result);
-static bool DeleteAttributeInNode(EvalContext *ctx, char *attrname, xmlNodePtr docnode, Attributes a, const Promise *pp, EditContext *edcontext, PromiseResult *result);
-static bool SetAttributeInNode(EvalContext *ctx, char *attrname, char *attrvalue, xmlNodePtr docnode, Attributes a, const Promise *pp, EditContext *edcontext, PromiseResult *result);
-static bool DeleteTextInNode(EvalContext *ctx, char *tree, xmlDocPtr doc, xmlNodePtr docnode, Attributes a, const Promise *pp, EditContext *edcontext, PromiseResult *result);
-static bool SetTextInNode(EvalContext *ctx, char *tree, xmlDocPtr doc, xmlNodePtr docnode, Attributes a, const Promise *pp, EditContext *edcontext, PromiseResult *result);
-static bool InsertTextInNode(EvalContext *ctx, char *tree, xmlDocPtr doc, xmlNodePtr docnode, Attributes a, const Promise *pp, EditContext *edcontext, PromiseResult *result);
-static bool SanityCheckXPathBuild(EvalContext *ctx, Attributes a, const Promise *pp, PromiseResult *result);
-static bool SanityCheckTreeDeletions(Attributes a);
-static bool SanityCheckTreeInsertions(Attributes a, EditContext *edcontext);
-static bool SanityCheckAttributeDeletions(Attributes a);
-static bool SanityCheckAttributeSet(Attributes a);
-static bool SanityCheckTextDeletions(Attributes a);
-static bool SanityCheckTextSet(Attributes a);
-static bool SanityCheckTextInsertions(Attributes a);
+static bool VerifyXPathBuild(EvalContext *ctx, const Attributes *a, const Promise *pp, EditContext *edcontext, PromiseResult *result);
+static PromiseResult VerifyTreeDeletions(EvalContext *ctx, const Attributes *a, const Promise *pp, EditContext *edcontext);
+static PromiseResult VerifyTreeInsertions(EvalContext *ctx, const Attributes *a, const Promise *pp, EditContext *edcontext);
+static PromiseResult VerifyAttributeDeletions(EvalContext *ctx, const Attributes *a, const Promise *pp, EditContext *edcontext);
+static PromiseResult VerifyAttributeSet(EvalContext *ctx, const Attributes *a, const Promise *pp, EditContext *edcontext);
+static PromiseResult VerifyTextDeletions(EvalContext *ctx, const Attributes *a, const Promise *pp, EditContext *edcontext);
+static PromiseResult VerifyTextSet(EvalContext *ctx, const Attributes *a, const Promise *pp, EditContext *edcontext);
+static PromiseResult VerifyTextInsertions(EvalContext *ctx, const Attributes *a, const Promise *pp, EditContext *edcontext);
+static bool XmlSelectNode(EvalContext *ctx, char *xpath, xmlDocPtr doc, xmlNodePtr *docnode, const Attributes *a, const Promise *pp, EditContext *edcontext, PromiseResult *result);
+static bool BuildXPathInFile(EvalContext *ctx, char xpath[CF_BUFSIZE], xmlDocPtr doc, const Attributes *a, const Promise *pp, EditContext *edcontext, PromiseResult *result);
+static bool BuildXPathInNode(EvalContext *ctx, char xpath[CF_BUFSIZE], xmlDocPtr doc, const Attributes *a, const Promise *pp, EditContext *edcontext, PromiseResult *result);
+static bool DeleteTreeInNode(EvalContext *ctx, char *tree, xmlDocPtr doc, xmlNodePtr docnode, const Attributes *a, const Promise *pp, EditContext *edcontext, PromiseResult *result);
+static bool InsertTreeInFile(EvalContext *ctx, char *root, xmlDocPtr doc, const Attributes *a, const Promise *pp, EditContext *edcontext, PromiseResult *result);
+static bool InsertTreeInNode(EvalContext *ctx, char *tree, xmlDocPtr doc, xmlNodePtr docnode, const Attributes *a, const Promise *pp, EditContext *edcontext, PromiseResult *result);
+static bool DeleteAttributeInNode(EvalContext *ctx, char *attrname, xmlNodePtr docnode, const Attributes *a, const Promise *pp, EditContext *edcontext, PromiseResult *result);
+static bool SetAttributeInNode(EvalContext *ctx, char *attrname, char *attrvalue, xmlNodePtr docnode, const Attributes *a, const Promise *pp, EditContext *edcontext, PromiseResult *result);
+static bool DeleteTextInNode(EvalContext *ctx, char *tree, xmlDocPtr doc, xmlNodePtr docnode, const Attributes *a, const Promise *pp, EditContext *edcontext, PromiseResult *result);
+static bool SetTextInNode(EvalContext *ctx, char *tree, xmlDocPtr doc, xmlNodePtr docnode, const Attributes *a, const Promise *pp, EditContext *edcontext, PromiseResult *result);
+static bool InsertTextInNode(EvalContext *ctx, char *tree, xmlDocPtr doc, xmlNodePtr docnode, const Attributes *a, const Promise *pp, EditContext *edcontext, PromiseResult *result);
+static bool SanityCheckXPathBuild(EvalContext *ctx, const Attributes *a, const Promise *pp, PromiseResult *result);
+static bool SanityCheckTreeDeletions(const Attributes *a);
+static bool SanityCheckTreeInsertions(const Attributes *a, EditContext *edcontext);
+static bool SanityCheckAttributeDeletions(const Attributes *a);
+static bool SanityCheckAttributeSet(const Attributes *a);
+static bool SanityCheckTextDeletions(const Attributes *a);
+static bool SanityCheckTextSet(const Attributes *a);
+static bool SanityCheckTextInsertions(const Attributes *a);
 
 static bool XmlDocsEqualMem(xmlDocPtr doc1, xmlDocPtr doc2);
-static bool XmlNodesCompare(xmlNodePtr node1, xmlNodePtr node2, Attributes a, const Promise *pp);
+static bool XmlNodesCompare(xmlNodePtr node1, xmlNodePtr node2, const Attributes *a, const Promise *pp);
 static bool XmlNodesCompareAttributes(xmlNodePtr node1, xmlNodePtr node2);
-static bool XmlNodesCompareNodes(xmlNodePtr node1, xmlNodePtr node2, Attributes a, const Promise *pp);
+static bool XmlNodesCompareNodes(xmlNodePtr node1, xmlNodePtr node2, const Attributes *a, const Promise *pp);
 static bool XmlNodesCompareTags(const xmlNodePtr node1, const xmlNodePtr node2);
 static bool XmlNodesCompareText(xmlNodePtr node1, xmlNodePtr node2);
-static bool XmlNodesSubset(const xmlNodePtr node1, const xmlNodePtr node2, Attributes a, const Promise *pp);
+static bool XmlNodesSubset(const xmlNodePtr node1, const xmlNodePtr node2, const Attributes *a, const Promise *pp);
 static bool XmlNodesSubsetOfAttributes(const xmlNodePtr node1, const xmlNodePtr node2);
-static bool XmlNodesSubsetOfNodes(const xmlNodePtr node1, const xmlNodePtr node2, Attributes a, const Promise *pp);
+static bool XmlNodesSubsetOfNodes(const xmlNodePtr node1, const xmlNodePtr node2, const Attributes *a, const Promise *pp);
 static bool XmlNodesSubstringOfText(const xmlNodePtr node1, const xmlNodePtr node2);
 static xmlAttrPtr XmlVerifyAttributeInNode(const xmlChar *attrname, xmlChar *attrvalue, xmlNodePtr node);
 static bool XmlVerifyTextInNodeExact(const xmlChar *text, const xmlNodePtr node);
 static bool XmlVerifyTextInNodeSubstring(const xmlChar *text, xmlNodePtr node);
-static bool XmlVerifyNodeInNodeExact(const xmlNodePtr node1, const xmlNodePtr node2, Attributes a, const Promise *pp);
-static xmlNodePtr XmlVerifyNodeInNodeSubset(xmlNodePtr node1, xmlNodePtr node2, Attributes a, const Promise *pp);
+static bool XmlVerifyNodeInNodeExact(const xmlNodePtr node1, const xmlNodePtr node2, const Attributes *a, const Promise *pp);
+static xmlNodePtr XmlVerifyNodeInNodeSubset(xmlNodePtr node1, xmlNodePtr node2, const Attributes *a, const Promise *pp);
 
 //xpath build functionality
 static xmlNodePtr PredicateExtractNode(char predicate[CF_BUFSIZE]);
 static bool PredicateRemoveHead(char xpath[CF_BUFSIZE]);
 
-static xmlNodePtr XPathHeadExtractNode(EvalContext *ctx, char xpath[CF_BUFSIZE], Attributes a, const Promise *pp, PromiseResult *result);
-static xmlNodePtr XPathTailExtractNode(EvalContext *ctx, char xpath[CF_BUFSIZE], Attributes a, const Promise *pp, PromiseResult *result);
+static xmlNodePtr XPathHeadExtractNode(EvalContext *ctx, char xpath[CF_BUFSIZE], const Attributes *a, const Promise *pp, PromiseResult *result);
+static xmlNodePtr XPathTailExtractNode(EvalContext *ctx, char xpath[CF_BUFSIZE], const Attributes *a, const Promise *pp, PromiseResult *result);
 static xmlNodePtr XPathSegmentExtractNode(char segment[CF_BUFSIZE]);
 static char* XPathGetTail(char xpath[CF_BUFSIZE]);
 static bool XPathRemoveHead(char xpath[CF_BUFSIZE]);
@@ -132,7 +132,7 @@ static bool PredicateHeadContainsNode(char *predicate);
 static bool XPathHasTail(char *head);
 static bool XPathHeadContainsNode(char *head);
 static bool XPathHeadContainsPredicate(char *head);
-static bool XPathVerifyBuildSyntax(EvalContext *ctx, const char* xpath, Attributes a, const Promise *pp, PromiseResult *result);
+static bool XPathVerifyBuildSyntax(EvalContext *ctx, const char* xpath, const Attributes *a, const Promise *pp, PromiseResult *result);
 static bool XPathVerifyConvergence(const char* xpath);
 
 //helper functions
@@ -146,7 +146,7 @@ static int XmlAttributeCount(const xmlNodePtr node);
 /* Level                                                                     */
 /*****************************************************************************/
 
-int ScheduleEditXmlOperations(EvalContext *ctx, const Bundle *bp, Attributes a, const Promise *parentp, EditContext *edcontext)
+int ScheduleEditXmlOperations(EvalContext *ctx, const Bundle *bp, const Attributes *a, const Promise *parentp, EditContext *edcontext)
 {
     enum editxmltypesequence type;
     char lockname[CF_BUFSIZE];
@@ -154,7 +154,7 @@ int ScheduleEditXmlOperations(EvalContext *ctx, const Bundle *bp, Attributes a,
     int pass;
 
     snprintf(lockname, CF_BUFSIZE - 1, "masterfilelock-%s", edcontext->filename);
-    thislock = AcquireLock(ctx, lockname, VUQNAME, CFSTARTTIME, a.transaction, parentp, true);
+    thislock = AcquireLock(ctx, lockname, VUQNAME, CFSTARTTIME, a->transaction, parentp, true);
 
     if (thislock.lock == NULL)
     {
@@ -213,11 +213,12 @@ static PromiseResult KeepEditXmlPromise(EvalContext *ctx, const Promise *pp,
         Attributes a = GetInsertionAttributes(ctx, pp);
 #ifdef HAVE_LIBXML2
         EditContext *edcontext = param;
+        a.transaction.ifelapsed = CF_EDIT_IFELAPSED;
         PromiseResult result = PROMISE_RESULT_NOOP;
-        VerifyXPathBuild(ctx, a, pp, edcontext, &result);
+        VerifyXPathBuild(ctx, &a, pp, edcontext, &result);
         return result;
 #else
-        cfPS(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_FAIL, pp, a, "Cannot edit XML files without LIBXML2.");
+        cfPS(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_FAIL, pp, &a, "Cannot edit XML files without LIBXML2.");
         return PROMISE_RESULT_FAIL;
 #endif
     }
@@ -226,10 +227,11 @@ static PromiseResult KeepEditXmlPromise(EvalContext *ctx, const Promise *pp,
         Attributes a = GetDeletionAttributes(ctx, pp);
 #ifdef HAVE_LIBXML2
         EditContext *edcontext = param;
-        PromiseResult result = VerifyTreeDeletions(ctx, a, pp, edcontext);
+        a.transaction.ifelapsed = CF_EDIT_IFELAPSED;
+        PromiseResult result = VerifyTreeDeletions(ctx, &a, pp, edcontext);
         return result;
 #else
-        cfPS(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_FAIL, pp, a, "Cannot edit XML files without LIBXML2");
+        cfPS(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_FAIL, pp, &a, "Cannot edit XML files without LIBXML2");
         return PROMISE_RESULT_FAIL;
 #endif
     }
@@ -238,10 +240,11 @@ static PromiseResult KeepEditXmlPromise(EvalContext *ctx, const Promise *pp,
         Attributes a = GetInsertionAttributes(ctx, pp);
 #ifdef HAVE_LIBXML2
         EditContext *edcontext = param;
-        PromiseResult result = VerifyTreeInsertions(ctx, a, pp, edcontext);
+        a.transaction.ifelapsed = CF_EDIT_IFELAPSED;
+        PromiseResult result = VerifyTreeInsertions(ctx, &a, pp, edcontext);
         return result;
 #else
-        cfPS(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_FAIL, pp, a, "Cannot edit XML files without LIBXML2");
+        cfPS(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_FAIL, pp, &a, "Cannot edit XML files without LIBXML2");
         return PROMISE_RESULT_FAIL;
 #endif
     }
@@ -250,10 +253,11 @@ static PromiseResult KeepEditXmlPromise(EvalContext *ctx, const Promise *pp,
         Attributes a = GetDeletionAttributes(ctx, pp);
 #ifdef HAVE_LIBXML2
         EditContext *edcontext = param;
-        PromiseResult result = VerifyAttributeDeletions(ctx, a, pp, edcontext);
+        a.transaction.ifelapsed = CF_EDIT_IFELAPSED;
+        PromiseResult result = VerifyAttributeDeletions(ctx, &a, pp, edcontext);
         return result;
 #else
-        cfPS(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_FAIL, pp, a, "Cannot edit XML files without LIBXML2");
+        cfPS(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_FAIL, pp, &a, "Cannot edit XML files without LIBXML2");
         return PROMISE_RESULT_FAIL;
 #endif
     }
@@ -262,10 +266,11 @@ static PromiseResult KeepEditXmlPromise(EvalContext *ctx, const Promise *pp,
         Attributes a = GetInsertionAttributes(ctx, pp);
 #ifdef HAVE_LIBXML2
         EditContext *edcontext = param;
-        PromiseResult result = VerifyAttributeSet(ctx, a, pp, edcontext);
+        a.transaction.ifelapsed = CF_EDIT_IFELAPSED;
+        PromiseResult result = VerifyAttributeSet(ctx, &a, pp, edcontext);
         return result;
 #else
-        cfPS(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_FAIL, pp, a, "Cannot edit XML files without LIBXML2");
+        cfPS(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_FAIL, pp, &a, "Cannot edit XML files without LIBXML2");
         return PROMISE_RESULT_FAIL;
 #endif
     }
@@ -274,10 +279,11 @@ static PromiseResult KeepEditXmlPromise(EvalContext *ctx, const Promise *pp,
         Attributes a = GetDeletionAttributes(ctx, pp);
 #ifdef HAVE_LIBXML2
         EditContext *edcontext = param;
-        PromiseResult result = VerifyTextDeletions(ctx, a, pp, edcontext);
+        a.transaction.ifelapsed = CF_EDIT_IFELAPSED;
+        PromiseResult result = VerifyTextDeletions(ctx, &a, pp, edcontext);
         return result;
 #else
-        cfPS(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_FAIL, pp, a, "Cannot edit XML files without LIBXML2");
+        cfPS(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_FAIL, pp, &a, "Cannot edit XML files without LIBXML2");
         return PROMISE_RESULT_FAIL;
 #endif
     }
@@ -286,10 +292,11 @@ static PromiseResult KeepEditXmlPromise(EvalContext *ctx, const Promise *pp,
         Attributes a = GetInsertionAttributes(ctx, pp);
 #ifdef HAVE_LIBXML2
         EditContext *edcontext = param;
-        PromiseResult result = VerifyTextSet(ctx, a, pp, edcontext);
+        a.transaction.ifelapsed = CF_EDIT_IFELAPSED;
+        PromiseResult result = VerifyTextSet(ctx, &a, pp, edcontext);
         return result;
 #else
-        cfPS(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_FAIL, pp, a, "Cannot edit XML files without LIBXML2");
+        cfPS(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_FAIL, pp, &a, "Cannot edit XML files without LIBXML2");
         return PROMISE_RESULT_FAIL;
 #endif
     }
@@ -298,10 +305,11 @@ static PromiseResult KeepEditXmlPromise(EvalContext *ctx, const Promise *pp,
         Attributes a = GetInsertionAttributes(ctx, pp);
 #ifdef HAVE_LIBXML2
         EditContext *edcontext = param;
-        PromiseResult result = VerifyTextInsertions(ctx, a, pp, edcontext);
+        a.transaction.ifelapsed = CF_EDIT_IFELAPSED;
+        PromiseResult result = VerifyTextInsertions(ctx, &a, pp, edcontext);
         return result;
 #else
-        cfPS(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_FAIL, pp, a, "Cannot edit XML files without LIBXML2");
+        cfPS(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_FAIL, pp, &a, "Cannot edit XML files without LIBXML2");
         return PROMISE_RESULT_FAIL;
 #endif
     }
@@ -319,17 +327,15 @@ static PromiseResult KeepEditXmlPromise(EvalContext *ctx, const Promise *pp,
 
 /***************************************************************************/
 
-static bool VerifyXPathBuild(EvalContext *ctx, Attributes a, const Promise *pp, EditContext *edcontext, PromiseResult *result)
+static bool VerifyXPathBuild(EvalContext *ctx, const Attributes *a, const Promise *pp, EditContext *edcontext, PromiseResult *result)
 {
     xmlDocPtr doc = NULL;
     CfLock thislock;
     char lockname[CF_BUFSIZE], rawxpath[CF_BUFSIZE] = { 0 };
 
-    a.transaction.ifelapsed = CF_EDIT_IFELAPSED;
-
-    if (a.xml.havebuildxpath)
+    if (a->xml.havebuildxpath)
     {
-        strcpy(rawxpath, a.xml.build_xpath);
+        strcpy(rawxpath, a->xml.build_xpath);
     }
     else
     {
@@ -352,7 +358,7 @@ static bool VerifyXPathBuild(EvalContext *ctx, Attributes a, const Promise *pp,
     }
 
     snprintf(lockname, CF_BUFSIZE - 1, "buildxpath-%s-%s", pp->promiser, edcontext->filename);
-    thislock = AcquireLock(ctx, lockname, VUQNAME, CFSTARTTIME, a.transaction, pp, true);
+    thislock = AcquireLock(ctx, lockname, VUQNAME, CFSTARTTIME, a->transaction, pp, true);
 
     if (thislock.lock == NULL)
     {
@@ -379,15 +385,13 @@ static bool VerifyXPathBuild(EvalContext *ctx, Attributes a, const Promise *pp,
 
 /***************************************************************************/
 
-static PromiseResult VerifyTreeDeletions(EvalContext *ctx, Attributes a, const Promise *pp, EditContext *edcontext)
+static PromiseResult VerifyTreeDeletions(EvalContext *ctx, const Attributes *a, const Promise *pp, EditContext *edcontext)
 {
     xmlDocPtr doc = NULL;
     xmlNodePtr docnode = NULL;
     CfLock thislock;
     char lockname[CF_BUFSIZE];
 
-    a.transaction.ifelapsed = CF_EDIT_IFELAPSED;
-
     if (!SanityCheckTreeDeletions(a))
     {
         cfPS(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_INTERRUPTED, pp, a,
@@ -396,7 +400,7 @@ static PromiseResult VerifyTreeDeletions(EvalContext *ctx, Attributes a, const P
     }
 
     PromiseResult result = PROMISE_RESULT_NOOP;
-    if (a.xml.havebuildxpath && !VerifyXPathBuild(ctx, a, pp, edcontext, &result))
+    if (a->xml.havebuildxpath && !VerifyXPathBuild(ctx, a, pp, edcontext, &result))
     {
         return result;
     }
@@ -408,17 +412,17 @@ static PromiseResult VerifyTreeDeletions(EvalContext *ctx, Attributes a, const P
         return result;
     }
 
-    if (!XmlSelectNode(ctx, a.xml.select_xpath, doc, &docnode, a, pp, edcontext, &result))
+    if (!XmlSelectNode(ctx, a->xml.select_xpath, doc, &docnode, a, pp, edcontext, &result))
     {
         cfPS(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_INTERRUPTED, pp, a,
             "The promised XPath pattern '%s', was NOT successful when selecting an edit node, in XML document '%s)",
-             a.xml.select_xpath, edcontext->filename);
+             a->xml.select_xpath, edcontext->filename);
         result = PromiseResultUpdate(result, PROMISE_RESULT_INTERRUPTED);
         return result;
     }
 
     snprintf(lockname, CF_BUFSIZE - 1, "deletetree-%s-%s", pp->promiser, edcontext->filename);
-    thislock = AcquireLock(ctx, lockname, VUQNAME, CFSTARTTIME, a.transaction, pp, true);
+    thislock = AcquireLock(ctx, lockname, VUQNAME, CFSTARTTIME, a->transaction, pp, true);
 
     if (thislock.lock == NULL)
     {
@@ -437,15 +441,13 @@ static PromiseResult VerifyTreeDeletions(EvalContext *ctx, Attributes a, const P
 
 /***************************************************************************/
 
-static PromiseResult VerifyTreeInsertions(EvalContext *ctx, Attributes a, const Promise *pp, EditContext *edcontext)
+static PromiseResult VerifyTreeInsertions(EvalContext *ctx, const Attributes *a, const Promise *pp, EditContext *edcontext)
 {
     xmlDocPtr doc = NULL;
     xmlNodePtr docnode = NULL;
     CfLock thislock;
     char lockname[CF_BUFSIZE];
 
-    a.transaction.ifelapsed = CF_EDIT_IFELAPSED;
-
     PromiseResult result = PROMISE_RESULT_NOOP;
     if (!SanityCheckTreeInsertions(a, edcontext))
     {
@@ -455,7 +457,7 @@ static PromiseResult VerifyTreeInsertions(EvalContext *ctx, Attributes a, const
         return result;
     }
 
-    if (a.xml.havebuildxpath && !VerifyXPathBuild(ctx, a, pp, edcontext, &result))
+    if (a->xml.havebuildxpath && !VerifyXPathBuild(ctx, a, pp, edcontext, &result))
     {
         result = PromiseResultUpdate(result, PROMISE_RESULT_INTERRUPTED);
         return result;
@@ -469,17 +471,17 @@ static PromiseResult VerifyTreeInsertions(EvalContext *ctx, Attributes a, const
     }
 
     //if file is not empty: select an edit node, for tree insertion
-    if (a.xml.haveselectxpath && !XmlSelectNode(ctx, a.xml.select_xpath, doc, &docnode, a, pp, edcontext, &result))
+    if (a->xml.haveselectxpath && !XmlSelectNode(ctx, a->xml.select_xpath, doc, &docnode, a, pp, edcontext, &result))
     {
         cfPS(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_INTERRUPTED, pp, a,
              "The promised XPath pattern '%s', was NOT successful when selecting an edit node, in XML document '%s'",
-             a.xml.select_xpath, edcontext->filename);
+             a->xml.select_xpath, edcontext->filename);
         result = PromiseResultUpdate(result, PROMISE_RESULT_INTERRUPTED);
         return result;
     }
 
     snprintf(lockname, CF_BUFSIZE - 1, "inserttree-%s-%s", pp->promiser, edcontext->filename);
-    thislock = AcquireLock(ctx, lockname, VUQNAME, CFSTARTTIME, a.transaction, pp, true);
+    thislock = AcquireLock(ctx, lockname, VUQNAME, CFSTARTTIME, a->transaction, pp, true);
 
     if (thislock.lock == NULL)
     {
@@ -487,7 +489,7 @@ static PromiseResult VerifyTreeInsertions(EvalContext *ctx, Attributes a, const
     }
 
     //insert tree into empty file or selected node
-    if (!a.xml.haveselectxpath)
+    if (!a->xml.haveselectxpath)
     {
         if (InsertTreeInFile(ctx, pp->promiser, doc, a, pp, edcontext, &result))
         {
@@ -505,15 +507,13 @@ static PromiseResult VerifyTreeInsertions(EvalContext *ctx, Attributes a, const
 
 /***************************************************************************/
 
-static PromiseResult VerifyAttributeDeletions(EvalContext *ctx, Attributes a, const Promise *pp, EditContext *edcontext)
+static PromiseResult VerifyAttributeDeletions(EvalContext *ctx, const Attributes *a, const Promise *pp, EditContext *edcontext)
 {
     xmlDocPtr doc = NULL;
     xmlNodePtr docnode = NULL;
     CfLock thislock;
     char lockname[CF_BUFSIZE];
 
-    a.transaction.ifelapsed = CF_EDIT_IFELAPSED;
-
     PromiseResult result = PROMISE_RESULT_NOOP;
     if (!SanityCheckAttributeDeletions(a))
     {
@@ -523,7 +523,7 @@ static PromiseResult VerifyAttributeDeletions(EvalContext *ctx, Attributes a, co
         return result;
     }
 
-    if (a.xml.havebuildxpath && !VerifyXPathBuild(ctx, a, pp, edcontext, &result))
+    if (a->xml.havebuildxpath && !VerifyXPathBuild(ctx, a, pp, edcontext, &result))
     {
         return result;
     }
@@ -535,17 +535,17 @@ static PromiseResult VerifyAttributeDeletions(EvalContext *ctx, Attributes a, co
         return result;
     }
 
-    if (!XmlSelectNode(ctx, a.xml.select_xpath, doc, &docnode, a, pp, edcontext, &result))
+    if (!XmlSelectNode(ctx, a->xml.select_xpath, doc, &docnode, a, pp, edcontext, &result))
     {
         cfPS(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_INTERRUPTED, pp, a,
             "The promised XPath pattern '%s', was NOT successful when selecting an edit node, in XML document '%s'",
-             a.xml.select_xpath, edcontext->filename);
+             a->xml.select_xpath, edcontext->filename);
         result = PromiseResultUpdate(result, PROMISE_RESULT_INTERRUPTED);
         return result;
     }
 
     snprintf(lockname, CF_BUFSIZE - 1, "deleteattribute-%s-%s", pp->promiser, edcontext->filename);
-    thislock = AcquireLock(ctx, lockname, VUQNAME, CFSTARTTIME, a.transaction, pp, true);
+    thislock = AcquireLock(ctx, lockname, VUQNAME, CFSTARTTIME, a->transaction, pp, true);
 
     if (thislock.lock == NULL)
     {
@@ -563,15 +563,13 @@ static PromiseResult VerifyAttributeDeletions(EvalContext *ctx, Attributes a, co
 
 /***************************************************************************/
 
-static PromiseResult VerifyAttributeSet(EvalContext *ctx, Attributes a, const Promise *pp, EditContext *edcontext)
+static PromiseResult VerifyAttributeSet(EvalContext *ctx, const Attributes *a, const Promise *pp, EditContext *edcontext)
 {
     xmlDocPtr doc = NULL;
     xmlNodePtr docnode = NULL;
     CfLock thislock;
     char lockname[CF_BUFSIZE];
 
-    a.transaction.ifelapsed = CF_EDIT_IFELAPSED;
-
     PromiseResult result = PROMISE_RESULT_NOOP;
     if (!SanityCheckAttributeSet(a))
     {
@@ -581,7 +579,7 @@ static PromiseResult VerifyAttributeSet(EvalContext *ctx, Attributes a, const Pr
         return result;
     }
 
-    if (a.xml.havebuildxpath && !VerifyXPathBuild(ctx, a, pp, edcontext, &result))
+    if (a->xml.havebuildxpath && !VerifyXPathBuild(ctx, a, pp, edcontext, &result))
     {
         return result;
     }
@@ -593,24 +591,24 @@ static PromiseResult VerifyAttributeSet(EvalContext *ctx, Attributes a, const Pr
         return result;
     }
 
-    if (!XmlSelectNode(ctx, a.xml.select_xpath, doc, &docnode, a, pp, edcontext, &result))
+    if (!XmlSelectNode(ctx, a->xml.select_xpath, doc, &docnode, a, pp, edcontext, &result))
     {
         cfPS(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_INTERRUPTED, pp, a,
             "The promised XPath pattern '%s', was NOT successful when selecting an edit node, in XML document '%s'",
-             a.xml.select_xpath, edcontext->filename);
+             a->xml.select_xpath, edcontext->filename);
         result = PromiseResultUpdate(result, PROMISE_RESULT_INTERRUPTED);
         return result;
     }
 
     snprintf(lockname, CF_BUFSIZE - 1, "setattribute-%s-%s", pp->promiser, edcontext->filename);
-    thislock = AcquireLock(ctx, lockname, VUQNAME, CFSTARTTIME, a.transaction, pp, true);
+    thislock = AcquireLock(ctx, lockname, VUQNAME, CFSTARTTIME, a->transaction, pp, true);
 
     if (thislock.lock == NULL)
     {
         return result;
     }
 
-    if (SetAttributeInNode(ctx, pp->promiser, a.xml.attribute_value, docnode, a, pp, edcontext, &result))
+    if (SetAttributeInNode(ctx, pp->promiser, a->xml.attribute_value, docnode, a, pp, edcontext, &result))
     {
         (edcontext->num_edits)++;
     }
@@ -621,15 +619,13 @@ static PromiseResult VerifyAttributeSet(EvalContext *ctx, Attributes a, const Pr
 
 /***************************************************************************/
 
-static PromiseResult VerifyTextDeletions(EvalContext *ctx, Attributes a, const Promise *pp, EditContext *edcontext)
+static PromiseResult VerifyTextDeletions(EvalContext *ctx, const Attributes *a, const Promise *pp, EditContext *edcontext)
 {
     xmlDocPtr doc = NULL;
     xmlNodePtr docnode = NULL;
     CfLock thislock;
     char lockname[CF_BUFSIZE];
 
-    a.transaction.ifelapsed = CF_EDIT_IFELAPSED;
-
     PromiseResult result = PROMISE_RESULT_NOOP;
     if (!SanityCheckTextDeletions(a))
     {
@@ -639,7 +635,7 @@ static PromiseResult VerifyTextDeletions(EvalContext *ctx, Attributes a, const P
         return result;
     }
 
-    if (a.xml.havebuildxpath && !VerifyXPathBuild(ctx, a, pp, edcontext, &result))
+    if (a->xml.havebuildxpath && !VerifyXPathBuild(ctx, a, pp, edcontext, &result))
     {
         return result;
     }
@@ -651,17 +647,17 @@ static PromiseResult VerifyTextDeletions(EvalContext *ctx, Attributes a, const P
         return result;
     }
 
-    if (!XmlSelectNode(ctx, a.xml.select_xpath, doc, &docnode, a, pp, edcontext, &result))
+    if (!XmlSelectNode(ctx, a->xml.select_xpath, doc, &docnode, a, pp, edcontext, &result))
     {
         cfPS(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_INTERRUPTED, pp, a,
             "The promised XPath pattern '%s', was NOT successful when selecting an edit node, in XML document '%s'",
-             a.xml.select_xpath, edcontext->filename);
+             a->xml.select_xpath, edcontext->filename);
         result = PromiseResultUpdate(result, PROMISE_RESULT_INTERRUPTED);
         return result;
     }
 
     snprintf(lockname, CF_BUFSIZE - 1, "deletetext-%s-%s", pp->promiser, edcontext->filename);
-    thislock = AcquireLock(ctx, lockname, VUQNAME, CFSTARTTIME, a.transaction, pp, true);
+    thislock = AcquireLock(ctx, lockname, VUQNAME, CFSTARTTIME, a->transaction, pp, true);
 
     if (thislock.lock == NULL)
     {
@@ -679,15 +675,13 @@ static PromiseResult VerifyTextDeletions(EvalContext *ctx, Attributes a, const P
 
 /***************************************************************************/
 
-static PromiseResult VerifyTextSet(EvalContext *ctx, Attributes a, const Promise *pp, EditContext *edcontext)
+static PromiseResult VerifyTextSet(EvalContext *ctx, const Attributes *a, const Promise *pp, EditContext *edcontext)
 {
     xmlDocPtr doc = NULL;
     xmlNodePtr docnode = NULL;
     CfLock thislock;
     char lockname[CF_BUFSIZE];
 
-    a.transaction.ifelapsed = CF_EDIT_IFELAPSED;
-
     PromiseResult result = PROMISE_RESULT_NOOP;
     if (!SanityCheckTextSet(a))
     {
@@ -697,7 +691,7 @@ static PromiseResult VerifyTextSet(EvalContext *ctx, Attributes a, const Promise
         return result;
     }
 
-    if (a.xml.havebuildxpath && !VerifyXPathBuild(ctx, a, pp, edcontext, &result))
+    if (a->xml.havebuildxpath && !VerifyXPathBuild(ctx, a, pp, edcontext, &result))
     {
         return result;
     }
@@ -709,17 +703,17 @@ static PromiseResult VerifyTextSet(EvalContext *ctx, Attributes a, const Promise
         return result;
     }
 
-    if (!XmlSelectNode(ctx, a.xml.select_xpath, doc, &docnode, a, pp, edcontext, &result))
+    if (!XmlSelectNode(ctx, a->xml.select_xpath, doc, &docnode, a, pp, edcontext, &result))
     {
         cfPS(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_INTERRUPTED, pp, a,
             "The promised XPath pattern '%s', was NOT successful when selecting an edit node, in XML document '%s'",
-             a.xml.select_xpath, edcontext->filename);
+             a->xml.select_xpath, edcontext->filename);
         result = PromiseResultUpdate(result, PROMISE_RESULT_INTERRUPTED);
         return result;
     }
 
     snprintf(lockname, CF_BUFSIZE - 1, "settext-%s-%s", pp->promiser, edcontext->filename);
-    thislock = AcquireLock(ctx, lockname, VUQNAME, CFSTARTTIME, a.transaction, pp, true);
+    thislock = AcquireLock(ctx, lockname, VUQNAME, CFSTARTTIME, a->transaction, pp, true);
 
     if (thislock.lock == NULL)
     {
@@ -737,15 +731,13 @@ static PromiseResult VerifyTextSet(EvalContext *ctx, Attributes a, const Promise
 
 /***************************************************************************/
 
-static PromiseResult VerifyTextInsertions(EvalContext *ctx, Attributes a, const Promise *pp, EditContext *edcontext)
+static PromiseResult VerifyTextInsertions(EvalContext *ctx, const Attributes *a, const Promise *pp, EditContext *edcontext)
 {
     xmlDocPtr doc = NULL;
     xmlNodePtr docnode = NULL;
     CfLock thislock;
     char lockname[CF_BUFSIZE];
 
-    a.transaction.ifelapsed = CF_EDIT_IFELAPSED;
-
     PromiseResult result = PROMISE_RESULT_NOOP;
     if (!SanityCheckTextInsertions(a))
     {
@@ -755,7 +747,7 @@ static PromiseResult VerifyTextInsertions(EvalContext *ctx, Attributes a, const
         return result;
     }
 
-    if (a.xml.havebuildxpath && !VerifyXPathBuild(ctx, a, pp, edcontext, &result))
+    if (a->xml.havebuildxpath && !VerifyXPathBuild(ctx, a, pp, edcontext, &result))
     {
         return result;
     }
@@ -767,17 +759,17 @@ static PromiseResult VerifyTextInsertions(EvalContext *ctx, Attributes a, const
         return result;
     }
 
-    if (!XmlSelectNode(ctx, a.xml.select_xpath, doc, &docnode, a, pp, edcontext, &result))
+    if (!XmlSelectNode(ctx, a->xml.select_xpath, doc, &docnode, a, pp, edcontext, &result))
     {
         cfPS(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_INTERRUPTED, pp, a,
             "The promised XPath pattern '%s', was NOT successful when selecting an edit node, in XML document '%s'",
-             a.xml.select_xpath, edcontext->filename);
+             a->xml.select_xpath, edcontext->filename);
         result = PromiseResultUpdate(result, PROMISE_RESULT_INTERRUPTED);
         return result;
     }
 
     snprintf(lockname, CF_BUFSIZE - 1, "inserttext-%s-%s", pp->promiser, edcontext->filename);
-    thislock = AcquireLock(ctx, lockname, VUQNAME, CFSTARTTIME, a.transaction, pp, true);
+    thislock = AcquireLock(ctx, lockname, VUQNAME, CFSTARTTIME, a->transaction, pp, true);
 
     if (thislock.lock == NULL)
     {
@@ -803,7 +795,7 @@ It returns true if a match was identified, else false.
 If no such node matches, docnode should point to NULL
 
 */
-static bool XmlSelectNode(EvalContext *ctx, char *rawxpath, xmlDocPtr doc, xmlNodePtr *docnode, Attributes a,
+static bool XmlSelectNode(EvalContext *ctx, char *rawxpath, xmlDocPtr doc, xmlNodePtr *docnode, const Attributes *a,
                           const Promise *pp, EditContext *edcontext, PromiseResult *result)
 {
     xmlNodePtr cur = NULL;
@@ -894,7 +886,7 @@ static bool XmlSelectNode(EvalContext *ctx, char *rawxpath, xmlDocPtr doc, xmlNo
 
 /***************************************************************************/
 
-static bool BuildXPathInFile(EvalContext *ctx, char rawxpath[CF_BUFSIZE], xmlDocPtr doc, Attributes a,
+static bool BuildXPathInFile(EvalContext *ctx, char rawxpath[CF_BUFSIZE], xmlDocPtr doc, const Attributes *a,
                              const Promise *pp, EditContext *edcontext, PromiseResult *result)
 {
     xmlNodePtr docnode = NULL, head = NULL;
@@ -954,7 +946,7 @@ static bool BuildXPathInFile(EvalContext *ctx, char rawxpath[CF_BUFSIZE], xmlDoc
 
 /***************************************************************************/
 
-static bool BuildXPathInNode(EvalContext *ctx, char rawxpath[CF_BUFSIZE], xmlDocPtr doc, Attributes a,
+static bool BuildXPathInNode(EvalContext *ctx, char rawxpath[CF_BUFSIZE], xmlDocPtr doc, const Attributes *a,
                              const Promise *pp, EditContext *edcontext, PromiseResult *result)
 {
     xmlNodePtr docnode = NULL,  head = NULL, tail = NULL;
@@ -1003,7 +995,7 @@ static bool BuildXPathInNode(EvalContext *ctx, char rawxpath[CF_BUFSIZE], xmlDoc
 
 /***************************************************************************/
 
-static bool InsertTreeInFile(EvalContext *ctx, char *rawtree, xmlDocPtr doc, Attributes a,
+static bool InsertTreeInFile(EvalContext *ctx, char *rawtree, xmlDocPtr doc, const Attributes *a,
                              const Promise *pp, EditContext *edcontext, PromiseResult *result)
 {
     xmlNodePtr treenode = NULL, rootnode = NULL;
@@ -1059,7 +1051,7 @@ static bool InsertTreeInFile(EvalContext *ctx, char *rawtree, xmlDocPtr doc, Att
         return false;
     }
 
-    if (a.transaction.action == cfa_warn)
+    if (a->transaction.action == cfa_warn)
     {
         cfPS(ctx, LOG_LEVEL_WARNING, PROMISE_RESULT_WARN, pp, a,
              "Need to insert the promised tree '%s' into an empty XML document '%s' - but only a warning was promised",
@@ -1096,7 +1088,7 @@ static bool InsertTreeInFile(EvalContext *ctx, char *rawtree, xmlDocPtr doc, Att
 
 /***************************************************************************/
 
-static bool DeleteTreeInNode(EvalContext *ctx, char *rawtree, xmlDocPtr doc, xmlNodePtr docnode, Attributes a,
+static bool DeleteTreeInNode(EvalContext *ctx, char *rawtree, xmlDocPtr doc, xmlNodePtr docnode, const Attributes *a,
                              const Promise *pp, EditContext *edcontext, PromiseResult *result)
 {
     //for parsing subtree from memory
@@ -1105,7 +1097,7 @@ static bool DeleteTreeInNode(EvalContext *ctx, char *rawtree, xmlDocPtr doc, xml
     {
         cfPS(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_INTERRUPTED, pp, a,
              "Tree to be deleted '%s' at XPath '%s' in XML document '%s', was NOT successfully loaded into an XML buffer",
-             rawtree, a.xml.select_xpath, edcontext->filename);
+             rawtree, a->xml.select_xpath, edcontext->filename);
         *result = PromiseResultUpdate(*result, PROMISE_RESULT_INTERRUPTED);
         return false;
     }
@@ -1116,7 +1108,7 @@ static bool DeleteTreeInNode(EvalContext *ctx, char *rawtree, xmlDocPtr doc, xml
     {
         cfPS(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_INTERRUPTED, pp, a,
              "Tree to be deleted '%s' at XPath '%s' in XML document '%s', was NOT parsed successfully",
-             rawtree, a.xml.select_xpath, edcontext->filename);
+             rawtree, a->xml.select_xpath, edcontext->filename);
         *result = PromiseResultUpdate(*result, PROMISE_RESULT_INTERRUPTED);
         xmlFreeNode(treenode);
         return false;
@@ -1127,16 +1119,16 @@ static bool DeleteTreeInNode(EvalContext *ctx, char *rawtree, xmlDocPtr doc, xml
     if ((deletetree = XmlVerifyNodeInNodeSubset(treenode, docnode, a, pp)) == NULL)
     {
         cfPS(ctx, LOG_LEVEL_VERBOSE, PROMISE_RESULT_NOOP, pp, a, "The promised tree to be deleted '%s' does NOT exist, at XPath '%s' in XML document '%s' (promise kept)",
-             rawtree, a.xml.select_xpath, edcontext->filename);
+             rawtree, a->xml.select_xpath, edcontext->filename);
         xmlFreeNode(treenode);
         return false;
     }
 
-    if (a.transaction.action == cfa_warn)
+    if (a->transaction.action == cfa_warn)
     {
         cfPS(ctx, LOG_LEVEL_WARNING, PROMISE_RESULT_WARN, pp, a,
              "Need to delete the promised tree '%s' at XPath '%s' in XML document '%s' - but only a warning was promised",
-             rawtree, a.xml.select_xpath, edcontext->filename);
+             rawtree, a->xml.select_xpath, edcontext->filename);
         *result = PromiseResultUpdate(*result, PROMISE_RESULT_WARN);
         xmlFreeNode(treenode);
         xmlFreeNode(deletetree);
@@ -1151,7 +1143,7 @@ static bool DeleteTreeInNode(EvalContext *ctx, char *rawtree, xmlDocPtr doc, xml
          a,
          "Deleting tree '%s' at XPath '%s' in XML document '%s'",
          rawtree,
-         a.xml.select_xpath,
+         a->xml.select_xpath,
          edcontext->filename);
     *result = PromiseResultUpdate(*result, PROMISE_RESULT_CHANGE);
     xmlUnlinkNode(deletetree);
@@ -1164,7 +1156,7 @@ static bool DeleteTreeInNode(EvalContext *ctx, char *rawtree, xmlDocPtr doc, xml
         {
             cfPS(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_INTERRUPTED, pp, a,
                  "The promised tree to be deleted '%s' was NOT successfully deleted, at XPath '%s' in XML document '%s'",
-                 rawtree, a.xml.select_xpath, edcontext->filename);
+                 rawtree, a->xml.select_xpath, edcontext->filename);
             *result = PromiseResultUpdate(*result, PROMISE_RESULT_INTERRUPTED);
             xmlFreeNode(treenode);
             xmlFreeNode(ret);
@@ -1178,7 +1170,7 @@ static bool DeleteTreeInNode(EvalContext *ctx, char *rawtree, xmlDocPtr doc, xml
 
 /***************************************************************************/
 
-static bool InsertTreeInNode(EvalContext *ctx, char *rawtree, xmlDocPtr doc, xmlNodePtr docnode, Attributes a,
+static bool InsertTreeInNode(EvalContext *ctx, char *rawtree, xmlDocPtr doc, xmlNodePtr docnode, const Attributes *a,
                              const Promise *pp, EditContext *edcontext, PromiseResult *result)
 {
     xmlNodePtr treenode = NULL;
@@ -1189,7 +1181,7 @@ static bool InsertTreeInNode(EvalContext *ctx, char *rawtree, xmlDocPtr doc, xml
     {
         cfPS(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_INTERRUPTED, pp, a,
              "Tree to be inserted '%s' at XPath '%s' in XML document '%s', was NOT successfully loaded into an XML buffer",
-             rawtree, a.xml.select_xpath, edcontext->filename);
+             rawtree, a->xml.select_xpath, edcontext->filename);
         *result = PromiseResultUpdate(*result, PROMISE_RESULT_INTERRUPTED);
         return false;
     }
@@ -1199,7 +1191,7 @@ static bool InsertTreeInNode(EvalContext *ctx, char *rawtree, xmlDocPtr doc, xml
     {
         cfPS(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_INTERRUPTED, pp, a,
              "Tree to be inserted '%s' at XPath '%s' in XML document '%s', was NOT parsed successfully",
-             rawtree, a.xml.select_xpath, edcontext->filename);
+             rawtree, a->xml.select_xpath, edcontext->filename);
         *result = PromiseResultUpdate(*result, PROMISE_RESULT_INTERRUPTED);
         return false;
     }
@@ -1207,7 +1199,7 @@ static bool InsertTreeInNode(EvalContext *ctx, char *rawtree, xmlDocPtr doc, xml
     if (treenode == NULL || (treenode->name) == NULL)
     {
         cfPS(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_INTERRUPTED, pp, a, "The promised tree to be inserted '%s' at XPath '%s' in XML document '%s', is empty",
-             rawtree, a.xml.select_xpath, edcontext->filename);
+             rawtree, a->xml.select_xpath, edcontext->filename);
         *result = PromiseResultUpdate(*result, PROMISE_RESULT_INTERRUPTED);
         return false;
     }
@@ -1216,28 +1208,28 @@ static bool InsertTreeInNode(EvalContext *ctx, char *rawtree, xmlDocPtr doc, xml
     if (XmlVerifyNodeInNodeSubset(treenode, docnode, a, pp))
     {
         cfPS(ctx, LOG_LEVEL_VERBOSE, PROMISE_RESULT_NOOP, pp, a, "The promised tree to be inserted '%s' already exists, at XPath '%s' in XML document '%s' (promise kept)",
-             rawtree, a.xml.select_xpath, edcontext->filename);
+             rawtree, a->xml.select_xpath, edcontext->filename);
         return false;
     }
 
-    if (a.transaction.action == cfa_warn)
+    if (a->transaction.action == cfa_warn)
     {
         cfPS(ctx, LOG_LEVEL_WARNING, PROMISE_RESULT_WARN, pp, a,
              "Need to insert the promised tree '%s' at XPath '%s' in XML document '%s' - but only a warning was promised",
-             rawtree, a.xml.select_xpath, edcontext->filename);
+             rawtree, a->xml.select_xpath, edcontext->filename);
         *result = PromiseResultUpdate(*result, PROMISE_RESULT_WARN);
         return true;
     }
 
     //insert the subtree into XML document
     cfPS(ctx, LOG_LEVEL_VERBOSE, PROMISE_RESULT_CHANGE, pp, a, "Inserting tree '%s' at XPath '%s' in XML document '%s'",
-         rawtree, a.xml.select_xpath, edcontext->filename);
+         rawtree, a->xml.select_xpath, edcontext->filename);
     *result = PromiseResultUpdate(*result, PROMISE_RESULT_CHANGE);
     if (!xmlAddChild(docnode, treenode))
     {
         cfPS(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_INTERRUPTED, pp, a,
              "The promised tree '%s' was NOT inserted successfully, at XPath '%s' in XML document '%s'",
-             rawtree, a.xml.select_xpath, edcontext->filename);
+             rawtree, a->xml.select_xpath, edcontext->filename);
         *result = PromiseResultUpdate(*result, PROMISE_RESULT_INTERRUPTED);
         return false;
     }
@@ -1247,7 +1239,7 @@ static bool InsertTreeInNode(EvalContext *ctx, char *rawtree, xmlDocPtr doc, xml
     {
         cfPS(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_INTERRUPTED, pp, a,
              "The promised tree '%s' was NOT inserted successfully, at XPath '%s' in XML document '%s'",
-             rawtree, a.xml.select_xpath, edcontext->filename);
+             rawtree, a->xml.select_xpath, edcontext->filename);
         *result = PromiseResultUpdate(*result, PROMISE_RESULT_INTERRUPTED);
         return false;
     }
@@ -1257,7 +1249,7 @@ static bool InsertTreeInNode(EvalContext *ctx, char *rawtree, xmlDocPtr doc, xml
 
 /***************************************************************************/
 
-static bool DeleteAttributeInNode(EvalContext *ctx, char *rawname, xmlNodePtr docnode, Attributes a,
+static bool DeleteAttributeInNode(EvalContext *ctx, char *rawname, xmlNodePtr docnode, const Attributes *a,
                                   const Promise *pp, EditContext *edcontext, PromiseResult *result)
 {
     xmlAttrPtr attr = NULL;
@@ -1267,7 +1259,7 @@ static bool DeleteAttributeInNode(EvalContext *ctx, char *rawname, xmlNodePtr do
     {
         cfPS(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_INTERRUPTED, pp, a,
              "Name of attribute to be deleted '%s', at XPath '%s' in XML document '%s', was NOT successfully loaded into an XML buffer",
-             rawname, a.xml.select_xpath, edcontext->filename);
+             rawname, a->xml.select_xpath, edcontext->filename);
         *result = PromiseResultUpdate(*result, PROMISE_RESULT_INTERRUPTED);
         return false;
     }
@@ -1277,28 +1269,28 @@ static bool DeleteAttributeInNode(EvalContext *ctx, char *rawname, xmlNodePtr do
     {
         cfPS(ctx, LOG_LEVEL_VERBOSE, PROMISE_RESULT_NOOP, pp, a,
              "The promised attribute to be deleted '%s', does NOT exist, at XPath '%s' in XML document '%s' (promise kept)",
-             rawname, a.xml.select_xpath, edcontext->filename);
+             rawname, a->xml.select_xpath, edcontext->filename);
         return false;
     }
 
-    if (a.transaction.action == cfa_warn)
+    if (a->transaction.action == cfa_warn)
     {
         cfPS(ctx, LOG_LEVEL_WARNING, PROMISE_RESULT_WARN, pp, a,
              "Need to delete the promised attribute '%s', at XPath '%s' in XML document '%s' - but only a warning was promised",
-             rawname, a.xml.select_xpath, edcontext->filename);
+             rawname, a->xml.select_xpath, edcontext->filename);
         *result = PromiseResultUpdate(*result, PROMISE_RESULT_WARN);
         return true;
     }
 
     //delete attribute from docnode
     cfPS(ctx, LOG_LEVEL_VERBOSE, PROMISE_RESULT_CHANGE, pp, a, "Deleting attribute '%s', at XPath '%s' in XML document '%s'",
-             rawname, a.xml.select_xpath, edcontext->filename);
+             rawname, a->xml.select_xpath, edcontext->filename);
     *result = PromiseResultUpdate(*result, PROMISE_RESULT_CHANGE);
     if ((xmlRemoveProp(attr)) == -1)
     {
         cfPS(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_INTERRUPTED, pp, a,
              "The promised attribute to be deleted '%s', was NOT deleted successfully, at XPath '%s' in XML document '%s'.",
-             rawname, a.xml.select_xpath, edcontext->filename);
+             rawname, a->xml.select_xpath, edcontext->filename);
         *result = PromiseResultUpdate(*result, PROMISE_RESULT_INTERRUPTED);
         return false;
     }
@@ -1308,7 +1300,7 @@ static bool DeleteAttributeInNode(EvalContext *ctx, char *rawname, xmlNodePtr do
     {
         cfPS(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_INTERRUPTED, pp, a,
              "The promised attribute to be deleted '%s', was NOT deleted successfully, at XPath '%s' in XML document '%s'",
-             rawname, a.xml.select_xpath, edcontext->filename);
+             rawname, a->xml.select_xpath, edcontext->filename);
         *result = PromiseResultUpdate(*result, PROMISE_RESULT_INTERRUPTED);
         return false;
     }
@@ -1318,7 +1310,7 @@ static bool DeleteAttributeInNode(EvalContext *ctx, char *rawname, xmlNodePtr do
 
 /***************************************************************************/
 
-static bool SetAttributeInNode(EvalContext *ctx, char *rawname, char *rawvalue, xmlNodePtr docnode, Attributes a,
+static bool SetAttributeInNode(EvalContext *ctx, char *rawname, char *rawvalue, xmlNodePtr docnode, const Attributes *a,
                                const Promise *pp, EditContext *edcontext, PromiseResult *result)
 {
     xmlAttrPtr attr = NULL;
@@ -1329,7 +1321,7 @@ static bool SetAttributeInNode(EvalContext *ctx, char *rawname, char *rawvalue,
     {
         cfPS(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_INTERRUPTED, pp, a,
              "Name of attribute to be set '%s', at XPath '%s' in XML document '%s', was NOT successfully loaded into an XML buffer",
-             rawname, a.xml.select_xpath, edcontext->filename);
+             rawname, a->xml.select_xpath, edcontext->filename);
         *result = PromiseResultUpdate(*result, PROMISE_RESULT_INTERRUPTED);
         return false;
     }
@@ -1338,7 +1330,7 @@ static bool SetAttributeInNode(EvalContext *ctx, char *rawname, char *rawvalue,
     {
         cfPS(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_INTERRUPTED, pp, a,
              "Value of attribute to be set '%s', at XPath '%s' in XML document '%s', was NOT successfully loaded into an XML buffer",
-             rawvalue, a.xml.select_xpath, edcontext->filename);
+             rawvalue, a->xml.select_xpath, edcontext->filename);
         *result = PromiseResultUpdate(*result, PROMISE_RESULT_INTERRUPTED);
         return false;
     }
@@ -1348,28 +1340,28 @@ static bool SetAttributeInNode(EvalContext *ctx, char *rawname, char *rawvalue,
     {
         cfPS(ctx, LOG_LEVEL_VERBOSE, PROMISE_RESULT_NOOP, pp, a,
              "The promised attribute to be set, with name '%s' and value '%s', already exists, at XPath '%s' in XML document '%s' (promise kept)",
-             rawname, rawvalue, a.xml.select_xpath, edcontext->filename);
+             rawname, rawvalue, a->xml.select_xpath, edcontext->filename);
         return false;
     }
 
-    if (a.transaction.action == cfa_warn)
+    if (a->transaction.action == cfa_warn)
     {
         cfPS(ctx, LOG_LEVEL_WARNING, PROMISE_RESULT_WARN, pp, a,
              "Need to set the promised attribute, with name '%s' and value '%s', at XPath '%s' in XML document '%s' - but only a warning was promised",
-             rawname, rawvalue, a.xml.select_xpath, edcontext->filename);
+             rawname, rawvalue, a->xml.select_xpath, edcontext->filename);
         *result = PromiseResultUpdate(*result, PROMISE_RESULT_WARN);
         return true;
     }
 
     //set attribute in docnode
     cfPS(ctx, LOG_LEVEL_VERBOSE, PROMISE_RESULT_CHANGE, pp, a, "Setting attribute with name '%s' and value '%s', at XPath '%s' in XML document '%s'",
-         rawname, rawvalue, a.xml.select_xpath, edcontext->filename);
+         rawname, rawvalue, a->xml.select_xpath, edcontext->filename);
     *result = PromiseResultUpdate(*result, PROMISE_RESULT_CHANGE);
     if ((attr = xmlSetProp(docnode, name, value)) == NULL)
     {
         cfPS(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_INTERRUPTED, pp, a,
              "The promised attribute to be set, with name '%s' and value '%s', was NOT successfully set, at XPath '%s' in XML document '%s'",
-             rawname, rawvalue, a.xml.select_xpath, edcontext->filename);
+             rawname, rawvalue, a->xml.select_xpath, edcontext->filename);
         *result = PromiseResultUpdate(*result, PROMISE_RESULT_INTERRUPTED);
         return false;
     }
@@ -1379,7 +1371,7 @@ static bool SetAttributeInNode(EvalContext *ctx, char *rawname, char *rawvalue,
     {
         cfPS(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_INTERRUPTED, pp, a,
              "The promised attribute to be set, with name '%s' and value '%s', was NOT successfully set, at XPath '%s' in XML document '%s'",
-             rawname, rawvalue, a.xml.select_xpath, edcontext->filename);
+             rawname, rawvalue, a->xml.select_xpath, edcontext->filename);
         *result = PromiseResultUpdate(*result, PROMISE_RESULT_INTERRUPTED);
         return false;
     }
@@ -1389,7 +1381,7 @@ static bool SetAttributeInNode(EvalContext *ctx, char *rawname, char *rawvalue,
 
 /***************************************************************************/
 
-static bool DeleteTextInNode(EvalContext *ctx, char *rawtext, xmlDocPtr doc, xmlNodePtr docnode, Attributes a,
+static bool DeleteTextInNode(EvalContext *ctx, char *rawtext, xmlDocPtr doc, xmlNodePtr docnode, const Attributes *a,
                              const Promise *pp, EditContext *edcontext, PromiseResult *result)
 {
     xmlNodePtr elemnode, copynode;
@@ -1399,7 +1391,7 @@ static bool DeleteTextInNode(EvalContext *ctx, char *rawtext, xmlDocPtr doc, xml
     {
         cfPS(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_INTERRUPTED, pp, a,
              "Text to be deleted '%s' at XPath '%s' in XML document '%s', was NOT successfully loaded into an XML buffer",
-             rawtext, a.xml.select_xpath, edcontext->filename);
+             rawtext, a->xml.select_xpath, edcontext->filename);
         *result = PromiseResultUpdate(*result, PROMISE_RESULT_INTERRUPTED);
         return false;
     }
@@ -1409,22 +1401,22 @@ static bool DeleteTextInNode(EvalContext *ctx, char *rawtext, xmlDocPtr doc, xml
     {
         cfPS(ctx, LOG_LEVEL_VERBOSE, PROMISE_RESULT_NOOP, pp, a,
              "The promised text to be deleted '%s' does NOT exist, at XPath '%s' in XML document '%s' (promise kept)",
-             rawtext, a.xml.select_xpath, edcontext->filename);
+             rawtext, a->xml.select_xpath, edcontext->filename);
         return false;
     }
 
-    if (a.transaction.action == cfa_warn)
+    if (a->transaction.action == cfa_warn)
     {
         cfPS(ctx, LOG_LEVEL_WARNING, PROMISE_RESULT_WARN, pp, a,
              "Need to delete the promised text '%s' at XPath '%s' in XML document '%s' - but only a warning was promised",
-             rawtext, a.xml.select_xpath, edcontext->filename);
+             rawtext, a->xml.select_xpath, edcontext->filename);
         *result = PromiseResultUpdate(*result, PROMISE_RESULT_WARN);
         return true;
     }
 
     //delete text from docnode
     cfPS(ctx, LOG_LEVEL_VERBOSE, PROMISE_RESULT_CHANGE, pp, a, "Deleting text '%s' at XPath '%s' in XML document '%s'",
-         rawtext, a.xml.select_xpath, edcontext->filename);
+         rawtext, a->xml.select_xpath, edcontext->filename);
     *result = PromiseResultUpdate(*result, PROMISE_RESULT_CHANGE);
 
     //node contains text
@@ -1450,7 +1442,7 @@ static bool DeleteTextInNode(EvalContext *ctx, char *rawtext, xmlDocPtr doc, xml
     {
         cfPS(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_INTERRUPTED, pp, a,
              "The promised text '%s' was NOT deleted successfully, at XPath '%s' in XML document '%s'",
-             rawtext, a.xml.select_xpath, edcontext->filename);
+             rawtext, a->xml.select_xpath, edcontext->filename);
         *result = PromiseResultUpdate(*result, PROMISE_RESULT_INTERRUPTED);
         return false;
     }
@@ -1460,7 +1452,7 @@ static bool DeleteTextInNode(EvalContext *ctx, char *rawtext, xmlDocPtr doc, xml
 
 /***************************************************************************/
 
-static bool SetTextInNode(EvalContext *ctx, char *rawtext, xmlDocPtr doc, xmlNodePtr docnode, Attributes a,
+static bool SetTextInNode(EvalContext *ctx, char *rawtext, xmlDocPtr doc, xmlNodePtr docnode, const Attributes *a,
                           const Promise *pp, EditContext *edcontext, PromiseResult *result)
 {
     xmlNodePtr elemnode, copynode;
@@ -1470,7 +1462,7 @@ static bool SetTextInNode(EvalContext *ctx, char *rawtext, xmlDocPtr doc, xmlNod
     {
         cfPS(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_INTERRUPTED, pp, a,
              "Text to be set '%s' at XPath '%s' in XML document '%s', was NOT successfully loaded into an XML buffer",
-             rawtext, a.xml.select_xpath, edcontext->filename);
+             rawtext, a->xml.select_xpath, edcontext->filename);
         *result = PromiseResultUpdate(*result, PROMISE_RESULT_INTERRUPTED);
         return false;
     }
@@ -1480,22 +1472,22 @@ static bool SetTextInNode(EvalContext *ctx, char *rawtext, xmlDocPtr doc, xmlNod
     {
         cfPS(ctx, LOG_LEVEL_VERBOSE, PROMISE_RESULT_NOOP, pp, a,
              "The promised text to be set '%s' already exists, at XPath '%s' in XML document '%s' (promise kept)",
-             rawtext, a.xml.select_xpath, edcontext->filename);
+             rawtext, a->xml.select_xpath, edcontext->filename);
         return false;
     }
 
-    if (a.transaction.action == cfa_warn)
+    if (a->transaction.action == cfa_warn)
     {
         cfPS(ctx, LOG_LEVEL_WARNING, PROMISE_RESULT_WARN, pp, a,
              "Need to set the promised text '%s' at XPath '%s' in XML document '%s' - but only a warning was promised",
-             rawtext, a.xml.select_xpath, edcontext->filename);
+             rawtext, a->xml.select_xpath, edcontext->filename);
         *result = PromiseResultUpdate(*result, PROMISE_RESULT_WARN);
         return true;
     }
 
     //set text in docnode
     cfPS(ctx, LOG_LEVEL_VERBOSE, PROMISE_RESULT_CHANGE, pp, a, "Setting text '%s' at XPath '%s' in XML document '%s'",
-         rawtext, a.xml.select_xpath, edcontext->filename);
+         rawtext, a->xml.select_xpath, edcontext->filename);
     *result = PromiseResultUpdate(*result, PROMISE_RESULT_CHANGE);
 
     //node already contains text
@@ -1521,7 +1513,7 @@ static bool SetTextInNode(EvalContext *ctx, char *rawtext, xmlDocPtr doc, xmlNod
     {
         cfPS(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_INTERRUPTED, pp, a,
              "The promised text '%s' was NOT set successfully, at XPath '%s' in XML document '%s'",
-             rawtext, a.xml.select_xpath, edcontext->filename);
+             rawtext, a->xml.select_xpath, edcontext->filename);
         *result = PromiseResultUpdate(*result, PROMISE_RESULT_INTERRUPTED);
         return false;
     }
@@ -1531,7 +1523,7 @@ static bool SetTextInNode(EvalContext *ctx, char *rawtext, xmlDocPtr doc, xmlNod
 
 /***************************************************************************/
 
-static bool InsertTextInNode(EvalContext *ctx, char *rawtext, xmlDocPtr doc, xmlNodePtr docnode, Attributes a,
+static bool InsertTextInNode(EvalContext *ctx, char *rawtext, xmlDocPtr doc, xmlNodePtr docnode, const Attributes *a,
                              const Promise *pp, EditContext *edcontext, PromiseResult *result)
 {
     xmlNodePtr elemnode, copynode;
@@ -1541,7 +1533,7 @@ static bool InsertTextInNode(EvalContext *ctx, char *rawtext, xmlDocPtr doc, xml
     {
         cfPS(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_INTERRUPTED, pp, a,
              "Text to be inserted '%s' at XPath '%s' in XML document '%s', was NOT successfully loaded into an XML buffer",
-             rawtext, a.xml.select_xpath, edcontext->filename);
+             rawtext, a->xml.select_xpath, edcontext->filename);
         *result = PromiseResultUpdate(*result, PROMISE_RESULT_INTERRUPTED);
         return false;
     }
@@ -1551,22 +1543,22 @@ static bool InsertTextInNode(EvalContext *ctx, char *rawtext, xmlDocPtr doc, xml
     {
         cfPS(ctx, LOG_LEVEL_VERBOSE, PROMISE_RESULT_NOOP, pp, a,
              "The promised text to be inserted '%s' already exists, at XPath '%s' in XML document '%s' (promise kept)",
-             rawtext, a.xml.select_xpath, edcontext->filename);
+             rawtext, a->xml.select_xpath, edcontext->filename);
         return false;
     }
 
-    if (a.transaction.action == cfa_warn)
+    if (a->transaction.action == cfa_warn)
     {
         cfPS(ctx, LOG_LEVEL_WARNING, PROMISE_RESULT_WARN, pp, a,
              "Need to insert the promised text '%s' at XPath '%s' in XML document '%s' - but only a warning was promised",
-             rawtext, a.xml.select_xpath, edcontext->filename);
+             rawtext, a->xml.select_xpath, edcontext->filename);
         *result = PromiseResultUpdate(*result, PROMISE_RESULT_WARN);
         return true;
     }
 
     //insert text into docnode
     cfPS(ctx, LOG_LEVEL_VERBOSE, PROMISE_RESULT_CHANGE, pp, a, "Inserting text '%s' at XPath '%s' in XML document '%s'",
-         rawtext, a.xml.select_xpath, edcontext->filename);
+         rawtext, a->xml.select_xpath, edcontext->filename);
     *result = PromiseResultUpdate(*result, PROMISE_RESULT_CHANGE);
 
     //node already contains text
@@ -1593,7 +1585,7 @@ static bool InsertTextInNode(EvalContext *ctx, char *rawtext, xmlDocPtr doc, xml
     {
         cfPS(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_INTERRUPTED, pp, a,
              "The promised text '%s' was NOT inserted successfully, at XPath '%s' in XML document '%s'",
-             rawtext, a.xml.select_xpath, edcontext->filename);
+             rawtext, a->xml.select_xpath, edcontext->filename);
         *result = PromiseResultUpdate(*result, PROMISE_RESULT_INTERRUPTED);
         return false;
     }
@@ -1603,26 +1595,26 @@ static bool InsertTextInNode(EvalContext *ctx, char *rawtext, xmlDocPtr doc, xml
 
 /***************************************************************************/
 
-static bool SanityCheckXPathBuild(EvalContext *ctx, Attributes a, const Promise *pp, PromiseResult *result)
+static bool SanityCheckXPathBuild(EvalContext *ctx, const Attributes *a, const Promise *pp, PromiseResult *result)
 {
     char rawxpath[CF_BUFSIZE] = { 0 };
 
-    if (a.xml.havebuildxpath)
+    if (a->xml.havebuildxpath)
     {
-        strcpy(rawxpath, a.xml.build_xpath);
+        strcpy(rawxpath, a->xml.build_xpath);
     }
     else
     {
         strcpy(rawxpath, pp->promiser);
     }
 
-    if ((strcmp("build_xpath", pp->parent_promise_type->name) == 0) && (a.xml.havebuildxpath))
+    if ((strcmp("build_xpath", pp->parent_promise_type->name) == 0) && (a->xml.havebuildxpath))
     {
         Log(LOG_LEVEL_ERR, "Attribute: build_xpath is not allowed within bundle: build_xpath");
         return false;
     }
 
-    if (a.xml.haveselectxpath && !a.xml.havebuildxpath)
+    if (a->xml.haveselectxpath && !a->xml.havebuildxpath)
     {
         Log(LOG_LEVEL_ERR, "XPath build does not require select_xpath to be specified");
         return false;
@@ -1638,16 +1630,16 @@ static bool SanityCheckXPathBuild(EvalContext *ctx, Attributes a, const Promise
 
 /***************************************************************************/
 
-static bool SanityCheckTreeDeletions(Attributes a)
+static bool SanityCheckTreeDeletions(const Attributes *a)
 {
-    if (!a.xml.haveselectxpath)
+    if (!a->xml.haveselectxpath)
     {
         Log(LOG_LEVEL_ERR,
               "Tree deletion requires select_xpath to be specified");
         return false;
     }
 
-    if (!XPathVerifyConvergence(a.xml.select_xpath))
+    if (!XPathVerifyConvergence(a->xml.select_xpath))
     {
         return false;
     }
@@ -1657,22 +1649,22 @@ static bool SanityCheckTreeDeletions(Attributes a)
 
 /***************************************************************************/
 
-static bool SanityCheckTreeInsertions(Attributes a, EditContext *edcontext)
+static bool SanityCheckTreeInsertions(const Attributes *a, EditContext *edcontext)
 {
-    if ((a.xml.haveselectxpath && !a.xml.havebuildxpath && !xmlDocGetRootElement(edcontext->xmldoc)))
+    if ((a->xml.haveselectxpath && !a->xml.havebuildxpath && !xmlDocGetRootElement(edcontext->xmldoc)))
     {
         Log(LOG_LEVEL_ERR,
               "Tree insertion into an empty file, using select_xpath, does not make sense");
         return false;
     }
-    else if ((!a.xml.haveselectxpath &&  a.xml.havebuildxpath))
+    else if ((!a->xml.haveselectxpath &&  a->xml.havebuildxpath))
     {
         Log(LOG_LEVEL_ERR,
               "Tree insertion requires select_xpath to be specified, unless inserting into an empty file");
         return false;
     }
 
-    if (a.xml.haveselectxpath && !XPathVerifyConvergence(a.xml.select_xpath))
+    if (a->xml.haveselectxpath && !XPathVerifyConvergence(a->xml.select_xpath))
     {
         return false;
     }
@@ -1682,15 +1674,15 @@ static bool SanityCheckTreeInsertions(Attributes a, EditContext *edcontext)
 
 /***************************************************************************/
 
-static bool SanityCheckAttributeDeletions(Attributes a)
+static bool SanityCheckAttributeDeletions(const Attributes *a)
 {
-    if (!(a.xml.haveselectxpath))
+    if (!(a->xml.haveselectxpath))
     {
         Log(LOG_LEVEL_ERR, "Attribute deletion requires select_xpath to be specified");
         return false;
     }
 
-    if (!XPathVerifyConvergence(a.xml.select_xpath))
+    if (!XPathVerifyConvergence(a->xml.select_xpath))
     {
         return false;
     }
@@ -1700,15 +1692,15 @@ static bool SanityCheckAttributeDeletions(Attributes a)
 
 /***************************************************************************/
 
-static bool SanityCheckAttributeSet(Attributes a)
+static bool SanityCheckAttributeSet(const Attributes *a)
 {
-    if (!(a.xml.haveselectxpath))
+    if (!(a->xml.haveselectxpath))
     {
         Log(LOG_LEVEL_ERR, "Attribute insertion requires select_xpath to be specified");
         return false;
     }
 
-    if (!XPathVerifyConvergence(a.xml.select_xpath))
+    if (!XPathVerifyConvergence(a->xml.select_xpath))
     {
         return false;
     }
@@ -1718,15 +1710,15 @@ static bool SanityCheckAttributeSet(Attributes a)
 
 /***************************************************************************/
 
-static bool SanityCheckTextDeletions(Attributes a)
+static bool SanityCheckTextDeletions(const Attributes *a)
 {
-    if (!(a.xml.haveselectxpath))
+    if (!(a->xml.haveselectxpath))
     {
         Log(LOG_LEVEL_ERR, "Tree insertion requires select_xpath to be specified");
         return false;
     }
 
-    if (!XPathVerifyConvergence(a.xml.select_xpath))
+    if (!XPathVerifyConvergence(a->xml.select_xpath))
     {
         return false;
     }
@@ -1736,15 +1728,15 @@ static bool SanityCheckTextDeletions(Attributes a)
 
 /***************************************************************************/
 
-static bool SanityCheckTextSet(Attributes a)
+static bool SanityCheckTextSet(const Attributes *a)
 {
-    if (!(a.xml.haveselectxpath))
+    if (!(a->xml.haveselectxpath))
     {
         Log(LOG_LEVEL_ERR, "Tree insertion requires select_xpath to be specified");
         return false;
     }
 
-    if (!XPathVerifyConvergence(a.xml.select_xpath))
+    if (!XPathVerifyConvergence(a->xml.select_xpath))
     {
         return false;
     }
@@ -1754,15 +1746,15 @@ static bool SanityCheckTextSet(Attributes a)
 
 /***************************************************************************/
 
-static bool SanityCheckTextInsertions(Attributes a)
+static bool SanityCheckTextInsertions(const Attributes *a)
 {
-    if (!(a.xml.haveselectxpath))
+    if (!(a->xml.haveselectxpath))
     {
         Log(LOG_LEVEL_ERR, "Tree insertion requires select_xpath to be specified");
         return false;
     }
 
-    if (!XPathVerifyConvergence(a.xml.select_xpath))
+    if (!XPathVerifyConvergence(a->xml.select_xpath))
     {
         return false;
     }
@@ -1845,7 +1837,7 @@ static bool XmlDocsEqualMem(xmlDocPtr doc1, xmlDocPtr doc2)
 
 /***************************************************************************/
 
-static bool XmlNodesCompare(const xmlNodePtr node1, const xmlNodePtr node2, Attributes a, const Promise *pp)
+static bool XmlNodesCompare(const xmlNodePtr node1, const xmlNodePtr node2, const Attributes *a, const Promise *pp)
 /* Does node1 contain all content(tag/attributes/text/nodes) found in node2? */
 {
     int compare = true;
@@ -1948,7 +1940,7 @@ static bool XmlNodesCompareAttributes(const xmlNodePtr node1, const xmlNodePtr n
 
 /*********************************************************************/
 
-static bool XmlNodesCompareNodes(const xmlNodePtr node1, const xmlNodePtr node2, Attributes a, const Promise *pp)
+static bool XmlNodesCompareNodes(const xmlNodePtr node1, const xmlNodePtr node2, const Attributes *a, const Promise *pp)
 /* Does node1 contain same nodes found in node2? */
 {
     if (!node1 && !node2)
@@ -2062,7 +2054,7 @@ static bool XmlNodesCompareText(xmlNodePtr node1, xmlNodePtr node2)
 
 /*********************************************************************/
 
-static bool XmlNodesSubset(const xmlNodePtr node1, const xmlNodePtr node2, Attributes a, const Promise *pp)
+static bool XmlNodesSubset(const xmlNodePtr node1, const xmlNodePtr node2, const Attributes *a, const Promise *pp)
 /* Does node1 contain matching subset of content(tag/attributes/text/nodes) found in node2? */
 {
     int subset = true;
@@ -2152,7 +2144,7 @@ static bool XmlNodesSubsetOfAttributes(const xmlNodePtr node1, const xmlNodePtr
 
 /*********************************************************************/
 
-static bool XmlNodesSubsetOfNodes(const xmlNodePtr node1, const xmlNodePtr node2, Attributes a, const Promise *pp)
+static bool XmlNodesSubsetOfNodes(const xmlNodePtr node1, const xmlNodePtr node2, const Attributes *a, const Promise *pp)
 /* Does node1 contain matching subset of nodes found in node2? */
 {
     if (!node1 && !node2)
@@ -2302,7 +2294,7 @@ bool XmlVerifyTextInNodeSubstring(const xmlChar *text, xmlNodePtr node)
 
 /*********************************************************************/
 
-static bool XmlVerifyNodeInNodeExact(const xmlNodePtr node1, const xmlNodePtr node2, Attributes a, const Promise *pp)
+static bool XmlVerifyNodeInNodeExact(const xmlNodePtr node1, const xmlNodePtr node2, const Attributes *a, const Promise *pp)
 /* Does node2 contain a node with content matching all content in node1?
    Returns a pointer to node found in node2 or NULL */
 {
@@ -2329,7 +2321,7 @@ static bool XmlVerifyNodeInNodeExact(const xmlNodePtr node1, const xmlNodePtr no
 
 /*********************************************************************/
 
-xmlNodePtr XmlVerifyNodeInNodeSubset(xmlNodePtr node1, xmlNodePtr node2, Attributes a, const Promise *pp)
+xmlNodePtr XmlVerifyNodeInNodeSubset(xmlNodePtr node1, xmlNodePtr node2, const Attributes *a, const Promise *pp)
 /* Does node2 contain: node with subset of content matching all content in node1?
    Returns a pointer to node found in node2 or NULL */
 {
@@ -2412,7 +2404,7 @@ static bool PredicateRemoveHead(char predicate[CF_BUFSIZE])
 
 /*********************************************************************/
 
-xmlNodePtr XPathHeadExtractNode(EvalContext *ctx, char xpath[CF_BUFSIZE], Attributes a, const Promise *pp, PromiseResult *result)
+xmlNodePtr XPathHeadExtractNode(EvalContext *ctx, char xpath[CF_BUFSIZE], const Attributes *a, const Promise *pp, PromiseResult *result)
 {
     xmlNodePtr node = NULL;
     char head[CF_BUFSIZE] = {0}, *tok = NULL;
@@ -2441,7 +2433,7 @@ xmlNodePtr XPathHeadExtractNode(EvalContext *ctx, char xpath[CF_BUFSIZE], Attrib
 
 /*********************************************************************/
 
-xmlNodePtr XPathTailExtractNode(EvalContext *ctx, char xpath[CF_BUFSIZE], Attributes a, const Promise *pp, PromiseResult *result)
+xmlNodePtr XPathTailExtractNode(EvalContext *ctx, char xpath[CF_BUFSIZE], const Attributes *a, const Promise *pp, PromiseResult *result)
 {
     xmlNodePtr node = NULL;
     char copyxpath[CF_BUFSIZE] = {0}, tail[CF_BUFSIZE] = {0}, *tok = NULL;
@@ -2691,7 +2683,7 @@ static bool XPathHeadContainsPredicate(char *head)
 
 /*********************************************************************/
 
-static bool XPathVerifyBuildSyntax(EvalContext *ctx, const char* xpath, Attributes a, const Promise *pp, PromiseResult *result)
+static bool XPathVerifyBuildSyntax(EvalContext *ctx, const char* xpath, const Attributes *a, const Promise *pp, PromiseResult *result)
 /*verify that XPath does not specify position wrt sibling-axis (such as):[#] [last()] [position()] following-sibling:: preceding-sibling:: */
 {
     char regexp[CF_BUFSIZE] = {'\0'};
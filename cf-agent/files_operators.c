@@ -50,7 +50,7 @@
 #include <buffer.h>
 
 
-int MoveObstruction(EvalContext *ctx, char *from, Attributes attr, const Promise *pp, PromiseResult *result)
+int MoveObstruction(EvalContext *ctx, char *from, const Attributes *attr, const Promise *pp, PromiseResult *result)
 {
     struct stat sb;
     char stamp[CF_BUFSIZE], saved[CF_BUFSIZE];
@@ -58,7 +58,7 @@ int MoveObstruction(EvalContext *ctx, char *from, Attributes attr, const Promise
 
     if (lstat(from, &sb) == 0)
     {
-        if (!attr.move_obstructions)
+        if (!attr->move_obstructions)
         {
             cfPS(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_FAIL, pp, attr, "Object '%s' exists and is obstructing our promise", from);
             *result = PromiseResultUpdate(*result, PROMISE_RESULT_FAIL);
@@ -75,7 +75,7 @@ int MoveObstruction(EvalContext *ctx, char *from, Attributes attr, const Promise
             saved[0] = '\0';
             strlcpy(saved, from, sizeof(saved));
 
-            if (attr.copy.backup == BACKUP_OPTION_TIMESTAMP || attr.edits.backup == BACKUP_OPTION_TIMESTAMP)
+            if (attr->copy.backup == BACKUP_OPTION_TIMESTAMP || attr->edits.backup == BACKUP_OPTION_TIMESTAMP)
             {
                 snprintf(stamp, CF_BUFSIZE, "_%jd_%s", (intmax_t) CFSTARTTIME, CanonifyName(ctime(&now_stamp)));
                 strlcat(saved, stamp, sizeof(saved));
@@ -143,7 +143,7 @@ int MoveObstruction(EvalContext *ctx, char *from, Attributes attr, const Promise
 
 /*********************************************************************/
 
-bool SaveAsFile(SaveCallbackFn callback, void *param, const char *file, Attributes a, NewLineMode new_line_mode)
+bool SaveAsFile(SaveCallbackFn callback, void *param, const char *file, const Attributes *a, NewLineMode new_line_mode)
 {
     struct stat statbuf;
     char new[CF_BUFSIZE], backup[CF_BUFSIZE];
@@ -203,7 +203,7 @@ bool SaveAsFile(SaveCallbackFn callback, void *param, const char *file, Attribut
 
     strcpy(backup, BufferData(deref_file));
 
-    if (a.edits.backup == BACKUP_OPTION_TIMESTAMP)
+    if (a->edits.backup == BACKUP_OPTION_TIMESTAMP)
     {
         snprintf(stamp, CF_BUFSIZE, "_%jd_%s", (intmax_t) CFSTARTTIME, CanonifyName(ctime(&stamp_now)));
         strcat(backup, stamp);
@@ -251,13 +251,13 @@ bool SaveAsFile(SaveCallbackFn callback, void *param, const char *file, Attribut
         }
     }
 
-    if (a.edits.backup == BACKUP_OPTION_ROTATE)
+    if (a->edits.backup == BACKUP_OPTION_ROTATE)
     {
-        RotateFiles(backup, a.edits.rotate);
+        RotateFiles(backup, a->edits.rotate);
         unlink(backup);
     }
 
-    if (a.edits.backup != BACKUP_OPTION_NO_BACKUP)
+    if (a->edits.backup != BACKUP_OPTION_NO_BACKUP)
     {
         if (ArchiveToRepository(backup, a))
         {
@@ -323,7 +323,7 @@ static bool SaveItemListCallback(const char *dest_filename, void *param, NewLine
 
 /*********************************************************************/
 
-bool SaveItemListAsFile(Item *liststart, const char *file, Attributes a, NewLineMode new_line_mode)
+bool SaveItemListAsFile(Item *liststart, const char *file, const Attributes *a, NewLineMode new_line_mode)
 {
     return SaveAsFile(&SaveItemListCallback, liststart, file, a, new_line_mode);
 }
@@ -343,7 +343,7 @@ static Item *NextItem(const Item *ip)
 }
 
 static int ItemListsEqual(EvalContext *ctx, const Item *list1, const Item *list2, int warnings,
-                          Attributes a, const Promise *pp, PromiseResult *result)
+                          const Attributes *a, const Promise *pp, PromiseResult *result)
 {
     int retval = true;
 
@@ -423,7 +423,7 @@ static int ItemListsEqual(EvalContext *ctx, const Item *list1, const Item *list2
 
 /* returns true if file on disk is identical to file in memory */
 
-int CompareToFile(EvalContext *ctx, const Item *liststart, const char *file, Attributes a, const Promise *pp,
+int CompareToFile(EvalContext *ctx, const Item *liststart, const char *file, const Attributes *a, const Promise *pp,
                   PromiseResult *result)
 {
     struct stat statbuf;
@@ -444,12 +444,12 @@ int CompareToFile(EvalContext *ctx, const Item *liststart, const char *file, Att
         return false;
     }
 
-    if (!LoadFileAsItemList(&cmplist, file, a.edits))
+    if (!LoadFileAsItemList(&cmplist, file, a->edits))
     {
         return false;
     }
 
-    if (!ItemListsEqual(ctx, cmplist, liststart, (a.transaction.action == cfa_warn), a, pp, result))
+    if (!ItemListsEqual(ctx, cmplist, liststart, (a->transaction.action == cfa_warn), a, pp, result))
     {
         DeleteItemList(cmplist);
         return false;
@@ -28,10 +28,10 @@
 void SetRepositoryLocation(const char *path);
 void SetRepositoryChar(char c);
 
-int ArchiveToRepository(char *file, Attributes attr);
+int ArchiveToRepository(char *file, const Attributes *attr);
 bool FileInRepository(const char *filename);
 
 /* Returns false if backing up files to repository is not set up */
-bool GetRepositoryPath(const char *file, Attributes attr, char *destination);
+bool GetRepositoryPath(const char *file, const Attributes *attr, char *destination);
 
 #endif
@@ -347,7 +347,7 @@ void DeleteMountInfo(Seq *list)
 
 /*******************************************************************/
 
-int VerifyInFstab(EvalContext *ctx, char *name, Attributes a, const Promise *pp, PromiseResult *result)
+int VerifyInFstab(EvalContext *ctx, char *name, const Attributes *a, const Promise *pp, PromiseResult *result)
 /* Ensure filesystem IS in fstab, and return no of changes */
 {
     char fstab[CF_BUFSIZE];
@@ -355,7 +355,7 @@ int VerifyInFstab(EvalContext *ctx, char *name, Attributes a, const Promise *pp,
 
     if (!FSTABLIST)
     {
-        if (!LoadFileAsItemList(&FSTABLIST, VFSTAB[VSYSTEMHARDCLASS], a.edits))
+        if (!LoadFileAsItemList(&FSTABLIST, VFSTAB[VSYSTEMHARDCLASS], a->edits))
         {
             Log(LOG_LEVEL_ERR, "Couldn't open '%s'", VFSTAB[VSYSTEMHARDCLASS]);
             return false;
@@ -366,19 +366,19 @@ int VerifyInFstab(EvalContext *ctx, char *name, Attributes a, const Promise *pp,
         }
     }
 
-    if (a.mount.mount_options)
+    if (a->mount.mount_options)
     {
-        opts = Rlist2String(a.mount.mount_options, ",");
+        opts = Rlist2String(a->mount.mount_options, ",");
     }
     else
     {
         opts = xstrdup(VMOUNTOPTS[VSYSTEMHARDCLASS]);
     }
 
-    host = a.mount.mount_server;
-    rmountpt = a.mount.mount_source;
+    host = a->mount.mount_server;
+    rmountpt = a->mount.mount_source;
     mountpt = name;
-    fstype = a.mount.mount_type;
+    fstype = a->mount.mount_type;
 
 #if defined(__QNX__) || defined(__QNXNTO__)
     snprintf(fstab, CF_BUFSIZE, "%s:%s \t %s %s\t%s 0 0", host, rmountpt, mountpt, fstype, opts);
@@ -422,7 +422,7 @@ int VerifyInFstab(EvalContext *ctx, char *name, Attributes a, const Promise *pp,
 
 /*******************************************************************/
 
-int VerifyNotInFstab(EvalContext *ctx, char *name, Attributes a, const Promise *pp, PromiseResult *result)
+int VerifyNotInFstab(EvalContext *ctx, char *name, const Attributes *a, const Promise *pp, PromiseResult *result)
 /* Ensure filesystem is NOT in fstab, and return no of changes */
 {
     char regex[CF_BUFSIZE];
@@ -431,7 +431,7 @@ int VerifyNotInFstab(EvalContext *ctx, char *name, Attributes a, const Promise *
 
     if (!FSTABLIST)
     {
-        if (!LoadFileAsItemList(&FSTABLIST, VFSTAB[VSYSTEMHARDCLASS], a.edits))
+        if (!LoadFileAsItemList(&FSTABLIST, VFSTAB[VSYSTEMHARDCLASS], a->edits))
         {
             Log(LOG_LEVEL_ERR, "Couldn't open '%s'", VFSTAB[VSYSTEMHARDCLASS]);
             return false;
@@ -442,21 +442,21 @@ int VerifyNotInFstab(EvalContext *ctx, char *name, Attributes a, const Promise *
         }
     }
 
-    if (a.mount.mount_options)
+    if (a->mount.mount_options)
     {
-        opts = Rlist2String(a.mount.mount_options, ",");
+        opts = Rlist2String(a->mount.mount_options, ",");
     }
     else
     {
         opts = xstrdup(VMOUNTOPTS[VSYSTEMHARDCLASS]);
     }
 
-    host = a.mount.mount_server;
+    host = a->mount.mount_server;
     mountpt = name;
 
     if (MatchFSInFstab(mountpt))
     {
-        if (a.mount.editfstab)
+        if (a->mount.editfstab)
         {
 #if defined(_AIX)
             FILE *pfp;
@@ -533,7 +533,7 @@ int VerifyNotInFstab(EvalContext *ctx, char *name, Attributes a, const Promise *
         }
     }
 
-    if (a.mount.mount_options)
+    if (a->mount.mount_options)
     {
         free(opts);
     }
@@ -543,20 +543,20 @@ int VerifyNotInFstab(EvalContext *ctx, char *name, Attributes a, const Promise *
 
 /*******************************************************************/
 
-PromiseResult VerifyMount(EvalContext *ctx, char *name, Attributes a, const Promise *pp)
+PromiseResult VerifyMount(EvalContext *ctx, char *name, const Attributes *a, const Promise *pp)
 {
     char comm[CF_BUFSIZE];
     FILE *pfp;
     char *host, *rmountpt, *mountpt, *opts=NULL;
 
-    host = a.mount.mount_server;
-    rmountpt = a.mount.mount_source;
+    host = a->mount.mount_server;
+    rmountpt = a->mount.mount_source;
     mountpt = name;
 
     /* Check for options required for this mount - i.e., -o ro,rsize, etc. */
-    if (a.mount.mount_options)
+    if (a->mount.mount_options)
     {
-        opts = Rlist2String(a.mount.mount_options, ",");
+        opts = Rlist2String(a->mount.mount_options, ",");
     }
     else
     {
@@ -613,7 +613,7 @@ PromiseResult VerifyMount(EvalContext *ctx, char *name, Attributes a, const Prom
 
 /*******************************************************************/
 
-PromiseResult VerifyUnmount(EvalContext *ctx, char *name, Attributes a, const Promise *pp)
+PromiseResult VerifyUnmount(EvalContext *ctx, char *name, const Attributes *a, const Promise *pp)
 {
     char comm[CF_BUFSIZE];
     FILE *pfp;
@@ -31,6 +31,7 @@
 #include <cf3.defs.h>
 
 #include <actuator.h>
+#include <eval_context.h>
 #include <policy.h>
 #include <matching.h>
 #include <match_scope.h>
@@ -64,6 +65,8 @@ PromiseResult LocateFilePromiserGroup(EvalContext *ctx, char *wildpath, const Pr
     else
     {
         Log(LOG_LEVEL_VERBOSE, "Using regex pathtype for '%s' (see pathtype)", wildpath);
+        /* The files matching change without any variable changing. */
+        EvalContextPromiseReadsExternalState(ctx);
     }
 
     pbuffer[0] = '\0';
@@ -28,19 +28,19 @@
 #include <actuator.h>
 #include <rlist.h>
 
-int VerifyCommandRetcode(EvalContext *ctx, int retcode, Attributes a, const Promise *pp, PromiseResult *result)
+int VerifyCommandRetcode(EvalContext *ctx, int retcode, const Attributes *a, const Promise *pp, PromiseResult *result)
 {
     bool result_retcode = true;
 
-    if (a.classes.retcode_kept ||
-        a.classes.retcode_repaired ||
-        a.classes.retcode_failed)
+    if (a->classes.retcode_kept ||
+        a->classes.retcode_repaired ||
+        a->classes.retcode_failed)
     {
         int matched = false;
         char retcodeStr[PRINTSIZE(retcode)];
         xsnprintf(retcodeStr, sizeof(retcodeStr), "%d", retcode);
 
-        if (RlistKeyIn(a.classes.retcode_kept, retcodeStr))
+        if (RlistKeyIn(a->classes.retcode_kept, retcodeStr))
         {
             cfPS(ctx, LOG_LEVEL_INFO, PROMISE_RESULT_NOOP, pp, a,
                  "Command related to promiser '%s' returned code defined as promise kept %d", pp->promiser,
@@ -48,7 +48,7 @@ int VerifyCommandRetcode(EvalContext *ctx, int retcode, Attributes a, const Prom
             matched = true;
         }
 
-        if (RlistKeyIn(a.classes.retcode_repaired, retcodeStr))
+        if (RlistKeyIn(a->classes.retcode_repaired, retcodeStr))
         {
             cfPS(ctx, LOG_LEVEL_INFO, PROMISE_RESULT_CHANGE, pp, a,
                  "Command related to promiser '%s' returned code defined as promise repaired %d", pp->promiser,
@@ -57,7 +57,7 @@ int VerifyCommandRetcode(EvalContext *ctx, int retcode, Attributes a, const Prom
             matched = true;
         }
 
-        if (RlistKeyIn(a.classes.retcode_failed, retcodeStr))
+        if (RlistKeyIn(a->classes.retcode_failed, retcodeStr))
         {
             cfPS(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_FAIL, pp, a,
                  "Command related to promiser '%s' returned code defined as promise failed %d", pp->promiser,
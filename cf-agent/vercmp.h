@@ -40,7 +40,7 @@ typedef enum
  *  a.packages.package_commands_useshell
  *  cfPS
  */
-VersionCmpResult CompareVersions(EvalContext *ctx, const char *v1, const char *v2, Attributes a, const Promise *pp, PromiseResult *result);
+VersionCmpResult CompareVersions(EvalContext *ctx, const char *v1, const char *v2, const Attributes *a, const Promise *pp, PromiseResult *result);
 
 const char* PackageVersionComparatorToString(const PackageVersionComparator pvc);
 
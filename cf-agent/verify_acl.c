@@ -48,29 +48,32 @@ static int CheckPermTypeSyntax(char *permt, int deny_support, const Promise *pp)
 static int CheckAclDefault(const char *path, Acl *acl, const Promise *pp);
 
 
-PromiseResult VerifyACL(EvalContext *ctx, const char *file, Attributes a, const Promise *pp)
+PromiseResult VerifyACL(EvalContext *ctx, const char *file, const Attributes *org_a, const Promise *pp)
 {
-    if (!CheckACLSyntax(file, a.acl, pp))
+    Attributes a_copy = *org_a; /* modified below */
+    Attributes *a = &a_copy;
+
+    if (!CheckACLSyntax(file, a->acl, pp))
     {
         cfPS(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_INTERRUPTED, pp, a, "Syntax error in access control list for '%s'", file);
         PromiseRef(LOG_LEVEL_ERR, pp);
         return PROMISE_RESULT_INTERRUPTED;
     }
 
-    SetACLDefaults(file, &a.acl);
+    SetACLDefaults(file, &a->acl);
 
     PromiseResult result = PROMISE_RESULT_NOOP;
 
 // decide which ACL API to use
-    switch (a.acl.acl_type)
+    switch (a->acl.acl_type)
     {
     case ACL_TYPE_NONE: // fallthrough: acl_type defaults to generic
     case ACL_TYPE_GENERIC:
 
 #if defined(__linux__)
-        result = PromiseResultUpdate(result, CheckPosixLinuxACL(ctx, file, a.acl, a, pp));
+        result = PromiseResultUpdate(result, CheckPosixLinuxACL(ctx, file, a->acl, a, pp));
 #elif defined(__MINGW32__)
-        result = PromiseResultUpdate(result, Nova_CheckNtACL(ctx, file, a.acl, a, pp));
+        result = PromiseResultUpdate(result, Nova_CheckNtACL(ctx, file, a->acl, a, pp));
 #else
         Log(LOG_LEVEL_INFO, "ACLs are not yet supported on this system.");
 #endif
@@ -79,7 +82,7 @@ PromiseResult VerifyACL(EvalContext *ctx, const char *file, Attributes a, const
     case ACL_TYPE_POSIX:
 
 #if defined(__linux__)
-        result = PromiseResultUpdate(result, CheckPosixLinuxACL(ctx, file, a.acl, a, pp));
+        result = PromiseResultUpdate(result, CheckPosixLinuxACL(ctx, file, a->acl, a, pp));
 #else
         Log(LOG_LEVEL_INFO, "Posix ACLs are not supported on this system");
 #endif
@@ -87,7 +90,7 @@ PromiseResult VerifyACL(EvalContext *ctx, const char *file, Attributes a, const
 
     case ACL_TYPE_NTFS_:
 #ifdef __MINGW32__
-        result = PromiseResultUpdate(result, Nova_CheckNtACL(ctx, file, a.acl, a, pp));
+        result = PromiseResultUpdate(result, Nova_CheckNtACL(ctx, file, a->acl, a, pp));
 #else
         Log(LOG_LEVEL_INFO, "NTFS ACLs are not supported on this system");
 #endif
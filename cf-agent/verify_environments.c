@@ -74,20 +74,20 @@ char *CF_SUSPENDED[CF_MAX_CONCURRENT_ENVIRONMENTS];
 
 /*****************************************************************************/
 
-static int EnvironmentsSanityChecks(Attributes a, const Promise *pp);
-static PromiseResult VerifyEnvironments(EvalContext *ctx, Attributes a, const Promise *pp);
-static PromiseResult VerifyVirtDomain(EvalContext *ctx, char *uri, enum cfhypervisors envtype, Attributes a, const Promise *pp);
-static PromiseResult VerifyVirtNetwork(EvalContext *ctx, char *uri, enum cfhypervisors envtype, Attributes a, const Promise *pp);
-static PromiseResult CreateVirtDom(EvalContext *ctx, virConnectPtr vc, Attributes a, const Promise *pp);
-static PromiseResult DeleteVirt(EvalContext *ctx, virConnectPtr vc, Attributes a, const Promise *pp);
-static PromiseResult RunningVirt(EvalContext *ctx, virConnectPtr vc, Attributes a, const Promise *pp);
-static PromiseResult SuspendedVirt(EvalContext *ctx, virConnectPtr vc, Attributes a, const Promise *pp);
-static PromiseResult DownVirt(EvalContext *ctx, virConnectPtr vc, Attributes a, const Promise *pp);
+static int EnvironmentsSanityChecks(const Attributes *a, const Promise *pp);
+static PromiseResult VerifyEnvironments(EvalContext *ctx, const Attributes *a, const Promise *pp);
+static PromiseResult VerifyVirtDomain(EvalContext *ctx, char *uri, enum cfhypervisors envtype, const Attributes *a, const Promise *pp);
+static PromiseResult VerifyVirtNetwork(EvalContext *ctx, char *uri, enum cfhypervisors envtype, const Attributes *a, const Promise *pp);
+static PromiseResult CreateVirtDom(EvalContext *ctx, virConnectPtr vc, const Attributes *a, const Promise *pp);
+static PromiseResult DeleteVirt(EvalContext *ctx, virConnectPtr vc, const Attributes *a, const Promise *pp);
+static PromiseResult RunningVirt(EvalContext *ctx, virConnectPtr vc, const Attributes *a, const Promise *pp);
+static PromiseResult SuspendedVirt(EvalContext *ctx, virConnectPtr vc, const Attributes *a, const Promise *pp);
+static PromiseResult DownVirt(EvalContext *ctx, virConnectPtr vc, const Attributes *a, const Promise *pp);
 static void EnvironmentErrorHandler(void);
 static void ShowRunList(virConnectPtr vc);
 static void ShowDormant(void);
-static PromiseResult CreateVirtNetwork(EvalContext *ctx, virConnectPtr vc, char **networks, Attributes a, const Promise *pp);
-static PromiseResult DeleteVirtNetwork(EvalContext *ctx, virConnectPtr vc, Attributes a, const Promise *pp);
+static PromiseResult CreateVirtNetwork(EvalContext *ctx, virConnectPtr vc, char **networks, const Attributes *a, const Promise *pp);
+static PromiseResult DeleteVirtNetwork(EvalContext *ctx, virConnectPtr vc, const Attributes *a, const Promise *pp);
 static enum cfhypervisors Str2Hypervisors(char *s);
 
 /*****************************************************************************/
@@ -126,7 +126,7 @@ PromiseResult VerifyEnvironmentsPromise(EvalContext *ctx, const Promise *pp)
     Attributes a = GetEnvironmentsAttributes(ctx, pp);
 
     PromiseResult result = PROMISE_RESULT_NOOP;
-    if (EnvironmentsSanityChecks(a, pp))
+    if (EnvironmentsSanityChecks(&a, pp))
     {
         thislock = AcquireLock(ctx, "virtual", VUQNAME, CFSTARTTIME, a.transaction, pp, false);
 
@@ -145,7 +145,7 @@ PromiseResult VerifyEnvironmentsPromise(EvalContext *ctx, const Promise *pp)
         }
         else
         {
-            result = VerifyEnvironments(ctx, a, pp);
+            result = VerifyEnvironments(ctx, &a, pp);
         }
 
         PromiseDestroy(pexp);
@@ -158,35 +158,35 @@ PromiseResult VerifyEnvironmentsPromise(EvalContext *ctx, const Promise *pp)
 
 /*****************************************************************************/
 
-static int EnvironmentsSanityChecks(Attributes a, const Promise *pp)
+static int EnvironmentsSanityChecks(const Attributes *a, const Promise *pp)
 {
-    if (a.env.spec)
+    if (a->env.spec)
     {
-        if (a.env.cpus != CF_NOINT || a.env.memory != CF_NOINT || a.env.disk != CF_NOINT)
+        if (a->env.cpus != CF_NOINT || a->env.memory != CF_NOINT || a->env.disk != CF_NOINT)
         {
             Log(LOG_LEVEL_ERR, "Conflicting promise of both a spec and cpu/memory/disk resources");
             return false;
         }
     }
 
-    if (a.env.host == NULL)
+    if (a->env.host == NULL)
     {
         Log(LOG_LEVEL_ERR, "No environment_host defined for environment promise");
         PromiseRef(LOG_LEVEL_ERR, pp);
         return false;
     }
 
-    switch (Str2Hypervisors(a.env.type))
+    switch (Str2Hypervisors(a->env.type))
     {
     case cfv_virt_xen_net:
     case cfv_virt_kvm_net:
     case cfv_virt_esx_net:
     case cfv_virt_test_net:
-        if (a.env.cpus != CF_NOINT || a.env.memory != CF_NOINT || a.env.disk != CF_NOINT || a.env.name
-            || a.env.addresses)
+        if (a->env.cpus != CF_NOINT || a->env.memory != CF_NOINT || a->env.disk != CF_NOINT || a->env.name
+            || a->env.addresses)
         {
-            Log(LOG_LEVEL_ERR, "Network environment promises computational resources (%d,%d,%d,%s)", a.env.cpus,
-                  a.env.memory, a.env.disk, a.env.name);
+            Log(LOG_LEVEL_ERR, "Network environment promises computational resources (%d,%d,%d,%s)", a->env.cpus,
+                  a->env.memory, a->env.disk, a->env.name);
             PromiseRef(LOG_LEVEL_ERR, pp);
         }
         break;
@@ -199,12 +199,15 @@ static int EnvironmentsSanityChecks(Attributes a, const Promise *pp)
 
 /*****************************************************************************/
 
-static PromiseResult VerifyEnvironments(EvalContext *ctx, Attributes a, const Promise *pp)
+static PromiseResult VerifyEnvironments(EvalContext *ctx, const Attributes *org_a, const Promise *pp)
 {
+    Attributes a_copy = *org_a; /* modified below */
+    Attributes *a = &a_copy;
+
     char hyper_uri[CF_MAXVARSIZE];
     enum cfhypervisors envtype = cfv_none;
 
-    switch (Str2Hypervisors(a.env.type))
+    switch (Str2Hypervisors(a->env.type))
     {
     case cfv_virt_xen:
     case cfv_virt_xen_net:
@@ -240,24 +243,24 @@ static PromiseResult VerifyEnvironments(EvalContext *ctx, Attributes a, const Pr
         break;
 
     default:
-        Log(LOG_LEVEL_ERR, "Environment type '%s' not currently supported", a.env.type);
+        Log(LOG_LEVEL_ERR, "Environment type '%s' not currently supported", a->env.type);
         return PROMISE_RESULT_NOOP;
         break;
     }
 
-    Log(LOG_LEVEL_VERBOSE, "Selecting environment type '%s' '%s'", a.env.type, hyper_uri);
+    Log(LOG_LEVEL_VERBOSE, "Selecting environment type '%s' '%s'", a->env.type, hyper_uri);
 
-    ClassRef environment_host_ref = ClassRefParse(a.env.host);
+    ClassRef environment_host_ref = ClassRefParse(a->env.host);
     if (!EvalContextClassGet(ctx, environment_host_ref.ns, environment_host_ref.name))
     {
-        switch (a.env.state)
+        switch (a->env.state)
         {
         case ENVIRONMENT_STATE_CREATE:
         case ENVIRONMENT_STATE_RUNNING:
             Log(LOG_LEVEL_VERBOSE,
                 "This host ''%s' is not the promised host for the environment '%s', so setting its intended state to 'down'",
-                  VFQNAME, a.env.host);
-            a.env.state = ENVIRONMENT_STATE_DOWN;
+                  VFQNAME, a->env.host);
+            a->env.state = ENVIRONMENT_STATE_DOWN;
             break;
         default:
             Log(LOG_LEVEL_VERBOSE,
@@ -270,7 +273,7 @@ static PromiseResult VerifyEnvironments(EvalContext *ctx, Attributes a, const Pr
 
     PromiseResult result = PROMISE_RESULT_NOOP;
 #if defined(__linux__)
-    switch (Str2Hypervisors(a.env.type))
+    switch (Str2Hypervisors(a->env.type))
     {
     case cfv_virt_xen:
     case cfv_virt_kvm:
@@ -293,7 +296,7 @@ static PromiseResult VerifyEnvironments(EvalContext *ctx, Attributes a, const Pr
         break;
     }
 #elif defined(__APPLE__)
-    switch (Str2Hypervisors(a.env.type))
+    switch (Str2Hypervisors(a->env.type))
     {
     case cfv_virt_vbox:
     case cfv_virt_test:
@@ -309,7 +312,7 @@ static PromiseResult VerifyEnvironments(EvalContext *ctx, Attributes a, const Pr
         break;
     }
 #elif defined(__sun)
-    switch (Str2Hypervisors(a.env.type))
+    switch (Str2Hypervisors(a->env.type))
     {
     case cfv_zone:
         result = PromiseResultUpdate(result, VerifyZone(a, pp));
@@ -327,7 +330,7 @@ static PromiseResult VerifyEnvironments(EvalContext *ctx, Attributes a, const Pr
 /* Level                                                                     */
 /*****************************************************************************/
 
-static PromiseResult VerifyVirtDomain(EvalContext *ctx, char *uri, enum cfhypervisors envtype, Attributes a, const Promise *pp)
+static PromiseResult VerifyVirtDomain(EvalContext *ctx, char *uri, enum cfhypervisors envtype, const Attributes *a, const Promise *pp)
 {
     int num, i;
 
@@ -357,7 +360,7 @@ static PromiseResult VerifyVirtDomain(EvalContext *ctx, char *uri, enum cfhyperv
     ShowDormant();
 
     PromiseResult result = PROMISE_RESULT_NOOP;
-    switch (a.env.state)
+    switch (a->env.state)
     {
     case ENVIRONMENT_STATE_CREATE:
         result = PromiseResultUpdate(result, CreateVirtDom(ctx, CFVC[envtype], a, pp));
@@ -384,7 +387,7 @@ static PromiseResult VerifyVirtDomain(EvalContext *ctx, char *uri, enum cfhyperv
 
 /*****************************************************************************/
 
-static PromiseResult VerifyVirtNetwork(EvalContext *ctx, char *uri, enum cfhypervisors envtype, Attributes a, const Promise *pp)
+static PromiseResult VerifyVirtNetwork(EvalContext *ctx, char *uri, enum cfhypervisors envtype, const Attributes *a, const Promise *pp)
 {
     int num, i;
     char *networks[CF_MAX_CONCURRENT_ENVIRONMENTS];
@@ -408,7 +411,7 @@ static PromiseResult VerifyVirtNetwork(EvalContext *ctx, char *uri, enum cfhyper
     Log(LOG_LEVEL_VERBOSE, "Detected %d active networks", num);
 
     PromiseResult result = PROMISE_RESULT_NOOP;
-    switch (a.env.state)
+    switch (a->env.state)
     {
     case ENVIRONMENT_STATE_CREATE:
         result = PromiseResultUpdate(result, CreateVirtNetwork(ctx, CFVC[envtype], networks, a, pp));
@@ -430,7 +433,7 @@ static PromiseResult VerifyVirtNetwork(EvalContext *ctx, char *uri, enum cfhyper
 /* Level                                                                     */
 /*****************************************************************************/
 
-static PromiseResult CreateVirtDom(EvalContext *ctx, virConnectPtr vc, Attributes a, const Promise *pp)
+static PromiseResult CreateVirtDom(EvalContext *ctx, virConnectPtr vc, const Attributes *a, const Promise *pp)
 {
     int alloc_file = false;
     char *xml_file;
@@ -473,9 +476,9 @@ static PromiseResult CreateVirtDom(EvalContext *ctx, virConnectPtr vc, Attribute
         }
     }
 
-    if(a.env.spec)
+    if(a->env.spec)
     {
-        xml_file = xstrdup(a.env.spec);
+        xml_file = xstrdup(a->env.spec);
         alloc_file = true;
     }
     else
@@ -490,7 +493,7 @@ static PromiseResult CreateVirtDom(EvalContext *ctx, virConnectPtr vc, Attribute
         cfPS(ctx, LOG_LEVEL_VERBOSE, PROMISE_RESULT_CHANGE, pp, a, "Created a virtual domain '%s'", pp->promiser);
         result = PromiseResultUpdate(result, PROMISE_RESULT_CHANGE);
 
-        if (a.env.cpus != CF_NOINT)
+        if (a->env.cpus != CF_NOINT)
         {
             int maxcpus;
 
@@ -500,24 +503,24 @@ static PromiseResult CreateVirtDom(EvalContext *ctx, virConnectPtr vc, Attribute
             }
             else
             {
-                if (a.env.cpus > maxcpus)
+                if (a->env.cpus > maxcpus)
                 {
                     Log(LOG_LEVEL_INFO,
                           "The promise to allocate %d CPUs in domain '%s' cannot be kept - only %d exist on the host",
-                          a.env.cpus, pp->promiser, maxcpus);
+                          a->env.cpus, pp->promiser, maxcpus);
                 }
-                else if (virDomainSetVcpus(dom, (unsigned int) a.env.cpus) == -1)
+                else if (virDomainSetVcpus(dom, (unsigned int) a->env.cpus) == -1)
                 {
-                    Log(LOG_LEVEL_INFO, "Unable to adjust CPU count to %d", a.env.cpus);
+                    Log(LOG_LEVEL_INFO, "Unable to adjust CPU count to %d", a->env.cpus);
                 }
                 else
                 {
-                    Log(LOG_LEVEL_INFO, "Verified that environment CPU count is now %d", a.env.cpus);
+                    Log(LOG_LEVEL_INFO, "Verified that environment CPU count is now %d", a->env.cpus);
                 }
             }
         }
 
-        if (a.env.memory != CF_NOINT)
+        if (a->env.memory != CF_NOINT)
         {
             unsigned long maxmem;
 
@@ -527,23 +530,23 @@ static PromiseResult CreateVirtDom(EvalContext *ctx, virConnectPtr vc, Attribute
             }
             else
             {
-                if (virDomainSetMaxMemory(dom, (unsigned long) a.env.memory) == -1)
+                if (virDomainSetMaxMemory(dom, (unsigned long) a->env.memory) == -1)
                 {
-                    Log(LOG_LEVEL_INFO, " Unable to set the memory limit to %d", a.env.memory);
+                    Log(LOG_LEVEL_INFO, " Unable to set the memory limit to %d", a->env.memory);
                 }
                 else
                 {
-                    Log(LOG_LEVEL_INFO, "Setting the memory limit to %d", a.env.memory);
+                    Log(LOG_LEVEL_INFO, "Setting the memory limit to %d", a->env.memory);
                 }
 
-                if (virDomainSetMemory(dom, (unsigned long) a.env.memory) == -1)
+                if (virDomainSetMemory(dom, (unsigned long) a->env.memory) == -1)
                 {
-                    Log(LOG_LEVEL_INFO, " Unable to set the current memory to %d", a.env.memory);
+                    Log(LOG_LEVEL_INFO, " Unable to set the current memory to %d", a->env.memory);
                 }
             }
         }
 
-        if (a.env.disk != CF_NOINT)
+        if (a->env.disk != CF_NOINT)
         {
             Log(LOG_LEVEL_VERBOSE, "Info: env_disk parameter is not currently supported on this platform");
         }
@@ -573,7 +576,7 @@ static PromiseResult CreateVirtDom(EvalContext *ctx, virConnectPtr vc, Attribute
 
 /*****************************************************************************/
 
-static PromiseResult DeleteVirt(EvalContext *ctx, virConnectPtr vc, Attributes a, const Promise *pp)
+static PromiseResult DeleteVirt(EvalContext *ctx, virConnectPtr vc, const Attributes *a, const Promise *pp)
 {
     virDomainPtr dom;
 
@@ -605,7 +608,7 @@ static PromiseResult DeleteVirt(EvalContext *ctx, virConnectPtr vc, Attributes a
 
 /*****************************************************************************/
 
-static PromiseResult RunningVirt(EvalContext *ctx, virConnectPtr vc, Attributes a, const Promise *pp)
+static PromiseResult RunningVirt(EvalContext *ctx, virConnectPtr vc, const Attributes *a, const Promise *pp)
 {
     virDomainPtr dom;
     virDomainInfo info;
@@ -692,36 +695,36 @@ static PromiseResult RunningVirt(EvalContext *ctx, virConnectPtr vc, Attributes
             break;
         }
 
-        if (a.env.cpus > 0)
+        if (a->env.cpus > 0)
         {
-            if (virDomainSetVcpus(dom, a.env.cpus) == -1)
+            if (virDomainSetVcpus(dom, a->env.cpus) == -1)
             {
-                Log(LOG_LEVEL_INFO, " Unable to set the number of cpus to %d", a.env.cpus);
+                Log(LOG_LEVEL_INFO, " Unable to set the number of cpus to %d", a->env.cpus);
             }
             else
             {
-                Log(LOG_LEVEL_INFO, "Setting the number of virtual cpus to %d", a.env.cpus);
+                Log(LOG_LEVEL_INFO, "Setting the number of virtual cpus to %d", a->env.cpus);
             }
         }
 
-        if (a.env.memory != CF_NOINT)
+        if (a->env.memory != CF_NOINT)
         {
-            if (virDomainSetMaxMemory(dom, (unsigned long) a.env.memory) == -1)
+            if (virDomainSetMaxMemory(dom, (unsigned long) a->env.memory) == -1)
             {
-                Log(LOG_LEVEL_INFO, " Unable to set the memory limit to %d", a.env.memory);
+                Log(LOG_LEVEL_INFO, " Unable to set the memory limit to %d", a->env.memory);
             }
             else
             {
-                Log(LOG_LEVEL_INFO, "Setting the memory limit to %d", a.env.memory);
+                Log(LOG_LEVEL_INFO, "Setting the memory limit to %d", a->env.memory);
             }
 
-            if (virDomainSetMemory(dom, (unsigned long) a.env.memory) == -1)
+            if (virDomainSetMemory(dom, (unsigned long) a->env.memory) == -1)
             {
-                Log(LOG_LEVEL_INFO, " Unable to set the current memory to %d", a.env.memory);
+                Log(LOG_LEVEL_INFO, " Unable to set the current memory to %d", a->env.memory);
             }
         }
 
-        if (a.env.disk != CF_NOINT)
+        if (a->env.disk != CF_NOINT)
         {
             Log(LOG_LEVEL_VERBOSE, "Info: env_disk parameter is not currently supported on this platform");
         }
@@ -739,7 +742,7 @@ static PromiseResult RunningVirt(EvalContext *ctx, virConnectPtr vc, Attributes
 
 /*****************************************************************************/
 
-static PromiseResult SuspendedVirt(EvalContext *ctx, virConnectPtr vc, Attributes a, const Promise *pp)
+static PromiseResult SuspendedVirt(EvalContext *ctx, virConnectPtr vc, const Attributes *a, const Promise *pp)
 {
     virDomainPtr dom;
     virDomainInfo info;
@@ -824,7 +827,7 @@ static PromiseResult SuspendedVirt(EvalContext *ctx, virConnectPtr vc, Attribute
 
 /*****************************************************************************/
 
-static PromiseResult DownVirt(EvalContext *ctx, virConnectPtr vc, Attributes a, const Promise *pp)
+static PromiseResult DownVirt(EvalContext *ctx, virConnectPtr vc, const Attributes *a, const Promise *pp)
 {
     virDomainPtr dom;
     virDomainInfo info;
@@ -904,7 +907,7 @@ static PromiseResult DownVirt(EvalContext *ctx, virConnectPtr vc, Attributes a,
 
 /*****************************************************************************/
 
-static PromiseResult CreateVirtNetwork(EvalContext *ctx, virConnectPtr vc, char **networks, Attributes a, const Promise *pp)
+static PromiseResult CreateVirtNetwork(EvalContext *ctx, virConnectPtr vc, char **networks, const Attributes *a, const Promise *pp)
 {
     virNetworkPtr network;
     char *xml_file;
@@ -936,9 +939,9 @@ static PromiseResult CreateVirtNetwork(EvalContext *ctx, virConnectPtr vc, char
         return PROMISE_RESULT_NOOP;
     }
 
-    if (a.env.spec)
+    if (a->env.spec)
     {
-        xml_file = xstrdup(a.env.spec);
+        xml_file = xstrdup(a->env.spec);
     }
     else
     {
@@ -966,7 +969,7 @@ static PromiseResult CreateVirtNetwork(EvalContext *ctx, virConnectPtr vc, char
 
 /*****************************************************************************/
 
-static PromiseResult DeleteVirtNetwork(EvalContext *ctx, virConnectPtr vc, Attributes a, const Promise *pp)
+static PromiseResult DeleteVirtNetwork(EvalContext *ctx, virConnectPtr vc, const Attributes *a, const Promise *pp)
 {
     virNetworkPtr network;
 
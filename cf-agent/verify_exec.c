@@ -53,27 +53,55 @@ typedef enum
     ACTION_RESULT_FAILED
 } ActionResult;
 
-static bool SyntaxCheckExec(Attributes a, const Promise *pp);
-static bool PromiseKeptExec(Attributes a, const Promise *pp);
-static char *GetLockNameExec(Attributes a, const Promise *pp);
-static ActionResult RepairExec(EvalContext *ctx, Attributes a, const Promise *pp, PromiseResult *result);
+/*
+ * A command started by a concurrent commands promise, see
+ * concurrent_commands in body agent control. Its output and exit code are
+ * collected later, in the order the commands were started.
+ */
+typedef struct
+{
+    Promise *pp;             /* copy of the expanded promise, owns a's data */
+    Attributes a;
+    CfLock lock;
+    FILE *pfp;
+    char cmdline[CF_BUFSIZE];
+    char comm[20];
+    PromiseResult result;
+} ConcurrentExec;
+
+static int MAX_CONCURRENT_COMMANDS = 1; /* GLOBAL_P */
+static Seq *CONCURRENT_EXECS = NULL; /* GLOBAL_X */
+
+static bool SyntaxCheckExec(const Attributes *a, const Promise *pp);
+static bool PromiseKeptExec(const Attributes *a, const Promise *pp);
+static char *GetLockNameExec(const Attributes *a, const Promise *pp);
+static ActionResult PrepareExec(EvalContext *ctx, const Attributes *a, const Promise *pp,
+                                PromiseResult *result, char *cmdline, char *comm,
+                                bool *execute);
+static ActionResult CollectExec(EvalContext *ctx, const Attributes *a, const Promise *pp,
+                                FILE *pfp, char *cmdline, const char *comm,
+                                bool background, PromiseResult *result);
+static ActionResult RepairExec(EvalContext *ctx, const Attributes *a, const Promise *pp, PromiseResult *result);
+static PromiseResult FinishExec(ActionResult action_result, PromiseResult result, CfLock lock);
+static bool ExecCanRunConcurrently(const Attributes *a, const Promise *pp);
+static PromiseResult StartConcurrentExec(EvalContext *ctx, const Promise *pp, CfLock lock);
 
 static void PreviewProtocolLine(char *line, char *comm);
 
-char* BuildCommandLine(Attributes a, const Promise *pp)
+char* BuildCommandLine(const Attributes *a, const Promise *pp)
 {
     Writer *w = StringWriter();
     WriterWriteF(w, "%s", pp->promiser);
 
-    if (a.args)
+    if (a->args)
     {
         WriterWrite(w, " ");
-        WriterWrite(w, a.args);
+        WriterWrite(w, a->args);
     }
 
-    if (a.arglist)
+    if (a->arglist)
     {
-        for (const Rlist *rp = a.arglist; rp != NULL; rp = rp->next)
+        for (const Rlist *rp = a->arglist; rp != NULL; rp = rp->next)
         {
             switch (rp->val.type)
             {
@@ -96,17 +124,17 @@ PromiseResult VerifyExecPromise(EvalContext *ctx, const Promise *pp)
 {
     Attributes a = GetExecAttributes(ctx, pp);
 
-    if (!SyntaxCheckExec(a, pp))
+    if (!SyntaxCheckExec(&a, pp))
     {
         return PROMISE_RESULT_FAIL;
     }
 
-    if (PromiseKeptExec(a, pp))
+    if (PromiseKeptExec(&a, pp))
     {
         return PROMISE_RESULT_NOOP;
     }
 
-    char *lock_name = GetLockNameExec(a, pp);
+    char *lock_name = GetLockNameExec(&a, pp);
     CfLock thislock = AcquireLock(ctx, lock_name, VUQNAME, CFSTARTTIME, a.transaction, pp, false);
     free(lock_name);
     if (thislock.lock == NULL)
@@ -116,41 +144,33 @@ PromiseResult VerifyExecPromise(EvalContext *ctx, const Promise *pp)
 
     PromiseBanner(ctx,pp);
 
+    if (ExecCanRunConcurrently(&a, pp))
+    {
+        return StartConcurrentExec(ctx, pp, thislock);
+    }
+
     PromiseResult result = PROMISE_RESULT_NOOP;
     /* See VerifyCommandRetcode for interpretation of return codes.
      * Unless overridden by attributes in body classes, an exit code 0 means
      * reparied (PROMISE_RESULT_CHANGE), an exit code != 0 means failure.
      */
-    switch (RepairExec(ctx, a, pp, &result))
-    {
-    case ACTION_RESULT_OK:
-        result = PromiseResultUpdate(result, PROMISE_RESULT_NOOP);
-        break;
-
-    case ACTION_RESULT_TIMEOUT:
-        result = PromiseResultUpdate(result, PROMISE_RESULT_TIMEOUT);
-        break;
+    ActionResult action_result = RepairExec(ctx, &a, pp, &result);
 
-    case ACTION_RESULT_FAILED:
-        result = PromiseResultUpdate(result, PROMISE_RESULT_FAIL);
-        break;
-
-    default:
-        ProgrammingError("Unexpected ActionResult value");
-    }
-
-    YieldCurrentLock(thislock);
+    return FinishExec(action_result, result, thislock);
+}
 
-    return result;
+void SetMaxConcurrentCommands(int max)
+{
+    MAX_CONCURRENT_COMMANDS = max;
 }
 
 /*****************************************************************************/
 /* Level                                                                     */
 /*****************************************************************************/
 
-static bool SyntaxCheckExec(Attributes a, const Promise *pp)
+static bool SyntaxCheckExec(const Attributes *a, const Promise *pp)
 {
-    if ((a.contain.nooutput) && (a.contain.preview))
+    if ((a->contain.nooutput) && (a->contain.preview))
     {
         Log(LOG_LEVEL_ERR, "no_output and preview are mutually exclusive (broken promise)");
         PromiseRef(LOG_LEVEL_ERR, pp);
@@ -158,67 +178,54 @@ static bool SyntaxCheckExec(Attributes a, const Promise *pp)
     }
 
 #ifdef __MINGW32__
-    if (a.contain.umask != (mode_t)CF_UNDEFINED)
+    if (a->contain.umask != (mode_t)CF_UNDEFINED)
     {
         Log(LOG_LEVEL_VERBOSE, "contain.umask is ignored on Windows");
     }
 
-    if (a.contain.owner != CF_UNDEFINED)
+    if (a->contain.owner != CF_UNDEFINED)
     {
         Log(LOG_LEVEL_VERBOSE, "contain.exec_owner is ignored on Windows");
     }
 
-    if (a.contain.group != CF_UNDEFINED)
+    if (a->contain.group != CF_UNDEFINED)
     {
         Log(LOG_LEVEL_VERBOSE, "contain.exec_group is ignored on Windows");
     }
 
-    if (a.contain.chroot != NULL)
+    if (a->contain.chroot != NULL)
     {
         Log(LOG_LEVEL_VERBOSE, "contain.chroot is ignored on Windows");
     }
-
-#else /* !__MINGW32__ */
-    if (a.contain.umask == (mode_t)CF_UNDEFINED)
-    {
-        a.contain.umask = 077;
-    }
-#endif /* !__MINGW32__ */
+#endif /* __MINGW32__ */
 
     return true;
 }
 
-static bool PromiseKeptExec(ARG_UNUSED Attributes a, ARG_UNUSED const Promise *pp)
+static bool PromiseKeptExec(ARG_UNUSED const Attributes *a, ARG_UNUSED const Promise *pp)
 {
     return false;
 }
 
-static char *GetLockNameExec(Attributes a, const Promise *pp)
+static char *GetLockNameExec(const Attributes *a, const Promise *pp)
 {
     return BuildCommandLine(a, pp);
 }
 
 /*****************************************************************************/
 
-static ActionResult RepairExec(EvalContext *ctx, Attributes a,
-                               const Promise *pp, PromiseResult *result)
+/**
+ * Checks, logging and dry-run handling before running the command of #pp.
+ * On return, #execute tells whether the command is to be run: #cmdline and
+ * #comm are filled in then.
+ */
+static ActionResult PrepareExec(EvalContext *ctx, const Attributes *a, const Promise *pp,
+                                PromiseResult *result, char *cmdline, char *comm,
+                                bool *execute)
 {
-    char eventname[CF_BUFSIZE];
-    char cmdline[CF_BUFSIZE];
-    char comm[20];
-    int outsourced, count = 0;
-#if !defined(__MINGW32__)
-    mode_t maskval = 0;
-#endif
-    FILE *pfp;
-    char cmdOutBuf[CF_BUFSIZE];
-    int cmdOutBufPos = 0;
-    int lineOutLen;
-    char module_context[CF_BUFSIZE];
+    *execute = false;
 
-    module_context[0] = '\0';
-
-    if (IsAbsoluteFileName(CommandArg0(pp->promiser)) || a.contain.shelltype == SHELL_TYPE_NONE)
+    if (IsAbsoluteFileName(CommandArg0(pp->promiser)) || a->contain.shelltype == SHELL_TYPE_NONE)
     {
         if (!IsExecutable(CommandArg0(pp->promiser)))
         {
@@ -239,25 +246,25 @@ static ActionResult RepairExec(EvalContext *ctx, Attributes a,
     }
 
     char timeout_str[CF_BUFSIZE];
-    if (a.contain.timeout == CF_NOINT)
+    if (a->contain.timeout == CF_NOINT)
     {
         snprintf(timeout_str, CF_BUFSIZE, "no timeout");
     }
     else
     {
-        snprintf(timeout_str, CF_BUFSIZE, "timeout=%ds", a.contain.timeout);
+        snprintf(timeout_str, CF_BUFSIZE, "timeout=%ds", a->contain.timeout);
     }
 
     char owner_str[CF_BUFSIZE] = "";
-    if (a.contain.owner != -1)
+    if (a->contain.owner != -1)
     {
-        snprintf(owner_str, CF_BUFSIZE, ",uid=%ju", (uintmax_t)a.contain.owner);
+        snprintf(owner_str, CF_BUFSIZE, ",uid=%ju", (uintmax_t)a->contain.owner);
     }
 
     char group_str[CF_BUFSIZE] = "";
-    if (a.contain.group != -1)
+    if (a->contain.group != -1)
     {
-        snprintf(group_str, CF_BUFSIZE, ",gid=%ju", (uintmax_t)a.contain.group);
+        snprintf(group_str, CF_BUFSIZE, ",gid=%ju", (uintmax_t)a->contain.group);
     }
 
     char* temp = BuildCommandLine(a, pp);
@@ -268,14 +275,14 @@ static ActionResult RepairExec(EvalContext *ctx, Attributes a,
 
     BeginMeasure();
 
-    if (DONTDO && (!a.contain.preview))
+    if (DONTDO && (!a->contain.preview))
     {
         cfPS(ctx, LOG_LEVEL_WARNING, PROMISE_RESULT_WARN, pp, a, "Would execute script '%s'", cmdline);
         *result = PromiseResultUpdate(*result, PROMISE_RESULT_WARN);
         return ACTION_RESULT_OK;
     }
 
-    if (a.transaction.action != cfa_fix)
+    if (a->transaction.action != cfa_fix)
     {
         cfPS(ctx, LOG_LEVEL_WARNING, PROMISE_RESULT_WARN, pp, a, "Command '%s' needs to be executed, but only warning was promised", cmdline);
         *result = PromiseResultUpdate(*result, PROMISE_RESULT_WARN);
@@ -284,7 +291,173 @@ static ActionResult RepairExec(EvalContext *ctx, Attributes a,
 
     CommandPrefix(cmdline, comm);
 
-    if (a.transaction.background)
+    *execute = true;
+    return ACTION_RESULT_OK;
+}
+
+static FILE *OpenExec(const Attributes *a, const char *cmdline)
+{
+    const char *open_mode = a->module ? "rt" : "r";
+    if (a->contain.shelltype == SHELL_TYPE_POWERSHELL)
+    {
+#ifdef __MINGW32__
+        return cf_popen_powershell_setuid(cmdline, open_mode, a->contain.owner, a->contain.group, a->contain.chdir, a->contain.chroot,
+                                          a->transaction.background);
+#else // !__MINGW32__
+        Log(LOG_LEVEL_ERR, "Powershell is only supported on Windows");
+        return NULL;
+#endif // !__MINGW32__
+    }
+    else if (a->contain.shelltype == SHELL_TYPE_USE)
+    {
+        return cf_popen_shsetuid(cmdline, open_mode, a->contain.owner, a->contain.group, a->contain.chdir, a->contain.chroot,
+                                 a->transaction.background);
+    }
+    else
+    {
+        return cf_popensetuid(cmdline, open_mode, a->contain.owner, a->contain.group, a->contain.chdir, a->contain.chroot,
+                              a->transaction.background);
+    }
+}
+
+/**
+ * Reads the output of the command, closes #pfp and evaluates the return
+ * code. Fails only if the output can not be read.
+ */
+static ActionResult CollectExec(EvalContext *ctx, const Attributes *a, const Promise *pp,
+                                FILE *pfp, char *cmdline, const char *comm,
+                                ARG_UNUSED bool background, PromiseResult *result)
+{
+    int count = 0;
+    char cmdOutBuf[CF_BUFSIZE];
+    int cmdOutBufPos = 0;
+    int lineOutLen;
+    char module_context[CF_BUFSIZE];
+
+    module_context[0] = '\0';
+
+    StringSet *module_tags = StringSetNew();
+    long persistence = 0;
+
+    size_t line_size = CF_BUFSIZE;
+    char *line = xmalloc(line_size);
+
+    for (;;)
+    {
+        ssize_t res = CfReadLine(&line, &line_size, pfp);
+        if (res == -1)
+        {
+            if (!feof(pfp))
+            {
+                Log(LOG_LEVEL_ERR, "Unable to read output from command '%s'. (fread: %s)", cmdline, GetErrorStr());
+                cf_pclose(pfp);
+                StringSetDestroy(module_tags);
+                free(line);
+                return ACTION_RESULT_FAILED;
+            }
+            else
+            {
+                break;
+            }
+        }
+
+        if (strstr(line, "cfengine-die"))
+        {
+            break;
+        }
+
+        if (a->contain.preview)
+        {
+            PreviewProtocolLine(line, cmdline);
+        }
+
+        if (a->module)
+        {
+            ModuleProtocol(ctx, cmdline, line, !a->contain.nooutput, module_context, sizeof(module_context), module_tags, &persistence);
+        }
+
+        if (!a->contain.nooutput && !EmptyString(line))
+        {
+            lineOutLen = strlen(comm) + strlen(line) + 12;
+
+            // if buffer is to small for this line, output it directly
+            if (lineOutLen > sizeof(cmdOutBuf))
+            {
+                Log(LOG_LEVEL_NOTICE, "Q: '%s': %s", comm, line);
+            }
+            else
+            {
+                if (cmdOutBufPos + lineOutLen > sizeof(cmdOutBuf))
+                {
+                    Log(LOG_LEVEL_NOTICE, "%s", cmdOutBuf);
+                    cmdOutBufPos = 0;
+                }
+                snprintf(cmdOutBuf + cmdOutBufPos,
+                         sizeof(cmdOutBuf) - cmdOutBufPos,
+                         "Q: \"...%s\": %s\n", comm, line);
+                cmdOutBufPos += (lineOutLen - 1);
+            }
+            count++;
+        }
+    }
+
+    StringSetDestroy(module_tags);
+    free(line);
+
+#ifdef __MINGW32__
+    if (background)     // only get return value if we waited for command execution
+    {
+        cf_pclose(pfp);
+    }
+    else
+#endif /* __MINGW32__ */
+    {
+        int ret = cf_pclose(pfp);
+
+        if (ret == -1)
+        {
+            cfPS(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_FAIL, pp, a, "Finished script '%s' - failed (abnormal termination)", pp->promiser);
+            *result = PromiseResultUpdate(*result, PROMISE_RESULT_FAIL);
+        }
+        else
+        {
+            VerifyCommandRetcode(ctx, ret, a, pp, result);
+        }
+    }
+
+    if (count)
+    {
+        if (cmdOutBufPos)
+        {
+            Log(LOG_LEVEL_NOTICE, "%s", cmdOutBuf);
+        }
+
+        Log(LOG_LEVEL_INFO, "Last %d quoted lines were generated by promiser '%s'", count, cmdline);
+    }
+
+    return ACTION_RESULT_OK;
+}
+
+static ActionResult RepairExec(EvalContext *ctx, const Attributes *a,
+                               const Promise *pp, PromiseResult *result)
+{
+    char eventname[CF_BUFSIZE];
+    char cmdline[CF_BUFSIZE];
+    char comm[20];
+    int outsourced;
+#if !defined(__MINGW32__)
+    mode_t maskval = 0;
+#endif
+    FILE *pfp;
+
+    bool execute;
+    ActionResult prepared = PrepareExec(ctx, a, pp, result, cmdline, comm, &execute);
+    if (!execute)
+    {
+        return prepared;
+    }
+
+    if (a->transaction.background)
     {
 #ifdef __MINGW32__
         outsourced = true;
@@ -298,175 +471,370 @@ static ActionResult RepairExec(EvalContext *ctx, Attributes a,
         outsourced = false;
     }
 
-    if (outsourced || (!a.transaction.background))    // work done here: either by child or non-background parent
+    if (outsourced || (!a->transaction.background))    // work done here: either by child or non-background parent
     {
-        if (a.contain.timeout != CF_NOINT)
+        if (a->contain.timeout != CF_NOINT)
         {
-            SetTimeOut(a.contain.timeout);
+            SetTimeOut(a->contain.timeout);
         }
 
 #ifndef __MINGW32__
-        Log(LOG_LEVEL_VERBOSE, "Setting umask to %jo", (uintmax_t)a.contain.umask);
-        maskval = umask(a.contain.umask);
+        Log(LOG_LEVEL_VERBOSE, "Setting umask to %jo", (uintmax_t)a->contain.umask);
+        maskval = umask(a->contain.umask);
 
-        if (a.contain.umask == 0)
+        if (a->contain.umask == 0)
         {
             Log(LOG_LEVEL_VERBOSE, "Programming '%s' running with umask 0! Use umask= to set", cmdline);
         }
 #endif /* !__MINGW32__ */
 
-        const char *open_mode = a.module ? "rt" : "r";
-        if (a.contain.shelltype == SHELL_TYPE_POWERSHELL)
+        pfp = OpenExec(a, cmdline);
+
+        if (pfp == NULL)
         {
-#ifdef __MINGW32__
-            pfp =
-                cf_popen_powershell_setuid(cmdline, open_mode, a.contain.owner, a.contain.group, a.contain.chdir, a.contain.chroot,
-                                           a.transaction.background);
-#else // !__MINGW32__
-            Log(LOG_LEVEL_ERR, "Powershell is only supported on Windows");
+            Log(LOG_LEVEL_ERR, "Couldn't open pipe to command '%s'. (cf_popen: %s)", cmdline, GetErrorStr());
             return ACTION_RESULT_FAILED;
-#endif // !__MINGW32__
         }
-        else if (a.contain.shelltype == SHELL_TYPE_USE)
-        {
-            pfp =
-                cf_popen_shsetuid(cmdline, open_mode, a.contain.owner, a.contain.group, a.contain.chdir, a.contain.chroot,
-                                  a.transaction.background);
-        }
-        else
+
+        if (CollectExec(ctx, a, pp, pfp, cmdline, comm, outsourced, result) == ACTION_RESULT_FAILED)
         {
-            pfp =
-                cf_popensetuid(cmdline, open_mode, a.contain.owner, a.contain.group, a.contain.chdir, a.contain.chroot,
-                               a.transaction.background);
+            return ACTION_RESULT_FAILED;
         }
+    }
 
-        if (pfp == NULL)
+    if (a->contain.timeout != CF_NOINT)
+    {
+        alarm(0);
+        signal(SIGALRM, SIG_DFL);
+    }
+
+    Log(LOG_LEVEL_INFO, "Completed execution of '%s'", cmdline);
+#ifndef __MINGW32__
+    umask(maskval);
+#endif
+
+    snprintf(eventname, CF_BUFSIZE - 1, "Exec(%s)", cmdline);
+
+#ifndef __MINGW32__
+    if ((a->transaction.background) && outsourced)
+    {
+        Log(LOG_LEVEL_VERBOSE, "Backgrounded command '%s' is done - exiting", cmdline);
+        exit(EXIT_SUCCESS);
+    }
+#endif /* !__MINGW32__ */
+
+    return ACTION_RESULT_OK;
+}
+
+static PromiseResult FinishExec(ActionResult action_result, PromiseResult result, CfLock lock)
+{
+    switch (action_result)
+    {
+    case ACTION_RESULT_OK:
+        result = PromiseResultUpdate(result, PROMISE_RESULT_NOOP);
+        break;
+
+    case ACTION_RESULT_TIMEOUT:
+        result = PromiseResultUpdate(result, PROMISE_RESULT_TIMEOUT);
+        break;
+
+    case ACTION_RESULT_FAILED:
+        result = PromiseResultUpdate(result, PROMISE_RESULT_FAIL);
+        break;
+
+    default:
+        ProgrammingError("Unexpected ActionResult value");
+    }
+
+    YieldCurrentLock(lock);
+
+    return result;
+}
+
+/*****************************************************************************/
+/* Concurrent commands                                                       */
+/*****************************************************************************/
+
+/*
+ * With concurrent_commands > 1, a commands promise only starts its command
+ * and returns. The command runs while the following promises of the commands
+ * section are evaluated, and is collected by CollectConcurrentCommands(),
+ * which sets its outcome classes and yields its lock as usual.
+ *
+ * The agent state stays in this process: only the commands run in parallel.
+ * Commands with anything that must happen before the next promise is
+ * evaluated run the usual way.
+ */
+static bool ExecCanRunConcurrently(const Attributes *a, const Promise *pp)
+{
+#ifdef __MINGW32__
+    return false;
+#else
+    return MAX_CONCURRENT_COMMANDS > 1 &&
+        !a->module &&                 /* defines variables and classes */
+        !a->contain.preview &&
+        !a->transaction.background && /* not waited for anyway */
+        a->contain.timeout == CF_NOINT && /* SIGALRM is per process */
+        PromiseGetHandle(pp) == NULL; /* depends_on needs the outcome */
+#endif
+}
+
+static void ConcurrentExecDestroy(void *p)
+{
+    ConcurrentExec *exec = p;
+    if (exec != NULL)
+    {
+        PromiseDestroy(exec->pp);
+        free(exec);
+    }
+}
+
+static PromiseResult StartConcurrentExec(EvalContext *ctx, const Promise *pp, CfLock lock)
+{
+    if (CONCURRENT_EXECS == NULL)
+    {
+        CONCURRENT_EXECS = SeqNew(MAX_CONCURRENT_COMMANDS, ConcurrentExecDestroy);
+    }
+
+    if (SeqLength(CONCURRENT_EXECS) >= (size_t) MAX_CONCURRENT_COMMANDS)
+    {
+        Log(LOG_LEVEL_VERBOSE, "Reached the maximum of %d concurrent commands, so serializing",
+            MAX_CONCURRENT_COMMANDS);
+
+        Attributes a = GetExecAttributes(ctx, pp);
+        PromiseResult result = PROMISE_RESULT_NOOP;
+        ActionResult action_result = RepairExec(ctx, &a, pp, &result);
+        return FinishExec(action_result, result, lock);
+    }
+
+    /* Outlives the iteration, and so does everything a points to. */
+    ConcurrentExec *exec = xcalloc(1, sizeof(ConcurrentExec));
+    exec->pp = PromiseCopy(pp);
+    exec->a = GetExecAttributes(ctx, exec->pp);
+    exec->lock = lock;
+    exec->result = PROMISE_RESULT_NOOP;
+
+    bool execute;
+    ActionResult prepared = PrepareExec(ctx, &exec->a, exec->pp, &exec->result,
+                                        exec->cmdline, exec->comm, &execute);
+    if (execute)
+    {
+        Log(LOG_LEVEL_VERBOSE, "Setting umask to %jo", (uintmax_t) exec->a.contain.umask);
+        mode_t maskval = umask(exec->a.contain.umask);
+        exec->pfp = OpenExec(&exec->a, exec->cmdline);
+        umask(maskval);
+
+        if (exec->pfp == NULL)
         {
-            Log(LOG_LEVEL_ERR, "Couldn't open pipe to command '%s'. (cf_popen: %s)", cmdline, GetErrorStr());
-            return ACTION_RESULT_FAILED;
+            Log(LOG_LEVEL_ERR, "Couldn't open pipe to command '%s'. (cf_popen: %s)",
+                exec->cmdline, GetErrorStr());
+            prepared = ACTION_RESULT_FAILED;
         }
+    }
+
+    if (exec->pfp == NULL)
+    {
+        PromiseResult result = FinishExec(prepared, exec->result, lock);
+        ConcurrentExecDestroy(exec);
+        return result;
+    }
+
+    Log(LOG_LEVEL_VERBOSE, "Started '%s', collecting it later", exec->cmdline);
+    SeqAppend(CONCURRENT_EXECS, exec);
+
+    /* The outcome is only known once collected. */
+    return PROMISE_RESULT_SKIPPED;
+}
+
+static PromiseResult CollectConcurrentExec(EvalContext *ctx, ConcurrentExec *exec)
+{
+    ActionResult action_result = CollectExec(ctx, &exec->a, exec->pp, exec->pfp,
+                                             exec->cmdline, exec->comm, false,
+                                             &exec->result);
+    if (action_result == ACTION_RESULT_OK)
+    {
+        Log(LOG_LEVEL_INFO, "Completed execution of '%s'", exec->cmdline);
+    }
 
-        StringSet *module_tags = StringSetNew();
-        long persistence = 0;
+    return FinishExec(action_result, exec->result, exec->lock);
+}
 
-        size_t line_size = CF_BUFSIZE;
-        char *line = xmalloc(line_size);
+static bool RvalHasFnCall(Rval rval)
+{
+    switch (rval.type)
+    {
+    case RVAL_TYPE_FNCALL:
+        return true;
 
-        for (;;)
+    case RVAL_TYPE_LIST:
+        for (const Rlist *rp = RvalRlistValue(rval); rp != NULL; rp = rp->next)
         {
-            ssize_t res = CfReadLine(&line, &line_size, pfp);
-            if (res == -1)
+            if (RvalHasFnCall(rp->val))
             {
-                if (!feof(pfp))
-                {
-                    Log(LOG_LEVEL_ERR, "Unable to read output from command '%s'. (fread: %s)", cmdline, GetErrorStr());
-                    cf_pclose(pfp);
-                    free(line);
-                    return ACTION_RESULT_FAILED;
-                }
-                else
-                {
-                    break;
-                }
+                return true;
             }
+        }
+        return false;
 
-            if (strstr(line, "cfengine-die"))
-            {
-                break;
-            }
+    default:
+        return false;
+    }
+}
 
-            if (a.contain.preview)
-            {
-                PreviewProtocolLine(line, cmdline);
-            }
+/**
+ * Whether the bodies and args #bodies_and_args resolved for a body
+ * reference, as returned by EvalContextResolveConstraintBody(), may read
+ * classes: through class restricted attributes or a function call.
+ */
+static bool BodiesMayReadClasses(const Seq *bodies_and_args)
+{
+    /* Pairs of the call of each body (NULL if not called) and the body. */
+    for (size_t i = 0; i + 1 < SeqLength(bodies_and_args); i += 2)
+    {
+        const Rval *called_rval = SeqAt(bodies_and_args, i);
+        if (called_rval != NULL && RvalHasFnCall(*called_rval))
+        {
+            return true;
+        }
 
-            if (a.module)
+        const Body *bp = SeqAt(bodies_and_args, i + 1);
+        for (size_t k = 0; k < SeqLength(bp->conlist); k++)
+        {
+            const Constraint *body_cp = SeqAt(bp->conlist, k);
+            if (strcmp(body_cp->classes, "any") != 0 ||
+                RvalHasFnCall(body_cp->rval))
             {
-                ModuleProtocol(ctx, cmdline, line, !a.contain.nooutput, module_context, sizeof(module_context), module_tags, &persistence);
+                return true;
             }
+        }
+    }
 
-            if (!a.contain.nooutput && !EmptyString(line))
-            {
-                lineOutLen = strlen(comm) + strlen(line) + 12;
+    return false;
+}
 
-                // if buffer is to small for this line, output it directly
-                if (lineOutLen > sizeof(cmdOutBuf))
-                {
-                    Log(LOG_LEVEL_NOTICE, "Q: '%s': %s", comm, line);
-                }
-                else
-                {
-                    if (cmdOutBufPos + lineOutLen > sizeof(cmdOutBuf))
-                    {
-                        Log(LOG_LEVEL_NOTICE, "%s", cmdOutBuf);
-                        cmdOutBufPos = 0;
-                    }
-                    snprintf(cmdOutBuf + cmdOutBufPos,
-                             sizeof(cmdOutBuf) - cmdOutBufPos,
-                             "Q: \"...%s\": %s\n", comm, line);
-                    cmdOutBufPos += (lineOutLen - 1);
-                }
-                count++;
-            }
-        }
+/**
+ * Whether evaluating #pp may depend on which classes are defined: through
+ * its context, if/unless, a function call, or a body with class
+ * restricted attributes.
+ */
+static bool PromiseMayReadClasses(EvalContext *ctx, const Promise *pp)
+{
+    if (strcmp(pp->classes, "any") != 0)
+    {
+        return true;
+    }
 
-        StringSetDestroy(module_tags);
-        free(line);
+    const Policy *policy = PolicyFromPromise(pp);
+    for (size_t i = 0; i < SeqLength(pp->conlist); i++)
+    {
+        const Constraint *cp = SeqAt(pp->conlist, i);
+        if (strcmp(cp->lval, "if") == 0 ||
+            strcmp(cp->lval, "ifvarclass") == 0 ||
+            strcmp(cp->lval, "unless") == 0)
+        {
+            return true;
+        }
 
-#ifdef __MINGW32__
-        if (outsourced)     // only get return value if we waited for command execution
+        const Seq *bodies = NULL;
+        if (cp->rval.type == RVAL_TYPE_SCALAR && cp->references_body)
         {
-            cf_pclose(pfp);
+            bodies = EvalContextResolveConstraintBody(
+                ctx, policy, cp, RvalScalarValue(cp->rval));
         }
-        else
-#endif /* __MINGW32__ */
+        else if (cp->rval.type == RVAL_TYPE_FNCALL)
         {
-            int ret = cf_pclose(pfp);
-
-            if (ret == -1)
+            /* Like classes => if_repaired("x"): a call of a body, unless
+             * there is no such body and it is a function call. */
+            const FnCall *fp = RvalFnCallValue(cp->rval);
+            bodies = EvalContextResolveConstraintBody(ctx, policy, cp, fp->name);
+            if (bodies == NULL)
             {
-                cfPS(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_FAIL, pp, a, "Finished script '%s' - failed (abnormal termination)", pp->promiser);
-                *result = PromiseResultUpdate(*result, PROMISE_RESULT_FAIL);
+                return true;
             }
-            else
+            for (const Rlist *rp = fp->args; rp != NULL; rp = rp->next)
             {
-                VerifyCommandRetcode(ctx, ret, a, pp, result);
+                if (RvalHasFnCall(rp->val))
+                {
+                    return true;
+                }
             }
         }
+        else if (RvalHasFnCall(cp->rval))
+        {
+            return true;
+        }
+
+        if (bodies != NULL && BodiesMayReadClasses(bodies))
+        {
+            return true;
+        }
     }
 
-    if (count)
+    return false;
+}
+
+/**
+ * Whether commands promise #next has to wait for all running commands to
+ * be collected before it is evaluated.
+ */
+static bool ConcurrentExecsBlock(EvalContext *ctx, const Promise *next)
+{
+    if (next == NULL || PromiseGetConstraint(next, "depends_on") != NULL)
     {
-        if (cmdOutBufPos)
+        return true;
+    }
+
+    for (size_t i = 0; i < SeqLength(CONCURRENT_EXECS); i++)
+    {
+        const ConcurrentExec *exec = SeqAt(CONCURRENT_EXECS, i);
+        if (exec->a.haveclasses)
         {
-            Log(LOG_LEVEL_NOTICE, "%s", cmdOutBuf);
+            return PromiseMayReadClasses(ctx, next);
         }
-
-        Log(LOG_LEVEL_INFO, "Last %d quoted lines were generated by promiser '%s'", count, cmdline);
     }
 
-    if (a.contain.timeout != CF_NOINT)
+    return false;
+}
+
+/**
+ * Collects commands started concurrently, oldest first, before commands
+ * promise #next is evaluated: all of them if #next may depend on their
+ * outcome, or is NULL at the end of the commands section, otherwise just
+ * enough to make room for one more.
+ *
+ * @return the combined outcome of the collected promises
+ */
+PromiseResult CollectConcurrentCommands(EvalContext *ctx, const Promise *next)
+{
+    PromiseResult result = PROMISE_RESULT_SKIPPED;
+    if (CONCURRENT_EXECS == NULL || SeqLength(CONCURRENT_EXECS) == 0)
     {
-        alarm(0);
-        signal(SIGALRM, SIG_DFL);
+        return result;
     }
 
-    Log(LOG_LEVEL_INFO, "Completed execution of '%s'", cmdline);
-#ifndef __MINGW32__
-    umask(maskval);
-#endif
+    size_t keep = 0;
+    if (!ConcurrentExecsBlock(ctx, next))
+    {
+        keep = MAX_CONCURRENT_COMMANDS - 1;
+    }
 
-    snprintf(eventname, CF_BUFSIZE - 1, "Exec(%s)", cmdline);
+    size_t collect = 0;
+    if (SeqLength(CONCURRENT_EXECS) > keep)
+    {
+        collect = SeqLength(CONCURRENT_EXECS) - keep;
+    }
 
-#ifndef __MINGW32__
-    if ((a.transaction.background) && outsourced)
+    if (collect > 0)
     {
-        Log(LOG_LEVEL_VERBOSE, "Backgrounded command '%s' is done - exiting", cmdline);
-        exit(EXIT_SUCCESS);
+        for (size_t i = 0; i < collect; i++)
+        {
+            ConcurrentExec *exec = SeqAt(CONCURRENT_EXECS, i);
+            result = PromiseResultUpdate(result, CollectConcurrentExec(ctx, exec));
+        }
+        SeqRemoveRange(CONCURRENT_EXECS, 0, collect - 1);
     }
-#endif /* !__MINGW32__ */
 
-    return ACTION_RESULT_OK;
+    return result;
 }
 
 /*************************************************************/
@@ -29,4 +29,7 @@
 
 PromiseResult VerifyExecPromise(EvalContext *ctx, const Promise *pp);
 
+void SetMaxConcurrentCommands(int max);
+PromiseResult CollectConcurrentCommands(EvalContext *ctx, const Promise *next);
+
 #endif
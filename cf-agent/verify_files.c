@@ -62,9 +62,9 @@ static PromiseResult VerifyFilePromise(EvalContext *ctx, char *path, const Promi
 
 /*****************************************************************************/
 
-static int FileSanityChecks(char *path, Attributes a, const Promise *pp)
+static int FileSanityChecks(char *path, const Attributes *a, const Promise *pp)
 {
-    if ((a.havelink) && (a.havecopy))
+    if ((a->havelink) && (a->havecopy))
     {
         Log(LOG_LEVEL_ERR,
             "Promise constraint conflicts - '%s' file cannot both be a copy of and a link to the source", path);
@@ -76,14 +76,14 @@ static int FileSanityChecks(char *path, Attributes a, const Promise *pp)
      * body, so we can't distinguish between link and copy source. In
      * post-verification all bodies are already expanded, so we don't have the
      * information either */
-    if ((a.havelink) && (!a.link.source))
+    if ((a->havelink) && (!a->link.source))
     {
         Log(LOG_LEVEL_ERR, "Promise to establish a link at '%s' has no source", path);
         PromiseRef(LOG_LEVEL_ERR, pp);
         return false;
     }
 
-    if ((a.haveeditline) && (a.haveeditxml))
+    if ((a->haveeditline) && (a->haveeditxml))
     {
         Log(LOG_LEVEL_ERR, "Promise constraint conflicts - '%s' editing file as both line and xml makes no sense",
               path);
@@ -91,21 +91,21 @@ static int FileSanityChecks(char *path, Attributes a, const Promise *pp)
         return false;
     }
 
-    if ((a.havedepthsearch) && (a.haveedit))
+    if ((a->havedepthsearch) && (a->haveedit))
     {
         Log(LOG_LEVEL_ERR, "Recursive depth_searches are not compatible with general file editing");
         PromiseRef(LOG_LEVEL_ERR, pp);
         return false;
     }
 
-    if ((a.havedelete) && ((a.create) || (a.havecopy) || (a.haveedit) || (a.haverename)))
+    if ((a->havedelete) && ((a->create) || (a->havecopy) || (a->haveedit) || (a->haverename)))
     {
         Log(LOG_LEVEL_ERR, "Promise constraint conflicts - '%s' cannot be deleted and exist at the same time", path);
         PromiseRef(LOG_LEVEL_ERR, pp);
         return false;
     }
 
-    if ((a.haverename) && ((a.create) || (a.havecopy) || (a.haveedit)))
+    if ((a->haverename) && ((a->create) || (a->havecopy) || (a->haveedit)))
     {
         Log(LOG_LEVEL_ERR,
             "Promise constraint conflicts - '%s' cannot be renamed/moved and exist there at the same time", path);
@@ -113,7 +113,7 @@ static int FileSanityChecks(char *path, Attributes a, const Promise *pp)
         return false;
     }
 
-    if ((a.havedelete) && (a.havedepthsearch) && (!a.haveselect))
+    if ((a->havedelete) && (a->havedepthsearch) && (!a->haveselect))
     {
         Log(LOG_LEVEL_ERR,
             "Dangerous or ambiguous promise - '%s' specifies recursive deletion but has no file selection criteria",
@@ -122,21 +122,21 @@ static int FileSanityChecks(char *path, Attributes a, const Promise *pp)
         return false;
     }
 
-    if ((a.haveselect) && (!a.select.result))
+    if ((a->haveselect) && (!a->select.result))
     {
         Log(LOG_LEVEL_ERR, "File select constraint body promised no result (check body definition)");
         PromiseRef(LOG_LEVEL_ERR, pp);
         return false;
     }
 
-    if ((a.havedelete) && (a.haverename))
+    if ((a->havedelete) && (a->haverename))
     {
         Log(LOG_LEVEL_ERR, "File '%s' cannot promise both deletion and renaming", path);
         PromiseRef(LOG_LEVEL_ERR, pp);
         return false;
     }
 
-    if ((a.havecopy) && (a.havedepthsearch) && (a.havedelete))
+    if ((a->havecopy) && (a->havedepthsearch) && (a->havedelete))
     {
         Log(LOG_LEVEL_WARNING,
             "depth_search of '%s' applies to both delete and copy, but these refer to different searches (source/destination)",
@@ -144,14 +144,14 @@ static int FileSanityChecks(char *path, Attributes a, const Promise *pp)
         PromiseRef(LOG_LEVEL_INFO, pp);
     }
 
-    if ((a.transaction.background) && (a.transaction.audit))
+    if ((a->transaction.background) && (a->transaction.audit))
     {
         Log(LOG_LEVEL_ERR, "Auditing cannot be performed on backgrounded promises (this might change).");
         PromiseRef(LOG_LEVEL_ERR, pp);
         return false;
     }
 
-    if (((a.havecopy) || (a.havelink)) && (a.transformer))
+    if (((a->havecopy) || (a->havelink)) && (a->transformer))
     {
         Log(LOG_LEVEL_ERR, "File object(s) '%s' cannot both be a copy of source and transformed simultaneously",
               pp->promiser);
@@ -159,21 +159,21 @@ static int FileSanityChecks(char *path, Attributes a, const Promise *pp)
         return false;
     }
 
-    if ((a.haveselect) && (a.select.result == NULL))
+    if ((a->haveselect) && (a->select.result == NULL))
     {
         Log(LOG_LEVEL_ERR, "Missing file_result attribute in file_select body");
         PromiseRef(LOG_LEVEL_ERR, pp);
         return false;
     }
 
-    if ((a.havedepthsearch) && (a.change.report_diffs))
+    if ((a->havedepthsearch) && (a->change.report_diffs))
     {
         Log(LOG_LEVEL_ERR, "Difference reporting is not allowed during a depth_search");
         PromiseRef(LOG_LEVEL_ERR, pp);
         return false;
     }
 
-    if ((a.haveedit) && (a.file_type) && (!strncmp(a.file_type, "fifo", 5)))
+    if ((a->haveedit) && (a->file_type) && (!strncmp(a->file_type, "fifo", 5)))
     {
         Log(LOG_LEVEL_ERR, "Editing is not allowed on fifos");
         PromiseRef(LOG_LEVEL_ERR, pp);
@@ -183,14 +183,14 @@ static int FileSanityChecks(char *path, Attributes a, const Promise *pp)
     return true;
 }
 
-static bool AttrHasNoAction(Attributes attr)
+static bool AttrHasNoAction(const Attributes *attr)
 {
     /* Hopefully this includes all "actions" for a files promise. See struct
      * Attributes for reference. */
-    if (!(attr.transformer || attr.haverename || attr.havedelete ||
-          attr.havecopy || attr.create || attr.touch || attr.havelink ||
-          attr.haveperms || attr.havechange || attr.acl.acl_entries ||
-          attr.haveedit || attr.haveeditline || attr.haveeditxml))
+    if (!(attr->transformer || attr->haverename || attr->havedelete ||
+          attr->havecopy || attr->create || attr->touch || attr->havelink ||
+          attr->haveperms || attr->havechange || attr->acl.acl_entries ||
+          attr->haveedit || attr->haveeditline || attr->haveeditxml))
     {
         return true;
     }
@@ -278,7 +278,7 @@ static PromiseResult VerifyFilePromise(EvalContext *ctx, char *path, const Promi
 
     Attributes attr = GetFilesAttributes(ctx, pp);
 
-    if (!FileSanityChecks(path, attr, pp))
+    if (!FileSanityChecks(path, &attr, pp))
     {
         ClearFilesAttributes(&attr);
         return PROMISE_RESULT_NOOP;
@@ -299,7 +299,7 @@ static PromiseResult VerifyFilePromise(EvalContext *ctx, char *path, const Promi
     {
         if ((a.create) || (a.touch))
         {
-            if (!CfCreateFile(ctx, path, pp, a, &result))
+            if (!CfCreateFile(ctx, path, pp, &a, &result))
             {
                 goto exit;
             }
@@ -315,7 +315,7 @@ static PromiseResult VerifyFilePromise(EvalContext *ctx, char *path, const Promi
     {
         if ((a.create) || (a.touch))
         {
-            cfPS(ctx, LOG_LEVEL_VERBOSE, PROMISE_RESULT_NOOP, pp, a, "File '%s' exists as promised", path);
+            cfPS(ctx, LOG_LEVEL_VERBOSE, PROMISE_RESULT_NOOP, pp, &a, "File '%s' exists as promised", path);
         }
         exists = true;
         link = true;
@@ -323,7 +323,7 @@ static PromiseResult VerifyFilePromise(EvalContext *ctx, char *path, const Promi
 
     if ((a.havedelete) && (!exists))
     {
-        cfPS(ctx, LOG_LEVEL_VERBOSE, PROMISE_RESULT_NOOP, pp, a, "File '%s' does not exist as promised", path);
+        cfPS(ctx, LOG_LEVEL_VERBOSE, PROMISE_RESULT_NOOP, pp, &a, "File '%s' does not exist as promised", path);
         goto exit;
     }
 
@@ -373,7 +373,7 @@ static PromiseResult VerifyFilePromise(EvalContext *ctx, char *path, const Promi
     {
         if ((a.create) || (a.touch))
         {
-            if (!CfCreateFile(ctx, path, pp, a, &result))
+            if (!CfCreateFile(ctx, path, pp, &a, &result))
             {
                 goto exit;
             }
@@ -426,7 +426,7 @@ static PromiseResult VerifyFilePromise(EvalContext *ctx, char *path, const Promi
     {
         lstat(path, &oslb);     /* if doesn't exist have to stat again anyway */
 
-        DepthSearch(ctx, path, &oslb, 0, a, pp, oslb.st_dev, &result);
+        DepthSearch(ctx, path, &oslb, 0, &a, pp, oslb.st_dev, &result);
 
         /* normally searches do not include the base directory */
 
@@ -437,7 +437,7 @@ static PromiseResult VerifyFilePromise(EvalContext *ctx, char *path, const Promi
             /* Handle this node specially */
 
             a.havedepthsearch = false;
-            DepthSearch(ctx, path, &oslb, 0, a, pp, oslb.st_dev, &result);
+            DepthSearch(ctx, path, &oslb, 0, &a, pp, oslb.st_dev, &result);
             a.havedepthsearch = save_search;
         }
         else
@@ -445,7 +445,7 @@ static PromiseResult VerifyFilePromise(EvalContext *ctx, char *path, const Promi
             /* unless child nodes were repaired, set a promise kept class */
             if (result == PROMISE_RESULT_NOOP)
             {
-                cfPS(ctx, LOG_LEVEL_VERBOSE, PROMISE_RESULT_NOOP, pp, a, "Basedir '%s' not promising anything", path);
+                cfPS(ctx, LOG_LEVEL_VERBOSE, PROMISE_RESULT_NOOP, pp, &a, "Basedir '%s' not promising anything", path);
             }
         }
     }
@@ -454,18 +454,18 @@ static PromiseResult VerifyFilePromise(EvalContext *ctx, char *path, const Promi
 
     if (a.havecopy)
     {
-        result = PromiseResultUpdate(result, ScheduleCopyOperation(ctx, path, a, pp));
+        result = PromiseResultUpdate(result, ScheduleCopyOperation(ctx, path, &a, pp));
     }
 
 /* Phase 2b link after copy in case need file first */
 
     if ((a.havelink) && (a.link.link_children))
     {
-        result = PromiseResultUpdate(result, ScheduleLinkChildrenOperation(ctx, path, a.link.source, 1, a, pp));
+        result = PromiseResultUpdate(result, ScheduleLinkChildrenOperation(ctx, path, a.link.source, 1, &a, pp));
     }
     else if (a.havelink)
     {
-        result = PromiseResultUpdate(result, ScheduleLinkOperation(ctx, path, a.link.source, a, pp));
+        result = PromiseResultUpdate(result, ScheduleLinkOperation(ctx, path, a.link.source, &a, pp));
     }
 
 /* Phase 3 - content editing */
@@ -474,11 +474,11 @@ static PromiseResult VerifyFilePromise(EvalContext *ctx, char *path, const Promi
     {
         if (exists)
         {
-            result = PromiseResultUpdate(result, ScheduleEditOperation(ctx, path, a, pp));
+            result = PromiseResultUpdate(result, ScheduleEditOperation(ctx, path, &a, pp));
         }
         else
         {
-            cfPS(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_FAIL, pp, a, "Promised to edit '%s', but file does not exist", path);
+            cfPS(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_FAIL, pp, &a, "Promised to edit '%s', but file does not exist", path);
             result = PromiseResultUpdate(result, PROMISE_RESULT_FAIL);
         }
     }
@@ -490,18 +490,18 @@ static PromiseResult VerifyFilePromise(EvalContext *ctx, char *path, const Promi
     if (exists && (S_ISREG(osb.st_mode))
         && (!a.haveselect || SelectLeaf(ctx, path, &osb, a.select)))
     {
-        VerifyFileLeaf(ctx, path, &osb, a, pp, &result);
+        VerifyFileLeaf(ctx, path, &osb, &a, pp, &result);
     }
 
     if (!exists && a.havechange)
     {
-        cfPS(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_FAIL, pp, a, "Promised to monitor '%s' for changes, but file does not exist", path);
+        cfPS(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_FAIL, pp, &a, "Promised to monitor '%s' for changes, but file does not exist", path);
         result = PromiseResultUpdate(result, PROMISE_RESULT_FAIL);
     }
 
 exit:
 
-    if (AttrHasNoAction(a))
+    if (AttrHasNoAction(&a))
     {
         Log(LOG_LEVEL_INFO,
             "No action was requested for file '%s'. Maybe a typo in the policy?", path);
@@ -518,18 +518,21 @@ exit:
 /*****************************************************************************/
 
 static PromiseResult RenderTemplateCFEngine(EvalContext *ctx, const Promise *pp,
-                                            const Rlist *bundle_args, Attributes a,
+                                            const Rlist *bundle_args, const Attributes *org_a,
                                             EditContext *edcontext)
 {
+    Attributes a_copy = *org_a; /* modified below */
+    Attributes *a = &a_copy;
+
     PromiseResult result = PROMISE_RESULT_NOOP;
 
     Policy *tmp_policy = PolicyNew();
     Bundle *bp = NULL;
     if ((bp = MakeTemporaryBundleFromTemplate(ctx, tmp_policy, a, pp, &result)))
     {
-        a.haveeditline = true;
+        a->haveeditline = true;
 
-        EvalContextStackPushBundleFrame(ctx, bp, bundle_args, a.edits.inherit);
+        EvalContextStackPushBundleFrame(ctx, bp, bundle_args, a->edits.inherit);
         BundleResolve(ctx, bp);
 
         ScheduleEditLineOperations(ctx, bp, a, pp, edcontext);
@@ -579,14 +582,17 @@ static bool SaveBufferCallback(const char *dest_filename, void *param, NewLineMo
 }
 
 
-static PromiseResult RenderTemplateMustache(EvalContext *ctx, const Promise *pp, Attributes a,
+static PromiseResult RenderTemplateMustache(EvalContext *ctx, const Promise *pp, const Attributes *org_a,
                                             EditContext *edcontext, const char *template)
 {
+    Attributes a_copy = *org_a; /* modified below */
+    Attributes *a = &a_copy;
+
     PromiseResult result = PROMISE_RESULT_NOOP;
 
-    if (a.template_data == NULL)
+    if (a->template_data == NULL)
     {
-        a.template_data = DefaultTemplateData(ctx, NULL);
+        a->template_data = DefaultTemplateData(ctx, NULL);
     }
 
     unsigned char existing_output_digest[EVP_MAX_MD_SIZE + 1] = { 0 };
@@ -598,22 +604,22 @@ static PromiseResult RenderTemplateMustache(EvalContext *ctx, const Promise *pp,
     Buffer *output_buffer = BufferNew();
 
     char *message;
-    if ( strcmp("inline_mustache", a.template_method) == 0)
+    if ( strcmp("inline_mustache", a->template_method) == 0)
     {
         message = xstrdup("inline");
     }
     else
     {
-        message = xstrdup(a.edit_template);
+        message = xstrdup(a->edit_template);
     }
 
-    if (MustacheRender(output_buffer, template, a.template_data))
+    if (MustacheRender(output_buffer, template, a->template_data))
     {
         unsigned char rendered_output_digest[EVP_MAX_MD_SIZE + 1] = { 0 };
         HashString(BufferData(output_buffer), BufferSize(output_buffer), rendered_output_digest, CF_DEFAULT_DIGEST);
         if (!HashesMatch(existing_output_digest, rendered_output_digest, CF_DEFAULT_DIGEST))
         {
-            if (a.transaction.action == cfa_warn || DONTDO)
+            if (a->transaction.action == cfa_warn || DONTDO)
             {
                 Log(LOG_LEVEL_WARNING, "Need to render '%s' from mustache template '%s' but policy is dry-run", pp->promiser, message);
                 result = PromiseResultUpdate(result, PROMISE_RESULT_WARN);
@@ -642,26 +648,26 @@ static PromiseResult RenderTemplateMustache(EvalContext *ctx, const Promise *pp,
     }
     else
     {
-        cfPS(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_FAIL, pp, a, "Error rendering mustache template '%s'", a.edit_template);
+        cfPS(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_FAIL, pp, a, "Error rendering mustache template '%s'", a->edit_template);
         result = PromiseResultUpdate(result, PROMISE_RESULT_FAIL);
         BufferDestroy(output_buffer);
         return PromiseResultUpdate(result, PROMISE_RESULT_FAIL);
     }
 }
 
-static PromiseResult RenderTemplateMustacheFromFile(EvalContext *ctx, const Promise *pp, Attributes a,
+static PromiseResult RenderTemplateMustacheFromFile(EvalContext *ctx, const Promise *pp, const Attributes *a,
                                             EditContext *edcontext)
 {
     PromiseResult result = PROMISE_RESULT_NOOP;
 
-    if (!FileCanOpen(a.edit_template, "r"))
+    if (!FileCanOpen(a->edit_template, "r"))
     {
-        cfPS(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_FAIL, pp, a, "Template file '%s' could not be opened for reading", a.edit_template);
+        cfPS(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_FAIL, pp, a, "Template file '%s' could not be opened for reading", a->edit_template);
         return PromiseResultUpdate(result, PROMISE_RESULT_FAIL);
     }
 
 
-    int template_fd = safe_open(a.edit_template, O_RDONLY | O_TEXT);
+    int template_fd = safe_open(a->edit_template, O_RDONLY | O_TEXT);
     Writer *template_writer = NULL;
     if (template_fd >= 0)
     {
@@ -670,7 +676,7 @@ static PromiseResult RenderTemplateMustacheFromFile(EvalContext *ctx, const Prom
     }
     if (template_writer == NULL)
     {
-        cfPS(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_FAIL, pp, a, "Could not read template file '%s'", a.edit_template);
+        cfPS(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_FAIL, pp, a, "Could not read template file '%s'", a->edit_template);
         return PromiseResultUpdate(result, PROMISE_RESULT_FAIL);
     }
 
@@ -681,11 +687,11 @@ static PromiseResult RenderTemplateMustacheFromFile(EvalContext *ctx, const Prom
     return result;
 }
 
-static PromiseResult RenderTemplateMustacheFromString(EvalContext *ctx, const Promise *pp, Attributes a,
+static PromiseResult RenderTemplateMustacheFromString(EvalContext *ctx, const Promise *pp, const Attributes *a,
                                             EditContext *edcontext)
 {
 
-    if ( a.edit_template_string == NULL  )
+    if ( a->edit_template_string == NULL  )
     {
         PromiseResult result = PROMISE_RESULT_NOOP;
 
@@ -693,10 +699,10 @@ static PromiseResult RenderTemplateMustacheFromString(EvalContext *ctx, const Pr
         return PromiseResultUpdate(result, PROMISE_RESULT_FAIL);
     }
 
-    return  RenderTemplateMustache(ctx, pp, a, edcontext, a.edit_template_string);
+    return  RenderTemplateMustache(ctx, pp, a, edcontext, a->edit_template_string);
 }
 
-PromiseResult ScheduleEditOperation(EvalContext *ctx, char *filename, Attributes a, const Promise *pp)
+PromiseResult ScheduleEditOperation(EvalContext *ctx, char *filename, const Attributes *a, const Promise *pp)
 {
     void *vp;
     FnCall *fp;
@@ -705,7 +711,7 @@ PromiseResult ScheduleEditOperation(EvalContext *ctx, char *filename, Attributes
     CfLock thislock;
 
     snprintf(lockname, CF_BUFSIZE - 1, "fileedit-%s", filename);
-    thislock = AcquireLock(ctx, lockname, VUQNAME, CFSTARTTIME, a.transaction, pp, false);
+    thislock = AcquireLock(ctx, lockname, VUQNAME, CFSTARTTIME, a->transaction, pp, false);
 
     if (thislock.lock == NULL)
     {
@@ -724,7 +730,7 @@ PromiseResult ScheduleEditOperation(EvalContext *ctx, char *filename, Attributes
 
     const Policy *policy = PolicyFromPromise(pp);
 
-    if (a.haveeditline)
+    if (a->haveeditline)
     {
         if ((vp = PromiseGetConstraintAsRval(pp, "edit_line", RVAL_TYPE_FNCALL)))
         {
@@ -747,7 +753,7 @@ PromiseResult ScheduleEditOperation(EvalContext *ctx, char *filename, Attributes
         const Bundle *bp = EvalContextResolveBundleExpression(ctx, policy, edit_bundle_name, "edit_line");
         if (bp)
         {
-            EvalContextStackPushBundleFrame(ctx, bp, args, a.edits.inherit);
+            EvalContextStackPushBundleFrame(ctx, bp, args, a->edits.inherit);
 
             BundleResolve(ctx, bp);
 
@@ -762,7 +768,7 @@ PromiseResult ScheduleEditOperation(EvalContext *ctx, char *filename, Attributes
     }
 
 
-    if (a.haveeditxml)
+    if (a->haveeditxml)
     {
         if ((vp = PromiseGetConstraintAsRval(pp, "edit_xml", RVAL_TYPE_FNCALL)))
         {
@@ -785,7 +791,7 @@ PromiseResult ScheduleEditOperation(EvalContext *ctx, char *filename, Attributes
         const Bundle *bp = EvalContextResolveBundleExpression(ctx, policy, edit_bundle_name, "edit_xml");
         if (bp)
         {
-            EvalContextStackPushBundleFrame(ctx, bp, args, a.edits.inherit);
+            EvalContextStackPushBundleFrame(ctx, bp, args, a->edits.inherit);
             BundleResolve(ctx, bp);
 
             ScheduleEditXmlOperations(ctx, bp, a, pp, edcontext);
@@ -794,34 +800,34 @@ PromiseResult ScheduleEditOperation(EvalContext *ctx, char *filename, Attributes
         }
     }
 
-    if (strcmp("cfengine", a.template_method) == 0)
+    if (strcmp("cfengine", a->template_method) == 0)
     {
-        if (a.edit_template)
+        if (a->edit_template)
         {
             Log(LOG_LEVEL_VERBOSE, "Rendering '%s' using template '%s' with method '%s'",
-                filename, a.edit_template, a.template_method);
+                filename, a->edit_template, a->template_method);
 
             PromiseResult render_result = RenderTemplateCFEngine(ctx, pp, args, a, edcontext);
             result = PromiseResultUpdate(result, render_result);
         }
     }
-    else if (strcmp("mustache", a.template_method) == 0)
+    else if (strcmp("mustache", a->template_method) == 0)
     {
-        if (a.edit_template)
+        if (a->edit_template)
         {
             Log(LOG_LEVEL_VERBOSE, "Rendering '%s' using template '%s' with method '%s'",
-                filename, a.edit_template, a.template_method);
+                filename, a->edit_template, a->template_method);
 
             PromiseResult render_result = RenderTemplateMustacheFromFile(ctx, pp, a, edcontext);
             result = PromiseResultUpdate(result, render_result);
         }
     }
-    else if (strcmp("inline_mustache", a.template_method) == 0)
+    else if (strcmp("inline_mustache", a->template_method) == 0)
     {
-        if (a.edit_template_string)
+        if (a->edit_template_string)
         {
             Log(LOG_LEVEL_VERBOSE, "Rendering '%s' with method '%s'",
-                filename, a.template_method);
+                filename, a->template_method);
 
             PromiseResult render_result = RenderTemplateMustacheFromString(ctx, pp, a, edcontext);
             result = PromiseResultUpdate(result, render_result);
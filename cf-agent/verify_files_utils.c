@@ -64,7 +64,11 @@
 #include <cf-agent-enterprise-stubs.h>
 #include <conn_cache.h>
 #include <stat_cache.h>                      /* remote_stat,StatCacheLookup */
+#include <download_cache.h>
+#include <policy_snapshot.h>
 #include <known_dirs.h>
+#include <map.h>
+#include <buffer.h>
 
 #include <cf-windows-functions.h>
 
@@ -77,42 +81,47 @@ static Item *VSETXIDLIST = NULL;
 const Rlist *SINGLE_COPY_LIST = NULL; /* GLOBAL_P */
 static Rlist *SINGLE_COPY_CACHE = NULL; /* GLOBAL_X */
 
-static bool TransformFile(EvalContext *ctx, char *file, Attributes attr, const Promise *pp, PromiseResult *result);
-static PromiseResult VerifyName(EvalContext *ctx, char *path, struct stat *sb, Attributes attr, const Promise *pp);
+/* Regex lists (exclude_dirs, copy_patterns, ...) compiled into RegexSets,
+ * keyed by their contents. */
+#define REGEX_SETS_MAX 256
+static Map *REGEX_SETS = NULL; /* GLOBAL_X */
+
+static bool TransformFile(EvalContext *ctx, char *file, const Attributes *attr, const Promise *pp, PromiseResult *result);
+static PromiseResult VerifyName(EvalContext *ctx, char *path, struct stat *sb, const Attributes *attr, const Promise *pp);
 static PromiseResult VerifyDelete(EvalContext *ctx,
                                   const char *path, const struct stat *sb,
-                                  Attributes attr, const Promise *pp);
-static PromiseResult VerifyCopy(EvalContext *ctx, const char *source, char *destination, Attributes attr, const Promise *pp,
+                                  const Attributes *attr, const Promise *pp);
+static PromiseResult VerifyCopy(EvalContext *ctx, const char *source, char *destination, const Attributes *attr, const Promise *pp,
                                 CompressedArray **inode_cache, AgentConnection *conn);
-static PromiseResult TouchFile(EvalContext *ctx, char *path, Attributes attr, const Promise *pp);
-static PromiseResult VerifyFileAttributes(EvalContext *ctx, const char *file, struct stat *dstat, Attributes attr, const Promise *pp);
+static PromiseResult TouchFile(EvalContext *ctx, char *path, const Attributes *attr, const Promise *pp);
+static PromiseResult VerifyFileAttributes(EvalContext *ctx, const char *file, struct stat *dstat, const Attributes *attr, const Promise *pp);
 static int PushDirState(EvalContext *ctx, char *name, struct stat *sb);
 static bool PopDirState(int goback, char *name, struct stat *sb, DirectoryRecursion r);
 static bool CheckLinkSecurity(struct stat *sb, char *name);
 static int CompareForFileCopy(char *sourcefile, char *destfile, struct stat *ssb, struct stat *dsb, FileCopy fc, AgentConnection *conn);
 static void FileAutoDefine(EvalContext *ctx, char *destfile);
 static void TruncateFile(char *name);
-static void RegisterAHardLink(int i, char *value, Attributes attr, CompressedArray **inode_cache);
-static PromiseResult VerifyCopiedFileAttributes(EvalContext *ctx, const char *src, const char *dest, struct stat *sstat, struct stat *dstat, Attributes attr, const Promise *pp);
+static void RegisterAHardLink(int i, char *value, const Attributes *attr, CompressedArray **inode_cache);
+static PromiseResult VerifyCopiedFileAttributes(EvalContext *ctx, const char *src, const char *dest, struct stat *sstat, struct stat *dstat, const Attributes *attr, const Promise *pp);
 static int cf_stat(const char *file, struct stat *buf, FileCopy fc, AgentConnection *conn);
 #ifndef __MINGW32__
-static int cf_readlink(EvalContext *ctx, char *sourcefile, char *linkbuf, int buffsize, Attributes attr, const Promise *pp, AgentConnection *conn, PromiseResult *result);
+static int cf_readlink(EvalContext *ctx, char *sourcefile, char *linkbuf, int buffsize, const Attributes *attr, const Promise *pp, AgentConnection *conn, PromiseResult *result);
 #endif
 static int SkipDirLinks(EvalContext *ctx, char *path, const char *lastnode, DirectoryRecursion r);
 static int DeviceBoundary(struct stat *sb, dev_t rootdevice);
-static PromiseResult LinkCopy(EvalContext *ctx, char *sourcefile, char *destfile, struct stat *sb, Attributes attr,
+static PromiseResult LinkCopy(EvalContext *ctx, char *sourcefile, char *destfile, struct stat *sb, const Attributes *attr,
                               const Promise *pp, CompressedArray **inode_cache, AgentConnection *conn);
 
 #ifndef __MINGW32__
 static void LoadSetxid(void);
 static void SaveSetxid(bool modified);
-static PromiseResult VerifySetUidGid(EvalContext *ctx, const char *file, struct stat *dstat, mode_t newperm, const Promise *pp, Attributes attr);
+static PromiseResult VerifySetUidGid(EvalContext *ctx, const char *file, struct stat *dstat, mode_t newperm, const Promise *pp, const Attributes *attr);
 #endif
 #ifdef __APPLE__
-static int VerifyFinderType(EvalContext *ctx, const char *file, Attributes a, const Promise *pp, PromiseResult *result);
+static int VerifyFinderType(EvalContext *ctx, const char *file, const Attributes *a, const Promise *pp, PromiseResult *result);
 #endif
-static void VerifyFileChanges(const char *file, struct stat *sb, Attributes attr, const Promise *pp);
-static PromiseResult VerifyFileIntegrity(EvalContext *ctx, const char *file, Attributes attr, const Promise *pp);
+static void VerifyFileChanges(const char *file, struct stat *sb, const Attributes *attr, const Promise *pp);
+static PromiseResult VerifyFileIntegrity(EvalContext *ctx, const char *file, const Attributes *attr, const Promise *pp);
 
 extern Attributes GetExpandedAttributes(EvalContext *ctx, const Promise *pp, const Attributes *attr);
 extern void ClearExpandedAttributes(Attributes *a);
@@ -122,7 +131,7 @@ void SetFileAutoDefineList(const Rlist *auto_define_list)
     AUTO_DEFINE_LIST = auto_define_list;
 }
 
-void VerifyFileLeaf(EvalContext *ctx, char *path, struct stat *sb, Attributes attr, const Promise *pp, PromiseResult *result)
+void VerifyFileLeaf(EvalContext *ctx, char *path, struct stat *sb, const Attributes *attr, const Promise *pp, PromiseResult *result)
 {
 /* Here we can assume that we are in the parent directory of the leaf */
 
@@ -132,9 +141,10 @@ void VerifyFileLeaf(EvalContext *ctx, char *path, struct stat *sb, Attributes at
 
     EvalContextVariablePutSpecial(ctx, SPECIAL_SCOPE_THIS, "promiser", path, CF_DATA_TYPE_STRING, "source=promise");        // Parameters may only be scalars
     Attributes org_attr = GetFilesAttributes(ctx, pp);
-    attr = GetExpandedAttributes(ctx, pp, &org_attr);
+    Attributes expanded_attr = GetExpandedAttributes(ctx, pp, &org_attr);
+    attr = &expanded_attr;
 
-    if (attr.transformer != NULL)
+    if (attr->transformer != NULL)
     {
         if (!TransformFile(ctx, path, attr, pp, result))
         {
@@ -143,25 +153,25 @@ void VerifyFileLeaf(EvalContext *ctx, char *path, struct stat *sb, Attributes at
     }
     else
     {
-        if (attr.haverename)
+        if (attr->haverename)
         {
             *result = PromiseResultUpdate(*result, VerifyName(ctx, path, sb, attr, pp));
         }
 
-        if (attr.havedelete)
+        if (attr->havedelete)
         {
             *result = PromiseResultUpdate(*result, VerifyDelete(ctx, path, sb, attr, pp));
         }
 
-        if (attr.touch)
+        if (attr->touch)
         {
             *result = PromiseResultUpdate(*result, TouchFile(ctx, path, attr, pp)); // intrinsically non-convergent op
         }
     }
 
-    if (attr.haveperms || attr.havechange || attr.acl.acl_entries)
+    if (attr->haveperms || attr->havechange || attr->acl.acl_entries)
     {
-        if (S_ISDIR(sb->st_mode) && attr.recursion.depth && !attr.recursion.include_basedir &&
+        if (S_ISDIR(sb->st_mode) && attr->recursion.depth && !attr->recursion.include_basedir &&
             (strcmp(path, pp->promiser) == 0))
         {
             Log(LOG_LEVEL_VERBOSE, "Promise to skip base directory '%s'", path);
@@ -171,12 +181,61 @@ void VerifyFileLeaf(EvalContext *ctx, char *path, struct stat *sb, Attributes at
             *result = PromiseResultUpdate(*result, VerifyFileAttributes(ctx, path, sb, attr, pp));
         }
     }
-    ClearExpandedAttributes(&attr);
+    ClearExpandedAttributes(&expanded_attr);
+}
+
+static void RegexSetDestroy_untyped(void *set)
+{
+    RegexSetDestroy(set);
+}
+
+static const RegexSet *RlistRegexSet(const Rlist *listofregex)
+{
+    Buffer *key = BufferNew();
+    for (const Rlist *rp = listofregex; rp != NULL; rp = rp->next)
+    {
+        const char *regex = RlistScalarValue(rp);
+        BufferAppendF(key, "%zu:%s", strlen(regex), regex);
+    }
+
+    if (REGEX_SETS == NULL)
+    {
+        REGEX_SETS = MapNew(StringHash_untyped, StringSafeEqual_untyped,
+                            free, RegexSetDestroy_untyped);
+    }
+
+    RegexSet *set = MapGet(REGEX_SETS, BufferData(key));
+    if (set != NULL)
+    {
+        BufferDestroy(key);
+        return set;
+    }
+
+    if (MapSize(REGEX_SETS) >= REGEX_SETS_MAX)
+    {
+        MapClear(REGEX_SETS);
+    }
+
+    Seq *regexes = SeqNew(RlistLen(listofregex), NULL);
+    for (const Rlist *rp = listofregex; rp != NULL; rp = rp->next)
+    {
+        SeqAppend(regexes, RlistScalarValue(rp));
+    }
+    set = RegexSetNew(regexes);
+    SeqDestroy(regexes);
+
+    MapInsert(REGEX_SETS, BufferClose(key), set);
+    return set;
 }
 
 /* Checks whether item matches a list of wildcards */
 static int MatchRlistItem(EvalContext *ctx, const Rlist *listofregex, const char *teststring)
 {
+    if (listofregex == NULL)
+    {
+        return false;
+    }
+
     for (const Rlist *rp = listofregex; rp != NULL; rp = rp->next)
     {
         /* Avoid using regex if possible, due to memory leak */
@@ -185,25 +244,35 @@ static int MatchRlistItem(EvalContext *ctx, const Rlist *listofregex, const char
         {
             return (true);
         }
+    }
 
-        /* Make it commutative */
-
-        if (FullTextMatch(ctx, RlistScalarValue(rp), teststring))
-        {
-            return true;
-        }
+    /* All of the list at once, instead of one regex after another. */
+    int i = RegexSetMatchFull(RlistRegexSet(listofregex), teststring);
+    if (i < 0)
+    {
+        return false;
     }
 
-    return false;
+    /* Once more with the matching one, to set the match variables. */
+    const Rlist *rp = listofregex;
+    for (; i > 0; i--)
+    {
+        rp = rp->next;
+    }
+    FullTextMatch(ctx, RlistScalarValue(rp), teststring);
+    return true;
 }
 
 /* (conn == NULL) then copy is from localhost. */
 static PromiseResult CfCopyFile(EvalContext *ctx, char *sourcefile,
                                 char *destfile, struct stat ssb,
-                                Attributes attr, const Promise *pp,
+                                const Attributes *org_attr, const Promise *pp,
                                 CompressedArray **inode_cache,
                                 AgentConnection *conn)
 {
+    Attributes attr_copy = *org_attr; /* modified below */
+    Attributes *attr = &attr_copy;
+
     const char *lastnode;
     struct stat dsb;
     int found;
@@ -220,7 +289,7 @@ static PromiseResult CfCopyFile(EvalContext *ctx, char *sourcefile,
     }
 
 #ifdef __MINGW32__
-    if (attr.copy.copy_links != NULL)
+    if (attr->copy.copy_links != NULL)
     {
         Log(LOG_LEVEL_VERBOSE,
             "copy_from.copylink_patterns is ignored on Windows "
@@ -228,7 +297,7 @@ static PromiseResult CfCopyFile(EvalContext *ctx, char *sourcefile,
     }
 #endif /* __MINGW32__ */
 
-    attr.link.when_no_file = cfa_force;
+    attr->link.when_no_file = cfa_force;
 
     if (strcmp(sourcefile, destfile) == 0 &&
         strcmp(server, "localhost") == 0)
@@ -239,7 +308,7 @@ static PromiseResult CfCopyFile(EvalContext *ctx, char *sourcefile,
         return PROMISE_RESULT_NOOP;
     }
 
-    if (attr.haveselect && !SelectLeaf(ctx, sourcefile, &ssb, attr.select))
+    if (attr->haveselect && !SelectLeaf(ctx, sourcefile, &ssb, attr->select))
     {
         Log(LOG_LEVEL_DEBUG, "Skipping non-selected file '%s'", sourcefile);
         return PROMISE_RESULT_NOOP;
@@ -251,13 +320,13 @@ static PromiseResult CfCopyFile(EvalContext *ctx, char *sourcefile,
         return PROMISE_RESULT_NOOP;
     }
 
-    if (attr.copy.link_type != FILE_LINK_TYPE_NONE)
+    if (attr->copy.link_type != FILE_LINK_TYPE_NONE)
     {
         lastnode = ReadLastNode(sourcefile);
 
-        if (MatchRlistItem(ctx, attr.copy.link_instead, lastnode))
+        if (MatchRlistItem(ctx, attr->copy.link_instead, lastnode))
         {
-            if (MatchRlistItem(ctx, attr.copy.copy_links, lastnode))
+            if (MatchRlistItem(ctx, attr->copy.copy_links, lastnode))
             {
                 Log(LOG_LEVEL_INFO,
                     "File %s matches both copylink_patterns and linkcopy_patterns"
@@ -285,12 +354,12 @@ static PromiseResult CfCopyFile(EvalContext *ctx, char *sourcefile,
 
     if (found != -1)
     {
-        if ((S_ISLNK(dsb.st_mode) && attr.copy.link_type == FILE_LINK_TYPE_NONE)
+        if ((S_ISLNK(dsb.st_mode) && attr->copy.link_type == FILE_LINK_TYPE_NONE)
             || (S_ISLNK(dsb.st_mode) && !S_ISLNK(ssb.st_mode)))
         {
             if (!S_ISLNK(ssb.st_mode) &&
-                attr.copy.type_check &&
-                attr.copy.link_type != FILE_LINK_TYPE_NONE)
+                attr->copy.type_check &&
+                attr->copy.link_type != FILE_LINK_TYPE_NONE)
             {
                 cfPS(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_FAIL, pp, attr,
                      "File image exists but destination type is silly "
@@ -327,10 +396,10 @@ static PromiseResult CfCopyFile(EvalContext *ctx, char *sourcefile,
         MakeParentDirectory(destfile, true);
     }
 
-    if (attr.copy.min_size != CF_NOINT)
+    if (attr->copy.min_size != CF_NOINT)
     {
-        if ((ssb.st_size < attr.copy.min_size)
-            || (ssb.st_size > attr.copy.max_size))
+        if ((ssb.st_size < attr->copy.min_size)
+            || (ssb.st_size > attr->copy.max_size))
         {
             cfPS(ctx, LOG_LEVEL_VERBOSE, PROMISE_RESULT_NOOP, pp, attr,
                  "Source file '%s' size is not in the permitted safety range",
@@ -342,7 +411,7 @@ static PromiseResult CfCopyFile(EvalContext *ctx, char *sourcefile,
     PromiseResult result = PROMISE_RESULT_NOOP;
     if (found == -1)
     {
-        if (attr.transaction.action == cfa_warn)
+        if (attr->transaction.action == cfa_warn)
         {
             cfPS(ctx, LOG_LEVEL_WARNING, PROMISE_RESULT_WARN, pp, attr,
                  "Image file '%s' is non-existent and should be a copy of '%s'",
@@ -351,7 +420,7 @@ static PromiseResult CfCopyFile(EvalContext *ctx, char *sourcefile,
         }
 
         if (S_ISREG(srcmode) ||
-            (S_ISLNK(srcmode) && attr.copy.link_type == FILE_LINK_TYPE_NONE))
+            (S_ISLNK(srcmode) && attr->copy.link_type == FILE_LINK_TYPE_NONE))
         {
             if (DONTDO)
             {
@@ -370,7 +439,7 @@ static PromiseResult CfCopyFile(EvalContext *ctx, char *sourcefile,
                     server, sourcefile);
             }
 
-            if (S_ISLNK(srcmode) && attr.copy.link_type != FILE_LINK_TYPE_NONE)
+            if (S_ISLNK(srcmode) && attr->copy.link_type != FILE_LINK_TYPE_NONE)
             {
                 Log(LOG_LEVEL_VERBOSE, "'%s' is a symbolic link", sourcefile);
                 result = PromiseResultUpdate(
@@ -467,7 +536,7 @@ static PromiseResult CfCopyFile(EvalContext *ctx, char *sourcefile,
 #endif /* !__MINGW32__ */
         }
 
-        if ((S_ISLNK(srcmode)) && (attr.copy.link_type != FILE_LINK_TYPE_NONE))
+        if ((S_ISLNK(srcmode)) && (attr->copy.link_type != FILE_LINK_TYPE_NONE))
         {
             result = PromiseResultUpdate(
                 result, LinkCopy(ctx, sourcefile, destfile, &ssb,
@@ -481,25 +550,25 @@ static PromiseResult CfCopyFile(EvalContext *ctx, char *sourcefile,
         Log(LOG_LEVEL_VERBOSE, "Destination file '%s' already exists",
             destfile);
 
-        if (attr.copy.compare == FILE_COMPARATOR_EXISTS)
+        if (attr->copy.compare == FILE_COMPARATOR_EXISTS)
         {
             Log(LOG_LEVEL_VERBOSE,
                 "Existence only is promised, no copying required");
             return result;
         }
 
-        if (!attr.copy.force_update)
+        if (!attr->copy.force_update)
         {
             ok_to_copy = CompareForFileCopy(sourcefile, destfile, &ssb,
-                                            &dsb, attr.copy, conn);
+                                            &dsb, attr->copy, conn);
         }
         else
         {
             ok_to_copy = true;
         }
 
-        if (attr.copy.type_check &&
-            attr.copy.link_type != FILE_LINK_TYPE_NONE)
+        if (attr->copy.type_check &&
+            attr->copy.link_type != FILE_LINK_TYPE_NONE)
         {
             if (((S_ISDIR(dsb.st_mode)) && (!S_ISDIR(ssb.st_mode))) ||
                 ((S_ISREG(dsb.st_mode)) && (!S_ISREG(ssb.st_mode))) ||
@@ -518,7 +587,7 @@ static PromiseResult CfCopyFile(EvalContext *ctx, char *sourcefile,
             }
         }
 
-        if (ok_to_copy && (attr.transaction.action == cfa_warn))
+        if (ok_to_copy && (attr->transaction.action == cfa_warn))
         {
             cfPS(ctx, LOG_LEVEL_WARNING, PROMISE_RESULT_WARN, pp, attr,
                  "Image file '%s' exists but is not up to date wrt '%s' "
@@ -528,12 +597,12 @@ static PromiseResult CfCopyFile(EvalContext *ctx, char *sourcefile,
             return result;
         }
 
-        if (attr.copy.force_update ||
+        if (attr->copy.force_update ||
             ok_to_copy ||
             S_ISLNK(ssb.st_mode))                     /* Always check links */
         {
             if (S_ISREG(srcmode) ||
-                attr.copy.link_type == FILE_LINK_TYPE_NONE)
+                attr->copy.link_type == FILE_LINK_TYPE_NONE)
             {
                 if (DONTDO)
                 {
@@ -619,7 +688,7 @@ static PromiseResult CfCopyFile(EvalContext *ctx, char *sourcefile,
     return result;
 }
 
-static PromiseResult PurgeLocalFiles(EvalContext *ctx, Item *filelist, const char *localdir, Attributes attr,
+static PromiseResult PurgeLocalFiles(EvalContext *ctx, Item *filelist, const char *localdir, const Attributes *attr,
                                      const Promise *pp, AgentConnection *conn)
 {
     Dir *dirh;
@@ -641,7 +710,7 @@ static PromiseResult PurgeLocalFiles(EvalContext *ctx, Item *filelist, const cha
         return PROMISE_RESULT_NOOP;
     }
 
-    if (!attr.havedepthsearch)
+    if (!attr->havedepthsearch)
     {
         Log(LOG_LEVEL_VERBOSE, "No depth search when copying '%s' so purging does not apply", localdir);
         return PROMISE_RESULT_NOOP;
@@ -680,7 +749,7 @@ static PromiseResult PurgeLocalFiles(EvalContext *ctx, Item *filelist, const cha
                 Log(LOG_LEVEL_ERR, "Path name is too long in PurgeLocalFiles");
             }
 
-            if (DONTDO || attr.transaction.action == cfa_warn)
+            if (DONTDO || attr->transaction.action == cfa_warn)
             {
                 Log(LOG_LEVEL_WARNING, "Need to purge '%s' from copy dest directory", filename);
                 result = PromiseResultUpdate(result, PROMISE_RESULT_WARN);
@@ -725,7 +794,7 @@ static PromiseResult PurgeLocalFiles(EvalContext *ctx, Item *filelist, const cha
     return result;
 }
 
-static PromiseResult SourceSearchAndCopy(EvalContext *ctx, const char *from, char *to, int maxrecurse, Attributes attr,
+static PromiseResult SourceSearchAndCopy(EvalContext *ctx, const char *from, char *to, int maxrecurse, const Attributes *attr,
                                          const Promise *pp, dev_t rootdevice, CompressedArray **inode_cache, AgentConnection *conn)
 {
     struct stat sb, dsb;
@@ -752,14 +821,14 @@ static PromiseResult SourceSearchAndCopy(EvalContext *ctx, const char *from, cha
     AddSlash(newto);
     strcat(newto, "dummy");
 
-    if (attr.transaction.action != cfa_warn)
+    if (attr->transaction.action != cfa_warn)
     {
         struct stat tostat;
 
-        if (!MakeParentDirectory(newto, attr.move_obstructions))
+        if (!MakeParentDirectory(newto, attr->move_obstructions))
         {
             cfPS(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_FAIL, pp, attr, "Unable to make directory for '%s' in file-copy '%s' to '%s'", newto,
-                 attr.copy.source, attr.copy.destination);
+                 attr->copy.source, attr->copy.destination);
             return PROMISE_RESULT_FAIL;
         }
 
@@ -779,7 +848,7 @@ static PromiseResult SourceSearchAndCopy(EvalContext *ctx, const char *from, cha
             char backup[CF_BUFSIZE];
             mode_t mask;
 
-            if (!attr.move_obstructions)
+            if (!attr->move_obstructions)
             {
                 Log(LOG_LEVEL_INFO, "Path '%s' is a symlink. Unable to move it aside without move_obstructions is set",
                       to);
@@ -808,7 +877,7 @@ static PromiseResult SourceSearchAndCopy(EvalContext *ctx, const char *from, cha
     }
 
     /* Send OPENDIR command. */
-    if ((dirh = AbstractDirOpen(from, attr.copy, conn)) == NULL)
+    if ((dirh = AbstractDirOpen(from, attr->copy, conn)) == NULL)
     {
         cfPS(ctx, LOG_LEVEL_INFO, PROMISE_RESULT_INTERRUPTED, pp, attr, "copy can't open directory '%s'", from);
         return PROMISE_RESULT_INTERRUPTED;
@@ -821,7 +890,7 @@ static PromiseResult SourceSearchAndCopy(EvalContext *ctx, const char *from, cha
     for (dirp = AbstractDirRead(dirh); dirp != NULL; dirp = AbstractDirRead(dirh))
     {
         /* This sends 1st STAT command. */
-        if (!ConsiderAbstractFile(dirp->d_name, from, attr.copy, conn))
+        if (!ConsiderAbstractFile(dirp->d_name, from, attr->copy, conn))
         {
             if (conn != NULL &&
                 conn->conn_info->status != CONNECTIONINFO_STATUS_ESTABLISHED)
@@ -837,7 +906,7 @@ static PromiseResult SourceSearchAndCopy(EvalContext *ctx, const char *from, cha
             }
         }
 
-        if (attr.copy.purge)
+        if (attr->copy.purge)
         {
             /* Append this file to the list of files not to purge */
             AppendItem(&namecache, dirp->d_name, NULL);
@@ -858,12 +927,12 @@ static PromiseResult SourceSearchAndCopy(EvalContext *ctx, const char *from, cha
 
         /* This issues a 2nd STAT command, hopefully served from cache. */
 
-        if ((attr.recursion.travlinks) || (attr.copy.link_type == FILE_LINK_TYPE_NONE))
+        if ((attr->recursion.travlinks) || (attr->copy.link_type == FILE_LINK_TYPE_NONE))
         {
             /* No point in checking if there are untrusted symlinks here,
                since this is from a trusted source, by definition */
 
-            if (cf_stat(newfrom, &sb, attr.copy, conn) == -1)
+            if (cf_stat(newfrom, &sb, attr->copy, conn) == -1)
             {
                 Log(LOG_LEVEL_VERBOSE, "Can't stat '%s'. (cf_stat: %s)", newfrom, GetErrorStr());
                 if (conn != NULL &&
@@ -882,7 +951,7 @@ static PromiseResult SourceSearchAndCopy(EvalContext *ctx, const char *from, cha
         }
         else
         {
-            if (cf_lstat(newfrom, &sb, attr.copy, conn) == -1)
+            if (cf_lstat(newfrom, &sb, attr->copy, conn) == -1)
             {
                 Log(LOG_LEVEL_VERBOSE, "Can't stat '%s'. (cf_stat: %s)", newfrom, GetErrorStr());
                 if (conn != NULL &&
@@ -904,8 +973,8 @@ static PromiseResult SourceSearchAndCopy(EvalContext *ctx, const char *from, cha
         /* If "collapse_destination_dir" is set, we skip subdirectories, which
          * means we are not creating them in the destination folder. */
 
-        if (!attr.copy.collapse ||
-            (attr.copy.collapse && !S_ISDIR(sb.st_mode)))
+        if (!attr->copy.collapse ||
+            (attr->copy.collapse && !S_ISDIR(sb.st_mode)))
         {
             if (!PathAppend(newto, sizeof(newto), dirp->d_name,
                             FILE_SEPARATOR))
@@ -919,7 +988,7 @@ static PromiseResult SourceSearchAndCopy(EvalContext *ctx, const char *from, cha
             }
         }
 
-        if ((attr.recursion.xdev) && (DeviceBoundary(&sb, rootdevice)))
+        if ((attr->recursion.xdev) && (DeviceBoundary(&sb, rootdevice)))
         {
             Log(LOG_LEVEL_VERBOSE, "Skipping '%s' on different device", newfrom);
             continue;
@@ -927,13 +996,13 @@ static PromiseResult SourceSearchAndCopy(EvalContext *ctx, const char *from, cha
 
         if (S_ISDIR(sb.st_mode))
         {
-            if (attr.recursion.travlinks)
+            if (attr->recursion.travlinks)
             {
                 Log(LOG_LEVEL_VERBOSE, "Traversing directory links during copy is too dangerous, pruned");
                 continue;
             }
 
-            if (SkipDirLinks(ctx, newfrom, dirp->d_name, attr.recursion))
+            if (SkipDirLinks(ctx, newfrom, dirp->d_name, attr->recursion))
             {
                 continue;
             }
@@ -942,7 +1011,7 @@ static PromiseResult SourceSearchAndCopy(EvalContext *ctx, const char *from, cha
 
             /* Only copy dirs if we are tracking subdirs */
 
-            if ((!attr.copy.collapse) && (stat(newto, &dsb) == -1))
+            if ((!attr->copy.collapse) && (stat(newto, &dsb) == -1))
             {
                 if (mkdir(newto, 0700) == -1)
                 {
@@ -963,7 +1032,7 @@ static PromiseResult SourceSearchAndCopy(EvalContext *ctx, const char *from, cha
 
             Log(LOG_LEVEL_VERBOSE, "Entering '%s'", newto);
 
-            if (!attr.copy.collapse)
+            if (!attr->copy.collapse)
             {
                 VerifyCopiedFileAttributes(ctx, newfrom, newto, &sb, &dsb, attr, pp);
             }
@@ -986,7 +1055,7 @@ static PromiseResult SourceSearchAndCopy(EvalContext *ctx, const char *from, cha
         }
     }
 
-    if (attr.copy.purge)
+    if (attr->copy.purge)
     {
         PurgeLocalFiles(ctx, namecache, to, attr, pp, conn);
         DeleteItemList(namecache);
@@ -999,7 +1068,7 @@ static PromiseResult SourceSearchAndCopy(EvalContext *ctx, const char *from, cha
 
 static PromiseResult VerifyCopy(EvalContext *ctx,
                                 const char *source, char *destination,
-                                Attributes attr, const Promise *pp,
+                                const Attributes *attr, const Promise *pp,
                                 CompressedArray **inode_cache,
                                 AgentConnection *conn)
 {
@@ -1012,14 +1081,14 @@ static PromiseResult VerifyCopy(EvalContext *ctx,
     const struct dirent *dirp;
     int found;
 
-    if (attr.copy.link_type == FILE_LINK_TYPE_NONE)
+    if (attr->copy.link_type == FILE_LINK_TYPE_NONE)
     {
         Log(LOG_LEVEL_DEBUG, "Treating links as files for '%s'", source);
-        found = cf_stat(source, &ssb, attr.copy, conn);
+        found = cf_stat(source, &ssb, attr->copy, conn);
     }
     else
     {
-        found = cf_lstat(source, &ssb, attr.copy, conn);
+        found = cf_lstat(source, &ssb, attr->copy, conn);
     }
 
     if (found == -1)
@@ -1043,7 +1112,7 @@ static PromiseResult VerifyCopy(EvalContext *ctx,
         strcpy(destdir, destination);
         AddSlash(destdir);
 
-        if ((dirh = AbstractDirOpen(sourcedir, attr.copy, conn)) == NULL)
+        if ((dirh = AbstractDirOpen(sourcedir, attr->copy, conn)) == NULL)
         {
             cfPS(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_FAIL, pp, attr,
                  "Can't open directory '%s'. (opendir: %s)",
@@ -1074,7 +1143,7 @@ static PromiseResult VerifyCopy(EvalContext *ctx,
              dirp = AbstractDirRead(dirh))
         {
             if (!ConsiderAbstractFile(dirp->d_name, sourcedir,
-                                      attr.copy, conn))
+                                      attr->copy, conn))
             {
                 if (conn != NULL &&
                     conn->conn_info->status != CONNECTIONINFO_STATUS_ESTABLISHED)
@@ -1107,9 +1176,9 @@ static PromiseResult VerifyCopy(EvalContext *ctx,
                 FatalError(ctx, "VerifyCopy destfile buffer limit");
             }
 
-            if (attr.copy.link_type == FILE_LINK_TYPE_NONE)
+            if (attr->copy.link_type == FILE_LINK_TYPE_NONE)
             {
-                if (cf_stat(sourcefile, &ssb, attr.copy, conn) == -1)
+                if (cf_stat(sourcefile, &ssb, attr->copy, conn) == -1)
                 {
                     cfPS(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_FAIL, pp, attr,
                          "Can't stat source file (notlinked) '%s'. (stat: %s)",
@@ -1119,7 +1188,7 @@ static PromiseResult VerifyCopy(EvalContext *ctx,
             }
             else
             {
-                if (cf_lstat(sourcefile, &ssb, attr.copy, conn) == -1)
+                if (cf_lstat(sourcefile, &ssb, attr->copy, conn) == -1)
                 {
                     cfPS(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_FAIL, pp, attr,
                          "Can't stat source file '%s'. (lstat: %s)",
@@ -1146,7 +1215,7 @@ static PromiseResult VerifyCopy(EvalContext *ctx,
     }
 }
 
-static PromiseResult LinkCopy(EvalContext *ctx, char *sourcefile, char *destfile, struct stat *sb, Attributes attr, const Promise *pp,
+static PromiseResult LinkCopy(EvalContext *ctx, char *sourcefile, char *destfile, struct stat *sb, const Attributes *attr, const Promise *pp,
                               CompressedArray **inode_cache, AgentConnection *conn)
 /* Link the file to the source, instead of copying */
 #ifdef __MINGW32__
@@ -1173,7 +1242,7 @@ static PromiseResult LinkCopy(EvalContext *ctx, char *sourcefile, char *destfile
     {
         Log(LOG_LEVEL_VERBOSE, "Checking link from '%s' to '%s'", destfile, linkbuf);
 
-        if ((attr.copy.link_type == FILE_LINK_TYPE_ABSOLUTE) && (!IsAbsoluteFileName(linkbuf)))        /* Not absolute path - must fix */
+        if ((attr->copy.link_type == FILE_LINK_TYPE_ABSOLUTE) && (!IsAbsoluteFileName(linkbuf)))        /* Not absolute path - must fix */
         {
             char vbuff[CF_BUFSIZE];
 
@@ -1191,7 +1260,7 @@ static PromiseResult LinkCopy(EvalContext *ctx, char *sourcefile, char *destfile
 
     lastnode = ReadLastNode(sourcefile);
 
-    if (MatchRlistItem(ctx, attr.copy.copy_links, lastnode))
+    if (MatchRlistItem(ctx, attr->copy.copy_links, lastnode))
     {
         struct stat ssb;
 
@@ -1203,7 +1272,7 @@ static PromiseResult LinkCopy(EvalContext *ctx, char *sourcefile, char *destfile
     }
 
     int status;
-    switch (attr.copy.link_type)
+    switch (attr->copy.link_type)
     {
     case FILE_LINK_TYPE_SYMLINK:
 
@@ -1230,7 +1299,7 @@ static PromiseResult LinkCopy(EvalContext *ctx, char *sourcefile, char *destfile
         break;
 
     default:
-        ProgrammingError("Unhandled link type in switch: %d", attr.copy.link_type);
+        ProgrammingError("Unhandled link type in switch: %d", attr->copy.link_type);
     }
 
     if ((status == PROMISE_RESULT_CHANGE) || (status == PROMISE_RESULT_NOOP))
@@ -1266,7 +1335,7 @@ static PromiseResult LinkCopy(EvalContext *ctx, char *sourcefile, char *destfile
 #endif /* !__MINGW32__ */
 
 bool CopyRegularFile(EvalContext *ctx, const char *source, const char *dest, struct stat sstat, struct stat dstat,
-                     Attributes attr, const Promise *pp, CompressedArray **inode_cache,
+                     const Attributes *attr, const Promise *pp, CompressedArray **inode_cache,
                      AgentConnection *conn, PromiseResult *result)
 {
     char backup[CF_BUFSIZE];
@@ -1291,7 +1360,7 @@ bool CopyRegularFile(EvalContext *ctx, const char *source, const char *dest, str
     int rsrcfork = 0;
 #endif
 
-    discardbackup = ((attr.copy.backup == BACKUP_OPTION_NO_BACKUP) || (attr.copy.backup == BACKUP_OPTION_REPOSITORY_STORE));
+    discardbackup = ((attr->copy.backup == BACKUP_OPTION_NO_BACKUP) || (attr->copy.backup == BACKUP_OPTION_REPOSITORY_STORE));
 
     if (DONTDO)
     {
@@ -1315,8 +1384,8 @@ bool CopyRegularFile(EvalContext *ctx, const char *source, const char *dest, str
 
     if (conn != NULL)
     {
-        assert(attr.copy.servers && strcmp(RlistScalarValue(attr.copy.servers), "localhost"));
-        Log(LOG_LEVEL_DEBUG, "This is a remote copy from server '%s'", RlistScalarValue(attr.copy.servers));
+        assert(attr->copy.servers && strcmp(RlistScalarValue(attr->copy.servers), "localhost"));
+        Log(LOG_LEVEL_DEBUG, "This is a remote copy from server '%s'", RlistScalarValue(attr->copy.servers));
         remote = true;
     }
 
@@ -1357,9 +1426,18 @@ bool CopyRegularFile(EvalContext *ctx, const char *source, const char *dest, str
             return false;
         }
 
-        if (!CopyRegularFileNet(source, new, sstat.st_size, attr.copy.encrypt, conn))
+        /* Another promise may have downloaded it already during this run. */
+        if (!DownloadCache_Fetch(conn->this_server, conn->this_port,
+                                 source, &sstat, new))
         {
-            return false;
+            if (!CopyRegularFileNet(source, new, sstat.st_size,
+                                    attr->copy.encrypt, conn))
+            {
+                return false;
+            }
+
+            DownloadCache_Store(conn->this_server, conn->this_port,
+                                source, &sstat, new);
         }
     }
     else
@@ -1371,7 +1449,7 @@ bool CopyRegularFile(EvalContext *ctx, const char *source, const char *dest, str
             return false;
         }
 
-        if (attr.copy.stealth)
+        if (attr->copy.stealth)
         {
 #ifdef HAVE_UTIME_H
             timebuf.actime = sstat.st_atime;
@@ -1394,7 +1472,7 @@ bool CopyRegularFile(EvalContext *ctx, const char *source, const char *dest, str
 
         strlcpy(backup, dest, CF_BUFSIZE);
 
-        if (attr.copy.backup == BACKUP_OPTION_TIMESTAMP)
+        if (attr->copy.backup == BACKUP_OPTION_TIMESTAMP)
         {
             stampnow = time((time_t *) NULL);
             snprintf(stamp, CF_BUFSIZE - 1, "_%lu_%s", CFSTARTTIME, CanonifyName(ctime(&stampnow)));
@@ -1468,11 +1546,11 @@ bool CopyRegularFile(EvalContext *ctx, const char *source, const char *dest, str
         return false;
     }
 
-    if (attr.copy.verify)
+    if (attr->copy.verify)
     {
         Log(LOG_LEVEL_VERBOSE, "Final verification of transmission ...");
 
-        if (CompareFileHashes(source, new, &sstat, &dstat, attr.copy, conn))
+        if (CompareFileHashes(source, new, &sstat, &dstat, attr->copy, conn))
         {
             cfPS(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_FAIL, pp, attr,
                  "New file '%s' seems to have been corrupted in transit, aborting.", new);
@@ -1598,7 +1676,7 @@ bool CopyRegularFile(EvalContext *ctx, const char *source, const char *dest, str
         unlink(backup);
     }
 
-    if (attr.copy.stealth)
+    if (attr->copy.stealth)
     {
 #ifdef HAVE_UTIME_H
         timebuf.actime = sstat.st_atime;
@@ -1610,23 +1688,23 @@ bool CopyRegularFile(EvalContext *ctx, const char *source, const char *dest, str
     return true;
 }
 
-static bool TransformFile(EvalContext *ctx, char *file, Attributes attr, const Promise *pp, PromiseResult *result)
+static bool TransformFile(EvalContext *ctx, char *file, const Attributes *attr, const Promise *pp, PromiseResult *result)
 {
     FILE *pop = NULL;
     int transRetcode = 0;
 
-    if (attr.transformer == NULL || file == NULL)
+    if (attr->transformer == NULL || file == NULL)
     {
         return false;
     }
 
     Buffer *command = BufferNew();
-    ExpandScalar(ctx, PromiseGetBundle(pp)->ns, PromiseGetBundle(pp)->name, attr.transformer, command);
+    ExpandScalar(ctx, PromiseGetBundle(pp)->ns, PromiseGetBundle(pp)->name, attr->transformer, command);
     Log(LOG_LEVEL_INFO, "Transforming '%s' ", BufferData(command));
 
     if (!IsExecutable(CommandArg0(BufferData(command))))
     {
-        cfPS(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_FAIL, pp, attr, "Transformer '%s' for file '%s' failed", attr.transformer, file);
+        cfPS(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_FAIL, pp, attr, "Transformer '%s' for file '%s' failed", attr->transformer, file);
         *result = PromiseResultUpdate(*result, PROMISE_RESULT_FAIL);
         BufferDestroy(command);
         return false;
@@ -1634,7 +1712,7 @@ static bool TransformFile(EvalContext *ctx, char *file, Attributes attr, const P
 
     if (!DONTDO)
     {
-        CfLock thislock = AcquireLock(ctx, BufferData(command), VUQNAME, CFSTARTTIME, attr.transaction, pp, false);
+        CfLock thislock = AcquireLock(ctx, BufferData(command), VUQNAME, CFSTARTTIME, attr->transaction, pp, false);
 
         if (thislock.lock == NULL)
         {
@@ -1644,7 +1722,7 @@ static bool TransformFile(EvalContext *ctx, char *file, Attributes attr, const P
 
         if ((pop = cf_popen(BufferData(command), "r", true)) == NULL)
         {
-            cfPS(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_FAIL, pp, attr, "Transformer '%s' for file '%s' failed", attr.transformer, file);
+            cfPS(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_FAIL, pp, attr, "Transformer '%s' for file '%s' failed", attr->transformer, file);
             *result = PromiseResultUpdate(*result, PROMISE_RESULT_FAIL);
             YieldCurrentLock(thislock);
             BufferDestroy(command);
@@ -1662,7 +1740,7 @@ static bool TransformFile(EvalContext *ctx, char *file, Attributes attr, const P
                 if (!feof(pop))
                 {
                     cf_pclose(pop);
-                    cfPS(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_FAIL, pp, attr, "Transformer '%s' for file '%s' failed", attr.transformer, file);
+                    cfPS(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_FAIL, pp, attr, "Transformer '%s' for file '%s' failed", attr->transformer, file);
                     *result = PromiseResultUpdate(*result, PROMISE_RESULT_FAIL);
                     YieldCurrentLock(thislock);
                     free(line);
@@ -1702,7 +1780,7 @@ static bool TransformFile(EvalContext *ctx, char *file, Attributes attr, const P
     return true;
 }
 
-static PromiseResult VerifyName(EvalContext *ctx, char *path, struct stat *sb, Attributes attr, const Promise *pp)
+static PromiseResult VerifyName(EvalContext *ctx, char *path, struct stat *sb, const Attributes *attr, const Promise *pp)
 {
     mode_t newperm;
     struct stat dsb;
@@ -1714,25 +1792,25 @@ static PromiseResult VerifyName(EvalContext *ctx, char *path, struct stat *sb, A
     }
     else
     {
-        if (attr.rename.disable)
+        if (attr->rename.disable)
         {
             Log(LOG_LEVEL_WARNING, "File object '%s' exists, contrary to promise", path);
         }
     }
 
     PromiseResult result = PROMISE_RESULT_NOOP;
-    if (attr.rename.newname)
+    if (attr->rename.newname)
     {
         if (DONTDO)
         {
-            Log(LOG_LEVEL_INFO, "File '%s' should be renamed to '%s' to keep promise", path, attr.rename.newname);
+            Log(LOG_LEVEL_INFO, "File '%s' should be renamed to '%s' to keep promise", path, attr->rename.newname);
             return PROMISE_RESULT_NOOP;
         }
         else
         {
-            if (!FileInRepository(attr.rename.newname))
+            if (!FileInRepository(attr->rename.newname))
             {
-                if (rename(path, attr.rename.newname) == -1)
+                if (rename(path, attr->rename.newname) == -1)
                 {
                     cfPS(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_FAIL, pp, attr, "Error occurred while renaming '%s'. (rename: %s)",
                          path, GetErrorStr());
@@ -1740,7 +1818,7 @@ static PromiseResult VerifyName(EvalContext *ctx, char *path, struct stat *sb, A
                 }
                 else
                 {
-                    cfPS(ctx, LOG_LEVEL_INFO, PROMISE_RESULT_CHANGE, pp, attr, "Renaming file '%s' to '%s'", path, attr.rename.newname);
+                    cfPS(ctx, LOG_LEVEL_INFO, PROMISE_RESULT_CHANGE, pp, attr, "Renaming file '%s' to '%s'", path, attr->rename.newname);
                     result = PromiseResultUpdate(result, PROMISE_RESULT_CHANGE);
                 }
             }
@@ -1757,7 +1835,7 @@ static PromiseResult VerifyName(EvalContext *ctx, char *path, struct stat *sb, A
 
     if (S_ISLNK(dsb.st_mode))
     {
-        if (attr.rename.disable)
+        if (attr->rename.disable)
         {
             if (!DONTDO)
             {
@@ -1784,11 +1862,11 @@ static PromiseResult VerifyName(EvalContext *ctx, char *path, struct stat *sb, A
 
 /* Normal disable - has priority */
 
-    if (attr.rename.disable)
+    if (attr->rename.disable)
     {
         char newname[CF_BUFSIZE];
 
-        if (attr.transaction.action == cfa_warn)
+        if (attr->transaction.action == cfa_warn)
         {
             cfPS(ctx, LOG_LEVEL_WARNING, PROMISE_RESULT_WARN, pp, attr, "'%s' '%s' should be renamed",
                  S_ISDIR(sb->st_mode) ? "Directory" : "File", path);
@@ -1796,11 +1874,11 @@ static PromiseResult VerifyName(EvalContext *ctx, char *path, struct stat *sb, A
             return result;
         }
 
-        if (attr.rename.newname && strlen(attr.rename.newname) > 0)
+        if (attr->rename.newname && strlen(attr->rename.newname) > 0)
         {
-            if (IsAbsPath(attr.rename.newname))
+            if (IsAbsPath(attr->rename.newname))
             {
-                strlcpy(path, attr.rename.newname, CF_BUFSIZE);
+                strlcpy(path, attr->rename.newname, CF_BUFSIZE);
             }
             else
             {
@@ -1808,12 +1886,12 @@ static PromiseResult VerifyName(EvalContext *ctx, char *path, struct stat *sb, A
                 ChopLastNode(newname);
 
                 if (!PathAppend(newname, sizeof(newname),
-                                attr.rename.newname, FILE_SEPARATOR))
+                                attr->rename.newname, FILE_SEPARATOR))
                 {
                     cfPS(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_FAIL, pp, attr,
                          "Internal buffer limit in rename operation,"
                          " destination: '%s' + '%s'",
-                         newname, attr.rename.newname);
+                         newname, attr->rename.newname);
                     result = PromiseResultUpdate(result, PROMISE_RESULT_FAIL);
                     return result;
                 }
@@ -1823,9 +1901,9 @@ static PromiseResult VerifyName(EvalContext *ctx, char *path, struct stat *sb, A
         {
             strcpy(newname, path);
 
-            if (attr.rename.disable_suffix)
+            if (attr->rename.disable_suffix)
             {
-                if (!JoinSuffix(newname, sizeof(newname), attr.rename.disable_suffix))
+                if (!JoinSuffix(newname, sizeof(newname), attr->rename.disable_suffix))
                 {
                     return result;
                 }
@@ -1839,11 +1917,11 @@ static PromiseResult VerifyName(EvalContext *ctx, char *path, struct stat *sb, A
             }
         }
 
-        if ((attr.rename.plus != CF_SAMEMODE) && (attr.rename.minus != CF_SAMEMODE))
+        if ((attr->rename.plus != CF_SAMEMODE) && (attr->rename.minus != CF_SAMEMODE))
         {
             newperm = (sb->st_mode & 07777);
-            newperm |= attr.rename.plus;
-            newperm &= ~(attr.rename.minus);
+            newperm |= attr->rename.plus;
+            newperm &= ~(attr->rename.minus);
         }
         else
         {
@@ -1891,9 +1969,9 @@ static PromiseResult VerifyName(EvalContext *ctx, char *path, struct stat *sb, A
         return result;
     }
 
-    if (attr.rename.rotate == 0)
+    if (attr->rename.rotate == 0)
     {
-        if (attr.transaction.action == cfa_warn)
+        if (attr->transaction.action == cfa_warn)
         {
             cfPS(ctx, LOG_LEVEL_WARNING, PROMISE_RESULT_WARN, pp, attr, "File '%s' should be truncated", path);
             result = PromiseResultUpdate(result, PROMISE_RESULT_WARN);
@@ -1911,17 +1989,17 @@ static PromiseResult VerifyName(EvalContext *ctx, char *path, struct stat *sb, A
         return result;
     }
 
-    if (attr.rename.rotate > 0)
+    if (attr->rename.rotate > 0)
     {
-        if (attr.transaction.action == cfa_warn)
+        if (attr->transaction.action == cfa_warn)
         {
             cfPS(ctx, LOG_LEVEL_WARNING, PROMISE_RESULT_WARN, pp, attr, "File '%s' should be rotated", path);
             result = PromiseResultUpdate(result, PROMISE_RESULT_WARN);
         }
         else if (!DONTDO)
         {
-            RotateFiles(path, attr.rename.rotate);
-            cfPS(ctx, LOG_LEVEL_INFO, PROMISE_RESULT_CHANGE, pp, attr, "Rotating files '%s' in %d fifo", path, attr.rename.rotate);
+            RotateFiles(path, attr->rename.rotate);
+            cfPS(ctx, LOG_LEVEL_INFO, PROMISE_RESULT_CHANGE, pp, attr, "Rotating files '%s' in %d fifo", path, attr->rename.rotate);
             result = PromiseResultUpdate(result, PROMISE_RESULT_CHANGE);
         }
         else
@@ -1937,7 +2015,7 @@ static PromiseResult VerifyName(EvalContext *ctx, char *path, struct stat *sb, A
 
 static PromiseResult VerifyDelete(EvalContext *ctx,
                                   const char *path, const struct stat *sb,
-                                  Attributes attr, const Promise *pp)
+                                  const Attributes *attr, const Promise *pp)
 {
     const char *lastnode = ReadLastNode(path);
     Log(LOG_LEVEL_VERBOSE, "Verifying file deletions for '%s'", path);
@@ -1949,7 +2027,7 @@ static PromiseResult VerifyDelete(EvalContext *ctx,
         return PROMISE_RESULT_NOOP;
     }
 
-    switch (attr.transaction.action)
+    switch (attr->transaction.action)
     {
     case cfa_warn:
 
@@ -1980,7 +2058,7 @@ static PromiseResult VerifyDelete(EvalContext *ctx,
         }
         else                                               /* directory */
         {
-            if (!attr.delete.rmdirs)
+            if (!attr->delete.rmdirs)
             {
                 Log(LOG_LEVEL_VERBOSE, "Keeping directory '%s' "
                     "since \"rmdirs\" attribute was not specified",
@@ -1988,7 +2066,7 @@ static PromiseResult VerifyDelete(EvalContext *ctx,
                 return PROMISE_RESULT_NOOP;
             }
 
-            if (attr.havedepthsearch && strcmp(path, pp->promiser) == 0)
+            if (attr->havedepthsearch && strcmp(path, pp->promiser) == 0)
             {
                 Log(LOG_LEVEL_DEBUG,
                     "Skipping deletion of parent directory for recursive promise '%s', "
@@ -2026,17 +2104,17 @@ static PromiseResult VerifyDelete(EvalContext *ctx,
 
     default:
         ProgrammingError("Unhandled file action in switch: %d",
-                         attr.transaction.action);
+                         attr->transaction.action);
     }
 
     assert(false);                                          /* Unreachable! */
     return PROMISE_RESULT_NOOP;
 }
 
-static PromiseResult TouchFile(EvalContext *ctx, char *path, Attributes attr, const Promise *pp)
+static PromiseResult TouchFile(EvalContext *ctx, char *path, const Attributes *attr, const Promise *pp)
 {
     PromiseResult result = PROMISE_RESULT_NOOP;
-    if (!DONTDO && attr.transaction.action == cfa_fix)
+    if (!DONTDO && attr->transaction.action == cfa_fix)
     {
         if (utime(path, NULL) != -1)
         {
@@ -2060,7 +2138,7 @@ static PromiseResult TouchFile(EvalContext *ctx, char *path, Attributes attr, co
     return result;
 }
 
-PromiseResult VerifyFileAttributes(EvalContext *ctx, const char *file, struct stat *dstat, Attributes attr, const Promise *pp)
+PromiseResult VerifyFileAttributes(EvalContext *ctx, const char *file, struct stat *dstat, const Attributes *attr, const Promise *pp)
 {
     PromiseResult result = PROMISE_RESULT_NOOP;
 
@@ -2075,15 +2153,15 @@ PromiseResult VerifyFileAttributes(EvalContext *ctx, const char *file, struct st
 
     newperm = (dstat->st_mode & 07777);
 
-    if ((attr.perms.plus != CF_SAMEMODE) && (attr.perms.minus != CF_SAMEMODE))
+    if ((attr->perms.plus != CF_SAMEMODE) && (attr->perms.minus != CF_SAMEMODE))
     {
-        newperm |= attr.perms.plus;
-        newperm &= ~(attr.perms.minus);
+        newperm |= attr->perms.plus;
+        newperm &= ~(attr->perms.minus);
         /* directories must have x set if r set, regardless  */
 
         if (S_ISDIR(dstat->st_mode))
         {
-            if (attr.perms.rxdirs)
+            if (attr->perms.rxdirs)
             {
                 Log(LOG_LEVEL_DEBUG, "Directory...fixing x bits");
 
@@ -2127,13 +2205,13 @@ PromiseResult VerifyFileAttributes(EvalContext *ctx, const char *file, struct st
 #ifdef __MINGW32__
     if (NovaWin_FileExists(file) && !NovaWin_IsDir(file))
 #else
-    if (attr.havechange && S_ISREG(dstat->st_mode))
+    if (attr->havechange && S_ISREG(dstat->st_mode))
 #endif
     {
         result = PromiseResultUpdate(result, VerifyFileIntegrity(ctx, file, attr, pp));
     }
 
-    if (attr.havechange)
+    if (attr->havechange)
     {
         VerifyFileChanges(file, dstat, attr, pp);
     }
@@ -2164,7 +2242,7 @@ PromiseResult VerifyFileAttributes(EvalContext *ctx, const char *file, struct st
         Log(LOG_LEVEL_DEBUG, "Trying to fix mode...newperm '%jo', stat '%jo'",
             (uintmax_t) (newperm & 07777), (uintmax_t) (dstat->st_mode & 07777));
 
-        if (attr.transaction.action == cfa_warn || DONTDO)
+        if (attr->transaction.action == cfa_warn || DONTDO)
         {
 
             cfPS(ctx, LOG_LEVEL_WARNING, PROMISE_RESULT_WARN, pp, attr,
@@ -2172,7 +2250,7 @@ PromiseResult VerifyFileAttributes(EvalContext *ctx, const char *file, struct st
                  (uintmax_t)dstat->st_mode & 07777, (uintmax_t)newperm & 07777);
             result = PromiseResultUpdate(result, PROMISE_RESULT_WARN);
         }
-        else if (attr.transaction.action == cfa_fix)
+        else if (attr->transaction.action == cfa_fix)
         {
             if (safe_chmod(file, newperm & 07777) == -1)
             {
@@ -2191,15 +2269,15 @@ PromiseResult VerifyFileAttributes(EvalContext *ctx, const char *file, struct st
         else
         {
             ProgrammingError("Unhandled file action in switch: %d",
-                             attr.transaction.action);
+                             attr->transaction.action);
         }
     }
 
 # if defined HAVE_CHFLAGS       /* BSD special flags */
 
     newflags = (dstat->st_flags & CHFLAGS_MASK);
-    newflags |= attr.perms.plus_flags;
-    newflags &= ~(attr.perms.minus_flags);
+    newflags |= attr->perms.plus_flags;
+    newflags &= ~(attr->perms.minus_flags);
 
     if ((newflags & CHFLAGS_MASK) == (dstat->st_flags & CHFLAGS_MASK))  /* file okay */
     {
@@ -2213,7 +2291,7 @@ PromiseResult VerifyFileAttributes(EvalContext *ctx, const char *file, struct st
                 file, (uintmax_t) (newflags & CHFLAGS_MASK),
                 (uintmax_t) (dstat->st_flags & CHFLAGS_MASK));
 
-        switch (attr.transaction.action)
+        switch (attr->transaction.action)
         {
         case cfa_warn:
 
@@ -2249,18 +2327,18 @@ PromiseResult VerifyFileAttributes(EvalContext *ctx, const char *file, struct st
             break;
 
         default:
-            ProgrammingError("Unhandled file action in switch: %d", attr.transaction.action);
+            ProgrammingError("Unhandled file action in switch: %d", attr->transaction.action);
         }
     }
 # endif
 #endif
 
-    if (attr.acl.acl_entries)
+    if (attr->acl.acl_entries)
     {
         result = PromiseResultUpdate(result, VerifyACL(ctx, file, attr, pp));
     }
 
-    if (attr.touch)
+    if (attr->touch)
     {
         if (utime(file, NULL) == -1)
         {
@@ -2282,7 +2360,7 @@ PromiseResult VerifyFileAttributes(EvalContext *ctx, const char *file, struct st
     return result;
 }
 
-int DepthSearch(EvalContext *ctx, char *name, struct stat *sb, int rlevel, Attributes attr,
+int DepthSearch(EvalContext *ctx, char *name, struct stat *sb, int rlevel, const Attributes *attr,
                 const Promise *pp, dev_t rootdevice, PromiseResult *result)
 {
     Dir *dirh;
@@ -2293,7 +2371,7 @@ int DepthSearch(EvalContext *ctx, char *name, struct stat *sb, int rlevel, Attri
     Seq *selected_files = NULL;
     bool retval = true;
 
-    if (!attr.havedepthsearch)  /* if the search is trivial, make sure that we are in the parent dir of the leaf */
+    if (!attr->havedepthsearch)  /* if the search is trivial, make sure that we are in the parent dir of the leaf */
     {
         char basedir[CF_BUFSIZE];
 
@@ -2305,7 +2383,7 @@ int DepthSearch(EvalContext *ctx, char *name, struct stat *sb, int rlevel, Attri
             Log(LOG_LEVEL_ERR, "Failed to chdir into '%s'. (chdir: '%s')", basedir, GetErrorStr());
             return false;
         }
-        if (!attr.haveselect || SelectLeaf(ctx, name, sb, attr.select))
+        if (!attr->haveselect || SelectLeaf(ctx, name, sb, attr->select))
         {
             VerifyFileLeaf(ctx, name, sb, attr, pp, result);
             return true;
@@ -2333,7 +2411,7 @@ int DepthSearch(EvalContext *ctx, char *name, struct stat *sb, int rlevel, Attri
         return false;
     }
 
-    if (attr.havechange)
+    if (attr->havechange)
     {
         db_file_set = SeqNew(1, &free);
         if (!FileChangesGetDirectoryList(name, db_file_set))
@@ -2387,7 +2465,7 @@ int DepthSearch(EvalContext *ctx, char *name, struct stat *sb, int rlevel, Attri
 
         /* See if we are supposed to treat links to dirs as dirs and descend */
 
-        if ((attr.recursion.travlinks) && (S_ISLNK(lsb.st_mode)))
+        if ((attr->recursion.travlinks) && (S_ISLNK(lsb.st_mode)))
         {
             if ((lsb.st_uid != 0) && (lsb.st_uid != getuid()))
             {
@@ -2405,7 +2483,7 @@ int DepthSearch(EvalContext *ctx, char *name, struct stat *sb, int rlevel, Attri
             }
         }
 
-        if ((attr.recursion.xdev) && (DeviceBoundary(&lsb, rootdevice)))
+        if ((attr->recursion.xdev) && (DeviceBoundary(&lsb, rootdevice)))
         {
             Log(LOG_LEVEL_VERBOSE, "Skipping '%s' on different device - use xdev option to change this. (stat: %s)", path, GetErrorStr());
             continue;
@@ -2413,25 +2491,25 @@ int DepthSearch(EvalContext *ctx, char *name, struct stat *sb, int rlevel, Attri
 
         if (S_ISDIR(lsb.st_mode))
         {
-            if (SkipDirLinks(ctx, path, dirp->d_name, attr.recursion))
+            if (SkipDirLinks(ctx, path, dirp->d_name, attr->recursion))
             {
                 continue;
             }
 
-            if ((attr.recursion.depth > 1) && (rlevel <= attr.recursion.depth))
+            if ((attr->recursion.depth > 1) && (rlevel <= attr->recursion.depth))
             {
                 Log(LOG_LEVEL_VERBOSE, "Entering '%s', level %d", path, rlevel);
                 goback = DepthSearch(ctx, path, &lsb, rlevel + 1, attr, pp, rootdevice, result);
-                if (!PopDirState(goback, name, sb, attr.recursion))
+                if (!PopDirState(goback, name, sb, attr->recursion))
                 {
                     FatalError(ctx, "Not safe to continue");
                 }
             }
         }
 
-        if (!attr.haveselect || SelectLeaf(ctx, path, &lsb, attr.select))
+        if (!attr->haveselect || SelectLeaf(ctx, path, &lsb, attr->select))
         {
-            if (attr.havechange)
+            if (attr->havechange)
             {
                 if (!SeqBinaryLookup(db_file_set, dirp->d_name, (SeqItemComparator)strcmp))
                 {
@@ -2450,10 +2528,10 @@ int DepthSearch(EvalContext *ctx, char *name, struct stat *sb, int rlevel, Attri
         }
     }
 
-    if (attr.havechange)
+    if (attr->havechange)
     {
         FileChangesCheckAndUpdateDirectory(name, selected_files, db_file_set,
-                                           attr.change.update, pp, result);
+                                           attr->change.update, pp, result);
     }
 
 end:
@@ -2539,8 +2617,11 @@ static bool CheckLinkSecurity(struct stat *sb, char *name)
 }
 
 static PromiseResult VerifyCopiedFileAttributes(EvalContext *ctx, const char *src, const char *dest, struct stat *sstat,
-                                                struct stat *dstat, Attributes attr, const Promise *pp)
+                                                struct stat *dstat, const Attributes *org_attr, const Promise *pp)
 {
+    Attributes attr_copy = *org_attr; /* modified below */
+    Attributes *attr = &attr_copy;
+
 #ifndef __MINGW32__
     mode_t newplus, newminus;
     uid_t save_uid;
@@ -2548,62 +2629,62 @@ static PromiseResult VerifyCopiedFileAttributes(EvalContext *ctx, const char *sr
 
 // If we get here, there is both a src and dest file
 
-    save_uid = (attr.perms.owners)->uid;
-    save_gid = (attr.perms.groups)->gid;
+    save_uid = (attr->perms.owners)->uid;
+    save_gid = (attr->perms.groups)->gid;
 
-    if (attr.copy.preserve)
+    if (attr->copy.preserve)
     {
         Log(LOG_LEVEL_VERBOSE, "Attempting to preserve file permissions from the source: %04jo",
               (uintmax_t)(sstat->st_mode & 07777));
 
-        if ((attr.perms.owners)->uid == CF_SAME_OWNER)  /* Preserve uid and gid  */
+        if ((attr->perms.owners)->uid == CF_SAME_OWNER)  /* Preserve uid and gid  */
         {
-            (attr.perms.owners)->uid = sstat->st_uid;
+            (attr->perms.owners)->uid = sstat->st_uid;
         }
 
-        if ((attr.perms.groups)->gid == CF_SAME_GROUP)
+        if ((attr->perms.groups)->gid == CF_SAME_GROUP)
         {
-            (attr.perms.groups)->gid = sstat->st_gid;
+            (attr->perms.groups)->gid = sstat->st_gid;
         }
 
 // Will this preserve if no mode set?
 
         newplus = (sstat->st_mode & 07777);
         newminus = ~newplus & 07777;
-        attr.perms.plus = newplus;
-        attr.perms.minus = newminus;
+        attr->perms.plus = newplus;
+        attr->perms.minus = newminus;
     }
     else
     {
-        if ((attr.perms.owners)->uid == CF_SAME_OWNER)  /* Preserve uid and gid  */
+        if ((attr->perms.owners)->uid == CF_SAME_OWNER)  /* Preserve uid and gid  */
         {
-            (attr.perms.owners)->uid = dstat->st_uid;
+            (attr->perms.owners)->uid = dstat->st_uid;
         }
 
-        if ((attr.perms.groups)->gid == CF_SAME_GROUP)
+        if ((attr->perms.groups)->gid == CF_SAME_GROUP)
         {
-            (attr.perms.groups)->gid = dstat->st_gid;
+            (attr->perms.groups)->gid = dstat->st_gid;
         }
 
-        if (attr.haveperms)
+        if (attr->haveperms)
         {
-            newplus = (dstat->st_mode & 07777) | attr.perms.plus;
-            newminus = ~(newplus & ~(attr.perms.minus)) & 07777;
-            attr.perms.plus = newplus;
-            attr.perms.minus = newminus;
+            newplus = (dstat->st_mode & 07777) | attr->perms.plus;
+            newminus = ~(newplus & ~(attr->perms.minus)) & 07777;
+            attr->perms.plus = newplus;
+            attr->perms.minus = newminus;
         }
     }
 #endif
     PromiseResult result = VerifyFileAttributes(ctx, dest, dstat, attr, pp);
 
 #ifndef __MINGW32__
-    (attr.perms.owners)->uid = save_uid;
-    (attr.perms.groups)->gid = save_gid;
+    (attr->perms.owners)->uid = save_uid;
+    (attr->perms.groups)->gid = save_gid;
 #endif
 
-    if (attr.copy.preserve &&
-        (   attr.copy.servers == NULL
-         || strcmp(RlistScalarValue(attr.copy.servers), "localhost") == 0))
+    if (attr->copy.preserve &&
+        (   attr->copy.servers == NULL
+         || strcmp(RlistScalarValue(attr->copy.servers), "localhost") == 0))
     {
         if (!CopyFileExtendedAttributesDisk(src, dest))
         {
@@ -2617,13 +2698,13 @@ static PromiseResult VerifyCopiedFileAttributes(EvalContext *ctx, const char *sr
     return result;
 }
 
-static PromiseResult CopyFileSources(EvalContext *ctx, char *destination, Attributes attr, const Promise *pp, AgentConnection *conn)
+static PromiseResult CopyFileSources(EvalContext *ctx, char *destination, const Attributes *attr, const Promise *pp, AgentConnection *conn)
 {
     Buffer *source = BufferNew();
     // Expand this.promiser
     ExpandScalar(ctx,
                  PromiseGetBundle(pp)->ns, PromiseGetBundle(pp)->name,
-                 attr.copy.source, source);
+                 attr->copy.source, source);
     char vbuff[CF_BUFSIZE];
     struct stat ssb, dsb;
     struct timespec start;
@@ -2637,9 +2718,9 @@ static PromiseResult CopyFileSources(EvalContext *ctx, char *destination, Attrib
         return PROMISE_RESULT_FAIL;
     }
 
-    if (cf_stat(BufferData(source), &ssb, attr.copy, conn) == -1)
+    if (cf_stat(BufferData(source), &ssb, attr->copy, conn) == -1)
     {
-        if (attr.copy.missing_ok)
+        if (attr->copy.missing_ok)
         {
             cfPS(ctx, LOG_LEVEL_VERBOSE, PROMISE_RESULT_NOOP, pp, attr,
                  "Can't stat file '%s' on '%s' but promise is kept because of"
@@ -2669,7 +2750,7 @@ static PromiseResult CopyFileSources(EvalContext *ctx, char *destination, Attrib
         strcat(vbuff, ".");
     }
 
-    if (!MakeParentDirectory(vbuff, attr.move_obstructions))
+    if (!MakeParentDirectory(vbuff, attr->move_obstructions))
     {
         cfPS(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_FAIL, pp, attr,
              "Can't make directories for '%s' in files.copy_from promise",
@@ -2683,7 +2764,7 @@ static PromiseResult CopyFileSources(EvalContext *ctx, char *destination, Attrib
     PromiseResult result = PROMISE_RESULT_NOOP;
     if (S_ISDIR(ssb.st_mode))   /* could be depth_search */
     {
-        if (attr.copy.purge)
+        if (attr->copy.purge)
         {
             Log(LOG_LEVEL_VERBOSE, "Destination purging enabled");
         }
@@ -2692,12 +2773,12 @@ static PromiseResult CopyFileSources(EvalContext *ctx, char *destination, Attrib
 
         result = PromiseResultUpdate(
             result, SourceSearchAndCopy(ctx, BufferData(source), destination,
-                                        attr.recursion.depth, attr, pp,
+                                        attr->recursion.depth, attr, pp,
                                         ssb.st_dev, &inode_cache, conn));
 
         if (stat(destination, &dsb) != -1)
         {
-            if (attr.copy.check_root)
+            if (attr->copy.check_root)
             {
                 result = PromiseResultUpdate(
                     result, VerifyCopiedFileAttributes(ctx, BufferData(source),
@@ -2756,8 +2837,7 @@ static ProtocolVersion DecideProtocol(const EvalContext *ctx,
     }
 }
 
-static AgentConnection *FileCopyConnectionOpen(const EvalContext *ctx,
-                                               const char *servername,
+static ConnectionFlags FileCopyConnectionFlags(const EvalContext *ctx,
                                                FileCopy fc, bool background)
 {
     ConnectionFlags flags = {
@@ -2766,13 +2846,24 @@ static AgentConnection *FileCopyConnectionOpen(const EvalContext *ctx,
         .force_ipv4 = fc.force_ipv4,
         .trust_server = fc.trustkey
     };
+    return flags;
+}
 
-    unsigned int conntimeout = fc.timeout;
+static unsigned int FileCopyConnectionTimeout(FileCopy fc)
+{
     if (fc.timeout == CF_NOINT || fc.timeout < 0)
     {
-        conntimeout = CONNTIMEOUT;
+        return CONNTIMEOUT;
     }
+    return fc.timeout;
+}
 
+static AgentConnection *FileCopyConnectionOpen(const EvalContext *ctx,
+                                               const char *servername,
+                                               FileCopy fc, bool background)
+{
+    ConnectionFlags flags = FileCopyConnectionFlags(ctx, fc, background);
+    unsigned int conntimeout = FileCopyConnectionTimeout(fc);
     const char *port = (fc.port != NULL) ? fc.port : CFENGINE_PORT_STR;
 
     AgentConnection *conn = NULL;
@@ -2820,6 +2911,167 @@ static AgentConnection *FileCopyConnectionOpen(const EvalContext *ctx,
     }
 }
 
+/* Connection times to each copy_from server are kept in the performance
+ * database, so that the fastest responders of the previous runs are tried
+ * first. */
+typedef struct
+{
+    const char *name;
+    size_t order;                         /* position in copy_from servers */
+    bool measured;
+    double average;                        /* seconds */
+} ServerCandidate;
+
+static void ServerConnectEventName(char *buf, size_t buf_size,
+                                   const char *servername, const char *port)
+{
+    snprintf(buf, buf_size, "Connect(%s:%s)", servername, port);
+}
+
+/* Allocate and add to the cache as failure. */
+static void CacheOfflineServer(const char *servername, const char *port,
+                               ConnectionFlags flags)
+{
+    AgentConnection *conn = NewAgentConn(servername, port, flags);
+    conn->conn_info->status = CONNECTIONINFO_STATUS_NOT_ESTABLISHED;
+    ConnCache_Add(conn, CONNCACHE_STATUS_OFFLINE);
+}
+
+/* Record a failed connection as if it took the whole connect timeout, so
+ * that the server is tried after the responsive ones next time. */
+static void NoteServerConnectFailure(const char *servername, const char *port,
+                                     unsigned int conntimeout)
+{
+    char eventname[CF_BUFSIZE];
+    ServerConnectEventName(eventname, sizeof(eventname), servername, port);
+    NoteMeasurement(eventname, (conntimeout > 0) ? conntimeout : CONNTIMEOUT);
+}
+
+static int CompareServerCandidates(const void *a, const void *b,
+                                   ARG_UNUSED void *user_data)
+{
+    const ServerCandidate *c1 = a;
+    const ServerCandidate *c2 = b;
+
+    /* Servers never measured go last, in the order given in the policy. */
+    if (c1->measured != c2->measured)
+    {
+        return c1->measured ? -1 : 1;
+    }
+    if (c1->measured && c1->average != c2->average)
+    {
+        return (c1->average < c2->average) ? -1 : 1;
+    }
+    return (c1->order < c2->order) ? -1 : (c1->order > c2->order);
+}
+
+/**
+ * Like FileCopyConnectionOpen(), but for a list of several servers. All
+ * are connected to at the same time with staggered starts, and the first
+ * one to respond is used, see ServerConnectionFirst().
+ */
+static AgentConnection *FileCopyConnectionOpenFirst(const EvalContext *ctx,
+                                                    const Seq *servernames,
+                                                    FileCopy fc,
+                                                    bool background)
+{
+    ConnectionFlags flags = FileCopyConnectionFlags(ctx, fc, background);
+    unsigned int conntimeout = FileCopyConnectionTimeout(fc);
+    const char *port = (fc.port != NULL) ? fc.port : CFENGINE_PORT_STR;
+
+    if (flags.cache_connection)
+    {
+        for (size_t i = 0; i < SeqLength(servernames); i++)
+        {
+            AgentConnection *conn =
+                ConnCache_FindIdleMarkBusy(SeqAt(servernames, i), port, flags);
+            if (conn != NULL)
+            {
+                return conn;
+            }
+        }
+    }
+
+    char eventname[CF_BUFSIZE];
+    Seq *candidates = SeqNew(SeqLength(servernames), free);
+    for (size_t i = 0; i < SeqLength(servernames); i++)
+    {
+        ServerCandidate *c = xcalloc(1, sizeof(*c));
+        c->name = SeqAt(servernames, i);
+        c->order = i;
+        ServerConnectEventName(eventname, sizeof(eventname), c->name, port);
+        c->measured = GetMeasuredAverage(eventname, &c->average);
+        SeqAppend(candidates, c);
+    }
+    SeqSort(candidates, CompareServerCandidates, NULL);
+
+    size_t num = SeqLength(candidates);
+    const char **names = xcalloc(num, sizeof(*names));
+    for (size_t i = 0; i < num; i++)
+    {
+        names[i] = ((ServerCandidate *) SeqAt(candidates, i))->name;
+    }
+
+    AgentConnection *conn = NULL;
+    while (conn == NULL && num > 0)
+    {
+        struct timespec start = BeginMeasure();
+        size_t winner;
+        int err;
+        conn = ServerConnectionFirst(names, num, port, conntimeout,
+                                     flags, &winner, &err);
+
+        if (winner == num)                      /* nobody even answered */
+        {
+            for (size_t i = 0; i < num; i++)
+            {
+                Log(LOG_LEVEL_INFO, "Unable to establish connection to '%s'",
+                    names[i]);
+                NoteServerConnectFailure(names[i], port, conntimeout);
+                if (flags.cache_connection)
+                {
+                    CacheOfflineServer(names[i], port, flags);
+                }
+            }
+            break;
+        }
+
+        if (conn == NULL)
+        {
+            Log(LOG_LEVEL_INFO, "Unable to establish connection to '%s'",
+                names[winner]);
+            NoteServerConnectFailure(names[winner], port, conntimeout);
+
+            if (flags.cache_connection)
+            {
+                CacheOfflineServer(names[winner], port, flags);
+            }
+
+            /* Try again without it. */
+            memmove(&names[winner], &names[winner + 1],
+                    (num - winner - 1) * sizeof(*names));
+            num--;
+        }
+        else
+        {
+            /* Only the winner's time is known, the servers tried before it
+             * were still connecting and may just be a bit slower. */
+            ServerConnectEventName(eventname, sizeof(eventname),
+                                   names[winner], port);
+            EndMeasure(eventname, start);
+
+            if (flags.cache_connection)
+            {
+                ConnCache_Add(conn, CONNCACHE_STATUS_BUSY);
+            }
+        }
+    }
+
+    free(names);
+    SeqDestroy(candidates);
+    return conn;
+}
+
 void FileCopyConnectionClose(AgentConnection *conn)
 {
     if (conn->flags.cache_connection)
@@ -2833,13 +3085,68 @@ void FileCopyConnectionClose(AgentConnection *conn)
     }
 }
 
-PromiseResult ScheduleCopyOperation(EvalContext *ctx, char *destination, Attributes attr, const Promise *pp)
+/**
+ * Replace directory #destination with the policy snapshot published by the
+ * server in attr.copy.source, see PolicySnapshotUpdate(). Falls back to
+ * copying file by file if the server has no snapshot.
+ */
+static PromiseResult CopyFromPolicySnapshot(EvalContext *ctx, char *destination,
+                                            const Attributes *attr, const Promise *pp,
+                                            AgentConnection *conn)
+{
+    /* Dry runs are left to the regular copy, which knows how to warn. */
+    if (DONTDO || attr->transaction.action == cfa_warn)
+    {
+        return CopyFileSources(ctx, destination, attr, pp, conn);
+    }
+
+    /* The directory itself is renamed, so "dir/." or "dir/" won't do. */
+    char local_dir[CF_BUFSIZE];
+    strlcpy(local_dir, destination, sizeof(local_dir));
+    DeleteSlash(local_dir);
+    while (strlen(local_dir) > 2 &&
+           StringEndsWith(local_dir, FILE_SEPARATOR_STR "."))
+    {
+        local_dir[strlen(local_dir) - 2] = '\0';
+        DeleteSlash(local_dir);
+    }
+
+    switch (PolicySnapshotUpdate(conn, attr->copy.source, local_dir))
+    {
+    case POLICY_SNAPSHOT_UPDATED:
+        cfPS(ctx, LOG_LEVEL_VERBOSE, PROMISE_RESULT_CHANGE, pp, attr,
+             "Updated '%s' from policy snapshot on '%s'",
+             local_dir, conn->this_server);
+        return PROMISE_RESULT_CHANGE;
+
+    case POLICY_SNAPSHOT_UNCHANGED:
+        cfPS(ctx, LOG_LEVEL_VERBOSE, PROMISE_RESULT_NOOP, pp, attr,
+             "'%s' is up to date with policy snapshot on '%s'",
+             local_dir, conn->this_server);
+        return PROMISE_RESULT_NOOP;
+
+    case POLICY_SNAPSHOT_UNAVAILABLE:
+        Log(LOG_LEVEL_VERBOSE,
+            "Server '%s' publishes no policy snapshot in '%s',"
+            " copying files one by one", conn->this_server, attr->copy.source);
+        return CopyFileSources(ctx, destination, attr, pp, conn);
+
+    case POLICY_SNAPSHOT_FAILED:
+    default:
+        cfPS(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_FAIL, pp, attr,
+             "Failed to update '%s' from policy snapshot on '%s'",
+             local_dir, conn->this_server);
+        return PROMISE_RESULT_FAIL;
+    }
+}
+
+PromiseResult ScheduleCopyOperation(EvalContext *ctx, char *destination, const Attributes *attr, const Promise *pp)
 {
     /* TODO currently parser allows body copy_from to have no source!
        See tests/acceptance/10_files/02_maintain/017.cf and
        https://cfengine.com/bugtracker/view.php?id=687 */
-    /* assert(attr.copy.source != NULL); */
-    if (attr.copy.source == NULL)
+    /* assert(attr->copy.source != NULL); */
+    if (attr->copy.source == NULL)
     {
         Log(LOG_LEVEL_INFO,
             "Body copy_from has no source! Maybe a typo in the policy?");
@@ -2847,15 +3154,15 @@ PromiseResult ScheduleCopyOperation(EvalContext *ctx, char *destination, Attribu
     }
 
     Log(LOG_LEVEL_VERBOSE, "File '%s' copy_from '%s'",
-        destination, attr.copy.source);
+        destination, attr->copy.source);
 
-    /* Empty attr.copy.servers means copy from localhost. */
-    bool copyfrom_localhost = (attr.copy.servers == NULL);
+    /* Empty attr->copy.servers means copy from localhost. */
+    bool copyfrom_localhost = (attr->copy.servers == NULL);
     AgentConnection *conn = NULL;
-    Rlist *rp = attr.copy.servers;
 
-    /* Iterate over all copy_from servers until connection succeeds. */
-    while (rp != NULL && conn == NULL)
+    /* All copy_from servers up to "localhost" are candidates. */
+    Seq *servernames = SeqNew(5, NULL);
+    for (const Rlist *rp = attr->copy.servers; rp != NULL; rp = rp->next)
     {
         const char *servername = RlistScalarValue(rp);
 
@@ -2865,15 +3172,34 @@ PromiseResult ScheduleCopyOperation(EvalContext *ctx, char *destination, Attribu
             break;
         }
 
-        conn = FileCopyConnectionOpen(ctx, servername, attr.copy,
-                                      attr.transaction.background);
+        SeqAppend(servernames, (void *) servername);
+    }
+
+    if (SeqLength(servernames) == 1)
+    {
+        const char *servername = SeqAt(servernames, 0);
+
+        conn = FileCopyConnectionOpen(ctx, servername, attr->copy,
+                                      attr->transaction.background);
         if (conn == NULL)
         {
             Log(LOG_LEVEL_INFO, "Unable to establish connection to '%s'",
                 servername);
         }
+    }
+    else if (SeqLength(servernames) > 1)
+    {
+        /* Use whichever server responds first. */
+        conn = FileCopyConnectionOpenFirst(ctx, servernames, attr->copy,
+                                           attr->transaction.background);
+    }
 
-        rp = rp->next;
+    SeqDestroy(servernames);
+
+    /* If any server was connected to, "localhost" is not used. */
+    if (conn != NULL)
+    {
+        copyfrom_localhost = false;
     }
 
     if (!copyfrom_localhost && conn == NULL)
@@ -2884,8 +3210,16 @@ PromiseResult ScheduleCopyOperation(EvalContext *ctx, char *destination, Attribu
         return PROMISE_RESULT_FAIL;
     }
 
-    /* (conn == NULL) means local copy. */
-    PromiseResult result = CopyFileSources(ctx, destination, attr, pp, conn);
+    PromiseResult result;
+    if (conn != NULL && attr->copy.snapshot)
+    {
+        result = CopyFromPolicySnapshot(ctx, destination, attr, pp, conn);
+    }
+    else
+    {
+        /* (conn == NULL) means local copy. */
+        result = CopyFileSources(ctx, destination, attr, pp, conn);
+    }
 
     if (conn != NULL)
     {
@@ -2895,23 +3229,23 @@ PromiseResult ScheduleCopyOperation(EvalContext *ctx, char *destination, Attribu
     return result;
 }
 
-PromiseResult ScheduleLinkOperation(EvalContext *ctx, char *destination, char *source, Attributes attr, const Promise *pp)
+PromiseResult ScheduleLinkOperation(EvalContext *ctx, char *destination, char *source, const Attributes *attr, const Promise *pp)
 {
     const char *lastnode;
 
     lastnode = ReadLastNode(destination);
     PromiseResult result = PROMISE_RESULT_NOOP;
 
-    if (MatchRlistItem(ctx, attr.link.copy_patterns, lastnode))
+    if (MatchRlistItem(ctx, attr->link.copy_patterns, lastnode))
     {
         Log(LOG_LEVEL_VERBOSE, "Link '%s' matches copy_patterns", destination);
         CompressedArray *inode_cache = NULL;
-        result = PromiseResultUpdate(result, VerifyCopy(ctx, attr.link.source, destination, attr, pp, &inode_cache, NULL));
+        result = PromiseResultUpdate(result, VerifyCopy(ctx, attr->link.source, destination, attr, pp, &inode_cache, NULL));
         DeleteCompressedArray(inode_cache);
         return result;
     }
 
-    switch (attr.link.link_type)
+    switch (attr->link.link_type)
     {
     case FILE_LINK_TYPE_SYMLINK:
         result = VerifyLink(ctx, destination, source, attr, pp);
@@ -2933,9 +3267,12 @@ PromiseResult ScheduleLinkOperation(EvalContext *ctx, char *destination, char *s
     return result;
 }
 
-PromiseResult ScheduleLinkChildrenOperation(EvalContext *ctx, char *destination, char *source, int recurse, Attributes attr,
+PromiseResult ScheduleLinkChildrenOperation(EvalContext *ctx, char *destination, char *source, int recurse, const Attributes *org_attr,
                                             const Promise *pp)
 {
+    Attributes attr_copy = *org_attr; /* modified below */
+    Attributes *attr = &attr_copy;
+
     Dir *dirh;
     const struct dirent *dirp;
     char promiserpath[CF_BUFSIZE], sourcepath[CF_BUFSIZE];
@@ -2944,7 +3281,7 @@ PromiseResult ScheduleLinkChildrenOperation(EvalContext *ctx, char *destination,
 
     if ((ret = lstat(destination, &lsb)) != -1)
     {
-        if (attr.move_obstructions && S_ISLNK(lsb.st_mode))
+        if (attr->move_obstructions && S_ISLNK(lsb.st_mode))
         {
             unlink(destination);
         }
@@ -2970,7 +3307,7 @@ PromiseResult ScheduleLinkChildrenOperation(EvalContext *ctx, char *destination,
     {
         cfPS(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_FAIL, pp, attr,
              "Can't open source of children to link '%s'. (opendir: %s)",
-             attr.link.source, GetErrorStr());
+             attr->link.source, GetErrorStr());
         result = PromiseResultUpdate(result, PROMISE_RESULT_FAIL);
         return result;
     }
@@ -3016,9 +3353,9 @@ PromiseResult ScheduleLinkChildrenOperation(EvalContext *ctx, char *destination,
 
         if ((lstat(promiserpath, &lsb) != -1) && !S_ISLNK(lsb.st_mode) && !S_ISDIR(lsb.st_mode))
         {
-            if (attr.link.when_linking_children == cfa_override)
+            if (attr->link.when_linking_children == cfa_override)
             {
-                attr.move_obstructions = true;
+                attr->move_obstructions = true;
             }
             else
             {
@@ -3027,7 +3364,7 @@ PromiseResult ScheduleLinkChildrenOperation(EvalContext *ctx, char *destination,
             }
         }
 
-        if ((attr.recursion.depth > recurse) && (lstat(sourcepath, &lsb) != -1) && S_ISDIR(lsb.st_mode))
+        if ((attr->recursion.depth > recurse) && (lstat(sourcepath, &lsb) != -1) && S_ISDIR(lsb.st_mode))
         {
             result = PromiseResultUpdate(result, ScheduleLinkChildrenOperation(ctx, promiserpath, sourcepath, recurse + 1, attr, pp));
         }
@@ -3041,13 +3378,13 @@ PromiseResult ScheduleLinkChildrenOperation(EvalContext *ctx, char *destination,
     return result;
 }
 
-static PromiseResult VerifyFileIntegrity(EvalContext *ctx, const char *file, Attributes attr, const Promise *pp)
+static PromiseResult VerifyFileIntegrity(EvalContext *ctx, const char *file, const Attributes *attr, const Promise *pp)
 {
     unsigned char digest1[EVP_MAX_MD_SIZE + 1];
     unsigned char digest2[EVP_MAX_MD_SIZE + 1];
     int changed = false, one, two;
 
-    if ((attr.change.report_changes != FILE_CHANGE_REPORT_CONTENT_CHANGE) && (attr.change.report_changes != FILE_CHANGE_REPORT_ALL))
+    if ((attr->change.report_changes != FILE_CHANGE_REPORT_CONTENT_CHANGE) && (attr->change.report_changes != FILE_CHANGE_REPORT_ALL))
     {
         return PROMISE_RESULT_NOOP;
     }
@@ -3056,7 +3393,7 @@ static PromiseResult VerifyFileIntegrity(EvalContext *ctx, const char *file, Att
     memset(digest2, 0, EVP_MAX_MD_SIZE + 1);
 
     PromiseResult result = PROMISE_RESULT_NOOP;
-    if (attr.change.hash == HASH_METHOD_BEST)
+    if (attr->change.hash == HASH_METHOD_BEST)
     {
         if (!DONTDO)
         {
@@ -3076,9 +3413,9 @@ static PromiseResult VerifyFileIntegrity(EvalContext *ctx, const char *file, Att
     {
         if (!DONTDO)
         {
-            HashFile(file, digest1, attr.change.hash);
+            HashFile(file, digest1, attr->change.hash);
 
-            if (FileChangesCheckAndUpdateHash(ctx, file, digest1, attr.change.hash, attr, pp, &result))
+            if (FileChangesCheckAndUpdateHash(ctx, file, digest1, attr->change.hash, attr, pp, &result))
             {
                 changed = true;
             }
@@ -3092,7 +3429,7 @@ static PromiseResult VerifyFileIntegrity(EvalContext *ctx, const char *file, Att
         FileChangesLogChange(file, FILE_STATE_CONTENT_CHANGED, "Content changed", pp);
     }
 
-    if (attr.change.report_diffs)
+    if (attr->change.report_diffs)
     {
         char destination[CF_BUFSIZE];
         if (!GetRepositoryPath(file, attr, destination))
@@ -3247,7 +3584,7 @@ static bool IsInSetxidList(const char *file)
 }
 
 static PromiseResult VerifySetUidGid(EvalContext *ctx, const char *file, struct stat *dstat, mode_t newperm,
-                                     const Promise *pp, Attributes attr)
+                                     const Promise *pp, const Attributes *attr)
 {
     int amroot = true;
     PromiseResult result = PROMISE_RESULT_NOOP;
@@ -3277,7 +3614,7 @@ static PromiseResult VerifySetUidGid(EvalContext *ctx, const char *file, struct
         }
         else
         {
-            switch (attr.transaction.action)
+            switch (attr->transaction.action)
             {
             case cfa_fix:
 
@@ -3319,7 +3656,7 @@ static PromiseResult VerifySetUidGid(EvalContext *ctx, const char *file, struct
         }
         else
         {
-            switch (attr.transaction.action)
+            switch (attr->transaction.action)
             {
             case cfa_fix:
 
@@ -3347,7 +3684,7 @@ static PromiseResult VerifySetUidGid(EvalContext *ctx, const char *file, struct
 
 #ifdef __APPLE__
 
-static int VerifyFinderType(EvalContext *ctx, const char *file, Attributes a, const Promise *pp, PromiseResult *result)
+static int VerifyFinderType(EvalContext *ctx, const char *file, const Attributes *a, const Promise *pp, PromiseResult *result)
 {                               /* Code modeled after hfstar's extract.c */
     typedef struct
     {
@@ -3379,14 +3716,14 @@ static int VerifyFinderType(EvalContext *ctx, const char *file, Attributes a, co
     fndrInfo;
     int retval;
 
-    if (a.perms.findertype == NULL)
+    if (a->perms.findertype == NULL)
     {
         return 0;
     }
 
-    Log(LOG_LEVEL_DEBUG, "VerifyFinderType of '%s' for '%s'", file, a.perms.findertype);
+    Log(LOG_LEVEL_DEBUG, "VerifyFinderType of '%s' for '%s'", file, a->perms.findertype);
 
-    if (strncmp(a.perms.findertype, "*", CF_BUFSIZE) == 0 || strncmp(a.perms.findertype, "", CF_BUFSIZE) == 0)
+    if (strncmp(a->perms.findertype, "*", CF_BUFSIZE) == 0 || strncmp(a->perms.findertype, "", CF_BUFSIZE) == 0)
     {
         return 0;
     }
@@ -3403,17 +3740,17 @@ static int VerifyFinderType(EvalContext *ctx, const char *file, Attributes a, co
 
     getattrlist(file, &attrs, &fndrInfo, sizeof(fndrInfo), 0);
 
-    if (fndrInfo.fi.fdType != *(long *) a.perms.findertype)
+    if (fndrInfo.fi.fdType != *(long *) a->perms.findertype)
     {
-        fndrInfo.fi.fdType = *(long *) a.perms.findertype;
+        fndrInfo.fi.fdType = *(long *) a->perms.findertype;
 
-        switch (a.transaction.action)
+        switch (a->transaction.action)
         {
         case cfa_fix:
 
             if (DONTDO)
             {
-                Log(LOG_LEVEL_INFO, "Promised to set Finder Type code of '%s' to '%s'", file, a.perms.findertype);
+                Log(LOG_LEVEL_INFO, "Promised to set Finder Type code of '%s' to '%s'", file, a->perms.findertype);
                 *result = PromiseResultUpdate(*result, PROMISE_RESULT_WARN);
                 return 0;
             }
@@ -3425,13 +3762,13 @@ static int VerifyFinderType(EvalContext *ctx, const char *file, Attributes a, co
 
             if (retval >= 0)
             {
-                cfPS(ctx, LOG_LEVEL_INFO, PROMISE_RESULT_CHANGE, pp, a, "Setting Finder Type code of '%s' to '%s'", file, a.perms.findertype);
+                cfPS(ctx, LOG_LEVEL_INFO, PROMISE_RESULT_CHANGE, pp, a, "Setting Finder Type code of '%s' to '%s'", file, a->perms.findertype);
                 *result = PromiseResultUpdate(*result, PROMISE_RESULT_CHANGE);
             }
             else
             {
                 cfPS(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_FAIL, pp, a, "Setting Finder Type code of '%s' to '%s' failed", file,
-                     a.perms.findertype);
+                     a->perms.findertype);
                 *result = PromiseResultUpdate(*result, PROMISE_RESULT_FAIL);
             }
 
@@ -3448,7 +3785,7 @@ static int VerifyFinderType(EvalContext *ctx, const char *file, Attributes a, co
     }
     else
     {
-        cfPS(ctx, LOG_LEVEL_VERBOSE, PROMISE_RESULT_NOOP, pp, a, "Finder Type code of '%s' to '%s' is as promised", file, a.perms.findertype);
+        cfPS(ctx, LOG_LEVEL_VERBOSE, PROMISE_RESULT_NOOP, pp, a, "Finder Type code of '%s' to '%s' is as promised", file, a->perms.findertype);
         *result = PromiseResultUpdate(*result, PROMISE_RESULT_NOOP);
         return 0;
     }
@@ -3478,7 +3815,7 @@ static void TruncateFile(char *name)
     }
 }
 
-static void RegisterAHardLink(int i, char *value, Attributes attr, CompressedArray **inode_cache)
+static void RegisterAHardLink(int i, char *value, const Attributes *attr, CompressedArray **inode_cache)
 {
     if (!FixCompressedArrayValue(i, value, inode_cache))
     {
@@ -3489,7 +3826,7 @@ static void RegisterAHardLink(int i, char *value, Attributes attr, CompressedArr
         }
         else
         {
-            if (attr.transaction.action == cfa_warn)
+            if (attr->transaction.action == cfa_warn)
             {
                 Log(LOG_LEVEL_WARNING, "Need to remove old hard link '%s' to preserve structure", value);
             }
@@ -3525,7 +3862,7 @@ static int cf_stat(const char *file, struct stat *buf, FileCopy fc, AgentConnect
 #ifndef __MINGW32__
 
 static int cf_readlink(EvalContext *ctx, char *sourcefile, char *linkbuf, int buffsize,
-                       Attributes attr, const Promise *pp, AgentConnection *conn, PromiseResult *result)
+                       const Attributes *attr, const Promise *pp, AgentConnection *conn, PromiseResult *result)
  /* wrapper for network access */
 {
     memset(linkbuf, 0, buffsize);
@@ -3534,11 +3871,11 @@ static int cf_readlink(EvalContext *ctx, char *sourcefile, char *linkbuf, int bu
     {
         return readlink(sourcefile, linkbuf, buffsize - 1);
     }
-    assert(attr.copy.servers &&
-           strcmp(RlistScalarValue(attr.copy.servers), "localhost"));
+    assert(attr->copy.servers &&
+           strcmp(RlistScalarValue(attr->copy.servers), "localhost"));
 
     const Stat *sp = StatCacheLookup(conn, sourcefile,
-                                     RlistScalarValue(attr.copy.servers));
+                                     RlistScalarValue(attr->copy.servers));
 
     if (sp)
     {
@@ -3590,7 +3927,7 @@ static int SkipDirLinks(EvalContext *ctx, char *path, const char *lastnode, Dire
 
 #ifndef __MINGW32__
 
-bool VerifyOwner(EvalContext *ctx, const char *file, const Promise *pp, Attributes attr, struct stat *sb, PromiseResult *result)
+bool VerifyOwner(EvalContext *ctx, const char *file, const Promise *pp, const Attributes *attr, struct stat *sb, PromiseResult *result)
 {
     struct passwd *pw;
     struct group *gp;
@@ -3602,7 +3939,7 @@ bool VerifyOwner(EvalContext *ctx, const char *file, const Promise *pp, Attribut
     gid_t gid = CF_UNKNOWN_GROUP;
 
     /* SKIP if file is already owned by anyone of the promised owners. */
-    for (ulp = attr.perms.owners; ulp != NULL; ulp = ulp->next)
+    for (ulp = attr->perms.owners; ulp != NULL; ulp = ulp->next)
     {
         if (ulp->uid == CF_SAME_OWNER || sb->st_uid == ulp->uid)        /* "same" matches anything */
         {
@@ -3614,7 +3951,7 @@ bool VerifyOwner(EvalContext *ctx, const char *file, const Promise *pp, Attribut
     if (uid != CF_SAME_OWNER)
     {
         /* Change ownership to the first known user in the promised list. */
-        for (ulp = attr.perms.owners; ulp != NULL; ulp = ulp->next)
+        for (ulp = attr->perms.owners; ulp != NULL; ulp = ulp->next)
         {
             if (ulp->uid != CF_UNKNOWN_OWNER)
             {
@@ -3634,7 +3971,7 @@ bool VerifyOwner(EvalContext *ctx, const char *file, const Promise *pp, Attribut
     assert(uid != CF_UNKNOWN_OWNER);
 
     /* SKIP if file is already group owned by anyone of the promised groups. */
-    for (glp = attr.perms.groups; glp != NULL; glp = glp->next)
+    for (glp = attr->perms.groups; glp != NULL; glp = glp->next)
     {
         if (glp->gid == CF_SAME_GROUP || sb->st_gid == glp->gid)
         {
@@ -3646,7 +3983,7 @@ bool VerifyOwner(EvalContext *ctx, const char *file, const Promise *pp, Attribut
     /* Change group ownership to the first known group in the promised list. */
     if (gid != CF_SAME_GROUP)
     {
-        for (glp = attr.perms.groups; glp != NULL; glp = glp->next)
+        for (glp = attr->perms.groups; glp != NULL; glp = glp->next)
         {
             if (glp->gid != CF_UNKNOWN_GROUP)
             {
@@ -3673,7 +4010,7 @@ bool VerifyOwner(EvalContext *ctx, const char *file, const Promise *pp, Attribut
     }
     else
     {
-        switch (attr.transaction.action)
+        switch (attr->transaction.action)
         {
         case cfa_fix:
 
@@ -3767,17 +4104,17 @@ bool VerifyOwner(EvalContext *ctx, const char *file, const Promise *pp, Attribut
 
 #endif /* !__MINGW32__ */
 
-static void VerifyFileChanges(const char *file, struct stat *sb, Attributes attr, const Promise *pp)
+static void VerifyFileChanges(const char *file, struct stat *sb, const Attributes *attr, const Promise *pp)
 {
-    if ((attr.change.report_changes != FILE_CHANGE_REPORT_STATS_CHANGE) && (attr.change.report_changes != FILE_CHANGE_REPORT_ALL))
+    if ((attr->change.report_changes != FILE_CHANGE_REPORT_STATS_CHANGE) && (attr->change.report_changes != FILE_CHANGE_REPORT_ALL))
     {
         return;
     }
 
-    FileChangesCheckAndUpdateStats(file, sb, attr.change.update, pp);
+    FileChangesCheckAndUpdateStats(file, sb, attr->change.update, pp);
 }
 
-bool CfCreateFile(EvalContext *ctx, char *file, const Promise *pp, Attributes attr, PromiseResult *result)
+bool CfCreateFile(EvalContext *ctx, char *file, const Promise *pp, const Attributes *attr, PromiseResult *result)
 {
     if (!IsAbsoluteFileName(file))
     {
@@ -3788,14 +4125,14 @@ bool CfCreateFile(EvalContext *ctx, char *file, const Promise *pp, Attributes at
     }
 
     /* If name ends in /., or depthsearch is set, then this is a directory */
-    bool is_dir = attr.havedepthsearch || (strcmp(".", ReadLastNode(file)) == 0);
+    bool is_dir = attr->havedepthsearch || (strcmp(".", ReadLastNode(file)) == 0);
     if (is_dir)
     {
         Log(LOG_LEVEL_DEBUG, "File object '%s' seems to be a directory", file);
 
-        if (!DONTDO && attr.transaction.action != cfa_warn)
+        if (!DONTDO && attr->transaction.action != cfa_warn)
         {
-            if (!MakeParentDirectory(file, attr.move_obstructions))
+            if (!MakeParentDirectory(file, attr->move_obstructions))
             {
                 cfPS(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_FAIL, pp, attr, "Error creating directories for '%s'. (creat: %s)",
                      file, GetErrorStr());
@@ -3813,7 +4150,7 @@ bool CfCreateFile(EvalContext *ctx, char *file, const Promise *pp, Attributes at
             return false;
         }
     }
-    else if (attr.file_type && !strncmp(attr.file_type, "fifo", 5))
+    else if (attr->file_type && !strncmp(attr->file_type, "fifo", 5))
     {
 #ifndef _WIN32
         if (!DONTDO)
@@ -3829,10 +4166,10 @@ bool CfCreateFile(EvalContext *ctx, char *file, const Promise *pp, Attributes at
             }
             else
             {
-                filemode = attr.perms.plus & ~(attr.perms.minus);
+                filemode = attr->perms.plus & ~(attr->perms.minus);
             }
 
-            MakeParentDirectory(file, attr.move_obstructions);
+            MakeParentDirectory(file, attr->move_obstructions);
 
             char errormsg[CF_BUFSIZE];
             if (!mkfifo(file, filemode))
@@ -3861,7 +4198,7 @@ bool CfCreateFile(EvalContext *ctx, char *file, const Promise *pp, Attributes at
     }
     else
     {
-        if (!DONTDO && attr.transaction.action != cfa_warn)
+        if (!DONTDO && attr->transaction.action != cfa_warn)
         {
             mode_t saveumask = umask(0);
             mode_t filemode = 0600;     /* Decide the mode for filecreation */
@@ -3874,10 +4211,10 @@ bool CfCreateFile(EvalContext *ctx, char *file, const Promise *pp, Attributes at
             }
             else
             {
-                filemode = attr.perms.plus & ~(attr.perms.minus);
+                filemode = attr->perms.plus & ~(attr->perms.minus);
             }
 
-            MakeParentDirectory(file, attr.move_obstructions);
+            MakeParentDirectory(file, attr->move_obstructions);
 
             int fd = safe_open(file, O_WRONLY | O_CREAT | O_EXCL, filemode);
             if (fd == -1)
@@ -72,7 +72,7 @@ PromiseResult VerifyMethodsPromise(EvalContext *ctx, const Promise *pp)
         destroy_name = true;
     }
 
-    PromiseResult result = VerifyMethod(ctx, method_name, a, pp);
+    PromiseResult result = VerifyMethod(ctx, method_name, &a, pp);
 
     if (destroy_name)
     {
@@ -84,7 +84,7 @@ PromiseResult VerifyMethodsPromise(EvalContext *ctx, const Promise *pp)
 
 /*****************************************************************************/
 
-PromiseResult VerifyMethod(EvalContext *ctx, const Rval call, Attributes a, const Promise *pp)
+PromiseResult VerifyMethod(EvalContext *ctx, const Rval call, const Attributes *a, const Promise *pp)
 {
     const Rlist *args = NULL;
     Buffer *method_name = BufferNew();
@@ -122,7 +122,7 @@ PromiseResult VerifyMethod(EvalContext *ctx, const Rval call, Attributes a, cons
     char lockname[CF_BUFSIZE];
     GetLockName(lockname, "method", pp->promiser, args);
 
-    CfLock thislock = AcquireLock(ctx, lockname, VUQNAME, CFSTARTTIME, a.transaction, pp, false);
+    CfLock thislock = AcquireLock(ctx, lockname, VUQNAME, CFSTARTTIME, a->transaction, pp, false);
     if (thislock.lock == NULL)
     {
         BufferDestroy(method_name);
@@ -142,7 +142,7 @@ PromiseResult VerifyMethod(EvalContext *ctx, const Rval call, Attributes a, cons
 
     if (bp)
     {
-        if (a.transaction.action == cfa_warn) // don't skip for dry-runs (ie ignore DONTDO)
+        if (a->transaction.action == cfa_warn) // don't skip for dry-runs (ie ignore DONTDO)
         {
             result = PROMISE_RESULT_WARN;
             cfPS(ctx, LOG_LEVEL_WARNING, result, pp, a, "Bundle '%s' should be invoked, but only a warning was promised!", BufferData(method_name));
@@ -150,7 +150,7 @@ PromiseResult VerifyMethod(EvalContext *ctx, const Rval call, Attributes a, cons
         else
         {
             BundleBanner(bp, args);
-            EvalContextStackPushBundleFrame(ctx, bp, args, a.inherit);
+            EvalContextStackPushBundleFrame(ctx, bp, args, a->inherit);
 
             /* Clear all array-variables that are already set in the sub-bundle.
                Otherwise, array-data accumulates between multiple bundle evaluations.
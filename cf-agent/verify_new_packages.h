@@ -28,7 +28,7 @@
 #include <cf3.defs.h>
 
 PromiseResult HandleNewPackagePromiseType(EvalContext *ctx, const Promise *pp,
-                                          Attributes a, char **promise_log_msg,
+                                          const Attributes *a, char **promise_log_msg,
                                           LogLevel *log_lvl);
 
 #endif
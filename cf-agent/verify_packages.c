@@ -104,29 +104,29 @@ typedef enum
     PACKAGE_PROMISE_TYPE_NEW_ERROR
 } PackagePromiseType;
 
-static int PackageSanityCheck(EvalContext *ctx, Attributes a, const Promise *pp);
+static int PackageSanityCheck(EvalContext *ctx, const Attributes *a, const Promise *pp);
 
-static int VerifyInstalledPackages(EvalContext *ctx, PackageManager **alllists, const char *default_arch, Attributes a, const Promise *pp, PromiseResult *result);
+static int VerifyInstalledPackages(EvalContext *ctx, PackageManager **alllists, const char *default_arch, const Attributes *a, const Promise *pp, PromiseResult *result);
 
-static PromiseResult VerifyPromisedPackage(EvalContext *ctx, Attributes a, const Promise *pp);
-static PromiseResult VerifyPromisedPatch(EvalContext *ctx, Attributes a, const Promise *pp);
+static PromiseResult VerifyPromisedPackage(EvalContext *ctx, const Attributes *a, const Promise *pp);
+static PromiseResult VerifyPromisedPatch(EvalContext *ctx, const Attributes *a, const Promise *pp);
 
 /** Utils **/
 
 static char *GetDefaultArch(const char *command);
 
-static bool ExecPackageCommand(EvalContext *ctx, char *command, int verify, int setCmdClasses, Attributes a, const Promise *pp, PromiseResult *result);
+static bool ExecPackageCommand(EvalContext *ctx, char *command, int verify, int setCmdClasses, const Attributes *a, const Promise *pp, PromiseResult *result);
 
-static int PrependPatchItem(EvalContext *ctx, PackageItem ** list, char *item, PackageItem * chklist, const char *default_arch, Attributes a, const Promise *pp);
-static int PrependMultiLinePackageItem(EvalContext *ctx, PackageItem ** list, char *item, int reset, const char *default_arch, Attributes a, const Promise *pp);
-static int PrependListPackageItem(EvalContext *ctx, PackageItem ** list, char *item, const char *default_arch, Attributes a, const Promise *pp);
+static int PrependPatchItem(EvalContext *ctx, PackageItem ** list, char *item, PackageItem * chklist, const char *default_arch, const Attributes *a, const Promise *pp);
+static int PrependMultiLinePackageItem(EvalContext *ctx, PackageItem ** list, char *item, int reset, const char *default_arch, const Attributes *a, const Promise *pp);
+static int PrependListPackageItem(EvalContext *ctx, PackageItem ** list, char *item, const char *default_arch, const Attributes *a, const Promise *pp);
 
 static PackageManager *GetPackageManager(PackageManager **lists, char *mgr, PackageAction pa, PackageActionPolicy x);
 static void DeletePackageManagers(PackageManager *morituri);
 
 static const char *PrefixLocalRepository(const Rlist *repositories, const char *package);
 
-PromiseResult HandleOldPackagePromiseType(EvalContext *ctx, const Promise *pp, Attributes a);
+PromiseResult HandleOldPackagePromiseType(EvalContext *ctx, const Promise *pp, const Attributes *a);
 
 ENTERPRISE_VOID_FUNC_1ARG_DEFINE_STUB(void, ReportPatches, ARG_UNUSED PackageManager *, list)
 {
@@ -188,14 +188,14 @@ PromiseResult VerifyPackagesPromise(EvalContext *ctx, const Promise *pp)
         case PACKAGE_PROMISE_TYPE_NEW:
             Log(LOG_LEVEL_VERBOSE, "Using new package promise.");
 
-            result = HandleNewPackagePromiseType(ctx, pp, a, &promise_log_message,
+            result = HandleNewPackagePromiseType(ctx, pp, &a, &promise_log_message,
                     &level);
             
             assert(promise_log_message != NULL);
             
             if (result != PROMISE_RESULT_SKIPPED)
             {
-                cfPS(ctx, level, result, pp, a, "%s", promise_log_message);
+                cfPS(ctx, level, result, pp, &a, "%s", promise_log_message);
             }
             free(promise_log_message);
             break;
@@ -206,7 +206,14 @@ PromiseResult VerifyPackagesPromise(EvalContext *ctx, const Promise *pp)
                 "implementation will continue to work, but forward development "
                 "will be directed toward the new implementation.");
 
-            result = HandleOldPackagePromiseType(ctx, pp, a);
+#ifdef __MINGW32__
+            if (!a.packages.package_list_command)
+            {
+                a.packages.package_list_command = PACKAGE_LIST_COMMAND_WINAPI;
+            }
+#endif
+
+            result = HandleOldPackagePromiseType(ctx, pp, &a);
         
             /* Update new package promise cache in case we have mixed old and new 
              * package promises in policy. */
@@ -216,15 +223,15 @@ PromiseResult VerifyPackagesPromise(EvalContext *ctx, const Promise *pp)
             }
             break;
         case PACKAGE_PROMISE_TYPE_NEW_ERROR:
-            cfPS_HELPER_0ARG(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_FAIL, pp, a, 
+            cfPS_HELPER_0ARG(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_FAIL, pp, &a, 
                          "New package promise failed sanity check.");
             break;
         case PACKAGE_PROMISE_TYPE_OLD_ERROR:
-            cfPS_HELPER_0ARG(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_FAIL, pp, a, 
+            cfPS_HELPER_0ARG(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_FAIL, pp, &a, 
                          "Old package promise failed sanity check.");
             break;
         case PACKAGE_PROMISE_TYPE_MIXED:
-            cfPS_HELPER_0ARG(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_FAIL, pp, a, 
+            cfPS_HELPER_0ARG(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_FAIL, pp, &a, 
                          "Mixed old and new package promise attributes inside "
                          "one package promise.");
             break;
@@ -243,8 +250,8 @@ PromiseResult VerifyPackagesPromise(EvalContext *ctx, const Promise *pp)
    Called by cf-agent.
 
    * checks "name", "version", "arch", "firstrepo" variables from the "this" context
-   * gets the package attributes into a
-   * on Windows, if the package_list_command is not defined, use the hard-coded PACKAGE_LIST_COMMAND_WINAPI
+   * gets the package attributes into a (on Windows, the caller has already
+     set the package_list_command to PACKAGE_LIST_COMMAND_WINAPI if undefined)
    * do a package sanity check on the promise
    * print promise banner
    * reset to root directory (Yum bugfix)
@@ -257,7 +264,7 @@ PromiseResult VerifyPackagesPromise(EvalContext *ctx, const Promise *pp)
    @param pp [in] the Promise for this operation
    @returns the promise result
 */
-PromiseResult HandleOldPackagePromiseType(EvalContext *ctx, const Promise *pp, Attributes a)
+PromiseResult HandleOldPackagePromiseType(EvalContext *ctx, const Promise *pp, const Attributes *a)
 {
     CfLock thislock;
     char lockname[CF_BUFSIZE];
@@ -276,15 +283,6 @@ PromiseResult HandleOldPackagePromiseType(EvalContext *ctx, const Promise *pp, A
         VarRefDestroy(var_ref);
     }
     
-#ifdef __MINGW32__
-
-    if(!a.packages.package_list_command)
-    {
-        a.packages.package_list_command = PACKAGE_LIST_COMMAND_WINAPI;
-    }
-
-#endif
-
     if (!PackageSanityCheck(ctx, a, pp))
     {
         Log(LOG_LEVEL_VERBOSE, "Package promise %s failed sanity check", pp->promiser);
@@ -306,9 +304,9 @@ PromiseResult HandleOldPackagePromiseType(EvalContext *ctx, const Promise *pp, A
         goto end;
     }
 
-    snprintf(lockname, CF_BUFSIZE - 1, "package-%s-%s", pp->promiser, a.packages.package_list_command);
+    snprintf(lockname, CF_BUFSIZE - 1, "package-%s-%s", pp->promiser, a->packages.package_list_command);
 
-    thislock = AcquireLock(ctx, lockname, VUQNAME, CFSTARTTIME, a.transaction, pp, false);
+    thislock = AcquireLock(ctx, lockname, VUQNAME, CFSTARTTIME, a->transaction, pp, false);
     if (thislock.lock == NULL)
     {
         YieldGlobalPackagePromiseLock(package_lock);
@@ -323,7 +321,7 @@ PromiseResult HandleOldPackagePromiseType(EvalContext *ctx, const Promise *pp, A
         Log(LOG_LEVEL_ERR, "Failed to chdir into '/'");
     }
 
-    char *default_arch = GetDefaultArch(a.packages.package_default_arch_command);
+    char *default_arch = GetDefaultArch(a->packages.package_default_arch_command);
 
     if (default_arch == NULL)
     {
@@ -347,7 +345,7 @@ PromiseResult HandleOldPackagePromiseType(EvalContext *ctx, const Promise *pp, A
 
     free(default_arch);
 
-    switch (a.packages.package_policy)
+    switch (a->packages.package_policy)
     {
     case PACKAGE_ACTION_PATCH:
         Log(LOG_LEVEL_VERBOSE, "Verifying patch action for promise %s", pp->promiser);
@@ -386,29 +384,29 @@ end:
    @returns the promise result
 */
 
-static int PackageSanityCheck(EvalContext *ctx, Attributes a, const Promise *pp)
+static int PackageSanityCheck(EvalContext *ctx, const Attributes *a, const Promise *pp)
 {
 #ifndef __MINGW32__  // Windows may use Win32 API for listing and parsing
 
-    if (a.packages.package_list_name_regex == NULL)
+    if (a->packages.package_list_name_regex == NULL)
     {
         cfPS_HELPER_0ARG(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_FAIL, pp, a,
              "You must supply a method for determining the name of existing packages e.g. use the standard library generic package_method");
         return false;
     }
 
-    if (a.packages.package_list_version_regex == NULL)
+    if (a->packages.package_list_version_regex == NULL)
     {
         cfPS_HELPER_0ARG(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_FAIL, pp, a,
              "You must supply a method for determining the version of existing packages e.g. use the standard library generic package_method");
         return false;
     }
 
-    if ((!a.packages.package_commands_useshell) && (a.packages.package_list_command) && (!IsExecutable(CommandArg0(a.packages.package_list_command))))
+    if ((!a->packages.package_commands_useshell) && (a->packages.package_list_command) && (!IsExecutable(CommandArg0(a->packages.package_list_command))))
     {
         cfPS_HELPER_1ARG(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_FAIL, pp, a,
              "The proposed package list command '%s' was not executable",
-             a.packages.package_list_command);
+             a->packages.package_list_command);
         return false;
     }
 
@@ -416,18 +414,18 @@ static int PackageSanityCheck(EvalContext *ctx, Attributes a, const Promise *pp)
 #endif /* !__MINGW32__ */
 
 
-    if ((a.packages.package_list_command == NULL) && (a.packages.package_file_repositories == NULL))
+    if ((a->packages.package_list_command == NULL) && (a->packages.package_file_repositories == NULL))
     {
         cfPS_HELPER_0ARG(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_FAIL, pp, a,
              "You must supply a method for determining the list of existing packages (a command or repository list) e.g. use the standard library generic package_method");
         return false;
     }
 
-    if (a.packages.package_file_repositories)
+    if (a->packages.package_file_repositories)
     {
         Rlist *rp;
 
-        for (rp = a.packages.package_file_repositories; rp != NULL; rp = rp->next)
+        for (rp = a->packages.package_file_repositories; rp != NULL; rp = rp->next)
         {
             if (strlen(RlistScalarValue(rp)) > CF_MAXVARSIZE - 1)
             {
@@ -437,16 +435,16 @@ static int PackageSanityCheck(EvalContext *ctx, Attributes a, const Promise *pp)
         }
     }
 
-    if ((a.packages.package_name_regex) || (a.packages.package_version_regex) || (a.packages.package_arch_regex))
+    if ((a->packages.package_name_regex) || (a->packages.package_version_regex) || (a->packages.package_arch_regex))
     {
-        if (a.packages.package_name_regex == NULL)
+        if (a->packages.package_name_regex == NULL)
         {
             cfPS_HELPER_0ARG(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_FAIL, pp, a, "You must supply name regex if you supplied version or arch regex for parsing promiser string");
             return false;
         }
-        if ((a.packages.package_name_regex) && (a.packages.package_version_regex) && (a.packages.package_arch_regex))
+        if ((a->packages.package_name_regex) && (a->packages.package_version_regex) && (a->packages.package_arch_regex))
         {
-            if ((a.packages.package_version) || (a.packages.package_architectures))
+            if ((a->packages.package_version) || (a->packages.package_architectures))
             {
                 cfPS_HELPER_0ARG(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_FAIL, pp, a,
                      "You must either supply all regexs for (name,version,arch) or a separate version number and architecture");
@@ -455,7 +453,7 @@ static int PackageSanityCheck(EvalContext *ctx, Attributes a, const Promise *pp)
         }
         else
         {
-            if ((a.packages.package_version) && (a.packages.package_architectures))
+            if ((a->packages.package_version) && (a->packages.package_architectures))
             {
                 cfPS_HELPER_0ARG(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_FAIL, pp, a,
                      "You must either supply all regexs for (name,version,arch) or a separate version number and architecture");
@@ -463,14 +461,14 @@ static int PackageSanityCheck(EvalContext *ctx, Attributes a, const Promise *pp)
             }
         }
 
-        if ((a.packages.package_version_regex) && (a.packages.package_version))
+        if ((a->packages.package_version_regex) && (a->packages.package_version))
         {
             cfPS_HELPER_0ARG(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_FAIL, pp, a,
                  "You must either supply version regex or a separate version number");
             return false;
         }
 
-        if ((a.packages.package_arch_regex) && (a.packages.package_architectures))
+        if ((a->packages.package_arch_regex) && (a->packages.package_architectures))
         {
             cfPS_HELPER_0ARG(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_FAIL, pp, a,
                  "You must either supply arch regex or a separate architecture");
@@ -478,21 +476,21 @@ static int PackageSanityCheck(EvalContext *ctx, Attributes a, const Promise *pp)
         }
     }
 
-    if (!a.packages.package_installed_regex)
+    if (!a->packages.package_installed_regex)
     {
         cfPS_HELPER_0ARG(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_FAIL, pp, a, "!! Package installed regex undefined");
         return false;
     }
 
-    if (a.packages.package_policy == PACKAGE_ACTION_VERIFY)
+    if (a->packages.package_policy == PACKAGE_ACTION_VERIFY)
     {
-        if (!a.packages.package_verify_command)
+        if (!a->packages.package_verify_command)
         {
             cfPS_HELPER_0ARG(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_FAIL, pp, a,
                  "!! Package verify policy is used, but no package_verify_command is defined");
             return false;
         }
-        else if ((a.packages.package_noverify_returncode == CF_NOINT) && (a.packages.package_noverify_regex == NULL))
+        else if ((a->packages.package_noverify_returncode == CF_NOINT) && (a->packages.package_noverify_regex == NULL))
         {
             cfPS_HELPER_0ARG(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_FAIL, pp, a,
                  "!! Package verify policy is used, but no definition of verification failiure is set (package_noverify_returncode or packages.package_noverify_regex)");
@@ -500,7 +498,7 @@ static int PackageSanityCheck(EvalContext *ctx, Attributes a, const Promise *pp)
         }
     }
 
-    if ((a.packages.package_noverify_returncode != CF_NOINT) && (a.packages.package_noverify_regex))
+    if ((a->packages.package_noverify_returncode != CF_NOINT) && (a->packages.package_noverify_regex))
     {
         cfPS_HELPER_0ARG(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_FAIL, pp, a,
              "!! Both package_noverify_returncode and package_noverify_regex are defined, pick one of them");
@@ -508,81 +506,81 @@ static int PackageSanityCheck(EvalContext *ctx, Attributes a, const Promise *pp)
     }
 
     /* Dependency checks */
-    if (!a.packages.package_delete_command)
+    if (!a->packages.package_delete_command)
     {
-        if (a.packages.package_delete_convention)
+        if (a->packages.package_delete_convention)
         {
             cfPS_HELPER_0ARG(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_FAIL, pp, a,
                  "!! Dependency conflict: package_delete_command is not used, but package_delete_convention is defined.");
             return false;
         }
     }
-    if (!a.packages.package_list_command)
+    if (!a->packages.package_list_command)
     {
-        if (a.packages.package_installed_regex)
+        if (a->packages.package_installed_regex)
         {
             cfPS_HELPER_0ARG(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_FAIL, pp, a,
                  "!! Dependency conflict: package_list_command is not used, but package_installed_regex is defined.");
             return false;
         }
-        if (a.packages.package_list_arch_regex)
+        if (a->packages.package_list_arch_regex)
         {
             cfPS_HELPER_0ARG(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_FAIL, pp, a,
                  "!! Dependency conflict: package_list_command is not used, but package_arch_regex is defined.");
             return false;
         }
-        if (a.packages.package_list_name_regex)
+        if (a->packages.package_list_name_regex)
         {
             cfPS_HELPER_0ARG(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_FAIL, pp, a,
                  "!! Dependency conflict: package_list_command is not used, but package_name_regex is defined.");
             return false;
         }
-        if (a.packages.package_list_version_regex)
+        if (a->packages.package_list_version_regex)
         {
             cfPS_HELPER_0ARG(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_FAIL, pp, a,
                  "!! Dependency conflict: package_list_command is not used, but package_version_regex is defined.");
             return false;
         }
     }
-    if (!a.packages.package_patch_command)
+    if (!a->packages.package_patch_command)
     {
-        if (a.packages.package_patch_arch_regex)
+        if (a->packages.package_patch_arch_regex)
         {
             cfPS_HELPER_0ARG(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_FAIL, pp, a,
                  "!! Dependency conflict: package_patch_command is not used, but package_patch_arch_regex is defined.");
             return false;
         }
-        if (a.packages.package_patch_name_regex)
+        if (a->packages.package_patch_name_regex)
         {
             cfPS_HELPER_0ARG(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_FAIL, pp, a,
                  "!! Dependency conflict: package_patch_command is not used, but package_patch_name_regex is defined.");
             return false;
         }
-        if (a.packages.package_patch_version_regex)
+        if (a->packages.package_patch_version_regex)
         {
             cfPS_HELPER_0ARG(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_FAIL, pp, a,
                  "!! Dependency conflict: package_patch_command is not used, but package_patch_version_regex is defined.");
             return false;
         }
     }
-    if (!a.packages.package_patch_list_command)
+    if (!a->packages.package_patch_list_command)
     {
-        if (a.packages.package_patch_installed_regex)
+        if (a->packages.package_patch_installed_regex)
         {
             cfPS_HELPER_0ARG(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_FAIL, pp, a,
                  "!! Dependency conflict: package_patch_list_command is not used, but package_patch_installed_regex is defined.");
             return false;
         }
     }
-    if (!a.packages.package_verify_command)
+    if (!a->packages.package_verify_command)
     {
-        if (a.packages.package_noverify_regex)
+        if (a->packages.package_noverify_regex)
         {
             cfPS_HELPER_0ARG(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_FAIL, pp, a,
                  "!! Dependency conflict: package_verify_command is not used, but package_noverify_regex is defined.");
             return false;
         }
-        if (a.packages.package_noverify_returncode != CF_NOINT)
+        if (a->packages.package_noverify_returncode != CF_NOINT)
         {
             cfPS_HELPER_0ARG(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_FAIL, pp, a,
                  "!! Dependency conflict: package_verify_command is not used, but package_noverify_returncode is defined.");
@@ -615,12 +613,12 @@ static int PackageSanityCheck(EvalContext *ctx, Attributes a, const Promise *pp)
 static bool PackageListInstalledFromCommand(EvalContext *ctx,
                                             PackageItem **installed_list,
                                             const char *default_arch,
-                                            Attributes a, const Promise *pp,
+                                            const Attributes *a, const Promise *pp,
                                             PromiseResult *result)
 {
-    if (a.packages.package_list_update_command != NULL)
+    if (a->packages.package_list_update_command != NULL)
     {
-        if (!a.packages.package_add_command)
+        if (!a->packages.package_add_command)
         {
             Log(LOG_LEVEL_ERR, "package_add_command missing while trying to "
                                "generate list of installed packages");
@@ -634,13 +632,13 @@ static bool PackageListInstalledFromCommand(EvalContext *ctx,
 
         snprintf(update_timestamp_file, sizeof(update_timestamp_file), "%s%csoftware_update_timestamp_%s",
                  GetStateDir(), FILE_SEPARATOR,
-                 ReadLastNode(RealPackageManager(a.packages.package_add_command)));
+                 ReadLastNode(RealPackageManager(a->packages.package_add_command)));
 
         if (stat(update_timestamp_file, &sb) != -1)
         {
-            if (a.packages.package_list_update_ifelapsed != CF_NOINT)
+            if (a->packages.package_list_update_ifelapsed != CF_NOINT)
             {
-                horizon = a.packages.package_list_update_ifelapsed;
+                horizon = a->packages.package_list_update_ifelapsed;
             }
 
             char *rel, *action;
@@ -656,7 +654,7 @@ static bool PackageListInstalledFromCommand(EvalContext *ctx,
                 action = "Updating";
             }
             Log(LOG_LEVEL_VERBOSE, "'%s' is %s than %i minutes old. %s package list.",
-                update_timestamp_file, rel, a.packages.package_list_update_ifelapsed, action);
+                update_timestamp_file, rel, a->packages.package_list_update_ifelapsed, action);
         }
         else
         {
@@ -665,8 +663,8 @@ static bool PackageListInstalledFromCommand(EvalContext *ctx,
 
         if (call_update)
         {
-            Log(LOG_LEVEL_VERBOSE, "Calling package list update command: '%s'", a.packages.package_list_update_command);
-            ExecPackageCommand(ctx, a.packages.package_list_update_command, false, false, a, pp, result);
+            Log(LOG_LEVEL_VERBOSE, "Calling package list update command: '%s'", a->packages.package_list_update_command);
+            ExecPackageCommand(ctx, a->packages.package_list_update_command, false, false, a, pp, result);
 
             // Touch timestamp file.
             int err = utime(update_timestamp_file, NULL);
@@ -694,23 +692,23 @@ static bool PackageListInstalledFromCommand(EvalContext *ctx,
         }
     }
 
-    Log(LOG_LEVEL_VERBOSE, "Reading package list from '%s'", a.packages.package_list_command);
+    Log(LOG_LEVEL_VERBOSE, "Reading package list from '%s'", a->packages.package_list_command);
 
     FILE *fin;
 
-    if (a.packages.package_commands_useshell)
+    if (a->packages.package_commands_useshell)
     {
-        if ((fin = cf_popen_sh(a.packages.package_list_command, "r")) == NULL)
+        if ((fin = cf_popen_sh(a->packages.package_list_command, "r")) == NULL)
         {
             Log(LOG_LEVEL_ERR, "Couldn't open the package list with command '%s'. (cf_popen_sh: %s)",
-                  a.packages.package_list_command, GetErrorStr());
+                  a->packages.package_list_command, GetErrorStr());
             return false;
         }
     }
-    else if ((fin = cf_popen(a.packages.package_list_command, "r", true)) == NULL)
+    else if ((fin = cf_popen(a->packages.package_list_command, "r", true)) == NULL)
     {
         Log(LOG_LEVEL_ERR, "Couldn't open the package list with command '%s'. (cf_popen: %s)",
-            a.packages.package_list_command, GetErrorStr());
+            a->packages.package_list_command, GetErrorStr());
         return false;
     }
 
@@ -727,7 +725,7 @@ static bool PackageListInstalledFromCommand(EvalContext *ctx,
             if (!feof(fin))
             {
                 Log(LOG_LEVEL_ERR, "Unable to read list of packages from command '%s'. (fread: %s)",
-                      a.packages.package_list_command, GetErrorStr());
+                      a->packages.package_list_command, GetErrorStr());
                 cf_pclose(fin);
                 free(buf);
                 return false;
@@ -738,9 +736,9 @@ static bool PackageListInstalledFromCommand(EvalContext *ctx,
             }
         }
 
-        if (a.packages.package_multiline_start)
+        if (a->packages.package_multiline_start)
         {
-            if (FullTextMatch(ctx, a.packages.package_multiline_start, buf))
+            if (FullTextMatch(ctx, a->packages.package_multiline_start, buf))
             {
                 PrependMultiLinePackageItem(ctx, installed_list, buf, reset, default_arch, a, pp);
             }
@@ -751,7 +749,7 @@ static bool PackageListInstalledFromCommand(EvalContext *ctx,
         }
         else
         {
-            if (!FullTextMatch(ctx, a.packages.package_installed_regex, buf))
+            if (!FullTextMatch(ctx, a->packages.package_installed_regex, buf))
             {
                 Log(LOG_LEVEL_VERBOSE, "Package line '%s' did not match the package_installed_regex pattern", buf);
                 continue;
@@ -766,7 +764,7 @@ static bool PackageListInstalledFromCommand(EvalContext *ctx,
         }
     }
 
-    if (a.packages.package_multiline_start)
+    if (a->packages.package_multiline_start)
     {
         PrependMultiLinePackageItem(ctx, installed_list, buf, reset, default_arch, a, pp);
     }
@@ -874,7 +872,7 @@ static void InvalidateSoftwareCache(void)
    @param pp [in] the Promise for this operation
    @returns list of PackageItems
 */
-static PackageItem *GetCachedPackageList(EvalContext *ctx, PackageManager *manager, const char *default_arch, Attributes a,
+static PackageItem *GetCachedPackageList(EvalContext *ctx, PackageManager *manager, const char *default_arch, const Attributes *a,
                                          const Promise *pp)
 {
     PackageItem *list = NULL;
@@ -891,9 +889,9 @@ static PackageItem *GetCachedPackageList(EvalContext *ctx, PackageManager *manag
         return NULL;
     }
 
-    if (a.packages.package_list_update_ifelapsed != CF_NOINT)
+    if (a->packages.package_list_update_ifelapsed != CF_NOINT)
     {
-        horizon = a.packages.package_list_update_ifelapsed;
+        horizon = a->packages.package_list_update_ifelapsed;
     }
 
     if (now - sb.st_mtime < horizon * 60)
@@ -985,13 +983,13 @@ static PackageItem *GetCachedPackageList(EvalContext *ctx, PackageManager *manag
    @returns boolean pass/fail of verification
 */
 static int VerifyInstalledPackages(EvalContext *ctx, PackageManager **all_mgrs, const char *default_arch,
-                                   Attributes a, const Promise *pp, PromiseResult *result)
+                                   const Attributes *a, const Promise *pp, PromiseResult *result)
 {
-    PackageManager *manager = GetPackageManager(all_mgrs, a.packages.package_list_command, PACKAGE_ACTION_NONE, PACKAGE_ACTION_POLICY_NONE);
+    PackageManager *manager = GetPackageManager(all_mgrs, a->packages.package_list_command, PACKAGE_ACTION_NONE, PACKAGE_ACTION_POLICY_NONE);
 
     if (manager == NULL)
     {
-        Log(LOG_LEVEL_ERR, "Can't create a package manager envelope for '%s'", a.packages.package_list_command);
+        Log(LOG_LEVEL_ERR, "Can't create a package manager envelope for '%s'", a->packages.package_list_command);
         return false;
     }
 
@@ -1009,12 +1007,12 @@ static int VerifyInstalledPackages(EvalContext *ctx, PackageManager **all_mgrs,
         return true;
     }
 
-    if (a.packages.package_list_command == NULL)
+    if (a->packages.package_list_command == NULL)
     {
         /* skip */
     }
 #ifdef __MINGW32__
-    else if (strcmp(a.packages.package_list_command, PACKAGE_LIST_COMMAND_WINAPI) == 0)
+    else if (strcmp(a->packages.package_list_command, PACKAGE_LIST_COMMAND_WINAPI) == 0)
     {
         if (!NovaWin_PackageListInstalledFromAPI(ctx, &(manager->pack_list), a, pp))
         {
@@ -1036,32 +1034,32 @@ static int VerifyInstalledPackages(EvalContext *ctx, PackageManager **all_mgrs,
 
 /* Now get available updates */
 
-    if (a.packages.package_patch_list_command != NULL)
+    if (a->packages.package_patch_list_command != NULL)
     {
-            Log(LOG_LEVEL_VERBOSE, "Reading patches from '%s'", CommandArg0(a.packages.package_patch_list_command));
+            Log(LOG_LEVEL_VERBOSE, "Reading patches from '%s'", CommandArg0(a->packages.package_patch_list_command));
 
-        if ((!a.packages.package_commands_useshell) && (!IsExecutable(CommandArg0(a.packages.package_patch_list_command))))
+        if ((!a->packages.package_commands_useshell) && (!IsExecutable(CommandArg0(a->packages.package_patch_list_command))))
         {
             Log(LOG_LEVEL_ERR, "The proposed patch list command '%s' was not executable",
-                  a.packages.package_patch_list_command);
+                  a->packages.package_patch_list_command);
             return false;
         }
 
         FILE *fin;
 
-        if (a.packages.package_commands_useshell)
+        if (a->packages.package_commands_useshell)
         {
-            if ((fin = cf_popen_sh(a.packages.package_patch_list_command, "r")) == NULL)
+            if ((fin = cf_popen_sh(a->packages.package_patch_list_command, "r")) == NULL)
             {
                 Log(LOG_LEVEL_ERR, "Couldn't open the patch list with command '%s'. (cf_popen_sh: %s)",
-                      a.packages.package_patch_list_command, GetErrorStr());
+                      a->packages.package_patch_list_command, GetErrorStr());
                 return false;
             }
         }
-        else if ((fin = cf_popen(a.packages.package_patch_list_command, "r", true)) == NULL)
+        else if ((fin = cf_popen(a->packages.package_patch_list_command, "r", true)) == NULL)
         {
             Log(LOG_LEVEL_ERR, "Couldn't open the patch list with command '%s'. (cf_popen: %s)",
-                  a.packages.package_patch_list_command, GetErrorStr());
+                  a->packages.package_patch_list_command, GetErrorStr());
             return false;
         }
 
@@ -1076,7 +1074,7 @@ static int VerifyInstalledPackages(EvalContext *ctx, PackageManager **all_mgrs,
                 if (!feof(fin))
                 {
                     Log(LOG_LEVEL_ERR, "Unable to read list of patches from command '%s'. (fread: %s)",
-                          a.packages.package_patch_list_command, GetErrorStr());
+                          a->packages.package_patch_list_command, GetErrorStr());
                     cf_pclose(fin);
                     free(vbuff);
                     return false;
@@ -1088,8 +1086,8 @@ static int VerifyInstalledPackages(EvalContext *ctx, PackageManager **all_mgrs,
             }
 
             // assume patch_list_command lists available patches/updates by default
-            if ((a.packages.package_patch_installed_regex == NULL)
-                || (!FullTextMatch(ctx, a.packages.package_patch_installed_regex, vbuff)))
+            if ((a->packages.package_patch_installed_regex == NULL)
+                || (!FullTextMatch(ctx, a->packages.package_patch_installed_regex, vbuff)))
             {
                 PrependPatchItem(ctx, &(manager->patch_avail), vbuff, manager->patch_list, default_arch, a, pp);
                 continue;
@@ -1105,7 +1103,7 @@ static int VerifyInstalledPackages(EvalContext *ctx, PackageManager **all_mgrs,
         free(vbuff);
     }
 
-    if (a.packages.package_patch_list_command != NULL)
+    if (a->packages.package_patch_list_command != NULL)
     {
         ReportPatches(INSTALLED_PACKAGE_LISTS); // Enterprise only
     }
@@ -1141,7 +1139,7 @@ static int VerifyInstalledPackages(EvalContext *ctx, PackageManager **all_mgrs,
    @returns boolean pass/fail of search
 */
 int FindLargestVersionAvail(EvalContext *ctx, char *matchName, char *matchVers, const char *refAnyVer, const char *ver,
-                            Rlist *repositories, Attributes a, const Promise *pp, PromiseResult *result)
+                            Rlist *repositories, const Attributes *a, const Promise *pp, PromiseResult *result)
 /* Returns true if a version gt/ge ver is found in local repos, false otherwise */
 {
     int match = false;
@@ -1217,13 +1215,13 @@ int FindLargestVersionAvail(EvalContext *ctx, char *matchName, char *matchVers,
    @param result [inout] the PromiseResult for this operation
    @returns boolean if given (n,v,a) is newer than known packages
 */
-static int IsNewerThanInstalled(EvalContext *ctx, const char *n, const char *v, const char *a, char *instV, char *instA, Attributes attr,
+static int IsNewerThanInstalled(EvalContext *ctx, const char *n, const char *v, const char *a, char *instV, char *instA, const Attributes *attr,
                                 const Promise *pp, PromiseResult *result)
 {
     PackageManager *mp = INSTALLED_PACKAGE_LISTS;
     while (mp != NULL)
     {
-        if (strcmp(mp->manager, attr.packages.package_list_command) == 0)
+        if (strcmp(mp->manager, attr->packages.package_list_command) == 0)
         {
             break;
         }
@@ -1232,8 +1230,8 @@ static int IsNewerThanInstalled(EvalContext *ctx, const char *n, const char *v,
 
     if (mp == NULL)
     {
-        Log(LOG_LEVEL_VERBOSE, "Found no package manager matching attr.packages.package_list_command '%s'",
-            attr.packages.package_list_command == NULL ? "[empty]" : attr.packages.package_list_command);
+        Log(LOG_LEVEL_VERBOSE, "Found no package manager matching attr->packages.package_list_command '%s'",
+            attr->packages.package_list_command == NULL ? "[empty]" : attr->packages.package_list_command);
         return false;
     }
 
@@ -1252,10 +1250,10 @@ static int IsNewerThanInstalled(EvalContext *ctx, const char *n, const char *v,
             strlcpy(instA, pi->arch, CF_MAXVARSIZE);
 
             /* Horrible */
-            Attributes attr2 = attr;
+            Attributes attr2 = *attr;
             attr2.packages.package_select = PACKAGE_VERSION_COMPARATOR_LT;
 
-            return CompareVersions(ctx, pi->version, v, attr2, pp, result) == VERCMP_MATCH;
+            return CompareVersions(ctx, pi->version, v, &attr2, pp, result) == VERCMP_MATCH;
         }
     }
 
@@ -1319,7 +1317,7 @@ static PromiseResult AddPackageToSchedule(EvalContext *ctx, const Attributes *a,
     {
     case cfa_warn:
 
-        cfPS_HELPER_3ARG(ctx, LOG_LEVEL_WARNING, PROMISE_RESULT_WARN, pp, *a, "Need to repair promise '%s' by '%s' package '%s'",
+        cfPS_HELPER_3ARG(ctx, LOG_LEVEL_WARNING, PROMISE_RESULT_WARN, pp, a, "Need to repair promise '%s' by '%s' package '%s'",
              pp->promiser, PackageAction2String(pa), name);
         return PROMISE_RESULT_WARN;
 
@@ -1367,7 +1365,7 @@ static PromiseResult AddPatchToSchedule(EvalContext *ctx, const Attributes *a, c
     {
     case cfa_warn:
 
-        cfPS_HELPER_3ARG(ctx, LOG_LEVEL_WARNING, PROMISE_RESULT_WARN, pp, *a, "Need to repair promise '%s' by '%s' package '%s'",
+        cfPS_HELPER_3ARG(ctx, LOG_LEVEL_WARNING, PROMISE_RESULT_WARN, pp, a, "Need to repair promise '%s' by '%s' package '%s'",
              pp->promiser, PackageAction2String(pa), name);
         return PROMISE_RESULT_WARN;
 
@@ -1453,7 +1451,7 @@ static PromiseResult AddPatchToSchedule(EvalContext *ctx, const Attributes *a, c
    @returns the promise result
 */
 static PromiseResult SchedulePackageOp(EvalContext *ctx, const char *name, const char *version, const char *arch, int installed, int matched,
-                                       int no_version_specified, Attributes a, const Promise *pp)
+                                       int no_version_specified, const Attributes *a, const Promise *pp)
 {
     char refAnyVerEsc[CF_EXPANDSIZE];
     char largestVerAvail[CF_MAXVARSIZE];
@@ -1468,7 +1466,7 @@ static PromiseResult SchedulePackageOp(EvalContext *ctx, const char *name, const
 /* Now we need to know the name-convention expected by the package manager */
 
     Buffer *expanded = BufferNew();
-    if ((a.packages.package_name_convention) || (a.packages.package_delete_convention))
+    if ((a->packages.package_name_convention) || (a->packages.package_delete_convention))
     {
         VarRef *ref_name = VarRefParseFromScope("name", PACKAGES_CONTEXT);
         EvalContextVariablePut(ctx, ref_name, name, CF_DATA_TYPE_STRING, "source=promise");
@@ -1479,14 +1477,14 @@ static PromiseResult SchedulePackageOp(EvalContext *ctx, const char *name, const
         VarRef *ref_arch = VarRefParseFromScope("arch", PACKAGES_CONTEXT);
         EvalContextVariablePut(ctx, ref_arch, arch, CF_DATA_TYPE_STRING, "source=promise");
 
-        if ((a.packages.package_delete_convention) && (a.packages.package_policy == PACKAGE_ACTION_DELETE))
+        if ((a->packages.package_delete_convention) && (a->packages.package_policy == PACKAGE_ACTION_DELETE))
         {
-            ExpandScalar(ctx, NULL, PACKAGES_CONTEXT, a.packages.package_delete_convention, expanded);
+            ExpandScalar(ctx, NULL, PACKAGES_CONTEXT, a->packages.package_delete_convention, expanded);
             strlcpy(id, BufferData(expanded), CF_EXPANDSIZE);
         }
-        else if (a.packages.package_name_convention)
+        else if (a->packages.package_name_convention)
         {
-            ExpandScalar(ctx, NULL, PACKAGES_CONTEXT, a.packages.package_name_convention, expanded);
+            ExpandScalar(ctx, NULL, PACKAGES_CONTEXT, a->packages.package_name_convention, expanded);
             strlcpy(id, BufferData(expanded), CF_EXPANDSIZE);
         }
         else
@@ -1518,7 +1516,7 @@ static PromiseResult SchedulePackageOp(EvalContext *ctx, const char *name, const
 
     // This is very confusing
     int package_select_in_range;
-    switch (a.packages.package_select)
+    switch (a->packages.package_select)
     {
     case PACKAGE_VERSION_COMPARATOR_EQ:
     case PACKAGE_VERSION_COMPARATOR_GE:
@@ -1533,7 +1531,7 @@ static PromiseResult SchedulePackageOp(EvalContext *ctx, const char *name, const
         break;
     }
 
-    PackageAction policy = a.packages.package_policy;
+    PackageAction policy = a->packages.package_policy;
     if (policy == PACKAGE_ACTION_ADDUPDATE) /* Work out which: */
     {
         if (installed)
@@ -1553,7 +1551,7 @@ static PromiseResult SchedulePackageOp(EvalContext *ctx, const char *name, const
 
         if (installed == 0)
         {
-            if ((a.packages.package_file_repositories != NULL))
+            if ((a->packages.package_file_repositories != NULL))
             {
                 Log(LOG_LEVEL_VERBOSE, "Package method specifies a file repository");
 
@@ -1568,9 +1566,9 @@ static PromiseResult SchedulePackageOp(EvalContext *ctx, const char *name, const
                     EvalContextVariablePut(ctx, ref_arch, arch, CF_DATA_TYPE_STRING, "source=promise");
 
                     BufferClear(expanded);
-                    if (a.packages.package_name_convention)
+                    if (a->packages.package_name_convention)
                     {
-                        ExpandScalar(ctx, NULL, PACKAGES_CONTEXT_ANYVER, a.packages.package_name_convention, expanded);
+                        ExpandScalar(ctx, NULL, PACKAGES_CONTEXT_ANYVER, a->packages.package_name_convention, expanded);
                     }
 
                     EvalContextVariableRemove(ctx, ref_name);
@@ -1586,7 +1584,7 @@ static PromiseResult SchedulePackageOp(EvalContext *ctx, const char *name, const
                 EscapeSpecialChars(BufferData(expanded), refAnyVerEsc, sizeof(refAnyVerEsc), "(.*)","");
 
                 if (FindLargestVersionAvail(ctx, largestPackAvail, largestVerAvail, refAnyVerEsc, version,
-                                            a.packages.package_file_repositories, a, pp, &result))
+                                            a->packages.package_file_repositories, a, pp, &result))
                 {
                     Log(LOG_LEVEL_VERBOSE, "Using latest version in file repositories; '%s'", largestPackAvail);
                     strlcpy(id, largestPackAvail, CF_EXPANDSIZE);
@@ -1604,14 +1602,14 @@ static PromiseResult SchedulePackageOp(EvalContext *ctx, const char *name, const
 
             Log(LOG_LEVEL_VERBOSE, "Schedule package for addition");
 
-            if (a.packages.package_add_command == NULL)
+            if (a->packages.package_add_command == NULL)
             {
                 cfPS_HELPER_0ARG(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_FAIL, pp, a, "Package add command undefined");
                 BufferDestroy(expanded);
                 return PROMISE_RESULT_FAIL;
             }
             result = PromiseResultUpdate_HELPER(pp, result,
-                                         AddPackageToSchedule(ctx, &a, a.packages.package_add_command,
+                                         AddPackageToSchedule(ctx, a, a->packages.package_add_command,
                                                               PACKAGE_ACTION_ADD, id, "any", "any", pp));
         }
         else
@@ -1629,14 +1627,14 @@ static PromiseResult SchedulePackageOp(EvalContext *ctx, const char *name, const
         {
             Log(LOG_LEVEL_VERBOSE, "Schedule package for deletion");
 
-            if (a.packages.package_delete_command == NULL)
+            if (a->packages.package_delete_command == NULL)
             {
                 cfPS_HELPER_0ARG(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_FAIL, pp, a, "Package delete command undefined");
                 BufferDestroy(expanded);
                 return PROMISE_RESULT_FAIL;
             }
             // expand local repository in the name convention, if present
-            if (a.packages.package_file_repositories)
+            if (a->packages.package_file_repositories)
             {
                 Log(LOG_LEVEL_VERBOSE, "Package method specifies a file repository");
 
@@ -1647,7 +1645,7 @@ static PromiseResult SchedulePackageOp(EvalContext *ctx, const char *name, const
                     const char *idBuf = id + 12;
 
                     // and add the correct repo
-                    const char *pathName = PrefixLocalRepository(a.packages.package_file_repositories, idBuf);
+                    const char *pathName = PrefixLocalRepository(a->packages.package_file_repositories, idBuf);
 
                     if (pathName)
                     {
@@ -1668,7 +1666,7 @@ static PromiseResult SchedulePackageOp(EvalContext *ctx, const char *name, const
             }
 
             result = PromiseResultUpdate_HELPER(pp, result,
-                                         AddPackageToSchedule(ctx, &a, a.packages.package_delete_command,
+                                         AddPackageToSchedule(ctx, a, a->packages.package_delete_command,
                                                               PACKAGE_ACTION_DELETE, id, "any", "any", pp));
         }
         else
@@ -1678,7 +1676,7 @@ static PromiseResult SchedulePackageOp(EvalContext *ctx, const char *name, const
         break;
 
     case PACKAGE_ACTION_REINSTALL:
-        if (a.packages.package_delete_command == NULL)
+        if (a->packages.package_delete_command == NULL)
         {
             cfPS_HELPER_0ARG(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_FAIL, pp, a, "Package delete command undefined");
             BufferDestroy(expanded);
@@ -1688,7 +1686,7 @@ static PromiseResult SchedulePackageOp(EvalContext *ctx, const char *name, const
         if (!no_version_specified)
         {
             Log(LOG_LEVEL_VERBOSE, "Schedule package for reinstallation");
-            if (a.packages.package_add_command == NULL)
+            if (a->packages.package_add_command == NULL)
             {
                 cfPS_HELPER_0ARG(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_FAIL, pp, a, "Package add command undefined");
                 BufferDestroy(expanded);
@@ -1700,12 +1698,12 @@ static PromiseResult SchedulePackageOp(EvalContext *ctx, const char *name, const
                 (installed && no_version_specified))
             {
                 result = PromiseResultUpdate_HELPER(pp, result,
-                                             AddPackageToSchedule(ctx, &a, a.packages.package_delete_command,
+                                             AddPackageToSchedule(ctx, a, a->packages.package_delete_command,
                                                                   PACKAGE_ACTION_DELETE, id, "any", "any", pp));
             }
 
             result = PromiseResultUpdate_HELPER(pp, result,
-                                         AddPackageToSchedule(ctx, &a, a.packages.package_add_command,
+                                         AddPackageToSchedule(ctx, a, a->packages.package_add_command,
                                                               PACKAGE_ACTION_ADD, id, "any", "any", pp));
         }
         else
@@ -1724,7 +1722,7 @@ static PromiseResult SchedulePackageOp(EvalContext *ctx, const char *name, const
         *inst_ver = '\0';
         *inst_arch = '\0';
 
-        if ((a.packages.package_file_repositories != NULL))
+        if ((a->packages.package_file_repositories != NULL))
         {
             Log(LOG_LEVEL_VERBOSE, "Package method specifies a file repository");
 
@@ -1739,7 +1737,7 @@ static PromiseResult SchedulePackageOp(EvalContext *ctx, const char *name, const
                 EvalContextVariablePut(ctx, ref_arch, arch, CF_DATA_TYPE_STRING, "source=promise");
 
                 BufferClear(expanded);
-                ExpandScalar(ctx, NULL, PACKAGES_CONTEXT_ANYVER, a.packages.package_name_convention, expanded);
+                ExpandScalar(ctx, NULL, PACKAGES_CONTEXT_ANYVER, a->packages.package_name_convention, expanded);
 
                 EvalContextVariableRemove(ctx, ref_name);
                 VarRefDestroy(ref_name);
@@ -1755,7 +1753,7 @@ static PromiseResult SchedulePackageOp(EvalContext *ctx, const char *name, const
             EscapeSpecialChars(BufferData(expanded), refAnyVerEsc, sizeof(refAnyVerEsc), "(.*)","");
 
             if (FindLargestVersionAvail(ctx, largestPackAvail, largestVerAvail, refAnyVerEsc, version,
-                                        a.packages.package_file_repositories, a, pp, &result))
+                                        a->packages.package_file_repositories, a, pp, &result))
             {
                 Log(LOG_LEVEL_VERBOSE, "Using latest version in file repositories; '%s'", largestPackAvail);
                 strlcpy(id, largestPackAvail, CF_EXPANDSIZE);
@@ -1792,13 +1790,13 @@ static PromiseResult SchedulePackageOp(EvalContext *ctx, const char *name, const
         if (installed ||
             (matched && package_select_in_range && !no_version_specified))
         {
-            if (a.packages.package_update_command == NULL)
+            if (a->packages.package_update_command == NULL)
             {
                 Log(LOG_LEVEL_VERBOSE, "Package update command undefined - failing over to delete then add");
 
                 // we need to have the version of installed package
                 const char *id_del = id;
-                if (a.packages.package_delete_convention)
+                if (a->packages.package_delete_convention)
                 {
                     if (*inst_ver == '\0')
                     {
@@ -1822,7 +1820,7 @@ static PromiseResult SchedulePackageOp(EvalContext *ctx, const char *name, const
                     EvalContextVariablePut(ctx, ref_arch, inst_arch, CF_DATA_TYPE_STRING, "source=promise");
 
                     BufferClear(expanded);
-                    ExpandScalar(ctx, NULL, PACKAGES_CONTEXT, a.packages.package_delete_convention, expanded);
+                    ExpandScalar(ctx, NULL, PACKAGES_CONTEXT, a->packages.package_delete_convention, expanded);
                     id_del = BufferData(expanded);
 
                     EvalContextVariableRemove(ctx, ref_name);
@@ -1837,31 +1835,31 @@ static PromiseResult SchedulePackageOp(EvalContext *ctx, const char *name, const
 
                 Log(LOG_LEVEL_VERBOSE, "Scheduling package with id '%s' for deletion", id_del);
 
-                if (a.packages.package_add_command == NULL)
+                if (a->packages.package_add_command == NULL)
                 {
                     cfPS_HELPER_0ARG(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_FAIL, pp, a, "Package add command undefined");
                     BufferDestroy(expanded);
                     return PROMISE_RESULT_FAIL;
                 }
-                if (a.packages.package_delete_command == NULL)
+                if (a->packages.package_delete_command == NULL)
                 {
                     cfPS_HELPER_0ARG(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_FAIL, pp, a, "Package delete command undefined");
                     BufferDestroy(expanded);
                     return PROMISE_RESULT_FAIL;
                 }
                 result = PromiseResultUpdate_HELPER(pp, result,
-                                             AddPackageToSchedule(ctx, &a, a.packages.package_delete_command,
+                                             AddPackageToSchedule(ctx, a, a->packages.package_delete_command,
                                                                   PACKAGE_ACTION_DELETE, id_del, "any", "any", pp));
 
                 result = PromiseResultUpdate_HELPER(pp, result,
-                                             AddPackageToSchedule(ctx, &a, a.packages.package_add_command,
+                                             AddPackageToSchedule(ctx, a, a->packages.package_add_command,
                                                                   PACKAGE_ACTION_ADD, id, "any", "any", pp));
             }
             else
             {
                 Log(LOG_LEVEL_VERBOSE, "Schedule package for update");
                 result = PromiseResultUpdate_HELPER(pp, result,
-                                             AddPackageToSchedule(ctx, &a, a.packages.package_update_command,
+                                             AddPackageToSchedule(ctx, a, a->packages.package_update_command,
                                                                   PACKAGE_ACTION_UPDATE, id, "any", "any", pp));
             }
         }
@@ -1879,7 +1877,7 @@ static PromiseResult SchedulePackageOp(EvalContext *ctx, const char *name, const
         {
             Log(LOG_LEVEL_VERBOSE, "Schedule package for patching");
             result = PromiseResultUpdate_HELPER(pp, result,
-                                         AddPatchToSchedule(ctx, &a, a.packages.package_patch_command,
+                                         AddPatchToSchedule(ctx, a, a->packages.package_patch_command,
                                                             PACKAGE_ACTION_PATCH, id, "any", "any", pp));
         }
         else
@@ -1896,7 +1894,7 @@ static PromiseResult SchedulePackageOp(EvalContext *ctx, const char *name, const
         {
             Log(LOG_LEVEL_VERBOSE, "Schedule package for verification");
             result = PromiseResultUpdate_HELPER(pp, result,
-                                         AddPackageToSchedule(ctx, &a, a.packages.package_verify_command,
+                                         AddPackageToSchedule(ctx, a, a->packages.package_verify_command,
                                                               PACKAGE_ACTION_VERIFY, id, "any", "any", pp));
         }
         else
@@ -1937,14 +1935,14 @@ static PromiseResult SchedulePackageOp(EvalContext *ctx, const char *name, const
 */
 VersionCmpResult ComparePackages(EvalContext *ctx,
                                  const char *n, const char *v, const char *arch,
-                                 PackageItem *pi, Attributes a,
+                                 PackageItem *pi, const Attributes *a,
                                  const Promise *pp,
                                  const char *mode,
                                  PromiseResult *result)
 {
     Log(LOG_LEVEL_VERBOSE, "Comparing %s package (%s,%s,%s) "
         "to [%s] with given (%s,%s,%s) [name,version,arch]",
-        mode, pi->name, pi->version, pi->arch, PackageVersionComparatorToString(a.packages.package_select), n, v, arch);
+        mode, pi->name, pi->version, pi->arch, PackageVersionComparatorToString(a->packages.package_select), n, v, arch);
 
     if (CompareCSVName(n, pi->name) != 0)
     {
@@ -1980,7 +1978,7 @@ VersionCmpResult ComparePackages(EvalContext *ctx,
         vc == VERCMP_MATCH ? "MATCH" : vc == VERCMP_NO_MATCH ? "NO_MATCH" : "ERROR",
         mode,
         pi->name, pi->version, pi->arch,
-        PackageVersionComparatorToString(a.packages.package_select),
+        PackageVersionComparatorToString(a->packages.package_select),
         n, v, arch);
 
     return vc;
@@ -2009,7 +2007,7 @@ VersionCmpResult ComparePackages(EvalContext *ctx,
 */
 static VersionCmpResult PatchMatch(EvalContext *ctx,
                                    const char *n, const char *v, const char *a,
-                                   Attributes attr, const Promise *pp,
+                                   const Attributes *attr, const Promise *pp,
                                    const char* mode,
                                    PromiseResult *result)
 {
@@ -2018,14 +2016,14 @@ static VersionCmpResult PatchMatch(EvalContext *ctx,
     // This REALLY needs some commenting
     for (mp = INSTALLED_PACKAGE_LISTS; mp != NULL; mp = mp->next)
     {
-        if (strcmp(mp->manager, attr.packages.package_list_command) == 0)
+        if (strcmp(mp->manager, attr->packages.package_list_command) == 0)
         {
             break;
         }
     }
 
     Log(LOG_LEVEL_VERBOSE, "PatchMatch: looking for %s to [%s] with given (%s,%s,%s) [name,version,arch] in package manager %s",
-        mode, PackageVersionComparatorToString(attr.packages.package_select), n, v, a, mp->manager);
+        mode, PackageVersionComparatorToString(attr->packages.package_select), n, v, a, mp->manager);
 
     for (PackageItem *pi = mp->patch_list; pi != NULL; pi = pi->next)
     {
@@ -2071,7 +2069,7 @@ static VersionCmpResult PatchMatch(EvalContext *ctx,
 */
 static VersionCmpResult PackageMatch(EvalContext *ctx,
                                      const char *n, const char *v, const char *a,
-                                     Attributes attr,
+                                     const Attributes *attr,
                                      const Promise *pp,
                                      const char* mode,
                                      PromiseResult *result)
@@ -2085,7 +2083,7 @@ static VersionCmpResult PackageMatch(EvalContext *ctx,
     // This REALLY needs some commenting
     for (mp = INSTALLED_PACKAGE_LISTS; mp != NULL; mp = mp->next)
     {
-        if (strcmp(mp->manager, attr.packages.package_list_command) == 0)
+        if (strcmp(mp->manager, attr->packages.package_list_command) == 0)
         {
             break;
         }
@@ -2127,9 +2125,9 @@ static VersionCmpResult PackageMatch(EvalContext *ctx,
    @param installed [in] whether the package is installed
    @returns whether the package operation should be scheduled
 */
-static int WillSchedulePackageOperation(EvalContext *ctx, Attributes a, const Promise *pp, int matches, int installed)
+static int WillSchedulePackageOperation(EvalContext *ctx, const Attributes *a, const Promise *pp, int matches, int installed)
 {
-    PackageAction policy = a.packages.package_policy;
+    PackageAction policy = a->packages.package_policy;
 
     Log(LOG_LEVEL_DEBUG, "WillSchedulePackageOperation: on entry, action %s: package %s matches = %s, installed = %s.",
         PackageAction2String(policy), pp->promiser, matches ? "yes" : "no", installed ? "yes" : "no");
@@ -2206,38 +2204,38 @@ static int WillSchedulePackageOperation(EvalContext *ctx, Attributes a, const Pr
    @param no_version [in] ignore the version, be cool
    @returns the promise result
 */
-static PromiseResult CheckPackageState(EvalContext *ctx, Attributes a, const Promise *pp, const char *name, const char *version,
+static PromiseResult CheckPackageState(EvalContext *ctx, const Attributes *a, const Promise *pp, const char *name, const char *version,
                                        const char *arch, bool no_version)
 {
     PromiseResult result = PROMISE_RESULT_NOOP;
 
     /* Horrible */
-    Attributes a2 = a;
+    Attributes a2 = *a;
     a2.packages.package_select = PACKAGE_VERSION_COMPARATOR_EQ;
 
-    VersionCmpResult installed = PackageMatch(ctx, name, "*", arch, a2, pp, "[installed]", &result);
+    VersionCmpResult installed = PackageMatch(ctx, name, "*", arch, &a2, pp, "[installed]", &result);
     Log(LOG_LEVEL_VERBOSE, "CheckPackageState: Installed package match for (%s,%s,%s) [name,version,arch] was decisive: %s",
         name, "*", arch, installed == VERCMP_MATCH ? "MATCH" : "ERROR-OR-NOMATCH");
 
     if (installed == VERCMP_ERROR)
     {
-        cfPS_HELPER_0ARG(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_FAIL, pp, a2, "Failure trying to compare installed package versions");
+        cfPS_HELPER_0ARG(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_FAIL, pp, &a2, "Failure trying to compare installed package versions");
         result = PromiseResultUpdate_HELPER(pp, result, PROMISE_RESULT_FAIL);
         return result;
     }
 
-    VersionCmpResult matches = PackageMatch(ctx, name, version, arch, a2, pp, "[available]", &result);
+    VersionCmpResult matches = PackageMatch(ctx, name, version, arch, &a2, pp, "[available]", &result);
     Log(LOG_LEVEL_VERBOSE, "CheckPackageState: Available package match for (%s,%s,%s) [name,version,arch] was decisive: %s",
         name, version, arch, matches == VERCMP_MATCH ? "MATCH" : "ERROR-OR-NOMATCH");
 
     if (matches == VERCMP_ERROR)
     {
-        cfPS_HELPER_0ARG(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_FAIL, pp, a2, "Failure trying to compare available package versions");
+        cfPS_HELPER_0ARG(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_FAIL, pp, &a2, "Failure trying to compare available package versions");
         result = PromiseResultUpdate_HELPER(pp, result, PROMISE_RESULT_FAIL);
         return result;
     }
 
-    if (WillSchedulePackageOperation(ctx, a2, pp, matches, installed))
+    if (WillSchedulePackageOperation(ctx, &a2, pp, matches, installed))
     {
         Log(LOG_LEVEL_VERBOSE, "CheckPackageState: matched package (%s,%s,%s) [name,version,arch]; scheduling operation", name, version, arch);
         return SchedulePackageOp(ctx, name, version, arch, installed, matches, no_version, a, pp);
@@ -2281,7 +2279,7 @@ static PromiseResult CheckPackageState(EvalContext *ctx, Attributes a, const Pro
    @param pp [in] the Promise for this operation
    @returns the promise result (failure or NOOP)
 */
-static PromiseResult VerifyPromisedPatch(EvalContext *ctx, Attributes a, const Promise *pp)
+static PromiseResult VerifyPromisedPatch(EvalContext *ctx, const Attributes *a, const Promise *pp)
 {
     char version[CF_MAXVARSIZE];
     char name[CF_MAXVARSIZE];
@@ -2291,7 +2289,7 @@ static PromiseResult VerifyPromisedPatch(EvalContext *ctx, Attributes a, const P
     Rlist *rp;
 
     /* Horrible */
-    Attributes a2 = a;
+    Attributes a2 = *a;
     a2.packages.package_select = PACKAGE_VERSION_COMPARATOR_EQ;
 
     PromiseResult result = PROMISE_RESULT_NOOP;
@@ -2305,12 +2303,12 @@ static PromiseResult VerifyPromisedPatch(EvalContext *ctx, Attributes a, const P
             strlcpy(arch,
                     (rp == NULL) ? "*" : RlistScalarValue(rp),
                     CF_MAXVARSIZE);
-            VersionCmpResult installed1 = PatchMatch(ctx, name, "*", "*", a2, pp, "[installed1]", &result);
-            VersionCmpResult matches1 = PatchMatch(ctx, name, version, arch, a2, pp, "[available1]", &result);
+            VersionCmpResult installed1 = PatchMatch(ctx, name, "*", "*", &a2, pp, "[installed1]", &result);
+            VersionCmpResult matches1 = PatchMatch(ctx, name, version, arch, &a2, pp, "[available1]", &result);
 
             if ((installed1 == VERCMP_ERROR) || (matches1 == VERCMP_ERROR))
             {
-                cfPS_HELPER_0ARG(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_FAIL, pp, a2, "Failure trying to compare package versions");
+                cfPS_HELPER_0ARG(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_FAIL, pp, &a2, "Failure trying to compare package versions");
                 result = PromiseResultUpdate_HELPER(pp, result, PROMISE_RESULT_FAIL);
                 return result;
             }
@@ -2327,12 +2325,12 @@ static PromiseResult VerifyPromisedPatch(EvalContext *ctx, Attributes a, const P
         strlcpy(version, ExtractFirstReference(a2.packages.package_version_regex, package), CF_MAXVARSIZE);
         strlcpy(name, ExtractFirstReference(a2.packages.package_name_regex, package), CF_MAXVARSIZE);
         strlcpy(arch, ExtractFirstReference(a2.packages.package_arch_regex, package), CF_MAXVARSIZE);
-        installed = PatchMatch(ctx, name, "*", "*", a2, pp, "[installed]", &result);
-        matches = PatchMatch(ctx, name, version, arch, a2, pp, "[available]", &result);
+        installed = PatchMatch(ctx, name, "*", "*", &a2, pp, "[installed]", &result);
+        matches = PatchMatch(ctx, name, version, arch, &a2, pp, "[available]", &result);
 
         if ((installed == VERCMP_ERROR) || (matches == VERCMP_ERROR))
         {
-            cfPS_HELPER_0ARG(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_FAIL, pp, a2, "Failure trying to compare package versions");
+            cfPS_HELPER_0ARG(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_FAIL, pp, &a2, "Failure trying to compare package versions");
             result = PromiseResultUpdate_HELPER(pp, result, PROMISE_RESULT_FAIL);
             return result;
         }
@@ -2349,12 +2347,12 @@ static PromiseResult VerifyPromisedPatch(EvalContext *ctx, Attributes a, const P
             strlcpy(arch,
                     (rp == NULL) ? "*" : RlistScalarValue(rp),
                     CF_MAXVARSIZE);
-            VersionCmpResult installed1 = PatchMatch(ctx, name, "*", "*", a2, pp, "[installed1]", &result);
-            VersionCmpResult matches1 = PatchMatch(ctx, name, version, arch, a2, pp, "[available1]", &result);
+            VersionCmpResult installed1 = PatchMatch(ctx, name, "*", "*", &a2, pp, "[installed1]", &result);
+            VersionCmpResult matches1 = PatchMatch(ctx, name, version, arch, &a2, pp, "[available1]", &result);
 
             if ((installed1 == VERCMP_ERROR) || (matches1 == VERCMP_ERROR))
             {
-                cfPS_HELPER_0ARG(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_FAIL, pp, a2, "Failure trying to compare package versions");
+                cfPS_HELPER_0ARG(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_FAIL, pp, &a2, "Failure trying to compare package versions");
                 result = PromiseResultUpdate_HELPER(pp, result, PROMISE_RESULT_FAIL);
                 return result;
             }
@@ -2397,43 +2395,43 @@ static PromiseResult VerifyPromisedPatch(EvalContext *ctx, Attributes a, const P
    @param pp [in] the Promise for this operation
    @returns the promise result as set by CheckPackageState
 */
-static PromiseResult VerifyPromisedPackage(EvalContext *ctx, Attributes a, const Promise *pp)
+static PromiseResult VerifyPromisedPackage(EvalContext *ctx, const Attributes *a, const Promise *pp)
 {
     const char *package = pp->promiser;
 
     PromiseResult result = PROMISE_RESULT_NOOP;
-    if (a.packages.package_version)
+    if (a->packages.package_version)
     {
         /* The version is specified separately */
-        Log(LOG_LEVEL_VERBOSE, "Package version %s specified explicitly in promise body", a.packages.package_version);
+        Log(LOG_LEVEL_VERBOSE, "Package version %s specified explicitly in promise body", a->packages.package_version);
 
-        if (a.packages.package_architectures == NULL)
+        if (a->packages.package_architectures == NULL)
         {
             Log(LOG_LEVEL_VERBOSE, " ... trying any arch '*'");
-            result = PromiseResultUpdate_HELPER(pp, result, CheckPackageState(ctx, a, pp, package, a.packages.package_version, "*", false));
+            result = PromiseResultUpdate_HELPER(pp, result, CheckPackageState(ctx, a, pp, package, a->packages.package_version, "*", false));
         }
         else
         {
-            for (Rlist *rp = a.packages.package_architectures; rp != NULL; rp = rp->next)
+            for (Rlist *rp = a->packages.package_architectures; rp != NULL; rp = rp->next)
             {
                 Log(LOG_LEVEL_VERBOSE, " ... trying listed arch '%s'", RlistScalarValue(rp));
                 result = PromiseResultUpdate_HELPER(pp, result,
-                                             CheckPackageState(ctx, a, pp, package, a.packages.package_version,
+                                             CheckPackageState(ctx, a, pp, package, a->packages.package_version,
                                                                RlistScalarValue(rp), false));
             }
         }
     }
-    else if (a.packages.package_version_regex)
+    else if (a->packages.package_version_regex)
     {
         /* The name, version and arch are to be extracted from the promiser */
-        Log(LOG_LEVEL_VERBOSE, "Package version %s specified implicitly in promiser's name", a.packages.package_version_regex);
+        Log(LOG_LEVEL_VERBOSE, "Package version %s specified implicitly in promiser's name", a->packages.package_version_regex);
 
         char version[CF_MAXVARSIZE];
         char name[CF_MAXVARSIZE];
         char arch[CF_MAXVARSIZE];
-        strlcpy(version, ExtractFirstReference(a.packages.package_version_regex, package), CF_MAXVARSIZE);
-        strlcpy(name, ExtractFirstReference(a.packages.package_name_regex, package), CF_MAXVARSIZE);
-        strlcpy(arch, ExtractFirstReference(a.packages.package_arch_regex, package), CF_MAXVARSIZE);
+        strlcpy(version, ExtractFirstReference(a->packages.package_version_regex, package), CF_MAXVARSIZE);
+        strlcpy(name, ExtractFirstReference(a->packages.package_name_regex, package), CF_MAXVARSIZE);
+        strlcpy(arch, ExtractFirstReference(a->packages.package_arch_regex, package), CF_MAXVARSIZE);
 
         if (!arch[0])
         {
@@ -2452,14 +2450,14 @@ static PromiseResult VerifyPromisedPackage(EvalContext *ctx, Attributes a, const
     {
         Log(LOG_LEVEL_VERBOSE, "Package version was not specified");
 
-        if (a.packages.package_architectures == NULL)
+        if (a->packages.package_architectures == NULL)
         {
             Log(LOG_LEVEL_VERBOSE, " ... trying any arch '*' and any version '*'");
             result = PromiseResultUpdate_HELPER(pp, result, CheckPackageState(ctx, a, pp, package, "*", "*", true));
         }
         else
         {
-            for (Rlist *rp = a.packages.package_architectures; rp != NULL; rp = rp->next)
+            for (Rlist *rp = a->packages.package_architectures; rp != NULL; rp = rp->next)
             {
                 Log(LOG_LEVEL_VERBOSE, " ... trying listed arch '%s' and any version '*'", RlistScalarValue(rp));
                 result = PromiseResultUpdate_HELPER(pp, result, CheckPackageState(ctx, a, pp, package, "*", RlistScalarValue(rp), true));
@@ -2642,7 +2640,7 @@ static bool ExecuteSchedule(EvalContext *ctx, const PackageManager *schedule, Pa
             EvalContextStackPushPromiseFrame(ctx, pp);
             if (EvalContextStackPushPromiseIterationFrame(ctx, NULL))
             {
-                if (ExecPackageCommand(ctx, command_string, verify, true, a, pp, &result))
+                if (ExecPackageCommand(ctx, command_string, verify, true, &a, pp, &result))
                 {
                     Log(LOG_LEVEL_VERBOSE, "Package schedule execution ok (outcome cannot be promised by cf-agent)");
                 }
@@ -2695,7 +2693,7 @@ static bool ExecuteSchedule(EvalContext *ctx, const PackageManager *schedule, Pa
                     EvalContextStackPushPromiseFrame(ctx, ppi);
                     if (EvalContextStackPushPromiseIterationFrame(ctx, NULL))
                     {
-                        if (ExecPackageCommand(ctx, command_string, verify, true, a, ppi, &result))
+                        if (ExecPackageCommand(ctx, command_string, verify, true, &a, ppi, &result))
                         {
                             Log(LOG_LEVEL_VERBOSE,
                                 "Package schedule execution ok for '%s' (outcome cannot be promised by cf-agent)",
@@ -2756,7 +2754,7 @@ static bool ExecuteSchedule(EvalContext *ctx, const PackageManager *schedule, Pa
                     EvalContextStackPushPromiseFrame(ctx, pp);
                     if (EvalContextStackPushPromiseIterationFrame(ctx, NULL))
                     {
-                        bool ok = ExecPackageCommand(ctx, command_string, verify, true, a, pp, &result);
+                        bool ok = ExecPackageCommand(ctx, command_string, verify, true, &a, pp, &result);
 
                         for (const PackageItem *pi = pm->pack_list; pi != NULL; pi = pi->next)
                         {
@@ -2913,7 +2911,7 @@ static bool ExecutePatch(EvalContext *ctx, const PackageManager *schedule, Packa
             EvalContextStackPushPromiseFrame(ctx, pp);
             if (EvalContextStackPushPromiseIterationFrame(ctx, NULL))
             {
-                if (ExecPackageCommand(ctx, command_string, false, true, a, pp, &result))
+                if (ExecPackageCommand(ctx, command_string, false, true, &a, pp, &result))
                 {
                     Log(LOG_LEVEL_VERBOSE, "Package patching seemed to succeed (outcome cannot be promised by cf-agent)");
                 }
@@ -2946,7 +2944,7 @@ static bool ExecutePatch(EvalContext *ctx, const PackageManager *schedule, Packa
                     EvalContextStackPushPromiseFrame(ctx, pp);
                     if (EvalContextStackPushPromiseIterationFrame(ctx, NULL))
                     {
-                        if (ExecPackageCommand(ctx, command_string, false, true, a, pp, &result))
+                        if (ExecPackageCommand(ctx, command_string, false, true, &a, pp, &result))
                         {
                             Log(LOG_LEVEL_VERBOSE,
                                 "Package schedule execution ok for '%s' (outcome cannot be promised by cf-agent)",
@@ -2985,7 +2983,7 @@ static bool ExecutePatch(EvalContext *ctx, const PackageManager *schedule, Packa
                 EvalContextStackPushPromiseFrame(ctx, pp);
                 if (EvalContextStackPushPromiseIterationFrame(ctx, NULL))
                 {
-                    bool ok = ExecPackageCommand(ctx, command_string, false, true, a, pp, &result);
+                    bool ok = ExecPackageCommand(ctx, command_string, false, true, &a, pp, &result);
 
                     for (const PackageItem *pi = pm->patch_list; pi != NULL; pi = pi->next)
                     {
@@ -3198,7 +3196,7 @@ const char *PrefixLocalRepository(const Rlist *repositories, const char *package
     return NULL;
 }
 
-bool ExecPackageCommand(EvalContext *ctx, char *command, int verify, int setCmdClasses, Attributes a,
+bool ExecPackageCommand(EvalContext *ctx, char *command, int verify, int setCmdClasses, const Attributes *a,
                         const Promise *pp, PromiseResult *result)
 {
     bool retval = true;
@@ -3206,7 +3204,7 @@ bool ExecPackageCommand(EvalContext *ctx, char *command, int verify, int setCmdC
     FILE *pfp;
     int packmanRetval = 0;
 
-    if ((!a.packages.package_commands_useshell) && (!IsExecutable(CommandArg0(command))))
+    if ((!a->packages.package_commands_useshell) && (!IsExecutable(CommandArg0(command))))
     {
         cfPS_HELPER_1ARG(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_FAIL, pp, a, "The proposed package schedule command '%s' was not executable", command);
         *result = PromiseResultUpdate_HELPER(pp, *result, PROMISE_RESULT_FAIL);
@@ -3220,7 +3218,7 @@ bool ExecPackageCommand(EvalContext *ctx, char *command, int verify, int setCmdC
 
 /* Use this form to avoid limited, intermediate argument processing - long lines */
 
-    if (a.packages.package_commands_useshell)
+    if (a->packages.package_commands_useshell)
     {
         Log(LOG_LEVEL_VERBOSE, "Running %s in shell", command);
         if ((pfp = cf_popen_sh(command, "r")) == NULL)
@@ -3282,9 +3280,9 @@ bool ExecPackageCommand(EvalContext *ctx, char *command, int verify, int setCmdC
 
         if (verify && (line[0] != '\0'))
         {
-            if (a.packages.package_noverify_regex)
+            if (a->packages.package_noverify_regex)
             {
-                if (FullTextMatch(ctx, a.packages.package_noverify_regex, line))
+                if (FullTextMatch(ctx, a->packages.package_noverify_regex, line))
                 {
                     cfPS_HELPER_2ARG(ctx, LOG_LEVEL_INFO, PROMISE_RESULT_FAIL, pp, a, "Package verification error in %-.40s ... :%s", cmd, lineSafe);
                     *result = PromiseResultUpdate_HELPER(pp, *result, PROMISE_RESULT_FAIL);
@@ -3298,9 +3296,9 @@ bool ExecPackageCommand(EvalContext *ctx, char *command, int verify, int setCmdC
 
     packmanRetval = cf_pclose(pfp);
 
-    if (verify && (a.packages.package_noverify_returncode != CF_NOINT))
+    if (verify && (a->packages.package_noverify_returncode != CF_NOINT))
     {
-        if (a.packages.package_noverify_returncode == packmanRetval)
+        if (a->packages.package_noverify_returncode == packmanRetval)
         {
             cfPS_HELPER_1ARG(ctx, LOG_LEVEL_INFO, PROMISE_RESULT_FAIL, pp, a, "Package verification error (returned %d)", packmanRetval);
             *result = PromiseResultUpdate_HELPER(pp, *result, PROMISE_RESULT_FAIL);
@@ -3312,7 +3310,7 @@ bool ExecPackageCommand(EvalContext *ctx, char *command, int verify, int setCmdC
             *result = PromiseResultUpdate_HELPER(pp, *result, PROMISE_RESULT_FAIL);
         }
     }
-    else if (verify && (a.packages.package_noverify_regex))
+    else if (verify && (a->packages.package_noverify_regex))
     {
         if (retval)             // set status if we succeeded above
         {
@@ -3379,21 +3377,21 @@ static int PackageInItemList(PackageItem * list, char *name, char *version, char
 }
 
 static int PrependPatchItem(EvalContext *ctx, PackageItem ** list, char *item, PackageItem * chklist, const char *default_arch,
-                            Attributes a, const Promise *pp)
+                            const Attributes *a, const Promise *pp)
 {
     char name[CF_MAXVARSIZE];
     char arch[CF_MAXVARSIZE];
     char version[CF_MAXVARSIZE];
     char vbuff[CF_MAXVARSIZE];
 
-    strlcpy(vbuff, ExtractFirstReference(a.packages.package_patch_name_regex, item), CF_MAXVARSIZE);
+    strlcpy(vbuff, ExtractFirstReference(a->packages.package_patch_name_regex, item), CF_MAXVARSIZE);
     sscanf(vbuff, "%s", name);  /* trim */
-    strlcpy(vbuff, ExtractFirstReference(a.packages.package_patch_version_regex, item), CF_MAXVARSIZE);
+    strlcpy(vbuff, ExtractFirstReference(a->packages.package_patch_version_regex, item), CF_MAXVARSIZE);
     sscanf(vbuff, "%s", version);       /* trim */
 
-    if (a.packages.package_patch_arch_regex)
+    if (a->packages.package_patch_arch_regex)
     {
-        strlcpy(vbuff, ExtractFirstReference(a.packages.package_patch_arch_regex, item), CF_MAXVARSIZE );
+        strlcpy(vbuff, ExtractFirstReference(a->packages.package_patch_arch_regex, item), CF_MAXVARSIZE );
         sscanf(vbuff, "%s", arch);      /* trim */
     }
     else
@@ -3419,7 +3417,7 @@ static int PrependPatchItem(EvalContext *ctx, PackageItem ** list, char *item, P
 }
 
 static int PrependMultiLinePackageItem(EvalContext *ctx, PackageItem ** list, char *item, int reset, const char *default_arch,
-                                       Attributes a, const Promise *pp)
+                                       const Attributes *a, const Promise *pp)
 {
     static char name[CF_MAXVARSIZE] = ""; /* GLOBAL_X */
     static char arch[CF_MAXVARSIZE] = ""; /* GLOBAL_X */
@@ -3444,23 +3442,23 @@ static int PrependMultiLinePackageItem(EvalContext *ctx, PackageItem ** list, ch
         strcpy(arch, default_arch);
     }
 
-    if (FullTextMatch(ctx, a.packages.package_list_name_regex, item))
+    if (FullTextMatch(ctx, a->packages.package_list_name_regex, item))
     {
-        strlcpy(vbuff, ExtractFirstReference(a.packages.package_list_name_regex, item), CF_MAXVARSIZE);
+        strlcpy(vbuff, ExtractFirstReference(a->packages.package_list_name_regex, item), CF_MAXVARSIZE);
         sscanf(vbuff, "%s", name);      /* trim */
     }
 
-    if (FullTextMatch(ctx, a.packages.package_list_version_regex, item))
+    if (FullTextMatch(ctx, a->packages.package_list_version_regex, item))
     {
-        strlcpy(vbuff, ExtractFirstReference(a.packages.package_list_version_regex, item), CF_MAXVARSIZE );
+        strlcpy(vbuff, ExtractFirstReference(a->packages.package_list_version_regex, item), CF_MAXVARSIZE );
         sscanf(vbuff, "%s", version);   /* trim */
     }
 
-    if ((a.packages.package_list_arch_regex) && (FullTextMatch(ctx, a.packages.package_list_arch_regex, item)))
+    if ((a->packages.package_list_arch_regex) && (FullTextMatch(ctx, a->packages.package_list_arch_regex, item)))
     {
-        if (a.packages.package_list_arch_regex)
+        if (a->packages.package_list_arch_regex)
         {
-            strlcpy(vbuff, ExtractFirstReference(a.packages.package_list_arch_regex, item), CF_MAXVARSIZE);
+            strlcpy(vbuff, ExtractFirstReference(a->packages.package_list_arch_regex, item), CF_MAXVARSIZE);
             sscanf(vbuff, "%s", arch);  /* trim */
         }
     }
@@ -3469,7 +3467,7 @@ static int PrependMultiLinePackageItem(EvalContext *ctx, PackageItem ** list, ch
 }
 
 static int PrependListPackageItem(EvalContext *ctx, PackageItem ** list,
-                                  char *item, const char *default_arch, Attributes a,
+                                  char *item, const char *default_arch, const Attributes *a,
                                   const Promise *pp)
 {
     char name[CF_MAXVARSIZE];
@@ -3477,15 +3475,15 @@ static int PrependListPackageItem(EvalContext *ctx, PackageItem ** list,
     char version[CF_MAXVARSIZE];
     char vbuff[CF_MAXVARSIZE];
 
-    strlcpy(vbuff, ExtractFirstReference(a.packages.package_list_name_regex, item), CF_MAXVARSIZE);
+    strlcpy(vbuff, ExtractFirstReference(a->packages.package_list_name_regex, item), CF_MAXVARSIZE);
     sscanf(vbuff, "%s", name);  /* trim */
 
-    strlcpy(vbuff, ExtractFirstReference(a.packages.package_list_version_regex, item), CF_MAXVARSIZE);
+    strlcpy(vbuff, ExtractFirstReference(a->packages.package_list_version_regex, item), CF_MAXVARSIZE);
     sscanf(vbuff, "%s", version);       /* trim */
 
-    if (a.packages.package_list_arch_regex)
+    if (a->packages.package_list_arch_regex)
     {
-        strlcpy(vbuff, ExtractFirstReference(a.packages.package_list_arch_regex, item), CF_MAXVARSIZE);
+        strlcpy(vbuff, ExtractFirstReference(a->packages.package_list_arch_regex, item), CF_MAXVARSIZE);
         sscanf(vbuff, "%s", arch);      /* trim */
     }
     else
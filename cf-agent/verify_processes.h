@@ -31,6 +31,6 @@ PromiseResult VerifyProcessesPromise(EvalContext *ctx, const Promise *pp);
 
 /* To be implemented in Nova for Win32 */
 
-int DoAllSignals(EvalContext *ctx, Item *siglist, Attributes a, const Promise *pp, PromiseResult *result);
+int DoAllSignals(EvalContext *ctx, Item *siglist, const Attributes *a, const Promise *pp, PromiseResult *result);
 
 #endif
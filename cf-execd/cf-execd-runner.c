@@ -350,33 +350,10 @@ static bool LineIsFiltered(const ExecConfig *config,
                            const char *line)
 {
     // Check whether the line matches mail filters
-    int include_filter_len = SeqLength(config->mailfilter_include_regex);
-    int exclude_filter_len = SeqLength(config->mailfilter_exclude_regex);
     // Count messages as matched in include set if there is no include set.
-    bool included = (include_filter_len == 0);
-    bool excluded = false;
-    if (include_filter_len > 0)
-    {
-        for (int i = 0; i < include_filter_len; i++)
-        {
-            if (StringMatchFullWithPrecompiledRegex(SeqAt(config->mailfilter_include_regex, i),
-                                                    line))
-            {
-                included = true;
-            }
-        }
-    }
-    if (exclude_filter_len > 0)
-    {
-        for (int i = 0; i < exclude_filter_len; i++)
-        {
-            if (StringMatchFullWithPrecompiledRegex(SeqAt(config->mailfilter_exclude_regex, i),
-                                                    line))
-            {
-                excluded = true;
-            }
-        }
-    }
+    bool included = (RegexSetLength(config->mailfilter_include_regex) == 0 ||
+                     RegexSetMatchFull(config->mailfilter_include_regex, line) >= 0);
+    bool excluded = (RegexSetMatchFull(config->mailfilter_exclude_regex, line) >= 0);
     return !included || excluded;
 }
 
@@ -51,13 +51,7 @@ static char *GetIpAddresses(const EvalContext *ctx)
     return StringWriterClose(ipbuf);
 }
 
-static void RegexFree(void *ptr)
-{
-    pcre_free(ptr);
-}
-
-static void MailFilterFill(const char *str,
-                           Seq **output, Seq **output_regex,
+static void MailFilterFill(const char *str, Seq *output,
                            const char *filter_type)
 {
     const char *errorstr;
@@ -75,43 +69,39 @@ static void MailFilterFill(const char *str,
     }
     else
     {
-        SeqAppend(*output, xstrdup(str));
-        SeqAppend(*output_regex, rx);
+        pcre_free(rx);
+        SeqAppend(output, xstrdup(str));
     }
 }
 
 static void RlistMailFilterFill(const Rlist *input,
-                                Seq **output, Seq **output_regex,
+                                Seq **output, RegexSet **output_regex,
                                 const char *filter_type)
 {
-    int len = RlistLen(input);
-
-    *output = SeqNew(len, &free);
-    *output_regex = SeqNew(len, &RegexFree);
+    *output = SeqNew(RlistLen(input), &free);
 
-    const Rlist *ptr = input;
-    for (int i = 0; i < len; i++)
+    for (const Rlist *ptr = input; ptr != NULL; ptr = ptr->next)
     {
-        const char *str = ptr->val.item;
-        MailFilterFill(str, output, output_regex, filter_type);
-
-        ptr = ptr->next;
+        MailFilterFill(ptr->val.item, *output, filter_type);
     }
+
+    *output_regex = RegexSetNew(*output);
 }
 
 static void SeqMailFilterFill(const Seq *input,
-                           Seq **output, Seq **output_regex,
-                           const char *filter_type)
+                              Seq **output, RegexSet **output_regex,
+                              const char *filter_type)
 {
     int len = SeqLength(input);
 
     *output = SeqNew(len, &free);
-    *output_regex = SeqNew(len, &RegexFree);
 
     for (int i = 0; i < len; i++)
     {
-        MailFilterFill(SeqAt(input, i), output, output_regex, filter_type);
+        MailFilterFill(SeqAt(input, i), *output, filter_type);
     }
+
+    *output_regex = RegexSetNew(*output);
 }
 
 ExecConfig *ExecConfigNew(bool scheduled_run, const EvalContext *ctx, const Policy *policy)
@@ -128,9 +118,9 @@ ExecConfig *ExecConfigNew(bool scheduled_run, const EvalContext *ctx, const Poli
     exec_config->mail_subject = xstrdup("");
     exec_config->mail_max_lines = 30;
     exec_config->mailfilter_include = SeqNew(0, &free);
-    exec_config->mailfilter_include_regex = SeqNew(0, &RegexFree);
+    exec_config->mailfilter_include_regex = RegexSetNew(exec_config->mailfilter_include);
     exec_config->mailfilter_exclude = SeqNew(0, &free);
-    exec_config->mailfilter_exclude_regex = SeqNew(0, &RegexFree);
+    exec_config->mailfilter_exclude_regex = RegexSetNew(exec_config->mailfilter_exclude);
 
     exec_config->fq_name = xstrdup(VFQNAME);
     exec_config->ip_address = xstrdup(VIPADDRESS);
@@ -203,14 +193,14 @@ ExecConfig *ExecConfigNew(bool scheduled_run, const EvalContext *ctx, const Poli
             else if (strcmp(cp->lval, CFEX_CONTROLBODY[EXEC_CONTROL_MAILFILTER_INCLUDE].lval) == 0)
             {
                 SeqDestroy(exec_config->mailfilter_include);
-                SeqDestroy(exec_config->mailfilter_include_regex);
+                RegexSetDestroy(exec_config->mailfilter_include_regex);
                 RlistMailFilterFill(value, &exec_config->mailfilter_include,
                                     &exec_config->mailfilter_include_regex, "include");
             }
             else if (strcmp(cp->lval, CFEX_CONTROLBODY[EXEC_CONTROL_MAILFILTER_EXCLUDE].lval) == 0)
             {
                 SeqDestroy(exec_config->mailfilter_exclude);
-                SeqDestroy(exec_config->mailfilter_exclude_regex);
+                RegexSetDestroy(exec_config->mailfilter_exclude_regex);
                 RlistMailFilterFill(value, &exec_config->mailfilter_exclude,
                                     &exec_config->mailfilter_exclude_regex, "exclude");
             }
@@ -254,8 +244,8 @@ void ExecConfigDestroy(ExecConfig *exec_config)
         free(exec_config->mail_subject);
         SeqDestroy(exec_config->mailfilter_include);
         SeqDestroy(exec_config->mailfilter_exclude);
-        SeqDestroy(exec_config->mailfilter_include_regex);
-        SeqDestroy(exec_config->mailfilter_exclude_regex);
+        RegexSetDestroy(exec_config->mailfilter_include_regex);
+        RegexSetDestroy(exec_config->mailfilter_exclude_regex);
         free(exec_config->fq_name);
         free(exec_config->ip_address);
         free(exec_config->ip_addresses);
@@ -26,6 +26,7 @@
 #define CFENGINE_EXEC_CONFIG_H
 
 #include <cf3.defs.h>
+#include <regex.h>                                           /* RegexSet */
 
 /* This struct is supposed to be immutable: don't update it,
    just destroy and create anew */
@@ -43,9 +44,9 @@ typedef struct
     // These two contain regular expression strings.
     Seq *mailfilter_include;
     Seq *mailfilter_exclude;
-    // These two contain precompiled regexes (pcre*).
-    Seq *mailfilter_include_regex;
-    Seq *mailfilter_exclude_regex;
+    // These two match any of the above at once.
+    RegexSet *mailfilter_include_regex;
+    RegexSet *mailfilter_exclude_regex;
 
     /*
      * Host information.
@@ -503,10 +503,7 @@ int ForceKeyRemoval(const char *hash)
         }
         snprintf(tmp, CF_BUFSIZE, "k%s", hash);
         DeleteDB(dbp, tmp);
-        snprintf(tmp, CF_BUFSIZE, "qi%s", hash);
-        DeleteDB(dbp, tmp);
-        snprintf(tmp, CF_BUFSIZE, "qo%s", hash);
-        DeleteDB(dbp, tmp);
+        DeleteLastSeenQualityEntries(dbp, hash);
         RemovePublicKey(hash);
         for (int i = 0; i < SeqLength(hostips); ++i)
         {
@@ -580,10 +577,7 @@ int ForceIpAddressRemoval(const char *ip)
             const char *myk = SeqAt(hostkeys, i);
             snprintf(tmp, CF_BUFSIZE, "k%s", myk);
             DeleteDB(dbp, tmp);
-            snprintf(tmp, CF_BUFSIZE, "qi%s", myk);
-            DeleteDB(dbp, tmp);
-            snprintf(tmp, CF_BUFSIZE, "qo%s", myk);
-            DeleteDB(dbp, tmp);
+            DeleteLastSeenQualityEntries(dbp, myk);
             RemovePublicKey(myk);
         }
         CloseDB(dbp);
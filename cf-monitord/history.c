@@ -171,15 +171,18 @@ static void Nova_HistoryUpdate(time_t time, const Averages *newvals)
     CloseDB(dbp);
 }
 
-static Item *NovaReSample(EvalContext *ctx, int slot, Attributes a, const Promise *pp, PromiseResult *result)
+static Item *NovaReSample(EvalContext *ctx, int slot, const Attributes *org_a, const Promise *pp, PromiseResult *result)
 {
+    Attributes a_copy = *org_a; /* modified below */
+    Attributes *a = &a_copy;
+
     CfLock thislock;
     char eventname[CF_BUFSIZE];
     struct timespec start;
     FILE *fin = NULL;
     mode_t maskval = 0;
 
-    if (a.measure.stream_type && strcmp(a.measure.stream_type, "pipe") == 0)
+    if (a->measure.stream_type && strcmp(a->measure.stream_type, "pipe") == 0)
     {
         if (!IsExecutable(CommandArg0(pp->promiser)))
         {
@@ -194,8 +197,8 @@ static Item *NovaReSample(EvalContext *ctx, int slot, Attributes a, const Promis
     }
 
     TransactionContext tc = {
-        .expireafter = a.transaction.expireafter,
-        .ifelapsed = MONITOR_RESTARTED ? 0 : a.transaction.ifelapsed, // Force a measurement if restarted
+        .expireafter = a->transaction.expireafter,
+        .ifelapsed = MONITOR_RESTARTED ? 0 : a->transaction.ifelapsed, // Force a measurement if restarted
     };
 
     CFSTARTTIME = time(NULL);
@@ -204,7 +207,7 @@ static Item *NovaReSample(EvalContext *ctx, int slot, Attributes a, const Promis
 
     if (thislock.lock == NULL)
     {
-        if (strcmp(a.measure.history_type, "log") == 0)
+        if (strcmp(a->measure.history_type, "log") == 0)
         {
             DeleteItemList(ENTERPRISE_DATA[slot].output);
             ENTERPRISE_DATA[slot].output = NULL;
@@ -223,19 +226,19 @@ static Item *NovaReSample(EvalContext *ctx, int slot, Attributes a, const Promis
         DeleteItemList(ENTERPRISE_DATA[slot].output);
         ENTERPRISE_DATA[slot].output = NULL;
 
-        Log(LOG_LEVEL_INFO, "Sampling \'%s\' ...(timeout=%d,owner=%ju,group=%ju)", pp->promiser, a.contain.timeout,
-              (uintmax_t)a.contain.owner, (uintmax_t)a.contain.group);
+        Log(LOG_LEVEL_INFO, "Sampling \'%s\' ...(timeout=%d,owner=%ju,group=%ju)", pp->promiser, a->contain.timeout,
+              (uintmax_t)a->contain.owner, (uintmax_t)a->contain.group);
 
         start = BeginMeasure();
 
-        if (a.contain.timeout != 0)
+        if (a->contain.timeout != 0)
         {
-            SetTimeOut(a.contain.timeout);
+            SetTimeOut(a->contain.timeout);
         }
 
         /* Stream types */
 
-        if (a.measure.stream_type && strcmp(a.measure.stream_type, "file") == 0)
+        if (a->measure.stream_type && strcmp(a->measure.stream_type, "file") == 0)
         {
             long filepos = 0;
             struct stat sb;
@@ -254,7 +257,7 @@ static Item *NovaReSample(EvalContext *ctx, int slot, Attributes a, const Promis
 
             fin = safe_fopen(pp->promiser, "r");
 
-            if (a.measure.growing)
+            if (a->measure.growing)
             {
                 filepos = Nova_RestoreFilePosition(pp->promiser);
 
@@ -264,30 +267,30 @@ static Item *NovaReSample(EvalContext *ctx, int slot, Attributes a, const Promis
                 }
             }
         }
-        else if (a.measure.stream_type && strcmp(a.measure.stream_type, "pipe") == 0)
+        else if (a->measure.stream_type && strcmp(a->measure.stream_type, "pipe") == 0)
         {
-            Log(LOG_LEVEL_VERBOSE, "(Setting pipe umask to %jo)", (uintmax_t)a.contain.umask);
-            maskval = umask(a.contain.umask);
+            Log(LOG_LEVEL_VERBOSE, "(Setting pipe umask to %jo)", (uintmax_t)a->contain.umask);
+            maskval = umask(a->contain.umask);
 
-            if (a.contain.umask == 0)
+            if (a->contain.umask == 0)
             {
                 Log(LOG_LEVEL_VERBOSE, "Programming %s running with umask 0! Use umask= to set", pp->promiser);
             }
 
 
             // Mark: This is strange that we used these wrappers. Currently no way of setting these
-            a.contain.owner = -1;
-            a.contain.group = -1;
-            a.contain.chdir = NULL;
-            a.contain.chroot = NULL;
+            a->contain.owner = -1;
+            a->contain.group = -1;
+            a->contain.chdir = NULL;
+            a->contain.chroot = NULL;
             // Mark: they were unset, and would fail for non-root(!)
 
-            if (a.contain.shelltype == SHELL_TYPE_POWERSHELL)
+            if (a->contain.shelltype == SHELL_TYPE_POWERSHELL)
             {
 #ifdef __MINGW32__
                 fin =
-                    cf_popen_powershell_setuid(pp->promiser, "r", a.contain.owner, a.contain.group, a.contain.chdir,
-                                      a.contain.chroot, false);
+                    cf_popen_powershell_setuid(pp->promiser, "r", a->contain.owner, a->contain.group, a->contain.chdir,
+                                      a->contain.chroot, false);
 #else // !__MINGW32__
                 Log(LOG_LEVEL_ERR, "Powershell is only supported on Windows");
                 YieldCurrentLock(thislock);
@@ -295,17 +298,17 @@ static Item *NovaReSample(EvalContext *ctx, int slot, Attributes a, const Promis
                 return NULL;
 #endif // !__MINGW32__
             }
-            else if (a.contain.shelltype == SHELL_TYPE_USE)
+            else if (a->contain.shelltype == SHELL_TYPE_USE)
             {
                 fin =
-                    cf_popen_shsetuid(pp->promiser, "r", a.contain.owner, a.contain.group, a.contain.chdir,
-                                      a.contain.chroot, false);
+                    cf_popen_shsetuid(pp->promiser, "r", a->contain.owner, a->contain.group, a->contain.chdir,
+                                      a->contain.chroot, false);
             }
             else
             {
                 fin =
-                    cf_popensetuid(pp->promiser, "r", a.contain.owner, a.contain.group, a.contain.chdir,
-                                   a.contain.chroot, false);
+                    cf_popensetuid(pp->promiser, "r", a->contain.owner, a->contain.group, a->contain.chdir,
+                                   a->contain.chroot, false);
             }
         }
 
@@ -350,20 +353,20 @@ static Item *NovaReSample(EvalContext *ctx, int slot, Attributes a, const Promis
 
         free(line);
 
-        if (a.measure.stream_type && strcmp(a.measure.stream_type, "file") == 0)
+        if (a->measure.stream_type && strcmp(a->measure.stream_type, "file") == 0)
         {
             long fileptr = ftell(fin);
 
             fclose(fin);
             Nova_SaveFilePosition(pp->promiser, fileptr);
         }
-        else if (a.measure.stream_type && strcmp(a.measure.stream_type, "pipe") == 0)
+        else if (a->measure.stream_type && strcmp(a->measure.stream_type, "pipe") == 0)
         {
             cf_pclose(fin);
         }
     }
 
-    if (a.contain.timeout != 0)
+    if (a->contain.timeout != 0)
     {
         alarm(0);
         signal(SIGALRM, SIG_DFL);
@@ -430,7 +433,7 @@ void HistoryUpdate(EvalContext *ctx, Averages newvals)
     Nova_DumpSlowlyVaryingObservations();
 }
 
-static Item *NovaGetMeasurementStream(EvalContext *ctx, Attributes a, const Promise *pp, PromiseResult *result)
+static Item *NovaGetMeasurementStream(EvalContext *ctx, const Attributes *a, const Promise *pp, PromiseResult *result)
 {
     int i;
 
@@ -454,7 +457,7 @@ static Item *NovaGetMeasurementStream(EvalContext *ctx, Attributes a, const Prom
 }
 
 static PromiseResult NovaExtractValueFromStream(EvalContext *ctx, const char *handle,
-                                                Item *stream, Attributes a,
+                                                Item *stream, const Attributes *a,
                                                 const Promise *pp, double *value_out)
 {
     char value[CF_MAXVARSIZE];
@@ -465,34 +468,34 @@ static PromiseResult NovaExtractValueFromStream(EvalContext *ctx, const char *ha
 
     for (ip = stream; ip != NULL; ip = ip->next)
     {
-        if (count == a.measure.select_line_number)
+        if (count == a->measure.select_line_number)
         {
             found = true;
             match = ip;
             match_count++;
         }
 
-        if (a.measure.select_line_matching && StringMatchFull(a.measure.select_line_matching, ip->name))
+        if (a->measure.select_line_matching && StringMatchFull(a->measure.select_line_matching, ip->name))
         {
-            Log(LOG_LEVEL_VERBOSE, " ?? Look for %s regex %s", handle, a.measure.select_line_matching);
+            Log(LOG_LEVEL_VERBOSE, " ?? Look for %s regex %s", handle, a->measure.select_line_matching);
             found = true;
             match = ip;
 
-            if (a.measure.extraction_regex)
+            if (a->measure.extraction_regex)
             {
-                switch (a.measure.data_type)
+                switch (a->measure.data_type)
                 {
                 case CF_DATA_TYPE_INT:
                 case CF_DATA_TYPE_REAL:
                 case CF_DATA_TYPE_COUNTER:
 
-                    strncpy(value, ExtractFirstReference(a.measure.extraction_regex, match->name), CF_MAXVARSIZE - 1);
+                    strncpy(value, ExtractFirstReference(a->measure.extraction_regex, match->name), CF_MAXVARSIZE - 1);
 
                     if (strcmp(value, "CF_NOMATCH") == 0)
                     {
                         ok_conversion = false;
                         Log(LOG_LEVEL_VERBOSE, "Was not able to match a value with '%s' on '%s'",
-                            a.measure.extraction_regex, match->name);
+                            a->measure.extraction_regex, match->name);
                     }
                     else
                     {
@@ -500,7 +503,7 @@ static PromiseResult NovaExtractValueFromStream(EvalContext *ctx, const char *ha
                         {
                             Log(LOG_LEVEL_VERBOSE, "Found candidate match value of '%s'", value);
 
-                            if (a.measure.policy == MEASURE_POLICY_SUM || a.measure.policy == MEASURE_POLICY_AVERAGE)
+                            if (a->measure.policy == MEASURE_POLICY_SUM || a->measure.policy == MEASURE_POLICY_AVERAGE)
                             {
                                 double delta = 0;
                                 if (DoubleFromString(value, &delta))
@@ -524,7 +527,7 @@ static PromiseResult NovaExtractValueFromStream(EvalContext *ctx, const char *ha
 
                             match_count++;
 
-                            if (a.measure.policy == MEASURE_POLICY_FIRST)
+                            if (a->measure.policy == MEASURE_POLICY_FIRST)
                             {
                                 done = true;
                             }
@@ -533,7 +536,7 @@ static PromiseResult NovaExtractValueFromStream(EvalContext *ctx, const char *ha
                     break;
 
                 default:
-                    Log(LOG_LEVEL_ERR, "Unexpected data type in data_type attribute: %d", a.measure.data_type);
+                    Log(LOG_LEVEL_ERR, "Unexpected data type in data_type attribute: %d", a->measure.data_type);
                 }
             }
 
@@ -554,7 +557,7 @@ static PromiseResult NovaExtractValueFromStream(EvalContext *ctx, const char *ha
         return PROMISE_RESULT_FAIL;
     }
 
-    switch (a.measure.data_type)
+    switch (a->measure.data_type)
     {
     case CF_DATA_TYPE_COUNTER:
 
@@ -566,10 +569,10 @@ static PromiseResult NovaExtractValueFromStream(EvalContext *ctx, const char *ha
         if (match_count > 1)
         {
             Log(LOG_LEVEL_INFO, "Warning: %d lines matched the line_selection \"%s\"- making best average",
-                  match_count, a.measure.select_line_matching);
+                  match_count, a->measure.select_line_matching);
         }
 
-        if (match_count > 0 && a.measure.policy == MEASURE_POLICY_AVERAGE) // If not "average" then "sum"
+        if (match_count > 0 && a->measure.policy == MEASURE_POLICY_AVERAGE) // If not "average" then "sum"
         {
             real_val /= match_count;
         }
@@ -580,7 +583,7 @@ static PromiseResult NovaExtractValueFromStream(EvalContext *ctx, const char *ha
         if (match_count > 1)
         {
             Log(LOG_LEVEL_INFO, "Warning: %d lines matched the line_selection \"%s\"- making best average",
-                  match_count, a.measure.select_line_matching);
+                  match_count, a->measure.select_line_matching);
         }
 
         if (match_count > 0)
@@ -591,7 +594,7 @@ static PromiseResult NovaExtractValueFromStream(EvalContext *ctx, const char *ha
         break;
 
     default:
-        Log(LOG_LEVEL_ERR, "Unexpected data type in data_type attribute: %d", a.measure.data_type);
+        Log(LOG_LEVEL_ERR, "Unexpected data type in data_type attribute: %d", a->measure.data_type);
     }
 
     if (!ok_conversion)
@@ -608,7 +611,7 @@ static PromiseResult NovaExtractValueFromStream(EvalContext *ctx, const char *ha
 }
 
 static void NovaLogSymbolicValue(EvalContext *ctx, const char *handle, Item *stream,
-                                 Attributes a, const Promise *pp, PromiseResult *result)
+                                 const Attributes *a, const Promise *pp, PromiseResult *result)
 {
     char value[CF_BUFSIZE], sdate[CF_MAXVARSIZE], filename[CF_BUFSIZE];
     int count = 1, found = false, match_count = 0;
@@ -631,17 +634,17 @@ static void NovaLogSymbolicValue(EvalContext *ctx, const char *handle, Item *str
             continue;
         }
 
-        if (count == a.measure.select_line_number)
+        if (count == a->measure.select_line_number)
         {
             Log(LOG_LEVEL_VERBOSE, "Found line %d by number...", count);
             found = true;
             match_count = 1;
             match = ip;
 
-            if (a.measure.extraction_regex)
+            if (a->measure.extraction_regex)
             {
-                Log(LOG_LEVEL_VERBOSE, "Now looking for a matching extractor \"%s\"", a.measure.extraction_regex);
-                strncpy(value, ExtractFirstReference(a.measure.extraction_regex, match->name), CF_MAXVARSIZE - 1);
+                Log(LOG_LEVEL_VERBOSE, "Now looking for a matching extractor \"%s\"", a->measure.extraction_regex);
+                strncpy(value, ExtractFirstReference(a->measure.extraction_regex, match->name), CF_MAXVARSIZE - 1);
                 Log(LOG_LEVEL_INFO, "Extracted value \"%s\" for promise \"%s\"", value, handle);
                 AppendItem(&matches, value, NULL);
             }
@@ -653,17 +656,17 @@ static void NovaLogSymbolicValue(EvalContext *ctx, const char *handle, Item *str
             break;
         }
 
-        if (a.measure.select_line_matching && StringMatchFull(a.measure.select_line_matching, ip->name))
+        if (a->measure.select_line_matching && StringMatchFull(a->measure.select_line_matching, ip->name))
         {
             Log(LOG_LEVEL_VERBOSE, "Found line %d by pattern...", count);
             found = true;
             match = ip;
             match_count++;
 
-            if (a.measure.extraction_regex)
+            if (a->measure.extraction_regex)
             {
-                Log(LOG_LEVEL_VERBOSE, "Now looking for a matching extractor \"%s\"", a.measure.extraction_regex);
-                strncpy(value, ExtractFirstReference(a.measure.extraction_regex, match->name), CF_MAXVARSIZE - 1);
+                Log(LOG_LEVEL_VERBOSE, "Now looking for a matching extractor \"%s\"", a->measure.extraction_regex);
+                strncpy(value, ExtractFirstReference(a->measure.extraction_regex, match->name), CF_MAXVARSIZE - 1);
                 Log(LOG_LEVEL_INFO, "Extracted value \"%s\" for promise \"%s\"", value, handle);
                 AppendItem(&matches, value, NULL);
             }
@@ -687,10 +690,10 @@ static void NovaLogSymbolicValue(EvalContext *ctx, const char *handle, Item *str
     if (match_count > 1)
     {
         Log(LOG_LEVEL_INFO, "Warning: %d lines matched the line_selection \"%s\"- matching to last", match_count,
-              a.measure.select_line_matching);
+              a->measure.select_line_matching);
     }
 
-    switch (a.measure.data_type)
+    switch (a->measure.data_type)
     {
     case CF_DATA_TYPE_COUNTER:
         Log(LOG_LEVEL_VERBOSE, "Counted %d for %s", match_count, handle);
@@ -707,7 +710,7 @@ static void NovaLogSymbolicValue(EvalContext *ctx, const char *handle, Item *str
 
     DeleteItemList(matches);
 
-    if (a.measure.history_type && strcmp(a.measure.history_type, "log") == 0)
+    if (a->measure.history_type && strcmp(a->measure.history_type, "log") == 0)
     {
         snprintf(filename, CF_BUFSIZE, "%s%c%s_measure.log", GetStateDir(), FILE_SEPARATOR, handle);
 
@@ -740,14 +743,14 @@ static void NovaLogSymbolicValue(EvalContext *ctx, const char *handle, Item *str
             return;
         }
 
-        snprintf(id, CF_MAXVARSIZE - 1, "%s:%d", handle, a.measure.data_type);
+        snprintf(id, CF_MAXVARSIZE - 1, "%s:%d", handle, a->measure.data_type);
         WriteDB(dbp, id, value, strlen(value) + 1);
         CloseDB(dbp);
     }
 }
 
 PromiseResult VerifyMeasurement(EvalContext *ctx, double *this,
-                                Attributes a, const Promise *pp)
+                                const Attributes *a, const Promise *pp)
 {
     const char *handle = PromiseGetHandle(pp);
     Item *stream = NULL;
@@ -765,7 +768,7 @@ PromiseResult VerifyMeasurement(EvalContext *ctx, double *this,
     }
 
     PromiseResult result = PROMISE_RESULT_NOOP;
-    switch (a.measure.data_type)
+    switch (a->measure.data_type)
     {
     case CF_DATA_TYPE_COUNTER:
     case CF_DATA_TYPE_INT:
@@ -776,10 +779,10 @@ PromiseResult VerifyMeasurement(EvalContext *ctx, double *this,
 
         stream = NovaGetMeasurementStream(ctx, a, pp, &result);
 
-        if (strcmp(a.measure.history_type, "weekly") == 0)
+        if (strcmp(a->measure.history_type, "weekly") == 0)
         {
             if ((slot = NovaRegisterSlot(handle, pp->comment ? pp->comment : "User defined measure",
-                                         a.measure.units ? a.measure.units : "unknown", 0.0f, 100.0f, true)) < 0)
+                                         a->measure.units ? a->measure.units : "unknown", 0.0f, 100.0f, true)) < 0)
             {
                 return result;
             }
@@ -787,7 +790,7 @@ PromiseResult VerifyMeasurement(EvalContext *ctx, double *this,
             result = PromiseResultUpdate(result, NovaExtractValueFromStream(ctx, handle, stream, a, pp, &this[slot]));
             Log(LOG_LEVEL_VERBOSE, "Setting Nova slot %d=%s to %lf", slot, handle, this[slot]);
         }
-        else if (strcmp(a.measure.history_type, "log") == 0)
+        else if (strcmp(a->measure.history_type, "log") == 0)
         {
             Log(LOG_LEVEL_VERBOSE, "Promise to log a numerical value");
             NovaLogSymbolicValue(ctx, handle, stream, a, pp, &result);
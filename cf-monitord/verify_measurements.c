@@ -47,11 +47,11 @@ PromiseResult VerifyMeasurementPromise(EvalContext *ctx, double *measurement, co
 
     if (!CheckMeasureSanity(a.measure, pp))
     {
-        cfPS(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_INTERRUPTED, pp, a, "Measurement promise is not valid");
+        cfPS(ctx, LOG_LEVEL_ERR, PROMISE_RESULT_INTERRUPTED, pp, &a, "Measurement promise is not valid");
         return PROMISE_RESULT_INTERRUPTED;
     }
 
-    return VerifyMeasurement(ctx, measurement, a, pp);
+    return VerifyMeasurement(ctx, measurement, &a, pp);
 }
 
 /*****************************************************************************/
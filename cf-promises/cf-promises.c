@@ -36,6 +36,7 @@
 #include <loading.h>
 #include <regex.h>                                        /* CompileRegex */
 #include <match_scope.h>
+#include <profiler.h>
 
 #include <time.h>
 
@@ -88,6 +89,7 @@ static const struct option OPTIONS[] =
     {"timestamp", no_argument, 0, 'l'},
     /* Only long option for the rest */
     {"log-modules", required_argument, 0, 0},
+    {"profile", no_argument, 0, 0},
     {NULL, 0, 0, '\0'}
 };
 
@@ -116,6 +118,7 @@ static const char *const HINTS[] =
     "Tag a directory with promises.cf with cf_promises_validated and cf_promises_release_id",
     "Log timestamps on each line of log output",
     "Enable even more detailed debug logging for specific areas of the implementation. Use together with '-d'. Use --log-modules=help for a list of available modules",
+    "Profile policy evaluation, writing flame graph input and a summary of the slowest promises and functions to the profile directory under the state directory",
     NULL
 };
 
@@ -227,6 +230,9 @@ int main(int argc, char *argv[])
         free(config->agent_specific.common.show_variables);
     }
 
+    ProfilerWrite("cf-promises");
+    ProfilerStop();
+
     PolicyDestroy(policy);
     GenericAgentFinalize(ctx, config);
 }
@@ -470,6 +476,10 @@ GenericAgentConfig *CheckOpts(int argc, char **argv)
                     exit(EXIT_FAILURE);
                 }
             }
+            else if (strcmp(OPTIONS[longopt_idx].name, "profile") == 0)
+            {
+                ProfilerStart();
+            }
             break;
 
         default:
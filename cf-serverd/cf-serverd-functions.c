@@ -48,6 +48,7 @@
 #include <file_lib.h>
 #include <loading.h>
 #include <printsize.h>
+#include <server_file_cache.h>
 
 
 static const size_t QUEUESIZE = 50;
@@ -396,6 +397,7 @@ static void CheckFileChanges(EvalContext *ctx, Policy **policy, GenericAgentConf
     if (reload_config)
     {
         ClearRequestReloadConfig();
+        FileCache_LogStats(LOG_LEVEL_VERBOSE);
 
         /* Rereading policies now, so update timestamp. */
         config->agent_specific.daemon.last_validated_at = validated_at;
@@ -712,6 +714,7 @@ int StartServer(EvalContext *ctx, Policy **policy, GenericAgentConfig *config)
 
     PrepareServer(sd);
     CollectCallStart(COLLECT_INTERVAL);
+    FileCache_Init(FILE_CACHE_DEFAULT_BUDGET);
 
     while (!IsPendingTermination())
     {
@@ -749,6 +752,11 @@ int StartServer(EvalContext *ctx, Policy **policy, GenericAgentConfig *config)
 
     /* This is a graceful exit, give 2 seconds chance to threads. */
     int threads_left = WaitOnThreads();
+    FileCache_LogStats(LOG_LEVEL_VERBOSE);
+    if (threads_left == 0)
+    {
+        FileCache_Destroy();
+    }
     YieldCurrentLock(thislock);
     PolicyDestroy(server_cfengine_policy);
 
@@ -52,6 +52,7 @@ static const int CF_NOSIZE = -1;
 #include <cf-windows-functions.h>                  /* NovaWin_UserNameToSid */
 #include <mutex.h>                                 /* ThreadLock */
 #include <stat_cache.h>                            /* struct Stat */
+#include <server_file_cache.h>                     /* FileCache_Acquire */
 #include "server_access.h"
 
 
@@ -396,6 +397,40 @@ static void FailedTransfer(ConnectionInfo *connection)
     }
 }
 
+/* Contents of a cached file are consistent by construction, so no need to
+ * check for changes while sending, and it can be sent in full TLS records
+ * instead of the 2K blocks the client reads in. */
+#define CACHED_FILE_SEND_SIZE (16 * 1024)
+
+static void SendCachedFile(ConnectionInfo *conn_info,
+                           const char *data, size_t size)
+{
+    size_t total = 0;
+    while (total < size)
+    {
+        int sendlen = MIN(size - total, CACHED_FILE_SEND_SIZE);
+        int ret = -1;
+
+        if (ConnectionInfoProtocolVersion(conn_info) == CF_PROTOCOL_CLASSIC)
+        {
+            ret = SendSocketStream(ConnectionInfoSocket(conn_info),
+                                   data + total, sendlen);
+        }
+        else if (ConnectionInfoProtocolVersion(conn_info) == CF_PROTOCOL_TLS)
+        {
+            ret = TLSSend(ConnectionInfoSSL(conn_info), data + total, sendlen);
+        }
+
+        if (ret == -1)
+        {
+            Log(LOG_LEVEL_VERBOSE, "Send failed in GetFile. (send: %s)",
+                GetErrorStr());
+            return;
+        }
+        total += sendlen;
+    }
+}
+
 void CfGetFile(ServerFileGetState *args)
 {
     int fd;
@@ -408,7 +443,7 @@ void CfGetFile(ServerFileGetState *args)
 
     TranslatePath(filename, args->replyfile);
 
-    stat(filename, &sb);
+    bool stat_ok = (stat(filename, &sb) == 0);
 
     Log(LOG_LEVEL_DEBUG, "CfGetFile('%s'), size = %jd",
         filename, (intmax_t) sb.st_size);
@@ -433,6 +468,17 @@ void CfGetFile(ServerFileGetState *args)
 
 /* File transfer */
 
+    const char *cached_data;
+    size_t cached_size;
+    FileCacheEntry *cached = stat_ok ?
+        FileCache_Acquire(filename, &sb, &cached_data, &cached_size) : NULL;
+    if (cached != NULL)
+    {
+        SendCachedFile(conn_info, cached_data, cached_size);
+        FileCache_Release(cached);
+        return;
+    }
+
     if ((fd = safe_open(filename, O_RDONLY)) == -1)
     {
         Log(LOG_LEVEL_ERR, "Open error of file '%s'. (open: %s)",
@@ -547,6 +593,103 @@ void CfGetFile(ServerFileGetState *args)
     }
 }
 
+/**
+ * Send #length bytes of file args->replyfile, starting at #offset, in
+ * blocks of args->buf_size. Only for the TLS protocol, it's used by agents
+ * to fetch single members out of a policy snapshot archive.
+ */
+void CfGetFileRange(ServerFileGetState *args, off_t offset, off_t length)
+{
+    char sendbuffer[CF_BUFSIZE + 256], filename[CF_BUFSIZE];
+    struct stat sb;
+    const int blocksize = args->buf_size;
+
+    ConnectionInfo *conn_info = args->conn->conn_info;
+    assert(ConnectionInfoProtocolVersion(conn_info) == CF_PROTOCOL_TLS);
+    assert(blocksize > 0 && blocksize <= CF_BUFSIZE);
+
+    TranslatePath(filename, args->replyfile);
+
+    if (stat(filename, &sb) == -1)
+    {
+        Log(LOG_LEVEL_INFO, "Cannot stat file '%s'. (stat: %s)",
+            filename, GetErrorStr());
+        goto fail;
+    }
+
+    Log(LOG_LEVEL_DEBUG, "CfGetFileRange('%s'), size = %jd, range = %jd+%jd",
+        filename, (intmax_t) sb.st_size, (intmax_t) offset, (intmax_t) length);
+
+    if (!TransferRights(args->conn, filename, &sb))
+    {
+        Log(LOG_LEVEL_INFO, "REFUSE access to file: %s", filename);
+        RefuseAccess(args->conn, args->replyfile);
+        goto fail;
+    }
+
+    if (offset < 0 || length < 0 ||
+        offset > sb.st_size || length > sb.st_size - offset)
+    {
+        Log(LOG_LEVEL_INFO,
+            "Range %jd+%jd is outside of file '%s' of size %jd",
+            (intmax_t) offset, (intmax_t) length,
+            filename, (intmax_t) sb.st_size);
+        goto fail;
+    }
+
+    int fd = safe_open(filename, O_RDONLY);
+    if (fd == -1)
+    {
+        Log(LOG_LEVEL_ERR, "Open error of file '%s'. (open: %s)",
+            filename, GetErrorStr());
+        goto fail;
+    }
+
+    if (lseek(fd, offset, SEEK_SET) == (off_t) -1)
+    {
+        Log(LOG_LEVEL_ERR, "Seek error in file '%s'. (lseek: %s)",
+            filename, GetErrorStr());
+        close(fd);
+        goto fail;
+    }
+
+    off_t total = 0;
+    while (total < length)
+    {
+        ssize_t n_read = read(fd, sendbuffer, MIN(blocksize, length - total));
+        if (n_read <= 0)
+        {
+            /* File was truncated or replaced underneath us. */
+            memset(sendbuffer, 0, blocksize);
+            snprintf(sendbuffer, blocksize, "%s%s: %s",
+                     CF_CHANGEDSTR1, CF_CHANGEDSTR2, filename);
+            if (TLSSend(ConnectionInfoSSL(conn_info), sendbuffer, blocksize) == -1)
+            {
+                Log(LOG_LEVEL_VERBOSE, "Send failed in GetFileRange. (send: %s)",
+                    GetErrorStr());
+            }
+            break;
+        }
+
+        if (TLSSend(ConnectionInfoSSL(conn_info), sendbuffer, n_read) == -1)
+        {
+            Log(LOG_LEVEL_VERBOSE, "Send failed in GetFileRange. (send: %s)",
+                GetErrorStr());
+            break;
+        }
+
+        total += n_read;
+    }
+
+    close(fd);
+    return;
+
+  fail:
+    memset(sendbuffer, 0, blocksize);
+    snprintf(sendbuffer, blocksize, "%s", CF_FAILEDSTR);
+    TLSSend(ConnectionInfoSSL(conn_info), sendbuffer, blocksize);
+}
+
 void CfEncryptGetFile(ServerFileGetState *args)
 /* Because the stream doesn't end for each file, we need to know the
    exact number of bytes transmitted, which might change during
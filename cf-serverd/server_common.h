@@ -43,6 +43,7 @@ bool IsUserNameValid(const char *username);
 int MatchClasses(const EvalContext *ctx, ServerConnectionState *conn);
 void Terminate(ConnectionInfo *connection);
 void CfGetFile(ServerFileGetState *args);
+void CfGetFileRange(ServerFileGetState *args, off_t offset, off_t length);
 void CfEncryptGetFile(ServerFileGetState *args);
 int StatFile(ServerConnectionState *conn, char *sendbuffer, char *ofilename);
 void ReplyServerContext(ServerConnectionState *conn, int encrypted, Item *classes);
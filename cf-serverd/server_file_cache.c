@@ -0,0 +1,407 @@
+/*
+   Copyright 2018 Northern.tech AS
+
+   This file is part of CFEngine 3 - written and maintained by Northern.tech AS.
+
+   This program is free software; you can redistribute it and/or modify it
+   under the terms of the GNU General Public License as published by the
+   Free Software Foundation; version 3.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA
+
+  To the extent this program is licensed as part of the Enterprise
+  versions of CFEngine, the applicable Commercial Open Source License
+  (COSL) may apply to this file if you as a licensee so wish it. See
+  included file COSL.txt.
+*/
+
+#include <server_file_cache.h>
+
+#include <alloc.h>
+#include <map.h>
+#include <mutex.h>                                           /* ThreadLock */
+#include <file_lib.h>                                        /* safe_open */
+#include <string_lib.h>                                /* StringHash_untyped */
+#include <misc_lib.h>                                         /* CF_ASSERT */
+
+
+/**
+   Cache of the contents of files served by cf-serverd, shared by all
+   connection threads. The same few hundred policy files are requested by
+   every agent, this way they are read from disk only once.
+
+   Entries are keyed by device and inode, and are only valid as long as
+   mtime, ctime (to the nanosecond where available) and size of the file
+   don't change. The contents are preloaded in
+   memory instead of mmap()ed, so that a file truncated on disk can't crash
+   the server with SIGBUS while it's being sent.
+
+   The least recently used entries are evicted when the cached contents go
+   over the byte budget, unless they are being sent at the moment.
+
+   @note THREAD-SAFETY: yes, all access is under cft_file_cache.
+*/
+
+
+typedef struct
+{
+    time_t mtime;
+    long mtime_ns;
+    time_t ctime;
+    long ctime_ns;
+    size_t size;
+} FileCacheStamp;
+
+struct FileCacheEntry_
+{
+    char *key;                                             /* "dev:ino" */
+    FileCacheStamp stamp;
+    char *data;
+
+    size_t refcount;                           /* threads sending it now */
+    bool stale;                      /* no longer in the index, free it */
+
+    FileCacheEntry *prev;                         /* LRU list, more recent */
+    FileCacheEntry *next;                          /* LRU list, less recent */
+};
+
+
+static pthread_mutex_t cft_file_cache = PTHREAD_ERRORCHECK_MUTEX_INITIALIZER_NP;
+
+static Map *file_cache = NULL;                      /* "dev:ino" -> entry */
+static FileCacheEntry *lru_head = NULL;
+static FileCacheEntry *lru_tail = NULL;
+static size_t cache_budget = 0;
+static size_t cache_bytes = 0;
+
+static unsigned long stats_hits = 0;
+static unsigned long stats_misses = 0;
+static unsigned long stats_evictions = 0;
+
+
+/* Sub-second timestamps, so that a file rewritten in the same second with
+ * the same size is not taken as unchanged. */
+static FileCacheStamp FileCacheStampOf(const struct stat *sb)
+{
+    return (FileCacheStamp) {
+        .mtime = sb->st_mtime,
+        .ctime = sb->st_ctime,
+#if defined(HAVE_STRUCT_STAT_ST_MTIM)
+        .mtime_ns = sb->st_mtim.tv_nsec,
+        .ctime_ns = sb->st_ctim.tv_nsec,
+#elif defined(HAVE_STRUCT_STAT_ST_MTIMESPEC)
+        .mtime_ns = sb->st_mtimespec.tv_nsec,
+        .ctime_ns = sb->st_ctimespec.tv_nsec,
+#endif
+        .size = sb->st_size,
+    };
+}
+
+static bool FileCacheStampEqual(FileCacheStamp a, FileCacheStamp b)
+{
+    return a.mtime == b.mtime && a.mtime_ns == b.mtime_ns &&
+           a.ctime == b.ctime && a.ctime_ns == b.ctime_ns &&
+           a.size == b.size;
+}
+
+static void FileCacheEntryDestroy(FileCacheEntry *entry)
+{
+    free(entry->key);
+    free(entry->data);
+    free(entry);
+}
+
+static void LRUUnlink(FileCacheEntry *entry)
+{
+    if (entry->prev != NULL)
+    {
+        entry->prev->next = entry->next;
+    }
+    else
+    {
+        lru_head = entry->next;
+    }
+
+    if (entry->next != NULL)
+    {
+        entry->next->prev = entry->prev;
+    }
+    else
+    {
+        lru_tail = entry->prev;
+    }
+
+    entry->prev = entry->next = NULL;
+}
+
+static void LRUPushFront(FileCacheEntry *entry)
+{
+    entry->prev = NULL;
+    entry->next = lru_head;
+    if (lru_head != NULL)
+    {
+        lru_head->prev = entry;
+    }
+    lru_head = entry;
+    if (lru_tail == NULL)
+    {
+        lru_tail = entry;
+    }
+}
+
+/* Take #entry out of the cache, it's freed once nobody is sending it. */
+static void FileCacheRemove(FileCacheEntry *entry)
+{
+    MapRemove(file_cache, entry->key);
+    LRUUnlink(entry);
+    cache_bytes -= entry->stamp.size;
+
+    if (entry->refcount == 0)
+    {
+        FileCacheEntryDestroy(entry);
+    }
+    else
+    {
+        entry->stale = true;
+    }
+}
+
+static void FileCacheEvict(void)
+{
+    FileCacheEntry *entry = lru_tail;
+    while (cache_bytes > cache_budget && entry != NULL)
+    {
+        FileCacheEntry *prev = entry->prev;
+        if (entry->refcount == 0)
+        {
+            FileCacheRemove(entry);
+            stats_evictions++;
+        }
+        entry = prev;
+    }
+}
+
+void FileCache_Init(size_t budget)
+{
+    ThreadLock(&cft_file_cache);
+
+    assert(file_cache == NULL);
+    file_cache = MapNew(StringHash_untyped, StringSafeEqual_untyped,
+                        NULL, NULL);          /* key is owned by the entry */
+    cache_budget = budget;
+    cache_bytes = 0;
+    stats_hits = stats_misses = stats_evictions = 0;
+
+    ThreadUnlock(&cft_file_cache);
+}
+
+void FileCache_Destroy()
+{
+    ThreadLock(&cft_file_cache);
+
+    if (file_cache != NULL)
+    {
+        while (lru_head != NULL)
+        {
+            FileCacheEntry *entry = lru_head;
+            CF_ASSERT(entry->refcount == 0,
+                      "FileCache_Destroy: entry '%s' still in use!",
+                      entry->key);
+            LRUUnlink(entry);
+            FileCacheEntryDestroy(entry);
+        }
+
+        MapDestroy(file_cache);
+        file_cache = NULL;
+        cache_bytes = 0;
+    }
+
+    ThreadUnlock(&cft_file_cache);
+}
+
+/**
+ * Read the whole of #filename, only if it still matches #sb.
+ */
+static char *ReadFileContents(const char *filename, const struct stat *sb)
+{
+    int fd = safe_open(filename, O_RDONLY | O_BINARY);
+    if (fd == -1)
+    {
+        return NULL;
+    }
+
+    char *data = xmalloc(sb->st_size);
+    size_t total = 0;
+    while (total < (size_t) sb->st_size)
+    {
+        ssize_t n_read = read(fd, data + total, sb->st_size - total);
+        if (n_read <= 0)
+        {
+            break;
+        }
+        total += n_read;
+    }
+
+    struct stat sb_after;
+    bool ok = (total == (size_t) sb->st_size &&
+               fstat(fd, &sb_after) == 0 &&
+               sb_after.st_ino == sb->st_ino &&
+               FileCacheStampEqual(FileCacheStampOf(&sb_after),
+                                   FileCacheStampOf(sb)));
+    close(fd);
+
+    if (!ok)
+    {
+        free(data);
+        return NULL;
+    }
+    return data;
+}
+
+/**
+ * @brief Get the contents of #filename from the cache, reading it into the
+ *        cache first if needed.
+ * @param #sb stat() of #filename, just taken by the caller.
+ * @return An entry that must be given back with FileCache_Release(), with
+ *         #data and #size set to its contents, or NULL if the file can't
+ *         be cached and must be read from disk.
+ */
+FileCacheEntry *FileCache_Acquire(const char *filename, const struct stat *sb,
+                                  const char **data, size_t *size)
+{
+    /* Tiny files aren't worth it, and huge ones would evict everything. */
+    if (!S_ISREG(sb->st_mode) || sb->st_size == 0 ||
+        (uintmax_t) sb->st_size > cache_budget / 16)
+    {
+        return NULL;
+    }
+
+    char *key;
+    xasprintf(&key, "%ju:%ju", (uintmax_t) sb->st_dev, (uintmax_t) sb->st_ino);
+
+    ThreadLock(&cft_file_cache);
+
+    if (file_cache == NULL)
+    {
+        ThreadUnlock(&cft_file_cache);
+        free(key);
+        return NULL;
+    }
+
+    const FileCacheStamp stamp = FileCacheStampOf(sb);
+    FileCacheEntry *entry = MapGet(file_cache, key);
+    if (entry != NULL && !FileCacheStampEqual(entry->stamp, stamp))
+    {
+        FileCacheRemove(entry);                            /* file changed */
+        entry = NULL;
+    }
+
+    if (entry != NULL)
+    {
+        stats_hits++;
+        entry->refcount++;
+        LRUUnlink(entry);
+        LRUPushFront(entry);
+        ThreadUnlock(&cft_file_cache);
+
+        free(key);
+        *data = entry->data;
+        *size = entry->stamp.size;
+        return entry;
+    }
+
+    stats_misses++;
+    ThreadUnlock(&cft_file_cache);
+
+    /* Read without holding the lock, other threads may be sending. */
+    char *contents = ReadFileContents(filename, sb);
+    if (contents == NULL)
+    {
+        free(key);
+        return NULL;
+    }
+
+    ThreadLock(&cft_file_cache);
+
+    if (file_cache == NULL)
+    {
+        ThreadUnlock(&cft_file_cache);
+        free(key);
+        free(contents);
+        return NULL;
+    }
+
+    /* Another thread might have read it meanwhile. */
+    entry = MapGet(file_cache, key);
+    if (entry != NULL && FileCacheStampEqual(entry->stamp, stamp))
+    {
+        free(key);
+        free(contents);
+    }
+    else
+    {
+        if (entry != NULL)
+        {
+            FileCacheRemove(entry);
+        }
+
+        entry = xcalloc(1, sizeof(*entry));
+        entry->key = key;
+        entry->stamp = stamp;
+        entry->data = contents;
+
+        MapInsert(file_cache, entry->key, entry);
+        cache_bytes += entry->stamp.size;
+        LRUPushFront(entry);
+    }
+
+    entry->refcount++;
+    FileCacheEvict();
+    ThreadUnlock(&cft_file_cache);
+
+    *data = entry->data;
+    *size = entry->stamp.size;
+    return entry;
+}
+
+void FileCache_Release(FileCacheEntry *entry)
+{
+    ThreadLock(&cft_file_cache);
+
+    assert(entry->refcount > 0);
+    entry->refcount--;
+
+    if (entry->stale && entry->refcount == 0)
+    {
+        FileCacheEntryDestroy(entry);
+    }
+    else if (cache_bytes > cache_budget)
+    {
+        FileCacheEvict();
+    }
+
+    ThreadUnlock(&cft_file_cache);
+}
+
+void FileCache_LogStats(LogLevel level)
+{
+    ThreadLock(&cft_file_cache);
+
+    unsigned long total = stats_hits + stats_misses;
+    Log(level,
+        "File cache: %lu/%lu requests served from memory (%.1f%%),"
+        " %zu files and %zu/%zu bytes resident, %lu evicted",
+        stats_hits, total,
+        (total > 0) ? (100.0 * stats_hits / total) : 0.0,
+        (file_cache != NULL) ? MapSize(file_cache) : 0,
+        cache_bytes, cache_budget, stats_evictions);
+
+    ThreadUnlock(&cft_file_cache);
+}
@@ -0,0 +1,50 @@
+/*
+   Copyright 2018 Northern.tech AS
+
+   This file is part of CFEngine 3 - written and maintained by Northern.tech AS.
+
+   This program is free software; you can redistribute it and/or modify it
+   under the terms of the GNU General Public License as published by the
+   Free Software Foundation; version 3.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA
+
+  To the extent this program is licensed as part of the Enterprise
+  versions of CFEngine, the applicable Commercial Open Source License
+  (COSL) may apply to this file if you as a licensee so wish it. See
+  included file COSL.txt.
+*/
+
+#ifndef CFENGINE_SERVER_FILE_CACHE_H
+#define CFENGINE_SERVER_FILE_CACHE_H
+
+
+#include <platform.h>
+#include <logging.h>                                           /* LogLevel */
+
+
+/* Default memory budget for cached file contents. */
+#define FILE_CACHE_DEFAULT_BUDGET (64 * 1024 * 1024)
+
+
+typedef struct FileCacheEntry_ FileCacheEntry;
+
+
+void FileCache_Init(size_t budget);
+void FileCache_Destroy(void);
+
+FileCacheEntry *FileCache_Acquire(const char *filename, const struct stat *sb,
+                                  const char **data, size_t *size);
+void FileCache_Release(FileCacheEntry *entry);
+
+void FileCache_LogStats(LogLevel level);
+
+
+#endif
@@ -560,6 +560,61 @@ ProtocolCommandNew GetCommandNew(char *str)
 }
 
 
+/**
+ * Expand and normalise in place the #filename requested by a GET or
+ * GETRANGE #command, check that the peer may access it, and set up
+ * #get_args to send it.
+ *
+ * @TODO OPENDIR and STAT do much the same.
+ *
+ * @return 1 if the file may be sent, 0 if access was refused (the refusal
+ *         has been sent), -1 on protocol error.
+ */
+static int PrepareFileGet(ServerConnectionState *conn, const char *command,
+                          char *recvbuffer,
+                          char *filename, size_t filename_size,
+                          char *sendbuffer, ServerFileGetState *get_args)
+{
+    size_t zret = ShortcutsExpand(filename, filename_size,
+                                  SV.path_shortcuts,
+                                  conn->ipaddr, conn->revdns,
+                                  KeyPrintableHash(ConnectionInfoKey(conn->conn_info)));
+    if (zret == (size_t) -1)
+    {
+        return -1;
+    }
+
+    zret = PreprocessRequestPath(filename, filename_size);
+    if (zret == (size_t) -1)
+    {
+        RefuseAccess(conn, recvbuffer);
+        return 0;
+    }
+
+    PathRemoveTrailingSlash(filename, strlen(filename));
+
+    Log(LOG_LEVEL_VERBOSE, "%14s %7s %s",
+        "Translated to:", command, filename);
+
+    if (acl_CheckPath(paths_acl, filename,
+                      conn->ipaddr, conn->revdns,
+                      KeyPrintableHash(ConnectionInfoKey(conn->conn_info)))
+        == false)
+    {
+        Log(LOG_LEVEL_INFO, "access denied to %s: %s", command, filename);
+        RefuseAccess(conn, recvbuffer);
+        return 0;
+    }
+
+    /* TODO eliminate! */
+    get_args->conn = conn;
+    get_args->encrypt = false;
+    get_args->replybuff = sendbuffer;
+    get_args->replyfile = filename;
+
+    return 1;
+}
+
 /**
  * Currently this function returns false when we want the connection
  * closed, and true, when we want to proceed further with requests.
@@ -661,37 +716,15 @@ bool BusyWithNewProtocol(EvalContext *ctx, ServerConnectionState *conn)
         Log(LOG_LEVEL_VERBOSE, "%14s %7s %s",
             "Received:", "GET", filename);
 
-        /* TODO batch all the following in one function since it's very
-         * similar in all of GET, OPENDIR and STAT. */
-
-        size_t zret = ShortcutsExpand(filename, sizeof(filename),
-                                     SV.path_shortcuts,
-                                     conn->ipaddr, conn->revdns,
-                                     KeyPrintableHash(ConnectionInfoKey(conn->conn_info)));
-        if (zret == (size_t) -1)
+        int prepared = PrepareFileGet(conn, "GET", recvbuffer,
+                                      filename, sizeof(filename),
+                                      sendbuffer, &get_args);
+        if (prepared == -1)
         {
             goto protocol_error;
         }
-
-        zret = PreprocessRequestPath(filename, sizeof(filename));
-        if (zret == (size_t) -1)
+        else if (prepared == 0)
         {
-            RefuseAccess(conn, recvbuffer);
-            return true;
-        }
-
-        PathRemoveTrailingSlash(filename, strlen(filename));
-
-        Log(LOG_LEVEL_VERBOSE, "%14s %7s %s",
-            "Translated to:", "GET", filename);
-
-        if (acl_CheckPath(paths_acl, filename,
-                          conn->ipaddr, conn->revdns,
-                          KeyPrintableHash(ConnectionInfoKey(conn->conn_info)))
-            == false)
-        {
-            Log(LOG_LEVEL_INFO, "access denied to GET: %s", filename);
-            RefuseAccess(conn, recvbuffer);
             return true;
         }
 
@@ -702,12 +735,6 @@ bool BusyWithNewProtocol(EvalContext *ctx, ServerConnectionState *conn)
             get_args.buf_size = 2048;
         }
 
-        /* TODO eliminate! */
-        get_args.conn = conn;
-        get_args.encrypt = false;
-        get_args.replybuff = sendbuffer;
-        get_args.replyfile = filename;
-
         CfGetFile(&get_args);
 
         return true;
@@ -1029,6 +1056,38 @@ bool BusyWithNewProtocol(EvalContext *ctx, ServerConnectionState *conn)
          * it and our caller can close the connection: */
         return false;
 
+    case PROTOCOL_COMMAND_GET_RANGE:
+    {
+        intmax_t offset, length;
+        int ret = sscanf(recvbuffer, "GETRANGE %jd %jd %[^\n]",
+                         &offset, &length, filename);
+
+        if (ret != 3 || offset < 0 || length < 0)
+        {
+            goto protocol_error;
+        }
+
+        Log(LOG_LEVEL_VERBOSE, "%14s %7s %s (%jd+%jd)",
+            "Received:", "GETRANGE", filename, offset, length);
+
+        int prepared = PrepareFileGet(conn, "GETRANGE", recvbuffer,
+                                      filename, sizeof(filename),
+                                      sendbuffer, &get_args);
+        if (prepared == -1)
+        {
+            goto protocol_error;
+        }
+        else if (prepared == 0)
+        {
+            return true;
+        }
+
+        get_args.buf_size = 2048;
+
+        CfGetFileRange(&get_args, offset, length);
+
+        return true;
+    }
     case PROTOCOL_COMMAND_BAD:
 
         Log(LOG_LEVEL_WARNING, "Unexpected protocol command: %s", recvbuffer);
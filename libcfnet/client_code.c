@@ -153,19 +153,11 @@ int TLSConnect(ConnectionInfo *conn_info, bool trust_server,
     return ret;
 }
 
-/**
- * @NOTE if #flags.protocol_version is CF_PROTOCOL_UNDEFINED, then classic
- *       protocol is used by default.
- */
-AgentConnection *ServerConnection(const char *server, const char *port,
-                                  unsigned int connect_timeout,
-                                  ConnectionFlags flags, int *err)
+static AgentConnection *ServerConnectionNew(const char *server,
+                                            const char *port,
+                                            ConnectionFlags flags)
 {
-    AgentConnection *conn = NULL;
-    int ret;
-    *err = 0;
-
-    conn = NewAgentConn(server, port, flags);
+    AgentConnection *conn = NewAgentConn(server, port, flags);
 
 #if !defined(__MINGW32__)
     signal(SIGPIPE, SIG_IGN);
@@ -182,26 +174,19 @@ AgentConnection *ServerConnection(const char *server, const char *port,
     strlcpy(conn->username, "root", sizeof(conn->username));
 #endif
 
-    if (port == NULL || *port == '\0')
-    {
-        port = CFENGINE_PORT_STR;
-    }
-
-    char txtaddr[CF_MAX_IP_LEN] = "";
-    conn->conn_info->sd = SocketConnect(server, port, connect_timeout,
-                                        flags.force_ipv4,
-                                        txtaddr, sizeof(txtaddr));
-    if (conn->conn_info->sd == -1)
-    {
-        Log(LOG_LEVEL_INFO, "No server is responding on port: %s",
-            port);
-        DisconnectServer(conn);
-        *err = -1;
-        return NULL;
-    }
+    return conn;
+}
 
-    assert(sizeof(conn->remoteip) >= sizeof(txtaddr));
-    strcpy(conn->remoteip, txtaddr);
+/**
+ * Run the TLS or classic protocol handshake on the already connected
+ * #conn, freeing #conn in case of failure.
+ */
+static AgentConnection *ServerConnectionHandshake(AgentConnection *conn,
+                                                  const char *server,
+                                                  ConnectionFlags flags,
+                                                  int *err)
+{
+    int ret;
 
     switch (flags.protocol_version)
     {
@@ -269,6 +254,88 @@ AgentConnection *ServerConnection(const char *server, const char *port,
     return conn;
 }
 
+/**
+ * @NOTE if #flags.protocol_version is CF_PROTOCOL_UNDEFINED, then classic
+ *       protocol is used by default.
+ */
+AgentConnection *ServerConnection(const char *server, const char *port,
+                                  unsigned int connect_timeout,
+                                  ConnectionFlags flags, int *err)
+{
+    *err = 0;
+
+    AgentConnection *conn = ServerConnectionNew(server, port, flags);
+
+    if (port == NULL || *port == '\0')
+    {
+        port = CFENGINE_PORT_STR;
+    }
+
+    char txtaddr[CF_MAX_IP_LEN] = "";
+    conn->conn_info->sd = SocketConnect(server, port, connect_timeout,
+                                        flags.force_ipv4,
+                                        txtaddr, sizeof(txtaddr));
+    if (conn->conn_info->sd == -1)
+    {
+        Log(LOG_LEVEL_INFO, "No server is responding on port: %s",
+            port);
+        DisconnectServer(conn);
+        *err = -1;
+        return NULL;
+    }
+
+    assert(sizeof(conn->remoteip) >= sizeof(txtaddr));
+    strcpy(conn->remoteip, txtaddr);
+
+    return ServerConnectionHandshake(conn, server, flags, err);
+}
+
+/**
+ * Connect to whichever of #servers responds first, see SocketConnectFirst().
+ *
+ * @param #winner set to the index of the server that accepted the TCP
+ *                connection, or to #num_servers if none did. It is set even
+ *                if the protocol handshake failed afterwards, so that the
+ *                caller can retry without that server.
+ */
+AgentConnection *ServerConnectionFirst(const char *const *servers,
+                                       size_t num_servers, const char *port,
+                                       unsigned int connect_timeout,
+                                       ConnectionFlags flags,
+                                       size_t *winner, int *err)
+{
+    *err = 0;
+    *winner = num_servers;
+
+    const char *connect_port = port;
+    if (connect_port == NULL || *connect_port == '\0')
+    {
+        connect_port = CFENGINE_PORT_STR;
+    }
+
+    char txtaddr[CF_MAX_IP_LEN] = "";
+    int sd = SocketConnectFirst(servers, num_servers, connect_port,
+                                connect_timeout, flags.force_ipv4, winner,
+                                txtaddr, sizeof(txtaddr));
+    if (sd == -1)
+    {
+        Log(LOG_LEVEL_INFO, "No server is responding on port: %s",
+            connect_port);
+        *winner = num_servers;
+        *err = -1;
+        return NULL;
+    }
+
+    const char *server = servers[*winner];
+    AgentConnection *conn = ServerConnectionNew(server, port, flags);
+    conn->conn_info->sd = sd;
+
+    assert(sizeof(conn->remoteip) >= sizeof(txtaddr));
+    strcpy(conn->remoteip, txtaddr);
+
+    return ServerConnectionHandshake(conn, server, flags, err);
+}
+
 /*********************************************************************/
 
 void DisconnectServer(AgentConnection *conn)
@@ -682,23 +749,18 @@ static void FlushFileStream(int sd, int toget)
     }
 }
 
+/**
+ * Send the GET or GETRANGE request #command, and receive the #size bytes of
+ * the reply into the newly created file #dest.
+ */
 /* TODO finalise socket or TLS session in all cases that this function fails
  * and the transaction protocol is out of sync. */
-int CopyRegularFileNet(const char *source, const char *dest, off_t size,
-                       bool encrypt, AgentConnection *conn)
+static bool ReceiveFileNet(const char *command, const char *source,
+                           const char *dest, off_t size, AgentConnection *conn)
 {
-    char *buf, workbuf[CF_BUFSIZE], cfchangedstr[265];
+    char *buf, cfchangedstr[265];
     const int buf_size = 2048;
 
-    /* We encrypt only for CLASSIC protocol. The TLS protocol is always over
-     * encrypted layer, so it does not support encrypted (S*) commands. */
-    encrypt = encrypt && conn->conn_info->protocol == CF_PROTOCOL_CLASSIC;
-
-    if (encrypt)
-    {
-        return EncryptCopyRegularFileNet(source, dest, size, conn);
-    }
-
     snprintf(cfchangedstr, 255, "%s%s", CF_CHANGEDSTR1, CF_CHANGEDSTR2);
 
     if ((strlen(dest) > CF_BUFSIZE - 20))
@@ -719,19 +781,9 @@ int CopyRegularFileNet(const char *source, const char *dest, off_t size,
         return false;
     }
 
-    workbuf[0] = '\0';
-    int tosend = snprintf(workbuf, CF_BUFSIZE, "GET %d %s", buf_size, source);
-    if (tosend <= 0 || tosend >= CF_BUFSIZE)
-    {
-        Log(LOG_LEVEL_ERR, "Failed to compose GET command for file %s",
-            source);
-        close(dd);
-        return false;
-    }
-
     /* Send proposition C0 */
 
-    if (SendTransaction(conn->conn_info, workbuf, tosend, CF_DONE) == -1)
+    if (SendTransaction(conn->conn_info, command, 0, CF_DONE) == -1)
     {
         Log(LOG_LEVEL_ERR, "Couldn't send GET command");
         close(dd);
@@ -851,3 +903,58 @@ int CopyRegularFileNet(const char *source, const char *dest, off_t size,
     free(buf);
     return true;
 }
+
+int CopyRegularFileNet(const char *source, const char *dest, off_t size,
+                       bool encrypt, AgentConnection *conn)
+{
+    char workbuf[CF_BUFSIZE];
+    const int buf_size = 2048;
+
+    /* We encrypt only for CLASSIC protocol. The TLS protocol is always over
+     * encrypted layer, so it does not support encrypted (S*) commands. */
+    encrypt = encrypt && conn->conn_info->protocol == CF_PROTOCOL_CLASSIC;
+
+    if (encrypt)
+    {
+        return EncryptCopyRegularFileNet(source, dest, size, conn);
+    }
+
+    int tosend = snprintf(workbuf, CF_BUFSIZE, "GET %d %s", buf_size, source);
+    if (tosend <= 0 || tosend >= CF_BUFSIZE)
+    {
+        Log(LOG_LEVEL_ERR, "Failed to compose GET command for file %s",
+            source);
+        return false;
+    }
+
+    return ReceiveFileNet(workbuf, source, dest, size, conn);
+}
+
+/**
+ * Copy #size bytes starting at #offset of remote file #source, into the
+ * new local file #dest. Only supported with the TLS protocol.
+ */
+bool CopyRegularFileRangeNet(const char *source, const char *dest,
+                             off_t offset, off_t size, AgentConnection *conn)
+{
+    char workbuf[CF_BUFSIZE];
+
+    if (conn->conn_info->protocol != CF_PROTOCOL_TLS)
+    {
+        Log(LOG_LEVEL_ERR,
+            "Partial file copy from '%s' requires the TLS protocol",
+            conn->this_server);
+        return false;
+    }
+
+    int tosend = snprintf(workbuf, CF_BUFSIZE, "GETRANGE %jd %jd %s",
+                          (intmax_t) offset, (intmax_t) size, source);
+    if (tosend <= 0 || tosend >= CF_BUFSIZE)
+    {
+        Log(LOG_LEVEL_ERR, "Failed to compose GETRANGE command for file %s",
+            source);
+        return false;
+    }
+
+    return ReceiveFileNet(workbuf, source, dest, size, conn);
+}
@@ -42,11 +42,18 @@ void DetermineCfenginePort(void);
 AgentConnection *ServerConnection(const char *server, const char *port,
                                   unsigned int connect_timeout,
                                   ConnectionFlags flags, int *err);
+AgentConnection *ServerConnectionFirst(const char *const *servers,
+                                       size_t num_servers, const char *port,
+                                       unsigned int connect_timeout,
+                                       ConnectionFlags flags,
+                                       size_t *winner, int *err);
 void DisconnectServer(AgentConnection *conn);
 
 int CompareHashNet(const char *file1, const char *file2, bool encrypt, AgentConnection *conn);
 int CopyRegularFileNet(const char *source, const char *dest, off_t size,
                        bool encrypt, AgentConnection *conn);
+bool CopyRegularFileRangeNet(const char *source, const char *dest,
+                             off_t offset, off_t size, AgentConnection *conn);
 Item *RemoteDirList(const char *dirname, bool encrypt, AgentConnection *conn);
 
 int TLSConnectCallCollect(ConnectionInfo *conn_info, const char *username);
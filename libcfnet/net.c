@@ -30,6 +30,7 @@
 #include <connection_info.h>
 #include <logging.h>
 #include <misc_lib.h>
+#include <alloc.h>
 
 
 /* TODO remove libpromises dependency. */
@@ -393,6 +394,60 @@ void EnforceBwLimit(int tosend)
 /*************************************************************************/
 
 
+/**
+   Binds #sd to BINDINTERFACE, if one was requested.
+
+   @return false only if the interface could not be looked up, failure to
+           bind() is logged but not fatal.
+*/
+static bool BindToInterface(int sd, bool force_ipv4)
+{
+    if (BINDINTERFACE[0] == '\0')
+    {
+        return true;
+    }
+
+    struct addrinfo query = {
+        .ai_family = force_ipv4 ? AF_INET : AF_UNSPEC,
+        .ai_socktype = SOCK_STREAM,
+        /* returned address is for bind() */
+        .ai_flags = AI_PASSIVE
+    };
+
+    struct addrinfo *response = NULL, *ap;
+    int ret = getaddrinfo(BINDINTERFACE, NULL, &query, &response);
+    if (ret != 0)
+    {
+        Log(LOG_LEVEL_ERR,
+            "Unable to lookup interface '%s' to bind. (getaddrinfo: %s)",
+            BINDINTERFACE, gai_strerror(ret));
+
+        if (response != NULL)
+        {
+            freeaddrinfo(response);
+        }
+        return false;
+    }
+
+    for (ap = response; ap != NULL; ap = ap->ai_next)
+    {
+        if (bind(sd, ap->ai_addr, ap->ai_addrlen) == 0)
+        {
+            break;
+        }
+    }
+    if (ap == NULL)
+    {
+        Log(LOG_LEVEL_ERR,
+            "Unable to bind to interface '%s'. (bind: %s)",
+            BINDINTERFACE, GetErrorStr());
+    }
+    assert(response);                 /* getaddrinfo was successful */
+    freeaddrinfo(response);
+
+    return true;
+}
+
 /**
    Tries to connect() to server #host, returns the socket descriptor and the
    IP address that succeeded in #txtaddr.
@@ -447,48 +502,12 @@ int SocketConnect(const char *host, const char *port,
         else
         {
             /* Bind socket to specific interface, if requested. */
-            if (BINDINTERFACE[0] != '\0')
+            if (!BindToInterface(sd, force_ipv4))
             {
-                struct addrinfo query2 = {
-                    .ai_family = force_ipv4 ? AF_INET : AF_UNSPEC,
-                    .ai_socktype = SOCK_STREAM,
-                    /* returned address is for bind() */
-                    .ai_flags = AI_PASSIVE
-                };
-
-                struct addrinfo *response2 = NULL, *ap2;
-                int ret2 = getaddrinfo(BINDINTERFACE, NULL, &query2, &response2);
-                if (ret2 != 0)
-                {
-                    Log(LOG_LEVEL_ERR,
-                        "Unable to lookup interface '%s' to bind. (getaddrinfo: %s)",
-                        BINDINTERFACE, gai_strerror(ret2));
-
-                    if (response2 != NULL)
-                    {
-                        freeaddrinfo(response2);
-                    }
-                    assert(response);   /* first getaddrinfo was successful */
-                    freeaddrinfo(response);
-                    cf_closesocket(sd);
-                    return -1;
-                }
-
-                for (ap2 = response2; ap2 != NULL; ap2 = ap2->ai_next)
-                {
-                    if (bind(sd, ap2->ai_addr, ap2->ai_addrlen) == 0)
-                    {
-                        break;
-                    }
-                }
-                if (ap2 == NULL)
-                {
-                    Log(LOG_LEVEL_ERR,
-                        "Unable to bind to interface '%s'. (bind: %s)",
-                        BINDINTERFACE, GetErrorStr());
-                }
-                assert(response2);     /* second getaddrinfo was successful */
-                freeaddrinfo(response2);
+                assert(response);   /* first getaddrinfo was successful */
+                freeaddrinfo(response);
+                cf_closesocket(sd);
+                return -1;
             }
 
             connected = TryConnect(sd, connect_timeout * 1000,
@@ -523,6 +542,362 @@ int SocketConnect(const char *host, const char *port,
 }
 
 
+/* Delay between starting consecutive connection attempts in
+ * SocketConnectFirst(), as recommended by RFC 8305 (Happy Eyeballs v2). */
+#define CONNECTION_ATTEMPT_DELAY_MS 250
+
+typedef struct
+{
+    int sd;
+    size_t host;
+    const struct addrinfo *ai;
+} ConnectAttempt;
+
+static long MsElapsed(const struct timespec *since)
+{
+    struct timespec now;
+    clock_gettime(PREFERRED_CLOCK, &now);
+    return (now.tv_sec - since->tv_sec) * 1000 +
+        (now.tv_nsec - since->tv_nsec) / 1000000;
+}
+
+static bool SetSocketNonBlocking(int sd, bool non_blocking)
+{
+#ifdef __MINGW32__
+    u_long enable = non_blocking ? 1 : 0;
+    int ret = ioctlsocket(sd, FIONBIO, &enable);
+# define NONBLOCK_CNTLNAME "ioctlsocket"
+#else
+    int arg = fcntl(sd, F_GETFL, NULL);
+    int ret = fcntl(sd, F_SETFL,
+                    non_blocking ? (arg | O_NONBLOCK) : (arg & ~O_NONBLOCK));
+# define NONBLOCK_CNTLNAME "fcntl"
+#endif
+
+    if (ret != 0)
+    {
+        Log(LOG_LEVEL_ERR,
+            "Failed to set socket to %s mode (" NONBLOCK_CNTLNAME ": %s)",
+            non_blocking ? "non-blocking" : "blocking", GetErrorStr());
+        return false;
+    }
+#undef NONBLOCK_CNTLNAME
+    return true;
+}
+
+static bool LastConnectInProgress(void)
+{
+#ifdef __MINGW32__
+    return (WSAGetLastError() == WSAEWOULDBLOCK);
+#else
+    return (errno == EINPROGRESS);
+#endif
+}
+
+/**
+   Starts a non-blocking connect() of #sd to #ai.
+
+   @return 1 if connected immediately, 0 if in progress, -1 on failure.
+*/
+static int StartConnect(int sd, const struct addrinfo *ai)
+{
+#ifndef __MINGW32__                 /* Windows fd_set is not a bitmap */
+    if (sd >= FD_SETSIZE)
+    {
+        Log(LOG_LEVEL_ERR,
+            "Open connections exceed FD_SETSIZE limit (%d >= %d)",
+            sd, FD_SETSIZE);
+        return -1;
+    }
+#endif
+
+    if (!SetSocketNonBlocking(sd, true))
+    {
+        return -1;
+    }
+
+    if (connect(sd, ai->ai_addr, ai->ai_addrlen) == 0)
+    {
+        return 1;
+    }
+    else if (LastConnectInProgress())
+    {
+        return 0;
+    }
+
+    Log(LOG_LEVEL_VERBOSE, "Failed to connect to server (connect: %s)",
+        GetErrorStr());
+    return -1;
+}
+
+/**
+   Connects to whichever of #hosts answers first, happy eyeballs style.
+
+   All addresses of all #hosts are tried, in the order given and in the
+   order getaddrinfo() returns them for each host. A new non-blocking
+   connect() is started every CONNECTION_ATTEMPT_DELAY_MS, or as soon as a
+   previous attempt fails, without waiting for earlier attempts to time out.
+   The first attempt to complete wins and the rest are closed.
+
+   This way a dead or slow host early in the list only delays the
+   connection by a fraction of a second instead of a full #connect_timeout.
+
+   @param #connect_timeout how long to wait in total, zero blocks forever
+   @param #winner on success set to the index in #hosts that connected
+   @param #txtaddr on success the IP connected to in textual representation
+   @return Connected socket descriptor or -1 in case of failure.
+*/
+int SocketConnectFirst(const char *const *hosts, size_t num_hosts,
+                       const char *port, unsigned int connect_timeout,
+                       bool force_ipv4, size_t *winner,
+                       char *txtaddr, size_t txtaddr_size)
+{
+    assert(num_hosts > 0);
+
+    struct addrinfo query = {
+        .ai_family = force_ipv4 ? AF_INET : AF_UNSPEC,
+        .ai_socktype = SOCK_STREAM
+    };
+
+    struct addrinfo **responses = xcalloc(num_hosts, sizeof(*responses));
+    size_t num_candidates = 0;
+
+    for (size_t i = 0; i < num_hosts; i++)
+    {
+        int ret = getaddrinfo(hosts[i], port, &query, &responses[i]);
+        if (ret != 0)
+        {
+            Log(LOG_LEVEL_INFO,
+                "Unable to find host '%s' service '%s' (%s)",
+                hosts[i], port, gai_strerror(ret));
+            if (responses[i] != NULL)
+            {
+                freeaddrinfo(responses[i]);
+                responses[i] = NULL;
+            }
+            continue;
+        }
+
+        for (const struct addrinfo *ap = responses[i]; ap != NULL;
+             ap = ap->ai_next)
+        {
+            num_candidates++;
+        }
+    }
+
+    ConnectAttempt *attempts = xcalloc(MAX(num_candidates, 1),
+                                       sizeof(*attempts));
+    size_t n = 0;
+    for (size_t i = 0; i < num_hosts; i++)
+    {
+        for (const struct addrinfo *ap = responses[i]; ap != NULL;
+             ap = ap->ai_next)
+        {
+            attempts[n].sd = -1;
+            attempts[n].host = i;
+            attempts[n].ai = ap;
+            n++;
+        }
+    }
+    assert(n == num_candidates);
+
+    struct timespec start;
+    clock_gettime(PREFERRED_CLOCK, &start);
+    const long timeout_ms = connect_timeout * 1000L;
+
+    size_t next = 0;                     /* next attempt to be started */
+    size_t pending = 0;                  /* attempts in progress */
+    long next_start_ms = 0;              /* when to start the next one */
+    int sd = -1;
+    size_t won = 0;
+
+    while (sd == -1 && (next < num_candidates || pending > 0))
+    {
+        long elapsed = MsElapsed(&start);
+        if (timeout_ms > 0 && elapsed >= timeout_ms)
+        {
+            Log(LOG_LEVEL_INFO, "Timeout connecting to server");
+            break;
+        }
+
+        if (next < num_candidates && elapsed >= next_start_ms)
+        {
+            ConnectAttempt *a = &attempts[next];
+            next++;
+
+            getnameinfo(a->ai->ai_addr, a->ai->ai_addrlen,
+                        txtaddr, txtaddr_size, NULL, 0, NI_NUMERICHOST);
+            Log(LOG_LEVEL_VERBOSE,
+                "Connecting to host %s, port %s as address %s",
+                hosts[a->host], port, txtaddr);
+
+            a->sd = socket(a->ai->ai_family, a->ai->ai_socktype,
+                           a->ai->ai_protocol);
+            if (a->sd == -1)
+            {
+                Log(LOG_LEVEL_ERR,
+                    "Couldn't open a socket to '%s' (socket: %s)",
+                    txtaddr, GetErrorStr());
+                continue;               /* start the next one right away */
+            }
+
+            int ret = BindToInterface(a->sd, force_ipv4) ?
+                StartConnect(a->sd, a->ai) : -1;
+            if (ret == 1)
+            {
+                sd = a->sd;
+                won = next - 1;
+                break;
+            }
+            else if (ret == -1)
+            {
+                cf_closesocket(a->sd);
+                a->sd = -1;
+                continue;
+            }
+
+            pending++;
+            next_start_ms = elapsed + CONNECTION_ATTEMPT_DELAY_MS;
+        }
+
+        /* Wait until an attempt completes, or it is time to start the next
+         * one, or we time out. */
+        long wait_ms = -1;
+        if (next < num_candidates)
+        {
+            wait_ms = MAX(next_start_ms - elapsed, 0);
+        }
+        if (timeout_ms > 0)
+        {
+            long left = timeout_ms - elapsed;
+            wait_ms = (wait_ms == -1) ? left : MIN(wait_ms, left);
+        }
+
+        fd_set myset;
+        FD_ZERO(&myset);
+        int maxfd = -1;
+        for (size_t i = 0; i < next; i++)
+        {
+            if (attempts[i].sd != -1)
+            {
+                FD_SET(attempts[i].sd, &myset);
+                maxfd = MAX(maxfd, attempts[i].sd);
+            }
+        }
+
+        if (maxfd == -1)
+        {
+            continue;                   /* nothing pending, start next */
+        }
+
+        struct timeval tv, *tvp = NULL;
+        if (wait_ms >= 0)
+        {
+            tv.tv_sec = wait_ms / 1000;
+            tv.tv_usec = (wait_ms % 1000) * 1000;
+            tvp = &tv;
+        }
+
+        int ret = select(maxfd + 1, NULL, &myset, NULL, tvp);
+        if (ret == -1)
+        {
+            if (errno == EINTR)
+            {
+                Log(LOG_LEVEL_ERR,
+                    "Socket connect was interrupted by signal");
+            }
+            else
+            {
+                Log(LOG_LEVEL_ERR,
+                    "Failure while connecting (select: %s)",
+                    GetErrorStr());
+            }
+            break;
+        }
+
+        for (size_t i = 0; ret > 0 && i < next; i++)
+        {
+            ConnectAttempt *a = &attempts[i];
+            if (a->sd == -1 || !FD_ISSET(a->sd, &myset))
+            {
+                continue;
+            }
+
+            int errcode;
+            socklen_t opt_len = sizeof(errcode);
+            if (getsockopt(a->sd, SOL_SOCKET, SO_ERROR,
+                           (void *) &errcode, &opt_len) == -1)
+            {
+                errcode = errno;
+            }
+
+            if (errcode == 0)
+            {
+                sd = a->sd;
+                won = i;
+                break;
+            }
+
+            getnameinfo(a->ai->ai_addr, a->ai->ai_addrlen,
+                        txtaddr, txtaddr_size, NULL, 0, NI_NUMERICHOST);
+            Log(LOG_LEVEL_VERBOSE, "Unable to connect to address %s (%s)",
+                txtaddr, GetErrorStrFromCode(errcode));
+            cf_closesocket(a->sd);
+            a->sd = -1;
+            pending--;
+            next_start_ms = 0;          /* start the next one right away */
+        }
+    }
+
+    /* Close all the losers. */
+    for (size_t i = 0; i < next; i++)
+    {
+        if (attempts[i].sd != -1 && attempts[i].sd != sd)
+        {
+            cf_closesocket(attempts[i].sd);
+        }
+    }
+
+    if (sd != -1)
+    {
+        const ConnectAttempt *a = &attempts[won];
+        getnameinfo(a->ai->ai_addr, a->ai->ai_addrlen,
+                    txtaddr, txtaddr_size, NULL, 0, NI_NUMERICHOST);
+
+        /* Connection succeeded, return to blocking mode. */
+        SetSocketNonBlocking(sd, false);
+        if (timeout_ms > 0)
+        {
+            SetReceiveTimeout(sd, timeout_ms);
+        }
+
+        *winner = a->host;
+        Log(LOG_LEVEL_VERBOSE,
+            "Connected to host %s address %s port %s (socket descriptor %d)",
+            hosts[a->host], txtaddr, port, sd);
+    }
+    else
+    {
+        Log(LOG_LEVEL_VERBOSE,
+            "Unable to connect to any of %zu hosts on port %s",
+            num_hosts, port);
+    }
+
+    for (size_t i = 0; i < num_hosts; i++)
+    {
+        if (responses[i] != NULL)
+        {
+            freeaddrinfo(responses[i]);
+        }
+    }
+    free(responses);
+    free(attempts);
+
+    return sd;
+}
+
+
+
 #if !defined(__MINGW32__)
 
 #if defined(__hpux) && defined(__GNUC__)
@@ -42,6 +42,10 @@ int SetReceiveTimeout(int fd, unsigned long ms);
 int SocketConnect(const char *host, const char *port,
                   unsigned int connect_timeout, bool force_ipv4,
                   char *txtaddr, size_t txtaddr_size);
+int SocketConnectFirst(const char *const *hosts, size_t num_hosts,
+                       const char *port, unsigned int connect_timeout,
+                       bool force_ipv4, size_t *winner,
+                       char *txtaddr, size_t txtaddr_size);
 
 /**
  * @NOTE DO NOT USE THIS FUNCTION. The only reason it is non-static is because
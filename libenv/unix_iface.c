@@ -30,7 +30,7 @@
 #include <misc_lib.h>
 #include <communication.h>
 #include <string_lib.h>
-#include <regex.h>                                       /* StringMatchFull */
+#include <regex.h>                                              /* RegexSet */
 #include <files_interfaces.h>
 #include <files_names.h>
 #include <known_dirs.h>
@@ -84,6 +84,7 @@ static bool IgnoreInterface(char *name);
 static void InitIgnoreInterfaces(void);
 
 static Rlist *IGNORE_INTERFACES = NULL; /* GLOBAL_E */
+static RegexSet *IGNORE_INTERFACES_REGEX = NULL; /* GLOBAL_E */
 
 typedef void (*ProcPostProcessFn)(void *ctx, void *json);
 
@@ -703,6 +704,15 @@ static void InitIgnoreInterfaces()
     }
  
     fclose(fin);
+
+    Seq *regexes = SeqNew(RlistLen(IGNORE_INTERFACES), NULL);
+    for (const Rlist *rp = IGNORE_INTERFACES; rp != NULL; rp = rp->next)
+    {
+        SeqAppend(regexes, RlistScalarValue(rp));
+    }
+    RegexSetDestroy(IGNORE_INTERFACES_REGEX);
+    IGNORE_INTERFACES_REGEX = RegexSetNew(regexes);
+    SeqDestroy(regexes);
 }
 
 /*******************************************************************/
@@ -714,14 +724,20 @@ static bool IgnoreInterface(char *name)
     for (rp = IGNORE_INTERFACES; rp != NULL; rp=rp->next)
     {
         /* FIXME: review this strcmp. Moved out from StringMatch */
-        if (!strcmp(RlistScalarValue(rp), name)
-            || StringMatchFull(RlistScalarValue(rp), name))
+        if (!strcmp(RlistScalarValue(rp), name))
         {
             Log(LOG_LEVEL_VERBOSE, "Ignoring interface '%s' because it matches '%s'",name,CF_IGNORE_INTERFACES);
             return true;
         }    
     }
 
+    if (IGNORE_INTERFACES_REGEX != NULL &&
+        RegexSetMatchFull(IGNORE_INTERFACES_REGEX, name) >= 0)
+    {
+        Log(LOG_LEVEL_VERBOSE, "Ignoring interface '%s' because it matches '%s'",name,CF_IGNORE_INTERFACES);
+        return true;
+    }
+
     return false;
 }
 
@@ -30,6 +30,7 @@
 #include <logging.h>
 #include <chflags.h>
 #include <audit.h>
+#include <string_lib.h>                                 /* SafeStringDuplicate */
 
 #define CF_DEFINECLASSES "classes"
 #define CF_TRANSACTION   "action"
@@ -42,7 +43,58 @@ void ClearFilesAttributes(Attributes *whom)
     GidListDestroy(whom->perms.groups);
 }
 
+static UidList *UidListCopy(const UidList *uids)
+{
+    UidList *copy = NULL;
+    UidList **tail = &copy;
+    for (const UidList *u = uids; u != NULL; u = u->next)
+    {
+        *tail = xmemdup(u, sizeof(UidList));
+        (*tail)->uidname = SafeStringDuplicate(u->uidname);
+        (*tail)->next = NULL;
+        tail = &(*tail)->next;
+    }
+    return copy;
+}
+
+static GidList *GidListCopy(const GidList *gids)
+{
+    GidList *copy = NULL;
+    GidList **tail = &copy;
+    for (const GidList *g = gids; g != NULL; g = g->next)
+    {
+        *tail = xmemdup(g, sizeof(GidList));
+        (*tail)->gidname = SafeStringDuplicate(g->gidname);
+        (*tail)->next = NULL;
+        tail = &(*tail)->next;
+    }
+    return copy;
+}
+
+static Attributes ExtractFilesAttributes(const EvalContext *ctx, const Promise *pp);
+
+/**
+ * The files attributes are a function of the promise constraints only, so
+ * they are extracted once per expanded promise and memoized in it; a
+ * depth_search asks again for every file it visits.
+ */
 Attributes GetFilesAttributes(const EvalContext *ctx, const Promise *pp)
+{
+    if (pp->files_attributes == NULL)
+    {
+        /* Cleared by PromiseAppendConstraint() and PromiseDestroy(). */
+        Attributes *memo = xmalloc(sizeof(Attributes));
+        *memo = ExtractFilesAttributes(ctx, pp);
+        ((Promise *) pp)->files_attributes = memo;
+    }
+
+    Attributes attr = *pp->files_attributes;
+    attr.perms.owners = UidListCopy(attr.perms.owners);
+    attr.perms.groups = GidListCopy(attr.perms.groups);
+    return attr;
+}
+
+static Attributes ExtractFilesAttributes(const EvalContext *ctx, const Promise *pp)
 {
     Attributes attr = { {0} };
 
@@ -64,7 +116,8 @@ Attributes GetFilesAttributes(const EvalContext *ctx, const Promise *pp)
 
     if (!attr.template_method )
     {
-        xasprintf(&attr.template_method, "cfengine");
+        static char default_template_method[] = "cfengine";
+        attr.template_method = default_template_method;
     }
 
     attr.haveeditline = PromiseBundleOrBodyConstraintExists(ctx, "edit_line", pp);
@@ -981,6 +1034,7 @@ FileCopy GetCopyConstraints(const EvalContext *ctx, const Promise *pp)
     f.verify = PromiseGetConstraintAsBoolean(ctx, "verify", pp);
     f.purge = PromiseGetConstraintAsBoolean(ctx, "purge", pp);
     f.missing_ok = PromiseGetConstraintAsBoolean(ctx, "missing_ok", pp);
+    f.snapshot = PromiseGetConstraintAsBoolean(ctx, "snapshot", pp);
     f.destination = NULL;
 
     return f;
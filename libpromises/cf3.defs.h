@@ -432,6 +432,8 @@ typedef enum
     COMMON_CONTROL_TLS_MIN_VERSION,
     COMMON_CONTROL_PACKAGE_INVENTORY,
     COMMON_CONTROL_PACKAGE_MODULE,
+    COMMON_CONTROL_PERSISTENT_FUNCTION_CACHE,
+    COMMON_CONTROL_PERSISTENT_FUNCTION_CACHE_TTL,
     COMMON_CONTROL_MAX
 } CommonControl;
 
@@ -484,6 +486,7 @@ typedef enum
     AGENT_CONTROL_VERBOSE,
     AGENT_CONTROL_REPORTCLASSLOG,
     AGENT_CONTROL_SELECT_END_MATCH_EOF,
+    AGENT_CONTROL_CONCURRENT_COMMANDS,
     AGENT_CONTROL_NONE
 } AgentControl;
 
@@ -1498,6 +1501,7 @@ typedef struct
     short timeout;
     ProtocolVersion protocol_version;
     bool missing_ok;
+    bool snapshot;                              /* from policy snapshot */
 } FileCopy;
 
 typedef struct
@@ -145,7 +145,7 @@ char BINDINTERFACE[CF_MAXVARSIZE]; /* GLOBAL_P */
 
   Utilized in generic_agent.c for
     - cf_promises_validated filename
-    - GenericAgentCheckPolicy
+    - IsPolicyPrecheckNeeded
     - GenericAgentLoadPolicy (ReadPolicyValidatedFile)
 */
 bool MINUSF = false; /* GLOBAL_A */
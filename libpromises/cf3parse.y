@@ -47,7 +47,6 @@
 int yylex(void);
 extern char *yytext;
 
-static int RelevantBundle(const char *agent, const char *blocktype);
 static bool LvalWantsBody(char *stype, char *lval);
 static SyntaxTypeMatch CheckSelection(const char *type, const char *name, const char *lval, Rval rval);
 static SyntaxTypeMatch CheckConstraint(const char *type, const char *lval, Rval rval, const PromiseTypeSyntax *ss);
@@ -65,6 +64,9 @@ static size_t CURRENT_PROMISER_LINE = 0;
 
 #define YYMALLOC xmalloc
 
+/* Errors reported per file, the ones after that are only counted. */
+#define PARSER_MAX_ERRORS 12
+
 #define ParserDebug(...) LogDebug(LOG_MOD_PARSER, __VA_ARGS__)
 
 %}
@@ -252,7 +254,7 @@ aitem:                 IDSYNTAX  /* recipient of argument is never a literal */
 
 bundlebody:            body_begin
                        {
-                           if (RelevantBundle(CF_AGENTTYPES[P.agent_type], P.blocktype))
+                           if (BundleTypeIsRelevant(P.agent_type, P.blocktype))
                            {
                                INSTALL_SKIP = false;
                            }
@@ -1154,6 +1156,8 @@ givearglist:           '('
                            if (++P.arg_nesting >= CF_MAX_NESTING)
                            {
                                fatal_yyerror("Nesting of functions is deeper than recommended");
+                               P.arg_nesting--;
+                               YYABORT;
                            }
                            P.currentfnid[P.arg_nesting] = xstrdup(P.currentid);
                            ParserDebug("\tP:%s:%s:%s begin givearglist for function %s, level %d\n", P.block,P.blocktype,P.blockid, P.currentfnid[P.arg_nesting], P.arg_nesting );
@@ -1244,6 +1248,13 @@ gaitem:                IDSYNTAX
 
 static void ParseErrorVColumnOffset(int column_offset, const char *s, va_list ap)
 {
+    if (P.error_count > PARSER_MAX_ERRORS)
+    {
+        /* Keep counting, the rest of the file is parsed without reporting. */
+        P.error_count++;
+        return;
+    }
+
     char *errmsg = StringVFormat(s, ap);
     fprintf(stderr, "%s:%d:%d: error: %s\n", P.filename, P.line_no, P.line_pos + column_offset, errmsg);
     free(errmsg);
@@ -1258,12 +1269,10 @@ static void ParseErrorVColumnOffset(int column_offset, const char *s, va_list ap
 
     }
 
-    if (P.error_count > 12)
+    if (P.error_count > PARSER_MAX_ERRORS)
     {
         fprintf(stderr, "Too many errors\n");
-        exit(EXIT_FAILURE);
     }
-
 }
 
 static void ParseErrorColumnOffset(int column_offset, const char *s, ...)
@@ -1294,6 +1303,11 @@ static void ParseWarningV(unsigned int warning, const char *s, va_list ap)
         return;
     }
 
+    if (P.error_count > PARSER_MAX_ERRORS)
+    {
+        return;
+    }
+
     char *errmsg = StringVFormat(s, ap);
     const char *warning_str = ParserWarningToString(warning);
 
@@ -1310,10 +1324,9 @@ static void ParseWarningV(unsigned int warning, const char *s, va_list ap)
         P.error_count++;
     }
 
-    if (P.error_count > 12)
+    if (P.error_count > PARSER_MAX_ERRORS)
     {
         fprintf(stderr, "Too many errors\n");
-        exit(EXIT_FAILURE);
     }
 }
 
@@ -1340,31 +1353,10 @@ static void fatal_yyerror(const char *s)
     }
 
     fprintf(stderr, "%s: %d,%d: Fatal error during parsing: %s, near token \'%.20s\'\n", P.filename, P.line_no, P.line_pos, s, sp ? sp : "NULL");
-    exit(EXIT_FAILURE);
-}
 
-static int RelevantBundle(const char *agent, const char *blocktype)
-{
-    if ((strcmp(agent, CF_AGENTTYPES[AGENT_TYPE_COMMON]) == 0) || (strcmp(CF_COMMONC, blocktype) == 0))
-    {
-        return true;
-    }
-
-/* Here are some additional bundle types handled by cfAgent */
-
-    Item *ip = SplitString("edit_line,edit_xml", ',');
-
-    if (strcmp(agent, CF_AGENTTYPES[AGENT_TYPE_AGENT]) == 0)
-    {
-        if (IsItemIn(ip, blocktype))
-        {
-            DeleteItemList(ip);
-            return true;
-        }
-    }
-
-    DeleteItemList(ip);
-    return false;
+    /* Fail the file without reporting what follows, the caller aborts the
+     * parse and it resumes from the next token as after syntax errors. */
+    P.error_count = PARSER_MAX_ERRORS + 1;
 }
 
 static bool LvalWantsBody(char *stype, char *lval)
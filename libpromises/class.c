@@ -26,8 +26,9 @@
 #include <map.h>
 #include <alloc.h>
 #include <string_lib.h> /* String*() */
-#include <regex.h>      /* CompileRegex,StringMatchFullWithPrecompiledRegex */
+#include <regex.h>      /* CachedRegexAcquire,StringMatchFullWithCachedRegex */
 #include <files_names.h>
+#include <string_intern.h>
 
 
 static void ClassDestroy(Class *cls);                /* forward declaration */
@@ -41,7 +42,7 @@ static void ClassDestroy_untyped(void *p)
 /**
    Define ClassMap.
    Key: a string which is always the fully qualified class name,
-        for example "default:127_0_0_1"
+        for example "default:127_0_0_1". It is interned.
 */
 
 TYPED_MAP_DECLARE(Class, char *, Class *)
@@ -49,7 +50,7 @@ TYPED_MAP_DECLARE(Class, char *, Class *)
 TYPED_MAP_DEFINE(Class, char *, Class *,
                  StringHash_untyped,
                  StringSafeEqual_untyped,
-                 free,
+                 StringInternRelease_untyped,
                  ClassDestroy_untyped)
 
 struct ClassTable_
@@ -80,11 +81,13 @@ static void ClassInit(Class *cls,
     }
     else
     {
-        cls->ns = xstrdup(ns);
+        cls->ns = StringIntern(ns);
     }
 
-    cls->name = xstrdup(name);
-    CanonifyNameInPlace(cls->name);
+    char *canonified = xstrdup(name);
+    CanonifyNameInPlace(canonified);
+    cls->name = StringIntern(canonified);
+    free(canonified);
 
     cls->is_soft = is_soft;
     cls->scope = scope;
@@ -100,8 +103,8 @@ static void ClassDestroySoft(Class *cls)
 {
     if (cls)
     {
-        free(cls->ns);
-        free(cls->name);
+        StringInternRelease(cls->ns);
+        StringInternRelease(cls->name);
         StringSetDestroy(cls->tags);
     }
 }
@@ -151,12 +154,14 @@ bool ClassTablePut(ClassTable *table,
 
     /* (cls->name != name) because canonification has happened. */
     char *fullname = StringConcatenate(3, ns, ":", cls->name);
+    const char *key = StringIntern(fullname);
+    free(fullname);
 
     Log(LOG_LEVEL_DEBUG, "Setting %sclass: %s",
         is_soft ? "" : "hard ",
-        fullname);
+        key);
 
-    return ClassMapInsert(table->classes, fullname, cls);
+    return ClassMapInsert(table->classes, (char *) key, cls);
 }
 
 Class *ClassTableGet(const ClassTable *table, const char *ns, const char *name)
@@ -174,10 +179,7 @@ Class *ClassTableGet(const ClassTable *table, const char *ns, const char *name)
 
 Class *ClassTableMatch(const ClassTable *table, const char *regex)
 {
-    ClassTableIterator *it = ClassTableIteratorNew(table, NULL, true, true);
-    Class *cls = NULL;
-
-    pcre *pattern = CompileRegex(regex);
+    CachedRegex *pattern = CachedRegexAcquire(regex);
     if (pattern == NULL)
     {
         // TODO: perhaps pcre has can give more info on this error?
@@ -185,18 +187,21 @@ Class *ClassTableMatch(const ClassTable *table, const char *regex)
         return NULL;
     }
 
+    ClassTableIterator *it = ClassTableIteratorNew(table, NULL, true, true);
+    Class *cls = NULL;
+
     while ((cls = ClassTableIteratorNext(it)))
     {
         bool matched;
         if (cls->ns)
         {
             char *class_expr = ClassRefToString(cls->ns, cls->name);
-            matched = StringMatchFullWithPrecompiledRegex(pattern, class_expr);
+            matched = StringMatchFullWithCachedRegex(pattern, class_expr);
             free(class_expr);
         }
         else
         {
-            matched = StringMatchFullWithPrecompiledRegex(pattern, cls->name);
+            matched = StringMatchFullWithCachedRegex(pattern, cls->name);
         }
 
         if (matched)
@@ -205,7 +210,7 @@ Class *ClassTableMatch(const ClassTable *table, const char *regex)
         }
     }
 
-    pcre_free(pattern);
+    CachedRegexRelease(pattern);
 
     ClassTableIteratorDestroy(it);
     return cls;
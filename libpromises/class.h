@@ -29,8 +29,8 @@
 
 typedef struct
 {
-    char *ns;                          /* NULL in case of default namespace */
-    char *name;                        /* class name */
+    const char *ns;           /* interned, NULL in case of default namespace */
+    const char *name;                               /* interned class name */
 
     ContextScope scope;
     bool is_soft;
@@ -105,7 +105,8 @@ static const char *const DB_PATHS_STATEDIR[] = {
     [dbid_agent_execution] = "nova_agent_execution",
     [dbid_bundles] = "bundles",
     [dbid_packages_installed] = "packages_installed",
-    [dbid_packages_updates] = "packages_updates"
+    [dbid_packages_updates] = "packages_updates",
+    [dbid_function_cache] = "cf_function_cache"
 };
 
 /*
@@ -539,6 +540,17 @@ bool DBCursorWriteEntry(DBCursor *cursor, const void *value, int value_size)
     return DBPrivWriteCursorEntry(cursor->cursor, value, value_size);
 }
 
+/**
+ * @brief Skip ahead to the first key that is greater than or equal to
+ *        #key_prefix, so that entries sharing a prefix can be range-scanned.
+ * @return false if the database backend doesn't keep keys sorted, in which
+ *         case the cursor is unchanged and a full scan is needed.
+ */
+bool DBCursorSeek(DBCursor *cursor, const char *key_prefix)
+{
+    return DBPrivSeekCursor(cursor->cursor, key_prefix, strlen(key_prefix));
+}
+
 bool DeleteDBCursor(DBCursor *cursor)
 {
     DBPrivCloseCursor(cursor->cursor);
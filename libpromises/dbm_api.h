@@ -52,6 +52,7 @@ typedef enum
     dbid_bundles,   // Deprecated
     dbid_packages_installed, //new package promise installed packages list
     dbid_packages_updates,   //new package promise list of available updates
+    dbid_function_cache,     //results of persistent_function_cache functions
 
     dbid_max
 } dbid;
@@ -90,6 +91,7 @@ bool NewDBCursor(CF_DB *dbp, CF_DBC **dbcp);
 bool NextDB(CF_DBC *dbcp, char **key, int *ksize, void **value, int *vsize);
 bool DBCursorDeleteEntry(CF_DBC *cursor);
 bool DBCursorWriteEntry(CF_DBC *cursor, const void *value, int value_size);
+bool DBCursorSeek(CF_DBC *cursor, const char *key_prefix);
 bool DeleteDBCursor(CF_DBC *dbcp);
 
 char *DBIdToPath(dbid id);
@@ -66,6 +66,7 @@ struct DBCursorPriv_
     MDB_val delkey;
     void *curkv;
     bool pending_delete;
+    MDB_val seekkey;                 /* set by DBPrivSeekCursor() until used */
 };
 
 static int DB_MAX_READERS = -1;
@@ -548,7 +549,23 @@ bool DBPrivAdvanceCursor(DBCursorPriv *cursor, void **key, int *key_size,
         free(cursor->curkv);
         cursor->curkv = NULL;
     }
-    if ((rc = mdb_cursor_get(cursor->mc, &mkey, &data, MDB_NEXT)) == MDB_SUCCESS)
+
+    MDB_cursor_op op = MDB_NEXT;
+    if (cursor->seekkey.mv_data != NULL)
+    {
+        mkey = cursor->seekkey;
+        op = MDB_SET_RANGE;
+    }
+
+    rc = mdb_cursor_get(cursor->mc, &mkey, &data, op);
+
+    if (cursor->seekkey.mv_data != NULL)
+    {
+        free(cursor->seekkey.mv_data);
+        cursor->seekkey.mv_data = NULL;
+    }
+
+    if (rc == MDB_SUCCESS)
     {
         // Align second buffer to 64-bit boundary, to avoid alignment errors on
         // certain platforms.
@@ -628,6 +645,14 @@ bool DBPrivWriteCursorEntry(DBCursorPriv *cursor, const void *value, int value_s
     return rc == MDB_SUCCESS;
 }
 
+bool DBPrivSeekCursor(DBCursorPriv *cursor, const void *key, int key_size)
+{
+    free(cursor->seekkey.mv_data);
+    cursor->seekkey.mv_data = xmemdup(key, key_size);
+    cursor->seekkey.mv_size = key_size;
+    return true;
+}
+
 void DBPrivCloseCursor(DBCursorPriv *cursor)
 {
     DBTxn *txn;
@@ -640,6 +665,7 @@ void DBPrivCloseCursor(DBCursorPriv *cursor)
     {
         free(cursor->curkv);
     }
+    free(cursor->seekkey.mv_data);
 
     if (cursor->pending_delete)
     {
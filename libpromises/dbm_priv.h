@@ -72,6 +72,13 @@ bool DBPrivDeleteCursorEntry(DBCursorPriv *cursor);
 bool DBPrivWriteCursorEntry(DBCursorPriv *cursor, const void *value, int value_size);
 void DBPrivCloseCursor(DBCursorPriv *cursor);
 
+/*
+ * Position the cursor so that the next DBPrivAdvanceCursor() returns the first
+ * entry with a key greater than or equal to #key (compared bytewise). Should
+ * return false if the database doesn't keep its keys sorted.
+ */
+bool DBPrivSeekCursor(DBCursorPriv *cursor, const void *key, int key_size);
+
 /**
  * @brief Check a database file for consistency
  * @param dbpath Path to database file
@@ -360,6 +360,13 @@ bool DBPrivWriteCursorEntry(DBCursorPriv *cursor, const void *value, int value_s
     return DBPrivWrite(cursor->db, cursor->curkey, cursor->curkey_size, value, value_size);
 }
 
+bool DBPrivSeekCursor(ARG_UNUSED DBCursorPriv *cursor,
+                      ARG_UNUSED const void *key, ARG_UNUSED int key_size)
+{
+    /* Hash database, keys are not kept in order. */
+    return false;
+}
+
 void DBPrivCloseCursor(DBCursorPriv *cursor)
 {
     DBPriv *db = cursor->db;
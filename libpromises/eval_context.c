@@ -32,6 +32,7 @@
 #include <expand.h>                                    /* ExpandPrivateRval */
 #include <matching.h>
 #include <string_lib.h>
+#include <string_intern.h>
 #include <misc_lib.h>
 #include <file_lib.h>
 #include <assoc.h>
@@ -50,6 +51,8 @@
 #include <regex.h>
 #include <map.h>
 #include <conversion.h>                               /* DataTypeIsIterable */
+#include <profiler.h>
+#include <function_cache.h>
 
 
 static const char *STACK_FRAME_TYPE_STR[STACK_FRAME_TYPE_MAX] = {
@@ -97,6 +100,9 @@ static bool EvalContextHeapContainsHard(const EvalContext *ctx, const char *name
 static bool EvalContextClassPut(EvalContext *ctx, const char *ns, const char *name, bool is_soft, ContextScope scope, const char *tags);
 static const char *EvalContextCurrentNamespace(const EvalContext *ctx);
 static ClassRef IDRefQualify(const EvalContext *ctx, const char *id);
+static void BufferAppendStackPath(Buffer *path, const EvalContext *ctx);
+static void PromiseReadsAddVariable(const EvalContext *ctx, const VarRef *ref, const Variable *var);
+static void PromiseReadsAddClass(const EvalContext *ctx, const char *context, bool value);
 
 /**
  * Every agent has only one EvalContext from process start to finish.
@@ -120,6 +126,13 @@ struct EvalContext_
 
     Seq *stack;
 
+    /* Frames on the stack, and their paths, are allocated here and released
+     * when popped. Stack frames are pushed and popped for every promise
+     * iteration, so the memory is better reused than malloc()ed. */
+    Arena *stack_arena;
+    Buffer *stack_path;
+    Seq *spare_log_messages;        /* cleared RingBuffers of popped frames */
+
     ClassTable *global_classes;
     VariableTable *global_variables;
 
@@ -129,6 +142,10 @@ struct EvalContext_
     StringSet *dependency_handles;
     FuncCacheMap *function_cache;
 
+    /* Functions whose results are kept across runs, see function_cache.h */
+    StringSet *persistent_functions;
+    long persistent_function_ttl;
+
     uid_t uid;
     uid_t gid;
     pid_t pid;
@@ -145,8 +162,44 @@ struct EvalContext_
 
     /* List if all classes set during policy evaluation */
     StringSet *all_classes;
+
+    /* Class expressions already parsed by IsDefinedClass(), see
+     * ClassExpression. The generation changes whenever the set of defined
+     * classes might have changed. */
+    Map *class_expressions;
+    unsigned long class_generation;
+
+    /* PromiseReads being tracked, the innermost promise last. Every change
+     * of a variable's value gives it the next serial. */
+    Seq *promise_reads;
+    unsigned long variable_serial;
 };
 
+/**
+ * Parsed class expression, cached by its string in ctx->class_expressions.
+ *
+ * The value of the expression is kept too, valid as long as
+ * ctx->class_generation is still the same as #generation.
+ */
+typedef struct
+{
+    bool has_whitespace;           /* invalid, missing operator */
+    Expression *expr;              /* NULL if it doesn't parse */
+
+    unsigned long generation;      /* 0 if #value was never computed */
+    bool value;
+} ClassExpression;
+
+/* The cache is emptied when it grows this big, the policy probably generates
+ * class expressions from variables. */
+#define CLASS_EXPRESSIONS_MAX 10000
+
+/* Must be called on every change that could affect IsDefinedClass(). */
+static void EvalContextClassesChanged(EvalContext *ctx)
+{
+    ctx->class_generation++;
+}
+
 bool EvalContextGetSelectEndMatchEof(const EvalContext *ctx)
 {
     return ctx->select_end_match_eof;
@@ -411,6 +464,7 @@ static void EvalContextStackFrameAddSoft(EvalContext *ctx, const char *context,
     }
 
     ClassTablePut(frame.classes, frame.owner->ns, context, true, CONTEXT_SCOPE_BUNDLE, tags);
+    EvalContextClassesChanged(ctx);
 
     if (!BundleAborted(ctx))
     {
@@ -488,10 +542,37 @@ bool ClassCharIsWhitespace(char ch)
     return ch == ' ' || ch == '\t' || ch == '\n' || ch == '\r';
 }
 
-bool IsDefinedClass(const EvalContext *ctx, const char *context)
+static void ClassExpressionDestroy(void *p)
 {
-    ParseResult res;
+    ClassExpression *ce = p;
+    if (ce != NULL)
+    {
+        FreeExpression(ce->expr);
+        free(ce);
+    }
+}
 
+static ClassExpression *ClassExpressionParse(const char *context)
+{
+    ClassExpression *ce = xcalloc(1, sizeof(ClassExpression));
+
+    if (StringMatchFullWithPrecompiledRegex(context_expression_whitespace_rx, context))
+    {
+        ce->has_whitespace = true;
+        return ce;
+    }
+
+    Buffer *condensed = BufferNewFrom(context, strlen(context));
+    BufferRewrite(condensed, &ClassCharIsWhitespace, true);
+    ParseResult res = ParseExpression(BufferData(condensed), 0, BufferSize(condensed));
+    BufferDestroy(condensed);
+
+    ce->expr = res.result;
+    return ce;
+}
+
+bool IsDefinedClass(const EvalContext *ctx, const char *context)
+{
     if (!context)
     {
         return true;
@@ -508,33 +589,43 @@ bool IsDefinedClass(const EvalContext *ctx, const char *context)
         return false;
     }
 
-    if (StringMatchFullWithPrecompiledRegex(context_expression_whitespace_rx, context))
+    ClassExpression *ce = MapGet(ctx->class_expressions, context);
+    if (ce == NULL)
+    {
+        if (MapSize(ctx->class_expressions) >= CLASS_EXPRESSIONS_MAX)
+        {
+            MapClear(ctx->class_expressions);
+        }
+
+        ce = ClassExpressionParse(context);
+        MapInsert(ctx->class_expressions, xstrdup(context), ce);
+    }
+
+    if (ce->has_whitespace)
     {
         Log(LOG_LEVEL_INFO, "class names can't be separated by whitespace without an intervening operator in expression '%s'", context);
         return false;
     }
 
-    Buffer *condensed = BufferNewFrom(context, strlen(context));
-    BufferRewrite(condensed, &ClassCharIsWhitespace, true);
-    res = ParseExpression(BufferData(condensed), 0, BufferSize(condensed));
-    BufferDestroy(condensed);
-
-    if (!res.result)
+    if (!ce->expr)
     {
         Log(LOG_LEVEL_ERR, "Unable to parse class expression '%s'", context);
         return false;
     }
-    else
+
+    if (ce->generation != ctx->class_generation)
     {
-        ExpressionValue r = EvalExpression(res.result,
+        ExpressionValue r = EvalExpression(ce->expr,
                                            &EvalTokenAsClass, &EvalVarRef,
                                            (void *)ctx); // controlled cast. None of these should modify EvalContext
 
-        FreeExpression(res.result);
-
         /* r is EvalResult which could be ERROR */
-        return r == EXPRESSION_VALUE_TRUE;
+        ce->value = (r == EXPRESSION_VALUE_TRUE);
+        ce->generation = ctx->class_generation;
     }
+
+    PromiseReadsAddClass(ctx, context, ce->value);
+    return ce->value;
 }
 
 /**********************************************************************/
@@ -875,8 +966,7 @@ static void StackFrameDestroy(StackFrame *frame)
             ProgrammingError("Unhandled stack frame type");
         }
 
-        free(frame->path);
-        free(frame);
+        /* The frame itself and its path are in ctx->stack_arena. */
     }
 }
 
@@ -938,6 +1028,9 @@ EvalContext *EvalContextNew(void)
 
     ctx->eval_options = EVAL_OPTION_FULL;
     ctx->stack = SeqNew(10, StackFrameDestroy);
+    ctx->stack_arena = ArenaNew(4096);
+    ctx->stack_path = BufferNew();
+    ctx->spare_log_messages = SeqNew(10, RingBufferDestroy);
     ctx->global_classes = ClassTableNew();
     ctx->global_variables = VariableTableNew();
     ctx->match_variables = VariableTableNew();
@@ -953,6 +1046,8 @@ EvalContext *EvalContextNew(void)
 
     ctx->promise_lock_cache = StringSetNew();
     ctx->function_cache = FuncCacheMapNew();
+    ctx->persistent_functions = StringSetNew();
+    ctx->persistent_function_ttl = FUNCTION_CACHE_DEFAULT_TTL;
 
     EvalContextSetupMissionPortalLogHook(ctx);
 
@@ -961,6 +1056,13 @@ EvalContext *EvalContextNew(void)
     ctx->all_classes = NULL;
     ctx->select_end_match_eof = false;
 
+    ctx->class_expressions = MapNew(StringHash_untyped, StringSafeEqual_untyped,
+                                    free, ClassExpressionDestroy);
+    ctx->class_generation = 1;
+
+    ctx->promise_reads = SeqNew(4, NULL);
+    ctx->variable_serial = 0;
+
     return ctx;
 }
 
@@ -984,6 +1086,9 @@ void EvalContextDestroy(EvalContext *ctx)
         RlistDestroy(ctx->args);
 
         SeqDestroy(ctx->stack);
+        ArenaDestroy(ctx->stack_arena);
+        BufferDestroy(ctx->stack_path);
+        SeqDestroy(ctx->spare_log_messages);
 
         ClassTableDestroy(ctx->global_classes);
         VariableTableDestroy(ctx->global_variables);
@@ -993,10 +1098,13 @@ void EvalContextDestroy(EvalContext *ctx)
         StringSetDestroy(ctx->promise_lock_cache);
 
         FuncCacheMapDestroy(ctx->function_cache);
+        StringSetDestroy(ctx->persistent_functions);
 
         FreePackagePromiseContext(ctx->package_promise_context);
 
         StringSetDestroy(ctx->all_classes);
+        MapDestroy(ctx->class_expressions);
+        SeqDestroy(ctx->promise_reads);
 
         free(ctx);
     }
@@ -1044,22 +1152,84 @@ static bool EvalContextStackFrameContainsSoft(const EvalContext *ctx, const char
 
 bool EvalContextHeapRemoveSoft(EvalContext *ctx, const char *ns, const char *name)
 {
+    EvalContextClassesChanged(ctx);
     return ClassTableRemove(ctx->global_classes, ns, name);
 }
 
 bool EvalContextHeapRemoveHard(EvalContext *ctx, const char *name)
 {
+    EvalContextClassesChanged(ctx);
     return ClassTableRemove(ctx->global_classes, NULL, name);
 }
 
 void EvalContextClear(EvalContext *ctx)
 {
     ClassTableClear(ctx->global_classes);
+    EvalContextClassesChanged(ctx);
     EvalContextDeleteIpAddresses(ctx);
     VariableTableClear(ctx->global_variables, NULL, NULL, NULL);
     VariableTableClear(ctx->match_variables, NULL, NULL, NULL);
     StringSetClear(ctx->promise_lock_cache);
     SeqClear(ctx->stack);
+    ArenaReset(ctx->stack_arena);
+    FuncCacheMapClear(ctx->function_cache);
+}
+
+/**
+ * Forget the classes and variables defined by promises, keeping the ones
+ * discovered by the agent or coming from augments. Used to discard what a
+ * policy rejected by validation has defined while being loaded.
+ */
+void EvalContextClearPromiseDefinitions(EvalContext *ctx)
+{
+    assert(SeqLength(ctx->stack) == 0);
+
+    StringSet *classes = StringSetNew();
+    {
+        ClassTableIterator *iter = ClassTableIteratorNew(ctx->global_classes, NULL, false, true);
+        Class *cls = NULL;
+        while ((cls = ClassTableIteratorNext(iter)))
+        {
+            if (StringSetContains(cls->tags, "source=promise"))
+            {
+                StringSetAdd(classes, ClassRefToString(cls->ns, cls->name));
+            }
+        }
+        ClassTableIteratorDestroy(iter);
+    }
+
+    StringSetIterator it = StringSetIteratorInit(classes);
+    const char *class_expr = NULL;
+    while ((class_expr = StringSetIteratorNext(&it)))
+    {
+        ClassRef ref = ClassRefParse(class_expr);
+        ClassTableRemove(ctx->global_classes, ref.ns, ref.name);
+        ClassRefDestroy(ref);
+    }
+    StringSetDestroy(classes);
+    EvalContextClassesChanged(ctx);
+
+    Seq *refs = SeqNew(100, VarRefDestroy_untyped);
+    {
+        VariableTableIterator *iter = VariableTableIteratorNew(ctx->global_variables, NULL, NULL, NULL);
+        Variable *var = NULL;
+        while ((var = VariableTableIteratorNext(iter)))
+        {
+            if (StringSetContains(var->tags, "source=promise"))
+            {
+                SeqAppend(refs, VarRefCopy(var->ref));
+            }
+        }
+        VariableTableIteratorDestroy(iter);
+    }
+
+    for (size_t i = 0; i < SeqLength(refs); i++)
+    {
+        VariableTableRemove(ctx->global_variables, SeqAt(refs, i));
+    }
+    SeqDestroy(refs);
+
+    /* Results may depend on what was removed. */
     FuncCacheMapClear(ctx->function_cache);
 }
 
@@ -1174,20 +1344,23 @@ int EvalContextGetPass(EvalContext *ctx)
     return ctx->pass;
 }
 
-static StackFrame *StackFrameNew(StackFrameType type, bool inherit_previous)
+static StackFrame *StackFrameNew(EvalContext *ctx,
+                                 StackFrameType type, bool inherit_previous)
 {
-    StackFrame *frame = xmalloc(sizeof(StackFrame));
+    ArenaMark mark = ArenaGetMark(ctx->stack_arena);
+    StackFrame *frame = ArenaAlloc(ctx->stack_arena, sizeof(StackFrame));
 
     frame->type = type;
     frame->inherits_previous = inherit_previous;
     frame->path = NULL;
+    frame->arena_mark = mark;
 
     return frame;
 }
 
-static StackFrame *StackFrameNewBundle(const Bundle *owner, bool inherit_previous)
+static StackFrame *StackFrameNewBundle(EvalContext *ctx, const Bundle *owner, bool inherit_previous)
 {
-    StackFrame *frame = StackFrameNew(STACK_FRAME_TYPE_BUNDLE, inherit_previous);
+    StackFrame *frame = StackFrameNew(ctx, STACK_FRAME_TYPE_BUNDLE, inherit_previous);
 
     frame->data.bundle.owner = owner;
     frame->data.bundle.classes = ClassTableNew();
@@ -1196,9 +1369,9 @@ static StackFrame *StackFrameNewBundle(const Bundle *owner, bool inherit_previou
     return frame;
 }
 
-static StackFrame *StackFrameNewBody(const Body *owner)
+static StackFrame *StackFrameNewBody(EvalContext *ctx, const Body *owner)
 {
-    StackFrame *frame = StackFrameNew(STACK_FRAME_TYPE_BODY, false);
+    StackFrame *frame = StackFrameNew(ctx, STACK_FRAME_TYPE_BODY, false);
 
     frame->data.body.owner = owner;
     frame->data.body.vars = VariableTableNew();
@@ -1206,31 +1379,42 @@ static StackFrame *StackFrameNewBody(const Body *owner)
     return frame;
 }
 
-static StackFrame *StackFrameNewPromiseType(const PromiseType *owner)
+static StackFrame *StackFrameNewPromiseType(EvalContext *ctx, const PromiseType *owner)
 {
-    StackFrame *frame = StackFrameNew(STACK_FRAME_TYPE_PROMISE_TYPE, true);
+    StackFrame *frame = StackFrameNew(ctx, STACK_FRAME_TYPE_PROMISE_TYPE, true);
 
     frame->data.promise_type.owner = owner;
 
     return frame;
 }
 
-static StackFrame *StackFrameNewPromise(const Promise *owner)
+static StackFrame *StackFrameNewPromise(EvalContext *ctx, const Promise *owner)
 {
-    StackFrame *frame = StackFrameNew(STACK_FRAME_TYPE_PROMISE, true);
+    StackFrame *frame = StackFrameNew(ctx, STACK_FRAME_TYPE_PROMISE, true);
 
     frame->data.promise.owner = owner;
 
     return frame;
 }
 
-static StackFrame *StackFrameNewPromiseIteration(Promise *owner, const PromiseIterator *iter_ctx)
+static StackFrame *StackFrameNewPromiseIteration(EvalContext *ctx, Promise *owner, const PromiseIterator *iter_ctx)
 {
-    StackFrame *frame = StackFrameNew(STACK_FRAME_TYPE_PROMISE_ITERATION, true);
+    StackFrame *frame = StackFrameNew(ctx, STACK_FRAME_TYPE_PROMISE_ITERATION, true);
 
     frame->data.promise_iteration.owner = owner;
     frame->data.promise_iteration.iter_ctx = iter_ctx;
-    frame->data.promise_iteration.log_messages = RingBufferNew(5, NULL, free);
+
+    size_t spare = SeqLength(ctx->spare_log_messages);
+    if (spare > 0)
+    {
+        frame->data.promise_iteration.log_messages =
+            SeqAt(ctx->spare_log_messages, spare - 1);
+        SeqSoftRemove(ctx->spare_log_messages, spare - 1);
+    }
+    else
+    {
+        frame->data.promise_iteration.log_messages = RingBufferNew(5, NULL, free);
+    }
 
     return frame;
 }
@@ -1241,6 +1425,16 @@ void EvalContextStackFrameRemoveSoft(EvalContext *ctx, const char *context)
     assert(frame);
 
     ClassTableRemove(frame->data.bundle.classes, frame->data.bundle.owner->ns, context);
+    EvalContextClassesChanged(ctx);
+}
+
+/* Whether pushing or popping #frame changes the classes in scope, or the
+ * namespace class names are qualified with. */
+static bool StackFrameChangesClasses(const StackFrame *frame)
+{
+    return (frame->type == STACK_FRAME_TYPE_BUNDLE ||
+            frame->type == STACK_FRAME_TYPE_BODY ||
+            !frame->inherits_previous);
 }
 
 static void EvalContextStackPushFrame(EvalContext *ctx, StackFrame *frame)
@@ -1255,9 +1449,34 @@ static void EvalContextStackPushFrame(EvalContext *ctx, StackFrame *frame)
     }
 
     SeqAppend(ctx->stack, frame);
+    if (StackFrameChangesClasses(frame))
+    {
+        EvalContextClassesChanged(ctx);
+    }
 
     assert(!frame->path);
-    frame->path = EvalContextStackPath(ctx);
+    BufferClear(ctx->stack_path);
+    BufferAppendStackPath(ctx->stack_path, ctx);
+    frame->path = ArenaStringDuplicate(ctx->stack_arena,
+                                       BufferData(ctx->stack_path));
+
+    switch (frame->type)
+    {
+    case STACK_FRAME_TYPE_BUNDLE:
+        ProfilerEnterBundle(frame->data.bundle.owner);
+        break;
+    case STACK_FRAME_TYPE_PROMISE_TYPE:
+        ProfilerEnterPromiseType(frame->data.promise_type.owner);
+        break;
+    case STACK_FRAME_TYPE_PROMISE:
+        ProfilerEnterPromise(frame->data.promise.owner);
+        break;
+    case STACK_FRAME_TYPE_PROMISE_ITERATION:
+        ProfilerPromiseIteration();
+        break;
+    default:
+        break;
+    }
 
     LogDebug(LOG_MOD_EVALCTX, "PUSHED FRAME (type %s)",
              STACK_FRAME_TYPE_STR[frame->type]);
@@ -1267,7 +1486,7 @@ void EvalContextStackPushBundleFrame(EvalContext *ctx, const Bundle *owner, cons
 {
     assert(!LastStackFrame(ctx, 0) || LastStackFrame(ctx, 0)->type == STACK_FRAME_TYPE_PROMISE_ITERATION);
 
-    EvalContextStackPushFrame(ctx, StackFrameNewBundle(owner, inherits_previous));
+    EvalContextStackPushFrame(ctx, StackFrameNewBundle(ctx, owner, inherits_previous));
 
     if (RlistLen(args) > 0)
     {
@@ -1309,7 +1528,7 @@ void EvalContextStackPushBodyFrame(EvalContext *ctx, const Promise *caller, cons
 #endif
 
 
-    EvalContextStackPushFrame(ctx, StackFrameNewBody(body));
+    EvalContextStackPushFrame(ctx, StackFrameNewBody(ctx, body));
 
     if (RlistLen(body->args) != RlistLen(args))
     {
@@ -1335,7 +1554,7 @@ void EvalContextStackPushPromiseTypeFrame(EvalContext *ctx, const PromiseType *o
 {
     assert(LastStackFrame(ctx, 0) && LastStackFrame(ctx, 0)->type == STACK_FRAME_TYPE_BUNDLE);
 
-    StackFrame *frame = StackFrameNewPromiseType(owner);
+    StackFrame *frame = StackFrameNewPromiseType(ctx, owner);
     EvalContextStackPushFrame(ctx, frame);
 }
 
@@ -1346,7 +1565,7 @@ void EvalContextStackPushPromiseFrame(EvalContext *ctx, const Promise *owner)
 
     EvalContextVariableClearMatch(ctx);
 
-    StackFrame *frame = StackFrameNewPromise(owner);
+    StackFrame *frame = StackFrameNewPromise(ctx, owner);
 
     EvalContextStackPushFrame(ctx, frame);
 
@@ -1419,15 +1638,16 @@ Promise *EvalContextStackPushPromiseIterationFrame(EvalContext *ctx, const Promi
 
     /* Evaluate all constraints by calling functions etc. */
     bool excluded;
-    Promise *pexp = ExpandDeRefPromise(ctx, last_frame->data.promise.owner,
-                                       &excluded);
+    Promise *pexp = ExpandDeRefPromiseIteration(ctx,
+                                                last_frame->data.promise.owner,
+                                                iter_ctx, &excluded);
     if (excluded || !pexp)
     {
         PromiseDestroy(pexp);
         return NULL;
     }
 
-    EvalContextStackPushFrame(ctx, StackFrameNewPromiseIteration(pexp, iter_ctx));
+    EvalContextStackPushFrame(ctx, StackFrameNewPromiseIteration(ctx, pexp, iter_ctx));
 
     LoggingPrivSetLevels(CalculateLogLevel(pexp), CalculateReportLevel(pexp));
 
@@ -1451,17 +1671,36 @@ void EvalContextStackPopFrame(EvalContext *ctx)
                 VariableTableClear(last_frame->data.bundle.vars, "default", "edit", NULL);
             }
         }
+        ProfilerLeave();
+        break;
+
+    case STACK_FRAME_TYPE_PROMISE_TYPE:
+    case STACK_FRAME_TYPE_PROMISE:
+        ProfilerLeave();
         break;
 
     case STACK_FRAME_TYPE_PROMISE_ITERATION:
         LoggingPrivSetLevels(LogGetGlobalLevel(), LogGetGlobalLevel());
+
+        /* Keep the messages buffer for the next iteration frame. */
+        RingBufferClear(last_frame->data.promise_iteration.log_messages);
+        SeqAppend(ctx->spare_log_messages,
+                  last_frame->data.promise_iteration.log_messages);
+        last_frame->data.promise_iteration.log_messages = NULL;
         break;
 
     default:
         break;
     }
 
+    if (StackFrameChangesClasses(last_frame))
+    {
+        EvalContextClassesChanged(ctx);
+    }
+
+    ArenaMark mark = last_frame->arena_mark;
     SeqRemove(ctx->stack, SeqLength(ctx->stack) - 1);
+    ArenaRelease(ctx->stack_arena, mark);
 
     last_frame = LastStackFrame(ctx, 0);
     if (last_frame)
@@ -1490,6 +1729,7 @@ bool EvalContextClassRemove(EvalContext *ctx, const char *ns, const char *name)
         ClassTableRemove(frame->data.bundle.classes, ns, name);
     }
 
+    EvalContextClassesChanged(ctx);
     return ClassTableRemove(ctx->global_classes, ns, name);
 }
 
@@ -1601,6 +1841,7 @@ static bool EvalContextClassPut(EvalContext *ctx, const char *ns, const char *na
     case CONTEXT_SCOPE_NONE:
         ProgrammingError("Attempted to add a class without a set scope");
     }
+    EvalContextClassesChanged(ctx);
 
     if (!BundleAborted(ctx))
     {
@@ -1765,10 +2006,8 @@ static void BufferAppendAbbreviatedStr(Buffer *buf,
     }
 }
 
-char *EvalContextStackPath(const EvalContext *ctx)
+static void BufferAppendStackPath(Buffer *path, const EvalContext *ctx)
 {
-    Buffer *path = BufferNew();
-
     for (size_t i = 0; i < SeqLength(ctx->stack); i++)
     {
         StackFrame *frame = SeqAt(ctx->stack, i);
@@ -1812,7 +2051,12 @@ char *EvalContextStackPath(const EvalContext *ctx)
                 ProgrammingError("Unhandled stack frame type");
         }
     }
+}
 
+char *EvalContextStackPath(const EvalContext *ctx)
+{
+    Buffer *path = BufferNew();
+    BufferAppendStackPath(path, ctx);
     return BufferClose(path);
 }
 
@@ -1879,8 +2123,10 @@ bool EvalContextVariablePutSpecial(EvalContext *ctx, SpecialScope scope, const c
     else
     {
         // plain lval, skip parsing
-        const VarRef ref = VarRefConst(NULL, SpecialScopeToString(scope), lval);
-        return EvalContextVariablePut(ctx, &ref, value, type, tags);
+        VarRef ref = VarRefConst(NULL, SpecialScopeToString(scope), lval);
+        bool ret = EvalContextVariablePut(ctx, &ref, value, type, tags);
+        VarRefConstRelease(&ref);
+        return ret;
     }
 }
 
@@ -2049,6 +2295,56 @@ static void VarRefStackQualify(const EvalContext *ctx, VarRef *ref)
     }
 }
 
+static bool JsonCompactEqual(const JsonElement *a, const JsonElement *b)
+{
+    Writer *wa = StringWriter();
+    Writer *wb = StringWriter();
+    JsonWriteCompact(wa, a);
+    JsonWriteCompact(wb, b);
+
+    bool equal = (strcmp(StringWriterData(wa), StringWriterData(wb)) == 0);
+
+    WriterClose(wa);
+    WriterClose(wb);
+    return equal;
+}
+
+static bool VariableValueEqual(const Variable *var, const Rval *rval, DataType type)
+{
+    if (var->type != type || var->rval.type != rval->type)
+    {
+        return false;
+    }
+
+    switch (rval->type)
+    {
+    case RVAL_TYPE_SCALAR:
+        return strcmp(RvalScalarValue(var->rval), RvalScalarValue(*rval)) == 0;
+
+    case RVAL_TYPE_LIST:
+        {
+            const Rlist *rp1 = var->rval.item;
+            const Rlist *rp2 = rval->item;
+            for (; rp1 != NULL && rp2 != NULL; rp1 = rp1->next, rp2 = rp2->next)
+            {
+                if (rp1->val.type != RVAL_TYPE_SCALAR ||
+                    rp2->val.type != RVAL_TYPE_SCALAR ||
+                    strcmp(RlistScalarValue(rp1), RlistScalarValue(rp2)) != 0)
+                {
+                    return false;
+                }
+            }
+            return (rp1 == NULL && rp2 == NULL);
+        }
+
+    case RVAL_TYPE_CONTAINER:
+        return JsonCompactEqual(var->rval.item, rval->item);
+
+    default:
+        return false;
+    }
+}
+
 /*
  * Copies value, so you need to free your own copy afterwards.
  */
@@ -2083,8 +2379,15 @@ bool EvalContextVariablePut(EvalContext *ctx,
     Rval rval = (Rval) { (void *)value, DataTypeToRvalType(type) };
 
     VariableTable *table = GetVariableTableForScope(ctx, ref->ns, ref->scope);
+
+    /* Putting the same value again is not a change, see PromiseReads. */
+    const Variable *existing = VariableTableGet(table, ref);
+    unsigned long serial = (existing != NULL && VariableValueEqual(existing, &rval, type)) ?
+        existing->serial : ++ctx->variable_serial;
+
     const Promise *pp = EvalContextStackCurrentPromise(ctx);
     VariableTablePut(table, ref, &rval, type, tags, pp ? pp->org_pp : pp);
+    VariableTableGet(table, ref)->serial = serial;
     return true;
 }
 
@@ -2187,6 +2490,7 @@ static Variable *VariableResolve(const EvalContext *ctx, const VarRef *ref)
 const void *EvalContextVariableGet(const EvalContext *ctx, const VarRef *ref, DataType *type_out)
 {
     Variable *var = VariableResolve(ctx, ref);
+    PromiseReadsAddVariable(ctx, ref, var);
     if (var)
     {
         if (var->ref->num_indices == 0    &&
@@ -2306,9 +2610,10 @@ const Bundle *EvalContextResolveBundleExpression(const EvalContext *ctx, const P
     ClassRef ref = IDRefQualify(ctx, callee_reference);
 
     const Bundle *bp = NULL;
-    for (size_t i = 0; i < SeqLength(policy->bundles); i++)
+    const Seq *candidates = PolicyGetBundlesNamed(policy, ref.name);
+    for (size_t i = 0; candidates != NULL && i < SeqLength(candidates); i++)
     {
-        const Bundle *curr_bp = SeqAt(policy->bundles, i);
+        const Bundle *curr_bp = SeqAt(candidates, i);
         if ((strcmp(curr_bp->type, callee_type) != 0) ||
             (strcmp(curr_bp->name, ref.name) != 0) ||
             !StringSafeEqual(curr_bp->ns, ref.ns))
@@ -2327,9 +2632,10 @@ const Bundle *EvalContextResolveBundleExpression(const EvalContext *ctx, const P
 const Body *EvalContextFindFirstMatchingBody(const Policy *policy, const char *type,
                                              const char *namespace, const char *name)
 {
-    for (size_t i = 0; i < SeqLength(policy->bodies); i++)
+    const Seq *candidates = PolicyGetBodiesNamed(policy, name);
+    for (size_t i = 0; candidates != NULL && i < SeqLength(candidates); i++)
     {
-        const Body *curr_bp = SeqAt(policy->bodies, i);
+        const Body *curr_bp = SeqAt(candidates, i);
         if ((strcmp(curr_bp->type, type) == 0) &&
             (strcmp(curr_bp->name, name) == 0) &&
             StringSafeEqual(curr_bp->ns, namespace))
@@ -2408,6 +2714,46 @@ Seq *EvalContextResolveBodyExpression(const EvalContext *ctx, const Policy *poli
     return bodies;
 }
 
+/**
+ * Like EvalContextResolveBodyExpression() for the body #cp refers to by
+ * #callee_reference, but memoized in #cp: the result only depends on the
+ * namespace the reference is resolved in, which is the same every time the
+ * promise is evaluated.
+ *
+ * @return The bodies and args, reversed (furthest parent first). Owned by
+ *         #cp, do not modify or free.
+ */
+const Seq *EvalContextResolveConstraintBody(const EvalContext *ctx, const Policy *policy,
+                                            const Constraint *cp,
+                                            const char *callee_reference)
+{
+    const char *ns = StringIntern(EvalContextCurrentNamespace(ctx));
+    if (cp->resolved_bodies != NULL && cp->resolved_bodies_ns == ns)
+    {
+        StringInternRelease(ns);
+        return cp->resolved_bodies;
+    }
+
+    Seq *bodies = EvalContextResolveBodyExpression(ctx, policy,
+                                                   callee_reference, cp->lval);
+    if (bodies != NULL)
+    {
+        SeqReverse(bodies);
+
+        Constraint *memo = (Constraint *) cp;
+        SeqDestroy(memo->resolved_bodies);
+        StringInternRelease(memo->resolved_bodies_ns);
+        memo->resolved_bodies = bodies;
+        memo->resolved_bodies_ns = ns;                 /* keeps the reference */
+    }
+    else
+    {
+        StringInternRelease(ns);
+    }
+
+    return bodies;
+}
+
 bool EvalContextPromiseLockCacheContains(const EvalContext *ctx, const char *key)
 {
     return StringSetContains(ctx->promise_lock_cache, key);
@@ -2461,6 +2807,372 @@ void EvalContextFunctionCachePut(EvalContext *ctx,
     FuncCacheMapInsert(ctx->function_cache, RlistCopy(args), rval_copy);
 }
 
+void EvalContextSetPersistentFunctions(EvalContext *ctx, const Rlist *functions)
+{
+    StringSetClear(ctx->persistent_functions);
+
+    for (const Rlist *rp = functions; rp != NULL; rp = rp->next)
+    {
+        const char *name = RlistScalarValue(rp);
+        if (FunctionCacheSupported(name))
+        {
+            StringSetAdd(ctx->persistent_functions, xstrdup(name));
+        }
+        else
+        {
+            Log(LOG_LEVEL_WARNING,
+                "Results of function '%s' can not be cached across runs, ignoring it",
+                name);
+        }
+    }
+}
+
+bool EvalContextFunctionIsPersistent(const EvalContext *ctx, const char *function)
+{
+    return StringSetContains(ctx->persistent_functions, function);
+}
+
+void EvalContextSetPersistentFunctionTTL(EvalContext *ctx, long ttl)
+{
+    ctx->persistent_function_ttl = ttl;
+}
+
+long EvalContextGetPersistentFunctionTTL(const EvalContext *ctx)
+{
+    return ctx->persistent_function_ttl;
+}
+
+/**
+ * Variables and classes read while evaluating a promise. Evaluating the
+ * promise again can be skipped as long as none of them changed, see
+ * EvalContextPromiseReadsChanged().
+ *
+ * Variables are compared by their serial, so we don't need to keep a copy of
+ * their values. Class expressions are compared by their value, which is cheap
+ * since IsDefinedClass() caches it.
+ */
+struct PromiseReads_
+{
+    Map *variables;                /* Variable * -> VariableRead * */
+    Map *missing_variables;        /* qualified name -> VarRef *, not found */
+    StringSet *defined_classes;    /* class expressions that were true */
+    StringSet *undefined_classes;  /* ... and false */
+    unsigned long class_generation;
+    bool external;                 /* read something we can't track */
+};
+
+typedef struct
+{
+    VarRef *ref;
+    unsigned long serial;
+} VariableRead;
+
+static void VariableReadDestroy(void *p)
+{
+    VariableRead *read = p;
+    VarRefDestroy(read->ref);
+    free(read);
+}
+
+PromiseReads *PromiseReadsNew(void)
+{
+    PromiseReads *reads = xcalloc(1, sizeof(PromiseReads));
+    reads->variables = MapNew(NULL, NULL, NULL, VariableReadDestroy);
+    reads->missing_variables = MapNew(StringHash_untyped, StringSafeEqual_untyped,
+                                      free, VarRefDestroy_untyped);
+    reads->defined_classes = StringSetNew();
+    reads->undefined_classes = StringSetNew();
+    return reads;
+}
+
+void PromiseReadsDestroy(PromiseReads *reads)
+{
+    if (reads != NULL)
+    {
+        MapDestroy(reads->variables);
+        MapDestroy(reads->missing_variables);
+        StringSetDestroy(reads->defined_classes);
+        StringSetDestroy(reads->undefined_classes);
+        free(reads);
+    }
+}
+
+void PromiseReadsDestroy_untyped(void *reads)
+{
+    PromiseReadsDestroy(reads);
+}
+
+/**
+ * Start recording into #reads (forgetting what it recorded before) whatever
+ * the promise about to be evaluated reads, until EvalContextPopPromiseReads().
+ * Nested promises, e.g. in bundles called by methods, can push their own.
+ */
+void EvalContextPushPromiseReads(EvalContext *ctx, PromiseReads *reads)
+{
+    MapClear(reads->variables);
+    MapClear(reads->missing_variables);
+    StringSetClear(reads->defined_classes);
+    StringSetClear(reads->undefined_classes);
+    reads->class_generation = ctx->class_generation;
+    reads->external = false;
+
+    SeqAppend(ctx->promise_reads, reads);
+}
+
+static PromiseReads *CurrentPromiseReads(const EvalContext *ctx)
+{
+    size_t length = SeqLength(ctx->promise_reads);
+    return (length > 0) ? SeqAt(ctx->promise_reads, length - 1) : NULL;
+}
+
+/* What a nested promise read, e.g. in a bundle called by methods, was read
+ * by the enclosing promise too. */
+static void PromiseReadsMerge(PromiseReads *to, const PromiseReads *from)
+{
+    if (to->external)
+    {
+        return;
+    }
+    if (from->external)
+    {
+        to->external = true;
+        return;
+    }
+
+    MapIterator it = MapIteratorInit(from->variables);
+    MapKeyValue *item;
+    while ((item = MapIteratorNext(&it)))
+    {
+        const VariableRead *read = item->value;
+        const VariableRead *existing = MapGet(to->variables, item->key);
+        if (existing == NULL)
+        {
+            VariableRead *copy = xmalloc(sizeof(VariableRead));
+            copy->ref = VarRefCopy(read->ref);
+            copy->serial = read->serial;
+            MapInsert(to->variables, item->key, copy);
+        }
+        else if (existing->serial != read->serial)
+        {
+            to->external = true;
+            return;
+        }
+    }
+
+    it = MapIteratorInit(from->missing_variables);
+    while ((item = MapIteratorNext(&it)))
+    {
+        if (!MapHasKey(to->missing_variables, item->key))
+        {
+            MapInsert(to->missing_variables, xstrdup(item->key),
+                      VarRefCopy(item->value));
+        }
+    }
+
+    StringSetIterator sit = StringSetIteratorInit(from->defined_classes);
+    const char *context;
+    while ((context = StringSetIteratorNext(&sit)))
+    {
+        if (!StringSetContains(to->defined_classes, context))
+        {
+            StringSetAdd(to->defined_classes, xstrdup(context));
+        }
+    }
+
+    sit = StringSetIteratorInit(from->undefined_classes);
+    while ((context = StringSetIteratorNext(&sit)))
+    {
+        if (!StringSetContains(to->undefined_classes, context))
+        {
+            StringSetAdd(to->undefined_classes, xstrdup(context));
+        }
+    }
+}
+
+void EvalContextPopPromiseReads(EvalContext *ctx)
+{
+    assert(SeqLength(ctx->promise_reads) > 0);
+    PromiseReads *reads = CurrentPromiseReads(ctx);
+    SeqRemove(ctx->promise_reads, SeqLength(ctx->promise_reads) - 1);
+
+    PromiseReads *enclosing = CurrentPromiseReads(ctx);
+    if (enclosing != NULL)
+    {
+        PromiseReadsMerge(enclosing, reads);
+    }
+}
+
+/**
+ * The promise being evaluated depends on something that isn't a variable or
+ * a class, e.g. a function result or the files matching a promiser regex, so
+ * it always needs to be evaluated again.
+ */
+void EvalContextPromiseReadsExternalState(EvalContext *ctx)
+{
+    PromiseReads *reads = CurrentPromiseReads(ctx);
+    if (reads != NULL)
+    {
+        reads->external = true;
+    }
+}
+
+static void PromiseReadsAddVariable(const EvalContext *ctx, const VarRef *ref, const Variable *var)
+{
+    PromiseReads *reads = CurrentPromiseReads(ctx);
+    if (reads == NULL || reads->external)
+    {
+        return;
+    }
+
+    if (var != NULL)
+    {
+        switch (SpecialScopeFromString(var->ref->scope))
+        {
+        case SPECIAL_SCOPE_THIS:
+        case SPECIAL_SCOPE_BODY:
+        case SPECIAL_SCOPE_EDIT:
+            /* Derived from the promise itself. */
+            return;
+        case SPECIAL_SCOPE_MATCH:
+            reads->external = true;
+            return;
+        default:
+            break;
+        }
+
+        VariableRead *read = MapGet(reads->variables, var);
+        if (read == NULL)
+        {
+            read = xmalloc(sizeof(VariableRead));
+            read->ref = VarRefCopy(var->ref);
+            read->serial = var->serial;
+            MapInsert(reads->variables, (void *) var, read);
+        }
+        else if (read->serial != var->serial)
+        {
+            /* Changed while the promise was evaluated. */
+            reads->external = true;
+        }
+        return;
+    }
+
+    /* Not found: remember where VariableResolve() would look for it last. */
+    VarRef *qualified = VarRefCopy(ref);
+    if (!VarRefIsQualified(qualified))
+    {
+        VarRefStackQualify(ctx, qualified);
+    }
+
+    switch (SpecialScopeFromString(qualified->scope))
+    {
+    case SPECIAL_SCOPE_EDIT:
+        VarRefDestroy(qualified);
+        return;
+    case SPECIAL_SCOPE_MATCH:
+        reads->external = true;
+        VarRefDestroy(qualified);
+        return;
+    case SPECIAL_SCOPE_THIS:
+    case SPECIAL_SCOPE_BODY:
+        {
+            const Bundle *bp = EvalContextStackCurrentBundle(ctx);
+            if (bp == NULL)
+            {
+                reads->external = true;
+                VarRefDestroy(qualified);
+                return;
+            }
+            VarRefQualify(qualified, bp->ns, bp->name);
+        }
+        break;
+    default:
+        break;
+    }
+
+    char *name = VarRefToString(qualified, true);
+    if (MapHasKey(reads->missing_variables, name))
+    {
+        free(name);
+        VarRefDestroy(qualified);
+    }
+    else
+    {
+        MapInsert(reads->missing_variables, name, qualified);
+    }
+}
+
+static void PromiseReadsAddClass(const EvalContext *ctx, const char *context, bool value)
+{
+    PromiseReads *reads = CurrentPromiseReads(ctx);
+    if (reads == NULL || reads->external)
+    {
+        return;
+    }
+
+    StringSet *set = value ? reads->defined_classes : reads->undefined_classes;
+    if (!StringSetContains(set, context))
+    {
+        StringSetAdd(set, xstrdup(context));
+    }
+}
+
+/**
+ * @return true if anything recorded in #reads changed since, i.e. evaluating
+ *         the promise again could give a different result
+ */
+bool EvalContextPromiseReadsChanged(const EvalContext *ctx, const PromiseReads *reads)
+{
+    if (reads->external)
+    {
+        return true;
+    }
+
+    MapIterator it = MapIteratorInit(reads->variables);
+    MapKeyValue *item;
+    while ((item = MapIteratorNext(&it)))
+    {
+        const VariableRead *read = item->value;
+        const Variable *var = VariableResolve2(ctx, read->ref);
+        if (var == NULL || var->serial != read->serial)
+        {
+            return true;
+        }
+    }
+
+    it = MapIteratorInit(reads->missing_variables);
+    while ((item = MapIteratorNext(&it)))
+    {
+        if (VariableResolve2(ctx, item->value) != NULL)
+        {
+            return true;
+        }
+    }
+
+    if (reads->class_generation != ctx->class_generation)
+    {
+        StringSetIterator sit = StringSetIteratorInit(reads->defined_classes);
+        const char *context;
+        while ((context = StringSetIteratorNext(&sit)))
+        {
+            if (!IsDefinedClass(ctx, context))
+            {
+                return true;
+            }
+        }
+
+        sit = StringSetIteratorInit(reads->undefined_classes);
+        while ((context = StringSetIteratorNext(&sit)))
+        {
+            if (IsDefinedClass(ctx, context))
+            {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
 /* cfPS and associated machinery */
 
 
@@ -2735,7 +3447,7 @@ void NotifyDependantPromises(EvalContext *ctx, const Promise *pp, PromiseResult
     }
 }
 
-void ClassAuditLog(EvalContext *ctx, const Promise *pp, Attributes attr, PromiseResult status)
+void ClassAuditLog(EvalContext *ctx, const Promise *pp, const Attributes *attr, PromiseResult status)
 {
     if (IsPromiseValuableForStatus(pp))
     {
@@ -2743,8 +3455,8 @@ void ClassAuditLog(EvalContext *ctx, const Promise *pp, Attributes attr, Promise
         UpdatePromiseCounters(status);
     }
 
-    SetPromiseOutcomeClasses(ctx, status, attr.classes);
-    DoSummarizeTransaction(ctx, status, pp, attr.transaction);
+    SetPromiseOutcomeClasses(ctx, status, attr->classes);
+    DoSummarizeTransaction(ctx, status, pp, attr->transaction);
 }
 
 static void LogPromiseContext(const EvalContext *ctx, const Promise *pp)
@@ -2792,7 +3504,7 @@ static void LogPromiseContext(const EvalContext *ctx, const Promise *pp)
     WriterClose(w);
 }
 
-void cfPS(EvalContext *ctx, LogLevel level, PromiseResult status, const Promise *pp, Attributes attr, const char *fmt, ...)
+void cfPS(EvalContext *ctx, LogLevel level, PromiseResult status, const Promise *pp, const Attributes *attr, const char *fmt, ...)
 {
     /*
      * This stub implementation of cfPS delegates to the new logging backend.
@@ -2895,7 +3607,7 @@ StringSet *ClassesMatching(const EvalContext *ctx, ClassTableIterator *iter, con
 {
     StringSet *matching = StringSetNew();
 
-    pcre *rx = CompileRegex(regex);
+    CachedRegex *rx = CachedRegexAcquire(regex);
 
     Class *cls;
     while ((cls = ClassTableIteratorNext(iter)))
@@ -2904,7 +3616,7 @@ StringSet *ClassesMatching(const EvalContext *ctx, ClassTableIterator *iter, con
 
         /* FIXME: review this strcmp. Moved out from StringMatch */
         if (!strcmp(regex, expr) ||
-            (rx && StringMatchFullWithPrecompiledRegex(rx, expr)))
+            (rx && StringMatchFullWithCachedRegex(rx, expr)))
         {
             bool pass = false;
             StringSet *tagset = EvalContextClassTags(ctx, cls->ns, cls->name);
@@ -2953,10 +3665,7 @@ StringSet *ClassesMatching(const EvalContext *ctx, ClassTableIterator *iter, con
         }
     }
 
-    if (rx)
-    {
-        pcre_free(rx);
-    }
+    CachedRegexRelease(rx);
 
     return matching;
 }
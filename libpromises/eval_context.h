@@ -37,6 +37,7 @@
 #include <iteration.h>
 #include <rb-tree.h>
 #include <ring_buffer.h>
+#include <arena.h>
 
 typedef enum
 {
@@ -98,6 +99,7 @@ typedef struct
     } data;
 
     char *path;
+    ArenaMark arena_mark;  // stack arena state before the frame was pushed
 } StackFrame;
 
 typedef enum
@@ -135,6 +137,7 @@ const StringSet *EvalContextAllClassesGet(const EvalContext *ctx);
 void EvalContextAllClassesLoggingEnable(EvalContext *ctx, bool enable);
 
 void EvalContextClear(EvalContext *ctx);
+void EvalContextClearPromiseDefinitions(EvalContext *ctx);
 
 Rlist *EvalContextGetPromiseCallerMethods(EvalContext *ctx);
 
@@ -175,6 +178,21 @@ void EvalContextPromiseLockCachePut(EvalContext *ctx, const char *key);
 void EvalContextPromiseLockCacheRemove(EvalContext *ctx, const char *key);
 bool EvalContextFunctionCacheGet(const EvalContext *ctx, const FnCall *fp, const Rlist *args, Rval *rval_out);
 void EvalContextFunctionCachePut(EvalContext *ctx, const FnCall *fp, const Rlist *args, const Rval *rval);
+void EvalContextSetPersistentFunctions(EvalContext *ctx, const Rlist *functions);
+bool EvalContextFunctionIsPersistent(const EvalContext *ctx, const char *function);
+void EvalContextSetPersistentFunctionTTL(EvalContext *ctx, long ttl);
+long EvalContextGetPersistentFunctionTTL(const EvalContext *ctx);
+
+/* - Skipping promises whose inputs didn't change - */
+typedef struct PromiseReads_ PromiseReads;
+
+PromiseReads *PromiseReadsNew(void);
+void PromiseReadsDestroy(PromiseReads *reads);
+void PromiseReadsDestroy_untyped(void *reads);
+void EvalContextPushPromiseReads(EvalContext *ctx, PromiseReads *reads);
+void EvalContextPopPromiseReads(EvalContext *ctx);
+void EvalContextPromiseReadsExternalState(EvalContext *ctx);
+bool EvalContextPromiseReadsChanged(const EvalContext *ctx, const PromiseReads *reads);
 
 const void  *EvalContextVariableControlCommonGet(const EvalContext *ctx, CommonControl lval);
 
@@ -197,6 +215,9 @@ const Body *EvalContextFindFirstMatchingBody(const Policy *policy, const char *t
   */
 Seq *EvalContextResolveBodyExpression(const EvalContext *ctx, const Policy *policy,
                                       const char *callee_reference, const char *callee_type);
+const Seq *EvalContextResolveConstraintBody(const EvalContext *ctx, const Policy *policy,
+                                            const Constraint *cp,
+                                            const char *callee_reference);
 
 /* - Parsing/evaluating expressions - */
 void ValidateClassSyntax(const char *str);
@@ -227,7 +248,7 @@ void EvalContextSetLaunchDirectory(EvalContext *ctx, const char *path);
 bool Abort(EvalContext *ctx);
 void NotifyDependantPromises(EvalContext *ctx, const Promise *pp, PromiseResult result);
 bool MissingDependencies(EvalContext *ctx, const Promise *pp);
-void cfPS(EvalContext *ctx, LogLevel level, PromiseResult status, const Promise *pp, Attributes attr, const char *fmt, ...) FUNC_ATTR_PRINTF(6, 7);
+void cfPS(EvalContext *ctx, LogLevel level, PromiseResult status, const Promise *pp, const Attributes *attr, const char *fmt, ...) FUNC_ATTR_PRINTF(6, 7);
 
 PackagePromiseContext *GetPackageDefaultsFromCtx(const EvalContext *ctx);
 
@@ -245,7 +266,7 @@ PackagePromiseContext *GetPackagePromiseContext(const EvalContext *ctx);
 
 /* This function is temporarily exported. It needs to be made an detail of
  * evaluator again, once variables promises are no longer specially handled */
-void ClassAuditLog(EvalContext *ctx, const Promise *pp, Attributes attr, PromiseResult status);
+void ClassAuditLog(EvalContext *ctx, const Promise *pp, const Attributes *attr, PromiseResult status);
 
 ENTERPRISE_VOID_FUNC_2ARG_DECLARE(void, TrackTotalCompliance, ARG_UNUSED PromiseResult, status, ARG_UNUSED const Promise *, pp);
 
@@ -45,7 +45,7 @@
 #include <hashes.h>
 #include <unix.h>
 #include <string_lib.h>
-#include <regex.h>          /* CompileRegex,StringMatchWithPrecompiledRegex */
+#include <regex.h>          /* CachedRegexAcquire,StringMatchWithCachedRegex */
 #include <net.h>                                           /* SocketConnect */
 #include <communication.h>
 #include <classic.h>                                    /* SendSocketStream */
@@ -589,14 +589,22 @@ static FnCallResult FnCallHostsSeen(ARG_UNUSED EvalContext *ctx, ARG_UNUSED cons
     Log(LOG_LEVEL_DEBUG, "Calling hostsseen(%d,%s,%s)",
         horizon, hostseen_policy, format);
 
-    if (!ScanLastSeenQuality(&CallHostsSeenCallback, &addresses))
+    bool return_recent = (strcmp(hostseen_policy, "lastseen") == 0);
+
+    /* Hosts not seen recently can only be told apart with all the entries,
+     * but the recent ones are found by range-scanning the time index. */
+    bool scanned = return_recent ?
+        ScanLastSeenQualitySince(time(NULL) - horizon,
+                                 &CallHostsSeenCallback, &addresses) :
+        ScanLastSeenQuality(&CallHostsSeenCallback, &addresses);
+    if (!scanned)
     {
         return FnFailure();
     }
 
     Rlist *returnlist = GetHostsFromLastseenDB(addresses, horizon,
                                                strcmp(format, "address") == 0,
-                                               strcmp(hostseen_policy, "lastseen") == 0);
+                                               return_recent);
 
     DeleteItemList(addresses);
 
@@ -1243,7 +1251,7 @@ static JsonElement *VariablesMatching(const EvalContext *ctx, const FnCall *fp,
     JsonElement *matching = JsonObjectCreate(10);
 
     const char *regex = RlistScalarValue(args);
-    pcre *rx = CompileRegex(regex);
+    CachedRegex *rx = CachedRegexAcquire(regex);
 
     Variable *v = NULL;
     while ((v = VariableTableIteratorNext(iter)))
@@ -1252,7 +1260,7 @@ static JsonElement *VariablesMatching(const EvalContext *ctx, const FnCall *fp,
 
         /* FIXME: review this strcmp. Moved out from StringMatch */
         if (!strcmp(regex, expr) ||
-            (rx && StringMatchFullWithPrecompiledRegex(rx, expr)))
+            (rx && StringMatchFullWithCachedRegex(rx, expr)))
         {
             StringSet *tagset = EvalContextVariableTags(ctx, v->ref);
             bool pass = false;
@@ -1325,10 +1333,7 @@ static JsonElement *VariablesMatching(const EvalContext *ctx, const FnCall *fp,
         }
     }
 
-    if (rx)
-    {
-        pcre_free(rx);
-    }
+    CachedRegexRelease(rx);
 
     return matching;
 }
@@ -1453,7 +1458,7 @@ static FnCallResult FnCallBundlesMatching(EvalContext *ctx, const Policy *policy
     }
 
     const char *regex = RlistScalarValue(finalargs);
-    pcre *rx = CompileRegex(regex);
+    CachedRegex *rx = CachedRegexAcquire(regex);
     if (!rx)
     {
         return FnFailure();
@@ -1467,7 +1472,7 @@ static FnCallResult FnCallBundlesMatching(EvalContext *ctx, const Policy *policy
         const Bundle *bp = SeqAt(policy->bundles, i);
 
         char *bundle_name = BundleQualifiedName(bp);
-        if (StringMatchFullWithPrecompiledRegex(rx, bundle_name))
+        if (StringMatchFullWithCachedRegex(rx, bundle_name))
         {
             VarRef *ref = VarRefParseFromBundle("tags", bp);
             VarRefSetMeta(ref, true);
@@ -1516,14 +1521,14 @@ static FnCallResult FnCallBundlesMatching(EvalContext *ctx, const Policy *policy
         free(bundle_name);
     }
 
-    pcre_free(rx);
+    CachedRegexRelease(rx);
 
     return (FnCallResult) { FNCALL_SUCCESS, { matches, RVAL_TYPE_LIST } };
 }
 
 /*********************************************************************/
 
-static bool AddPackagesMatchingJsonLine(pcre *matcher, JsonElement *json, char *line)
+static bool AddPackagesMatchingJsonLine(const CachedRegex *matcher, JsonElement *json, char *line)
 {
 
     if (strlen(line) > CF_BUFSIZE - 80)
@@ -1535,7 +1540,7 @@ static bool AddPackagesMatchingJsonLine(pcre *matcher, JsonElement *json, char *
     }
 
 
-    if (StringMatchFullWithPrecompiledRegex(matcher, line))
+    if (StringMatchFullWithCachedRegex(matcher, line))
     {
         Seq *list = SeqParseCsvString(line);
         if (SeqLength(list) != 4)
@@ -1560,7 +1565,7 @@ static bool AddPackagesMatchingJsonLine(pcre *matcher, JsonElement *json, char *
     return true;
 }
 
-static bool GetLegacyPackagesMatching(pcre *matcher, JsonElement *json, const bool installed_mode)
+static bool GetLegacyPackagesMatching(const CachedRegex *matcher, JsonElement *json, const bool installed_mode)
 {
     char filename[CF_MAXVARSIZE];
     if (installed_mode)
@@ -1608,7 +1613,7 @@ static bool GetLegacyPackagesMatching(pcre *matcher, JsonElement *json, const bo
     return ret;
 }
 
-static bool GetPackagesMatching(pcre *matcher, JsonElement *json, const bool installed_mode, Rlist *default_inventory)
+static bool GetPackagesMatching(const CachedRegex *matcher, JsonElement *json, const bool installed_mode, Rlist *default_inventory)
 {
     dbid database = (installed_mode == true ? dbid_packages_installed : dbid_packages_updates);
 
@@ -1692,7 +1697,7 @@ static bool GetPackagesMatching(pcre *matcher, JsonElement *json, const bool ins
 static FnCallResult FnCallPackagesMatching(ARG_UNUSED EvalContext *ctx, ARG_UNUSED const Policy *policy, const FnCall *fp, const Rlist *finalargs)
 {
     const bool installed_mode = (strcmp(fp->name, "packagesmatching") == 0);
-    pcre *matcher;
+    CachedRegex *matcher;
     {
         const char *regex_package = RlistScalarValue(finalargs);
         const char *regex_version = RlistScalarValue(finalargs->next);
@@ -1703,7 +1708,7 @@ static FnCallResult FnCallPackagesMatching(ARG_UNUSED EvalContext *ctx, ARG_UNUS
         // Here we will truncate the regex if the parameters add up to over CF_BUFSIZE
         snprintf(regex, sizeof(regex), "^%s,%s,%s,%s$",
                  regex_package, regex_version, regex_arch, regex_method);
-        matcher = CompileRegex(regex);
+        matcher = CachedRegexAcquire(regex);
         if (matcher == NULL)
         {
             return FnFailure();
@@ -1725,7 +1730,7 @@ static FnCallResult FnCallPackagesMatching(ARG_UNUSED EvalContext *ctx, ARG_UNUS
         ret = GetPackagesMatching(matcher, json, installed_mode, default_inventory);
     }
 
-    pcre_free(matcher);
+    CachedRegexRelease(matcher);
 
     if (ret == false)
     {
@@ -2740,7 +2745,7 @@ static FnCallResult FnCallGetFields(EvalContext *ctx,
                                     const FnCall *fp,
                                     const Rlist *finalargs)
 {
-    pcre *rx = CompileRegex(RlistScalarValue(finalargs));
+    CachedRegex *rx = CachedRegexAcquire(RlistScalarValue(finalargs));
     if (!rx)
     {
         return FnFailure();
@@ -2754,7 +2759,7 @@ static FnCallResult FnCallGetFields(EvalContext *ctx,
     if (!fin)
     {
         Log(LOG_LEVEL_ERR, "File '%s' could not be read in getfields(). (fopen: %s)", filename, GetErrorStr());
-        pcre_free(rx);
+        CachedRegexRelease(rx);
         return FnFailure();
     }
 
@@ -2765,7 +2770,7 @@ static FnCallResult FnCallGetFields(EvalContext *ctx,
 
     while (CfReadLine(&line, &line_size, fin) != -1)
     {
-        if (!StringMatchFullWithPrecompiledRegex(rx, line))
+        if (!StringMatchFullWithCachedRegex(rx, line))
         {
             continue;
         }
@@ -2796,7 +2801,7 @@ static FnCallResult FnCallGetFields(EvalContext *ctx,
                         VarRefDestroy(ref);
                         free(line);
                         RlistDestroy(newlist);
-                        pcre_free(rx);
+                        CachedRegexRelease(rx);
                         return FnFailure();
                     }
                 }
@@ -2813,7 +2818,7 @@ static FnCallResult FnCallGetFields(EvalContext *ctx,
         line_count++;
     }
 
-    pcre_free(rx);
+    CachedRegexRelease(rx);
     free(line);
 
     if (!feof(fin))
@@ -2832,7 +2837,7 @@ static FnCallResult FnCallGetFields(EvalContext *ctx,
 
 static FnCallResult FnCallCountLinesMatching(ARG_UNUSED EvalContext *ctx, ARG_UNUSED const Policy *policy, ARG_UNUSED const FnCall *fp, const Rlist *finalargs)
 {
-    pcre *rx = CompileRegex(RlistScalarValue(finalargs));
+    CachedRegex *rx = CachedRegexAcquire(RlistScalarValue(finalargs));
     if (!rx)
     {
         return FnFailure();
@@ -2844,7 +2849,7 @@ static FnCallResult FnCallCountLinesMatching(ARG_UNUSED EvalContext *ctx, ARG_UN
     if (!fin)
     {
         Log(LOG_LEVEL_VERBOSE, "File '%s' could not be read in countlinesmatching(). (fopen: %s)", filename, GetErrorStr());
-        pcre_free(rx);
+        CachedRegexRelease(rx);
         return FnReturn("0");
     }
 
@@ -2855,7 +2860,7 @@ static FnCallResult FnCallCountLinesMatching(ARG_UNUSED EvalContext *ctx, ARG_UN
 
         while (CfReadLine(&line, &line_size, fin) != -1)
         {
-            if (StringMatchFullWithPrecompiledRegex(rx, line))
+            if (StringMatchFullWithCachedRegex(rx, line))
             {
                 lcount++;
                 Log(LOG_LEVEL_VERBOSE, "countlinesmatching: matched '%s'", line);
@@ -2866,7 +2871,7 @@ static FnCallResult FnCallCountLinesMatching(ARG_UNUSED EvalContext *ctx, ARG_UN
         free(line);
     }
 
-    pcre_free(rx);
+    CachedRegexRelease(rx);
 
     if (!feof(fin))
     {
@@ -4288,10 +4293,10 @@ static FnCallResult FilterInternal(EvalContext *ctx,
                                    bool invert,
                                    long max)
 {
-    pcre *rx = NULL;
+    CachedRegex *rx = NULL;
     if (do_regex)
     {
-        rx = CompileRegex(regex);
+        rx = CachedRegexAcquire(regex);
         if (!rx)
         {
             return FnFailure();
@@ -4304,7 +4309,7 @@ static FnCallResult FilterInternal(EvalContext *ctx,
     // we failed to produce a valid JsonElement, so give up
     if (json == NULL)
     {
-        pcre_free(rx);
+        CachedRegexRelease(rx);
         return FnFailure();
     }
     else if (JsonGetElementType(json) != JSON_ELEMENT_TYPE_CONTAINER)
@@ -4312,7 +4317,7 @@ static FnCallResult FilterInternal(EvalContext *ctx,
         Log(LOG_LEVEL_VERBOSE, "Function '%s', argument '%s' was not a data container or list",
             fp->name, RlistScalarValueSafe(rp));
         JsonDestroyMaybe(json, allocated);
-        pcre_free(rx);
+        CachedRegexRelease(rx);
         return FnFailure();
     }
 
@@ -4332,7 +4337,7 @@ static FnCallResult FilterInternal(EvalContext *ctx,
             bool found;
             if (do_regex)
             {
-                found = StringMatchFullWithPrecompiledRegex(rx, val);
+                found = StringMatchFullWithCachedRegex(rx, val);
             }
             else
             {
@@ -4365,10 +4370,7 @@ static FnCallResult FilterInternal(EvalContext *ctx,
 
     JsonDestroyMaybe(json, allocated);
 
-    if (rx)
-    {
-        pcre_free(rx);
-    }
+    CachedRegexRelease(rx);
 
     bool contextmode = 0;
     bool ret;
@@ -5839,7 +5841,7 @@ static FnCallResult FnCallRegExtract(EvalContext *ctx, ARG_UNUSED const Policy *
 
 static FnCallResult FnCallRegLine(ARG_UNUSED EvalContext *ctx, ARG_UNUSED const Policy *policy, const FnCall *fp, const Rlist *finalargs)
 {
-    pcre *rx = CompileRegex(RlistScalarValue(finalargs));
+    CachedRegex *rx = CachedRegexAcquire(RlistScalarValue(finalargs));
     if (!rx)
     {
         return FnFailure();
@@ -5850,7 +5852,7 @@ static FnCallResult FnCallRegLine(ARG_UNUSED EvalContext *ctx, ARG_UNUSED const
     FILE *fin = safe_fopen(arg_filename, "rt");
     if (!fin)
     {
-        pcre_free(rx);
+        CachedRegexRelease(rx);
         return FnReturnContext(false);
     }
 
@@ -5859,16 +5861,16 @@ static FnCallResult FnCallRegLine(ARG_UNUSED EvalContext *ctx, ARG_UNUSED const
 
     while (CfReadLine(&line, &line_size, fin) != -1)
     {
-        if (StringMatchFullWithPrecompiledRegex(rx, line))
+        if (StringMatchFullWithCachedRegex(rx, line))
         {
             free(line);
             fclose(fin);
-            pcre_free(rx);
+            CachedRegexRelease(rx);
             return FnReturnContext(true);
         }
     }
 
-    pcre_free(rx);
+    CachedRegexRelease(rx);
     free(line);
 
     if (!feof(fin))
@@ -7325,14 +7327,14 @@ static char *StripPatterns(char *file_buffer, const char *pattern, const char *f
         return file_buffer;
     }
 
-    pcre *rx = CompileRegex(pattern);
+    CachedRegex *rx = CachedRegexAcquire(pattern);
     if (!rx)
     {
         return file_buffer;
     }
 
     int start, end, count = 0;
-    while (StringMatchWithPrecompiledRegex(rx, file_buffer, &start, &end))
+    while (StringMatchWithCachedRegex(rx, file_buffer, &start, &end))
     {
         CloseStringHole(file_buffer, start, end);
 
@@ -7341,12 +7343,12 @@ static char *StripPatterns(char *file_buffer, const char *pattern, const char *f
             Log(LOG_LEVEL_ERR,
                 "Comment regex '%s' was irreconcilable reading input '%s' probably because it legally matches nothing",
                 pattern, filename);
-            pcre_free(rx);
+            CachedRegexRelease(rx);
             return file_buffer;
         }
     }
 
-    pcre_free(rx);
+    CachedRegexRelease(rx);
     return file_buffer;
 }
 
@@ -7667,13 +7669,13 @@ void ModuleProtocol(EvalContext *ctx, char *command, const char *line, int print
             content[0] != '\0')
         {
             /* Symbol ID without \200 to \377: */
-            pcre *context_name_rx = CompileRegex("[a-zA-Z0-9_]+");
+            CachedRegex *context_name_rx = CachedRegexAcquire("[a-zA-Z0-9_]+");
             if (!context_name_rx)
             {
                 Log(LOG_LEVEL_ERR,
                     "Internal error compiling module protocol context regex, aborting!!!");
             }
-            else if (StringMatchFullWithPrecompiledRegex(context_name_rx, content))
+            else if (StringMatchFullWithCachedRegex(context_name_rx, content))
             {
                 Log(LOG_LEVEL_VERBOSE, "Module changed variable context from '%s' to '%s'", context, content);
                 strlcpy(context, content, context_size);
@@ -7684,10 +7686,7 @@ void ModuleProtocol(EvalContext *ctx, char *command, const char *line, int print
                     "Module protocol was given an unacceptable ^context directive '%s', skipping", content);
             }
 
-            if (context_name_rx)
-            {
-                pcre_free(context_name_rx);
-            }
+            CachedRegexRelease(context_name_rx);
         }
         else if (sscanf(line + 1, "meta=%1024[^\n]", content) == 1 &&
                  content[0] != '\0')
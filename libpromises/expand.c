@@ -42,6 +42,8 @@
 #include <string_lib.h>
 #include <conversion.h>
 #include <verify_classes.h>
+#include <map.h>
+#include <string_intern.h>
 
 
 /**
@@ -417,97 +419,357 @@ Rval ExpandBundleReference(EvalContext *ctx,
 }
 
 /**
- * Expand a #string into Buffer #out, returning the pointer to the string
- * itself, inside the Buffer #out. If #out is NULL then the buffer will be
- * created and destroyed internally.
+ * Scalar templates
  *
- * @retval NULL something went wrong
+ * ExpandScalar() is called for every string of every promise, in every
+ * iteration and every pass. Instead of scanning the string for references
+ * and parsing them each time, the string is parsed once into a template:
+ * literal text, each followed by a reference with its name already parsed
+ * into a VarRef. References that can't be expanded (e.g. "$(/bin/cat x)")
+ * are folded into the literal text, and references whose name contains
+ * other references (e.g. "$(array[$(i)])") keep a template of their name.
+ *
+ * Templates are cached by string, so expansion is a lookup of each variable
+ * and a concatenation.
+ *
+ * @note THREAD-SAFETY: no, just like the EvalContext.
  */
-char *ExpandScalar(const EvalContext *ctx, const char *ns, const char *scope,
-                   const char *string, Buffer *out)
+
+#define SCALAR_TEMPLATES_MAX 10000
+
+typedef struct
 {
-    bool out_belongs_to_us = false;
+    char *name;                              /* as written, without $( ) */
+    VarRef *ref;                     /* parsed without ns/scope defaults */
+    bool default_ns;             /* namespace is taken from ExpandScalar() */
+} ScalarRef;
 
-    if (out == NULL)
+typedef struct ScalarTemplate_ ScalarTemplate;
+
+typedef struct
+{
+    char *literal;                          /* text before the reference */
+    size_t literal_len;
+    char varstring;                                        /* '(' or '{' */
+    ScalarRef *ref;                             /* NULL if name is nested */
+    ScalarTemplate *name;                 /* template of the nested name */
+} ScalarSegment;
+
+struct ScalarTemplate_
+{
+    Seq *segments;
+    char *tail;                          /* text after the last reference */
+    size_t tail_len;
+};
+
+static Map *SCALAR_TEMPLATES = NULL;                  /* string -> template */
+static Map *SCALAR_REFS = NULL;            /* expanded nested name -> ref */
+
+static ScalarRef *ScalarRefNew(const char *name)
+{
+    ScalarRef *sref = xmalloc(sizeof(ScalarRef));
+    sref->name = xstrdup(name);
+    sref->ref = VarRefParseFromNamespaceAndScope(name, NULL, NULL, CF_NS, '.');
+
+    /* A namespace isn't inherited when there is one in the name, or when
+     * the scope is a special one. Let the parser tell. */
+    VarRef *probe = VarRefParseFromNamespaceAndScope(name, "-", NULL, CF_NS, '.');
+    sref->default_ns = (sref->ref->ns == NULL && probe->ns != NULL);
+    VarRefDestroy(probe);
+
+    return sref;
+}
+
+static void ScalarRefDestroy(ScalarRef *sref)
+{
+    if (sref != NULL)
     {
-        out               = BufferNew();
-        out_belongs_to_us = true;
+        free(sref->name);
+        VarRefDestroy(sref->ref);
+        free(sref);
     }
+}
 
-    assert(string != NULL);
-    assert(out != NULL);
+static void ScalarRefDestroy_untyped(void *sref)
+{
+    ScalarRefDestroy(sref);
+}
+
+static void ScalarTemplateDestroy(ScalarTemplate *tmpl);
+
+static void ScalarSegmentDestroy(void *p)
+{
+    ScalarSegment *segment = p;
+    free(segment->literal);
+    ScalarRefDestroy(segment->ref);
+    ScalarTemplateDestroy(segment->name);
+    free(segment);
+}
+
+static void ScalarTemplateDestroy(ScalarTemplate *tmpl)
+{
+    if (tmpl != NULL)
+    {
+        SeqDestroy(tmpl->segments);
+        free(tmpl->tail);
+        free(tmpl);
+    }
+}
+
+static void ScalarTemplateDestroy_untyped(void *tmpl)
+{
+    ScalarTemplateDestroy(tmpl);
+}
+
+/**
+ * Parse #string the same way ExpandScalar() always did: literal text up to
+ * "$(" or "${", then the reference up to the matching bracket.
+ */
+static ScalarTemplate *ScalarTemplateNew(const char *string)
+{
+    ScalarTemplate *tmpl = xmalloc(sizeof(ScalarTemplate));
+    tmpl->segments = SeqNew(2, ScalarSegmentDestroy);
+
+    Buffer *literal = BufferNew();
     Buffer *current_item = BufferNew();
+    const size_t len = strlen(string);
 
-    for (const char *sp = string; *sp != '\0'; sp++)
+    for (size_t i = 0; i < len; i++)
     {
         BufferClear(current_item);
-        ExtractScalarPrefix(current_item, sp, strlen(sp));
+        ExtractScalarPrefix(current_item, string + i, len - i);
 
-        BufferAppend(out, BufferData(current_item), BufferSize(current_item));
-        sp += BufferSize(current_item);
-        if (*sp == '\0')
+        BufferAppend(literal, BufferData(current_item), BufferSize(current_item));
+        i += BufferSize(current_item);
+        if (i >= len)
         {
             break;
         }
 
         BufferClear(current_item);
-        char varstring = sp[1];
-        ExtractScalarReference(current_item,  sp, strlen(sp), true);
-        sp += BufferSize(current_item) + 2;
+        char varstring = string[i + 1];
+        ExtractScalarReference(current_item, string + i, len - i, true);
+        i += BufferSize(current_item) + 2;
+
+        const char *name = BufferData(current_item);
+        ScalarRef *ref = NULL;
+        ScalarTemplate *nested = NULL;
+
+        if (IsCf3VarString(name))
+        {
+            nested = ScalarTemplateNew(name);
+        }
+        else if (!IsExpandable(name))
+        {
+            ref = ScalarRefNew(name);
+        }
+        else
+        {
+            /* Can never be expanded, it's just text. */
+            BufferAppendF(literal, (varstring == '{') ? "${%s}" : "$(%s)", name);
+            continue;
+        }
+
+        ScalarSegment *segment = xmalloc(sizeof(ScalarSegment));
+        segment->literal_len = BufferSize(literal);
+        segment->literal = BufferClose(literal);
+        segment->varstring = varstring;
+        segment->ref = ref;
+        segment->name = nested;
+        SeqAppend(tmpl->segments, segment);
+
+        literal = BufferNew();
+    }
+
+    tmpl->tail_len = BufferSize(literal);
+    tmpl->tail = BufferClose(literal);
+    BufferDestroy(current_item);
+
+    return tmpl;
+}
+
+static const ScalarTemplate *ScalarTemplateGet(const char *string)
+{
+    if (SCALAR_TEMPLATES == NULL)
+    {
+        SCALAR_TEMPLATES = MapNew(StringHash_untyped, StringSafeEqual_untyped,
+                                  free, ScalarTemplateDestroy_untyped);
+    }
 
-        if (IsCf3VarString(BufferData(current_item)))
+    ScalarTemplate *tmpl = MapGet(SCALAR_TEMPLATES, string);
+    if (tmpl == NULL)
+    {
+        if (MapSize(SCALAR_TEMPLATES) >= SCALAR_TEMPLATES_MAX)
         {
-            Buffer *temp = BufferCopy(current_item);
-            BufferClear(current_item);
-            ExpandScalar(ctx, ns, scope, BufferData(temp), current_item);
-            BufferDestroy(temp);
+            MapClear(SCALAR_TEMPLATES);
         }
 
-        if (!IsExpandable(BufferData(current_item)))
+        tmpl = ScalarTemplateNew(string);
+        MapInsert(SCALAR_TEMPLATES, xstrdup(string), tmpl);
+    }
+
+    return tmpl;
+}
+
+static const ScalarRef *ScalarRefGet(const char *name)
+{
+    if (SCALAR_REFS == NULL)
+    {
+        SCALAR_REFS = MapNew(StringHash_untyped, StringSafeEqual_untyped,
+                             free, ScalarRefDestroy_untyped);
+    }
+
+    ScalarRef *sref = MapGet(SCALAR_REFS, name);
+    if (sref == NULL)
+    {
+        if (MapSize(SCALAR_REFS) >= SCALAR_TEMPLATES_MAX)
         {
-            VarRef *ref = VarRefParseFromNamespaceAndScope(
-                BufferData(current_item),
-                ns, scope, CF_NS, '.');
-            DataType value_type;
-            const void *value = EvalContextVariableGet(ctx, ref, &value_type);
-            VarRefDestroy(ref);
+            MapClear(SCALAR_REFS);
+        }
+
+        sref = ScalarRefNew(name);
+        MapInsert(SCALAR_REFS, xstrdup(name), sref);
+    }
 
-            switch (DataTypeToRvalType(value_type))
+    return sref;
+}
+
+/**
+ * Append the value of #sref to #out, qualified as
+ * VarRefParseFromNamespaceAndScope(name, ns, scope) would. #ns and #scope
+ * are interned.
+ *
+ * @return false if it has no scalar value.
+ */
+static bool ScalarRefExpand(const EvalContext *ctx,
+                            const char *ns, const char *scope,
+                            const ScalarRef *sref, Buffer *out)
+{
+    VarRef ref = *sref->ref;                        /* no need to copy it */
+    if (sref->default_ns)
+    {
+        ref.ns = ns;
+    }
+    if (ref.scope == NULL)
+    {
+        ref.scope = scope;
+    }
+
+    DataType value_type;
+    const void *value = EvalContextVariableGet(ctx, &ref, &value_type);
+
+    switch (DataTypeToRvalType(value_type))
+    {
+    case RVAL_TYPE_SCALAR:
+        assert(value != NULL);
+        BufferAppendString(out, value);
+        return true;
+
+    case RVAL_TYPE_CONTAINER:
+    {
+        assert(value != NULL);
+        const JsonElement *jvalue = value;      /* instead of casts */
+        if (JsonGetElementType(jvalue) == JSON_ELEMENT_TYPE_PRIMITIVE)
+        {
+            BufferAppendString(out, JsonPrimitiveGetAsString(jvalue));
+            return true;
+        }
+        return false;
+    }
+    default:
+        /* TODO Log() */
+        return false;
+    }
+}
+
+static void ScalarTemplateExpand(const EvalContext *ctx,
+                                 const char *ns, const char *scope,
+                                 const ScalarTemplate *tmpl, Buffer *out)
+{
+    Buffer *name = NULL;
+
+    const size_t length = SeqLength(tmpl->segments);
+    for (size_t i = 0; i < length; i++)
+    {
+        const ScalarSegment *segment = SeqAt(tmpl->segments, i);
+        BufferAppend(out, segment->literal, segment->literal_len);
+
+        const char *unexpanded;
+        if (segment->ref != NULL)
+        {
+            if (ScalarRefExpand(ctx, ns, scope, segment->ref, out))
             {
-            case RVAL_TYPE_SCALAR:
-                assert(value != NULL);
-                BufferAppendString(out, value);
                 continue;
-                break;
-
-            case RVAL_TYPE_CONTAINER:
+            }
+            unexpanded = segment->ref->name;
+        }
+        else
+        {
+            if (name == NULL)
             {
-                assert(value != NULL);
-                const JsonElement *jvalue = value;      /* instead of casts */
-                if (JsonGetElementType(jvalue) == JSON_ELEMENT_TYPE_PRIMITIVE)
-                {
-                    BufferAppendString(out, JsonPrimitiveGetAsString(jvalue));
-                    continue;
-                }
-                break;
+                name = BufferNew();
             }
-            default:
-                /* TODO Log() */
-                break;
+            BufferClear(name);
+            ScalarTemplateExpand(ctx, ns, scope, segment->name, name);
+
+            if (!IsExpandable(BufferData(name)) &&
+                ScalarRefExpand(ctx, ns, scope,
+                                ScalarRefGet(BufferData(name)), out))
+            {
+                continue;
             }
+            unexpanded = BufferData(name);
         }
 
-        if (varstring == '{')
+        if (segment->varstring == '{')
         {
-            BufferAppendF(out, "${%s}", BufferData(current_item));
+            BufferAppendF(out, "${%s}", unexpanded);
         }
         else
         {
-            BufferAppendF(out, "$(%s)", BufferData(current_item));
+            BufferAppendF(out, "$(%s)", unexpanded);
         }
     }
 
-    BufferDestroy(current_item);
+    BufferAppend(out, tmpl->tail, tmpl->tail_len);
+    BufferDestroy(name);
+}
+
+/**
+ * Expand a #string into Buffer #out, returning the pointer to the string
+ * itself, inside the Buffer #out. If #out is NULL then the buffer will be
+ * created and destroyed internally.
+ *
+ * @retval NULL something went wrong
+ */
+char *ExpandScalar(const EvalContext *ctx, const char *ns, const char *scope,
+                   const char *string, Buffer *out)
+{
+    bool out_belongs_to_us = false;
+
+    if (out == NULL)
+    {
+        out               = BufferNew();
+        out_belongs_to_us = true;
+    }
+
+    assert(string != NULL);
+    assert(out != NULL);
+
+    if (strchr(string, '$') == NULL)                  /* nothing to expand */
+    {
+        BufferAppendString(out, string);
+    }
+    else
+    {
+        /* VarRef needs interned names, do it once for all references. */
+        const char *interned_ns = StringIntern(ns);
+        const char *interned_scope = StringIntern(scope);
+        ScalarTemplateExpand(ctx, interned_ns, interned_scope,
+                             ScalarTemplateGet(string), out);
+        StringInternRelease(interned_ns);
+        StringInternRelease(interned_scope);
+    }
 
     LogDebug(LOG_MOD_EXPAND, "ExpandScalar( %s : %s . %s )  =>  %s",
              SAFENULL(ns), SAFENULL(scope), string, BufferData(out));
@@ -836,6 +1098,22 @@ static void ResolveControlBody(EvalContext *ctx, GenericAgentConfig *config,
                                      cache_system_functions);
         }
 
+        if (strcmp(lval, CFG_CONTROLBODY[COMMON_CONTROL_PERSISTENT_FUNCTION_CACHE].lval) == 0)
+        {
+            Log(LOG_LEVEL_VERBOSE, "SET persistent_function_cache list");
+            EvalContextSetPersistentFunctions(ctx, RvalRlistValue(evaluated_rval));
+        }
+
+        if (strcmp(lval, CFG_CONTROLBODY[COMMON_CONTROL_PERSISTENT_FUNCTION_CACHE_TTL].lval) == 0)
+        {
+            long ttl = IntFromString(RvalScalarValue(evaluated_rval));
+            if (ttl != CF_NOINT && ttl >= 0)
+            {
+                Log(LOG_LEVEL_VERBOSE, "SET persistent_function_cache_ttl %ld", ttl);
+                EvalContextSetPersistentFunctionTTL(ctx, ttl);
+            }
+        }
+
         if (strcmp(lval, CFG_CONTROLBODY[COMMON_CONTROL_PROTOCOL_VERSION].lval) == 0)
         {
             config->protocol_version = ProtocolVersionParse(
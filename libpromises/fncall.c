@@ -34,6 +34,8 @@
 #include <promises.h>
 #include <syntax.h>
 #include <audit.h>
+#include <profiler.h>
+#include <function_cache.h>
 
 /******************************************************************/
 /* Argument propagation                                           */
@@ -304,7 +306,7 @@ static FnCallResult CallFunction(EvalContext *ctx, const Policy *policy, const F
     return (*fncall_type->impl) (ctx, policy, fp, expargs);
 }
 
-FnCallResult FnCallEvaluate(EvalContext *ctx, const Policy *policy, FnCall *fp, const Promise *caller)
+static FnCallResult FnCallEvaluateCall(EvalContext *ctx, const Policy *policy, FnCall *fp, const Promise *caller)
 {
     assert(ctx);
     assert(policy);
@@ -400,7 +402,36 @@ FnCallResult FnCallEvaluate(EvalContext *ctx, const Policy *policy, FnCall *fp,
         WriterClose(fncall_writer);
     }
 
-    FnCallResult result = CallFunction(ctx, policy, fp, expargs);
+    FnCallResult result;
+    if (EvalContextFunctionIsPersistent(ctx, fp->name))
+    {
+        /* Fingerprint the inputs before the call, so that a change during
+         * it invalidates the stored result rather than going unnoticed. */
+        JsonElement *fingerprint = FunctionCacheFingerprint(fp->name, expargs);
+        long ttl = EvalContextGetPersistentFunctionTTL(ctx);
+
+        if (FunctionCacheGet(fp->name, expargs, fingerprint, ttl, &result.rval))
+        {
+            result.status = FNCALL_SUCCESS;
+            JsonDestroy(fingerprint);
+        }
+        else
+        {
+            result = CallFunction(ctx, policy, fp, expargs);
+            if (result.status == FNCALL_SUCCESS)
+            {
+                FunctionCachePut(fp->name, expargs, fingerprint, result.rval);
+            }
+            else
+            {
+                JsonDestroy(fingerprint);
+            }
+        }
+    }
+    else
+    {
+        result = CallFunction(ctx, policy, fp, expargs);
+    }
 
     if (result.status == FNCALL_FAILURE)
     {
@@ -423,6 +454,55 @@ FnCallResult FnCallEvaluate(EvalContext *ctx, const Policy *policy, FnCall *fp,
     return result;
 }
 
+/* Functions whose result only depends on their arguments and on variables
+ * and classes they look up the usual way, see PromiseReads. Any other
+ * function makes the calling promise be evaluated again in every pass. */
+static const char *const TRACKED_FUNCTIONS[] =
+{
+    "and",
+    "canonify",
+    "canonifyuniquely",
+    "concat",
+    "ifelse",
+    "isvariable",
+    "not",
+    "or",
+    "strcmp",
+    "string_downcase",
+    "string_head",
+    "string_length",
+    "string_reverse",
+    "string_tail",
+    "string_upcase",
+    NULL
+};
+
+static bool FnCallIsTracked(const char *name)
+{
+    for (size_t i = 0; TRACKED_FUNCTIONS[i] != NULL; i++)
+    {
+        if (strcmp(TRACKED_FUNCTIONS[i], name) == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+FnCallResult FnCallEvaluate(EvalContext *ctx, const Policy *policy, FnCall *fp, const Promise *caller)
+{
+    if (!FnCallIsTracked(fp->name))
+    {
+        EvalContextPromiseReadsExternalState(ctx);
+    }
+
+    ProfilerEnterFunction(fp->name);
+    FnCallResult result = FnCallEvaluateCall(ctx, policy, fp, caller);
+    ProfilerLeave();
+
+    return result;
+}
+
 /*******************************************************************/
 
 const FnCallType *FnCallTypeGet(const char *name)
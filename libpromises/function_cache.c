@@ -0,0 +1,436 @@
+/*
+   Copyright 2018 Northern.tech AS
+
+   This file is part of CFEngine 3 - written and maintained by Northern.tech AS.
+
+   This program is free software; you can redistribute it and/or modify it
+   under the terms of the GNU General Public License as published by the
+   Free Software Foundation; version 3.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA
+
+  To the extent this program is licensed as part of the Enterprise
+  versions of CFEngine, the applicable Commercial Open Source License
+  (COSL) may apply to this file if you as a licensee so wish it. See
+  included file COSL.txt.
+*/
+
+#include <function_cache.h>
+
+#include <dbm_api.h>
+#include <files_hashes.h>
+#include <file_lib.h>
+#include <rlist.h>
+#include <writer.h>
+#include <string_lib.h>
+#include <misc_lib.h>                                          /* xsnprintf */
+#include <openssl/evp.h>
+
+
+/* Entries older than this are not used even if their inputs are unchanged,
+ * and are removed from the database once a day. */
+#define FUNCTION_CACHE_MAX_AGE (7 * SECONDS_PER_DAY)
+#define FUNCTION_CACHE_PURGE_KEY "last_purge"
+
+typedef enum
+{
+    FUNCTION_CACHE_INPUT_FILE,    /* first argument is a file or directory */
+    FUNCTION_CACHE_INPUT_TTL,     /* result depends on commands or a tree walk */
+} FunctionCacheInput;
+
+typedef struct
+{
+    const char *name;
+    FunctionCacheInput input;
+} FunctionCacheEntry;
+
+/* Only functions without side effects: readstringarray() and friends also
+ * define array variables, which a cached result would not do. */
+static const FunctionCacheEntry FUNCTION_CACHE_FUNCTIONS[] =
+{
+    { "readfile", FUNCTION_CACHE_INPUT_FILE },
+    { "readjson", FUNCTION_CACHE_INPUT_FILE },
+    { "readyaml", FUNCTION_CACHE_INPUT_FILE },
+    { "readdata", FUNCTION_CACHE_INPUT_FILE },
+    { "readcsv", FUNCTION_CACHE_INPUT_FILE },
+    { "readenvfile", FUNCTION_CACHE_INPUT_FILE },
+    { "readstringlist", FUNCTION_CACHE_INPUT_FILE },
+    { "readintlist", FUNCTION_CACHE_INPUT_FILE },
+    { "readreallist", FUNCTION_CACHE_INPUT_FILE },
+    { "data_readstringarray", FUNCTION_CACHE_INPUT_FILE },
+    { "data_readstringarrayidx", FUNCTION_CACHE_INPUT_FILE },
+    { "file_hash", FUNCTION_CACHE_INPUT_FILE },
+    { "lsdir", FUNCTION_CACHE_INPUT_FILE },
+    { "findfiles", FUNCTION_CACHE_INPUT_TTL },
+    { "execresult", FUNCTION_CACHE_INPUT_TTL },
+    { "packagesmatching", FUNCTION_CACHE_INPUT_TTL },
+    { "packageupdatesmatching", FUNCTION_CACHE_INPUT_TTL },
+    { NULL, 0 }
+};
+
+static const FunctionCacheEntry *FunctionCacheLookup(const char *function)
+{
+    for (int i = 0; FUNCTION_CACHE_FUNCTIONS[i].name != NULL; i++)
+    {
+        if (strcmp(FUNCTION_CACHE_FUNCTIONS[i].name, function) == 0)
+        {
+            return &FUNCTION_CACHE_FUNCTIONS[i];
+        }
+    }
+    return NULL;
+}
+
+bool FunctionCacheSupported(const char *function)
+{
+    return FunctionCacheLookup(function) != NULL;
+}
+
+/*********************************************************************/
+
+static char *FunctionCacheCallString(const char *function, const Rlist *args)
+{
+    Writer *w = StringWriter();
+    WriterWriteF(w, "%s", function);
+    RlistWrite(w, args);
+    return StringWriterClose(w);
+}
+
+static void FunctionCacheKey(const char *call, char key[CF_HOSTKEY_STRING_SIZE])
+{
+    unsigned char digest[EVP_MAX_MD_SIZE + 1];
+    HashString(call, strlen(call), digest, HASH_METHOD_SHA256);
+    HashPrintSafe(key, CF_HOSTKEY_STRING_SIZE, digest, HASH_METHOD_SHA256, true);
+}
+
+static char *JsonCompactString(const JsonElement *json)
+{
+    Writer *w = StringWriter();
+    JsonWriteCompact(w, json);
+    return StringWriterClose(w);
+}
+
+static bool JsonCompactEqual(const JsonElement *a, const JsonElement *b)
+{
+    char *a_str = JsonCompactString(a);
+    char *b_str = JsonCompactString(b);
+    bool equal = (strcmp(a_str, b_str) == 0);
+    free(a_str);
+    free(b_str);
+    return equal;
+}
+
+/**
+ * @brief What the result of #function depends on, besides its arguments:
+ *        the identity of the file or directory it reads. Empty for
+ *        functions that are only cached for a time.
+ * @return NULL if the call can not be cached, e.g. a relative path
+ */
+JsonElement *FunctionCacheFingerprint(const char *function, const Rlist *args)
+{
+    const FunctionCacheEntry *entry = FunctionCacheLookup(function);
+    if (entry == NULL)
+    {
+        return NULL;
+    }
+
+    JsonElement *files = JsonObjectCreate(1);
+    if (entry->input == FUNCTION_CACHE_INPUT_FILE)
+    {
+        const char *path = RlistScalarValueSafe(args);
+        if (args == NULL || !IsAbsoluteFileName(path))
+        {
+            JsonDestroy(files);
+            return NULL;
+        }
+
+        struct stat sb;
+        if (stat(path, &sb) == -1)
+        {
+            JsonObjectAppendString(files, path, "absent");
+        }
+        else
+        {
+            /* Sub-second timestamps, so that a file rewritten twice in the
+             * same second with the same size is not taken as unchanged. */
+#if defined(HAVE_STRUCT_STAT_ST_MTIM)
+            long mtime_ns = sb.st_mtim.tv_nsec;
+            long ctime_ns = sb.st_ctim.tv_nsec;
+#elif defined(HAVE_STRUCT_STAT_ST_MTIMESPEC)
+            long mtime_ns = sb.st_mtimespec.tv_nsec;
+            long ctime_ns = sb.st_ctimespec.tv_nsec;
+#else
+            long mtime_ns = 0;
+            long ctime_ns = 0;
+#endif
+            char id[CF_SMALLBUF];
+            xsnprintf(id, sizeof(id), "%jd.%09ld:%jd.%09ld:%jd:%ju",
+                      (intmax_t) sb.st_mtime, mtime_ns,
+                      (intmax_t) sb.st_ctime, ctime_ns,
+                      (intmax_t) sb.st_size, (uintmax_t) sb.st_ino);
+            JsonObjectAppendString(files, path, id);
+        }
+    }
+    return files;
+}
+
+static void FunctionCachePurge(CF_DB *db, time_t now)
+{
+    char last[CF_SMALLBUF] = "";
+    if (ReadDB(db, FUNCTION_CACHE_PURGE_KEY, last, sizeof(last) - 1) &&
+        now - (time_t) StringToLongDefaultOnError(last, 0) < SECONDS_PER_DAY)
+    {
+        return;
+    }
+
+    CF_DBC *cursor;
+    if (NewDBCursor(db, &cursor))
+    {
+        char *key;
+        void *value;
+        int ksize, vsize;
+        int purged = 0;
+
+        while (NextDB(cursor, &key, &ksize, &value, &vsize))
+        {
+            if (vsize < 1 || ((const char *) value)[vsize - 1] != '\0' ||
+                !StringStartsWith(key, "SHA"))
+            {
+                continue;
+            }
+
+            const char *data = value;
+            JsonElement *json = NULL;
+            long time = 0;
+            if (JsonParse(&data, &json) == JSON_PARSE_OK &&
+                JsonGetElementType(json) == JSON_ELEMENT_TYPE_CONTAINER &&
+                JsonGetContainerType(json) == JSON_CONTAINER_TYPE_OBJECT)
+            {
+                time = StringToLongDefaultOnError(JsonObjectGetAsString(json, "time"), 0);
+            }
+            JsonDestroy(json);
+
+            if (now - (time_t) time > FUNCTION_CACHE_MAX_AGE)
+            {
+                DBCursorDeleteEntry(cursor);
+                purged++;
+            }
+        }
+        DeleteDBCursor(cursor);
+
+        Log(LOG_LEVEL_VERBOSE, "Purged %d expired function cache entries", purged);
+    }
+
+    xsnprintf(last, sizeof(last), "%jd", (intmax_t) now);
+    WriteDB(db, FUNCTION_CACHE_PURGE_KEY, last, strlen(last) + 1);
+}
+
+static bool FunctionCacheRestore(const JsonElement *entry, Rval *rval_out)
+{
+    const char *type = JsonObjectGetAsString(entry, "type");
+    JsonElement *value = JsonObjectGet(entry, "value");
+    if (type == NULL || value == NULL)
+    {
+        return false;
+    }
+
+    if (strcmp(type, "scalar") == 0 &&
+        JsonGetElementType(value) == JSON_ELEMENT_TYPE_PRIMITIVE)
+    {
+        *rval_out = RvalNew(JsonPrimitiveGetAsString(value), RVAL_TYPE_SCALAR);
+        return true;
+    }
+    else if (strcmp(type, "list") == 0 &&
+             JsonGetElementType(value) == JSON_ELEMENT_TYPE_CONTAINER &&
+             JsonGetContainerType(value) == JSON_CONTAINER_TYPE_ARRAY)
+    {
+        Rlist *list = NULL;
+        for (size_t i = 0; i < JsonLength(value); i++)
+        {
+            const char *item = JsonArrayGetAsString(value, i);
+            if (item == NULL)
+            {
+                RlistDestroy(list);
+                return false;
+            }
+            RlistAppendScalar(&list, item);
+        }
+        *rval_out = (Rval) { list, RVAL_TYPE_LIST };
+        return true;
+    }
+    else if (strcmp(type, "container") == 0)
+    {
+        *rval_out = RvalNew(value, RVAL_TYPE_CONTAINER);
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Look up the result of a previous run of #function with #args.
+ * @param fingerprint the current state of its inputs, see FunctionCacheFingerprint()
+ * @param ttl seconds a result stays valid, for functions without file inputs
+ * @return true and a new rval in #rval_out on a hit
+ */
+bool FunctionCacheGet(const char *function, const Rlist *args,
+                      const JsonElement *fingerprint, long ttl,
+                      Rval *rval_out)
+{
+    const FunctionCacheEntry *fn = FunctionCacheLookup(function);
+    if (fn == NULL || fingerprint == NULL)
+    {
+        return false;
+    }
+
+    CF_DB *db;
+    if (!OpenDB(&db, dbid_function_cache))
+    {
+        return false;
+    }
+
+    char *call = FunctionCacheCallString(function, args);
+    char key[CF_HOSTKEY_STRING_SIZE];
+    FunctionCacheKey(call, key);
+
+    char *stored = NULL;
+    int size = ValueSizeDB(db, key, strlen(key) + 1);
+    if (size > 0)
+    {
+        stored = xmalloc(size + 1);
+        if (!ReadDB(db, key, stored, size))
+        {
+            free(stored);
+            stored = NULL;
+        }
+        else
+        {
+            stored[size] = '\0';
+        }
+    }
+    CloseDB(db);
+
+    bool hit = false;
+    JsonElement *entry = NULL;
+    const char *data = stored;
+    if (stored != NULL && JsonParse(&data, &entry) == JSON_PARSE_OK &&
+        JsonGetElementType(entry) == JSON_ELEMENT_TYPE_CONTAINER &&
+        JsonGetContainerType(entry) == JSON_CONTAINER_TYPE_OBJECT)
+    {
+        time_t age = time(NULL) -
+            (time_t) StringToLongDefaultOnError(JsonObjectGetAsString(entry, "time"), 0);
+        const char *stored_call = JsonObjectGetAsString(entry, "call");
+        JsonElement *files = JsonObjectGetAsObject(entry, "files");
+
+        if (stored_call == NULL || strcmp(stored_call, call) != 0)
+        {
+            Log(LOG_LEVEL_DEBUG, "Function cache collision for '%s'", call);
+        }
+        else if (age < 0 || age > FUNCTION_CACHE_MAX_AGE ||
+                 (fn->input == FUNCTION_CACHE_INPUT_TTL && age > ttl))
+        {
+            Log(LOG_LEVEL_DEBUG, "Function cache entry for '%s' has expired", call);
+        }
+        else if (files == NULL || !JsonCompactEqual(files, fingerprint))
+        {
+            Log(LOG_LEVEL_DEBUG, "Inputs of '%s' changed since it was cached", call);
+        }
+        else
+        {
+            hit = FunctionCacheRestore(entry, rval_out);
+        }
+    }
+
+    if (hit)
+    {
+        Log(LOG_LEVEL_DEBUG, "Using result of '%s' from the persistent function cache", call);
+    }
+
+    JsonDestroy(entry);
+    free(stored);
+    free(call);
+    return hit;
+}
+
+/**
+ * @brief Store the result of #function with #args for later runs.
+ * @param fingerprint taken before the call, consumed
+ */
+void FunctionCachePut(const char *function, const Rlist *args,
+                      JsonElement *fingerprint, Rval rval)
+{
+    if (fingerprint == NULL)
+    {
+        return;
+    }
+
+    JsonElement *value = NULL;
+    const char *type = NULL;
+    switch (rval.type)
+    {
+    case RVAL_TYPE_SCALAR:
+        type = "scalar";
+        value = JsonStringCreate(RvalScalarValue(rval));
+        break;
+
+    case RVAL_TYPE_LIST:
+        type = "list";
+        value = JsonArrayCreate(RlistLen(RvalRlistValue(rval)));
+        for (const Rlist *rp = RvalRlistValue(rval); rp != NULL; rp = rp->next)
+        {
+            if (rp->val.type != RVAL_TYPE_SCALAR)
+            {
+                JsonDestroy(value);
+                JsonDestroy(fingerprint);
+                return;
+            }
+            JsonArrayAppendString(value, RlistScalarValue(rp));
+        }
+        break;
+
+    case RVAL_TYPE_CONTAINER:
+        type = "container";
+        value = JsonCopy(RvalContainerValue(rval));
+        break;
+
+    default:
+        JsonDestroy(fingerprint);
+        return;
+    }
+
+    time_t now = time(NULL);
+    char now_str[CF_SMALLBUF];
+    xsnprintf(now_str, sizeof(now_str), "%jd", (intmax_t) now);
+
+    char *call = FunctionCacheCallString(function, args);
+    JsonElement *entry = JsonObjectCreate(5);
+    JsonObjectAppendString(entry, "call", call);
+    JsonObjectAppendString(entry, "time", now_str);
+    JsonObjectAppendObject(entry, "files", fingerprint);
+    JsonObjectAppendString(entry, "type", type);
+    JsonObjectAppendElement(entry, "value", value);
+
+    char key[CF_HOSTKEY_STRING_SIZE];
+    FunctionCacheKey(call, key);
+    char *data = JsonCompactString(entry);
+
+    CF_DB *db;
+    if (OpenDB(&db, dbid_function_cache))
+    {
+        if (!WriteDB(db, key, data, strlen(data) + 1))
+        {
+            Log(LOG_LEVEL_VERBOSE, "Could not cache result of '%s'", call);
+        }
+        FunctionCachePurge(db, now);
+        CloseDB(db);
+    }
+
+    free(data);
+    JsonDestroy(entry);
+    free(call);
+}
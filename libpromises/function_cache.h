@@ -0,0 +1,51 @@
+/*
+   Copyright 2018 Northern.tech AS
+
+   This file is part of CFEngine 3 - written and maintained by Northern.tech AS.
+
+   This program is free software; you can redistribute it and/or modify it
+   under the terms of the GNU General Public License as published by the
+   Free Software Foundation; version 3.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA
+
+  To the extent this program is licensed as part of the Enterprise
+  versions of CFEngine, the applicable Commercial Open Source License
+  (COSL) may apply to this file if you as a licensee so wish it. See
+  included file COSL.txt.
+*/
+
+#ifndef CFENGINE_FUNCTION_CACHE_H
+#define CFENGINE_FUNCTION_CACHE_H
+
+
+#include <cf3.defs.h>
+#include <json.h>
+
+
+/* Seconds that results of functions which run commands or search the file
+ * system stay valid, unless persistent_function_cache_ttl says otherwise. */
+#define FUNCTION_CACHE_DEFAULT_TTL 300
+
+
+/*
+ * Results of function calls that are kept across agent runs, see
+ * persistent_function_cache in body common control.
+ */
+bool FunctionCacheSupported(const char *function);
+
+JsonElement *FunctionCacheFingerprint(const char *function, const Rlist *args);
+bool FunctionCacheGet(const char *function, const Rlist *args,
+                      const JsonElement *fingerprint, long ttl,
+                      Rval *rval_out);
+void FunctionCachePut(const char *function, const Rlist *args,
+                      JsonElement *fingerprint, Rval rval);
+
+#endif
@@ -64,11 +64,14 @@
 #include <ornaments.h>
 #include <cf-windows-functions.h>
 #include <loading.h>
+#include <policy_snapshot.h>
 #include <signals.h>
 #include <addr_lib.h>
 #include <openssl/evp.h>
 #include <libcrypto-compat.h>
 #include <libgen.h>
+#include <regex.h>                                   /* RegexCache_LogStats */
+#include <string_intern.h>                         /* StringIntern_LogStats */
 
 static pthread_once_t pid_cleanup_once = PTHREAD_ONCE_INIT; /* GLOBAL_T */
 
@@ -86,6 +89,8 @@ static bool GeneratePolicyReleaseID(char *release_id_out, size_t out_size,
 static char* ReadReleaseIdFromReleaseIdFileMasterfiles(const char *maybe_dirname);
 
 static bool MissingInputFile(const char *input_file);
+static Policy *LoadValidatedPolicy(EvalContext *ctx, GenericAgentConfig *config,
+                                   bool force_validation, bool write_validated_file);
 
 bool LoadAugmentsFiles(EvalContext *ctx, const char* filename);
 
@@ -148,20 +153,21 @@ void MarkAsPolicyServer(EvalContext *ctx)
 
 Policy *SelectAndLoadPolicy(GenericAgentConfig *config, EvalContext *ctx, bool validate_policy, bool write_validated_file)
 {
-    Policy *policy = NULL;
+    Policy *policy = LoadValidatedPolicy(ctx, config, validate_policy, write_validated_file);
 
-    if (GenericAgentCheckPolicy(config, validate_policy, write_validated_file))
+    if (policy != NULL)
     {
-        policy = LoadPolicy(ctx, config);
+        return policy;
     }
-    else if (config->tty_interactive)
+
+    if (config->tty_interactive)
     {
         Log(LOG_LEVEL_ERR,
                "Failsafe condition triggered. Interactive session detected, skipping failsafe.cf execution.");
     }
     else
     {
-        Log(LOG_LEVEL_ERR, "CFEngine was not able to get confirmation of promises from cf-promises, so going to failsafe");
+        Log(LOG_LEVEL_ERR, "CFEngine was not able to validate the policy, so going to failsafe");
         EvalContextClassPutHard(ctx, "failsafe_fallback", "attribute_name=Errors,source=agent");
 
         if (CheckAndGenerateFailsafe(GetInputDir(), "failsafe.cf"))
@@ -615,46 +621,62 @@ static bool IsPolicyPrecheckNeeded(GenericAgentConfig *config, bool force_valida
     return check_policy;
 }
 
-bool GenericAgentCheckPolicy(GenericAgentConfig *config, bool force_validation, bool write_validated_file)
+/**
+ * Load the policy, validating it first if needed. Validation happens
+ * in-process while loading, so that the policy is only parsed once: like
+ * cf-promises it is checked for all agent types, and rejected instead of
+ * exiting on errors.
+ *
+ * @return The policy, or NULL if it's missing or not valid.
+ */
+static Policy *LoadValidatedPolicy(EvalContext *ctx, GenericAgentConfig *config,
+                                   bool force_validation, bool write_validated_file)
 {
-    if (!MissingInputFile(config->input_file))
+    if (MissingInputFile(config->input_file))
     {
-        {
-            if (config->agent_type == AGENT_TYPE_SERVER ||
-                config->agent_type == AGENT_TYPE_MONITOR ||
-                config->agent_type == AGENT_TYPE_EXECUTOR)
-            {
-                time_t validated_at = ReadTimestampFromPolicyValidatedFile(config, NULL);
-                config->agent_specific.daemon.last_validated_at = validated_at;
-            }
-        }
+        return NULL;
+    }
 
-        if (IsPolicyPrecheckNeeded(config, force_validation))
-        {
-            bool policy_check_ok = GenericAgentArePromisesValid(config);
-            if (policy_check_ok && write_validated_file)
-            {
-                GenericAgentTagReleaseDirectory(config,
-                                                NULL, // use GetAutotagDir
-                                                write_validated_file, // true
-                                                GetAmPolicyHub()); // write release ID?
-            }
+    if (config->agent_type == AGENT_TYPE_SERVER ||
+        config->agent_type == AGENT_TYPE_MONITOR ||
+        config->agent_type == AGENT_TYPE_EXECUTOR)
+    {
+        time_t validated_at = ReadTimestampFromPolicyValidatedFile(config, NULL);
+        config->agent_specific.daemon.last_validated_at = validated_at;
+    }
 
-            if (config->agent_specific.agent.bootstrap_argument && !policy_check_ok)
-            {
-                Log(LOG_LEVEL_VERBOSE, "Policy is not valid, but proceeding with bootstrap");
-                return true;
-            }
+    if (!IsPolicyPrecheckNeeded(config, force_validation))
+    {
+        Log(LOG_LEVEL_VERBOSE, "Policy is already validated");
+        return LoadPolicy(ctx, config);
+    }
 
-            return policy_check_ok;
-        }
-        else
+    Log(LOG_LEVEL_VERBOSE, "Validating policy while loading it");
+    Policy *policy = LoadPolicyIfValid(ctx, config);
+    if (policy != NULL)
+    {
+        /* The daemons trust cf_promises_validated and skip their own check,
+         * LoadPolicyIfValid() checked the bundles of all of them. */
+        if (write_validated_file)
         {
-            Log(LOG_LEVEL_VERBOSE, "Policy is already validated");
-            return true;
+            GenericAgentTagReleaseDirectory(config,
+                                            NULL, // use GetAutotagDir
+                                            write_validated_file, // true
+                                            GetAmPolicyHub()); // write release ID?
         }
+        return policy;
     }
-    return false;
+
+    /* Don't let the rejected policy leak into the fallback one. */
+    EvalContextClearPromiseDefinitions(ctx);
+
+    if (config->agent_specific.agent.bootstrap_argument)
+    {
+        Log(LOG_LEVEL_VERBOSE, "Policy is not valid, but proceeding with bootstrap");
+        return LoadPolicy(ctx, config);
+    }
+
+    return NULL;
 }
 
 static JsonElement *ReadPolicyValidatedFile(const char *filename)
@@ -799,6 +821,18 @@ bool GenericAgentTagReleaseDirectory(const GenericAgentConfig *config, const cha
         }
 
         Log(LOG_LEVEL_DEBUG, "The promises_validated file %s was updated", filename);
+
+        if (write_release)
+        {
+            /* Republish the snapshot agents update from, it's not fatal
+             * if this fails since agents can still copy file by file. */
+            char *id = ReadReleaseIdFromReleaseIdFileMasterfiles(dirname);
+            if (id != NULL)
+            {
+                PolicySnapshotWrite(dirname, id);
+                free(id);
+            }
+        }
         return true;
     }
 
@@ -1116,6 +1150,8 @@ void GenericAgentInitialize(EvalContext *ctx, GenericAgentConfig *config)
 void GenericAgentFinalize(EvalContext *ctx, GenericAgentConfig *config)
 {
     /* TODO, FIXME: what else from the above do we need to undo here ? */
+    RegexCache_LogStats(LOG_LEVEL_VERBOSE);
+    StringIntern_LogStats(LOG_LEVEL_VERBOSE);
     if (config->agent_type != AGENT_TYPE_KEYGEN)
     {
         cfnet_shut();
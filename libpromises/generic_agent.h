@@ -55,6 +55,7 @@ typedef struct
 
     bool check_not_writable_by_others;
     bool check_runnable;
+    bool check_all_agent_types; /* parse and check all bundles, see LoadPolicyIfValid() */
 
     StringSet *heap_soft;
     StringSet *heap_negated;
@@ -106,7 +107,6 @@ ENTERPRISE_VOID_FUNC_2ARG_DECLARE(void, GenericAgentSetDefaultDigest, HashMethod
 const char *GenericAgentResolveInputPath(const GenericAgentConfig *config, const char *input_file);
 void MarkAsPolicyServer(EvalContext *ctx);
 void GenericAgentDiscoverContext(EvalContext *ctx, GenericAgentConfig *config);
-bool GenericAgentCheckPolicy(GenericAgentConfig *config, bool force_validation, bool write_validated_file);
 
 ENTERPRISE_VOID_FUNC_1ARG_DECLARE(void, GenericAgentAddEditionClasses, EvalContext *, ctx);
 void GenericAgentInitialize(EvalContext *ctx, GenericAgentConfig *config);
@@ -139,6 +139,44 @@ int EndMeasureValueMs(struct timespec start)
 
 /***************************************************************/
 
+/**
+ * @brief Look up the running average of all measurements of #eventname,
+ *        see EndMeasure().
+ * @return false if #eventname was never measured.
+ */
+bool GetMeasuredAverage(const char *eventname, double *average)
+{
+    CF_DB *dbp;
+    Event e;
+
+    if (!OpenDB(&dbp, dbid_performance))
+    {
+        return false;
+    }
+
+    bool found = ReadDB(dbp, eventname, &e, sizeof(e));
+    CloseDB(dbp);
+
+    if (found)
+    {
+        *average = e.Q.expect;
+    }
+    return found;
+}
+
+/***************************************************************/
+
+/**
+ * @brief Record #seconds as a measurement of #eventname, for events that
+ *        failed and have no elapsed time to record with EndMeasure().
+ */
+void NoteMeasurement(char *eventname, double seconds)
+{
+    NotePerformance(eventname, time(NULL), seconds);
+}
+
+/***************************************************************/
+
 static void NotePerformance(char *eventname, time_t t, double value)
 {
     CF_DB *dbp;
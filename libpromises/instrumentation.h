@@ -33,6 +33,8 @@
 struct timespec BeginMeasure(void);
 void EndMeasure(char *eventname, struct timespec start);
 int EndMeasureValueMs(struct timespec start);
+bool GetMeasuredAverage(const char *eventname, double *average);
+void NoteMeasurement(char *eventname, double seconds);
 void EndMeasurePromise(struct timespec start, const Promise *pp);
 extern bool TIMING;
 #endif
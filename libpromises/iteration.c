@@ -34,6 +34,7 @@
 #include <assoc.h>
 #include <expand.h>                                   /* ExpandScalar */
 #include <conversion.h>                               /* DataTypeIsIterable */
+#include <syntax.h>                                   /* ExpectedDataType */
 
 
 
@@ -132,13 +133,51 @@ typedef struct {
 
     size_t iter_index;                           /* current iteration index */
 
+    /* Incremented every time "values" are looked up again. */
+    unsigned long values_generation;
+
 } Wheel;
 
 
+/**
+ * CONSTRAINT MEMOS
+ *
+ * Most constraints of a promise don't change from one iteration to the
+ * next: they are constants, or they only reference a few of the wheels.
+ * For every constraint of the promise that contains no function calls and
+ * whose variables are all wheels, the expanded value of the last iteration
+ * is kept together with the positions of the wheels it depends on. As long
+ * as none of them moved, ExpandDeRefPromise() copies it instead of
+ * expanding the constraint again.
+ *
+ * Constraints referencing any other variable are always expanded, since
+ * the promise itself may change them (e.g. vars promises).
+ */
+typedef struct {
+    bool memoizable;
+
+    size_t *wheels;             /* indexes of the wheels it depends on */
+    size_t num_wheels;
+
+    bool valid;
+    Rval value;                 /* expanded value, owned */
+    size_t *iter_indices;       /* wheel positions it was expanded with */
+    unsigned long *generations; /* and values_generation of the wheels */
+} ConstraintMemo;
+
+typedef struct {
+    ConstraintMemo *memos;                  /* one for each constraint */
+    size_t num_memos;
+} ConstraintMemos;
+
 struct PromiseIterator_ {
     Seq *wheels;
     const Promise *pp;                                   /* not owned by us */
     size_t count;                                 /* total iterations count */
+
+    /* Filled in while iterating, through a pointer because the expanded
+     * promise only gets a const PromiseIterator. */
+    ConstraintMemos *memos;
 };
 
 
@@ -153,7 +192,8 @@ static Wheel *WheelNew(const char *varname, size_t varname_len)
         .varname_exp   = NULL,
         .values        = NULL,
         .vartype       = -1,
-        .iter_index    = 0
+        .iter_index    = 0,
+        .values_generation = 0
     };
 
     return xmemdup(&new_wheel, sizeof(new_wheel));
@@ -203,13 +243,34 @@ PromiseIterator *PromiseIteratorNew(const Promise *pp)
     PromiseIterator iterctx = {
         .wheels = SeqNew(4, WheelDestroy),
         .pp     = pp,
-        .count  = 0
+        .count  = 0,
+        .memos  = xcalloc(1, sizeof(ConstraintMemos))
     };
     return xmemdup(&iterctx, sizeof(iterctx));
 }
 
+static void ConstraintMemoClear(ConstraintMemo *memo)
+{
+    if (memo->valid)
+    {
+        RvalDestroy(memo->value);
+        memo->valid = false;
+    }
+}
+
 void PromiseIteratorDestroy(PromiseIterator *iterctx)
 {
+    for (size_t i = 0; i < iterctx->memos->num_memos; i++)
+    {
+        ConstraintMemo *memo = &iterctx->memos->memos[i];
+        ConstraintMemoClear(memo);
+        free(memo->wheels);
+        free(memo->iter_indices);
+        free(memo->generations);
+    }
+    free(iterctx->memos->memos);
+    free(iterctx->memos);
+
     SeqDestroy(iterctx->wheels);
     free(iterctx);
 }
@@ -758,6 +819,7 @@ static void ExpandAndPutWheelVariablesAfter(
             wheel->varname_exp = xstrdup(varname);
 
             WheelValuesSeqDestroy(wheel);           /* free previous values */
+            wheel->values_generation++;
 
             /* After expanding the variable name, we have to lookup its value,
                and set the size of the wheel if it's an slist or container. */
@@ -999,3 +1061,205 @@ bool PromiseIteratorNext(PromiseIterator *iterctx, EvalContext *evalctx)
     iterctx->count++;
     return true;
 }
+
+
+/**
+ * Collect in #deps the wheels referenced by #str.
+ *
+ * @return false if #str references anything that is not a wheel.
+ */
+static bool ScalarWheelDependencies(const PromiseIterator *iterctx,
+                                    const char *str, Seq *deps)
+{
+    if (strstr(str, "@(") != NULL || strstr(str, "@{") != NULL)
+    {
+        return false;                                /* lists dropped in */
+    }
+
+    bool ret = true;
+    Buffer *name = BufferNew();
+    const size_t len = strlen(str);
+
+    for (size_t i = 0; ret && i < len; i++)
+    {
+        BufferClear(name);
+        ExtractScalarPrefix(name, str + i, len - i);
+        i += BufferSize(name);
+        if (i >= len)
+        {
+            break;
+        }
+
+        BufferClear(name);
+        if (!ExtractScalarReference(name, str + i, len - i, true))
+        {
+            ret = false;
+            break;
+        }
+        i += BufferSize(name) + 2;
+
+        ret = false;
+        size_t wheels_num = SeqLength(iterctx->wheels);
+        for (size_t w = 0; w < wheels_num; w++)
+        {
+            const Wheel *wheel = SeqAt(iterctx->wheels, w);
+            if (strcmp(wheel->varname_unexp, BufferData(name)) == 0)
+            {
+                SeqAppend(deps, (void *) (uintptr_t) w);
+                ret = true;
+                break;
+            }
+        }
+    }
+
+    BufferDestroy(name);
+    return ret;
+}
+
+static bool RvalWheelDependencies(const PromiseIterator *iterctx,
+                                  Rval rval, Seq *deps)
+{
+    switch (rval.type)
+    {
+    case RVAL_TYPE_SCALAR:
+        return ScalarWheelDependencies(iterctx, RvalScalarValue(rval), deps);
+
+    case RVAL_TYPE_LIST:
+        for (const Rlist *rp = RvalRlistValue(rval); rp != NULL; rp = rp->next)
+        {
+            if (rp->val.type != RVAL_TYPE_SCALAR ||
+                !ScalarWheelDependencies(iterctx, RlistScalarValue(rp), deps))
+            {
+                return false;
+            }
+        }
+        return true;
+
+    default:
+        return false;                          /* function calls and data */
+    }
+}
+
+static ConstraintMemo *GetConstraintMemo(const PromiseIterator *iterctx,
+                                         size_t constraint_idx)
+{
+    ConstraintMemos *memos = iterctx->memos;
+    const Seq *conlist = iterctx->pp->conlist;
+
+    if (memos->memos == NULL)
+    {
+        memos->num_memos = SeqLength(conlist);
+        memos->memos = xcalloc(memos->num_memos, sizeof(ConstraintMemo));
+
+        for (size_t i = 0; i < memos->num_memos; i++)
+        {
+            const Constraint *cp = SeqAt(conlist, i);
+            ConstraintMemo *memo = &memos->memos[i];
+
+            if (ExpectedDataType(cp->lval) == CF_DATA_TYPE_BUNDLE)
+            {
+                continue;
+            }
+
+            Seq *deps = SeqNew(4, NULL);
+            memo->memoizable = RvalWheelDependencies(iterctx, cp->rval, deps);
+            if (memo->memoizable)
+            {
+                memo->num_wheels   = SeqLength(deps);
+                memo->wheels       = xcalloc(memo->num_wheels + 1, sizeof(size_t));
+                memo->iter_indices = xcalloc(memo->num_wheels + 1, sizeof(size_t));
+                memo->generations  = xcalloc(memo->num_wheels + 1, sizeof(unsigned long));
+                for (size_t d = 0; d < memo->num_wheels; d++)
+                {
+                    memo->wheels[d] = (uintptr_t) SeqAt(deps, d);
+                }
+            }
+            SeqDestroy(deps);
+        }
+    }
+
+    assert(constraint_idx < memos->num_memos);
+    return &memos->memos[constraint_idx];
+}
+
+/* Only wheels iterating over values have a known value at each position. */
+static bool WheelHasValues(const Wheel *wheel)
+{
+    return (wheel->values != NULL &&
+            wheel->iter_index < SeqLength(wheel->values));
+}
+
+/**
+ * @brief Get the expanded value of constraint #constraint_idx of the
+ *        iterated promise, if it's known to be the same as in a previous
+ *        iteration.
+ * @param #rval_out set to a copy of the value, owned by the caller.
+ * @return false if the constraint has to be expanded again.
+ */
+bool PromiseIteratorConstraintValue(const PromiseIterator *iterctx,
+                                    size_t constraint_idx, Rval *rval_out)
+{
+    if (iterctx == NULL)
+    {
+        return false;
+    }
+
+    const ConstraintMemo *memo = GetConstraintMemo(iterctx, constraint_idx);
+    if (!memo->memoizable || !memo->valid)
+    {
+        return false;
+    }
+
+    for (size_t d = 0; d < memo->num_wheels; d++)
+    {
+        const Wheel *wheel = SeqAt(iterctx->wheels, memo->wheels[d]);
+        if (!WheelHasValues(wheel) ||
+            wheel->iter_index != memo->iter_indices[d] ||
+            wheel->values_generation != memo->generations[d])
+        {
+            return false;
+        }
+    }
+
+    *rval_out = RvalCopy(memo->value);
+    return true;
+}
+
+/**
+ * Remember #rval, the expanded value of constraint #constraint_idx in the
+ * current iteration, for PromiseIteratorConstraintValue().
+ */
+void PromiseIteratorConstraintSetValue(const PromiseIterator *iterctx,
+                                       size_t constraint_idx, Rval rval)
+{
+    if (iterctx == NULL)
+    {
+        return;
+    }
+
+    ConstraintMemo *memo = GetConstraintMemo(iterctx, constraint_idx);
+    if (!memo->memoizable)
+    {
+        return;
+    }
+
+    ConstraintMemoClear(memo);
+
+    for (size_t d = 0; d < memo->num_wheels; d++)
+    {
+        const Wheel *wheel = SeqAt(iterctx->wheels, memo->wheels[d]);
+        if (!WheelHasValues(wheel))
+        {
+            return;                              /* no value to compare */
+        }
+    }
+
+    for (size_t d = 0; d < memo->num_wheels; d++)
+    {
+        const Wheel *wheel = SeqAt(iterctx->wheels, memo->wheels[d]);
+        memo->iter_indices[d] = wheel->iter_index;
+        memo->generations[d]  = wheel->values_generation;
+    }
+    memo->value = RvalCopy(rval);
+    memo->valid = true;
+}
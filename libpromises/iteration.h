@@ -41,5 +41,10 @@ bool PromiseIteratorNext(PromiseIterator *iterctx,
                          EvalContext *evalctx);
 size_t PromiseIteratorIndex(const PromiseIterator *iter_ctx);
 
+bool PromiseIteratorConstraintValue(const PromiseIterator *iterctx,
+                                    size_t constraint_idx, Rval *rval_out);
+void PromiseIteratorConstraintSetValue(const PromiseIterator *iterctx,
+                                       size_t constraint_idx, Rval rval);
+
 
 #endif
@@ -60,6 +60,17 @@ void UpdateLastSawHost(const char *hostkey, const char *address,
  * key: a<address> (IPv6 or IPv6)
  * value: <hostkey>
  *
+ * "Time" entries (auxiliary), one per "quality of connection" entry
+ *
+ * key: t<lastseen><direction><hostkey> (lastseen: 16 hex digits)
+ * value: ""
+ *
+ * Time entries sort by lastseen, so that "hosts seen since X" only needs to
+ * walk the entries after "t<X>" on databases with ordered keys. They are
+ * only written with LMDB, hash databases (TC, QDBM) scan everything anyway.
+ * The "timeindex" key is written once the time entries have been generated
+ * for all quality entries, databases written by older versions lack them.
+ *
  *
  *
  * Schema version 0 mapped direction + hostkey to address + quality of
@@ -106,6 +117,87 @@ void LastSaw(const char *ipaddress, const char *digest, LastSeenRole role)
 
 /*****************************************************************************/
 
+#define TIME_INDEX_KEY "timeindex"
+
+static void TimeIndexKey(char *dst, size_t dst_size, time_t lastseen,
+                         char direction, const char *hostkey)
+{
+    snprintf(dst, dst_size, "t%016jx%c%s",
+             (uintmax_t) lastseen, direction, hostkey);
+}
+
+/**
+ * @brief Parse a time index key, #hostkey points inside #key.
+ */
+static bool ParseTimeIndexKey(const char *key, time_t *lastseen,
+                              char *direction, const char **hostkey)
+{
+    if (key[0] != 't' || strlen(key) < 1 + 16 + 1 + 1)
+    {
+        return false;
+    }
+
+    uintmax_t t = 0;
+    for (int i = 1; i <= 16; i++)
+    {
+        int digit;
+        if (key[i] >= '0' && key[i] <= '9')
+        {
+            digit = key[i] - '0';
+        }
+        else if (key[i] >= 'a' && key[i] <= 'f')
+        {
+            digit = key[i] - 'a' + 10;
+        }
+        else
+        {
+            return false;
+        }
+        t = (t << 4) | digit;
+    }
+
+    if (key[17] != 'i' && key[17] != 'o')
+    {
+        return false;
+    }
+
+    *lastseen = (time_t) t;
+    *direction = key[17];
+    *hostkey = key + 18;
+    return true;
+}
+
+/* Remove quality entry for #hostkey in #direction, with its time entry. */
+static void DeleteQualityEntry(DBHandle *db, char direction,
+                               const char *hostkey)
+{
+    char quality_key[CF_BUFSIZE];
+    snprintf(quality_key, CF_BUFSIZE, "q%c%s", direction, hostkey);
+
+#ifdef LMDB
+    KeyHostSeen q;
+    if (ReadDB(db, quality_key, &q, sizeof(q)))
+    {
+        char time_key[CF_BUFSIZE];
+        TimeIndexKey(time_key, sizeof(time_key), q.lastseen,
+                     direction, hostkey);
+        DeleteDB(db, time_key);
+    }
+#endif
+
+    DeleteDB(db, quality_key);
+}
+
+/**
+ * @brief Remove both quality-of-connection entries of #hostkey, and their
+ *        time entries, from the open lastseen database #db.
+ */
+void DeleteLastSeenQualityEntries(DBHandle *db, const char *hostkey)
+{
+    DeleteQualityEntry(db, 'i', hostkey);
+    DeleteQualityEntry(db, 'o', hostkey);
+}
+
 void UpdateLastSawHost(const char *hostkey, const char *address,
                        bool incoming, time_t timestamp)
 {
@@ -118,15 +210,28 @@ void UpdateLastSawHost(const char *hostkey, const char *address,
 
     /* Update quality-of-connection entry */
 
+    const char direction = incoming ? 'i' : 'o';
     char quality_key[CF_BUFSIZE];
-    snprintf(quality_key, CF_BUFSIZE, "q%c%s", incoming ? 'i' : 'o', hostkey);
+    snprintf(quality_key, CF_BUFSIZE, "q%c%s", direction, hostkey);
 
     KeyHostSeen newq = { .lastseen = timestamp };
+#ifdef LMDB
+    char time_key[CF_BUFSIZE];
+#endif
 
     KeyHostSeen q;
     if (ReadDB(db, quality_key, &q, sizeof(q)))
     {
         newq.Q = QAverage(q.Q, newq.lastseen - q.lastseen, 0.4);
+
+#ifdef LMDB
+        if (q.lastseen != newq.lastseen)
+        {
+            TimeIndexKey(time_key, sizeof(time_key), q.lastseen,
+                         direction, hostkey);
+            DeleteDB(db, time_key);
+        }
+#endif
     }
     else
     {
@@ -135,6 +240,14 @@ void UpdateLastSawHost(const char *hostkey, const char *address,
     }
     WriteDB(db, quality_key, &newq, sizeof(newq));
 
+#ifdef LMDB
+    /* Update time entry */
+
+    TimeIndexKey(time_key, sizeof(time_key), newq.lastseen,
+                 direction, hostkey);
+    WriteDB(db, time_key, "", 1);
+#endif
+
     /* Update forward mapping */
 
     char hostkey_key[CF_BUFSIZE];
@@ -338,7 +451,8 @@ bool IsLastSeenCoherent(void)
             strncmp(key, "qi", 2) != 0 &&
             strncmp(key, "qo", 2) != 0 &&
             key[0] != 'k' &&
-            key[0] != 'a')
+            key[0] != 'a' &&
+            key[0] != 't')
         {
             Log(LOG_LEVEL_WARNING,
                 "lastseen db inconsistency, unexpected key: %s",
@@ -490,13 +604,7 @@ bool DeleteIpFromLastSeen(const char *ip, char *digest, size_t digest_size)
         goto clean;
     }
 
-    strcpy(bufkey, "qi");
-    strlcat(bufkey, key, CF_BUFSIZE);
-    DeleteDB(db, bufkey);
-
-    strcpy(bufkey, "qo");
-    strlcat(bufkey, key, CF_BUFSIZE);
-    DeleteDB(db, bufkey);
+    DeleteLastSeenQualityEntries(db, key);
 
 clean:
     CloseDB(db);
@@ -557,13 +665,7 @@ bool DeleteDigestFromLastSeen(const char *key, char *ip, size_t ip_size)
         goto clean;
     }
 
-    strcpy(bufkey, "qi");
-    strlcat(bufkey, key, CF_BUFSIZE);
-    DeleteDB(db, bufkey);
-
-    strcpy(bufkey, "qo");
-    strlcat(bufkey, key, CF_BUFSIZE);
-    DeleteDB(db, bufkey);
+    DeleteLastSeenQualityEntries(db, key);
 
 clean:
     CloseDB(db);
@@ -640,6 +742,179 @@ bool ScanLastSeenQuality(LastSeenQualityCallback callback, void *ctx)
 
 /*****************************************************************************/
 
+typedef struct
+{
+    time_t since;
+    LastSeenQualityCallback callback;
+    void *ctx;
+} LastSeenSinceFilter;
+
+static bool LastSeenSinceFilterCallback(const char *hostkey, const char *address,
+                                        bool incoming, const KeyHostSeen *quality,
+                                        void *ctx)
+{
+    LastSeenSinceFilter *filter = ctx;
+    if (quality->lastseen < filter->since)
+    {
+        return true;
+    }
+    return filter->callback(hostkey, address, incoming, quality, filter->ctx);
+}
+
+/* Generate the time entries of a database written by an older version. */
+static bool BuildTimeIndex(DBHandle *db)
+{
+    DBCursor *cursor;
+    if (!NewDBCursor(db, &cursor))
+    {
+        return false;
+    }
+
+    char *key;
+    void *value;
+    int ksize, vsize;
+
+    Seq *time_keys = SeqNew(100, free);
+    while (NextDB(cursor, &key, &ksize, &value, &vsize))
+    {
+        if ((strncmp(key, "qi", 2) == 0 || strncmp(key, "qo", 2) == 0) &&
+            vsize == sizeof(KeyHostSeen))
+        {
+            KeyHostSeen q;
+            memcpy(&q, value, sizeof(q));
+
+            char time_key[CF_BUFSIZE];
+            TimeIndexKey(time_key, sizeof(time_key), q.lastseen,
+                         key[1], key + 2);
+            SeqAppend(time_keys, xstrdup(time_key));
+        }
+    }
+    DeleteDBCursor(cursor);
+
+    bool ok = true;
+    for (size_t i = 0; ok && i < SeqLength(time_keys); i++)
+    {
+        ok = WriteDB(db, SeqAt(time_keys, i), "", 1);
+    }
+    SeqDestroy(time_keys);
+
+    return ok && WriteDB(db, TIME_INDEX_KEY, "1", sizeof("1"));
+}
+
+static bool OpenTimeIndexCursor(DBHandle *db, DBCursor **cursor, time_t since)
+{
+    char start_key[CF_BUFSIZE];
+    snprintf(start_key, sizeof(start_key), "t%016jx",
+             (uintmax_t) MAX(since, 0));
+
+    if (!NewDBCursor(db, cursor))
+    {
+        return false;
+    }
+    if (!DBCursorSeek(*cursor, start_key))
+    {
+        DeleteDBCursor(*cursor);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Same as ScanLastSeenQuality(), but only for connections seen at
+ *        #since or later.
+ *
+ * When the database keeps keys sorted, only the time entries starting from
+ * #since are visited, so the cost is proportional to the number of matching
+ * connections instead of the size of the database.
+ */
+bool ScanLastSeenQualitySince(time_t since, LastSeenQualityCallback callback,
+                              void *ctx)
+{
+    DBHandle *db;
+    if (!OpenDB(&db, dbid_lastseen))
+    {
+        return false;
+    }
+
+    bool indexed = HasKeyDB(db, TIME_INDEX_KEY, sizeof(TIME_INDEX_KEY));
+
+    DBCursor *cursor;
+    bool range_scan = OpenTimeIndexCursor(db, &cursor, since);
+    if (range_scan && !indexed)
+    {
+        DeleteDBCursor(cursor);
+
+        Log(LOG_LEVEL_VERBOSE, "Generating time index of lastseen database");
+        range_scan = BuildTimeIndex(db) &&
+                     OpenTimeIndexCursor(db, &cursor, since);
+    }
+
+    if (!range_scan)
+    {
+        CloseDB(db);
+
+        LastSeenSinceFilter filter = {
+            .since = since,
+            .callback = callback,
+            .ctx = ctx
+        };
+        return ScanLastSeenQuality(LastSeenSinceFilterCallback, &filter);
+    }
+
+    char *key;
+    void *value;
+    int ksize, vsize;
+
+    Seq *time_keys = SeqNew(100, free);
+    while (NextDB(cursor, &key, &ksize, &value, &vsize) && key[0] == 't')
+    {
+        SeqAppend(time_keys, xstrdup(key));
+    }
+    DeleteDBCursor(cursor);
+
+    for (size_t i = 0; i < SeqLength(time_keys); i++)
+    {
+        time_t lastseen;
+        char direction;
+        const char *hostkey;
+        if (!ParseTimeIndexKey(SeqAt(time_keys, i),
+                               &lastseen, &direction, &hostkey))
+        {
+            continue;                                  /* TIME_INDEX_KEY */
+        }
+
+        /* Skip time entries left behind by concurrent updates. */
+        char quality_key[CF_BUFSIZE];
+        snprintf(quality_key, CF_BUFSIZE, "q%c%s", direction, hostkey);
+        KeyHostSeen q;
+        if (!ReadDB(db, quality_key, &q, sizeof(q)) || q.lastseen != lastseen)
+        {
+            continue;
+        }
+
+        char hostkey_key[CF_BUFSIZE];
+        snprintf(hostkey_key, CF_BUFSIZE, "k%s", hostkey);
+        char address[CF_BUFSIZE];
+        if (!ReadDB(db, hostkey_key, address, sizeof(address)))
+        {
+            Log(LOG_LEVEL_ERR, "Failed to read address for key '%s'.", hostkey);
+            continue;
+        }
+
+        if (!(*callback)(hostkey, address, direction == 'i', &q, ctx))
+        {
+            break;
+        }
+    }
+
+    SeqDestroy(time_keys);
+    CloseDB(db);
+
+    return true;
+}
+
+/*****************************************************************************/
+
 int LastSeenHostKeyCount(void)
 {
     CF_DB *dbp;
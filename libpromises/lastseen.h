@@ -25,6 +25,8 @@
 #ifndef CFENGINE_LASTSEEN_H
 #define CFENGINE_LASTSEEN_H
 
+#include <dbm_api.h>
+
 typedef struct
 {
     time_t lastseen;
@@ -45,6 +47,7 @@ void LastSaw(const char *ipaddress, const char *digest, LastSeenRole role);
 
 bool DeleteIpFromLastSeen(const char *ip, char *digest, size_t digest_size);
 bool DeleteDigestFromLastSeen(const char *key, char *ip, size_t ip_size);
+void DeleteLastSeenQualityEntries(DBHandle *db, const char *hostkey);
 
 /*
  * Return false in order to stop iteration
@@ -54,6 +57,8 @@ typedef bool (*LastSeenQualityCallback)(const char *hostkey, const char *address
                                         void *ctx);
 
 bool ScanLastSeenQuality(LastSeenQualityCallback callback, void *ctx);
+bool ScanLastSeenQualitySince(time_t since, LastSeenQualityCallback callback,
+                              void *ctx);
 int LastSeenHostKeyCount(void);
 bool IsLastSeenCoherent(void);
 int RemoveKeysFromLastSeen(const char *input, bool must_be_coherent,
@@ -35,22 +35,45 @@
 #include <fncall.h>
 #include <known_dirs.h>
 #include <ornaments.h>
+#include <policy_cache.h>
+#include <map.h>
 
 // TODO: remove
 #include <vars.h>                                         /* IsCf3VarString */
 #include <audit.h>                                        /* FatalError */
 
 
-static Policy *LoadPolicyFile(EvalContext *ctx, GenericAgentConfig *config, const char *policy_file,
-                              StringSet *parsed_files_and_checksums, StringSet *failed_files);
+/* Upper bound on the number of processes parsing input files at once. */
+#define PARSE_WORKERS_MAX 8
 
+/* An input file parsed ahead of time, before LoadPolicyFile() needs it. */
+typedef struct
+{
+    char digest[CF_HOSTKEY_STRING_SIZE];
+    Policy *policy;
+} ParsedFile;
+
+static Policy *LoadPolicyFile(EvalContext *ctx, GenericAgentConfig *config, const char *policy_file,
+                              StringSet *parsed_files_and_checksums, StringSet *failed_files,
+                              Map *parsed_files, Policy *other_bundles);
 
 
 
 /*
  * The difference between filename and input_input file is that the latter is the file specified by -f or
  * equivalently the file containing body common control. This will hopefully be squashed in later refactoring.
+ *
+ * Returns NULL if the file can't be read or has errors, which have been logged.
  */
+/**
+ * The agent type to parse policy files for: while validating, the bundles of
+ * all agent types are loaded, like cf-promises does.
+ */
+static AgentType ParserAgentType(const GenericAgentConfig *config)
+{
+    return config->check_all_agent_types ? AGENT_TYPE_COMMON : config->agent_type;
+}
+
 Policy *Cf3ParseFile(const GenericAgentConfig *config, const char *input_path)
 {
     struct stat statbuf;
@@ -63,7 +86,7 @@ Policy *Cf3ParseFile(const GenericAgentConfig *config, const char *input_path)
         }
 
         Log(LOG_LEVEL_ERR, "Can't stat file '%s' for parsing. (stat: %s)", input_path, GetErrorStr());
-        exit(EXIT_FAILURE);
+        return NULL;
     }
     else if (S_ISDIR(statbuf.st_mode))
     {
@@ -73,14 +96,14 @@ Policy *Cf3ParseFile(const GenericAgentConfig *config, const char *input_path)
         }
 
         Log(LOG_LEVEL_ERR, "Can't parse directory '%s'.", input_path);
-        exit(EXIT_FAILURE);
+        return NULL;
     }
 
 #ifndef _WIN32
     if (config->check_not_writable_by_others && (statbuf.st_mode & (S_IWGRP | S_IWOTH)))
     {
         Log(LOG_LEVEL_ERR, "File %s (owner %ju) is writable by others (security exception)", input_path, (uintmax_t)statbuf.st_uid);
-        exit(EXIT_FAILURE);
+        return NULL;
     }
 #endif
 
@@ -89,7 +112,7 @@ Policy *Cf3ParseFile(const GenericAgentConfig *config, const char *input_path)
     if (!FileCanOpen(input_path, "r"))
     {
         Log(LOG_LEVEL_ERR, "Can't open file '%s' for parsing", input_path);
-        exit(EXIT_FAILURE);
+        return NULL;
     }
 
     Policy *policy = NULL;
@@ -132,7 +155,7 @@ Policy *Cf3ParseFile(const GenericAgentConfig *config, const char *input_path)
         }
         else
         {
-            policy = ParserParseFile(config->agent_type, input_path, 0, 0);
+            policy = ParserParseFile(ParserAgentType(config), input_path, 0, 0);
         }
     }
 
@@ -140,10 +163,394 @@ Policy *Cf3ParseFile(const GenericAgentConfig *config, const char *input_path)
     return policy;
 }
 
-static Policy *LoadPolicyInputFiles(EvalContext *ctx, GenericAgentConfig *config, const Rlist *inputs, StringSet *parsed_files_and_checksums, StringSet *failed_files)
+/**
+ * Whether the parsed #policy_file may come from, and go to, the policy cache.
+ * JSON policy is not cached, nor is policy parsed with warnings enabled since
+ * the warnings are only issued while parsing. Files failing the permission
+ * check of Cf3ParseFile() are left for it to report.
+ */
+static bool PolicyCacheUsable(const GenericAgentConfig *config, const char *policy_file)
+{
+    if (StringEndsWith(policy_file, ".json"))
+    {
+        return false;
+    }
+
+    if (config->agent_type == AGENT_TYPE_COMMON &&
+        (config->agent_specific.common.parser_warnings != 0 ||
+         config->agent_specific.common.parser_warnings_error != 0))
+    {
+        return false;
+    }
+
+    struct stat statbuf;
+    if (stat(policy_file, &statbuf) == -1 || !S_ISREG(statbuf.st_mode))
+    {
+        return false;
+    }
+
+#ifndef _WIN32
+    if (config->check_not_writable_by_others && (statbuf.st_mode & (S_IWGRP | S_IWOTH)))
+    {
+        return false;
+    }
+#endif
+
+    return true;
+}
+
+static void HashPolicyFile(const char *policy_file, char hashbuffer[CF_HOSTKEY_STRING_SIZE])
+{
+    unsigned char digest[EVP_MAX_MD_SIZE + 1] = { 0 };
+
+    HashFile(policy_file, digest, CF_DEFAULT_DIGEST);
+    HashPrintSafe(hashbuffer, CF_HOSTKEY_STRING_SIZE, digest, CF_DEFAULT_DIGEST, true);
+}
+
+/**
+ * Parse and check a single policy file, going through the policy cache.
+ *
+ * @return The policy, or NULL if it has errors, which have been reported.
+ */
+static Policy *ParseAndCheckPolicyFile(const GenericAgentConfig *config, const char *policy_file,
+                                       const char *hashbuffer)
+{
+    bool use_cache = PolicyCacheUsable(config, policy_file);
+    if (use_cache)
+    {
+        Policy *policy = PolicyCacheLoad(policy_file, hashbuffer, ParserAgentType(config));
+        if (policy)
+        {
+            Log(LOG_LEVEL_VERBOSE, "Loaded policy file %s from cache", policy_file);
+            return policy;
+        }
+    }
+
+    Policy *policy = Cf3ParseFile(config, policy_file);
+    if (!policy)
+    {
+        return NULL;
+    }
+
+    Seq *errors = SeqNew(10, free);
+    if (!PolicyCheckPartial(policy, errors))
+    {
+        Writer *writer = FileWriter(stderr);
+        for (size_t i = 0; i < errors->length; i++)
+        {
+            PolicyErrorWrite(writer, errors->data[i]);
+        }
+        WriterClose(writer);
+        SeqDestroy(errors);
+
+        PolicyDestroy(policy);
+        return NULL;
+    }
+
+    SeqDestroy(errors);
+
+    if (use_cache)
+    {
+        /* #hashbuffer was computed before parsing, which reads the file
+         * again: don't store what was parsed under the digest of a
+         * different content. */
+        char parsed_hash[CF_HOSTKEY_STRING_SIZE] = { 0 };
+        HashPolicyFile(policy_file, parsed_hash);
+        if (strcmp(parsed_hash, hashbuffer) == 0)
+        {
+            PolicyCacheStore(policy, hashbuffer, ParserAgentType(config));
+        }
+        else
+        {
+            Log(LOG_LEVEL_VERBOSE,
+                "Policy file %s changed while it was parsed, not caching it",
+                policy_file);
+        }
+    }
+
+    return policy;
+}
+
+static void ParsedFileDestroy(void *p)
+{
+    ParsedFile *parsed = p;
+    if (parsed)
+    {
+        PolicyDestroy(parsed->policy);
+        free(parsed);
+    }
+}
+
+#ifndef __MINGW32__
+
+/*
+ * Input files are parsed in parallel by child processes rather than threads:
+ * the parser, the string intern table and the regex cache all keep global
+ * state. Each child writes the digest and the serialized policy to a
+ * temporary file, which the parent reads back once all children are done.
+ * LoadPolicyFile() then consumes the results in input order, so the merged
+ * policy does not depend on which child finished first. A file a child
+ * failed on is parsed again by the parent, which reports the errors.
+ */
+
+typedef struct
+{
+    const char *path;
+    pid_t pid;
+    FILE *result;
+    bool ok;
+} ParseJob;
+
+static size_t ParseWorkersCount(const GenericAgentConfig *config)
+{
+    /* Other agents may have started threads by the time they load policy. */
+    if (config->agent_type != AGENT_TYPE_AGENT &&
+        config->agent_type != AGENT_TYPE_COMMON)
+    {
+        return 1;
+    }
+
+    /* Parser warnings are only issued while parsing, in the foreground. */
+    if (config->agent_type == AGENT_TYPE_COMMON &&
+        (config->agent_specific.common.parser_warnings != 0 ||
+         config->agent_specific.common.parser_warnings_error != 0))
+    {
+        return 1;
+    }
+
+#ifdef _SC_NPROCESSORS_ONLN
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    if (cpus > 1)
+    {
+        return MIN((size_t) cpus, PARSE_WORKERS_MAX);
+    }
+#endif
+
+    return 1;
+}
+
+static int ParseJobRunChild(const GenericAgentConfig *config, const char *policy_file, int fd)
+{
+    /* Errors are reported when the parent parses the file again. */
+    LogSetGlobalLevel(LOG_LEVEL_NOTHING);
+    int devnull = open("/dev/null", O_WRONLY);
+    if (devnull != -1)
+    {
+        dup2(devnull, STDOUT_FILENO);
+        dup2(devnull, STDERR_FILENO);
+        close(devnull);
+    }
+
+    char hashbuffer[CF_HOSTKEY_STRING_SIZE] = { 0 };
+    HashPolicyFile(policy_file, hashbuffer);
+
+    Policy *policy = ParseAndCheckPolicyFile(config, policy_file, hashbuffer);
+    if (!policy)
+    {
+        return EXIT_FAILURE;
+    }
+
+    /* The serialized policy takes its source path from the file, which JSON
+     * policy does not have to agree with. */
+    for (size_t i = 0; i < SeqLength(policy->bundles); i++)
+    {
+        const Bundle *bp = SeqAt(policy->bundles, i);
+        if (!StringSafeEqual(bp->source_path, policy_file))
+        {
+            return EXIT_FAILURE;
+        }
+    }
+    for (size_t i = 0; i < SeqLength(policy->bodies); i++)
+    {
+        const Body *bp = SeqAt(policy->bodies, i);
+        if (!StringSafeEqual(bp->source_path, policy_file))
+        {
+            return EXIT_FAILURE;
+        }
+    }
+
+    Buffer *data = BufferNew();
+    PolicyCacheSerialize(policy, data);
+
+    if (FullWrite(fd, hashbuffer, sizeof(hashbuffer)) != sizeof(hashbuffer) ||
+        FullWrite(fd, BufferData(data), BufferSize(data)) != (ssize_t) BufferSize(data))
+    {
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+static void ParseJobStart(const GenericAgentConfig *config, ParseJob *job, const char *policy_file)
+{
+    job->path = policy_file;
+    job->pid = -1;
+    job->ok = false;
+
+    job->result = tmpfile();
+    if (job->result == NULL)
+    {
+        Log(LOG_LEVEL_VERBOSE, "Could not create a temporary file to parse '%s' (tmpfile: %s)",
+            policy_file, GetErrorStr());
+        return;
+    }
+
+    job->pid = fork();
+    if (job->pid == 0)
+    {
+        /* Skip atexit() handlers and stdio buffers belonging to the parent. */
+        _exit(ParseJobRunChild(config, policy_file, fileno(job->result)));
+    }
+    else if (job->pid == -1)
+    {
+        Log(LOG_LEVEL_VERBOSE, "Could not fork to parse '%s' (fork: %s)",
+            policy_file, GetErrorStr());
+    }
+}
+
+static void ParseJobWait(ParseJob *job)
+{
+    if (job->pid <= 0)
+    {
+        return;
+    }
+
+    int status;
+    pid_t ret;
+    while ((ret = waitpid(job->pid, &status, 0)) == -1 && errno == EINTR)
+    {
+        // Retry
+    }
+
+    job->ok = (ret == job->pid && WIFEXITED(status) && WEXITSTATUS(status) == EXIT_SUCCESS);
+}
+
+static void ParseJobCollect(ParseJob *job, Map *parsed_files)
+{
+    if (job->result == NULL)
+    {
+        return;
+    }
+
+    int fd = fileno(job->result);
+    struct stat sb;
+    if (job->ok && fstat(fd, &sb) == 0 && sb.st_size > CF_HOSTKEY_STRING_SIZE &&
+        lseek(fd, 0, SEEK_SET) == 0)
+    {
+        char *data = xmalloc(sb.st_size);
+        if (FullRead(fd, data, sb.st_size) == sb.st_size &&
+            data[CF_HOSTKEY_STRING_SIZE - 1] == '\0')
+        {
+            Policy *policy = PolicyCacheDeserialize(data + CF_HOSTKEY_STRING_SIZE,
+                                                    sb.st_size - CF_HOSTKEY_STRING_SIZE,
+                                                    job->path);
+            if (policy)
+            {
+                ParsedFile *parsed = xcalloc(1, sizeof(ParsedFile));
+                strlcpy(parsed->digest, data, sizeof(parsed->digest));
+                parsed->policy = policy;
+                MapInsert(parsed_files, xstrdup(job->path), parsed);
+            }
+        }
+        free(data);
+    }
+
+    fclose(job->result);
+}
+
+static void ParsePolicyFilesInParallel(const GenericAgentConfig *config, const Seq *paths,
+                                       Map *parsed_files)
+{
+    size_t length = SeqLength(paths);
+    size_t workers = ParseWorkersCount(config);
+    if (workers < 2 || length < 2)
+    {
+        return;
+    }
+
+    Log(LOG_LEVEL_VERBOSE, "Parsing %zu policy files in up to %zu processes", length, workers);
+
+    ParseJob *jobs = xcalloc(length, sizeof(ParseJob));
+    size_t oldest = 0;
+    for (size_t i = 0; i < length; i++)
+    {
+        if (i - oldest >= workers)
+        {
+            ParseJobWait(&jobs[oldest]);
+            oldest++;
+        }
+        ParseJobStart(config, &jobs[i], SeqAt(paths, i));
+    }
+
+    for (; oldest < length; oldest++)
+    {
+        ParseJobWait(&jobs[oldest]);
+    }
+
+    for (size_t i = 0; i < length; i++)
+    {
+        ParseJobCollect(&jobs[i], parsed_files);
+    }
+
+    free(jobs);
+}
+
+/**
+ * Resolve the #inputs as far as currently possible and append the files
+ * which have not been loaded yet to #paths. Inputs depending on policy which
+ * is not loaded yet may resolve differently later, which only costs a wasted
+ * parse.
+ */
+static void CollectInputFiles(EvalContext *ctx, const GenericAgentConfig *config, const Policy *policy,
+                              const Rlist *inputs, const StringSet *parsed_files_and_checksums,
+                              Map *parsed_files, Seq *paths)
+{
+    for (const Rlist *rp = inputs; rp; rp = rp->next)
+    {
+        if (rp->val.type != RVAL_TYPE_SCALAR)
+        {
+            continue;
+        }
+
+        Rval resolved_input = EvaluateFinalRval(ctx, policy, NULL, "sys", rp->val, true, NULL);
+
+        if (resolved_input.type == RVAL_TYPE_SCALAR &&
+            !IsCf3VarString(RvalScalarValue(resolved_input)))
+        {
+            const char *path = GenericAgentResolveInputPath(config, RvalScalarValue(resolved_input));
+            if (!StringSetContains(parsed_files_and_checksums, path) &&
+                !MapHasKey(parsed_files, path) &&
+                SeqLookup(paths, path, (SeqItemComparator) strcmp) == NULL)
+            {
+                SeqAppend(paths, xstrdup(path));
+            }
+        }
+        else if (resolved_input.type == RVAL_TYPE_LIST)
+        {
+            CollectInputFiles(ctx, config, policy, RvalRlistValue(resolved_input),
+                              parsed_files_and_checksums, parsed_files, paths);
+        }
+
+        RvalDestroy(resolved_input);
+    }
+}
+
+#endif /* !__MINGW32__ */
+
+static Policy *LoadPolicyInputFiles(EvalContext *ctx, GenericAgentConfig *config, const Rlist *inputs, StringSet *parsed_files_and_checksums, StringSet *failed_files, Map *parsed_files, Policy *other_bundles)
 {
     Policy *policy = PolicyNew();
 
+#ifndef __MINGW32__
+    if (ParseWorkersCount(config) > 1)
+    {
+        Seq *paths = SeqNew(10, free);
+        CollectInputFiles(ctx, config, policy, inputs, parsed_files_and_checksums, parsed_files, paths);
+        ParsePolicyFilesInParallel(config, paths, parsed_files);
+        SeqDestroy(paths);
+    }
+#endif
+
     for (const Rlist *rp = inputs; rp; rp = rp->next)
     {
         if (rp->val.type != RVAL_TYPE_SCALAR)
@@ -170,11 +577,11 @@ static Policy *LoadPolicyInputFiles(EvalContext *ctx, GenericAgentConfig *config
                 break;
             }
 
-            aux_policy = LoadPolicyFile(ctx, config, GenericAgentResolveInputPath(config, RvalScalarValue(resolved_input)), parsed_files_and_checksums, failed_files);
+            aux_policy = LoadPolicyFile(ctx, config, GenericAgentResolveInputPath(config, RvalScalarValue(resolved_input)), parsed_files_and_checksums, failed_files, parsed_files, other_bundles);
             break;
 
         case RVAL_TYPE_LIST:
-            aux_policy = LoadPolicyInputFiles(ctx, config, RvalRlistValue(resolved_input), parsed_files_and_checksums, failed_files);
+            aux_policy = LoadPolicyInputFiles(ctx, config, RvalRlistValue(resolved_input), parsed_files_and_checksums, failed_files, parsed_files, other_bundles);
             break;
 
         default:
@@ -204,13 +611,14 @@ static void ShowContext(EvalContext *ctx)
         Class *cls = NULL;
         while ((cls = ClassTableIteratorNext(iter)))
         {
+            /* The sequences don't own or modify the interned names. */
             if (cls->is_soft)
             {
-                SeqAppend(soft_contexts, cls->name);
+                SeqAppend(soft_contexts, (char *) cls->name);
             }
             else
             {
-                SeqAppend(hard_contexts, cls->name);
+                SeqAppend(hard_contexts, (char *) cls->name);
             }
         }
 
@@ -253,16 +661,23 @@ static void ShowContext(EvalContext *ctx)
     SeqDestroy(soft_contexts);
 }
 
-static Policy *LoadPolicyFile(EvalContext *ctx, GenericAgentConfig *config, const char *policy_file, StringSet *parsed_files_and_checksums, StringSet *failed_files)
+static Policy *LoadPolicyFile(EvalContext *ctx, GenericAgentConfig *config, const char *policy_file,
+                              StringSet *parsed_files_and_checksums, StringSet *failed_files,
+                              Map *parsed_files, Policy *other_bundles)
 {
-    unsigned char digest[EVP_MAX_MD_SIZE + 1] = { 0 };
     char hashbuffer[CF_HOSTKEY_STRING_SIZE] = { 0 };
     char hashprintbuffer[CF_BUFSIZE] = { 0 };
 
-    HashFile(policy_file, digest, CF_DEFAULT_DIGEST);
-    snprintf(hashprintbuffer, CF_BUFSIZE - 1, "{checksum}%s",
-             HashPrintSafe(hashbuffer, sizeof(hashbuffer), digest,
-                           CF_DEFAULT_DIGEST, true));
+    ParsedFile *parsed = MapGet(parsed_files, policy_file);
+    if (parsed != NULL)
+    {
+        strlcpy(hashbuffer, parsed->digest, sizeof(hashbuffer));
+    }
+    else
+    {
+        HashPolicyFile(policy_file, hashbuffer);
+    }
+    snprintf(hashprintbuffer, CF_BUFSIZE - 1, "{checksum}%s", hashbuffer);
 
     Log(LOG_LEVEL_DEBUG, "Hashed policy file %s to %s", policy_file, hashprintbuffer);
 
@@ -281,32 +696,28 @@ static Policy *LoadPolicyFile(EvalContext *ctx, GenericAgentConfig *config, cons
         Log(LOG_LEVEL_DEBUG, "Loading policy file %s", policy_file);
     }
 
-    Policy *policy = Cf3ParseFile(config, policy_file);
+    Policy *policy = NULL;
+    if (parsed != NULL)
+    {
+        Log(LOG_LEVEL_VERBOSE, "Loaded policy file %s parsed in parallel", policy_file);
+        policy = parsed->policy;
+        parsed->policy = NULL;
+    }
+    else
+    {
+        policy = ParseAndCheckPolicyFile(config, policy_file, hashbuffer);
+    }
+
+    /* Set aside before anything is resolved, at most they are checked. */
+    if (policy != NULL)
+    {
+        PolicyMoveBundlesOfOtherAgents(policy, config->agent_type, other_bundles);
+    }
     // we keep the checksum and the policy file name to help debugging
     StringSetAdd(parsed_files_and_checksums, xstrdup(policy_file));
     StringSetAdd(parsed_files_and_checksums, xstrdup(hashprintbuffer));
 
-    if (policy)
-    {
-        Seq *errors = SeqNew(10, free);
-        if (!PolicyCheckPartial(policy, errors))
-        {
-            Writer *writer = FileWriter(stderr);
-            for (size_t i = 0; i < errors->length; i++)
-            {
-                PolicyErrorWrite(writer, errors->data[i]);
-            }
-            WriterClose(writer);
-            SeqDestroy(errors);
-
-            StringSetAdd(failed_files, xstrdup(policy_file));
-            PolicyDestroy(policy);
-            return NULL;
-        }
-
-        SeqDestroy(errors);
-    }
-    else
+    if (policy == NULL)
     {
         StringSetAdd(failed_files, xstrdup(policy_file));
         return NULL;
@@ -325,7 +736,7 @@ static Policy *LoadPolicyFile(EvalContext *ctx, GenericAgentConfig *config, cons
 
         if (cp)
         {
-            Policy *aux_policy = LoadPolicyInputFiles(ctx, config, RvalRlistValue(cp->rval), parsed_files_and_checksums, failed_files);
+            Policy *aux_policy = LoadPolicyInputFiles(ctx, config, RvalRlistValue(cp->rval), parsed_files_and_checksums, failed_files, parsed_files, other_bundles);
             if (aux_policy)
             {
                 policy = PolicyMerge(policy, aux_policy);
@@ -341,7 +752,7 @@ static Policy *LoadPolicyFile(EvalContext *ctx, GenericAgentConfig *config, cons
 
         if (cp)
         {
-            Policy *aux_policy = LoadPolicyInputFiles(ctx, config, RvalRlistValue(cp->rval), parsed_files_and_checksums, failed_files);
+            Policy *aux_policy = LoadPolicyInputFiles(ctx, config, RvalRlistValue(cp->rval), parsed_files_and_checksums, failed_files, parsed_files, other_bundles);
             if (aux_policy)
             {
                 policy = PolicyMerge(policy, aux_policy);
@@ -428,24 +839,52 @@ static JsonElement *ReadReleaseIdFileFromInputs()
     return validated_doc;
 }
 
-Policy *LoadPolicy(EvalContext *ctx, GenericAgentConfig *config)
+/**
+ * @param exit_on_error Exit if the policy has errors, otherwise return NULL.
+ */
+static Policy *LoadPolicyExt(EvalContext *ctx, GenericAgentConfig *config, bool exit_on_error)
 {
     StringSet *parsed_files_and_checksums = StringSetNew();
     StringSet *failed_files = StringSetNew();
+    Map *parsed_files = MapNew(StringHash_untyped, StringSafeEqual_untyped,
+                               free, ParsedFileDestroy);
+
+    /* Bundles of other agent types, which the parser only keeps while
+     * validating (JSON policy always has them). */
+    Policy *other_bundles = PolicyNew();
 
     Banner("Loading policy");
 
     Policy *policy = LoadPolicyFile(ctx, config, config->input_file,
-                                    parsed_files_and_checksums, failed_files);
+                                    parsed_files_and_checksums, failed_files,
+                                    parsed_files, other_bundles);
 
-    if (StringSetSize(failed_files) > 0)
+    bool syntax_errors = (StringSetSize(failed_files) > 0);
+    StringSetDestroy(parsed_files_and_checksums);
+    StringSetDestroy(failed_files);
+    MapDestroy(parsed_files);
+
+    if (syntax_errors)
     {
         Log(LOG_LEVEL_ERR, "There are syntax errors in policy files");
-        exit(EXIT_FAILURE);
+        if (exit_on_error)
+        {
+            exit(EXIT_FAILURE);
+        }
+        PolicyDestroy(policy);
+        PolicyDestroy(other_bundles);
+        return NULL;
     }
 
-    StringSetDestroy(parsed_files_and_checksums);
-    StringSetDestroy(failed_files);
+    if (config->check_all_agent_types)
+    {
+        /* Checked like cf-promises does, in one piece. */
+        policy = PolicyMerge(policy, other_bundles);
+    }
+    else
+    {
+        PolicyDestroy(other_bundles);
+    }
 
     {
         Seq *errors = SeqNew(100, PolicyErrorDestroy);
@@ -470,12 +909,25 @@ Policy *LoadPolicy(EvalContext *ctx, GenericAgentConfig *config)
                 PolicyErrorWrite(writer, errors->data[i]);
             }
             WriterClose(writer);
-            exit(EXIT_FAILURE); // TODO: do not exit
+            SeqDestroy(errors);
+            if (exit_on_error)
+            {
+                exit(EXIT_FAILURE); // TODO: do not exit
+            }
+            PolicyDestroy(policy);
+            return NULL;
         }
 
         SeqDestroy(errors);
     }
 
+    if (config->check_all_agent_types)
+    {
+        other_bundles = PolicyNew();
+        PolicyMoveBundlesOfOtherAgents(policy, config->agent_type, other_bundles);
+        PolicyDestroy(other_bundles);
+    }
+
     if (LogGetGlobalLevel() >= LOG_LEVEL_VERBOSE)
     {
         Legend();
@@ -529,7 +981,13 @@ Policy *LoadPolicy(EvalContext *ctx, GenericAgentConfig *config)
             {
                 if (!VerifyBundleSequence(ctx, policy, config))
                 {
-                    FatalError(ctx, "Errors in promise bundles: could not verify bundlesequence");
+                    if (exit_on_error)
+                    {
+                        FatalError(ctx, "Errors in promise bundles: could not verify bundlesequence");
+                    }
+                    Log(LOG_LEVEL_ERR, "Errors in promise bundles: could not verify bundlesequence");
+                    PolicyDestroy(policy);
+                    return NULL;
                 }
             }
         }
@@ -548,3 +1006,26 @@ Policy *LoadPolicy(EvalContext *ctx, GenericAgentConfig *config)
 
     return policy;
 }
+
+Policy *LoadPolicy(EvalContext *ctx, GenericAgentConfig *config)
+{
+    return LoadPolicyExt(ctx, config, true);
+}
+
+/**
+ * Load and validate the policy, like cf-promises does but in-process: the
+ * bundles of all agent types are parsed and checked, then the ones of other
+ * agent types are dropped.
+ *
+ * @return The policy, or NULL if it's not valid, the errors having been
+ *         logged. In that case #ctx still holds the classes and variables
+ *         the policy defined while being loaded.
+ */
+Policy *LoadPolicyIfValid(EvalContext *ctx, GenericAgentConfig *config)
+{
+    config->check_all_agent_types = true;
+    Policy *policy = LoadPolicyExt(ctx, config, false);
+    config->check_all_agent_types = false;
+
+    return policy;
+}
@@ -29,6 +29,7 @@
 #include <generic_agent.h>
 
 Policy *LoadPolicy(EvalContext *ctx, GenericAgentConfig *config);
+Policy *LoadPolicyIfValid(EvalContext *ctx, GenericAgentConfig *config);
 Policy *Cf3ParseFile(const GenericAgentConfig *config, const char *input_path);
 
 #endif
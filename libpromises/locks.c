@@ -179,40 +179,66 @@ static bool WriteLockDataCurrent(CF_DB *dbp, const char *lock_id)
     return WriteLockData(dbp, lock_id, &lock_data);
 }
 
-time_t FindLockTime(const char *name)
+static bool ReadLockData(CF_DB *dbp, const char *lock_id, LockData *lock_data)
 {
     bool ret;
-    CF_DB *dbp;
-    LockData entry = {
-        .process_start_time = PROCESS_START_TIME_UNKNOWN,
-    };
-
-    if ((dbp = OpenLock()) == NULL)
-    {
-        return -1;
-    }
 
 #ifdef LMDB
     unsigned char ohash[EVP_MAX_MD_SIZE*2 + 1];
-    GenerateMd5Hash(name, ohash);
+    GenerateMd5Hash(lock_id, ohash);
 
-    LOG_LOCK_ENTRY(name, ohash, &entry);
-    ret = ReadDB(dbp, ohash, &entry, sizeof(entry));
-    LOG_LOCK_EXIT(name, ohash, &entry);
+    LOG_LOCK_ENTRY(lock_id, ohash, lock_data);
+    ret = ReadDB(dbp, ohash, lock_data, sizeof(LockData));
+    LOG_LOCK_EXIT(lock_id, ohash, lock_data);
 #else
-    ret = ReadDB(dbp, name, &entry, sizeof(entry));
+    ret = ReadDB(dbp, lock_id, lock_data, sizeof(LockData));
 #endif
 
-    if (ret)
+    return ret;
+}
+
+static bool DeleteLockData(CF_DB *dbp, const char *lock_id)
+{
+    bool ret;
+
+#ifdef LMDB
+    unsigned char digest2[EVP_MAX_MD_SIZE*2 + 1];
+
+    if (!strcmp(lock_id, "CF_CRITICAL_SECTION"))
     {
-        CloseLock(dbp);
-        return entry.time;
+        strcpy(digest2, lock_id);
     }
     else
     {
-        CloseLock(dbp);
+        GenerateMd5Hash(lock_id, digest2);
+    }
+
+    LOG_LOCK_ENTRY(lock_id, digest2, NULL);
+    ret = DeleteDB(dbp, digest2);
+    LOG_LOCK_EXIT(lock_id, digest2, NULL);
+#else
+    ret = DeleteDB(dbp, lock_id);
+#endif
+
+    return ret;
+}
+
+time_t FindLockTime(const char *name)
+{
+    CF_DB *dbp;
+    LockData entry = {
+        .process_start_time = PROCESS_START_TIME_UNKNOWN,
+    };
+
+    if ((dbp = OpenLock()) == NULL)
+    {
         return -1;
     }
+
+    bool ret = ReadLockData(dbp, name, &entry);
+    CloseLock(dbp);
+
+    return ret ? entry.time : -1;
 }
 
 static void RemoveDates(char *s)
@@ -290,31 +316,14 @@ static int RemoveLock(const char *name)
     }
 
     ThreadLock(cft_lock);
-#ifdef LMDB
-    unsigned char digest2[EVP_MAX_MD_SIZE*2 + 1];
-
-    if (!strcmp(name, "CF_CRITICAL_SECTION"))
-    {
-        strcpy(digest2, name);
-    }
-    else
-    {
-        GenerateMd5Hash(name, digest2);
-    }
-
-    LOG_LOCK_ENTRY(name, digest2, NULL);
-    DeleteDB(dbp, digest2);
-    LOG_LOCK_EXIT(name, digest2, NULL);
-#else
-    DeleteDB(dbp, name);
-#endif
+    DeleteLockData(dbp, name);
     ThreadUnlock(cft_lock);
 
     CloseLock(dbp);
     return 0;
 }
 
-void WaitForCriticalSection(const char *section_id)
+static void WaitForCriticalSectionRelease(const char *section_id)
 {
     time_t now = time(NULL), then = FindLockTime(section_id);
 
@@ -328,7 +337,11 @@ void WaitForCriticalSection(const char *section_id)
         now = time(NULL);
         then = FindLockTime(section_id);
     }
+}
 
+void WaitForCriticalSection(const char *section_id)
+{
+    WaitForCriticalSectionRelease(section_id);
     WriteLock(section_id);
 }
 
@@ -337,62 +350,55 @@ void ReleaseCriticalSection(const char *section_id)
     RemoveLock(section_id);
 }
 
-static time_t FindLock(char *last)
+/*
+ * AcquireLock() reads and updates the locks in a single transaction of the
+ * returned handle, so that a promise costs one commit instead of one per
+ * lock record. Under LMDB, writing the section marker starts the write
+ * transaction, which keeps other agents out until LeaveLocksCriticalSection()
+ * commits it. With the other backends the marker is written through, and
+ * keeps them out like WaitForCriticalSection() does. The section is left
+ * while the holder of an expired lock is terminated, see KillLockHolder().
+ */
+static CF_DB *EnterLocksCriticalSection(void)
 {
-    time_t mtime;
+    WaitForCriticalSectionRelease(CF_CRITIAL_SECTION);
 
-    if ((mtime = FindLockTime(last)) == -1)
+    CF_DB *dbp = OpenLock();
+    if (dbp != NULL)
     {
-        /* Do this to prevent deadlock loops from surviving if IfElapsed > T_sched */
+        ThreadLock(cft_lock);
+        WriteLockDataCurrent(dbp, CF_CRITIAL_SECTION);
+    }
 
-        if (WriteLock(last) == -1)
-        {
-            Log(LOG_LEVEL_ERR, "Unable to lock %s", last);
-            return 0;
-        }
+    return dbp;
+}
 
-        return 0;
-    }
-    else
-    {
-        return mtime;
-    }
+static void LeaveLocksCriticalSection(CF_DB *dbp)
+{
+    DeleteLockData(dbp, CF_CRITIAL_SECTION);
+    CloseLock(dbp);
+    ThreadUnlock(cft_lock);
 }
 
-static pid_t FindLockPid(char *name)
+static time_t FindLock(CF_DB *dbp, const char *last)
 {
-    bool ret;
-    CF_DB *dbp;
     LockData entry = {
         .process_start_time = PROCESS_START_TIME_UNKNOWN,
     };
 
-    if ((dbp = OpenLock()) == NULL)
+    if (ReadLockData(dbp, last, &entry))
     {
-        return -1;
+        return entry.time;
     }
 
-#ifdef LMDB
-    unsigned char ohash[EVP_MAX_MD_SIZE*2 + 1];
-    GenerateMd5Hash(name, ohash);
+    /* Do this to prevent deadlock loops from surviving if IfElapsed > T_sched */
 
-    LOG_LOCK_ENTRY(name, ohash, &entry);
-    ret = ReadDB(dbp, ohash, &entry, sizeof(entry));
-    LOG_LOCK_EXIT(name, ohash, &entry);
-#else
-    ret = ReadDB(dbp, name, &entry, sizeof(entry));
-#endif
-
-    if (ret)
+    if (!WriteLockDataCurrent(dbp, last))
     {
-        CloseLock(dbp);
-        return entry.pid;
-    }
-    else
-    {
-        CloseLock(dbp);
-        return -1;
+        Log(LOG_LEVEL_ERR, "Unable to lock %s", last);
     }
+
+    return 0;
 }
 
 static void LocksCleanup(void)
@@ -472,41 +478,42 @@ static void PromiseTypeString(char *dst, size_t dst_size, const Promise *pp)
 
 
 
-static bool KillLockHolder(const char *lock)
+/*
+ * Terminates the holder of an expired lock, which takes a while, so the
+ * holder is read first and the locks database isn't kept locked meanwhile.
+ * Returns the database re-entered, or NULL if that failed.
+ */
+static CF_DB *KillLockHolder(CF_DB *dbp, const char *lock, bool *killed,
+                             LockData *holder)
 {
-    bool ret;
-    CF_DB *dbp = OpenLock();
-    if (dbp == NULL)
-    {
-        Log(LOG_LEVEL_ERR, "Unable to open locks database");
-        return false;
-    }
+    holder->pid = -1;
+    holder->time = 0;
+    holder->process_start_time = PROCESS_START_TIME_UNKNOWN;
 
-    LockData lock_data = {
-        .process_start_time = PROCESS_START_TIME_UNKNOWN,
-    };
+    bool found = ReadLockData(dbp, lock, holder);
+    LeaveLocksCriticalSection(dbp);
 
-#ifdef LMDB
-    unsigned char ohash[EVP_MAX_MD_SIZE*2 + 1];
-    GenerateMd5Hash(lock, ohash);
+    /* No lock found counts as killed */
+    *killed = !found ||
+        GracefulTerminate(holder->pid, holder->process_start_time);
 
-    LOG_LOCK_ENTRY(lock, ohash, &lock_data);
-    ret = ReadDB(dbp, ohash, &lock_data, sizeof(lock_data));
-    LOG_LOCK_EXIT(lock, ohash, &lock_data);
-#else
-    ret = ReadDB(dbp, lock, &lock_data, sizeof(lock_data));
-#endif
+    return EnterLocksCriticalSection();
+}
 
-    if (!ret)
+/* Whether #lock is still the record of #holder, or gone. */
+static bool LockHolderUnchanged(CF_DB *dbp, const char *lock,
+                                const LockData *holder)
+{
+    LockData entry = {
+        .process_start_time = PROCESS_START_TIME_UNKNOWN,
+    };
+
+    if (!ReadLockData(dbp, lock, &entry))
     {
-        /* No lock found */
-        CloseLock(dbp);
         return true;
     }
 
-    CloseLock(dbp);
-
-    return GracefulTerminate(lock_data.pid, lock_data.process_start_time);
+    return entry.pid == holder->pid && entry.time == holder->time;
 }
 
 void PromiseRuntimeHash(const Promise *pp, const char *salt, unsigned char digest[EVP_MAX_MD_SIZE + 1], HashMethod type)
@@ -724,10 +731,15 @@ CfLock AcquireLock(EvalContext *ctx, const char *operand, const char *host, time
         bundle_name, cflock);
 
     // Now see if we can get exclusivity to edit the locks
-    WaitForCriticalSection(CF_CRITIAL_SECTION);
+    CF_DB *dbp = EnterLocksCriticalSection();
+    if (dbp == NULL)
+    {
+        Log(LOG_LEVEL_ERR, "Unable to lock %s", cflock);
+        return CfLockNew(cflast, cflock, false);
+    }
 
     // Look for non-existent (old) processes
-    time_t lastcompleted = FindLock(cflast);
+    time_t lastcompleted = FindLock(dbp, cflast);
     time_t elapsedtime = (time_t) (now - lastcompleted) / 60;
 
     // For promises/locks with ifelapsed == 0, skip all detection logic of
@@ -739,7 +751,7 @@ CfLock AcquireLock(EvalContext *ctx, const char *operand, const char *host, time
             Log(LOG_LEVEL_VERBOSE,
                 "XX Another cf-agent seems to have done this since I started (elapsed=%jd)",
                 (intmax_t) elapsedtime);
-            ReleaseCriticalSection(CF_CRITIAL_SECTION);
+            LeaveLocksCriticalSection(dbp);
             return CfLockNull();
         }
 
@@ -748,13 +760,13 @@ CfLock AcquireLock(EvalContext *ctx, const char *operand, const char *host, time
             Log(LOG_LEVEL_VERBOSE,
                 "XX Nothing promised here [%.40s] (%jd/%u minutes elapsed)",
                 cflast, (intmax_t) elapsedtime, tc.ifelapsed);
-            ReleaseCriticalSection(CF_CRITIAL_SECTION);
+            LeaveLocksCriticalSection(dbp);
             return CfLockNull();
         }
     }
 
     // Look for existing (current) processes
-    lastcompleted = FindLock(cflock);
+    lastcompleted = FindLock(dbp, cflock);
     if (!ignoreProcesses)
     {
         elapsedtime = (time_t) (now - lastcompleted) / 60;
@@ -766,13 +778,15 @@ CfLock AcquireLock(EvalContext *ctx, const char *operand, const char *host, time
                 Log(LOG_LEVEL_INFO, "Lock expired after %jd/%u minutes: %s",
                     (intmax_t) elapsedtime, tc.expireafter, cflock);
 
-                pid_t pid = FindLockPid(cflock);
+                bool killed;
+                LockData holder;
+                dbp = KillLockHolder(dbp, cflock, &killed, &holder);
 
-                if (KillLockHolder(cflock))
+                if (killed)
                 {
                     Log(LOG_LEVEL_INFO,
                         "Lock expired, process with PID %jd killed",
-                        (intmax_t) pid);
+                        (intmax_t) holder.pid);
                     unlink(cflock);
                 }
                 else
@@ -780,32 +794,45 @@ CfLock AcquireLock(EvalContext *ctx, const char *operand, const char *host, time
                     Log(LOG_LEVEL_ERR,
                         "Unable to kill expired process %jd from lock %s"
                         " (probably process not found or permission denied)",
-                        (intmax_t) pid, cflock);
+                        (intmax_t) holder.pid, cflock);
+                }
+
+                if (dbp == NULL)
+                {
+                    Log(LOG_LEVEL_ERR, "Unable to lock %s", cflock);
+                    return CfLockNew(cflast, cflock, false);
+                }
+
+                /* Another agent may have taken the lock over meanwhile. */
+                if (!LockHolderUnchanged(dbp, cflock, &holder))
+                {
+                    LeaveLocksCriticalSection(dbp);
+                    Log(LOG_LEVEL_VERBOSE,
+                        "Couldn't obtain lock for %s (already running!)", cflock);
+                    return CfLockNull();
                 }
             }
             else
             {
-                ReleaseCriticalSection(CF_CRITIAL_SECTION);
+                LeaveLocksCriticalSection(dbp);
                 Log(LOG_LEVEL_VERBOSE,
                     "Couldn't obtain lock for %s (already running!)", cflock);
                 return CfLockNull();
             }
         }
 
-        int ret = WriteLock(cflock);
-        if (ret != -1)
-        {
-            /* Register a cleanup handler *after* having opened the DB, so that
-             * CloseAllDB() atexit() handler is registered in advance, and it is
-             * called after removing this lock.
+        WriteLockDataCurrent(dbp, cflock);
 
-             * There is a small race condition here that we'll leave a stale lock
-             * if we exit before the following line. */
-            pthread_once(&lock_cleanup_once, &RegisterLockCleanup);
-        }
+        /* Register a cleanup handler *after* having opened the DB, so that
+         * CloseAllDB() atexit() handler is registered in advance, and it is
+         * called after removing this lock.
+
+         * There is a small race condition here that we'll leave a stale lock
+         * if we exit before the following line. */
+        pthread_once(&lock_cleanup_once, &RegisterLockCleanup);
     }
 
-    ReleaseCriticalSection(CF_CRITIAL_SECTION);
+    LeaveLocksCriticalSection(dbp);
 
     // Keep this as a global for signal handling
     PushLock(cflock, cflast);
@@ -828,7 +855,9 @@ void YieldCurrentLock(CfLock lock)
 
     Log(LOG_LEVEL_DEBUG, "Yielding lock '%s'", lock.lock);
 
-    if (RemoveLock(lock.lock) == -1)
+    /* Remove the lock and record the completion in one transaction. */
+    CF_DB *dbp = OpenLock();
+    if (dbp == NULL)
     {
         Log(LOG_LEVEL_VERBOSE, "Unable to remove lock %s", lock.lock);
         free(lock.last);
@@ -836,12 +865,15 @@ void YieldCurrentLock(CfLock lock)
         return;
     }
 
-    if (WriteLock(lock.last) == -1)
+    ThreadLock(cft_lock);
+    DeleteLockData(dbp, lock.lock);
+    bool written = WriteLockDataCurrent(dbp, lock.last);
+    CloseLock(dbp);
+    ThreadUnlock(cft_lock);
+
+    if (!written)
     {
-        Log(LOG_LEVEL_ERR, "Unable to create '%s'. (creat: %s)", lock.last, GetErrorStr());
-        free(lock.last);
-        free(lock.lock);
-        return;
+        Log(LOG_LEVEL_ERR, "Unable to create '%s'", lock.last);
     }
 
     /* This lock has ben yield'ed, don't try to yield it again in case process
@@ -266,6 +266,8 @@ const ConstraintSyntax CFG_CONTROLBODY[COMMON_CONTROL_MAX + 1] =
     ConstraintSyntaxNewString("tls_min_version", "", "Minimum acceptable TLS version for outgoing connections, defaults to OpenSSL's default", SYNTAX_STATUS_NORMAL),
     ConstraintSyntaxNewStringList("package_inventory", ".*", "Name of the package manager used for software inventory management", SYNTAX_STATUS_NORMAL),
     ConstraintSyntaxNewString("package_module", ".*", "Name of the default package manager", SYNTAX_STATUS_NORMAL),
+    ConstraintSyntaxNewStringList("persistent_function_cache", CF_IDRANGE, "Functions whose results are kept across runs while the files they read are unchanged", SYNTAX_STATUS_NORMAL),
+    ConstraintSyntaxNewInt("persistent_function_cache_ttl", CF_VALRANGE, "Seconds that cached results of functions running commands or searching files stay valid. Default value: 300", SYNTAX_STATUS_NORMAL),
     ConstraintSyntaxNewNull()
 };
 
@@ -316,6 +318,7 @@ const ConstraintSyntax CFA_CONTROLBODY[] =
     ConstraintSyntaxNewBool("verbose", "true/false switches on verbose standard output. Default value: false", SYNTAX_STATUS_NORMAL),
     ConstraintSyntaxNewBool("report_class_log", "true/false enables logging classes at the end of agent execution. Default value: false", SYNTAX_STATUS_NORMAL),
     ConstraintSyntaxNewBool("select_end_match_eof", "Set the default behavior of select_end_match_eof in edit_line promises. Default: false", SYNTAX_STATUS_NORMAL),
+    ConstraintSyntaxNewInt("concurrent_commands", CF_VALRANGE, "Maximum number of commands promises of a bundle allowed to run at the same time. Default value: 1", SYNTAX_STATUS_NORMAL),
     ConstraintSyntaxNewNull()
 };
 
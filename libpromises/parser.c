@@ -121,21 +121,25 @@ Policy *ParserParseFile(AgentType agent_type, const char *path, unsigned int war
     if (yyin == NULL)
     {
         Log(LOG_LEVEL_ERR, "While opening file '%s' for parsing. (fopen: %s)", path, GetErrorStr());
-        exit(EXIT_FAILURE);
+        P.error_count++;
     }
 
-    while (!feof(yyin))
+    while (yyin != NULL && !feof(yyin))
     {
         yyparse();
 
         if (ferror(yyin))
         {
-            perror("cfengine");
-            exit(EXIT_FAILURE);
+            Log(LOG_LEVEL_ERR, "While reading file '%s' for parsing. (fread: %s)", path, GetErrorStr());
+            P.error_count++;
+            break;
         }
     }
 
-    fclose(yyin);
+    if (yyin != NULL)
+    {
+        fclose(yyin);
+    }
 
     if (P.error_count > 0)
     {
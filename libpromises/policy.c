@@ -43,6 +43,8 @@
 #include <audit.h>
 #include <logging.h>
 #include <expand.h>
+#include <attributes.h>                                /* ClearFilesAttributes */
+#include <string_intern.h>                         /* StringInternRelease */
 
 static const char *const POLICY_ERROR_BUNDLE_NAME_RESERVED =
     "Use of a reserved container name as a bundle name \"%s\"";
@@ -98,6 +100,49 @@ const char *NamespaceDefault(void)
 
 /*************************************************************************/
 
+/* Bundle and body lookups happen for every methods: promise and body
+ * reference, so policy->bundle_index and policy->body_index map the name
+ * without any namespace prefix to all bundles or bodies having it, in
+ * policy order. The lookups then only compare the few candidates. */
+
+static void PolicyIndexEntryDestroy(void *entry)
+{
+    SeqDestroy(entry);
+}
+
+static Map *PolicyIndexNew(void)
+{
+    return MapNew(StringHash_untyped, StringSafeEqual_untyped,
+                  NULL, PolicyIndexEntryDestroy);  /* keys owned by elements */
+}
+
+/* Everything after the last namespace separator. */
+static const char *PolicyIndexKey(const char *name)
+{
+    const char *sep = strrchr(name, CF_NS);
+    return (sep != NULL) ? sep + 1 : name;
+}
+
+static void PolicyIndexAdd(Map *index, const char *name, void *element)
+{
+    const char *key = PolicyIndexKey(name);
+
+    Seq *entry = MapGet(index, key);
+    if (entry == NULL)
+    {
+        entry = SeqNew(1, NULL);
+        MapInsert(index, (char *) key, entry);
+    }
+    SeqAppend(entry, element);
+}
+
+static const Seq *PolicyIndexGet(Map *index, const char *name)
+{
+    return MapGet(index, PolicyIndexKey(name));
+}
+
+/*************************************************************************/
+
 Policy *PolicyNew(void)
 {
     Policy *policy = xcalloc(1, sizeof(Policy));
@@ -105,6 +150,8 @@ Policy *PolicyNew(void)
     policy->release_id = NULL;
     policy->bundles = SeqNew(100, BundleDestroy);
     policy->bodies = SeqNew(100, BodyDestroy);
+    policy->bundle_index = PolicyIndexNew();
+    policy->body_index = PolicyIndexNew();
 
     return policy;
 }
@@ -124,6 +171,8 @@ void PolicyDestroy(Policy *policy)
     {
         SeqDestroy(policy->bundles);
         SeqDestroy(policy->bodies);
+        MapDestroy(policy->bundle_index);
+        MapDestroy(policy->body_index);
         free(policy->release_id);
 
         free(policy);
@@ -286,9 +335,15 @@ static const char *StripNamespace(const char *full_symbol)
  */
 Body *PolicyGetBody(const Policy *policy, const char *ns, const char *type, const char *name)
 {
-    for (size_t i = 0; i < SeqLength(policy->bodies); i++)
+    const Seq *candidates = PolicyIndexGet(policy->body_index, name);
+    if (candidates == NULL)
     {
-        Body *bp = SeqAt(policy->bodies, i);
+        return NULL;
+    }
+
+    for (size_t i = 0; i < SeqLength(candidates); i++)
+    {
+        Body *bp = SeqAt(candidates, i);
         const char *body_symbol = StripNamespace(bp->name);
 
         if (strcmp(bp->type, type)    == 0 &&
@@ -321,9 +376,15 @@ Bundle *PolicyGetBundle(const Policy *policy, const char *ns, const char *type,
 {
     const char *bundle_symbol = StripNamespace(name);
 
-    for (size_t i = 0; i < SeqLength(policy->bundles); i++)
+    const Seq *candidates = PolicyIndexGet(policy->bundle_index, name);
+    if (candidates == NULL)
     {
-        Bundle *bp = SeqAt(policy->bundles, i);
+        return NULL;
+    }
+
+    for (size_t i = 0; i < SeqLength(candidates); i++)
+    {
+        Bundle *bp = SeqAt(candidates, i);
 
         if ((type == NULL || strcmp(bp->type, type) == 0)
             &&
@@ -345,6 +406,23 @@ Bundle *PolicyGetBundle(const Policy *policy, const char *ns, const char *type,
 
 /*************************************************************************/
 
+/**
+ * @return The bundles (or bodies) whose name is the same as #name's when
+ *         stripped of any namespace prefix, in policy order, or NULL.
+ *         Faster than walking all of them for lookups by name.
+ */
+const Seq *PolicyGetBundlesNamed(const Policy *policy, const char *name)
+{
+    return PolicyIndexGet(policy->bundle_index, name);
+}
+
+const Seq *PolicyGetBodiesNamed(const Policy *policy, const char *name)
+{
+    return PolicyIndexGet(policy->body_index, name);
+}
+
+/*************************************************************************/
+
 /**
  * @brief Check to see if a policy is runnable (contains body common control)
  * @param policy Policy to check
@@ -376,6 +454,7 @@ Policy *PolicyMerge(Policy *a, Policy *b)
     {
         Bundle *bp = SeqAt(result->bundles, i);
         bp->parent_policy = result;
+        PolicyIndexAdd(result->bundle_index, bp->name, bp);
     }
 
     SeqAppendSeq(result->bodies, a->bodies);
@@ -387,11 +466,16 @@ Policy *PolicyMerge(Policy *a, Policy *b)
     {
         Body *bdp = SeqAt(result->bodies, i);
         bdp->parent_policy = result;
+        PolicyIndexAdd(result->body_index, bdp->name, bdp);
     }
 
     /* Should result take over a release_id ? */
     free(a->release_id);
     free(b->release_id);
+    MapDestroy(a->bundle_index);
+    MapDestroy(b->bundle_index);
+    MapDestroy(a->body_index);
+    MapDestroy(b->body_index);
     free(a);
     free(b);
 
@@ -400,6 +484,61 @@ Policy *PolicyMerge(Policy *a, Policy *b)
 
 /*************************************************************************/
 
+/**
+ * @return Whether agents of type #agent_type load the bundles of type
+ *         #bundle_type on top of their own type: cf-promises loads all of
+ *         them, the others common bundles, and cf-agent edit_line and
+ *         edit_xml bundles too.
+ */
+bool BundleTypeIsRelevant(AgentType agent_type, const char *bundle_type)
+{
+    if (agent_type == AGENT_TYPE_COMMON || strcmp(CF_COMMONC, bundle_type) == 0)
+    {
+        return true;
+    }
+
+    if (agent_type == AGENT_TYPE_AGENT)
+    {
+        return strcmp(bundle_type, "edit_line") == 0 ||
+               strcmp(bundle_type, "edit_xml") == 0;
+    }
+
+    return false;
+}
+
+/**
+ * @brief Move the bundles of #policy that agents of type #agent_type don't
+ *        load, as the parser would have skipped them, to #other.
+ */
+void PolicyMoveBundlesOfOtherAgents(Policy *policy, AgentType agent_type, Policy *other)
+{
+    Seq *kept = SeqNew(SeqLength(policy->bundles), BundleDestroy);
+
+    MapDestroy(policy->bundle_index);
+    policy->bundle_index = PolicyIndexNew();
+
+    for (size_t i = 0; i < SeqLength(policy->bundles); i++)
+    {
+        Bundle *bp = SeqAt(policy->bundles, i);
+
+        Policy *owner = policy;
+        if (!BundleTypeIsRelevant(agent_type, bp->type) &&
+            strcmp(CF_AGENTTYPES[agent_type], bp->type) != 0)
+        {
+            owner = other;
+        }
+
+        bp->parent_policy = owner;
+        SeqAppend((owner == policy) ? kept : owner->bundles, bp);
+        PolicyIndexAdd(owner->bundle_index, bp->name, bp);
+    }
+
+    SeqSoftDestroy(policy->bundles);
+    policy->bundles = kept;
+}
+
+/*************************************************************************/
+
 const char *ConstraintGetNamespace(const Constraint *cp)
 {
     switch (cp->type)
@@ -1288,6 +1427,8 @@ Bundle *PolicyAppendBundle(Policy *policy,
     bundle->source_path = SafeStringDuplicate(source_path);
     bundle->promise_types = SeqNew(10, PromiseTypeDestroy);
 
+    PolicyIndexAdd(policy->bundle_index, bundle->name, bundle);
+
     return bundle;
 }
 
@@ -1307,6 +1448,8 @@ Body *PolicyAppendBody(Policy *policy, const char *ns, const char *name, const c
     body->source_path = SafeStringDuplicate(source_path);
     body->conlist = SeqNew(10, ConstraintDestroy);
 
+    PolicyIndexAdd(policy->body_index, body->name, body);
+
     // TODO: move to standard callback
     if (strcmp("service_method", body->name) == 0)
     {
@@ -1431,11 +1574,74 @@ void PromiseDestroy(Promise *pp)
         free(pp->comment);
 
         SeqDestroy(pp->conlist);
+        MapDestroy(pp->conindex);
+        PromiseClearFilesAttributes(pp);
 
         free(pp);
     }
 }
 
+/**
+ * Drop the memoized GetFilesAttributes() of #pp, they point into constraints
+ * that are about to change.
+ */
+void PromiseClearFilesAttributes(Promise *pp)
+{
+    if (pp->files_attributes != NULL)
+    {
+        ClearFilesAttributes(pp->files_attributes);
+        free(pp->files_attributes);
+        pp->files_attributes = NULL;
+    }
+}
+
+/*
+ * Promises flattening a few bodies easily carry dozens of constraints, and
+ * attribute extraction looks up most of the known lvals for every promise.
+ * Past CONSTRAINT_INDEX_MIN constraints they are looked up through an index
+ * instead of scanning the conlist. Lvals are unique within a promise, since
+ * PromiseAppendConstraint() replaces existing ones.
+ */
+#define CONSTRAINT_INDEX_MIN 16
+
+static void PromiseIndexConstraint(Promise *pp, Constraint *cp)
+{
+    if (pp->conindex != NULL)
+    {
+        /* Also replaces the key of a constraint being replaced. */
+        MapInsert(pp->conindex, cp->lval, cp);
+    }
+    else if (SeqLength(pp->conlist) >= CONSTRAINT_INDEX_MIN)
+    {
+        pp->conindex = MapNew(StringHash_untyped, StringSafeEqual_untyped,
+                              NULL, NULL);  /* both owned by the conlist */
+        for (size_t i = 0; i < SeqLength(pp->conlist); i++)
+        {
+            Constraint *c = SeqAt(pp->conlist, i);
+            MapInsert(pp->conindex, c->lval, c);
+        }
+    }
+}
+
+static Constraint *PromiseLookupConstraint(const Promise *pp, const char *lval)
+{
+    if (pp->conindex != NULL)
+    {
+        return MapGet(pp->conindex, lval);
+    }
+
+    for (size_t i = 0; i < SeqLength(pp->conlist); i++)
+    {
+        Constraint *cp = SeqAt(pp->conlist, i);
+        if (strcmp(cp->lval, lval) == 0)
+        {
+            return cp;
+        }
+    }
+
+    return NULL;
+}
+
 /*******************************************************************/
 
 static Constraint *ConstraintNew(const char *lval, Rval rval, const char *classes, bool references_body)
@@ -1451,12 +1657,47 @@ static Constraint *ConstraintNew(const char *lval, Rval rval, const char *classe
     return cp;
 }
 
+/**
+ * Deep copy of a (usually expanded) promise, for keeping it past the
+ * iteration that produced it. Memoized attributes are not copied.
+ */
+Promise *PromiseCopy(const Promise *pp)
+{
+    Promise *copy = xcalloc(1, sizeof(Promise));
+
+    copy->parent_promise_type = pp->parent_promise_type;
+    copy->classes = SafeStringDuplicate(pp->classes);
+    copy->comment = pp->comment ? xstrdup(pp->comment) : NULL;
+    copy->promiser = SafeStringDuplicate(pp->promiser);
+    copy->promisee = RvalCopy(pp->promisee);
+    copy->org_pp = pp->org_pp;
+    copy->offset = pp->offset;
+
+    copy->conlist = SeqNew(10, ConstraintDestroy);
+    for (size_t i = 0; i < SeqLength(pp->conlist); i++)
+    {
+        const Constraint *cp = SeqAt(pp->conlist, i);
+        Constraint *new_cp = ConstraintNew(cp->lval, RvalCopy(cp->rval),
+                                           cp->classes, cp->references_body);
+        new_cp->type = POLICY_ELEMENT_TYPE_PROMISE;
+        new_cp->parent.promise = copy;
+        new_cp->offset = cp->offset;
+
+        SeqAppend(copy->conlist, new_cp);
+        PromiseIndexConstraint(copy, new_cp);
+    }
+
+    return copy;
+}
+
 Constraint *PromiseAppendConstraint(Promise *pp, const char *lval, Rval rval, bool references_body)
 {
     Constraint *cp = ConstraintNew(lval, rval, "any", references_body);
     cp->type = POLICY_ELEMENT_TYPE_PROMISE;
     cp->parent.promise = pp;
 
+    PromiseClearFilesAttributes(pp);
+
     for (size_t i = 0; i < SeqLength(pp->conlist); i++)
     {
         Constraint *old_cp = SeqAt(pp->conlist, i);
@@ -1512,12 +1753,15 @@ Constraint *PromiseAppendConstraint(Promise *pp, const char *lval, Rval rval, bo
                     break;
                 }
             }
+            /* Before SeqSet() frees the old lval, the index key. */
+            PromiseIndexConstraint(pp, cp);
             SeqSet(pp->conlist, i, cp);
             return cp;
         }
     }
 
     SeqAppend(pp->conlist, cp);
+    PromiseIndexConstraint(pp, cp);
     return cp;
 }
 
@@ -2398,6 +2642,8 @@ void ConstraintDestroy(Constraint *cp)
         RvalDestroy(cp->rval);
         free(cp->lval);
         free(cp->classes);
+        SeqDestroy(cp->resolved_bodies);
+        StringInternRelease(cp->resolved_bodies_ns);
 
         free(cp);
     }
@@ -2415,43 +2661,24 @@ int PromiseGetConstraintAsBoolean(const EvalContext *ctx, const char *lval, cons
 {
     int retval = CF_UNDEFINED;
 
-    for (size_t i = 0; i < SeqLength(pp->conlist); i++)
+    const Constraint *cp = PromiseLookupConstraint(pp, lval);
+    if (cp != NULL && IsDefinedClass(ctx, cp->classes))
     {
-        Constraint *cp = SeqAt(pp->conlist, i);
-
-        if (strcmp(cp->lval, lval) == 0)
+        if (cp->rval.type != RVAL_TYPE_SCALAR)
         {
-            if (IsDefinedClass(ctx, cp->classes))
-            {
-                if (retval != CF_UNDEFINED)
-                {
-                    Log(LOG_LEVEL_ERR, "Multiple '%s' (boolean) constraints break this promise", lval);
-                    PromiseRef(LOG_LEVEL_ERR, pp);
-                }
-            }
-            else
-            {
-                continue;
-            }
-
-            if (cp->rval.type != RVAL_TYPE_SCALAR)
-            {
-                Log(LOG_LEVEL_ERR, "Type mismatch on rhs - expected type %c for boolean constraint '%s'",
-                    cp->rval.type, lval);
-                PromiseRef(LOG_LEVEL_ERR, pp);
-                FatalError(ctx, "Aborted");
-            }
-
-            if (strcmp(cp->rval.item, "true") == 0 || strcmp(cp->rval.item, "yes") == 0)
-            {
-                retval = true;
-                continue;
-            }
+            Log(LOG_LEVEL_ERR, "Type mismatch on rhs - expected type %c for boolean constraint '%s'",
+                cp->rval.type, lval);
+            PromiseRef(LOG_LEVEL_ERR, pp);
+            FatalError(ctx, "Aborted");
+        }
 
-            if (strcmp(cp->rval.item, "false") == 0 || strcmp(cp->rval.item, "no") == 0)
-            {
-                retval = false;
-            }
+        if (strcmp(cp->rval.item, "true") == 0 || strcmp(cp->rval.item, "yes") == 0)
+        {
+            retval = true;
+        }
+        else if (strcmp(cp->rval.item, "false") == 0 || strcmp(cp->rval.item, "no") == 0)
+        {
+            retval = false;
         }
     }
 
@@ -2525,41 +2752,22 @@ int ConstraintsGetAsBoolean(const EvalContext *ctx, const char *lval, const Seq
 
 bool PromiseBundleOrBodyConstraintExists(const EvalContext *ctx, const char *lval, const Promise *pp)
 {
-    int retval = CF_UNDEFINED;
-
-    for (size_t i = 0; i < SeqLength(pp->conlist); i++)
+    const Constraint *cp = PromiseLookupConstraint(pp, lval);
+    if (cp == NULL || !IsDefinedClass(ctx, cp->classes))
     {
-        const Constraint *cp = SeqAt(pp->conlist, i);
-
-        if (strcmp(cp->lval, lval) == 0)
-        {
-            if (IsDefinedClass(ctx, cp->classes))
-            {
-                if (retval != CF_UNDEFINED)
-                {
-                    Log(LOG_LEVEL_ERR, "Multiple '%s' constraints break this promise", lval);
-                    PromiseRef(LOG_LEVEL_ERR, pp);
-                }
-            }
-            else
-            {
-                continue;
-            }
-
-            if (!(cp->rval.type == RVAL_TYPE_FNCALL || cp->rval.type == RVAL_TYPE_SCALAR))
-            {
-                Log(LOG_LEVEL_ERR,
-                    "Anomalous type mismatch - type %c for bundle constraint '%s' did not match internals",
-                    cp->rval.type, lval);
-                PromiseRef(LOG_LEVEL_ERR, pp);
-                FatalError(ctx, "Aborted");
-            }
+        return false;
+    }
 
-            return true;
-        }
+    if (!(cp->rval.type == RVAL_TYPE_FNCALL || cp->rval.type == RVAL_TYPE_SCALAR))
+    {
+        Log(LOG_LEVEL_ERR,
+            "Anomalous type mismatch - type %c for bundle constraint '%s' did not match internals",
+            cp->rval.type, lval);
+        PromiseRef(LOG_LEVEL_ERR, pp);
+        FatalError(ctx, "Aborted");
     }
 
-    return false;
+    return true;
 }
 
 static bool CheckScalarNotEmptyVarRef(const char *scalar)
@@ -2881,33 +3089,16 @@ Constraint *PromiseGetConstraint(const Promise *pp, const char *lval)
         return NULL;
     }
 
-    for (size_t i = 0; i < SeqLength(pp->conlist); i++)
-    {
-        Constraint *cp = SeqAt(pp->conlist, i);
-
-        if (strcmp(cp->lval, lval) == 0)
-        {
-            return cp;
-        }
-    }
-
-    return NULL;
+    return PromiseLookupConstraint(pp, lval);
 }
 
 Constraint *PromiseGetConstraintWithType(const Promise *pp, const char *lval, RvalType type)
 {
     assert(pp);
-    for (size_t i = 0; i < SeqLength(pp->conlist); i++)
+    Constraint *cp = PromiseLookupConstraint(pp, lval);
+    if (cp != NULL && cp->rval.type == type)
     {
-        Constraint *cp = SeqAt(pp->conlist, i);
-        if (cp->rval.type != type) {
-            continue;
-        }
-
-        if (strcmp(cp->lval, lval) == 0)
-        {
-            return cp;
-        }
+        return cp;
     }
 
     return NULL;
@@ -2929,25 +3120,15 @@ Constraint *PromiseGetImmediateConstraint(const Promise *pp, const char *lval)
         return NULL;
     }
 
-    for (size_t i = 0; i < SeqLength(pp->conlist); ++i)
-    {
-        Constraint *cp = SeqAt(pp->conlist, i);
+    /* It would be nice to check whether the constraint we have asked
+       for is defined in promise (not in referenced body), but there
+       seem to be no way to do it easily.
 
-        if (strcmp(cp->lval, lval) == 0)
-        {
-            /* It would be nice to check whether the constraint we have asked
-               for is defined in promise (not in referenced body), but there
-               seem to be no way to do it easily.
+       Checking for absence of classes does not work, as constrains
+       obtain classes defined on promise itself.
+    */
 
-               Checking for absence of classes does not work, as constrains
-               obtain classes defined on promise itself.
-            */
-
-            return cp;
-        }
-    }
-
-    return NULL;
+    return PromiseLookupConstraint(pp, lval);
 }
 
 /**
@@ -31,6 +31,7 @@
 #include <sequence.h>
 #include <json.h>
 #include <set.h>
+#include <map.h>
 
 typedef enum
 {
@@ -55,6 +56,10 @@ struct Policy_
 
     Seq *bundles;
     Seq *bodies;
+
+    /* Bundles and bodies by unqualified name, see PolicyIndexAdd() */
+    Map *bundle_index;
+    Map *body_index;
 };
 
 typedef struct
@@ -114,9 +119,12 @@ struct Promise_
     char *promiser;
     Rval promisee;
     Seq *conlist;
+    Map *conindex;             /* lval -> Constraint, only for long conlists */
 
     const Promise *org_pp;            /* A ptr to the unexpanded raw promise */
 
+    Attributes *files_attributes;         /* memo of GetFilesAttributes() */
+
     SourceOffset offset;
 };
 
@@ -134,6 +142,10 @@ struct Constraint_
     char *classes;
     bool references_body;
 
+    /* memo of EvalContextResolveConstraintBody() */
+    Seq *resolved_bodies;
+    const char *resolved_bodies_ns;                         /* interned */
+
     SourceOffset offset;
 };
 
@@ -147,8 +159,12 @@ unsigned PolicyHash(const Policy *policy);
 StringSet *PolicySourceFiles(const Policy *policy);
 
 Policy *PolicyMerge(Policy *a, Policy *b);
+bool BundleTypeIsRelevant(AgentType agent_type, const char *bundle_type);
+void PolicyMoveBundlesOfOtherAgents(Policy *policy, AgentType agent_type, Policy *other);
 Body *PolicyGetBody(const Policy *policy, const char *ns, const char *type, const char *name);
 Bundle *PolicyGetBundle(const Policy *policy, const char *ns, const char *type, const char *name);
+const Seq *PolicyGetBundlesNamed(const Policy *policy, const char *name);
+const Seq *PolicyGetBodiesNamed(const Policy *policy, const char *name);
 bool PolicyIsRunnable(const Policy *policy);
 const Policy *PolicyFromPromise(const Promise *promise);
 char *BundleQualifiedName(const Bundle *bundle);
@@ -181,7 +197,9 @@ const char *ConstraintGetNamespace(const Constraint *cp);
 Promise *PromiseTypeAppendPromise(PromiseType *type, const char *promiser, Rval promisee, const char *classes, const char *varclasses);
 void PromiseTypeDestroy(PromiseType *promise_type);
 
+Promise *PromiseCopy(const Promise *pp);
 void PromiseDestroy(Promise *pp);
+void PromiseClearFilesAttributes(Promise *pp);
 
 Constraint *PromiseAppendConstraint(Promise *promise, const char *lval, Rval rval, bool references_body);
 
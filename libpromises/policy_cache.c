@@ -0,0 +1,775 @@
+/*
+   Copyright 2018 Northern.tech AS
+
+   This file is part of CFEngine 3 - written and maintained by Northern.tech AS.
+
+   This program is free software; you can redistribute it and/or modify it
+   under the terms of the GNU General Public License as published by the
+   Free Software Foundation; version 3.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA
+
+  To the extent this program is licensed as part of the Enterprise
+  versions of CFEngine, the applicable Commercial Open Source License
+  (COSL) may apply to this file if you as a licensee so wish it. See
+  included file COSL.txt.
+*/
+
+#include <policy_cache.h>
+
+#include <alloc.h>
+#include <logging.h>
+#include <dir.h>
+#include <json.h>
+#include <rlist.h>
+#include <fncall.h>
+#include <writer.h>
+#include <file_lib.h>                         /* safe_open, FullRead/Write */
+#include <known_dirs.h>                                     /* GetStateDir */
+#include <prototypes3.h>                                        /* Version */
+
+
+/**
+   Parsed and checked policy files are cached in the state directory, so
+   that agents don't lex and parse the unchanged ones on every run. Each
+   cache file holds the Policy fragment of one policy file, for one agent
+   type since the parser skips the bundles of other agents:
+
+       <state dir>/policy_cache/<digest of policy file>.<agent type>
+
+   The format is a flat sequence of fields in host byte order (the cache is
+   never shared between hosts), strings being prefixed by their length:
+
+       "CFPC" <byte order mark> <format version> <CFEngine version>
+       <bundles> <bodies>
+
+   The whole file is read at once and decoded with bounds checks, anything
+   unexpected makes it a cache miss. The source path is not stored, it's
+   always the path of the file being loaded, which has the same digest.
+
+   Cache files are replaced atomically with rename(), and the ones unused for
+   POLICY_CACHE_MAX_AGE are removed whenever a new one is written.
+*/
+
+#define POLICY_CACHE_MAGIC "CFPC"
+#define POLICY_CACHE_BOM 0x01020304
+#define POLICY_CACHE_FORMAT 1
+
+#define POLICY_CACHE_MAX_SIZE (64 * 1024 * 1024)
+#define POLICY_CACHE_MAX_AGE (7 * SECONDS_PER_DAY)
+/* Used cache files get their mtime refreshed at most this often. */
+#define POLICY_CACHE_TOUCH_INTERVAL SECONDS_PER_DAY
+
+#define NULL_STRING_LENGTH UINT32_MAX
+
+
+/*********************************************************************/
+/* Serialization                                                     */
+/*********************************************************************/
+
+static void WriteU32(Buffer *out, uint32_t value)
+{
+    BufferAppend(out, (const char *) &value, sizeof(value));
+}
+
+static void WriteU64(Buffer *out, uint64_t value)
+{
+    BufferAppend(out, (const char *) &value, sizeof(value));
+}
+
+static void WriteString(Buffer *out, const char *str)
+{
+    if (str == NULL)
+    {
+        WriteU32(out, NULL_STRING_LENGTH);
+        return;
+    }
+
+    size_t len = strlen(str);
+    WriteU32(out, len);
+    BufferAppend(out, str, len);
+}
+
+static void WriteOffset(Buffer *out, const SourceOffset *offset)
+{
+    WriteU64(out, offset->start);
+    WriteU64(out, offset->end);
+    WriteU64(out, offset->line);
+    WriteU64(out, offset->context);
+}
+
+static void WriteRlist(Buffer *out, const Rlist *list);
+
+static void WriteRval(Buffer *out, Rval rval)
+{
+    WriteU32(out, rval.type);
+
+    switch (rval.type)
+    {
+    case RVAL_TYPE_SCALAR:
+        WriteString(out, RvalScalarValue(rval));
+        break;
+
+    case RVAL_TYPE_LIST:
+        WriteRlist(out, RvalRlistValue(rval));
+        break;
+
+    case RVAL_TYPE_FNCALL:
+        WriteString(out, RvalFnCallValue(rval)->name);
+        WriteRlist(out, RvalFnCallValue(rval)->args);
+        break;
+
+    case RVAL_TYPE_CONTAINER:
+        {
+            Writer *w = StringWriter();
+            JsonWriteCompact(w, RvalContainerValue(rval));
+            WriteString(out, StringWriterData(w));
+            WriterClose(w);
+        }
+        break;
+
+    case RVAL_TYPE_NOPROMISEE:
+        break;
+    }
+}
+
+static void WriteRlist(Buffer *out, const Rlist *list)
+{
+    WriteU32(out, RlistLen(list));
+    for (const Rlist *rp = list; rp != NULL; rp = rp->next)
+    {
+        WriteRval(out, rp->val);
+    }
+}
+
+static void WriteConstraints(Buffer *out, const Seq *conlist)
+{
+    WriteU32(out, SeqLength(conlist));
+    for (size_t i = 0; i < SeqLength(conlist); i++)
+    {
+        const Constraint *cp = SeqAt(conlist, i);
+        WriteString(out, cp->lval);
+        WriteString(out, cp->classes);
+        WriteU32(out, cp->references_body);
+        WriteOffset(out, &cp->offset);
+        WriteRval(out, cp->rval);
+    }
+}
+
+static void WriteBundle(Buffer *out, const Bundle *bp)
+{
+    WriteString(out, bp->ns);
+    WriteString(out, bp->name);
+    WriteString(out, bp->type);
+    WriteRlist(out, bp->args);
+    WriteOffset(out, &bp->offset);
+
+    WriteU32(out, SeqLength(bp->promise_types));
+    for (size_t i = 0; i < SeqLength(bp->promise_types); i++)
+    {
+        const PromiseType *tp = SeqAt(bp->promise_types, i);
+        WriteString(out, tp->name);
+        WriteOffset(out, &tp->offset);
+
+        WriteU32(out, SeqLength(tp->promises));
+        for (size_t j = 0; j < SeqLength(tp->promises); j++)
+        {
+            const Promise *pp = SeqAt(tp->promises, j);
+            WriteString(out, pp->promiser);
+            WriteString(out, pp->classes);
+            WriteString(out, pp->comment);
+            WriteRval(out, pp->promisee);
+            WriteOffset(out, &pp->offset);
+            WriteConstraints(out, pp->conlist);
+        }
+    }
+}
+
+static void WriteBody(Buffer *out, const Body *bp)
+{
+    WriteString(out, bp->ns);
+    WriteString(out, bp->name);
+    WriteString(out, bp->type);
+    WriteRlist(out, bp->args);
+    WriteOffset(out, &bp->offset);
+    WriteConstraints(out, bp->conlist);
+}
+
+void PolicyCacheSerialize(const Policy *policy, Buffer *out)
+{
+    BufferSetMode(out, BUFFER_BEHAVIOR_BYTEARRAY);
+
+    BufferAppend(out, POLICY_CACHE_MAGIC, strlen(POLICY_CACHE_MAGIC));
+    WriteU32(out, POLICY_CACHE_BOM);
+    WriteU32(out, POLICY_CACHE_FORMAT);
+    WriteString(out, Version());
+
+    WriteU32(out, SeqLength(policy->bundles));
+    for (size_t i = 0; i < SeqLength(policy->bundles); i++)
+    {
+        WriteBundle(out, SeqAt(policy->bundles, i));
+    }
+
+    WriteU32(out, SeqLength(policy->bodies));
+    for (size_t i = 0; i < SeqLength(policy->bodies); i++)
+    {
+        WriteBody(out, SeqAt(policy->bodies, i));
+    }
+}
+
+/*********************************************************************/
+/* Deserialization                                                   */
+/*********************************************************************/
+
+typedef struct
+{
+    const char *data;
+    size_t size;
+    size_t pos;
+    bool error;                      /* sticky, all reads fail after it */
+} CacheReader;
+
+static bool ReadBytes(CacheReader *r, void *dst, size_t n)
+{
+    if (r->error || n > r->size - r->pos)
+    {
+        r->error = true;
+        return false;
+    }
+
+    memcpy(dst, r->data + r->pos, n);
+    r->pos += n;
+    return true;
+}
+
+static uint32_t ReadU32(CacheReader *r)
+{
+    uint32_t value = 0;
+    ReadBytes(r, &value, sizeof(value));
+    return value;
+}
+
+static uint64_t ReadU64(CacheReader *r)
+{
+    uint64_t value = 0;
+    ReadBytes(r, &value, sizeof(value));
+    return value;
+}
+
+/* Element counts can't exceed the bytes left, this keeps a corrupt count
+ * from causing huge allocations or long loops. */
+static uint32_t ReadCount(CacheReader *r)
+{
+    uint32_t count = ReadU32(r);
+    if (count > r->size - r->pos)
+    {
+        r->error = true;
+        return 0;
+    }
+    return count;
+}
+
+/**
+ * @return A newly allocated string, NULL for a NULL string or on error.
+ */
+static char *ReadString(CacheReader *r)
+{
+    uint32_t len = ReadU32(r);
+    if (r->error || len == NULL_STRING_LENGTH)
+    {
+        return NULL;
+    }
+    if (len > r->size - r->pos)
+    {
+        r->error = true;
+        return NULL;
+    }
+
+    char *str = xstrndup(r->data + r->pos, len);
+    r->pos += len;
+    return str;
+}
+
+/* Same, but a NULL string is an error. */
+static char *ReadNonNullString(CacheReader *r)
+{
+    char *str = ReadString(r);
+    if (str == NULL)
+    {
+        r->error = true;
+    }
+    return str;
+}
+
+static SourceOffset ReadOffset(CacheReader *r)
+{
+    SourceOffset offset;
+    offset.start = ReadU64(r);
+    offset.end = ReadU64(r);
+    offset.line = ReadU64(r);
+    offset.context = ReadU64(r);
+    return offset;
+}
+
+static Rlist *ReadRlist(CacheReader *r);
+
+static Rval ReadRval(CacheReader *r)
+{
+    Rval rval = { NULL, RVAL_TYPE_NOPROMISEE };
+
+    uint32_t type = ReadU32(r);
+    if (r->error)
+    {
+        return rval;
+    }
+
+    switch (type)
+    {
+    case RVAL_TYPE_SCALAR:
+        rval = (Rval) { ReadNonNullString(r), RVAL_TYPE_SCALAR };
+        break;
+
+    case RVAL_TYPE_LIST:
+        rval = (Rval) { ReadRlist(r), RVAL_TYPE_LIST };
+        break;
+
+    case RVAL_TYPE_FNCALL:
+        {
+            char *name = ReadNonNullString(r);
+            Rlist *args = ReadRlist(r);
+            if (r->error)
+            {
+                free(name);
+                RlistDestroy(args);
+                break;
+            }
+            rval = (Rval) { FnCallNew(name, args), RVAL_TYPE_FNCALL };
+            free(name);
+        }
+        break;
+
+    case RVAL_TYPE_CONTAINER:
+        {
+            char *json_str = ReadNonNullString(r);
+            JsonElement *json = NULL;
+            const char *data = json_str;
+            if (!r->error && JsonParse(&data, &json) != JSON_PARSE_OK)
+            {
+                r->error = true;
+            }
+            free(json_str);
+            if (!r->error)
+            {
+                rval = (Rval) { json, RVAL_TYPE_CONTAINER };
+            }
+        }
+        break;
+
+    case RVAL_TYPE_NOPROMISEE:
+        break;
+
+    default:
+        r->error = true;
+        break;
+    }
+
+    if (r->error)
+    {
+        RvalDestroy(rval);
+        return (Rval) { NULL, RVAL_TYPE_NOPROMISEE };
+    }
+    return rval;
+}
+
+static Rlist *ReadRlist(CacheReader *r)
+{
+    Rlist *list = NULL;
+
+    uint32_t count = ReadCount(r);
+    for (uint32_t i = 0; i < count && !r->error; i++)
+    {
+        Rval rval = ReadRval(r);
+        if (!r->error)
+        {
+            RlistAppendRval(&list, rval);
+        }
+    }
+
+    if (r->error)
+    {
+        RlistDestroy(list);
+        return NULL;
+    }
+    return list;
+}
+
+/**
+ * Reads one constraint, appending it to #pp or #body, whichever is not NULL.
+ */
+static bool ReadConstraint(CacheReader *r, Promise *pp, Body *body)
+{
+    char *lval = ReadNonNullString(r);
+    char *classes = ReadNonNullString(r);
+    bool references_body = ReadU32(r);
+    SourceOffset offset = ReadOffset(r);
+    Rval rval = ReadRval(r);
+
+    if (r->error)
+    {
+        free(lval);
+        free(classes);
+        return false;
+    }
+
+    Constraint *cp;
+    if (pp != NULL)
+    {
+        cp = PromiseAppendConstraint(pp, lval, rval, references_body);
+        if (strcmp(cp->classes, classes) != 0)
+        {
+            free(cp->classes);
+            cp->classes = xstrdup(classes);
+        }
+    }
+    else
+    {
+        cp = BodyAppendConstraint(body, lval, rval, classes, references_body);
+    }
+    cp->offset = offset;
+
+    free(lval);
+    free(classes);
+    return true;
+}
+
+static bool ReadConstraints(CacheReader *r, Promise *pp, Body *body)
+{
+    uint32_t count = ReadCount(r);
+    for (uint32_t i = 0; i < count; i++)
+    {
+        if (!ReadConstraint(r, pp, body))
+        {
+            return false;
+        }
+    }
+    return !r->error;
+}
+
+static bool ReadPromise(CacheReader *r, PromiseType *tp)
+{
+    char *promiser = ReadNonNullString(r);
+    char *classes = ReadString(r);
+    char *comment = ReadString(r);
+    Rval promisee = ReadRval(r);
+    SourceOffset offset = ReadOffset(r);
+
+    if (r->error)
+    {
+        free(promiser);
+        free(classes);
+        free(comment);
+        RvalDestroy(promisee);
+        return false;
+    }
+
+    Promise *pp = PromiseTypeAppendPromise(tp, promiser, promisee, classes, NULL);
+    pp->comment = comment;
+    pp->offset = offset;
+
+    free(promiser);
+    free(classes);
+
+    return ReadConstraints(r, pp, NULL);
+}
+
+static bool ReadBundle(CacheReader *r, Policy *policy, const char *policy_file)
+{
+    char *ns = ReadNonNullString(r);
+    char *name = ReadNonNullString(r);
+    char *type = ReadNonNullString(r);
+    Rlist *args = ReadRlist(r);
+    SourceOffset offset = ReadOffset(r);
+
+    Bundle *bp = NULL;
+    if (!r->error)
+    {
+        bp = PolicyAppendBundle(policy, ns, name, type, args, policy_file);
+        bp->offset = offset;
+    }
+
+    free(ns);
+    free(name);
+    free(type);
+    RlistDestroy(args);
+
+    uint32_t types = ReadCount(r);
+    for (uint32_t i = 0; i < types && !r->error; i++)
+    {
+        char *type_name = ReadNonNullString(r);
+        SourceOffset type_offset = ReadOffset(r);
+        if (r->error)
+        {
+            free(type_name);
+            break;
+        }
+
+        PromiseType *tp = BundleAppendPromiseType(bp, type_name);
+        tp->offset = type_offset;
+        free(type_name);
+
+        uint32_t promises = ReadCount(r);
+        for (uint32_t j = 0; j < promises && !r->error; j++)
+        {
+            ReadPromise(r, tp);
+        }
+    }
+
+    return !r->error;
+}
+
+static bool ReadBody(CacheReader *r, Policy *policy, const char *policy_file)
+{
+    char *ns = ReadNonNullString(r);
+    char *name = ReadNonNullString(r);
+    char *type = ReadNonNullString(r);
+    Rlist *args = ReadRlist(r);
+    SourceOffset offset = ReadOffset(r);
+
+    if (r->error)
+    {
+        free(ns);
+        free(name);
+        free(type);
+        RlistDestroy(args);
+        return false;
+    }
+
+    Body *bp = PolicyAppendBody(policy, ns, name, type, args, policy_file);
+    bp->offset = offset;
+
+    free(ns);
+    free(name);
+    free(type);
+    RlistDestroy(args);
+
+    return ReadConstraints(r, NULL, bp);
+}
+
+/**
+ * @return The policy serialized in #data by PolicyCacheSerialize(), with
+ *         #policy_file as source path, or NULL if #data is not valid or was
+ *         written by another CFEngine version.
+ */
+Policy *PolicyCacheDeserialize(const char *data, size_t size,
+                               const char *policy_file)
+{
+    CacheReader r = { .data = data, .size = size, .pos = 0, .error = false };
+
+    char magic[sizeof(POLICY_CACHE_MAGIC) - 1];
+    if (!ReadBytes(&r, magic, sizeof(magic)) ||
+        memcmp(magic, POLICY_CACHE_MAGIC, sizeof(magic)) != 0 ||
+        ReadU32(&r) != POLICY_CACHE_BOM ||
+        ReadU32(&r) != POLICY_CACHE_FORMAT)
+    {
+        return NULL;
+    }
+
+    char *version = ReadString(&r);
+    bool same_version = (version != NULL && strcmp(version, Version()) == 0);
+    free(version);
+    if (!same_version)
+    {
+        return NULL;
+    }
+
+    Policy *policy = PolicyNew();
+
+    uint32_t bundles = ReadCount(&r);
+    for (uint32_t i = 0; i < bundles && !r.error; i++)
+    {
+        ReadBundle(&r, policy, policy_file);
+    }
+
+    uint32_t bodies = ReadCount(&r);
+    for (uint32_t i = 0; i < bodies && !r.error; i++)
+    {
+        ReadBody(&r, policy, policy_file);
+    }
+
+    if (r.error || r.pos != r.size)
+    {
+        PolicyDestroy(policy);
+        return NULL;
+    }
+
+    return policy;
+}
+
+/*********************************************************************/
+/* Cache files                                                       */
+/*********************************************************************/
+
+static void PolicyCacheFilePath(char *path, size_t path_size,
+                                const char *digest, AgentType agent_type)
+{
+    snprintf(path, path_size, "%s%c%s%c%s.%s",
+             GetStateDir(), FILE_SEPARATOR, POLICY_CACHE_DIR, FILE_SEPARATOR,
+             digest, CF_AGENTTYPES[agent_type]);
+}
+
+/**
+ * @return The cached policy of #policy_file, whose digest is #digest, or
+ *         NULL if it's not in the cache.
+ */
+Policy *PolicyCacheLoad(const char *policy_file, const char *digest,
+                        AgentType agent_type)
+{
+    char path[CF_BUFSIZE];
+    PolicyCacheFilePath(path, sizeof(path), digest, agent_type);
+
+    int fd = safe_open(path, O_RDONLY | O_BINARY);
+    if (fd == -1)
+    {
+        return NULL;
+    }
+
+    struct stat sb;
+    if (fstat(fd, &sb) == -1 || sb.st_size > POLICY_CACHE_MAX_SIZE)
+    {
+        close(fd);
+        return NULL;
+    }
+
+    char *data = xmalloc(sb.st_size + 1);
+    bool read_ok = (FullRead(fd, data, sb.st_size) == sb.st_size);
+    close(fd);
+
+    Policy *policy = NULL;
+    if (read_ok)
+    {
+        policy = PolicyCacheDeserialize(data, sb.st_size, policy_file);
+    }
+    free(data);
+
+    if (policy == NULL)
+    {
+        Log(LOG_LEVEL_VERBOSE,
+            "Ignoring invalid or outdated policy cache file '%s'", path);
+        unlink(path);
+        return NULL;
+    }
+
+    /* Keep it from being purged as unused. */
+    time_t now = time(NULL);
+    if (sb.st_mtime < now - POLICY_CACHE_TOUCH_INTERVAL)
+    {
+        utime(path, NULL);
+    }
+
+    Log(LOG_LEVEL_DEBUG, "Loaded policy file '%s' from cache '%s'",
+        policy_file, path);
+    return policy;
+}
+
+static void PolicyCachePurge(const char *dirname)
+{
+    Dir *dirh = DirOpen(dirname);
+    if (dirh == NULL)
+    {
+        return;
+    }
+
+    time_t oldest = time(NULL) - POLICY_CACHE_MAX_AGE;
+    for (const struct dirent *dirp = DirRead(dirh); dirp != NULL;
+         dirp = DirRead(dirh))
+    {
+        if (dirp->d_name[0] == '.')
+        {
+            continue;
+        }
+
+        char path[CF_BUFSIZE];
+        int ret = snprintf(path, sizeof(path), "%s%c%s",
+                           dirname, FILE_SEPARATOR, dirp->d_name);
+        if (ret < 0 || (size_t) ret >= sizeof(path))
+        {
+            continue;
+        }
+
+        struct stat sb;
+        if (lstat(path, &sb) == 0 && S_ISREG(sb.st_mode) &&
+            sb.st_mtime < oldest)
+        {
+            Log(LOG_LEVEL_DEBUG, "Removing unused policy cache file '%s'", path);
+            unlink(path);
+        }
+    }
+
+    DirClose(dirh);
+}
+
+/**
+ * Cache #policy, parsed from a policy file whose digest is #digest. Failing
+ * to do so is not an error, the file is just parsed again next time.
+ */
+bool PolicyCacheStore(const Policy *policy, const char *digest,
+                      AgentType agent_type)
+{
+    char dirname[CF_BUFSIZE];
+    snprintf(dirname, sizeof(dirname), "%s%c%s",
+             GetStateDir(), FILE_SEPARATOR, POLICY_CACHE_DIR);
+    if (mkdir(dirname, 0700) == -1 && errno != EEXIST)
+    {
+        Log(LOG_LEVEL_VERBOSE,
+            "Unable to create policy cache directory '%s' (mkdir: %s)",
+            dirname, GetErrorStr());
+        return false;
+    }
+
+    char path[CF_BUFSIZE], tmp_path[CF_BUFSIZE];
+    PolicyCacheFilePath(path, sizeof(path), digest, agent_type);
+    int ret = snprintf(tmp_path, sizeof(tmp_path), "%s.%ju.tmp",
+                       path, (uintmax_t) getpid());
+    if (ret < 0 || (size_t) ret >= sizeof(tmp_path))
+    {
+        Log(LOG_LEVEL_VERBOSE,
+            "Policy cache file path '%s' is too long", path);
+        return false;
+    }
+
+    Buffer *data = BufferNew();
+    PolicyCacheSerialize(policy, data);
+
+    int fd = safe_open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC | O_BINARY, 0600);
+    bool ok = (fd != -1);
+    if (ok)
+    {
+        ok = (FullWrite(fd, BufferData(data), BufferSize(data)) ==
+              (ssize_t) BufferSize(data));
+        ok = (close(fd) == 0) && ok;
+    }
+    ok = ok && (rename(tmp_path, path) == 0);
+    BufferDestroy(data);
+
+    if (!ok)
+    {
+        Log(LOG_LEVEL_VERBOSE,
+            "Unable to write policy cache file '%s' (%s)",
+            path, GetErrorStr());
+        unlink(tmp_path);
+        return false;
+    }
+
+    Log(LOG_LEVEL_DEBUG, "Stored policy cache file '%s'", path);
+
+    /* Policy files only change now and then, and so do cache files. */
+    PolicyCachePurge(dirname);
+    return true;
+}
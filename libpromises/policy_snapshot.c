@@ -0,0 +1,889 @@
+/*
+   Copyright 2018 Northern.tech AS
+
+   This file is part of CFEngine 3 - written and maintained by Northern.tech AS.
+
+   This program is free software; you can redistribute it and/or modify it
+   under the terms of the GNU General Public License as published by the
+   Free Software Foundation; version 3.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA
+
+  To the extent this program is licensed as part of the Enterprise
+  versions of CFEngine, the applicable Commercial Open Source License
+  (COSL) may apply to this file if you as a licensee so wish it. See
+  included file COSL.txt.
+*/
+
+#include <policy_snapshot.h>
+
+#include <openssl/evp.h>
+
+#include <alloc.h>
+#include <logging.h>
+#include <dir.h>
+#include <map.h>
+#include <string_lib.h>
+#include <file_lib.h>                   /* safe_open, DeleteDirectoryTree */
+#include <files_lib.h>                  /* MakeParentDirectory */
+#include <files_copy.h>                 /* CopyRegularFileDisk */
+#include <files_hashes.h>               /* HashFile, HashPrintSafe */
+#include <client_code.h>                /* CopyRegularFileNet */
+#include <stat_cache.h>                 /* cf_remote_stat */
+
+
+/**
+   A policy snapshot is a single archive holding the contents of all files
+   of a tagged policy directory, plus a text index describing them:
+
+       release_id <release ID>
+       <digest> <offset> <size> <mode> <path>
+       ...
+
+   Identical files are stored only once in the archive. Agents fetch the
+   index, and then only the members whose digest differs from the files
+   they already have, see PolicySnapshotUpdate().
+
+   Only regular files are carried. A policy directory holding anything
+   else, like symbolic links or empty directories, is not published as a
+   snapshot, and agents copy it file by file instead.
+*/
+
+/* Fixed, so that hub and agents agree regardless of FIPS mode. */
+#define POLICY_SNAPSHOT_HASH HASH_METHOD_SHA256
+
+
+static void PolicySnapshotEntryDestroy(PolicySnapshotEntry *entry)
+{
+    if (entry != NULL)
+    {
+        free(entry->path);
+        free(entry);
+    }
+}
+
+void PolicySnapshotIndexDestroy(PolicySnapshotIndex *index)
+{
+    if (index != NULL)
+    {
+        free(index->release_id);
+        SeqDestroy(index->entries);
+        free(index);
+    }
+}
+
+/**
+ * snprintf() a path into #path, of size CF_BUFSIZE.
+ * @return false, having logged it, if the path doesn't fit.
+ */
+static bool PathPrintf(char *path, const char *fmt, ...) FUNC_ATTR_PRINTF(2, 3);
+
+static bool PathPrintf(char *path, const char *fmt, ...)
+{
+    va_list ap;
+    va_start(ap, fmt);
+    int ret = vsnprintf(path, CF_BUFSIZE, fmt, ap);
+    va_end(ap);
+
+    if (ret < 0 || ret >= CF_BUFSIZE)
+    {
+        Log(LOG_LEVEL_ERR, "Path too long for policy snapshot: '%s'", path);
+        return false;
+    }
+    return true;
+}
+
+static bool IsSnapshotFile(const char *name)
+{
+    return StringStartsWith(name, POLICY_SNAPSHOT_FILE);
+}
+
+/**
+ * Paths in the index come from the network, make sure they can't escape
+ * the directory they are extracted to.
+ */
+static bool IsSafeRelativePath(const char *path)
+{
+    if (path[0] == '\0' || IsAbsoluteFileName(path))
+    {
+        return false;
+    }
+
+    const char *component = path;
+    while (component != NULL)
+    {
+        const char *next = strchr(component, '/');
+        size_t len = (next == NULL) ? strlen(component) : (size_t) (next - component);
+
+        if (len == 0 ||
+            (len == 1 && component[0] == '.') ||
+            (len == 2 && component[0] == '.' && component[1] == '.'))
+        {
+            return false;
+        }
+
+        component = (next == NULL) ? NULL : next + 1;
+    }
+
+    return true;
+}
+
+/*****************************************************************************/
+/*                          Writing, on the hub                              */
+/*****************************************************************************/
+
+/**
+ * Append to #files the paths, relative to #dirname, of all regular files
+ * under #dirname/#relpath.
+ *
+ * @return false if the tree can't be read, or holds anything the snapshot
+ *         can't carry: symbolic links, empty directories or other special
+ *         files.
+ */
+static bool CollectPolicyFiles(const char *dirname, const char *relpath,
+                               Seq *files)
+{
+    char path[CF_BUFSIZE];
+    if (relpath == NULL)
+    {
+        strlcpy(path, dirname, sizeof(path));
+    }
+    else if (!PathPrintf(path, "%s/%s", dirname, relpath))
+    {
+        return false;
+    }
+
+    Dir *dirh = DirOpen(path);
+    if (dirh == NULL)
+    {
+        Log(LOG_LEVEL_ERR,
+            "Unable to open directory '%s' for policy snapshot (opendir: %s)",
+            path, GetErrorStr());
+        return false;
+    }
+
+    const size_t num_files = SeqLength(files);
+    bool ok = true;
+    for (const struct dirent *dirp = DirRead(dirh); ok && dirp != NULL;
+         dirp = DirRead(dirh))
+    {
+        const char *name = dirp->d_name;
+        if (strcmp(name, ".") == 0 || strcmp(name, "..") == 0 ||
+            strcmp(name, ".git") == 0 ||
+            (relpath == NULL && IsSnapshotFile(name)))
+        {
+            continue;
+        }
+
+        char *subrel;
+        if (relpath == NULL)
+        {
+            subrel = xstrdup(name);
+        }
+        else
+        {
+            xasprintf(&subrel, "%s/%s", relpath, name);
+        }
+
+        char subpath[CF_BUFSIZE];
+        struct stat sb;
+        if (!PathPrintf(subpath, "%s/%s", dirname, subrel))
+        {
+            ok = false;
+            free(subrel);
+        }
+        else if (lstat(subpath, &sb) == -1)
+        {
+            Log(LOG_LEVEL_ERR, "Unable to stat '%s' (lstat: %s)",
+                subpath, GetErrorStr());
+            ok = false;
+            free(subrel);
+        }
+        else if (S_ISDIR(sb.st_mode))
+        {
+            ok = CollectPolicyFiles(dirname, subrel, files);
+            free(subrel);
+        }
+        else if (S_ISREG(sb.st_mode) && strchr(subrel, '\n') == NULL)
+        {
+            SeqAppend(files, subrel);
+        }
+        else
+        {
+            Log(LOG_LEVEL_INFO,
+                "Policy snapshot can't carry '%s', not a regular file",
+                subpath);
+            ok = false;
+            free(subrel);
+        }
+    }
+
+    DirClose(dirh);
+
+    if (ok && relpath != NULL && SeqLength(files) == num_files)
+    {
+        Log(LOG_LEVEL_INFO,
+            "Policy snapshot can't carry empty directory '%s'", path);
+        ok = false;
+    }
+    return ok;
+}
+
+/**
+ * Remove the snapshot of #dirname, the index first so that agents stop
+ * looking for the archive.
+ */
+static void RemoveSnapshot(const char *dirname)
+{
+    char path[CF_BUFSIZE];
+    if (PathPrintf(path, "%s/%s", dirname, POLICY_SNAPSHOT_INDEX_FILE))
+    {
+        unlink(path);
+    }
+    if (PathPrintf(path, "%s/%s", dirname, POLICY_SNAPSHOT_FILE))
+    {
+        unlink(path);
+    }
+}
+
+/**
+ * Append file #path to the archive #archive_fd, hashing it on the way.
+ */
+static bool AppendToArchive(int archive_fd, const char *path,
+                            char digest[CF_HOSTKEY_STRING_SIZE], off_t *size)
+{
+    int fd = safe_open(path, O_RDONLY | O_BINARY);
+    if (fd == -1)
+    {
+        Log(LOG_LEVEL_ERR, "Unable to open '%s' for policy snapshot (open: %s)",
+            path, GetErrorStr());
+        return false;
+    }
+
+    EVP_MD_CTX *crypto_ctx = EVP_MD_CTX_new();
+    if (crypto_ctx == NULL)
+    {
+        Log(LOG_LEVEL_ERR, "Failed to allocate openssl hashing context");
+        close(fd);
+        return false;
+    }
+    EVP_DigestInit(crypto_ctx,
+                   EVP_get_digestbyname(HashNameFromId(POLICY_SNAPSHOT_HASH)));
+
+    bool ok = true;
+    char buf[CF_BUFSIZE];
+    ssize_t n_read;
+    *size = 0;
+    while ((n_read = read(fd, buf, sizeof(buf))) > 0)
+    {
+        if (FullWrite(archive_fd, buf, n_read) != n_read)
+        {
+            Log(LOG_LEVEL_ERR, "Unable to write policy snapshot (write: %s)",
+                GetErrorStr());
+            ok = false;
+            break;
+        }
+        EVP_DigestUpdate(crypto_ctx, buf, n_read);
+        *size += n_read;
+    }
+    if (n_read == -1)
+    {
+        Log(LOG_LEVEL_ERR, "Unable to read '%s' for policy snapshot (read: %s)",
+            path, GetErrorStr());
+        ok = false;
+    }
+
+    unsigned char md[EVP_MAX_MD_SIZE + 1] = { 0 };
+    unsigned int md_len;
+    EVP_DigestFinal(crypto_ctx, md, &md_len);
+    EVP_MD_CTX_free(crypto_ctx);
+    close(fd);
+
+    HashPrintSafe(digest, CF_HOSTKEY_STRING_SIZE, md,
+                  POLICY_SNAPSHOT_HASH, true);
+    return ok;
+}
+
+/**
+ * @brief Write the snapshot archive and index of policy directory #dirname,
+ *        replacing any previous snapshot in there.
+ * @return true if successful. Otherwise no snapshot is left in #dirname,
+ *         since a previous one would be outdated.
+ */
+bool PolicySnapshotWrite(const char *dirname, const char *release_id)
+{
+    assert(release_id != NULL);
+
+    char archive[CF_BUFSIZE], archive_tmp[CF_BUFSIZE];
+    char index[CF_BUFSIZE], index_tmp[CF_BUFSIZE];
+    Seq *files = SeqNew(500, free);
+    if (!PathPrintf(archive, "%s/%s", dirname, POLICY_SNAPSHOT_FILE) ||
+        !PathPrintf(archive_tmp, "%s.tmp", archive) ||
+        !PathPrintf(index, "%s/%s", dirname, POLICY_SNAPSHOT_INDEX_FILE) ||
+        !PathPrintf(index_tmp, "%s.tmp", index) ||
+        !CollectPolicyFiles(dirname, NULL, files))
+    {
+        Log(LOG_LEVEL_VERBOSE, "Not publishing a policy snapshot of '%s'",
+            dirname);
+        RemoveSnapshot(dirname);
+        SeqDestroy(files);
+        return false;
+    }
+    SeqSort(files, (SeqItemComparator) strcmp, NULL);
+
+    unlink(archive_tmp);
+    unlink(index_tmp);
+
+    int archive_fd = safe_open(archive_tmp,
+                               O_WRONLY | O_CREAT | O_EXCL | O_BINARY, 0600);
+    if (archive_fd == -1)
+    {
+        Log(LOG_LEVEL_ERR, "Unable to create policy snapshot '%s' (open: %s)",
+            archive_tmp, GetErrorStr());
+        RemoveSnapshot(dirname);
+        SeqDestroy(files);
+        return false;
+    }
+
+    FILE *index_fp = safe_fopen(index_tmp, "w");
+    if (index_fp == NULL)
+    {
+        Log(LOG_LEVEL_ERR,
+            "Unable to create policy snapshot index '%s' (fopen: %s)",
+            index_tmp, GetErrorStr());
+        close(archive_fd);
+        unlink(archive_tmp);
+        RemoveSnapshot(dirname);
+        SeqDestroy(files);
+        return false;
+    }
+
+    fprintf(index_fp, "release_id %s\n", release_id);
+
+    /* digest -> offset of the contents already in the archive */
+    StringMap *stored = StringMapNew();
+    off_t archive_size = 0;
+    bool ok = true;
+
+    for (size_t i = 0; ok && i < SeqLength(files); i++)
+    {
+        const char *relpath = SeqAt(files, i);
+        char path[CF_BUFSIZE];
+        struct stat sb;
+        char digest[CF_HOSTKEY_STRING_SIZE];
+        off_t size;
+        if (!PathPrintf(path, "%s/%s", dirname, relpath) ||
+            stat(path, &sb) == -1 ||
+            !AppendToArchive(archive_fd, path, digest, &size))
+        {
+            ok = false;
+            break;
+        }
+
+        off_t offset = archive_size;
+        const char *prev = StringMapGet(stored, digest);
+        if (prev != NULL)
+        {
+            /* Already in there, drop the copy we just appended. */
+            offset = (off_t) strtoimax(prev, NULL, 10);
+            if (ftruncate(archive_fd, archive_size) == -1 ||
+                lseek(archive_fd, archive_size, SEEK_SET) == (off_t) -1)
+            {
+                Log(LOG_LEVEL_ERR,
+                    "Unable to truncate policy snapshot '%s' (ftruncate: %s)",
+                    archive_tmp, GetErrorStr());
+                ok = false;
+                break;
+            }
+        }
+        else
+        {
+            char *offset_str;
+            xasprintf(&offset_str, "%jd", (intmax_t) offset);
+            StringMapInsert(stored, xstrdup(digest), offset_str);
+            archive_size += size;
+        }
+
+        fprintf(index_fp, "%s %jd %jd %04o %s\n", digest,
+                (intmax_t) offset, (intmax_t) size,
+                (unsigned int) (sb.st_mode & 07777), relpath);
+    }
+
+    Log(LOG_LEVEL_VERBOSE,
+        "Policy snapshot of '%s': %zu files, %zu distinct, %jd bytes",
+        dirname, SeqLength(files), StringMapSize(stored),
+        (intmax_t) archive_size);
+
+    StringMapDestroy(stored);
+    SeqDestroy(files);
+
+    if (close(archive_fd) == -1)
+    {
+        ok = false;
+    }
+    if (fclose(index_fp) != 0)
+    {
+        ok = false;
+    }
+
+    /* The archive goes first, so that an index is never newer than it. */
+    if (!ok ||
+        rename(archive_tmp, archive) == -1 ||
+        rename(index_tmp, index) == -1)
+    {
+        Log(LOG_LEVEL_ERR, "Failed to write policy snapshot of '%s'", dirname);
+        unlink(archive_tmp);
+        unlink(index_tmp);
+        RemoveSnapshot(dirname);
+        return false;
+    }
+
+    Log(LOG_LEVEL_VERBOSE, "Saved policy snapshot '%s'", archive);
+    return true;
+}
+
+/*****************************************************************************/
+/*                                 Index                                     */
+/*****************************************************************************/
+
+static PolicySnapshotEntry *ParseIndexLine(const char *line)
+{
+    char digest[CF_HOSTKEY_STRING_SIZE];
+    intmax_t offset, size;
+    unsigned int mode;
+    int path_start = 0;
+
+    /* Width is CF_HOSTKEY_STRING_SIZE - 1. */
+    int ret = sscanf(line, "%132s %jd %jd %o %n",
+                     digest, &offset, &size, &mode, &path_start);
+    if (ret != 4 || path_start == 0 || offset < 0 || size < 0 ||
+        !IsSafeRelativePath(line + path_start))
+    {
+        return NULL;
+    }
+
+    PolicySnapshotEntry *entry = xcalloc(1, sizeof(*entry));
+    entry->path = xstrdup(line + path_start);
+    strlcpy(entry->digest, digest, sizeof(entry->digest));
+    entry->offset = offset;
+    entry->size = size;
+    entry->mode = mode & 07777;
+    return entry;
+}
+
+/**
+ * @return the parsed index, or NULL if #filename does not exist or is not
+ *         a valid snapshot index.
+ */
+PolicySnapshotIndex *PolicySnapshotIndexLoad(const char *filename)
+{
+    FILE *fp = safe_fopen(filename, "r");
+    if (fp == NULL)
+    {
+        Log(LOG_LEVEL_DEBUG, "Could not open policy snapshot index '%s' (fopen: %s)",
+            filename, GetErrorStr());
+        return NULL;
+    }
+
+    PolicySnapshotIndex *index = xcalloc(1, sizeof(*index));
+    index->entries = SeqNew(500, PolicySnapshotEntryDestroy);
+
+    char *line = NULL;
+    size_t line_size = 0;
+    bool ok = true;
+    ssize_t len;
+    while ((len = CfReadLine(&line, &line_size, fp)) != -1)
+    {
+        if (index->release_id == NULL)
+        {
+            if (!StringStartsWith(line, "release_id ") ||
+                line[strlen("release_id ")] == '\0')
+            {
+                ok = false;
+                break;
+            }
+            index->release_id = xstrdup(line + strlen("release_id "));
+            continue;
+        }
+
+        PolicySnapshotEntry *entry = ParseIndexLine(line);
+        if (entry == NULL)
+        {
+            Log(LOG_LEVEL_ERR, "Invalid line in policy snapshot index '%s': %s",
+                filename, line);
+            ok = false;
+            break;
+        }
+        SeqAppend(index->entries, entry);
+    }
+
+    if (ok && !feof(fp))
+    {
+        Log(LOG_LEVEL_ERR, "Unable to read policy snapshot index '%s' (fread: %s)",
+            filename, GetErrorStr());
+        ok = false;
+    }
+
+    free(line);
+    fclose(fp);
+
+    if (!ok || index->release_id == NULL)
+    {
+        PolicySnapshotIndexDestroy(index);
+        return NULL;
+    }
+
+    return index;
+}
+
+/*****************************************************************************/
+/*                          Updating, on agents                              */
+/*****************************************************************************/
+
+static bool FileHasDigest(const char *path, off_t size, const char *digest)
+{
+    struct stat sb;
+    if (stat(path, &sb) == -1 || !S_ISREG(sb.st_mode) || sb.st_size != size)
+    {
+        return false;
+    }
+
+    unsigned char md[EVP_MAX_MD_SIZE + 1] = { 0 };
+    char file_digest[CF_HOSTKEY_STRING_SIZE];
+    HashFile(path, md, POLICY_SNAPSHOT_HASH);
+    HashPrintSafe(file_digest, sizeof(file_digest), md,
+                  POLICY_SNAPSHOT_HASH, true);
+
+    return strcmp(file_digest, digest) == 0;
+}
+
+/**
+ * The release ID alone is not enough: hubs that don't track releases keep
+ * the same one across edits, and somebody could have edited or removed the
+ * local files. Every file listed in #index must be present in #local_dir
+ * with the digest and mode the server published.
+ */
+static bool LocalFilesMatchIndex(const char *local_dir,
+                                 const PolicySnapshotIndex *local,
+                                 const PolicySnapshotIndex *index)
+{
+    if (SeqLength(local->entries) != SeqLength(index->entries))
+    {
+        return false;
+    }
+
+    StringMap *local_digests = StringMapNew();          /* path -> digest */
+    for (size_t i = 0; i < SeqLength(local->entries); i++)
+    {
+        const PolicySnapshotEntry *entry = SeqAt(local->entries, i);
+        StringMapInsert(local_digests, xstrdup(entry->path),
+                        xstrdup(entry->digest));
+    }
+
+    bool match = true;
+    for (size_t i = 0; match && i < SeqLength(index->entries); i++)
+    {
+        const PolicySnapshotEntry *entry = SeqAt(index->entries, i);
+        const char *local_digest = StringMapGet(local_digests, entry->path);
+        if (local_digest == NULL || strcmp(local_digest, entry->digest) != 0)
+        {
+            match = false;
+            continue;
+        }
+
+        char path[CF_BUFSIZE];
+        struct stat sb;
+        match = (PathPrintf(path, "%s/%s", local_dir, entry->path) &&
+                 stat(path, &sb) == 0 &&
+                 (sb.st_mode & 07777) == entry->mode &&
+                 FileHasDigest(path, entry->size, entry->digest));
+    }
+
+    StringMapDestroy(local_digests);
+    return match;
+}
+
+static bool RemoveDirectory(const char *path)
+{
+    struct stat sb;
+    if (lstat(path, &sb) == -1)
+    {
+        return (errno == ENOENT);
+    }
+
+    if (!DeleteDirectoryTree(path) || rmdir(path) == -1)
+    {
+        Log(LOG_LEVEL_ERR, "Unable to remove directory '%s' (rmdir: %s)",
+            path, GetErrorStr());
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Create file #staged for #entry, from the local copy if it's unchanged,
+ * from a member already fetched in this update, or from the server.
+ */
+static bool StageEntry(AgentConnection *conn, const char *remote_archive,
+                       const char *local_dir, const char *staged,
+                       const PolicySnapshotEntry *entry, StringMap *fetched,
+                       size_t *num_fetched)
+{
+    char local[CF_BUFSIZE];
+    if (!PathPrintf(local, "%s/%s", local_dir, entry->path) ||
+        !MakeParentDirectory(staged, false))
+    {
+        return false;
+    }
+
+    const char *already = StringMapGet(fetched, entry->digest);
+    if (already != NULL)
+    {
+        if (!CopyRegularFileDisk(already, staged))
+        {
+            return false;
+        }
+    }
+    else if (FileHasDigest(local, entry->size, entry->digest))
+    {
+        if (!CopyRegularFileDisk(local, staged))
+        {
+            return false;
+        }
+    }
+    else if (entry->size == 0)
+    {
+        int fd = safe_open(staged, O_WRONLY | O_CREAT | O_EXCL | O_BINARY, 0600);
+        if (fd == -1)
+        {
+            Log(LOG_LEVEL_ERR, "Unable to create '%s' (open: %s)",
+                staged, GetErrorStr());
+            return false;
+        }
+        close(fd);
+    }
+    else
+    {
+        Log(LOG_LEVEL_VERBOSE, "Fetching '%s' from policy snapshot on '%s'",
+            entry->path, conn->this_server);
+
+        if (!CopyRegularFileRangeNet(remote_archive, staged,
+                                     entry->offset, entry->size, conn) ||
+            !FileHasDigest(staged, entry->size, entry->digest))
+        {
+            Log(LOG_LEVEL_ERR,
+                "Failed to fetch '%s' from policy snapshot on '%s'",
+                entry->path, conn->this_server);
+
+            /* The stream may be out of sync, don't use this connection
+             * any more. */
+            conn->error = true;
+            return false;
+        }
+        (*num_fetched)++;
+    }
+
+    if (chmod(staged, entry->mode) == -1)
+    {
+        Log(LOG_LEVEL_ERR, "Unable to set mode of '%s' (chmod: %s)",
+            staged, GetErrorStr());
+        return false;
+    }
+
+    if (already == NULL)
+    {
+        StringMapInsert(fetched, xstrdup(entry->digest), xstrdup(staged));
+    }
+    return true;
+}
+
+/**
+ * Put directory #staging in place of #local_dir. Where renameat2() can
+ * exchange them, that's a single atomic step, and the previous tree ends up
+ * in #staging. Otherwise the previous tree is moved to #retired first, and
+ * #local_dir is missing for a moment.
+ */
+static bool SwapInDirectory(const char *staging, const char *local_dir,
+                            const char *retired)
+{
+    struct stat sb;
+    bool had_local = (lstat(local_dir, &sb) == 0);
+
+#if defined(HAVE_RENAMEAT2) && defined(RENAME_EXCHANGE)
+    if (had_local)
+    {
+        if (renameat2(AT_FDCWD, staging, AT_FDCWD, local_dir,
+                      RENAME_EXCHANGE) == 0)
+        {
+            return true;
+        }
+        if (errno != EINVAL && errno != ENOSYS)
+        {
+            Log(LOG_LEVEL_ERR, "Unable to swap '%s' into place (renameat2: %s)",
+                staging, GetErrorStr());
+            return false;
+        }
+        /* Not supported by the file system. */
+    }
+#endif
+
+    if (had_local && rename(local_dir, retired) == -1)
+    {
+        Log(LOG_LEVEL_ERR, "Unable to move '%s' out of the way (rename: %s)",
+            local_dir, GetErrorStr());
+        return false;
+    }
+    if (rename(staging, local_dir) == -1)
+    {
+        Log(LOG_LEVEL_ERR, "Unable to move '%s' into place (rename: %s)",
+            staging, GetErrorStr());
+        if (had_local && rename(retired, local_dir) == -1)
+        {
+            Log(LOG_LEVEL_ERR, "Unable to restore '%s' (rename: %s)",
+                local_dir, GetErrorStr());
+        }
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Bring #local_dir up to date with the policy snapshot published in
+ *        #remote_dir on the server of #conn.
+ *
+ * The new tree is assembled next to #local_dir, reusing unchanged local
+ * files, and then swapped into place, so that #local_dir never holds a mix
+ * of two releases, see SwapInDirectory(). Files not in the snapshot are not
+ * kept.
+ */
+PolicySnapshotResult PolicySnapshotUpdate(AgentConnection *conn,
+                                          const char *remote_dir,
+                                          const char *local_dir)
+{
+    char remote_index[CF_BUFSIZE], remote_archive[CF_BUFSIZE];
+    char staging[CF_BUFSIZE], retired[CF_BUFSIZE];
+    char staged_index[CF_BUFSIZE], local_index[CF_BUFSIZE];
+    if (!PathPrintf(remote_index, "%s/%s",
+                    remote_dir, POLICY_SNAPSHOT_INDEX_FILE) ||
+        !PathPrintf(remote_archive, "%s/%s",
+                    remote_dir, POLICY_SNAPSHOT_FILE) ||
+        !PathPrintf(staging, "%s.snapshot.%ju",
+                    local_dir, (uintmax_t) getpid()) ||
+        !PathPrintf(retired, "%s.retired.%ju",
+                    local_dir, (uintmax_t) getpid()) ||
+        !PathPrintf(staged_index, "%s/%s",
+                    staging, POLICY_SNAPSHOT_INDEX_FILE) ||
+        !PathPrintf(local_index, "%s/%s",
+                    local_dir, POLICY_SNAPSHOT_INDEX_FILE))
+    {
+        return POLICY_SNAPSHOT_FAILED;
+    }
+
+    struct stat sb;
+    if (cf_remote_stat(conn, false, remote_index, &sb, "file") == -1 ||
+        !S_ISREG(sb.st_mode))
+    {
+        Log(LOG_LEVEL_VERBOSE, "No policy snapshot found at '%s:%s'",
+            conn->this_server, remote_index);
+        return POLICY_SNAPSHOT_UNAVAILABLE;
+    }
+
+    if (!RemoveDirectory(staging) || !RemoveDirectory(retired))
+    {
+        return POLICY_SNAPSHOT_FAILED;
+    }
+
+    /* The staging directory is renamed into place, give it the mode the
+     * final directory should have rather than relying on the umask. */
+    mode_t dir_mode = DEFAULTMODE;
+    if (stat(local_dir, &sb) == 0 && S_ISDIR(sb.st_mode))
+    {
+        dir_mode = sb.st_mode & 07777;
+    }
+    if (mkdir(staging, 0700) == -1)
+    {
+        Log(LOG_LEVEL_ERR, "Unable to create directory '%s' (mkdir: %s)",
+            staging, GetErrorStr());
+        return POLICY_SNAPSHOT_FAILED;
+    }
+
+    PolicySnapshotIndex *index = NULL;
+    PolicySnapshotIndex *local = NULL;
+    PolicySnapshotResult result = POLICY_SNAPSHOT_FAILED;
+
+    if (!CopyRegularFileNet(remote_index, staged_index, sb.st_size,
+                            false, conn))
+    {
+        goto end;
+    }
+
+    index = PolicySnapshotIndexLoad(staged_index);
+    if (index == NULL)
+    {
+        Log(LOG_LEVEL_ERR, "Invalid policy snapshot index from '%s:%s'",
+            conn->this_server, remote_index);
+        goto end;
+    }
+
+    local = PolicySnapshotIndexLoad(local_index);
+    if (local != NULL &&
+        strcmp(local->release_id, index->release_id) == 0 &&
+        LocalFilesMatchIndex(local_dir, local, index))
+    {
+        Log(LOG_LEVEL_VERBOSE, "Policy in '%s' is already at release '%s'",
+            local_dir, index->release_id);
+        result = POLICY_SNAPSHOT_UNCHANGED;
+        goto end;
+    }
+
+    StringMap *fetched = StringMapNew();                /* digest -> path */
+    size_t num_fetched = 0;
+    bool ok = true;
+    for (size_t i = 0; ok && i < SeqLength(index->entries); i++)
+    {
+        const PolicySnapshotEntry *entry = SeqAt(index->entries, i);
+        char staged[CF_BUFSIZE];
+        ok = (PathPrintf(staged, "%s/%s", staging, entry->path) &&
+              StageEntry(conn, remote_archive, local_dir, staged, entry,
+                         fetched, &num_fetched));
+    }
+    StringMapDestroy(fetched);
+
+    if (!ok)
+    {
+        goto end;
+    }
+
+    if (chmod(staging, dir_mode) == -1)
+    {
+        Log(LOG_LEVEL_ERR, "Unable to set mode of '%s' (chmod: %s)",
+            staging, GetErrorStr());
+        goto end;
+    }
+
+    if (!SwapInDirectory(staging, local_dir, retired))
+    {
+        goto end;
+    }
+
+    Log(LOG_LEVEL_INFO,
+        "Updated '%s' to policy release '%s' from '%s'"
+        " (%zu files, %zu fetched)",
+        local_dir, index->release_id, conn->this_server,
+        SeqLength(index->entries), num_fetched);
+    result = POLICY_SNAPSHOT_UPDATED;
+
+  end:
+    RemoveDirectory(staging);
+    RemoveDirectory(retired);
+    PolicySnapshotIndexDestroy(index);
+    PolicySnapshotIndexDestroy(local);
+    return result;
+}
@@ -0,0 +1,73 @@
+/*
+   Copyright 2018 Northern.tech AS
+
+   This file is part of CFEngine 3 - written and maintained by Northern.tech AS.
+
+   This program is free software; you can redistribute it and/or modify it
+   under the terms of the GNU General Public License as published by the
+   Free Software Foundation; version 3.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA
+
+  To the extent this program is licensed as part of the Enterprise
+  versions of CFEngine, the applicable Commercial Open Source License
+  (COSL) may apply to this file if you as a licensee so wish it. See
+  included file COSL.txt.
+*/
+
+#ifndef CFENGINE_POLICY_SNAPSHOT_H
+#define CFENGINE_POLICY_SNAPSHOT_H
+
+
+#include <cf3.defs.h>
+#include <files_hashes.h>                        /* CF_HOSTKEY_STRING_SIZE */
+#include <sequence.h>
+
+
+/* Both live at the top of the tagged policy directory. */
+#define POLICY_SNAPSHOT_FILE       "cf_promises_snapshot"
+#define POLICY_SNAPSHOT_INDEX_FILE "cf_promises_snapshot_index"
+
+
+typedef struct
+{
+    char *path;                         /* relative to the policy directory */
+    char digest[CF_HOSTKEY_STRING_SIZE];
+    off_t offset;                       /* of the contents in the archive */
+    off_t size;
+    mode_t mode;
+} PolicySnapshotEntry;
+
+typedef struct
+{
+    char *release_id;
+    Seq *entries;                       /* of PolicySnapshotEntry */
+} PolicySnapshotIndex;
+
+typedef enum
+{
+    POLICY_SNAPSHOT_UPDATED,
+    POLICY_SNAPSHOT_UNCHANGED,
+    POLICY_SNAPSHOT_UNAVAILABLE,        /* server publishes no snapshot */
+    POLICY_SNAPSHOT_FAILED
+} PolicySnapshotResult;
+
+
+bool PolicySnapshotWrite(const char *dirname, const char *release_id);
+
+PolicySnapshotIndex *PolicySnapshotIndexLoad(const char *filename);
+void PolicySnapshotIndexDestroy(PolicySnapshotIndex *index);
+
+PolicySnapshotResult PolicySnapshotUpdate(AgentConnection *conn,
+                                          const char *remote_dir,
+                                          const char *local_dir);
+
+
+#endif
@@ -0,0 +1,615 @@
+/*
+   Copyright 2018 Northern.tech AS
+
+   This file is part of CFEngine 3 - written and maintained by Northern.tech AS.
+
+   This program is free software; you can redistribute it and/or modify it
+   under the terms of the GNU General Public License as published by the
+   Free Software Foundation; version 3.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA
+
+  To the extent this program is licensed as part of the Enterprise
+  versions of CFEngine, the applicable Commercial Open Source License
+  (COSL) may apply to this file if you as a licensee so wish it. See
+  included file COSL.txt.
+*/
+
+#include <profiler.h>
+
+#include <known_dirs.h>                                     /* GetStateDir */
+#include <file_lib.h>                                       /* safe_fopen */
+#include <string_lib.h>
+#include <sequence.h>
+#include <buffer.h>
+#include <map.h>
+
+#include <pthread.h>
+
+
+/* Longest promiser that makes it into a frame name. */
+#define PROFILER_PROMISER_MAX 100
+
+typedef enum
+{
+    PROFILE_NODE_ROOT,
+    PROFILE_NODE_BUNDLE,
+    PROFILE_NODE_PROMISE_TYPE,
+    PROFILE_NODE_PROMISE,
+    PROFILE_NODE_FUNCTION,
+} ProfileNodeType;
+
+typedef struct ProfileNode_ ProfileNode;
+struct ProfileNode_
+{
+    ProfileNodeType type;
+    const void *owner;        /* Bundle, PromiseType or Promise, else NULL */
+    char *name;
+    char *id;                 /* source position and promiser of a promise */
+    JsonElement *info;        /* about a promise, for the summary */
+
+    ProfileNode *parent;
+    Seq *children;
+    size_t last_child;        /* siblings are mostly entered in order */
+
+    uint64_t wall_ns;
+    uint64_t cpu_ns;
+    unsigned long count;      /* how many times it was entered */
+    unsigned long iterations; /* promise iterations, for promises */
+
+    uint64_t wall_start;
+    uint64_t cpu_start;
+};
+
+typedef struct
+{
+    const ProfileNode *first;       /* names the promise or function */
+    uint64_t wall_ns;
+    uint64_t cpu_ns;
+    uint64_t self_wall_ns;
+    uint64_t self_cpu_ns;
+    unsigned long count;
+    unsigned long iterations;
+} ProfileAggregate;
+
+typedef enum
+{
+    PROFILE_OUTPUT_WALL_TIME,
+    PROFILE_OUTPUT_CPU_TIME,
+    PROFILE_OUTPUT_SUMMARY,
+} ProfileOutput;
+
+static bool PROFILING = false; /* GLOBAL_X */
+static pthread_t PROFILED_THREAD; /* GLOBAL_X */
+static ProfileNode *PROFILE_ROOT = NULL; /* GLOBAL_X */
+static ProfileNode *PROFILE_CURRENT = NULL; /* GLOBAL_X */
+
+/*********************************************************************/
+
+static uint64_t ClockNs(clockid_t clock)
+{
+    struct timespec ts;
+    if (clock_gettime(clock, &ts) == -1)
+    {
+        return 0;
+    }
+    return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static uint64_t WallNow(void)
+{
+    return ClockNs(CLOCK_MONOTONIC);
+}
+
+static uint64_t CpuNow(void)
+{
+#ifdef CLOCK_THREAD_CPUTIME_ID
+    return ClockNs(CLOCK_THREAD_CPUTIME_ID);
+#else
+    return ClockNs(CLOCK_PROCESS_CPUTIME_ID);
+#endif
+}
+
+static void ProfileNodeDestroy(void *p)
+{
+    ProfileNode *node = p;
+    if (node != NULL)
+    {
+        SeqDestroy(node->children);
+        JsonDestroy(node->info);
+        free(node->id);
+        free(node->name);
+        free(node);
+    }
+}
+
+static ProfileNode *ProfileNodeNew(ProfileNodeType type, const void *owner,
+                                   const char *name, ProfileNode *parent)
+{
+    ProfileNode *node = xcalloc(1, sizeof(ProfileNode));
+    node->type = type;
+    node->owner = owner;
+    node->name = xstrdup(name);
+    node->parent = parent;
+    node->children = SeqNew(4, ProfileNodeDestroy);
+    return node;
+}
+
+/*
+ * Policy objects can be freed while profiling, e.g. the policy validated
+ * before the one that is run, and their memory be reused. Hence nodes
+ * compare the names too, and don't point back into the policy.
+ */
+static bool ProfileNodeIs(const ProfileNode *node, ProfileNodeType type,
+                          const void *owner, const char *name)
+{
+    return node->type == type && node->owner == owner &&
+           strcmp(node->name, name) == 0;
+}
+
+/**
+ * @return The child of #parent for #owner or #name, which is created if it
+ *         doesn't exist yet. The search starts at the last child found,
+ *         since promises are evaluated in the order they were added.
+ */
+static ProfileNode *ProfileNodeChild(ProfileNode *parent, ProfileNodeType type,
+                                     const void *owner, const char *name)
+{
+    size_t length = SeqLength(parent->children);
+    for (size_t i = 0; i < length; i++)
+    {
+        size_t index = (parent->last_child + i) % length;
+        ProfileNode *child = SeqAt(parent->children, index);
+        if (ProfileNodeIs(child, type, owner, name))
+        {
+            parent->last_child = index;
+            return child;
+        }
+    }
+
+    ProfileNode *child = ProfileNodeNew(type, owner, name, parent);
+    SeqAppend(parent->children, child);
+    parent->last_child = length;
+    return child;
+}
+
+static bool ProfilerActive(void)
+{
+    return PROFILING && pthread_equal(pthread_self(), PROFILED_THREAD);
+}
+
+/*********************************************************************/
+
+void ProfilerStart(void)
+{
+    ProfilerStop();
+
+    PROFILE_ROOT = ProfileNodeNew(PROFILE_NODE_ROOT, NULL, "", NULL);
+    PROFILE_ROOT->count = 1;
+    PROFILE_ROOT->wall_start = WallNow();
+    PROFILE_ROOT->cpu_start = CpuNow();
+    PROFILE_CURRENT = PROFILE_ROOT;
+    PROFILED_THREAD = pthread_self();
+    PROFILING = true;
+}
+
+void ProfilerStop(void)
+{
+    PROFILING = false;
+    ProfileNodeDestroy(PROFILE_ROOT);
+    PROFILE_ROOT = NULL;
+    PROFILE_CURRENT = NULL;
+}
+
+bool ProfilerIsEnabled(void)
+{
+    return PROFILING;
+}
+
+static void ProfilerEnter(ProfileNodeType type, const void *owner,
+                          const char *name)
+{
+    if (!ProfilerActive())
+    {
+        return;
+    }
+
+    ProfileNode *node = ProfileNodeChild(PROFILE_CURRENT, type, owner, name);
+    node->count++;
+    node->wall_start = WallNow();
+    node->cpu_start = CpuNow();
+    PROFILE_CURRENT = node;
+}
+
+void ProfilerEnterBundle(const Bundle *bundle)
+{
+    if (ProfilerActive())
+    {
+        char name[CF_MAXVARSIZE];
+        snprintf(name, sizeof(name), "%s:%s", bundle->ns, bundle->name);
+        ProfilerEnter(PROFILE_NODE_BUNDLE, bundle, name);
+    }
+}
+
+void ProfilerEnterPromiseType(const PromiseType *promise_type)
+{
+    ProfilerEnter(PROFILE_NODE_PROMISE_TYPE, promise_type, promise_type->name);
+}
+
+static void ProfileNodeSetPromise(ProfileNode *node, const Promise *pp)
+{
+    const Bundle *bundle = PromiseGetBundle(pp);
+    const char *source_path = (bundle->source_path != NULL) ?
+        bundle->source_path : "";
+
+    node->id = StringFormat("%s:%zu:%s", source_path, pp->offset.line,
+                            pp->promiser);
+
+    node->info = JsonObjectCreate(12);
+    JsonObjectAppendString(node->info, "namespace", bundle->ns);
+    JsonObjectAppendString(node->info, "bundle", bundle->name);
+    JsonObjectAppendString(node->info, "promiseType",
+                           pp->parent_promise_type->name);
+    JsonObjectAppendString(node->info, "promiser", pp->promiser);
+    const char *handle = PromiseGetHandle(pp);
+    if (handle != NULL)
+    {
+        JsonObjectAppendString(node->info, "handle", handle);
+    }
+    JsonObjectAppendString(node->info, "sourcePath", source_path);
+    JsonObjectAppendInteger(node->info, "line", pp->offset.line);
+}
+
+void ProfilerEnterPromise(const Promise *pp)
+{
+    if (!ProfilerActive())
+    {
+        return;
+    }
+
+    /* Evaluation works on copies of the promise in the policy. */
+    const Promise *org_pp = (pp->org_pp != NULL) ? pp->org_pp : pp;
+    char name[PROFILER_PROMISER_MAX + 1];
+    strlcpy(name, org_pp->promiser, sizeof(name));
+
+    ProfilerEnter(PROFILE_NODE_PROMISE, org_pp, name);
+    if (PROFILE_CURRENT->info == NULL)
+    {
+        ProfileNodeSetPromise(PROFILE_CURRENT, org_pp);
+    }
+}
+
+void ProfilerEnterFunction(const char *name)
+{
+    ProfilerEnter(PROFILE_NODE_FUNCTION, NULL, name);
+}
+
+void ProfilerLeave(void)
+{
+    /* Not entered since profiling started. */
+    if (!ProfilerActive() || PROFILE_CURRENT == PROFILE_ROOT)
+    {
+        return;
+    }
+
+    ProfileNode *node = PROFILE_CURRENT;
+    node->wall_ns += WallNow() - node->wall_start;
+    node->cpu_ns += CpuNow() - node->cpu_start;
+    PROFILE_CURRENT = node->parent;
+}
+
+void ProfilerPromiseIteration(void)
+{
+    if (ProfilerActive() && PROFILE_CURRENT->type == PROFILE_NODE_PROMISE)
+    {
+        PROFILE_CURRENT->iterations++;
+    }
+}
+
+/*********************************************************************/
+/* Reports                                                           */
+/*********************************************************************/
+
+/* The root covers everything since ProfilerStart(). */
+static void ProfileRootUpdate(void)
+{
+    if (PROFILING)
+    {
+        PROFILE_ROOT->wall_ns = WallNow() - PROFILE_ROOT->wall_start;
+        PROFILE_ROOT->cpu_ns = CpuNow() - PROFILE_ROOT->cpu_start;
+    }
+}
+
+static uint64_t ProfileNodeSelf(const ProfileNode *node, bool cpu_time)
+{
+    uint64_t total = cpu_time ? node->cpu_ns : node->wall_ns;
+    uint64_t children = 0;
+    for (size_t i = 0; i < SeqLength(node->children); i++)
+    {
+        const ProfileNode *child = SeqAt(node->children, i);
+        children += cpu_time ? child->cpu_ns : child->wall_ns;
+    }
+    return (total > children) ? total - children : 0;
+}
+
+/* Frames are separated by ';', and stacks by newlines. */
+static void BufferAppendFrame(Buffer *stack, const ProfileNode *node)
+{
+    BufferAppendChar(stack, ';');
+    for (const char *c = node->name; *c != '\0'; c++)
+    {
+        bool separator = (*c == ';' || *c == '\n' || *c == '\r');
+        BufferAppendChar(stack, separator ? '_' : *c);
+    }
+    if (node->type == PROFILE_NODE_FUNCTION)
+    {
+        BufferAppendString(stack, "()");
+    }
+}
+
+static void ProfileNodeWriteFolded(const ProfileNode *node, Buffer *stack,
+                                   Writer *writer, bool cpu_time)
+{
+    /* Microseconds, flame graphs only take integers. */
+    uint64_t self = ProfileNodeSelf(node, cpu_time) / 1000;
+    if (self > 0)
+    {
+        WriterWriteF(writer, "%s %ju\n", BufferData(stack), (uintmax_t) self);
+    }
+
+    unsigned int length = BufferSize(stack);
+    for (size_t i = 0; i < SeqLength(node->children); i++)
+    {
+        const ProfileNode *child = SeqAt(node->children, i);
+        BufferAppendFrame(stack, child);
+        ProfileNodeWriteFolded(child, stack, writer, cpu_time);
+        BufferTrimToMaxLength(stack, length);
+    }
+}
+
+/**
+ * Write the profile in the collapsed stack format of flame graph tools,
+ * one line per stack with the time spent in its last frame, in
+ * microseconds.
+ */
+void ProfilerWriteFolded(Writer *writer, const char *root_name, bool cpu_time)
+{
+    if (PROFILE_ROOT == NULL)
+    {
+        return;
+    }
+    ProfileRootUpdate();
+
+    Buffer *stack = BufferNew();
+    BufferAppendString(stack, root_name);
+    ProfileNodeWriteFolded(PROFILE_ROOT, stack, writer, cpu_time);
+    BufferDestroy(stack);
+}
+
+static void ProfileAggregateAdd(Map *map, Seq *list, const void *key,
+                                const ProfileNode *node)
+{
+    ProfileAggregate *aggregate = MapGet(map, key);
+    if (aggregate == NULL)
+    {
+        aggregate = xcalloc(1, sizeof(ProfileAggregate));
+        aggregate->first = node;
+        MapInsert(map, (void *) key, aggregate);
+        SeqAppend(list, aggregate);
+    }
+
+    aggregate->wall_ns += node->wall_ns;
+    aggregate->cpu_ns += node->cpu_ns;
+    aggregate->self_wall_ns += ProfileNodeSelf(node, false);
+    aggregate->self_cpu_ns += ProfileNodeSelf(node, true);
+    aggregate->count += node->count;
+    aggregate->iterations += node->iterations;
+}
+
+/* Sum up the nodes of every promise and function, wherever they were called. */
+static void ProfileAggregateTree(const ProfileNode *node,
+                                 Map *promises, Seq *promise_list,
+                                 Map *functions, Seq *function_list)
+{
+    if (node->type == PROFILE_NODE_PROMISE)
+    {
+        ProfileAggregateAdd(promises, promise_list, node->id, node);
+    }
+    else if (node->type == PROFILE_NODE_FUNCTION)
+    {
+        ProfileAggregateAdd(functions, function_list, node->name, node);
+    }
+
+    for (size_t i = 0; i < SeqLength(node->children); i++)
+    {
+        ProfileAggregateTree(SeqAt(node->children, i), promises, promise_list,
+                             functions, function_list);
+    }
+}
+
+static int ProfileAggregateCompare(const void *a, const void *b,
+                                   ARG_UNUSED void *user_data)
+{
+    const ProfileAggregate *aggregate_a = a;
+    const ProfileAggregate *aggregate_b = b;
+    if (aggregate_a->self_wall_ns != aggregate_b->self_wall_ns)
+    {
+        return (aggregate_a->self_wall_ns > aggregate_b->self_wall_ns) ? -1 : 1;
+    }
+    return strcmp(aggregate_a->first->name, aggregate_b->first->name);
+}
+
+static double Milliseconds(uint64_t ns)
+{
+    return ns / 1e6;
+}
+
+static void ProfileAggregateToJson(JsonElement *json,
+                                   const ProfileAggregate *aggregate)
+{
+    JsonObjectAppendReal(json, "wallMs", Milliseconds(aggregate->wall_ns));
+    JsonObjectAppendReal(json, "cpuMs", Milliseconds(aggregate->cpu_ns));
+    JsonObjectAppendReal(json, "selfWallMs", Milliseconds(aggregate->self_wall_ns));
+    JsonObjectAppendReal(json, "selfCpuMs", Milliseconds(aggregate->self_cpu_ns));
+}
+
+static JsonElement *ProfilePromiseToJson(const ProfileAggregate *aggregate)
+{
+    JsonElement *json = JsonCopy(aggregate->first->info);
+    JsonObjectAppendInteger(json, "evaluations", aggregate->count);
+    JsonObjectAppendInteger(json, "iterations", aggregate->iterations);
+    ProfileAggregateToJson(json, aggregate);
+    return json;
+}
+
+static JsonElement *ProfileFunctionToJson(const ProfileAggregate *aggregate)
+{
+    JsonElement *json = JsonObjectCreate(6);
+    JsonObjectAppendString(json, "name", aggregate->first->name);
+    JsonObjectAppendInteger(json, "calls", aggregate->count);
+    ProfileAggregateToJson(json, aggregate);
+    return json;
+}
+
+/**
+ * @return The totals, and the #top promises and functions that took the
+ *         most wall clock time of their own, i.e. not counting the
+ *         functions and bundles they called.
+ */
+JsonElement *ProfilerSummary(size_t top)
+{
+    JsonElement *summary = JsonObjectCreate(4);
+    JsonElement *promises_json = JsonArrayCreate(top);
+    JsonElement *functions_json = JsonArrayCreate(top);
+
+    if (PROFILE_ROOT != NULL)
+    {
+        ProfileRootUpdate();
+        JsonObjectAppendReal(summary, "wallMs", Milliseconds(PROFILE_ROOT->wall_ns));
+        JsonObjectAppendReal(summary, "cpuMs", Milliseconds(PROFILE_ROOT->cpu_ns));
+
+        /* The maps only index the aggregates, which the sequences own. */
+        Map *promises = MapNew(StringHash_untyped, StringSafeEqual_untyped,
+                               NULL, NULL);
+        Map *functions = MapNew(StringHash_untyped, StringSafeEqual_untyped,
+                                NULL, NULL);
+        Seq *promise_list = SeqNew(100, free);
+        Seq *function_list = SeqNew(20, free);
+
+        ProfileAggregateTree(PROFILE_ROOT, promises, promise_list,
+                             functions, function_list);
+
+        SeqSort(promise_list, ProfileAggregateCompare, NULL);
+        SeqSort(function_list, ProfileAggregateCompare, NULL);
+        for (size_t i = 0; i < SeqLength(promise_list) && i < top; i++)
+        {
+            JsonArrayAppendObject(promises_json,
+                                  ProfilePromiseToJson(SeqAt(promise_list, i)));
+        }
+        for (size_t i = 0; i < SeqLength(function_list) && i < top; i++)
+        {
+            JsonArrayAppendObject(functions_json,
+                                  ProfileFunctionToJson(SeqAt(function_list, i)));
+        }
+
+        SeqDestroy(promise_list);
+        SeqDestroy(function_list);
+        MapDestroy(promises);
+        MapDestroy(functions);
+    }
+
+    JsonObjectAppendArray(summary, "promises", promises_json);
+    JsonObjectAppendArray(summary, "functions", functions_json);
+    return summary;
+}
+
+static bool ProfilerWriteFile(const char *dirname, const char *filename,
+                              const char *agent_name, ProfileOutput output)
+{
+    char path[CF_BUFSIZE], tmp_path[CF_BUFSIZE];
+    int ret = snprintf(path, sizeof(path), "%s%c%s",
+                       dirname, FILE_SEPARATOR, filename);
+    if (ret >= 0 && (size_t) ret < sizeof(path))
+    {
+        ret = snprintf(tmp_path, sizeof(tmp_path), "%s.%ju.tmp",
+                       path, (uintmax_t) getpid());
+    }
+    if (ret < 0 || (size_t) ret >= sizeof(tmp_path))
+    {
+        Log(LOG_LEVEL_ERR, "Unable to write profile '%s', path too long",
+            filename);
+        return false;
+    }
+
+    FILE *fp = safe_fopen(tmp_path, "w");
+    if (fp == NULL)
+    {
+        Log(LOG_LEVEL_ERR, "Unable to write profile '%s' (fopen: %s)",
+            tmp_path, GetErrorStr());
+        return false;
+    }
+
+    Writer *writer = FileWriter(fp);
+    if (output == PROFILE_OUTPUT_SUMMARY)
+    {
+        JsonElement *summary = ProfilerSummary(PROFILER_SUMMARY_TOP);
+        JsonWrite(writer, summary, 0);
+        WriterWrite(writer, "\n");
+        JsonDestroy(summary);
+    }
+    else
+    {
+        ProfilerWriteFolded(writer, agent_name,
+                            output == PROFILE_OUTPUT_CPU_TIME);
+    }
+    WriterClose(writer);
+
+    if (rename(tmp_path, path) == -1)
+    {
+        Log(LOG_LEVEL_ERR, "Unable to write profile '%s' (rename: %s)",
+            path, GetErrorStr());
+        unlink(tmp_path);
+        return false;
+    }
+
+    Log(LOG_LEVEL_VERBOSE, "Wrote evaluation profile '%s'", path);
+    return true;
+}
+
+/**
+ * Write the profile to the profile directory under the state directory:
+ * wall clock and CPU time flame graph input, and a JSON summary.
+ */
+void ProfilerWrite(const char *agent_name)
+{
+    if (PROFILE_ROOT == NULL)
+    {
+        return;
+    }
+
+    char dirname[CF_BUFSIZE];
+    snprintf(dirname, sizeof(dirname), "%s%c%s",
+             GetStateDir(), FILE_SEPARATOR, PROFILER_DIR);
+    if (mkdir(dirname, 0700) == -1 && errno != EEXIST)
+    {
+        Log(LOG_LEVEL_ERR,
+            "Unable to create profile directory '%s' (mkdir: %s)",
+            dirname, GetErrorStr());
+        return;
+    }
+
+    char filename[CF_MAXVARSIZE];
+    snprintf(filename, sizeof(filename), "%s.folded", agent_name);
+    ProfilerWriteFile(dirname, filename, agent_name, PROFILE_OUTPUT_WALL_TIME);
+    snprintf(filename, sizeof(filename), "%s-cpu.folded", agent_name);
+    ProfilerWriteFile(dirname, filename, agent_name, PROFILE_OUTPUT_CPU_TIME);
+    snprintf(filename, sizeof(filename), "%s.json", agent_name);
+    ProfilerWriteFile(dirname, filename, agent_name, PROFILE_OUTPUT_SUMMARY);
+}
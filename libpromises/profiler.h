@@ -0,0 +1,66 @@
+/*
+   Copyright 2018 Northern.tech AS
+
+   This file is part of CFEngine 3 - written and maintained by Northern.tech AS.
+
+   This program is free software; you can redistribute it and/or modify it
+   under the terms of the GNU General Public License as published by the
+   Free Software Foundation; version 3.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA
+
+  To the extent this program is licensed as part of the Enterprise
+  versions of CFEngine, the applicable Commercial Open Source License
+  (COSL) may apply to this file if you as a licensee so wish it. See
+  included file COSL.txt.
+*/
+
+#ifndef CFENGINE_PROFILER_H
+#define CFENGINE_PROFILER_H
+
+
+#include <cf3.defs.h>
+#include <policy.h>
+#include <json.h>
+#include <writer.h>
+
+
+/* Under the state directory, where ProfilerWrite() puts its files. */
+#define PROFILER_DIR "profile"
+
+/* How many promises and functions the JSON summary lists. */
+#define PROFILER_SUMMARY_TOP 20
+
+
+/*
+ * Evaluation profiler, enabled with --profile. Bundles, promise types,
+ * promises and function calls form a call tree, each node of which sums
+ * the wall clock and CPU time spent in it. Only the thread that called
+ * ProfilerStart() is profiled, and everything is a no-op until then.
+ */
+void ProfilerStart(void);
+void ProfilerStop(void);
+bool ProfilerIsEnabled(void);
+
+void ProfilerEnterBundle(const Bundle *bundle);
+void ProfilerEnterPromiseType(const PromiseType *promise_type);
+void ProfilerEnterPromise(const Promise *pp);
+void ProfilerEnterFunction(const char *name);
+void ProfilerLeave(void);
+void ProfilerPromiseIteration(void);
+
+/* Write <agent>.folded, <agent>-cpu.folded and <agent>.json */
+void ProfilerWrite(const char *agent_name);
+
+/* Exposed for testing. */
+void ProfilerWriteFolded(Writer *writer, const char *root_name, bool cpu_time);
+JsonElement *ProfilerSummary(size_t top);
+
+#endif
@@ -252,9 +252,9 @@ Promise *DeRefCopyPromise(EvalContext *ctx, const Promise *pp)
         const Policy *policy = PolicyFromPromise(pp);
 
         /* bodies_and_args: Do we have body to expand, possibly with arguments?
-         * At position 0 we'll have the body, then its rval, then the same for
-         * each of its inherit_from parents. */
-        Seq *bodies_and_args       = NULL;
+         * At the last position we'll have the body, preceded by its rval,
+         * and the same for each of its inherit_from parents before that. */
+        const Seq *bodies_and_args = NULL;
         const Rlist *args          = NULL;
         const char *body_reference = NULL;
 
@@ -265,13 +265,13 @@ Promise *DeRefCopyPromise(EvalContext *ctx, const Promise *pp)
             if (cp->references_body)
             {
                 body_reference = RvalScalarValue(cp->rval);
-                bodies_and_args = EvalContextResolveBodyExpression(ctx, policy, body_reference, cp->lval);
+                bodies_and_args = EvalContextResolveConstraintBody(ctx, policy, cp, body_reference);
             }
             args = NULL;
             break;
         case RVAL_TYPE_FNCALL:
             body_reference = RvalFnCallValue(cp->rval)->name;
-            bodies_and_args = EvalContextResolveBodyExpression(ctx, policy, body_reference, cp->lval);
+            bodies_and_args = EvalContextResolveConstraintBody(ctx, policy, cp, body_reference);
             args = RvalFnCallValue(cp->rval)->args;
             break;
         default:
@@ -283,11 +283,11 @@ Promise *DeRefCopyPromise(EvalContext *ctx, const Promise *pp)
         if (bodies_and_args != NULL &&
             SeqLength(bodies_and_args) > 0)
         {
-            const Body *bp = SeqAt(bodies_and_args, 0);
+            /* Reversed, when we iterate we start with the furthest parent. */
+            const Body *bp = SeqAt(bodies_and_args,
+                                   SeqLength(bodies_and_args) - 1);
             assert(bp != NULL);
 
-            SeqReverse(bodies_and_args); // when we iterate, start with the furthest parent
-
             EvalContextStackPushBodyFrame(ctx, pcopy, bp, args);
 
             if (strcmp(bp->type, cp->lval) != 0)
@@ -351,7 +351,6 @@ Promise *DeRefCopyPromise(EvalContext *ctx, const Promise *pp)
             }
 
             EvalContextStackPopFrame(ctx);
-            SeqDestroy(bodies_and_args);
         }
         else                                    /* constraint is not a body */
         {
@@ -561,6 +560,18 @@ static void DereferenceAndPutComment(Promise* pp, const char *comment)
 }
 
 Promise *ExpandDeRefPromise(EvalContext *ctx, const Promise *pp, bool *excluded)
+{
+    return ExpandDeRefPromiseIteration(ctx, pp, NULL, excluded);
+}
+
+/**
+ * Like ExpandDeRefPromise(), for promise #pp being iterated by #iterctx.
+ * Constraints whose value can't have changed since the previous iteration
+ * are copied from it instead of being expanded again.
+ */
+Promise *ExpandDeRefPromiseIteration(EvalContext *ctx, const Promise *pp,
+                                     const PromiseIterator *iterctx,
+                                     bool *excluded)
 {
     assert(pp->promiser);
     assert(pp->classes);
@@ -694,10 +705,18 @@ Promise *ExpandDeRefPromise(EvalContext *ctx, const Promise *pp, bool *excluded)
         }
 
         Rval final;
-        if (!EvaluateConstraintIteration(ctx, cp, &final))
+        if (!IsDefinedClass(ctx, cp->classes))
         {
             continue;
         }
+        if (!PromiseIteratorConstraintValue(iterctx, i, &final))
+        {
+            if (!EvaluateConstraintIteration(ctx, cp, &final))
+            {
+                continue;
+            }
+            PromiseIteratorConstraintSetValue(iterctx, i, final);
+        }
 
         PromiseAppendConstraint(pcopy, cp->lval, final, false);
 
@@ -30,10 +30,14 @@
 
 #include <logging.h>
 #include <sequence.h>
+#include <iteration.h>                                    /* PromiseIterator */
 
 
 Promise *DeRefCopyPromise(EvalContext *ctx, const Promise *pp);
 Promise *ExpandDeRefPromise(EvalContext *ctx, const Promise *pp, bool *excluded);
+Promise *ExpandDeRefPromiseIteration(EvalContext *ctx, const Promise *pp,
+                                     const PromiseIterator *iterctx,
+                                     bool *excluded);
 void PromiseRef(LogLevel level, const Promise *pp);
 void CopyBodyConstraintsToPromise(EvalContext *ctx, Promise *pp,
                                   const Body *bp);
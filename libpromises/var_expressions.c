@@ -30,62 +30,67 @@
 #include <string_lib.h>
 #include <hashes.h>
 #include <scope.h>
+#include <string_intern.h>
 
 
 // This is not allowed to be the part of VarRef.indices so looks safe
 // to be used as multi array indices separator while hashing.
 #define ARRAY_SEPARATOR_HASH ']'
 
+static unsigned int HashCombine(unsigned int h, unsigned int v)
+{
+    h += v;
+    h += (h << 10);
+    h ^= (h >> 6);
+    return h;
+}
+
+/* ns == NULL is the same as "default" */
+static unsigned int NamespaceHash(const char *ns)
+{
+    return (ns != NULL) ? StringInternHash(ns) : StringHash("default", 0);
+}
+
+static bool NamespaceEqual(const char *a, const char *b)
+{
+    if (a == b)
+    {
+        return true;
+    }
+    else if (a == NULL)
+    {
+        return strcmp(b, "default") == 0;
+    }
+    else if (b == NULL)
+    {
+        return strcmp(a, "default") == 0;
+    }
+    return false;
+}
+
 static unsigned VarRefHash(const VarRef *ref)
 {
     unsigned int h = 0;
 
+    /* ns, scope and lval are interned, their hashes are precomputed. */
     if (VarRefIsQualified(ref))
     {
-        if (ref->ns)
-        {
-            for (int i = 0; ref->ns[i] != '\0'; i++)
-            {
-                h += ref->ns[i];
-                h += (h << 10);
-                h ^= (h >> 6);
-            }
-        }
-        else
-        {
-            h = 1195645448; // hash of "default"
-        }
-
-        int len = strlen(ref->scope);
-        for (int i = 0; i < len; i++)
-        {
-            h += ref->scope[i];
-            h += (h << 10);
-            h ^= (h >> 6);
-        }
+        h = HashCombine(h, NamespaceHash(ref->ns));
+        h = HashCombine(h, StringInternHash(ref->scope));
     }
 
-    for (int i = 0; ref->lval[i] != '\0'; i++)
-    {
-        h += ref->lval[i];
-        h += (h << 10);
-        h ^= (h >> 6);
-    }
+    h = HashCombine(h, StringInternHash(ref->lval));
 
     for (size_t k = 0; k < ref->num_indices; k++)
     {
         // Fixing multi index arrays hashing collisions - Redmine 6674
         // Multi index arrays with indexes expanded to the same string
         // (e.g. v[te][st], v[t][e][s][t]) will not be hashed to the same value.
-        h += ARRAY_SEPARATOR_HASH;
-        h += (h << 10);
-        h ^= (h >> 6);
+        h = HashCombine(h, ARRAY_SEPARATOR_HASH);
 
         for (int i = 0; ref->indices[k][i] != '\0'; i++)
         {
-            h += ref->indices[k][i];
-            h += (h << 10);
-            h ^= (h >> 6);
+            h = HashCombine(h, ref->indices[k][i]);
         }
     }
 
@@ -106,22 +111,32 @@ VarRef VarRefConst(const char *ns, const char *scope, const char *lval)
 {
     VarRef ref;
 
-    ref.ns = (char *)ns;
-    ref.scope = (char *)scope;
-    ref.lval = (char *)lval;
+    ref.ns = StringIntern(ns);
+    ref.scope = StringIntern(scope);
+    ref.lval = StringIntern(lval);
     ref.num_indices = 0;
     ref.indices = NULL;
 
     return ref;
 }
 
+/**
+ * @brief Release the names of #ref, for VarRefs from VarRefConst().
+ */
+void VarRefConstRelease(VarRef *ref)
+{
+    StringInternRelease(ref->ns);
+    StringInternRelease(ref->scope);
+    StringInternRelease(ref->lval);
+}
+
 VarRef *VarRefCopy(const VarRef *ref)
 {
     VarRef *copy = xmalloc(sizeof(VarRef));
 
-    copy->ns = ref->ns ? xstrdup(ref->ns) : NULL;
-    copy->scope = ref->scope ? xstrdup(ref->scope) : NULL;
-    copy->lval = ref->lval ? xstrdup(ref->lval) : NULL;
+    copy->ns = StringInternRetain(ref->ns);
+    copy->scope = StringInternRetain(ref->scope);
+    copy->lval = StringInternRetain(ref->lval);
 
     copy->num_indices = ref->num_indices;
     if (ref->num_indices > 0)
@@ -145,8 +160,8 @@ VarRef *VarRefCopyLocalized(const VarRef *ref)
     VarRef *copy = xmalloc(sizeof(VarRef));
 
     copy->ns = NULL;
-    copy->scope = xstrdup("this");
-    copy->lval = ref->lval ? xstrdup(ref->lval) : NULL;
+    copy->scope = StringIntern("this");
+    copy->lval = StringInternRetain(ref->lval);
 
     copy->num_indices = ref->num_indices;
     if (ref->num_indices > 0)
@@ -169,9 +184,9 @@ VarRef *VarRefCopyIndexless(const VarRef *ref)
 {
     VarRef *copy = xmalloc(sizeof(VarRef));
 
-    copy->ns = ref->ns ? xstrdup(ref->ns) : NULL;
-    copy->scope = ref->scope ? xstrdup(ref->scope) : NULL;
-    copy->lval = ref->lval ? xstrdup(ref->lval) : NULL;
+    copy->ns = StringInternRetain(ref->ns);
+    copy->scope = StringInternRetain(ref->scope);
+    copy->lval = StringInternRetain(ref->lval);
     copy->num_indices = 0;
     copy->indices = NULL;
 
@@ -331,12 +346,16 @@ VarRef *VarRefParseFromNamespaceAndScope(const char *qualified_name,
 
     VarRef *ref = xmalloc(sizeof(VarRef));
 
-    ref->ns = ns ? ns : (_ns ? xstrdup(_ns) : NULL);
-    ref->scope = scope ? scope : (_scope ? xstrdup(_scope) : NULL);
-    ref->lval = lval;
+    ref->ns = StringIntern(ns ? ns : _ns);
+    ref->scope = StringIntern(scope ? scope : _scope);
+    ref->lval = StringIntern(lval);
     ref->indices = indices;
     ref->num_indices = num_indices;
 
+    free(ns);
+    free(scope);
+    free(lval);
+
     return ref;
 }
 
@@ -412,9 +431,6 @@ void VarRefDestroy(VarRef *ref)
 {
     if (ref)
     {
-        free(ref->ns);
-        free(ref->scope);
-        free(ref->lval);
         if (ref->num_indices > 0)
         {
             for (int i = 0; i < ref->num_indices; ++i)
@@ -424,6 +440,7 @@ void VarRefDestroy(VarRef *ref)
             free(ref->indices);
         }
 
+        VarRefConstRelease(ref);
         free(ref);
     }
 
@@ -492,7 +509,7 @@ VarRef *VarRefDeMangle(const char *mangled_var_ref)
                                             CF_MANGLED_NS, CF_MANGLED_SCOPE);
 }
 
-static bool VarRefIsMeta(VarRef *ref)
+static bool VarRefIsMeta(const VarRef *ref)
 {
     return StringEndsWith(ref->scope, "_meta");
 }
@@ -504,17 +521,19 @@ void VarRefSetMeta(VarRef *ref, bool enabled)
         if (!VarRefIsMeta(ref))
         {
             char *tmp = StringConcatenate(2, ref->scope, "_meta");
-            free(ref->scope);
-            ref->scope = tmp;
+            StringInternRelease(ref->scope);
+            ref->scope = StringIntern(tmp);
+            free(tmp);
         }
     }
     else
     {
         if (VarRefIsMeta(ref))
         {
-            char *tmp = ref->scope;
-            size_t len = strlen(ref->scope);
-            memcpy(ref->scope, StringSubstring(ref->scope, len, 0, len - strlen("_meta")), len - strlen("_meta"));
+            char *tmp = xstrndup(ref->scope,
+                                 strlen(ref->scope) - strlen("_meta"));
+            StringInternRelease(ref->scope);
+            ref->scope = StringIntern(tmp);
             free(tmp);
         }
     }
@@ -529,14 +548,12 @@ void VarRefQualify(VarRef *ref, const char *ns, const char *scope)
 {
     assert(scope);
 
-    free(ref->ns);
-    ref->ns = NULL;
-
-    free(ref->scope);
-    ref->scope = NULL;
-
-    ref->ns = ns ? xstrdup(ns) : NULL;
-    ref->scope = xstrdup(scope);
+    const char *old_ns = ref->ns;
+    const char *old_scope = ref->scope;
+    ref->ns = StringIntern(ns);
+    ref->scope = StringIntern(scope);
+    StringInternRelease(old_ns);
+    StringInternRelease(old_scope);
 }
 
 void VarRefAddIndex(VarRef *ref, const char *index)
@@ -564,7 +581,10 @@ int VarRefCompare(const VarRef *a, const VarRef *b)
         return ret;
     }
 
-    ret = strcmp(NULLStringToEmpty(a->scope), NULLStringToEmpty(b->scope));
+    const char *a_scope = a->scope ? a->scope : "";
+    const char *b_scope = b->scope ? b->scope : "";
+
+    ret = strcmp(a_scope, b_scope);
     if (ret != 0)
     {
         return ret;
@@ -599,5 +619,24 @@ int VarRefCompare(const VarRef *a, const VarRef *b)
 
 bool VarRefEqual_untyped(const void *a, const void *b)
 {
-    return (VarRefCompare(a, b) == 0);
+    const VarRef *ra = a, *rb = b;
+
+    /* Interned, compare by pointer. */
+    if (ra->lval != rb->lval ||
+        ra->scope != rb->scope ||
+        !NamespaceEqual(ra->ns, rb->ns) ||
+        ra->num_indices != rb->num_indices)
+    {
+        return false;
+    }
+
+    for (size_t i = 0; i < ra->num_indices; i++)
+    {
+        if (strcmp(ra->indices[i], rb->indices[i]) != 0)
+        {
+            return false;
+        }
+    }
+
+    return true;
 }
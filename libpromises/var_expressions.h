@@ -34,14 +34,18 @@
    VarRef is immutable, which means that after allocated the members never
    change, until all of it is freed.
 
+   ns, scope and lval are interned (see StringIntern()), so they can be
+   compared by pointer. The VarRef holds a reference to each of them, and
+   owns the indices.
+
    @TODO constify all pointers returned from VarRef initializers (VarRefCopy,
          VarRefParse, etc)
 */
 typedef struct
 {
-    char *ns;
-    char *scope;
-    char *lval;
+    const char *ns;
+    const char *scope;
+    const char *lval;
     char **indices;
     size_t num_indices;
 
@@ -67,6 +71,7 @@ VarRef *VarRefParseFromNamespaceAndScope(const char *qualified_name,
                                          const char *_ns, const char *_scope,
                                          char ns_separator, char scope_separator);
 VarRef VarRefConst(const char *ns, const char *scope, const char *lval);
+void VarRefConstRelease(VarRef *ref);
 
 void VarRefDestroy        (VarRef *ref);
 void VarRefDestroy_untyped(void   *ref);
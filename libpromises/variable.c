@@ -27,6 +27,7 @@
 #include <rlist.h>
 #include <writer.h>
 #include <conversion.h>                                 /* DataTypeToString */
+#include <string_intern.h>                                   /* StringIntern */
 
 
 static void VariableDestroy(Variable *var);                 /* forward declaration */
@@ -99,18 +100,21 @@ Variable *VariableTableGet(const VariableTable *table, const VarRef *ref)
 {
     Variable *v = VarMapGet(table->vars, ref);
 
-    char *ref_s = VarRefToString(ref, true);              /* TODO optimise */
-
-    if (v != NULL)
+    /* Only stringify #ref when it's printed, this is a hot path. */
+    if (v != NULL &&
+        v->rval.item == NULL && !DataTypeIsIterable(v->type))
     {
-        CF_ASSERT(v->rval.item != NULL || DataTypeIsIterable(v->type),
+        char *ref_s = VarRefToString(ref, true);
+        CF_ASSERT(false,
                   "VariableTableGet(%s): "
                   "Only iterables (Rlists) are allowed to be NULL",
                   ref_s);
+        free(ref_s);
     }
 
     if (LogModuleEnabled(LOG_MOD_VARTABLE))
     {
+        char *ref_s = VarRefToString(ref, true);
         Buffer *buf = BufferNew();
         BufferPrintf(buf, "VariableTableGet(%s): %s", ref_s,
                      v ? DataTypeToString(v->type) : "NOT FOUND");
@@ -135,9 +139,9 @@ Variable *VariableTableGet(const VariableTable *table, const VarRef *ref)
         LogDebug(LOG_MOD_VARTABLE, "%s", BufferGet(buf));
 
         BufferDestroy(buf);
+        free(ref_s);
     }
 
-    free(ref_s);
     return v;
 }
 
@@ -154,6 +158,7 @@ static Variable *VariableNew(VarRef *ref, Rval rval, DataType type,
     var->ref = ref;
     var->rval = rval;
     var->type = type;
+    var->serial = 0;
     if (tags == NULL)
     {
         var->tags = StringSetFromString("", ',');
@@ -273,11 +278,13 @@ VariableTableIterator *VariableTableIteratorNewFromVarRef(const VariableTable *t
 VariableTableIterator *VariableTableIteratorNew(const VariableTable *table, const char *ns, const char *scope, const char *lval)
 {
     VarRef ref = { 0 };
-    ref.ns = (char *)ns;
-    ref.scope = (char *)scope;
-    ref.lval = (char *)lval;
+    ref.ns = StringIntern(ns);
+    ref.scope = StringIntern(scope);
+    ref.lval = StringIntern(lval);
 
-    return VariableTableIteratorNewFromVarRef(table, &ref);
+    VariableTableIterator *iter = VariableTableIteratorNewFromVarRef(table, &ref);
+    VarRefConstRelease(&ref);
+    return iter;
 }
 
 Variable *VariableTableIteratorNext(VariableTableIterator *iter)
@@ -294,12 +301,13 @@ Variable *VariableTableIteratorNext(VariableTableIterator *iter)
             continue;
         }
 
-        if (iter->ref->scope && strcmp(var->ref->scope, iter->ref->scope) != 0)
+        /* Interned, compare by pointer. */
+        if (iter->ref->scope && var->ref->scope != iter->ref->scope)
         {
             continue;
         }
 
-        if (iter->ref->lval && strcmp(var->ref->lval, iter->ref->lval) != 0)
+        if (iter->ref->lval && var->ref->lval != iter->ref->lval)
         {
             continue;
         }
@@ -35,6 +35,7 @@ typedef struct
     DataType type;
     StringSet *tags;
     const Promise *promise; // The promise that set the present value
+    unsigned long serial;   // Changes with the value, see EvalContextVariablePut()
 } Variable;
 
 typedef struct VariableTable_ VariableTable;
@@ -0,0 +1,171 @@
+/*
+   Copyright 2018 Northern.tech AS
+
+   This file is part of CFEngine 3 - written and maintained by Northern.tech AS.
+
+   This program is free software; you can redistribute it and/or modify it
+   under the terms of the GNU General Public License as published by the
+   Free Software Foundation; version 3.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA
+
+  To the extent this program is licensed as part of the Enterprise
+  versions of CFEngine, the applicable Commercial Open Source License
+  (COSL) may apply to this file if you as a licensee so wish it. See
+  included file COSL.txt.
+*/
+
+#include <arena.h>
+
+#include <alloc.h>
+
+
+/* Every allocation is aligned like malloc() would. */
+#define ARENA_ALIGNMENT (2 * sizeof(void *))
+#define ARENA_ROUND_UP(n) (((n) + ARENA_ALIGNMENT - 1) & ~(ARENA_ALIGNMENT - 1))
+
+/**
+   The chunks form a list in allocation order. The ones after #current are
+   free, and kept to be reused after ArenaRelease().
+*/
+typedef struct ArenaChunk_ ArenaChunk;
+struct ArenaChunk_
+{
+    ArenaChunk *next;
+    size_t size;                               /* usable bytes after header */
+};
+
+#define ARENA_HEADER_SIZE ARENA_ROUND_UP(sizeof(ArenaChunk))
+
+struct Arena_
+{
+    ArenaChunk *head;
+    ArenaChunk *current;                          /* NULL before the head */
+    size_t used;                                     /* bytes of #current */
+    size_t chunk_size;
+
+    ArenaStats stats;
+};
+
+
+static char *ArenaChunkData(ArenaChunk *chunk)
+{
+    return ((char *) chunk) + ARENA_HEADER_SIZE;
+}
+
+Arena *ArenaNew(size_t chunk_size)
+{
+    assert(chunk_size > 0);
+
+    Arena *arena = xcalloc(1, sizeof(Arena));
+    arena->chunk_size = ARENA_ROUND_UP(chunk_size);
+    return arena;
+}
+
+void ArenaDestroy(Arena *arena)
+{
+    if (arena != NULL)
+    {
+        ArenaChunk *chunk = arena->head;
+        while (chunk != NULL)
+        {
+            ArenaChunk *next = chunk->next;
+            free(chunk);
+            chunk = next;
+        }
+        free(arena);
+    }
+}
+
+void *ArenaAlloc(Arena *arena, size_t size)
+{
+    size = ARENA_ROUND_UP(MAX(size, 1));
+    arena->stats.allocations++;
+
+    ArenaChunk *current = arena->current;
+    if (current != NULL && arena->used + size <= current->size)
+    {
+        void *p = ArenaChunkData(current) + arena->used;
+        arena->used += size;
+        return p;
+    }
+
+    /* Move on to the next free chunk, dropping the ones too small. */
+    ArenaChunk *next = (current != NULL) ? current->next : arena->head;
+    while (next != NULL && next->size < size)
+    {
+        ArenaChunk *after = next->next;
+        arena->stats.chunk_bytes -= next->size;
+        free(next);
+        next = after;
+    }
+
+    if (next == NULL)
+    {
+        size_t chunk_size = MAX(arena->chunk_size, size);
+        next = xmalloc(ARENA_HEADER_SIZE + chunk_size);
+        next->next = NULL;
+        next->size = chunk_size;
+
+        arena->stats.chunks_allocated++;
+        arena->stats.chunk_bytes += chunk_size;
+    }
+
+    if (current != NULL)
+    {
+        current->next = next;
+    }
+    else
+    {
+        arena->head = next;
+    }
+
+    arena->current = next;
+    arena->used = size;
+    return ArenaChunkData(next);
+}
+
+char *ArenaStringDuplicate(Arena *arena, const char *str)
+{
+    size_t len = strlen(str);
+    char *copy = ArenaAlloc(arena, len + 1);
+    memcpy(copy, str, len + 1);
+    return copy;
+}
+
+/**
+ * @return A mark to give back everything allocated after this call to
+ *         ArenaRelease().
+ */
+ArenaMark ArenaGetMark(const Arena *arena)
+{
+    return (ArenaMark) { .chunk = arena->current, .used = arena->used };
+}
+
+/**
+ * Free everything allocated since #mark was taken. Marks must be released
+ * in reverse order, releasing a mark invalidates the ones taken after it.
+ */
+void ArenaRelease(Arena *arena, ArenaMark mark)
+{
+    arena->current = mark.chunk;
+    arena->used = mark.used;
+}
+
+void ArenaReset(Arena *arena)
+{
+    arena->current = NULL;
+    arena->used = 0;
+}
+
+ArenaStats ArenaGetStats(const Arena *arena)
+{
+    return arena->stats;
+}
@@ -0,0 +1,68 @@
+/*
+   Copyright 2018 Northern.tech AS
+
+   This file is part of CFEngine 3 - written and maintained by Northern.tech AS.
+
+   This program is free software; you can redistribute it and/or modify it
+   under the terms of the GNU General Public License as published by the
+   Free Software Foundation; version 3.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA
+
+  To the extent this program is licensed as part of the Enterprise
+  versions of CFEngine, the applicable Commercial Open Source License
+  (COSL) may apply to this file if you as a licensee so wish it. See
+  included file COSL.txt.
+*/
+
+#ifndef CFENGINE_ARENA_H
+#define CFENGINE_ARENA_H
+
+
+#include <platform.h>
+
+
+/**
+   Bump allocator for memory with stack-like (LIFO) lifetime. Nothing
+   allocated from an Arena is freed individually: ArenaRelease() gives back
+   everything allocated since a mark in one go, and the memory is reused by
+   the next allocations.
+
+   @note THREAD-SAFETY: no, an Arena must not be shared between threads.
+*/
+
+typedef struct Arena_ Arena;
+
+typedef struct
+{
+    void *chunk;
+    size_t used;
+} ArenaMark;
+
+typedef struct
+{
+    unsigned long allocations;       /* ArenaAlloc() calls */
+    unsigned long chunks_allocated;  /* malloc() calls they needed */
+    size_t chunk_bytes;              /* currently held */
+} ArenaStats;
+
+Arena *ArenaNew(size_t chunk_size);
+void ArenaDestroy(Arena *arena);
+
+void *ArenaAlloc(Arena *arena, size_t size);
+char *ArenaStringDuplicate(Arena *arena, const char *str);
+
+ArenaMark ArenaGetMark(const Arena *arena);
+void ArenaRelease(Arena *arena, ArenaMark mark);
+void ArenaReset(Arena *arena);
+
+ArenaStats ArenaGetStats(const Arena *arena);
+
+#endif  /* CFENGINE_ARENA_H */
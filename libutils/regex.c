@@ -31,17 +31,154 @@
 #include <string_lib.h>
 
 #include <buffer.h>
+#include <map.h>
 
 #define STRING_MATCH_OVECCOUNT 30
 
+#define REGEX_OPTIONS (PCRE_MULTILINE | PCRE_DOTALL)
 
-pcre *CompileRegex(const char *regex)
+
+/**
+   Cache of compiled regular expressions, shared by all threads. Policy
+   evaluation matches the same few hundred patterns (class expressions,
+   classmatch(), edit_line selections, ...) over and over again, with this
+   each of them is compiled and studied only once per process. Where PCRE
+   supports it, the patterns are JIT-compiled too.
+
+   Entries are keyed by the compile options and the pattern. Patterns that
+   don't compile are cached too, so that the error is only reported once.
+   The least recently used entries are evicted when there are more than
+   REGEX_CACHE_MAX_ENTRIES, unless a match with them is running.
+
+   @note THREAD-SAFETY: yes, all access is under regex_cache_mutex. The
+         matching itself is done without holding the lock.
+*/
+
+#define REGEX_CACHE_MAX_ENTRIES 1024
+
+typedef struct RegexCacheEntry_ RegexCacheEntry;
+struct RegexCacheEntry_
+{
+    char *key;                                         /* "options:regex" */
+    pcre *rx;                               /* NULL if it doesn't compile */
+    pcre_extra *extra;                         /* pcre_study(), maybe NULL */
+    size_t size;                                  /* of the compiled rx */
+
+    size_t refcount;                              /* matches running now */
+    bool stale;                          /* no longer in the cache, free it */
+
+    RegexCacheEntry *prev;                        /* LRU list, more recent */
+    RegexCacheEntry *next;                         /* LRU list, less recent */
+};
+
+static pthread_mutex_t regex_cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static Map *regex_cache = NULL;                         /* key -> entry */
+static RegexCacheEntry *regex_lru_head = NULL;
+static RegexCacheEntry *regex_lru_tail = NULL;
+
+static unsigned long regex_stats_hits = 0;
+static unsigned long regex_stats_misses = 0;
+static unsigned long regex_stats_evictions = 0;
+
+
+static pcre_extra *RegexStudy(const pcre *rx, const char *regex)
+{
+    const char *errorstr = NULL;
+#ifdef PCRE_STUDY_JIT_COMPILE
+    pcre_extra *extra = pcre_study(rx, PCRE_STUDY_JIT_COMPILE, &errorstr);
+#else
+    pcre_extra *extra = pcre_study(rx, 0, &errorstr);
+#endif
+    if (errorstr != NULL)
+    {
+        Log(LOG_LEVEL_DEBUG, "pcre_study() failed for '%s' (%s)",
+            regex, errorstr);
+    }
+    return extra;
+}
+
+static void RegexFreeStudy(pcre_extra *extra)
+{
+    if (extra != NULL)
+    {
+#ifdef PCRE_STUDY_JIT_COMPILE
+        pcre_free_study(extra);
+#else
+        pcre_free(extra);
+#endif
+    }
+}
+
+static void RegexCacheEntryDestroy(RegexCacheEntry *entry)
+{
+    RegexFreeStudy(entry->extra);
+    pcre_free(entry->rx);
+    free(entry->key);
+    free(entry);
+}
+
+static void RegexLRUUnlink(RegexCacheEntry *entry)
+{
+    if (entry->prev != NULL)
+    {
+        entry->prev->next = entry->next;
+    }
+    else
+    {
+        regex_lru_head = entry->next;
+    }
+
+    if (entry->next != NULL)
+    {
+        entry->next->prev = entry->prev;
+    }
+    else
+    {
+        regex_lru_tail = entry->prev;
+    }
+
+    entry->prev = entry->next = NULL;
+}
+
+static void RegexLRUPushFront(RegexCacheEntry *entry)
+{
+    entry->prev = NULL;
+    entry->next = regex_lru_head;
+    if (regex_lru_head != NULL)
+    {
+        regex_lru_head->prev = entry;
+    }
+    regex_lru_head = entry;
+    if (regex_lru_tail == NULL)
+    {
+        regex_lru_tail = entry;
+    }
+}
+
+static void RegexCacheEvict(void)
+{
+    RegexCacheEntry *entry = regex_lru_tail;
+    while (MapSize(regex_cache) > REGEX_CACHE_MAX_ENTRIES && entry != NULL)
+    {
+        RegexCacheEntry *prev = entry->prev;
+        if (entry->refcount == 0)
+        {
+            MapRemove(regex_cache, entry->key);
+            RegexLRUUnlink(entry);
+            RegexCacheEntryDestroy(entry);
+            regex_stats_evictions++;
+        }
+        entry = prev;
+    }
+}
+
+static pcre *RegexCompile(const char *regex, int options)
 {
     const char *errorstr;
     int erroffset;
 
-    pcre *rx = pcre_compile(regex, PCRE_MULTILINE | PCRE_DOTALL,
-                            &errorstr, &erroffset, NULL);
+    pcre *rx = pcre_compile(regex, options, &errorstr, &erroffset, NULL);
 
     if (!rx)
     {
@@ -53,6 +190,217 @@ pcre *CompileRegex(const char *regex)
     return rx;
 }
 
+/**
+ * @brief Get #regex compiled with #options from the cache, compiling it
+ *        first if needed.
+ * @return An entry that must be given back with RegexCacheRelease(), or
+ *         NULL if #regex doesn't compile.
+ */
+static RegexCacheEntry *RegexCacheAcquire(const char *regex, int options)
+{
+    char *key;
+    xasprintf(&key, "%d:%s", options, regex);
+
+    pthread_mutex_lock(&regex_cache_mutex);
+
+    if (regex_cache == NULL)
+    {
+        regex_cache = MapNew(StringHash_untyped, StringSafeEqual_untyped,
+                             NULL, NULL);     /* key is owned by the entry */
+    }
+
+    RegexCacheEntry *entry = MapGet(regex_cache, key);
+    if (entry != NULL)
+    {
+        regex_stats_hits++;
+        RegexLRUUnlink(entry);
+        RegexLRUPushFront(entry);
+        if (entry->rx == NULL)
+        {
+            entry = NULL;
+        }
+        else
+        {
+            entry->refcount++;
+        }
+        pthread_mutex_unlock(&regex_cache_mutex);
+
+        free(key);
+        return entry;
+    }
+
+    regex_stats_misses++;
+    pthread_mutex_unlock(&regex_cache_mutex);
+
+    /* Compile without holding the lock, other threads may be matching. */
+    pcre *rx = RegexCompile(regex, options);
+    pcre_extra *extra = NULL;
+    size_t size = 0;
+    if (rx != NULL)
+    {
+        extra = RegexStudy(rx, regex);
+        pcre_fullinfo(rx, NULL, PCRE_INFO_SIZE, &size);
+    }
+
+    RegexCacheEntry *new_entry = xcalloc(1, sizeof(*new_entry));
+    new_entry->key = key;
+    new_entry->rx = rx;
+    new_entry->extra = extra;
+    new_entry->size = size;
+
+    pthread_mutex_lock(&regex_cache_mutex);
+
+    /* Another thread might have compiled it meanwhile. */
+    entry = MapGet(regex_cache, key);
+    if (entry != NULL)
+    {
+        RegexCacheEntryDestroy(new_entry);
+    }
+    else
+    {
+        entry = new_entry;
+        MapInsert(regex_cache, entry->key, entry);
+        RegexLRUPushFront(entry);
+    }
+
+    if (entry->rx == NULL)
+    {
+        entry = NULL;
+    }
+    else
+    {
+        entry->refcount++;
+    }
+    RegexCacheEvict();
+    pthread_mutex_unlock(&regex_cache_mutex);
+
+    return entry;
+}
+
+static void RegexCacheRelease(RegexCacheEntry *entry)
+{
+    pthread_mutex_lock(&regex_cache_mutex);
+
+    assert(entry->refcount > 0);
+    entry->refcount--;
+
+    if (entry->stale && entry->refcount == 0)
+    {
+        RegexCacheEntryDestroy(entry);
+    }
+
+    pthread_mutex_unlock(&regex_cache_mutex);
+}
+
+/**
+ * pcre_exec() with the studied data #extra, falling back to the
+ * interpreter if the JIT code runs out of stack.
+ */
+static int RegexExec(const pcre *rx, const pcre_extra *extra, const char *str,
+                     int *ovector, int ovecsize)
+{
+    int rc = pcre_exec(rx, extra, str, strlen(str), 0, 0, ovector, ovecsize);
+#ifdef PCRE_ERROR_JIT_STACKLIMIT
+    if (rc == PCRE_ERROR_JIT_STACKLIMIT)
+    {
+        rc = pcre_exec(rx, NULL, str, strlen(str), 0, 0, ovector, ovecsize);
+    }
+#endif
+    return rc;
+}
+
+static int RegexCacheExec(const RegexCacheEntry *entry, const char *str,
+                          int *ovector, int ovecsize)
+{
+    return RegexExec(entry->rx, entry->extra, str, ovector, ovecsize);
+}
+
+#ifdef TEST_REGEX_CACHE
+
+/**
+ * Drop all cached patterns. Those that are being matched at the moment are
+ * freed once released.
+ */
+void RegexCache_Clear(void)
+{
+    pthread_mutex_lock(&regex_cache_mutex);
+
+    RegexCacheEntry *entry = regex_lru_head;
+    while (entry != NULL)
+    {
+        RegexCacheEntry *next = entry->next;
+        MapRemove(regex_cache, entry->key);
+        RegexLRUUnlink(entry);
+        if (entry->refcount == 0)
+        {
+            RegexCacheEntryDestroy(entry);
+        }
+        else
+        {
+            entry->stale = true;
+        }
+        entry = next;
+    }
+
+    pthread_mutex_unlock(&regex_cache_mutex);
+}
+
+void RegexCache_GetStats(unsigned long *hits, unsigned long *misses)
+{
+    pthread_mutex_lock(&regex_cache_mutex);
+    *hits = regex_stats_hits;
+    *misses = regex_stats_misses;
+    pthread_mutex_unlock(&regex_cache_mutex);
+}
+
+#endif /* TEST_REGEX_CACHE */
+
+void RegexCache_LogStats(LogLevel level)
+{
+    pthread_mutex_lock(&regex_cache_mutex);
+
+    unsigned long total = regex_stats_hits + regex_stats_misses;
+    Log(level,
+        "Regex cache: %lu/%lu compilations avoided (%.1f%%),"
+        " %zu patterns cached, %lu evicted, JIT %s",
+        regex_stats_hits, total,
+        (total > 0) ? (100.0 * regex_stats_hits / total) : 0.0,
+        (regex_cache != NULL) ? MapSize(regex_cache) : 0,
+        regex_stats_evictions,
+#ifdef PCRE_STUDY_JIT_COMPILE
+        "available"
+#else
+        "unavailable"
+#endif
+        );
+
+    pthread_mutex_unlock(&regex_cache_mutex);
+}
+
+/**
+ * @return A compiled copy of #regex, owned by the caller and freed with
+ *         pcre_free(). It is copied from the regex cache, so compiling the
+ *         same pattern again is cheap.
+ */
+pcre *CompileRegex(const char *regex)
+{
+    RegexCacheEntry *entry = RegexCacheAcquire(regex, REGEX_OPTIONS);
+    if (entry == NULL)
+    {
+        return NULL;
+    }
+
+    /* Compiled patterns are relocatable, see pcreprecompile(3). */
+    pcre *rx = pcre_malloc(entry->size);
+    if (rx != NULL)
+    {
+        memcpy(rx, entry->rx, entry->size);
+    }
+    RegexCacheRelease(entry);
+
+    return (rx != NULL) ? rx : RegexCompile(regex, REGEX_OPTIONS);
+}
+
 bool StringMatchWithPrecompiledRegex(pcre *regex, const char *str, int *start, int *end)
 {
     assert(regex);
@@ -88,35 +436,91 @@ bool StringMatchWithPrecompiledRegex(pcre *regex, const char *str, int *start, i
     return result >= 0;
 }
 
-bool StringMatch(const char *regex, const char *str, int *start, int *end)
+/**
+ * @return #regex from the regex cache, to be given back with
+ *         CachedRegexRelease(), or NULL if it doesn't compile. Unlike the
+ *         copy returned by CompileRegex(), it is studied, and JIT-compiled
+ *         where PCRE supports it, so prefer it to match many strings.
+ */
+CachedRegex *CachedRegexAcquire(const char *regex)
 {
-    pcre *pattern = CompileRegex(regex);
+    assert(regex);
+    return RegexCacheAcquire(regex, REGEX_OPTIONS);
+}
 
-    if (pattern == NULL)
+void CachedRegexRelease(CachedRegex *rx)
+{
+    if (rx != NULL)
     {
-        return false;
+        RegexCacheRelease(rx);
     }
+}
+
+bool StringMatchWithCachedRegex(const CachedRegex *rx, const char *str,
+                                int *start, int *end)
+{
+    assert(rx);
+    assert(str);
 
-    bool ret = StringMatchWithPrecompiledRegex(pattern, str, start, end);
+    int ovector[STRING_MATCH_OVECCOUNT] = { 0 };
+    int result = RegexCacheExec(rx, str, ovector, STRING_MATCH_OVECCOUNT);
 
-    pcre_free(pattern);
-    return ret;
+    if (start)
+    {
+        *start = (result >= 0) ? ovector[0] : 0;
+    }
+    if (end)
+    {
+        *end = (result >= 0) ? ovector[1] : 0;
+    }
 
+    return result >= 0;
 }
 
-bool StringMatchFull(const char *regex, const char *str)
+bool StringMatchFullWithCachedRegex(const CachedRegex *rx, const char *str)
 {
-    pcre *pattern = CompileRegex(regex);
+    int start = 0, end = 0;
+
+    if (StringMatchWithCachedRegex(rx, str, &start, &end))
+    {
+        return (start == 0) && (end == strlen(str));
+    }
+    else
+    {
+        return false;
+    }
+}
 
-    if (pattern == NULL)
+bool StringMatch(const char *regex, const char *str, int *start, int *end)
+{
+    assert(regex);
+    assert(str);
+
+    RegexCacheEntry *entry = RegexCacheAcquire(regex, REGEX_OPTIONS);
+
+    if (entry == NULL)
     {
         return false;
     }
 
-    bool ret = StringMatchFullWithPrecompiledRegex(pattern, str);
+    bool result = StringMatchWithCachedRegex(entry, str, start, end);
+    RegexCacheRelease(entry);
 
-    pcre_free(pattern);
-    return ret;
+    return result;
+}
+
+bool StringMatchFull(const char *regex, const char *str)
+{
+    int start = 0, end = 0;
+
+    if (StringMatch(regex, str, &start, &end))
+    {
+        return (start == 0) && (end == strlen(str));
+    }
+    else
+    {
+        return false;
+    }
 }
 
 bool StringMatchFullWithPrecompiledRegex(pcre *pattern, const char *str)
@@ -235,21 +639,15 @@ Seq *StringMatchCaptures(const char *regex, const char *str, const bool return_n
     assert(regex);
     assert(str);
 
-    pcre *pattern = NULL;
-    {
-        const char *errorstr;
-        int erroffset;
-        pattern = pcre_compile(regex, PCRE_MULTILINE | PCRE_DOTALL,
-                               &errorstr, &erroffset, NULL);
-    }
+    RegexCacheEntry *entry = RegexCacheAcquire(regex, REGEX_OPTIONS);
 
-    if (pattern == NULL)
+    if (entry == NULL)
     {
         return NULL;
     }
 
-    Seq *ret = StringMatchCapturesWithPrecompiledRegex(pattern, str, return_names);
-    pcre_free(pattern);
+    Seq *ret = StringMatchCapturesWithPrecompiledRegex(entry->rx, str, return_names);
+    RegexCacheRelease(entry);
     return ret;
 }
 
@@ -283,3 +681,201 @@ bool RegexPartialMatch(const pcre *rx, const char *teststring)
 
     return rc >= 0;
 }
+
+/**
+   A list of regular expressions merged into a single alternation, so that a
+   string is tested against all of them with one pcre_exec(). Each member
+   is wrapped in a capturing group, the first group that took part in the
+   match tells which member matched.
+
+   Members that can't be merged without changing their meaning (numbered
+   back references or subroutine calls, (*VERB)s) are kept aside and
+   matched one by one, as are all members if the merged pattern doesn't
+   compile. Invalid members never match.
+*/
+
+typedef struct
+{
+    pcre *rx;                                    /* NULL if it's invalid */
+    int group;                   /* capturing group in the merged pattern,
+                                    0 if it's matched on its own */
+} RegexSetMember;
+
+struct RegexSet_
+{
+    size_t length;
+    RegexSetMember *members;
+
+    pcre *rx;                                   /* merged, maybe NULL */
+    pcre_extra *extra;
+    int ovecsize;
+};
+
+static bool RegexCanBeMerged(const char *regex, const pcre *rx)
+{
+    int backrefmax = 0;
+    pcre_fullinfo(rx, NULL, PCRE_INFO_BACKREFMAX, &backrefmax);
+    if (backrefmax > 0 || strstr(regex, "(*") != NULL ||
+        strstr(regex, "\\g") != NULL)
+    {
+        return false;
+    }
+
+    for (const char *p = strstr(regex, "(?"); p != NULL; p = strstr(p + 2, "(?"))
+    {
+        /* (?R) (?1) (?+1) (?-1) (?&name) (?P>name) */
+        if (p[2] != '\0' && strchr("R0123456789+-&P", p[2]) != NULL)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @param regexes Seq of the regular expressions (char *), not retained.
+ */
+RegexSet *RegexSetNew(const Seq *regexes)
+{
+    RegexSet *set = xcalloc(1, sizeof(RegexSet));
+    set->length = SeqLength(regexes);
+    set->members = xcalloc(set->length, sizeof(RegexSetMember));
+
+    Buffer *merged = BufferNew();
+    BufferAppendString(merged, "\\A(?:");
+
+    int groups = 0;
+    bool first = true;
+    for (size_t i = 0; i < set->length; i++)
+    {
+        const char *regex = SeqAt(regexes, i);
+        RegexSetMember *member = &set->members[i];
+
+        member->rx = CompileRegex(regex);
+        if (member->rx == NULL || !RegexCanBeMerged(regex, member->rx))
+        {
+            continue;
+        }
+
+        int captures = 0;
+        pcre_fullinfo(member->rx, NULL, PCRE_INFO_CAPTURECOUNT, &captures);
+
+        BufferAppendString(merged, first ? "(" : "|(");
+        BufferAppendString(merged, regex);
+        BufferAppendChar(merged, ')');
+        first = false;
+
+        member->group = groups + 1;
+        groups += captures + 1;
+    }
+
+    BufferAppendString(merged, ")\\z");
+
+    if (!first)
+    {
+        const char *errorstr;
+        int erroffset;
+        set->rx = pcre_compile(BufferData(merged), REGEX_OPTIONS,
+                               &errorstr, &erroffset, NULL);
+        if (set->rx != NULL)
+        {
+            set->extra = RegexStudy(set->rx, BufferData(merged));
+            set->ovecsize = (groups + 1) * 3;
+        }
+        else
+        {
+            /* E.g. the same group name in two members. */
+            Log(LOG_LEVEL_DEBUG,
+                "Matching %zu regular expressions one by one,"
+                " they can't be merged (%s)", set->length, errorstr);
+            for (size_t i = 0; i < set->length; i++)
+            {
+                set->members[i].group = 0;
+            }
+        }
+    }
+
+    BufferDestroy(merged);
+    return set;
+}
+
+void RegexSetDestroy(RegexSet *set)
+{
+    if (set != NULL)
+    {
+        for (size_t i = 0; i < set->length; i++)
+        {
+            pcre_free(set->members[i].rx);
+        }
+        free(set->members);
+        RegexFreeStudy(set->extra);
+        pcre_free(set->rx);
+        free(set);
+    }
+}
+
+size_t RegexSetLength(const RegexSet *set)
+{
+    return set->length;
+}
+
+/**
+ * @return The index of the first member for which StringMatchFull() would
+ *         be true, or -1 if none of them matches #str.
+ */
+int RegexSetMatchFull(const RegexSet *set, const char *str)
+{
+    assert(set);
+    assert(str);
+
+    /* The first merged member matching all of #str. */
+    size_t found = set->length;
+    if (set->rx != NULL)
+    {
+        int ovector_stack[STRING_MATCH_OVECCOUNT];
+        int *ovector = (set->ovecsize <= STRING_MATCH_OVECCOUNT) ?
+            ovector_stack : xmalloc(set->ovecsize * sizeof(int));
+
+        if (RegexExec(set->rx, set->extra, str, ovector, set->ovecsize) >= 0)
+        {
+            for (size_t i = 0; i < set->length; i++)
+            {
+                int group = set->members[i].group;
+                if (group > 0 && ovector[2 * group] >= 0)
+                {
+                    found = i;
+                    break;
+                }
+            }
+        }
+
+        if (ovector != ovector_stack)
+        {
+            free(ovector);
+        }
+
+        /* The merged pattern is anchored, StringMatchFull() takes the
+         * leftmost-first match, which only differs for alternations like
+         * "a|ab". Confirm and keep looking if needed. */
+        while (found < set->length &&
+               !(set->members[found].group > 0 &&
+                 StringMatchFullWithPrecompiledRegex(set->members[found].rx, str)))
+        {
+            found++;
+        }
+    }
+
+    /* Members matched on their own. */
+    for (size_t i = 0; i < found; i++)
+    {
+        const RegexSetMember *member = &set->members[i];
+        if (member->rx != NULL && member->group == 0 &&
+            StringMatchFullWithPrecompiledRegex(member->rx, str))
+        {
+            return i;
+        }
+    }
+
+    return (found < set->length) ? (int) found : -1;
+}
@@ -32,6 +32,7 @@
 #include <pcre_include.h>
 
 #include <sequence.h>                                           /* Seq */
+#include <logging.h>                                           /* LogLevel */
 
 #define CFENGINE_REGEX_WHITESPACE_IN_CONTEXTS ".*[_A-Za-z0-9][ \\t]+[_A-Za-z0-9].*"
 
@@ -49,4 +50,27 @@ bool CompareStringOrRegex(const char *value, const char *compareTo, bool regex);
 /* Does not free rx! */
 bool RegexPartialMatch(const pcre *rx, const char *teststring);
 
+typedef struct RegexSet_ RegexSet;
+
+RegexSet *RegexSetNew(const Seq *regexes);
+void RegexSetDestroy(RegexSet *set);
+size_t RegexSetLength(const RegexSet *set);
+int RegexSetMatchFull(const RegexSet *set, const char *str);
+
+/* Matching many strings against the same pattern: see CachedRegexAcquire(). */
+typedef struct RegexCacheEntry_ CachedRegex;
+
+CachedRegex *CachedRegexAcquire(const char *regex);
+void CachedRegexRelease(CachedRegex *rx);
+bool StringMatchWithCachedRegex(const CachedRegex *rx, const char *str,
+                                int *start, int *end);
+bool StringMatchFullWithCachedRegex(const CachedRegex *rx, const char *str);
+
+void RegexCache_LogStats(LogLevel level);
+
+#ifdef TEST_REGEX_CACHE
+void RegexCache_Clear(void);
+void RegexCache_GetStats(unsigned long *hits, unsigned long *misses);
+#endif
+
 #endif  /* CFENGINE_REGEX_H */
@@ -0,0 +1,194 @@
+/*
+   Copyright 2018 Northern.tech AS
+
+   This file is part of CFEngine 3 - written and maintained by Northern.tech AS.
+
+   This program is free software; you can redistribute it and/or modify it
+   under the terms of the GNU General Public License as published by the
+   Free Software Foundation; version 3.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA
+
+  To the extent this program is licensed as part of the Enterprise
+  versions of CFEngine, the applicable Commercial Open Source License
+  (COSL) may apply to this file if you as a licensee so wish it. See
+  included file COSL.txt.
+*/
+
+#include <string_intern.h>
+
+#include <alloc.h>
+#include <map.h>
+#include <string_lib.h>                                      /* StringHash */
+
+
+/**
+   Table of interned strings, shared by all threads. Every string is stored
+   once, right after its precomputed hash and its reference count, so that
+   StringInternHash() is a plain memory read.
+
+   @note THREAD-SAFETY: yes, all access to the table is under
+         string_intern_mutex. The interned strings themselves are immutable.
+*/
+
+typedef struct
+{
+    unsigned int hash;
+    size_t refcount;
+    char str[];
+} InternedString;
+
+static pthread_mutex_t string_intern_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static Map *string_intern_table = NULL;         /* str -> InternedString */
+static size_t string_intern_bytes = 0;
+
+
+static InternedString *InternTableGet(const char *str)
+{
+    if (string_intern_table == NULL)
+    {
+        return NULL;
+    }
+    return MapGet(string_intern_table, str);
+}
+
+static InternedString *InternedStringFromStr(const char *interned)
+{
+    return (InternedString *) (interned - offsetof(InternedString, str));
+}
+
+/**
+ * @return The interned copy of #str, adding it to the table if needed.
+ *         NULL if #str is NULL. Release it with StringInternRelease().
+ */
+const char *StringIntern(const char *str)
+{
+    if (str == NULL)
+    {
+        return NULL;
+    }
+
+    pthread_mutex_lock(&string_intern_mutex);
+
+    InternedString *entry = InternTableGet(str);
+    if (entry == NULL)
+    {
+        if (string_intern_table == NULL)
+        {
+            string_intern_table = MapNew(StringHash_untyped,
+                                         StringSafeEqual_untyped,
+                                         NULL, NULL);
+        }
+
+        size_t len = strlen(str);
+        entry = xmalloc(sizeof(InternedString) + len + 1);
+        entry->hash = StringHash(str, 0);
+        entry->refcount = 0;
+        memcpy(entry->str, str, len + 1);
+
+        MapInsert(string_intern_table, entry->str, entry);
+        string_intern_bytes += len + 1;
+    }
+    entry->refcount++;
+
+    pthread_mutex_unlock(&string_intern_mutex);
+    return entry->str;
+}
+
+/**
+ * @brief Take another reference to #interned, cheaper than interning it
+ *        again. NULL is allowed.
+ * @warning #interned MUST come from StringIntern().
+ */
+const char *StringInternRetain(const char *interned)
+{
+    if (interned == NULL)
+    {
+        return NULL;
+    }
+
+    pthread_mutex_lock(&string_intern_mutex);
+    InternedStringFromStr(interned)->refcount++;
+    pthread_mutex_unlock(&string_intern_mutex);
+
+    return interned;
+}
+
+/**
+ * @brief Drop a reference to #interned, freeing it with the last one.
+ *        NULL is allowed.
+ */
+void StringInternRelease(const char *interned)
+{
+    if (interned == NULL)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&string_intern_mutex);
+
+    InternedString *entry = InternedStringFromStr(interned);
+    assert(entry->refcount > 0);
+    if (--entry->refcount == 0)
+    {
+        string_intern_bytes -= strlen(entry->str) + 1;
+        MapRemove(string_intern_table, entry->str);
+        free(entry);
+    }
+
+    pthread_mutex_unlock(&string_intern_mutex);
+}
+
+void StringInternRelease_untyped(void *interned)
+{
+    StringInternRelease(interned);
+}
+
+/**
+ * @return The interned copy of #str, or NULL if it is not interned. No
+ *         reference is taken, the result is only valid while the caller
+ *         holds one by other means.
+ */
+const char *StringInternFind(const char *str)
+{
+    if (str == NULL)
+    {
+        return NULL;
+    }
+
+    pthread_mutex_lock(&string_intern_mutex);
+    InternedString *entry = InternTableGet(str);
+    pthread_mutex_unlock(&string_intern_mutex);
+
+    return (entry != NULL) ? entry->str : NULL;
+}
+
+/**
+ * @return StringHash(#interned, 0), without looking at the string.
+ * @warning #interned MUST come from StringIntern().
+ */
+unsigned int StringInternHash(const char *interned)
+{
+    assert(interned != NULL);
+
+    return InternedStringFromStr(interned)->hash;
+}
+
+void StringIntern_LogStats(LogLevel level)
+{
+    pthread_mutex_lock(&string_intern_mutex);
+
+    Log(level, "Interned strings: %zu, using %zu bytes",
+        (string_intern_table != NULL) ? MapSize(string_intern_table) : 0,
+        string_intern_bytes);
+
+    pthread_mutex_unlock(&string_intern_mutex);
+}
@@ -0,0 +1,55 @@
+/*
+   Copyright 2018 Northern.tech AS
+
+   This file is part of CFEngine 3 - written and maintained by Northern.tech AS.
+
+   This program is free software; you can redistribute it and/or modify it
+   under the terms of the GNU General Public License as published by the
+   Free Software Foundation; version 3.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA
+
+  To the extent this program is licensed as part of the Enterprise
+  versions of CFEngine, the applicable Commercial Open Source License
+  (COSL) may apply to this file if you as a licensee so wish it. See
+  included file COSL.txt.
+*/
+
+#ifndef CFENGINE_STRING_INTERN_H
+#define CFENGINE_STRING_INTERN_H
+
+
+#include <platform.h>
+
+#include <logging.h>                                           /* LogLevel */
+
+
+/**
+   Interned strings are unique per process: two interned strings are equal
+   if and only if they are the same pointer. Only intern identifiers
+   (namespace, bundle, variable and class names), never data such as
+   variable values or array indices.
+
+   Interned strings are reference counted: every StringIntern() or
+   StringInternRetain() must be paired with a StringInternRelease(), and the
+   string is freed with its last reference, so that long-running daemons
+   don't keep the names of every class and variable they have ever seen.
+*/
+
+const char *StringIntern(const char *str);
+const char *StringInternRetain(const char *interned);
+void StringInternRelease(const char *interned);
+void StringInternRelease_untyped(void *interned);
+const char *StringInternFind(const char *str);
+unsigned int StringInternHash(const char *interned);
+
+void StringIntern_LogStats(LogLevel level);
+
+#endif  /* CFENGINE_STRING_INTERN_H */
@@ -0,0 +1,647 @@
+#include <cf3.defs.h>
+#include <generic_agent.h>
+#include <eval_context.h>
+#include <loading.h>
+#include <expand.h>
+#include <fncall.h>
+#include <verify_vars.h>
+#include <verify_classes.h>
+#include <known_dirs.h>
+#include <crypto.h>                                      /* CryptoInitialize */
+#include <file_lib.h>                                    /* safe_fopen */
+#include <misc_lib.h>                                    /* xsnprintf */
+#include <json.h>
+#include <writer.h>
+
+#include <libgen.h>                                             /* basename */
+#include <sys/resource.h>                                        /* getrusage */
+
+
+/*
+ * Generates a synthetic policy of the given size, then loads and evaluates
+ * it the way cf-agent does, and prints how long every phase took and its
+ * peak memory use as one JSON object.
+ *
+ * Only vars and classes promises are actuated, reports promises are
+ * expanded but not printed, so the numbers are those of the evaluator
+ * itself: iteration, expansion, functions and the evaluation context.
+ */
+
+#define SOURCE_PATH "policy_load"
+
+typedef struct
+{
+    int bundles;          /* agent bundles */
+    int promises;         /* vars and reports promises per agent bundle */
+    int list_size;        /* items of the slist every reports promise
+                           * iterates over */
+    int classes;          /* classes, in the common and every agent bundle */
+    int data_size;        /* keys of the data container */
+    int functions;        /* function calls per agent bundle */
+    bool json;            /* write the policy as JSON instead of CFEngine
+                           * syntax */
+    bool keep;            /* keep the work directory */
+} Parameters;
+
+char CFWORKDIR[CF_BUFSIZE];
+
+
+static void print_usage(const char *program)
+{
+    printf("Usage: %s [-b BUNDLES] [-p PROMISES] [-l LIST_SIZE] [-c CLASSES]\n"
+           "       [-d DATA_SIZE] [-f FUNCTIONS] [-j] [-k]\n"
+           "\n"
+           "    -b  agent bundles (default 10)\n"
+           "    -p  vars and reports promises per agent bundle (default 10)\n"
+           "    -l  items of the slist that reports iterate over (default 10)\n"
+           "    -c  classes per bundle (default 10)\n"
+           "    -d  keys of the data container (default 10)\n"
+           "    -f  function calls per agent bundle (default 10)\n"
+           "    -j  write the policy as JSON instead of CFEngine syntax\n"
+           "    -k  keep the work directory\n",
+           program);
+}
+
+static int ParseCount(const char *arg, const char *program)
+{
+    int count;
+    if (sscanf(arg, "%d", &count) != 1 || count < 0)
+    {
+        print_usage(program);
+        exit(EXIT_FAILURE);
+    }
+    return count;
+}
+
+static void parse_args(int argc, char *argv[], Parameters *params)
+{
+    *params = (Parameters) {
+        .bundles = 10, .promises = 10, .list_size = 10,
+        .classes = 10, .data_size = 10, .functions = 10,
+    };
+
+    const char *program = basename(argv[0]);
+    int c;
+    while ((c = getopt(argc, argv, "b:p:l:c:d:f:jkh")) != -1)
+    {
+        switch (c)
+        {
+        case 'b':
+            params->bundles = ParseCount(optarg, program);
+            break;
+        case 'p':
+            params->promises = ParseCount(optarg, program);
+            break;
+        case 'l':
+            params->list_size = ParseCount(optarg, program);
+            break;
+        case 'c':
+            params->classes = ParseCount(optarg, program);
+            break;
+        case 'd':
+            params->data_size = ParseCount(optarg, program);
+            break;
+        case 'f':
+            params->functions = ParseCount(optarg, program);
+            break;
+        case 'j':
+            params->json = true;
+            break;
+        case 'k':
+            params->keep = true;
+            break;
+        case 'h':
+            print_usage(program);
+            exit(EXIT_SUCCESS);
+        default:
+            print_usage(program);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    if (optind < argc || params->bundles == 0)
+    {
+        print_usage(program);
+        exit(EXIT_FAILURE);
+    }
+}
+
+/*********************************************************************/
+/* Policy generator                                                  */
+/*********************************************************************/
+
+static Rval ScalarRval(const char *fmt, ...) FUNC_ATTR_PRINTF(1, 2);
+static Rval ScalarRval(const char *fmt, ...)
+{
+    va_list ap;
+    va_start(ap, fmt);
+    char *value = NULL;
+    xvasprintf(&value, fmt, ap);
+    va_end(ap);
+    return (Rval) { value, RVAL_TYPE_SCALAR };
+}
+
+static Rval FnCallRval(const char *name, int argc, ...)
+{
+    Rlist *args = NULL;
+    va_list ap;
+    va_start(ap, argc);
+    for (int i = 0; i < argc; i++)
+    {
+        RlistAppendScalar(&args, va_arg(ap, const char *));
+    }
+    va_end(ap);
+    return (Rval) { FnCallNew(name, args), RVAL_TYPE_FNCALL };
+}
+
+static Promise *AppendPromise(PromiseType *tp, const char *promiser,
+                              const char *classes)
+{
+    return PromiseTypeAppendPromise(tp, promiser,
+                                    (Rval) { NULL, RVAL_TYPE_NOPROMISEE },
+                                    classes, NULL);
+}
+
+/* Every other class is defined, so some promises are skipped. */
+static void AppendClasses(Bundle *bundle, const char *prefix, int count)
+{
+    PromiseType *classes = BundleAppendPromiseType(bundle, "classes");
+    for (int i = 0; i < count; i++)
+    {
+        char promiser[CF_MAXVARSIZE];
+        xsnprintf(promiser, sizeof(promiser), "%s_%d", prefix, i);
+        Promise *pp = AppendPromise(classes, promiser, NULL);
+        PromiseAppendConstraint(pp, "expression",
+                                ScalarRval("%s", (i % 2 == 0) ? "any" : "!any"),
+                                false);
+    }
+}
+
+/*
+ * bench_common defines the slist, the data container and the classes the
+ * agent bundles use.
+ */
+static void AppendCommonBundle(Policy *policy, const Parameters *params)
+{
+    Bundle *bundle = PolicyAppendBundle(policy, "default", "bench_common",
+                                        "common", NULL, SOURCE_PATH);
+    PromiseType *vars = BundleAppendPromiseType(bundle, "vars");
+
+    Rlist *items = NULL;
+    for (int i = 0; i < params->list_size; i++)
+    {
+        char item[CF_SMALLBUF];
+        xsnprintf(item, sizeof(item), "item_%d", i);
+        RlistAppendScalar(&items, item);
+    }
+    Promise *pp = AppendPromise(vars, "list", NULL);
+    PromiseAppendConstraint(pp, "slist", (Rval) { items, RVAL_TYPE_LIST }, false);
+
+    JsonElement *data = JsonObjectCreate(params->data_size);
+    for (int i = 0; i < params->data_size; i++)
+    {
+        char key[CF_SMALLBUF], value[CF_SMALLBUF];
+        xsnprintf(key, sizeof(key), "key_%d", i);
+        xsnprintf(value, sizeof(value), "value_%d", i);
+        JsonObjectAppendString(data, key, value);
+    }
+    Writer *w = StringWriter();
+    JsonWriteCompact(w, data);
+    JsonDestroy(data);
+    pp = AppendPromise(vars, "data", NULL);
+    PromiseAppendConstraint(pp, "data",
+                            FnCallRval("parsejson", 1, StringWriterData(w)),
+                            false);
+    WriterClose(w);
+
+    AppendClasses(bundle, "bench_class", params->classes);
+}
+
+/* A mix of functions on strings, lists and data containers. */
+static void AppendFunctionCall(PromiseType *vars, int bundle_index, int i,
+                               const Parameters *params)
+{
+    char promiser[CF_SMALLBUF];
+    xsnprintf(promiser, sizeof(promiser), "f_%d", i);
+    Promise *pp = AppendPromise(vars, promiser, NULL);
+
+    char key[CF_SMALLBUF], number[CF_SMALLBUF];
+    xsnprintf(key, sizeof(key), "key_%d", i % MAX(params->data_size, 1));
+    xsnprintf(number, sizeof(number), "%d", i);
+
+    switch (i % 6)
+    {
+    case 0:
+        PromiseAppendConstraint(pp, "string",
+                                FnCallRval("canonify", 1, "bench $(this.bundle) $(this.promiser)"),
+                                false);
+        break;
+    case 1:
+        PromiseAppendConstraint(pp, "string",
+                                FnCallRval("join", 2, ",", "bench_common.list"),
+                                false);
+        break;
+    case 2:
+        PromiseAppendConstraint(pp, "int",
+                                FnCallRval("length", 1, "bench_common.list"),
+                                false);
+        break;
+    case 3:
+        PromiseAppendConstraint(pp, "string",
+                                FnCallRval("nth", 2, "bench_common.data", key),
+                                false);
+        break;
+    case 4:
+        PromiseAppendConstraint(pp, "slist",
+                                FnCallRval("getindices", 1, "bench_common.data"),
+                                false);
+        break;
+    default:
+        {
+            char bundle_number[CF_SMALLBUF];
+            xsnprintf(bundle_number, sizeof(bundle_number), "%d", bundle_index);
+            PromiseAppendConstraint(pp, "string",
+                                    FnCallRval("format", 3, "bench_%s_%s",
+                                               bundle_number, number),
+                                    false);
+        }
+        break;
+    }
+}
+
+static void AppendAgentBundle(Policy *policy, int index,
+                              const Parameters *params)
+{
+    char name[CF_SMALLBUF];
+    xsnprintf(name, sizeof(name), "bench_%d", index);
+    Bundle *bundle = PolicyAppendBundle(policy, "default", name, "agent",
+                                        NULL, SOURCE_PATH);
+
+    PromiseType *vars = BundleAppendPromiseType(bundle, "vars");
+    for (int i = 0; i < params->promises; i++)
+    {
+        char promiser[CF_SMALLBUF];
+        xsnprintf(promiser, sizeof(promiser), "s_%d", i);
+        Promise *pp = AppendPromise(vars, promiser, NULL);
+        if (params->data_size > 0)
+        {
+            PromiseAppendConstraint(pp, "string",
+                                    ScalarRval("%s %d $(bench_common.data[key_%d])",
+                                               name, i, i % params->data_size),
+                                    false);
+        }
+        else
+        {
+            PromiseAppendConstraint(pp, "string", ScalarRval("%s %d", name, i),
+                                    false);
+        }
+    }
+    for (int i = 0; i < params->functions; i++)
+    {
+        AppendFunctionCall(vars, index, i, params);
+    }
+
+    AppendClasses(bundle, name, params->classes);
+
+    PromiseType *reports = BundleAppendPromiseType(bundle, "reports");
+    for (int i = 0; i < params->promises; i++)
+    {
+        char promiser[CF_MAXVARSIZE];
+        xsnprintf(promiser, sizeof(promiser),
+                  "%s $(bench_common.list) $(s_%d)", name, i);
+
+        char classes[CF_SMALLBUF] = "any";
+        if (params->classes > 0)
+        {
+            xsnprintf(classes, sizeof(classes), "bench_class_%d",
+                      i % params->classes);
+        }
+        AppendPromise(reports, promiser, classes);
+    }
+}
+
+static Policy *GeneratePolicy(const Parameters *params)
+{
+    Policy *policy = PolicyNew();
+
+    AppendCommonBundle(policy, params);
+
+    Rlist *bundlesequence = NULL;
+    for (int i = 0; i < params->bundles; i++)
+    {
+        AppendAgentBundle(policy, i, params);
+
+        char name[CF_SMALLBUF];
+        xsnprintf(name, sizeof(name), "bench_%d", i);
+        RlistAppendScalar(&bundlesequence, name);
+    }
+
+    Body *control = PolicyAppendBody(policy, "default", "control", "common",
+                                     NULL, SOURCE_PATH);
+    BodyAppendConstraint(control, "bundlesequence",
+                         (Rval) { bundlesequence, RVAL_TYPE_LIST },
+                         "any", false);
+
+    return policy;
+}
+
+/**
+ * @return The size of the policy file written to #path.
+ */
+static long WritePolicy(const Policy *policy, const char *path, bool json)
+{
+    FILE *fp = safe_fopen(path, "w");
+    if (fp == NULL)
+    {
+        perror("fopen");
+        exit(EXIT_FAILURE);
+    }
+
+    Writer *w = FileWriter(fp);
+    if (json)
+    {
+        JsonElement *json_policy = PolicyToJson(policy);
+        JsonWrite(w, json_policy, 0);
+        JsonDestroy(json_policy);
+    }
+    else
+    {
+        PolicyToString(policy, w);
+    }
+    long size = ftell(fp);
+    WriterClose(w);
+
+    return size;
+}
+
+/*********************************************************************/
+/* Phases                                                            */
+/*********************************************************************/
+
+typedef struct
+{
+    const char *name;
+    struct timespec wall;
+    struct rusage usage;
+    bool peak_rss_reset;
+} Phase;
+
+static double TimevalMs(struct timeval tv)
+{
+    return tv.tv_sec * 1000.0 + tv.tv_usec / 1000.0;
+}
+
+/*
+ * getrusage() only has the peak RSS of the whole process. Linux can reset
+ * it for the phase that starts, and tell it as VmHWM.
+ */
+static bool ResetPeakRss(void)
+{
+    FILE *fp = safe_fopen("/proc/self/clear_refs", "w");
+    if (fp == NULL)
+    {
+        return false;
+    }
+
+    bool ok = (fputs("5", fp) >= 0);
+    return (fclose(fp) == 0) && ok;
+}
+
+/* @return The peak RSS since ResetPeakRss() in kB, or -1. */
+static long ReadPeakRssKb(void)
+{
+    FILE *fp = safe_fopen("/proc/self/status", "r");
+    if (fp == NULL)
+    {
+        return -1;
+    }
+
+    long kb = -1;
+    char line[256];
+    while (kb == -1 && fgets(line, sizeof(line), fp) != NULL)
+    {
+        if (sscanf(line, "VmHWM: %ld kB", &kb) != 1)
+        {
+            kb = -1;
+        }
+    }
+    fclose(fp);
+
+    return kb;
+}
+
+static Phase PhaseBegin(const char *name)
+{
+    Phase phase = { .name = name };
+    phase.peak_rss_reset = ResetPeakRss();
+    getrusage(RUSAGE_SELF, &phase.usage);
+    clock_gettime(CLOCK_MONOTONIC, &phase.wall);
+    return phase;
+}
+
+/**
+ * Append the time #phase took and its peak memory use in kB, where it can
+ * be told apart, to #phases. The peak of the process so far is appended
+ * too (in kB on most platforms).
+ */
+static void PhaseEnd(const Phase *phase, JsonElement *phases)
+{
+    struct timespec wall;
+    clock_gettime(CLOCK_MONOTONIC, &wall);
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+
+    double wall_ms = (wall.tv_sec - phase->wall.tv_sec) * 1000.0 +
+                     (wall.tv_nsec - phase->wall.tv_nsec) / 1e6;
+    double cpu_ms = TimevalMs(usage.ru_utime) + TimevalMs(usage.ru_stime) -
+                    TimevalMs(phase->usage.ru_utime) -
+                    TimevalMs(phase->usage.ru_stime);
+
+    JsonElement *json = JsonObjectCreate(5);
+    JsonObjectAppendString(json, "name", phase->name);
+    JsonObjectAppendReal(json, "wallMs", wall_ms);
+    JsonObjectAppendReal(json, "cpuMs", cpu_ms);
+    long max_rss_kb = phase->peak_rss_reset ? ReadPeakRssKb() : -1;
+    if (max_rss_kb != -1)
+    {
+        JsonObjectAppendInteger(json, "maxRssKb", max_rss_kb);
+    }
+    JsonObjectAppendInteger(json, "processMaxRssKb", usage.ru_maxrss);
+    JsonArrayAppendObject(phases, json);
+}
+
+/* Actuate what only changes the evaluation context. */
+static PromiseResult BenchActuator(EvalContext *ctx, const Promise *pp,
+                                   void *param)
+{
+    unsigned long *actuations = param;
+    (*actuations)++;
+
+    const char *type = pp->parent_promise_type->name;
+    if (strcmp(type, "vars") == 0)
+    {
+        return VerifyVarPromise(ctx, pp, NULL);
+    }
+    else if (strcmp(type, "classes") == 0)
+    {
+        return VerifyClassPromise(ctx, pp, NULL);
+    }
+    return PROMISE_RESULT_NOOP;
+}
+
+/* Like ScheduleAgentOperations() in cf-agent, for every agent bundle. */
+static unsigned long EvaluatePolicy(EvalContext *ctx, const Policy *policy)
+{
+    static const char *const types[] = { "vars", "classes", "reports", NULL };
+    unsigned long actuations = 0;
+
+    for (size_t i = 0; i < SeqLength(policy->bundles); i++)
+    {
+        const Bundle *bp = SeqAt(policy->bundles, i);
+        if (strcmp(bp->type, "agent") != 0)
+        {
+            continue;
+        }
+
+        EvalContextStackPushBundleFrame(ctx, bp, NULL, false);
+        for (int pass = 1; pass < CF_DONEPASSES; pass++)
+        {
+            for (int type = 0; types[type] != NULL; type++)
+            {
+                const PromiseType *sp = BundleGetPromiseType((Bundle *) bp,
+                                                             types[type]);
+                if (sp == NULL)
+                {
+                    continue;
+                }
+
+                EvalContextStackPushPromiseTypeFrame(ctx, sp);
+                for (size_t ppi = 0; ppi < SeqLength(sp->promises); ppi++)
+                {
+                    EvalContextSetPass(ctx, pass);
+                    ExpandPromise(ctx, SeqAt(sp->promises, ppi),
+                                  BenchActuator, &actuations);
+                }
+                EvalContextStackPopFrame(ctx);
+
+                if (strcmp(types[type], "classes") == 0)
+                {
+                    BundleResolve(ctx, bp);
+                }
+            }
+        }
+        EvalContextStackPopFrame(ctx);
+    }
+
+    return actuations;
+}
+
+/*********************************************************************/
+
+static void tests_setup(void)
+{
+    xsnprintf(CFWORKDIR, sizeof(CFWORKDIR), "/tmp/policy_load.XXXXXX");
+    if (mkdtemp(CFWORKDIR) == NULL)
+    {
+        perror("mkdtemp");
+        exit(EXIT_FAILURE);
+    }
+
+    char *envvar;
+    xasprintf(&envvar, "%s=%s", "CFENGINE_TEST_OVERRIDE_WORKDIR", CFWORKDIR);
+    putenv(envvar);
+
+    if (mkdir(GetInputDir(), 0700) != 0)
+    {
+        perror("mkdir");
+        exit(EXIT_FAILURE);
+    }
+}
+
+static void tests_teardown(void)
+{
+    char cmd[CF_BUFSIZE];
+    xsnprintf(cmd, sizeof(cmd), "rm -rf '%s'", CFWORKDIR);
+    system(cmd);
+}
+
+int main(int argc, char *argv[])
+{
+    Parameters params;
+    parse_args(argc, argv, &params);
+
+    /* Only the results go to stdout. */
+    LogSetGlobalLevel(LOG_LEVEL_ERR);
+    tests_setup();
+
+    JsonElement *phases = JsonArrayCreate(4);
+
+    Phase phase = PhaseBegin("generate");
+    char path[CF_BUFSIZE];
+    xsnprintf(path, sizeof(path), "%s%cpromises.%s", GetInputDir(),
+              FILE_SEPARATOR, params.json ? "json" : "cf");
+    Policy *generated = GeneratePolicy(&params);
+    long policy_size = WritePolicy(generated, path, params.json);
+    PolicyDestroy(generated);
+    PhaseEnd(&phase, phases);
+
+    CryptoInitialize();
+    EvalContext *ctx = EvalContextNew();
+    GenericAgentConfig *config = GenericAgentConfigNewDefault(AGENT_TYPE_AGENT,
+                                                              false);
+    GenericAgentConfigSetInputFile(config, NULL, path);
+    MINUSF = true;
+    GenericAgentConfigApply(ctx, config);
+
+    phase = PhaseBegin("discovery");
+    GenericAgentDiscoverContext(ctx, config);
+    PhaseEnd(&phase, phases);
+
+    /* Parsing, checking, and resolving common bundles and control bodies. */
+    phase = PhaseBegin("load");
+    Policy *policy = LoadPolicy(ctx, config);
+    PhaseEnd(&phase, phases);
+    if (policy == NULL)
+    {
+        fprintf(stderr, "Unable to load the generated policy '%s'\n", path);
+        exit(EXIT_FAILURE);
+    }
+
+    phase = PhaseBegin("evaluation");
+    unsigned long actuations = EvaluatePolicy(ctx, policy);
+    PhaseEnd(&phase, phases);
+
+    JsonElement *parameters = JsonObjectCreate(7);
+    JsonObjectAppendInteger(parameters, "bundles", params.bundles);
+    JsonObjectAppendInteger(parameters, "promises", params.promises);
+    JsonObjectAppendInteger(parameters, "listSize", params.list_size);
+    JsonObjectAppendInteger(parameters, "classes", params.classes);
+    JsonObjectAppendInteger(parameters, "dataSize", params.data_size);
+    JsonObjectAppendInteger(parameters, "functions", params.functions);
+    JsonObjectAppendString(parameters, "format", params.json ? "json" : "cf");
+
+    JsonElement *result = JsonObjectCreate(4);
+    JsonObjectAppendObject(result, "parameters", parameters);
+    JsonObjectAppendInteger(result, "policyBytes", policy_size);
+    JsonObjectAppendInteger(result, "actuations", actuations);
+    JsonObjectAppendArray(result, "phases", phases);
+
+    Writer *w = FileWriter(stdout);
+    JsonWriteCompact(w, result);
+    WriterWrite(w, "\n");
+    FileWriterDetach(w);
+    JsonDestroy(result);
+
+    PolicyDestroy(policy);
+    GenericAgentFinalize(ctx, config);
+
+    if (params.keep)
+    {
+        fprintf(stderr, "Work directory: %s\n", CFWORKDIR);
+    }
+    else
+    {
+        tests_teardown();
+    }
+    return 0;
+}
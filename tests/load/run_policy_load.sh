@@ -0,0 +1,27 @@
+#!/bin/sh -e
+
+# Without arguments, check that a small synthetic policy loads and
+# evaluates. With "benchmark", scale every parameter of the generated
+# policy in turn and print one JSON object per run, e.g.:
+#
+#   make -C tests/load benchmark > policy_load.jsonl
+
+if [ "x$1" != "xbenchmark" ]
+then
+    ./policy_load -b 2 -p 2 -l 2 -c 2 -d 2 -f 6 > /dev/null
+    ./policy_load -b 2 -p 2 -l 2 -c 2 -d 2 -f 6 -j > /dev/null
+    exit 0
+fi
+
+# bundles promises list_size classes data_size functions [-j]
+run() {
+    ./policy_load -b $1 -p $2 -l $3 -c $4 -d $5 -f $6 $7
+}
+
+for n in 10 100 1000; do run $n 10 10 10 10 10; done
+for n in 10 100 1000; do run 10 $n 10 10 10 10; done
+for n in 10 100 1000; do run 10 10 $n 10 10 10; done
+for n in 10 100 1000; do run 10 10 10 $n 10 10; done
+for n in 10 100 1000 10000; do run 10 10 10 10 $n 10; done
+for n in 10 100 1000; do run 10 10 10 10 10 $n; done
+run 10 10 10 10 10 10 -j
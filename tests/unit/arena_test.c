@@ -0,0 +1,103 @@
+#include <test.h>
+
+#include <arena.h>
+
+static void test_alloc(void)
+{
+    Arena *arena = ArenaNew(64);
+
+    char *a = ArenaAlloc(arena, 3);
+    char *b = ArenaAlloc(arena, 1);
+    assert_true(a != b);
+    assert_int_equal(((uintptr_t) b) % sizeof(void *), 0);
+
+    memset(a, 'a', 3);
+    memset(b, 'b', 1);
+    assert_int_equal(a[2], 'a');
+
+    /* Bigger than a chunk. */
+    char *big = ArenaAlloc(arena, 1000);
+    memset(big, 'x', 1000);
+    assert_int_equal(b[0], 'b');
+
+    char *s = ArenaStringDuplicate(arena, "some string");
+    assert_string_equal(s, "some string");
+
+    ArenaStats stats = ArenaGetStats(arena);
+    assert_int_equal(stats.allocations, 4);
+    assert_int_equal(stats.chunks_allocated, 3);
+
+    ArenaDestroy(arena);
+}
+
+static void test_release(void)
+{
+    Arena *arena = ArenaNew(128);
+
+    ArenaAlloc(arena, 16);
+    ArenaMark mark = ArenaGetMark(arena);
+    void *p = ArenaAlloc(arena, 16);
+
+    ArenaRelease(arena, mark);
+    assert_true(ArenaAlloc(arena, 16) == p);
+
+    ArenaReset(arena);
+    void *first = ArenaAlloc(arena, 16);
+
+    /* Stack-like use only mallocs until the deepest level was reached. */
+    for (int round = 0; round < 10; round++)
+    {
+        ArenaMark marks[20];
+        for (int i = 0; i < 20; i++)
+        {
+            marks[i] = ArenaGetMark(arena);
+            ArenaAlloc(arena, 40);
+        }
+        for (int i = 19; i >= 0; i--)
+        {
+            ArenaRelease(arena, marks[i]);
+        }
+    }
+
+    ArenaStats stats = ArenaGetStats(arena);
+    assert_int_equal(stats.chunks_allocated, 10);
+
+    ArenaReset(arena);
+    assert_true(ArenaAlloc(arena, 16) == first);
+
+    ArenaDestroy(arena);
+}
+
+static void test_reuse_grows_chunk(void)
+{
+    Arena *arena = ArenaNew(64);
+
+    ArenaMark mark = ArenaGetMark(arena);
+    ArenaAlloc(arena, 32);
+    ArenaAlloc(arena, 32);
+    ArenaAlloc(arena, 32);
+    ArenaRelease(arena, mark);
+
+    /* The released chunks are too small and get replaced. */
+    char *big = ArenaAlloc(arena, 256);
+    memset(big, 'x', 256);
+
+    ArenaStats stats = ArenaGetStats(arena);
+    assert_int_equal(stats.chunks_allocated, 3);
+    assert_int_equal(stats.chunk_bytes, 256);
+
+    ArenaDestroy(arena);
+}
+
+int main()
+{
+    PRINT_TEST_BANNER();
+    const UnitTest tests[] =
+    {
+        unit_test(test_alloc),
+        unit_test(test_release),
+        unit_test(test_reuse_grows_chunk),
+    };
+
+    return run_tests(tests);
+}
@@ -0,0 +1,160 @@
+#include <test.h>
+
+#include <net.h>                                     /* SocketConnectFirst */
+#include <client_code.h>                          /* ServerConnectionFirst */
+#include <misc_lib.h>                                          /* xsnprintf */
+
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+
+/* Listens on 127.0.0.1 only, so that connecting to any other loopback
+ * address on the same port is refused right away. */
+static int LISTEN_SD = -1;
+static char LISTEN_PORT[16];
+
+
+static void tests_setup(void)
+{
+    LISTEN_SD = socket(AF_INET, SOCK_STREAM, 0);
+    assert_int_not_equal(LISTEN_SD, -1);
+
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_port = 0,                                   /* any free port */
+    };
+    inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+    assert_int_equal(bind(LISTEN_SD, (struct sockaddr *) &addr,
+                          sizeof(addr)), 0);
+    assert_int_equal(listen(LISTEN_SD, 8), 0);
+
+    socklen_t addr_len = sizeof(addr);
+    assert_int_equal(getsockname(LISTEN_SD, (struct sockaddr *) &addr,
+                                 &addr_len), 0);
+    xsnprintf(LISTEN_PORT, sizeof(LISTEN_PORT), "%d", ntohs(addr.sin_port));
+}
+
+static void tests_teardown(void)
+{
+    close(LISTEN_SD);
+}
+
+static time_t ElapsedSince(time_t start)
+{
+    return time(NULL) - start;
+}
+
+
+static void test_socket_connect_first(void)
+{
+    const char *hosts[] = { "127.0.0.2", "127.0.0.1", "127.0.0.3" };
+    char txtaddr[CF_MAX_IP_LEN] = "";
+    size_t winner = 99;
+
+    time_t start = time(NULL);
+    int sd = SocketConnectFirst(hosts, 3, LISTEN_PORT, 10, true, &winner,
+                                txtaddr, sizeof(txtaddr));
+    assert_int_not_equal(sd, -1);
+    assert_int_equal(winner, 1);
+    assert_string_equal(txtaddr, "127.0.0.1");
+
+    /* The refused host was skipped without waiting for the timeout. */
+    assert_true(ElapsedSince(start) < 2);
+
+    /* The socket is back in blocking mode. */
+    assert_false(fcntl(sd, F_GETFL, NULL) & O_NONBLOCK);
+    close(sd);
+}
+
+static void test_socket_connect_first_in_order(void)
+{
+    const char *hosts[] = { "127.0.0.1", "127.0.0.2" };
+    char txtaddr[CF_MAX_IP_LEN] = "";
+    size_t winner = 99;
+
+    int sd = SocketConnectFirst(hosts, 2, LISTEN_PORT, 10, true, &winner,
+                                txtaddr, sizeof(txtaddr));
+    assert_int_not_equal(sd, -1);
+    assert_int_equal(winner, 0);
+    close(sd);
+}
+
+static void test_socket_connect_first_none(void)
+{
+    const char *hosts[] = { "127.0.0.2", "127.0.0.3" };
+    char txtaddr[CF_MAX_IP_LEN] = "";
+    size_t winner = 99;
+
+    time_t start = time(NULL);
+    int sd = SocketConnectFirst(hosts, 2, LISTEN_PORT, 10, true, &winner,
+                                txtaddr, sizeof(txtaddr));
+    assert_int_equal(sd, -1);
+    assert_int_equal(winner, 99);                            /* untouched */
+    assert_true(ElapsedSince(start) < 2);
+}
+
+static void test_server_connection_first_none(void)
+{
+    const char *servers[] = { "127.0.0.2", "127.0.0.3" };
+    ConnectionFlags flags = {
+        .protocol_version = CF_PROTOCOL_CLASSIC,
+        .force_ipv4 = true,
+    };
+    size_t winner = 99;
+    int err = 0;
+
+    AgentConnection *conn = ServerConnectionFirst(servers, 2, LISTEN_PORT, 10,
+                                                  flags, &winner, &err);
+    assert_true(conn == NULL);
+    assert_int_equal(winner, 2);
+    assert_int_equal(err, -1);
+}
+
+static void test_server_connection_first_handshake_fails(void)
+{
+    /* The TCP connection to 127.0.0.1 succeeds, but there is no key pair
+     * loaded, so the classic protocol handshake fails. The winner is still
+     * reported, so that the caller can retry without it. */
+    const char *servers[] = { "127.0.0.2", "127.0.0.1" };
+    ConnectionFlags flags = {
+        .protocol_version = CF_PROTOCOL_CLASSIC,
+        .force_ipv4 = true,
+    };
+    size_t winner = 99;
+    int err = 0;
+
+    AgentConnection *conn = ServerConnectionFirst(servers, 2, LISTEN_PORT, 10,
+                                                  flags, &winner, &err);
+    assert_true(conn == NULL);
+    assert_int_equal(winner, 1);
+    assert_int_equal(err, -2);
+
+    /* Drop the connection queued on the listening socket. */
+    int sd = accept(LISTEN_SD, NULL, NULL);
+    if (sd != -1)
+    {
+        close(sd);
+    }
+}
+
+
+int main()
+{
+    PRINT_TEST_BANNER();
+    tests_setup();
+
+    const UnitTest tests[] =
+    {
+        unit_test(test_socket_connect_first),
+        unit_test(test_socket_connect_first_in_order),
+        unit_test(test_socket_connect_first_none),
+        unit_test(test_server_connection_first_none),
+        unit_test(test_server_connection_first_handshake_fails),
+    };
+
+    int ret = run_tests(tests);
+
+    tests_teardown();
+    return ret;
+}
@@ -0,0 +1,218 @@
+/*
+   Copyright 2018 Northern.tech AS
+
+   This file is part of CFEngine 3 - written and maintained by Northern.tech AS.
+
+   This program is free software; you can redistribute it and/or modify it
+   under the terms of the GNU General Public License as published by the
+   Free Software Foundation; version 3.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA
+
+  To the extent this program is licensed as part of the Enterprise
+  versions of CFEngine, the applicable Commercial Open Source License
+  (COSL) may apply to this file if you as a licensee so wish it. See
+  included file COSL.txt.
+*/
+
+#include <test.h>
+
+#include <cf3.defs.h>
+#include <download_cache.h>
+#include <known_dirs.h>
+#include <misc_lib.h>                                          /* xsnprintf */
+
+
+char CFWORKDIR[CF_BUFSIZE];
+char SRC_FILE[CF_BUFSIZE];
+char DST_FILE[CF_BUFSIZE];
+
+#define CONTENTS "some remote file contents\n"
+
+static void WriteTestFile(const char *path, const char *contents)
+{
+    FILE *fp = fopen(path, "w");
+    assert_true(fp != NULL);
+    assert_int_equal(fputs(contents, fp) >= 0, true);
+    assert_int_equal(fclose(fp), 0);
+}
+
+static void AssertFileContents(const char *path, const char *contents)
+{
+    char buf[CF_BUFSIZE] = "";
+    FILE *fp = fopen(path, "r");
+    assert_true(fp != NULL);
+    size_t n = fread(buf, 1, sizeof(buf) - 1, fp);
+    fclose(fp);
+    buf[n] = '\0';
+    assert_string_equal(buf, contents);
+}
+
+static void tests_setup(void)
+{
+    static char env[] = /* Needs to be static for putenv() */
+        "CFENGINE_TEST_OVERRIDE_WORKDIR=/tmp/download_cache_test.XXXXXX";
+
+    char *workdir = strchr(env, '=') + 1; /* start of the path */
+    assert(workdir - 1 && workdir[0] == '/');
+
+    mkdtemp(workdir);
+    strlcpy(CFWORKDIR, workdir, CF_BUFSIZE);
+    putenv(env);
+    mkdir(GetStateDir(), (S_IRWXU | S_IRWXG | S_IRWXO));
+
+    xsnprintf(SRC_FILE, sizeof(SRC_FILE), "%s/downloaded", CFWORKDIR);
+    xsnprintf(DST_FILE, sizeof(DST_FILE), "%s/destination", CFWORKDIR);
+}
+
+static void tests_teardown(void)
+{
+    char cmd[CF_BUFSIZE];
+    xsnprintf(cmd, CF_BUFSIZE, "rm -rf '%s'", CFWORKDIR);
+    system(cmd);
+}
+
+static void test_fetch_uninitialised(void)
+{
+    struct stat sb = { .st_size = 42, .st_mtime = 1000 };
+    assert_false(DownloadCache_Fetch("hub", "5308", "/src", &sb, DST_FILE));
+}
+
+static void test_store_and_fetch(void)
+{
+    struct stat sb = { .st_size = sizeof(CONTENTS) - 1, .st_mtime = 1000 };
+
+    DownloadCache_Init();
+
+    assert_false(DownloadCache_Fetch("hub", "5308", "/src", &sb, DST_FILE));
+
+    WriteTestFile(SRC_FILE, CONTENTS);
+    DownloadCache_Store("hub", "5308", "/src", &sb, SRC_FILE);
+    unlink(SRC_FILE);
+
+    assert_true(DownloadCache_Fetch("hub", "5308", "/src", &sb, DST_FILE));
+    AssertFileContents(DST_FILE, CONTENTS);
+    unlink(DST_FILE);
+
+    /* Changing any part of the key is a miss. */
+    assert_false(DownloadCache_Fetch("hub2", "5308", "/src", &sb, DST_FILE));
+    assert_false(DownloadCache_Fetch("hub", "5309", "/src", &sb, DST_FILE));
+    assert_false(DownloadCache_Fetch("hub", "5308", "/src2", &sb, DST_FILE));
+
+    struct stat sb_newer = sb;
+    sb_newer.st_mtime++;
+    assert_false(DownloadCache_Fetch("hub", "5308", "/src", &sb_newer,
+                                     DST_FILE));
+
+    DownloadCache_Destroy();
+}
+
+static void test_identical_contents_share_spool(void)
+{
+    struct stat sb = { .st_size = sizeof(CONTENTS) - 1, .st_mtime = 1000 };
+
+    DownloadCache_Init();
+
+    WriteTestFile(SRC_FILE, CONTENTS);
+    DownloadCache_Store("hub", "5308", "/a", &sb, SRC_FILE);
+    DownloadCache_Store("hub", "5308", "/b", &sb, SRC_FILE);
+    unlink(SRC_FILE);
+
+    char spool[CF_BUFSIZE];
+    xsnprintf(spool, sizeof(spool), "%s/download_spool.%ju",
+              GetStateDir(), (uintmax_t) getpid());
+
+    DIR *dir = opendir(spool);
+    assert_true(dir != NULL);
+    int count = 0;
+    const struct dirent *dirp;
+    while ((dirp = readdir(dir)) != NULL)
+    {
+        if (dirp->d_name[0] != '.')
+        {
+            count++;
+        }
+    }
+    closedir(dir);
+    assert_int_equal(count, 1);
+
+    assert_true(DownloadCache_Fetch("hub", "5308", "/b", &sb, DST_FILE));
+    AssertFileContents(DST_FILE, CONTENTS);
+    unlink(DST_FILE);
+
+    DownloadCache_Destroy();
+
+    /* The spool is removed at the end of the run. */
+    struct stat spool_sb;
+    assert_int_equal(stat(spool, &spool_sb), -1);
+
+    assert_false(DownloadCache_Fetch("hub", "5308", "/b", &sb, DST_FILE));
+}
+
+static void test_stale_spools_removed(void)
+{
+    /* Spools of processes that are gone, as left by a crashed run. Fork a
+     * child that exits right away to get the PID of one. */
+    pid_t gone = fork();
+    assert_int_not_equal(gone, -1);
+    if (gone == 0)
+    {
+        _exit(0);
+    }
+    assert_int_equal(waitpid(gone, NULL, 0), gone);
+
+    char stale[CF_BUFSIZE];
+    xsnprintf(stale, sizeof(stale), "%s/download_spool.%ju",
+              GetStateDir(), (uintmax_t) gone);
+    assert_int_equal(mkdir(stale, 0700), 0);
+    char stale_file[CF_BUFSIZE];
+    xsnprintf(stale_file, sizeof(stale_file), "%s/digest", stale);
+    WriteTestFile(stale_file, CONTENTS);
+
+    /* The spool of a running process, and unrelated entries. */
+    char running[CF_BUFSIZE];
+    xsnprintf(running, sizeof(running), "%s/download_spool.%ju",
+              GetStateDir(), (uintmax_t) getppid());
+    assert_int_equal(mkdir(running, 0700), 0);
+    char other[CF_BUFSIZE];
+    xsnprintf(other, sizeof(other), "%s/download_spool.x", GetStateDir());
+    assert_int_equal(mkdir(other, 0700), 0);
+
+    DownloadCache_Init();
+
+    struct stat sb;
+    assert_int_equal(stat(stale, &sb), -1);
+    assert_int_equal(stat(running, &sb), 0);
+    assert_int_equal(stat(other, &sb), 0);
+
+    DownloadCache_Destroy();
+
+    rmdir(running);
+    rmdir(other);
+}
+
+int main()
+{
+    tests_setup();
+
+    const UnitTest tests[] =
+        {
+            unit_test(test_fetch_uninitialised),
+            unit_test(test_store_and_fetch),
+            unit_test(test_identical_contents_share_spool),
+            unit_test(test_stale_spools_removed),
+        };
+
+    PRINT_TEST_BANNER();
+    int ret = run_tests(tests);
+
+    tests_teardown();
+    return ret;
+}
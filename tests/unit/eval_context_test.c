@@ -100,6 +100,121 @@ static void test_class_persistence(void)
     EvalContextDestroy(ctx);
 }
 
+static void test_defined_class_cache(void)
+{
+    EvalContext *ctx = EvalContextNew();
+
+    assert_false(IsDefinedClass(ctx, "a.b|c"));
+    assert_false(IsDefinedClass(ctx, "a b"));
+    assert_false(IsDefinedClass(ctx, "a.("));
+    assert_true(IsDefinedClass(ctx, "!a"));
+
+    EvalContextClassPutHard(ctx, "a", "");
+    assert_false(IsDefinedClass(ctx, "a.b|c"));
+    assert_false(IsDefinedClass(ctx, "!a"));
+
+    EvalContextClassPutSoft(ctx, "b", CONTEXT_SCOPE_NAMESPACE, "");
+    assert_true(IsDefinedClass(ctx, "a.b|c"));
+
+    EvalContextClassRemove(ctx, "default", "b");
+    assert_false(IsDefinedClass(ctx, "a.b|c"));
+
+    /* Bundle classes are only visible while the bundle is evaluated. */
+    Policy *p = PolicyNew();
+    Bundle *bp = PolicyAppendBundle(p, "default", "bundle1", "agent", NULL, NULL);
+
+    EvalContextStackPushBundleFrame(ctx, bp, NULL, false);
+    EvalContextClassPutSoft(ctx, "c", CONTEXT_SCOPE_BUNDLE, "");
+    assert_true(IsDefinedClass(ctx, "a.b|c"));
+    EvalContextStackPopFrame(ctx);
+
+    assert_false(IsDefinedClass(ctx, "a.b|c"));
+
+    /* Classes of another namespace need qualifying. */
+    Bundle *bp2 = PolicyAppendBundle(p, "ns1", "bundle2", "agent", NULL, NULL);
+    EvalContextClassPutSoft(ctx, "ns1:d", CONTEXT_SCOPE_NAMESPACE, "");
+    assert_false(IsDefinedClass(ctx, "d"));
+    EvalContextStackPushBundleFrame(ctx, bp2, NULL, false);
+    assert_true(IsDefinedClass(ctx, "d"));
+    EvalContextStackPopFrame(ctx);
+    assert_false(IsDefinedClass(ctx, "d"));
+    assert_true(IsDefinedClass(ctx, "ns1:d"));
+
+    PolicyDestroy(p);
+    EvalContextDestroy(ctx);
+}
+
+static void test_promise_reads(void)
+{
+    EvalContext *ctx = EvalContextNew();
+    Policy *p = PolicyNew();
+    Bundle *bp = PolicyAppendBundle(p, "default", "bundle1", "agent", NULL, NULL);
+    EvalContextStackPushBundleFrame(ctx, bp, NULL, false);
+
+    VarRef *x = VarRefParseFromBundle("x", bp);
+    VarRef *y = VarRefParseFromBundle("y", bp);
+    EvalContextVariablePut(ctx, x, "1", CF_DATA_TYPE_STRING, "");
+
+    PromiseReads *reads = PromiseReadsNew();
+    EvalContextPushPromiseReads(ctx, reads);
+    assert_true(EvalContextVariableGet(ctx, x, NULL) != NULL);
+    assert_true(EvalContextVariableGet(ctx, y, NULL) == NULL);
+    assert_false(IsDefinedClass(ctx, "a"));
+    EvalContextPopPromiseReads(ctx);
+    assert_false(EvalContextPromiseReadsChanged(ctx, reads));
+
+    /* Neither the same value again, nor what wasn't read, are changes. */
+    EvalContextVariablePut(ctx, x, "1", CF_DATA_TYPE_STRING, "");
+    EvalContextClassPutHard(ctx, "b", "");
+    assert_false(EvalContextPromiseReadsChanged(ctx, reads));
+
+    EvalContextVariablePut(ctx, x, "2", CF_DATA_TYPE_STRING, "");
+    assert_true(EvalContextPromiseReadsChanged(ctx, reads));
+
+    /* Pushing again starts over. */
+    EvalContextPushPromiseReads(ctx, reads);
+    assert_true(EvalContextVariableGet(ctx, y, NULL) == NULL);
+    assert_false(IsDefinedClass(ctx, "a"));
+    EvalContextPopPromiseReads(ctx);
+    assert_false(EvalContextPromiseReadsChanged(ctx, reads));
+
+    EvalContextVariablePut(ctx, y, "1", CF_DATA_TYPE_STRING, "");
+    assert_true(EvalContextPromiseReadsChanged(ctx, reads));
+
+    EvalContextPushPromiseReads(ctx, reads);
+    assert_false(IsDefinedClass(ctx, "a"));
+    EvalContextPopPromiseReads(ctx);
+    EvalContextClassPutHard(ctx, "a", "");
+    assert_true(EvalContextPromiseReadsChanged(ctx, reads));
+
+    /* What a nested promise read counts for the enclosing one too. */
+    PromiseReads *nested = PromiseReadsNew();
+    EvalContextPushPromiseReads(ctx, reads);
+    EvalContextPushPromiseReads(ctx, nested);
+    assert_true(EvalContextVariableGet(ctx, x, NULL) != NULL);
+    EvalContextPopPromiseReads(ctx);
+    EvalContextPopPromiseReads(ctx);
+    assert_false(EvalContextPromiseReadsChanged(ctx, reads));
+
+    EvalContextVariablePut(ctx, x, "3", CF_DATA_TYPE_STRING, "");
+    assert_true(EvalContextPromiseReadsChanged(ctx, nested));
+    assert_true(EvalContextPromiseReadsChanged(ctx, reads));
+    PromiseReadsDestroy(nested);
+
+    /* Nothing tracks what e.g. a function read. */
+    EvalContextPushPromiseReads(ctx, reads);
+    EvalContextPromiseReadsExternalState(ctx);
+    EvalContextPopPromiseReads(ctx);
+    assert_true(EvalContextPromiseReadsChanged(ctx, reads));
+
+    PromiseReadsDestroy(reads);
+    VarRefDestroy(x);
+    VarRefDestroy(y);
+    EvalContextStackPopFrame(ctx);
+    PolicyDestroy(p);
+    EvalContextDestroy(ctx);
+}
+
 int main()
 {
     PRINT_TEST_BANNER();
@@ -108,6 +223,8 @@ int main()
     const UnitTest tests[] =
     {
         unit_test(test_class_persistence),
+        unit_test(test_defined_class_cache),
+        unit_test(test_promise_reads),
     };
 
     int ret = run_tests(tests);
@@ -357,6 +357,57 @@ static void test_expand_scalar_nested_inner_undefined(void **state)
     BufferDestroy(res);
 }
 
+static void test_expand_scalar_reused(void **state)
+{
+    EvalContext *ctx = *state;
+    {
+        VarRef *lval = VarRefParse("default:bundle.one");
+        EvalContextVariablePut(ctx, lval, "first", CF_DATA_TYPE_STRING, NULL);
+        VarRefDestroy(lval);
+    }
+    {
+        VarRef *lval = VarRefParse("default:other.one");
+        EvalContextVariablePut(ctx, lval, "other", CF_DATA_TYPE_STRING, NULL);
+        VarRefDestroy(lval);
+    }
+    {
+        VarRef *lval = VarRefParse("ns:bundle.one");
+        EvalContextVariablePut(ctx, lval, "namespaced", CF_DATA_TYPE_STRING, NULL);
+        VarRefDestroy(lval);
+    }
+
+    const char *const string = "$(one) $(other.one) ${default:bundle.one} $(/bin/cat x)";
+
+    Buffer *res = BufferNew();
+    ExpandScalar(ctx, "default", "bundle", string, res);
+    assert_string_equal("first other first $(/bin/cat x)", BufferData(res));
+
+    /* The same string in another scope and namespace. */
+    BufferClear(res);
+    ExpandScalar(ctx, "default", "other", string, res);
+    assert_string_equal("other other first $(/bin/cat x)", BufferData(res));
+
+    BufferClear(res);
+    ExpandScalar(ctx, "ns", "bundle", string, res);
+    assert_string_equal("namespaced $(other.one) first $(/bin/cat x)", BufferData(res));
+
+    /* New value, same string. */
+    {
+        VarRef *lval = VarRefParse("default:bundle.one");
+        EvalContextVariablePut(ctx, lval, "changed", CF_DATA_TYPE_STRING, NULL);
+        VarRefDestroy(lval);
+    }
+    BufferClear(res);
+    ExpandScalar(ctx, "default", "bundle", string, res);
+    assert_string_equal("changed other changed $(/bin/cat x)", BufferData(res));
+
+    BufferClear(res);
+    ExpandScalar(ctx, "default", "bundle", "no variables $", res);
+    assert_string_equal("no variables $", BufferData(res));
+
+    BufferDestroy(res);
+}
+
 static void test_expand_list_nested(void **state)
 {
     EvalContext *ctx = *state;
@@ -546,6 +597,77 @@ static void test_expand_promise_array_with_slist_arg(void **state)
     PolicyDestroy(policy);
 }
 
+static PromiseResult actuator_expand_promise_constraints_per_iteration(
+    ARG_UNUSED EvalContext *ctx, const Promise *pp, ARG_UNUSED void *param)
+{
+    static const char *const expected[][3] =
+    {
+        { "a1", "a", "1" }, { "a2", "a", "2" },
+        { "b1", "b", "1" }, { "b2", "b", "2" },
+    };
+
+    assert_true(actuator_state < 4);
+    assert_string_equal(expected[actuator_state][0], pp->promiser);
+    assert_string_equal(expected[actuator_state][1],
+                        PromiseGetConstraintAsRval(pp, "outer", RVAL_TYPE_SCALAR));
+    assert_string_equal(expected[actuator_state][2],
+                        PromiseGetConstraintAsRval(pp, "inner", RVAL_TYPE_SCALAR));
+    assert_string_equal("fixed",
+                        PromiseGetConstraintAsRval(pp, "constant", RVAL_TYPE_SCALAR));
+
+    /* Actuators may rewrite the expanded constraints, that must not leak
+     * into the next iteration. */
+    Constraint *cp = PromiseGetConstraint(pp, "constant");
+    RvalDestroy(cp->rval);
+    cp->rval = RvalNew("clobbered", RVAL_TYPE_SCALAR);
+
+    actuator_state++;
+    return PROMISE_RESULT_NOOP;
+}
+
+static void test_expand_promise_constraints_per_iteration(void **state)
+{
+    actuator_state = 0;
+
+    EvalContext *ctx = *state;
+    {
+        VarRef *lval = VarRefParse("default:bundle.x");
+        Rlist *list = NULL;
+        RlistAppendScalar(&list, "a");
+        RlistAppendScalar(&list, "b");
+        EvalContextVariablePut(ctx, lval, list, CF_DATA_TYPE_STRING_LIST, NULL);
+        RlistDestroy(list);
+        VarRefDestroy(lval);
+    }
+    {
+        VarRef *lval = VarRefParse("default:bundle.y");
+        Rlist *list = NULL;
+        RlistAppendScalar(&list, "1");
+        RlistAppendScalar(&list, "2");
+        EvalContextVariablePut(ctx, lval, list, CF_DATA_TYPE_STRING_LIST, NULL);
+        RlistDestroy(list);
+        VarRefDestroy(lval);
+    }
+
+    Policy *policy = PolicyNew();
+    Bundle *bundle = PolicyAppendBundle(policy, NamespaceDefault(), "bundle", "agent", NULL, NULL);
+    PromiseType *promise_type = BundleAppendPromiseType(bundle, "dummy");
+    Promise *promise = PromiseTypeAppendPromise(promise_type, "$(x)$(y)", (Rval) { NULL, RVAL_TYPE_NOPROMISEE }, "any", NULL);
+    PromiseAppendConstraint(promise, "outer", RvalNew("$(x)", RVAL_TYPE_SCALAR), false);
+    PromiseAppendConstraint(promise, "inner", RvalNew("$(y)", RVAL_TYPE_SCALAR), false);
+    PromiseAppendConstraint(promise, "constant", RvalNew("fixed", RVAL_TYPE_SCALAR), false);
+
+    EvalContextStackPushBundleFrame(ctx, bundle, NULL, false);
+    EvalContextStackPushPromiseTypeFrame(ctx, promise_type);
+    ExpandPromise(ctx, promise, actuator_expand_promise_constraints_per_iteration, NULL);
+    EvalContextStackPopFrame(ctx);
+    EvalContextStackPopFrame(ctx);
+
+    assert_int_equal(4, actuator_state);
+
+    PolicyDestroy(policy);
+}
+
 static void test_setup(void **state)
 {
     *state = EvalContextNew();
@@ -576,10 +698,12 @@ int main()
         unit_test_setup_teardown(test_expand_scalar_array_with_scalar_arg, test_setup, test_teardown),
         unit_test_setup_teardown(test_expand_scalar_undefined, test_setup, test_teardown),
         unit_test_setup_teardown(test_expand_scalar_nested_inner_undefined, test_setup, test_teardown),
+        unit_test_setup_teardown(test_expand_scalar_reused, test_setup, test_teardown),
         unit_test_setup_teardown(test_expand_list_nested, test_setup, test_teardown),
         unit_test_setup_teardown(test_expand_promise_array_with_scalar_arg, test_setup, test_teardown),
         unit_test_setup_teardown(test_expand_promise_slist, test_setup, test_teardown),
-        unit_test_setup_teardown(test_expand_promise_array_with_slist_arg, test_setup, test_teardown)
+        unit_test_setup_teardown(test_expand_promise_array_with_slist_arg, test_setup, test_teardown),
+        unit_test_setup_teardown(test_expand_promise_constraints_per_iteration, test_setup, test_teardown)
     };
 
     return run_tests(tests);
@@ -0,0 +1,234 @@
+/*
+   Copyright 2018 Northern.tech AS
+
+   This file is part of CFEngine 3 - written and maintained by Northern.tech AS.
+
+   This program is free software; you can redistribute it and/or modify it
+   under the terms of the GNU General Public License as published by the
+   Free Software Foundation; version 3.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA
+
+  To the extent this program is licensed as part of the Enterprise
+  versions of CFEngine, the applicable Commercial Open Source License
+  (COSL) may apply to this file if you as a licensee so wish it. See
+  included file COSL.txt.
+*/
+
+#include <test.h>
+
+#include <cf3.defs.h>
+#include <function_cache.h>
+#include <known_dirs.h>
+#include <rlist.h>
+#include <json.h>
+#include <misc_lib.h>                                          /* xsnprintf */
+
+
+char CFWORKDIR[CF_BUFSIZE];
+static char INPUT_FILE[CF_BUFSIZE];
+
+static void WriteInput(const char *content)
+{
+    FILE *f = fopen(INPUT_FILE, "w");
+    assert_true(f != NULL);
+    fputs(content, f);
+    fclose(f);
+}
+
+static Rlist *Args(const char *first, const char *second)
+{
+    Rlist *args = NULL;
+    RlistAppendScalar(&args, first);
+    RlistAppendScalar(&args, second);
+    return args;
+}
+
+static void test_supported(void)
+{
+    assert_true(FunctionCacheSupported("readjson"));
+    assert_true(FunctionCacheSupported("execresult"));
+    /* Defines array variables as a side effect. */
+    assert_false(FunctionCacheSupported("readstringarray"));
+    assert_false(FunctionCacheSupported("now"));
+
+    assert_true(FunctionCacheFingerprint("now", NULL) == NULL);
+
+    /* Relative paths depend on the working directory. */
+    Rlist *args = Args("relative/file", "1024");
+    assert_true(FunctionCacheFingerprint("readfile", args) == NULL);
+    RlistDestroy(args);
+}
+
+static void test_file_input(void)
+{
+    WriteInput("first");
+    Rlist *args = Args(INPUT_FILE, "1024");
+    Rval rval;
+
+    JsonElement *fingerprint = FunctionCacheFingerprint("readfile", args);
+    assert_true(fingerprint != NULL);
+    assert_false(FunctionCacheGet("readfile", args, fingerprint, 0, &rval));
+    FunctionCachePut("readfile", args, fingerprint,
+                     (Rval) { "first", RVAL_TYPE_SCALAR });
+
+    /* The TTL does not apply to file inputs. */
+    fingerprint = FunctionCacheFingerprint("readfile", args);
+    assert_true(FunctionCacheGet("readfile", args, fingerprint, 0, &rval));
+    assert_int_equal(rval.type, RVAL_TYPE_SCALAR);
+    assert_string_equal(RvalScalarValue(rval), "first");
+    RvalDestroy(rval);
+    JsonDestroy(fingerprint);
+
+    /* Other arguments are another call. */
+    Rlist *other = Args(INPUT_FILE, "2");
+    fingerprint = FunctionCacheFingerprint("readfile", other);
+    assert_false(FunctionCacheGet("readfile", other, fingerprint, 0, &rval));
+    JsonDestroy(fingerprint);
+    RlistDestroy(other);
+
+    /* A changed file is a miss. */
+    WriteInput("second, longer");
+    fingerprint = FunctionCacheFingerprint("readfile", args);
+    assert_false(FunctionCacheGet("readfile", args, fingerprint, 0, &rval));
+
+#if defined(HAVE_STRUCT_STAT_ST_MTIM)
+    /* And one rewritten with the same size within the same second. */
+    FunctionCachePut("readfile", args, fingerprint,
+                     (Rval) { "second, longer", RVAL_TYPE_SCALAR });
+    fingerprint = FunctionCacheFingerprint("readfile", args);
+
+    struct stat sb;
+    assert_int_equal(stat(INPUT_FILE, &sb), 0);
+    struct timespec times[2] = {
+        sb.st_atim,
+        { sb.st_mtime, (sb.st_mtim.tv_nsec + 500000000) % 1000000000 }
+    };
+    assert_int_equal(utimensat(AT_FDCWD, INPUT_FILE, times, 0), 0);
+    assert_int_equal(stat(INPUT_FILE, &sb), 0);
+    if (sb.st_mtim.tv_nsec == times[1].tv_nsec)  /* fine-grained timestamps */
+    {
+        JsonElement *touched = FunctionCacheFingerprint("readfile", args);
+        assert_false(FunctionCacheGet("readfile", args, touched, 0, &rval));
+        JsonDestroy(touched);
+    }
+#endif
+    JsonDestroy(fingerprint);
+
+    /* So is a removed one. */
+    unlink(INPUT_FILE);
+    fingerprint = FunctionCacheFingerprint("readfile", args);
+    assert_true(fingerprint != NULL);
+    assert_false(FunctionCacheGet("readfile", args, fingerprint, 0, &rval));
+    JsonDestroy(fingerprint);
+
+    RlistDestroy(args);
+}
+
+static void test_result_types(void)
+{
+    WriteInput("a\nb\n");
+    Rlist *args = Args(INPUT_FILE, "");
+    Rval rval;
+
+    Rlist *list = NULL;
+    RlistAppendScalar(&list, "a");
+    RlistAppendScalar(&list, "b");
+    FunctionCachePut("readstringlist", args,
+                     FunctionCacheFingerprint("readstringlist", args),
+                     (Rval) { list, RVAL_TYPE_LIST });
+    RlistDestroy(list);
+
+    JsonElement *fingerprint = FunctionCacheFingerprint("readstringlist", args);
+    assert_true(FunctionCacheGet("readstringlist", args, fingerprint, 0, &rval));
+    JsonDestroy(fingerprint);
+    assert_int_equal(rval.type, RVAL_TYPE_LIST);
+    assert_int_equal(RlistLen(RvalRlistValue(rval)), 2);
+    assert_string_equal(RlistScalarValue(RvalRlistValue(rval)->next), "b");
+    RvalDestroy(rval);
+
+    JsonElement *data = JsonObjectCreate(1);
+    JsonObjectAppendString(data, "key", "value");
+    FunctionCachePut("readjson", args,
+                     FunctionCacheFingerprint("readjson", args),
+                     (Rval) { data, RVAL_TYPE_CONTAINER });
+
+    fingerprint = FunctionCacheFingerprint("readjson", args);
+    assert_true(FunctionCacheGet("readjson", args, fingerprint, 0, &rval));
+    JsonDestroy(fingerprint);
+    assert_int_equal(rval.type, RVAL_TYPE_CONTAINER);
+    assert_int_equal(JsonLength(RvalContainerValue(rval)), 1);
+    assert_string_equal(JsonObjectGetAsString(RvalContainerValue(rval), "key"), "value");
+    RvalDestroy(rval);
+    JsonDestroy(data);
+
+    RlistDestroy(args);
+}
+
+static void test_ttl(void)
+{
+    Rlist *args = Args("/bin/echo hello", "noshell");
+    Rval rval;
+
+    JsonElement *fingerprint = FunctionCacheFingerprint("execresult", args);
+    assert_true(fingerprint != NULL);
+    FunctionCachePut("execresult", args, fingerprint,
+                     (Rval) { "hello", RVAL_TYPE_SCALAR });
+
+    fingerprint = FunctionCacheFingerprint("execresult", args);
+    assert_true(FunctionCacheGet("execresult", args, fingerprint, 60, &rval));
+    assert_string_equal(RvalScalarValue(rval), "hello");
+    RvalDestroy(rval);
+
+    sleep(2);
+    assert_false(FunctionCacheGet("execresult", args, fingerprint, 1, &rval));
+    JsonDestroy(fingerprint);
+
+    RlistDestroy(args);
+}
+
+static void tests_setup(void)
+{
+    static char env[] = /* Needs to be static for putenv() */
+        "CFENGINE_TEST_OVERRIDE_WORKDIR=/tmp/function_cache_test.XXXXXX";
+
+    char *workdir = strchr(env, '=') + 1; /* start of the path */
+    assert_true(mkdtemp(workdir) != NULL);
+    strlcpy(CFWORKDIR, workdir, CF_BUFSIZE);
+    putenv(env);
+    mkdir(GetStateDir(), 0700);
+    xsnprintf(INPUT_FILE, sizeof(INPUT_FILE), "%s/input", CFWORKDIR);
+}
+
+static void tests_teardown(void)
+{
+    char cmd[CF_BUFSIZE];
+    xsnprintf(cmd, CF_BUFSIZE, "rm -rf '%s'", CFWORKDIR);
+    system(cmd);
+}
+
+int main()
+{
+    PRINT_TEST_BANNER();
+    tests_setup();
+
+    const UnitTest tests[] =
+    {
+        unit_test(test_supported),
+        unit_test(test_file_input),
+        unit_test(test_result_types),
+        unit_test(test_ttl),
+    };
+
+    int ret = run_tests(tests);
+
+    tests_teardown();
+    return ret;
+}
@@ -78,6 +78,74 @@ void test_dont_have_tty_interactive_failsafe_is_created(void)
 
 }
 
+/* A common bundle defining a class, and the given bundlesequence. */
+#define TEST_POLICY_JSON \
+    "{\"bundles\": [{\"namespace\": \"default\", \"name\": \"defs\"," \
+    " \"bundleType\": \"common\", \"sourcePath\": \"test.cf\", \"arguments\": []," \
+    " \"promiseTypes\": [{\"name\": \"classes\", \"contexts\": [{\"name\": \"any\"," \
+    " \"promises\": [{\"promiser\": \"policy_class\", \"attributes\": [{\"lval\":" \
+    " \"expression\", \"rval\": {\"type\": \"string\", \"value\": \"any\"}}]}]}]}]}]," \
+    " \"bodies\": [{\"namespace\": \"default\", \"name\": \"control\"," \
+    " \"bodyType\": \"common\", \"sourcePath\": \"test.cf\", \"arguments\": []," \
+    " \"contexts\": [{\"name\": \"any\", \"attributes\": [{\"lval\": \"bundlesequence\"," \
+    " \"rval\": {\"type\": \"list\", \"value\": [{\"type\": \"string\"," \
+    " \"value\": \"%s\"}]}}]}]}]}"
+
+static char *WriteTestPolicy(const char *bundle)
+{
+    char *path = StringFormat("%s/test_%s.json", TEMPDIR, bundle);
+    FILE *fp = fopen(path, "w");
+    assert_true(fp != NULL);
+    fprintf(fp, TEST_POLICY_JSON, bundle);
+    assert_int_equal(fclose(fp), 0);
+    return path;
+}
+
+void test_valid_policy_is_validated_in_process(void)
+{
+    CryptoInitialize();
+
+    EvalContext *ctx = EvalContextNew();
+    GenericAgentConfig *config =
+        GenericAgentConfigNewDefault(AGENT_TYPE_AGENT, false);
+
+    /* Outside of the inputs directory, so it needs validation. */
+    char *path = WriteTestPolicy("defs");
+    GenericAgentConfigSetInputFile(config, NULL, path);
+
+    Policy *policy = SelectAndLoadPolicy(config, ctx, true, false);
+    assert_true(policy != NULL);
+    assert_true(PolicyGetBundle(policy, NULL, "common", "defs") != NULL);
+    assert_true(EvalContextClassGet(ctx, NULL, "policy_class") != NULL);
+    assert_true(EvalContextClassGet(ctx, NULL, "failsafe_fallback") == NULL);
+
+    free(path);
+    PolicyDestroy(policy);
+    GenericAgentFinalize(ctx, config);
+}
+
+void test_invalid_policy_is_rejected(void)
+{
+    CryptoInitialize();
+
+    EvalContext *ctx = EvalContextNew();
+    GenericAgentConfig *config =
+        GenericAgentConfigNewDefault(AGENT_TYPE_AGENT, true);
+
+    char *path = WriteTestPolicy("missing");
+    GenericAgentConfigSetInputFile(config, NULL, path);
+    EvalContextClassPutHard(ctx, "discovered_class", "source=agent");
+
+    /* Rejected without exiting, nor keeping what it defined. */
+    Policy *policy = SelectAndLoadPolicy(config, ctx, true, false);
+    assert_true(policy == NULL);
+    assert_true(EvalContextClassGet(ctx, NULL, "policy_class") == NULL);
+    assert_true(EvalContextClassGet(ctx, NULL, "discovered_class") != NULL);
+
+    free(path);
+    GenericAgentFinalize(ctx, config);
+}
+
 void test_resolve_absolute_input_path(void)
 {
     assert_string_equal("/abs/aux.cf", GenericAgentResolveInputPath(NULL, "/abs/aux.cf"));
@@ -145,6 +213,8 @@ int main()
         unit_test(test_resolve_relative_base_path),
         unit_test(test_have_tty_interactive_failsafe_is_not_created),
         unit_test(test_dont_have_tty_interactive_failsafe_is_created),
+        unit_test(test_valid_policy_is_validated_in_process),
+        unit_test(test_invalid_policy_is_rejected),
     };
 
     int ret = run_tests(tests);
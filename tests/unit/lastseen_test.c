@@ -212,6 +212,104 @@ static void test_remove_ip(void)
     CloseDB(db);
 }
 
+#ifdef LMDB
+static void test_time_index(void)
+{
+    setup();
+
+    UpdateLastSawHost("SHA-12345", "127.0.0.64", true, 0x22b);
+    UpdateLastSawHost("SHA-12345", "127.0.0.64", false, 0x22c);
+
+    DBHandle *db;
+    OpenDB(&db, dbid_lastseen);
+    assert_int_equal(DBHasStr(db, "t000000000000022biSHA-12345"), true);
+    assert_int_equal(DBHasStr(db, "t000000000000022coSHA-12345"), true);
+    CloseDB(db);
+
+    /* The old time entry is replaced. */
+    UpdateLastSawHost("SHA-12345", "127.0.0.64", true, 0x456);
+
+    OpenDB(&db, dbid_lastseen);
+    assert_int_equal(DBHasStr(db, "t000000000000022biSHA-12345"), false);
+    assert_int_equal(DBHasStr(db, "t0000000000000456iSHA-12345"), true);
+    CloseDB(db);
+
+    DeleteDigestFromLastSeen("SHA-12345", NULL, 0);
+
+    OpenDB(&db, dbid_lastseen);
+    assert_int_equal(DBHasStr(db, "t0000000000000456iSHA-12345"), false);
+    assert_int_equal(DBHasStr(db, "t000000000000022coSHA-12345"), false);
+    CloseDB(db);
+
+    /* cf-key removes entries from an open database. */
+    UpdateLastSawHost("SHA-12345", "127.0.0.64", true, 0x789);
+
+    OpenDB(&db, dbid_lastseen);
+    DeleteLastSeenQualityEntries(db, "SHA-12345");
+    assert_int_equal(DBHasStr(db, "qiSHA-12345"), false);
+    assert_int_equal(DBHasStr(db, "t0000000000000789iSHA-12345"), false);
+    CloseDB(db);
+}
+#endif
+
+static bool CollectSeenCallback(const char *hostkey, const char *address,
+                                bool incoming, const KeyHostSeen *quality,
+                                void *ctx)
+{
+    Item **seen = ctx;
+
+    char entry[CF_BUFSIZE];
+    xsnprintf(entry, sizeof(entry), "%s %s %c %jd", hostkey, address,
+              incoming ? 'i' : 'o', (intmax_t) quality->lastseen);
+    PrependItem(seen, entry, NULL);
+    return true;
+}
+
+static void test_scan_since(void)
+{
+    setup();
+
+    UpdateLastSawHost(KEY1, IP1, true, 100);
+    UpdateLastSawHost(KEY2, IP2, true, 200);
+    UpdateLastSawHost(KEY2, IP2, false, 250);
+    UpdateLastSawHost(KEY3, IP3, false, 300);
+
+    Item *seen = NULL;
+    assert_int_equal(ScanLastSeenQualitySince(200, CollectSeenCallback, &seen),
+                     true);
+    assert_int_equal(ListLen(seen), 3);
+    assert_int_equal(IsItemIn(seen, KEY2" "IP2" i 200"), true);
+    assert_int_equal(IsItemIn(seen, KEY2" "IP2" o 250"), true);
+    assert_int_equal(IsItemIn(seen, KEY3" "IP3" o 300"), true);
+    DeleteItemList(seen);
+
+    /* Database from an older version, without time entries. */
+    DBHandle *db;
+    OpenDB(&db, dbid_lastseen);
+    DeleteDB(db, "t0000000000000064i"KEY1);
+    DeleteDB(db, "t00000000000000c8i"KEY2);
+    DeleteDB(db, "t00000000000000fao"KEY2);
+    DeleteDB(db, "t000000000000012co"KEY3);
+    DeleteDB(db, "timeindex");
+    CloseDB(db);
+
+    seen = NULL;
+    assert_int_equal(ScanLastSeenQualitySince(250, CollectSeenCallback, &seen),
+                     true);
+    assert_int_equal(ListLen(seen), 2);
+    assert_int_equal(IsItemIn(seen, KEY2" "IP2" o 250"), true);
+    assert_int_equal(IsItemIn(seen, KEY3" "IP3" o 300"), true);
+    DeleteItemList(seen);
+
+    seen = NULL;
+    assert_int_equal(ScanLastSeenQualitySince(0, CollectSeenCallback, &seen),
+                     true);
+    assert_int_equal(ListLen(seen), 4);
+    DeleteItemList(seen);
+
+    assert_int_equal(IsLastSeenCoherent(), true);
+}
+
 
 /* These tests can't be multi-threaded anyway. */
 static DBHandle *DBH;
@@ -589,6 +687,10 @@ int main()
             unit_test(test_reverse_missing_forward),
             unit_test(test_remove),
             unit_test(test_remove_ip),
+#ifdef LMDB
+            unit_test(test_time_index),
+#endif
+            unit_test(test_scan_since),
 
             unit_test_setup_teardown(test_consistent_1a, begin, end),
             unit_test_setup_teardown(test_consistent_1b, begin, end),
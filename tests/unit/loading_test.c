@@ -0,0 +1,182 @@
+/*
+   Copyright 2018 Northern.tech AS
+
+   This file is part of CFEngine 3 - written and maintained by Northern.tech AS.
+
+   This program is free software; you can redistribute it and/or modify it
+   under the terms of the GNU General Public License as published by the
+   Free Software Foundation; version 3.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA
+
+  To the extent this program is licensed as part of the Enterprise
+  versions of CFEngine, the applicable Commercial Open Source License
+  (COSL) may apply to this file if you as a licensee so wish it. See
+  included file COSL.txt.
+*/
+
+
+#include <test.h>
+
+#include <loading.h>
+#include <generic_agent.h>
+#include <eval_context.h>
+#include <string_lib.h>
+#include <misc_lib.h>                                          /* xsnprintf */
+
+
+#define INPUTS_COUNT 10
+
+char TEMPDIR[] = "/tmp/loading_test_XXXXXX";
+
+#define BUNDLE_JSON \
+    "{\"namespace\": \"default\", \"name\": \"%s\", \"bundleType\": \"common\"," \
+    " \"sourcePath\": \"%s\", \"arguments\": [], \"promiseTypes\": []}"
+
+static void WriteFile(const char *path, const char *contents)
+{
+    FILE *fp = fopen(path, "w");
+    assert_true(fp != NULL);
+    fputs(contents, fp);
+    assert_int_equal(fclose(fp), 0);
+}
+
+/* Writes the main policy file, with inputs in_0.json, in_1.json, ... */
+static char *WriteMainPolicy(void)
+{
+    Writer *w = StringWriter();
+    WriterWriteF(w, "{\"bundles\": [" BUNDLE_JSON "], \"bodies\": [", "main", "main.json");
+    WriterWrite(w, "{\"namespace\": \"default\", \"name\": \"control\","
+                " \"bodyType\": \"common\", \"sourcePath\": \"main.json\", \"arguments\": [],"
+                " \"contexts\": [{\"name\": \"any\", \"attributes\": ["
+                "{\"lval\": \"bundlesequence\", \"rval\": {\"type\": \"list\","
+                " \"value\": [{\"type\": \"string\", \"value\": \"main\"}]}},"
+                "{\"lval\": \"inputs\", \"rval\": {\"type\": \"list\", \"value\": [");
+    for (int i = 0; i < INPUTS_COUNT; i++)
+    {
+        WriterWriteF(w, "%s{\"type\": \"string\", \"value\": \"in_%d.json\"}",
+                     (i == 0) ? "" : ", ", i);
+    }
+    WriterWrite(w, "]}}]}]}]}");
+
+    char *path = StringFormat("%s/main.json", TEMPDIR);
+    WriteFile(path, StringWriterData(w));
+    WriterClose(w);
+    return path;
+}
+
+static void WriteInputPolicy(int i, const char *source_path)
+{
+    char path[CF_BUFSIZE];
+    xsnprintf(path, sizeof(path), "%s/in_%d.json", TEMPDIR, i);
+
+    char name[32];
+    xsnprintf(name, sizeof(name), "b_%d", i);
+
+    char *contents = StringFormat("{\"bundles\": [" BUNDLE_JSON "], \"bodies\": []}",
+                                  name, (source_path != NULL) ? source_path : path);
+    WriteFile(path, contents);
+    free(contents);
+}
+
+static void test_inputs_are_merged_in_order(void)
+{
+    for (int i = 0; i < INPUTS_COUNT; i++)
+    {
+        /* One of them can't be parsed in parallel, and is parsed in place. */
+        WriteInputPolicy(i, (i == 3) ? "elsewhere.cf" : NULL);
+    }
+    char *path = WriteMainPolicy();
+
+    EvalContext *ctx = EvalContextNew();
+    GenericAgentConfig *config = GenericAgentConfigNewDefault(AGENT_TYPE_COMMON, false);
+    GenericAgentConfigSetInputFile(config, NULL, path);
+
+    Policy *policy = LoadPolicyIfValid(ctx, config);
+    assert_true(policy != NULL);
+    assert_int_equal(SeqLength(policy->bundles), INPUTS_COUNT + 1);
+    assert_string_equal(((Bundle *) SeqAt(policy->bundles, 0))->name, "main");
+
+    for (int i = 0; i < INPUTS_COUNT; i++)
+    {
+        const Bundle *bp = SeqAt(policy->bundles, i + 1);
+        char name[32];
+        xsnprintf(name, sizeof(name), "b_%d", i);
+        assert_string_equal(bp->name, name);
+
+        if (i == 3)
+        {
+            assert_string_equal(bp->source_path, "elsewhere.cf");
+        }
+        else
+        {
+            char input[CF_BUFSIZE];
+            xsnprintf(input, sizeof(input), "%s/in_%d.json", TEMPDIR, i);
+            assert_string_equal(bp->source_path, input);
+        }
+    }
+
+    free(path);
+    PolicyDestroy(policy);
+    GenericAgentConfigDestroy(config);
+    EvalContextDestroy(ctx);
+}
+
+static void test_missing_input_is_rejected(void)
+{
+    for (int i = 0; i < INPUTS_COUNT; i++)
+    {
+        WriteInputPolicy(i, NULL);
+    }
+    char *path = WriteMainPolicy();
+
+    char missing[CF_BUFSIZE];
+    xsnprintf(missing, sizeof(missing), "%s/in_%d.json", TEMPDIR, INPUTS_COUNT / 2);
+    assert_int_equal(unlink(missing), 0);
+
+    EvalContext *ctx = EvalContextNew();
+    GenericAgentConfig *config = GenericAgentConfigNewDefault(AGENT_TYPE_COMMON, false);
+    GenericAgentConfigSetInputFile(config, NULL, path);
+
+    assert_true(LoadPolicyIfValid(ctx, config) == NULL);
+
+    free(path);
+    GenericAgentConfigDestroy(config);
+    EvalContextDestroy(ctx);
+}
+
+int main()
+{
+    if (mkdtemp(TEMPDIR) == NULL)
+    {
+        fprintf(stderr, "Could not create temporary directory\n");
+        return 1;
+    }
+
+    char *env_var = NULL;
+    xasprintf(&env_var, "CFENGINE_TEST_OVERRIDE_WORKDIR=%s", TEMPDIR);
+    // Will leak, but that's how crappy putenv() is.
+    putenv(env_var);
+
+    PRINT_TEST_BANNER();
+    const UnitTest tests[] =
+    {
+        unit_test(test_inputs_are_merged_in_order),
+        unit_test(test_missing_input_is_rejected),
+    };
+
+    int ret = run_tests(tests);
+
+    char cmd[CF_BUFSIZE];
+    xsnprintf(cmd, sizeof(cmd), "rm -rf '%s'", TEMPDIR);
+    ARG_UNUSED int ignore = system(cmd);
+
+    return ret;
+}
@@ -4,10 +4,190 @@
 #include <locks.h>
 #include <misc_lib.h>                                          /* xsnprintf */
 #include <known_dirs.h>
+#include <eval_context.h>
+#include <policy.h>
+#include <files_hashes.h>
+#include <sys/wait.h>
 
 
 char CFWORKDIR[CF_BUFSIZE];
 
+static Policy *TestPolicy(void)
+{
+    Policy *policy = PolicyNew();
+    Bundle *bundle = PolicyAppendBundle(policy, "default", "main", "agent",
+                                        NULL, "promises.cf");
+    PromiseType *tp = BundleAppendPromiseType(bundle, "files");
+    PromiseTypeAppendPromise(tp, "/etc/motd", (Rval) { NULL, RVAL_TYPE_NOPROMISEE },
+                             "any", NULL);
+    return policy;
+}
+
+static CfLock TestAcquireLockExpiring(const Promise *pp, int ifelapsed,
+                                      int expireafter)
+{
+    /* A new context each time, not to hit its promise lock cache. */
+    EvalContext *ctx = EvalContextNew();
+    TransactionContext tc = {
+        .ifelapsed = ifelapsed,
+        .expireafter = expireafter,
+    };
+    CfLock lock = AcquireLock(ctx, "/etc/motd", "localhost", time(NULL),
+                              tc, pp, false);
+    EvalContextDestroy(ctx);
+    return lock;
+}
+
+static CfLock TestAcquireLock(const Promise *pp, int ifelapsed)
+{
+    return TestAcquireLockExpiring(pp, ifelapsed, 60);
+}
+
+static void test_acquire_yield(void)
+{
+    Policy *policy = TestPolicy();
+    const Bundle *bundle = SeqAt(policy->bundles, 0);
+    const PromiseType *tp = SeqAt(bundle->promise_types, 0);
+    const Promise *pp = SeqAt(tp->promises, 0);
+
+    CfLock lock = TestAcquireLock(pp, 0);
+    assert_true(lock.lock != NULL);
+    assert_true(FindLockTime(lock.lock) > 0);
+    /* The critical section is not left behind. */
+    assert_true(FindLockTime("CF_CRITICAL_SECTION") == -1);
+
+    /* Already running. */
+    CfLock other = TestAcquireLock(pp, 0);
+    assert_true(other.lock == NULL);
+
+    char *lock_name = xstrdup(lock.lock);
+    char *last_name = xstrdup(lock.last);
+    YieldCurrentLock(lock);
+    assert_true(FindLockTime(lock_name) == -1);
+    assert_true(FindLockTime(last_name) > 0);
+
+    /* Done within ifelapsed. */
+    other = TestAcquireLock(pp, 10);
+    assert_true(other.lock == NULL);
+
+    other = TestAcquireLock(pp, 0);
+    assert_true(other.lock != NULL);
+    YieldCurrentLock(other);
+    assert_true(FindLockTime(lock_name) == -1);
+
+    free(lock_name);
+    free(last_name);
+    PolicyDestroy(policy);
+}
+
+static double Now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void *ProbeLocks(void *arg)
+{
+    /* While the holder of the expired lock is being terminated. */
+    usleep(300000);
+
+    double start = Now();
+    WaitForCriticalSection("probe");
+    ReleaseCriticalSection("probe");
+    *(double *) arg = Now() - start;
+
+    return NULL;
+}
+
+static void test_expired_lock_holder_killed(void)
+{
+    Policy *policy = TestPolicy();
+    const Bundle *bundle = SeqAt(policy->bundles, 0);
+    const PromiseType *tp = SeqAt(bundle->promise_types, 0);
+    const Promise *pp = SeqAt(tp->promises, 0);
+
+    int ready[2];
+    assert_int_equal(pipe(ready), 0);
+
+    pid_t holder = fork();
+    assert_true(holder != -1);
+    if (holder == 0)
+    {
+        /* Makes terminating it take a second. */
+        signal(SIGINT, SIG_IGN);
+        CfLock lock = TestAcquireLock(pp, 0);
+        char c = (lock.lock != NULL) ? 'y' : 'n';
+        if (write(ready[1], &c, 1) != 1)
+        {
+            _exit(1);
+        }
+        for (;;)
+        {
+            pause();
+        }
+    }
+
+    char c = '\0';
+    assert_int_equal(read(ready[0], &c, 1), 1);
+    assert_int_equal(c, 'y');
+
+    /* Expire it right away. */
+    double wait = -1;
+    pthread_t probe;
+    assert_int_equal(pthread_create(&probe, NULL, ProbeLocks, &wait), 0);
+    CfLock lock = TestAcquireLockExpiring(pp, 0, 0);
+    pthread_join(probe, NULL);
+
+    int status;
+    assert_int_equal(waitpid(holder, &status, 0), holder);
+    assert_true(WIFSIGNALED(status) && WTERMSIG(status) == SIGTERM);
+
+    assert_true(lock.lock != NULL);
+    /* The locks were not held while waiting for the holder to exit. */
+    assert_true(wait >= 0 && wait < 0.5);
+
+    YieldCurrentLock(lock);
+    close(ready[0]);
+    close(ready[1]);
+    PolicyDestroy(policy);
+}
+
+static void test_promise_runtime_hash(void)
+{
+    Policy *policy = TestPolicy();
+    const Bundle *bundle = SeqAt(policy->bundles, 0);
+    const PromiseType *tp = SeqAt(bundle->promise_types, 0);
+    Promise *pp = SeqAt(tp->promises, 0);
+    PromiseAppendConstraint(pp, "perms", RvalNew("m", RVAL_TYPE_SCALAR), false);
+    PromiseAppendConstraint(pp, "mtime", RvalNew("123", RVAL_TYPE_SCALAR), false);
+
+    /* The digest of all of it, but times. */
+    const char input[] = "/etc/motd" "default" "main" "salt" "perms" "m" "mtime";
+    unsigned char expected[EVP_MAX_MD_SIZE + 1] = { 0 };
+    HashString(input, strlen(input), expected, HASH_METHOD_SHA256);
+
+    unsigned char digest[EVP_MAX_MD_SIZE + 1] = { 0 };
+    PromiseRuntimeHash(pp, "salt", digest, HASH_METHOD_SHA256);
+    assert_memory_equal(digest, expected, sizeof(digest));
+
+    /* Stable across calls, different per salt and hash method. */
+    memset(digest, 0, sizeof(digest));
+    PromiseRuntimeHash(pp, "salt", digest, HASH_METHOD_SHA256);
+    assert_memory_equal(digest, expected, sizeof(digest));
+
+    PromiseRuntimeHash(pp, "other", digest, HASH_METHOD_SHA256);
+    assert_memory_not_equal(digest, expected, sizeof(digest));
+
+    memset(digest, 0, sizeof(digest));
+    memset(expected, 0, sizeof(expected));
+    HashString(input, strlen(input), expected, HASH_METHOD_MD5);
+    PromiseRuntimeHash(pp, "salt", digest, HASH_METHOD_MD5);
+    assert_memory_equal(digest, expected, sizeof(digest));
+
+    PolicyDestroy(policy);
+}
+
 static void tests_setup(void)
 {
     OpenSSL_add_all_digests();
@@ -15,6 +195,10 @@ static void tests_setup(void)
     xsnprintf(CFWORKDIR, CF_BUFSIZE, "/tmp/persistent_lock_test.XXXXXX");
     mkdtemp(CFWORKDIR);
 
+    static char env[CF_BUFSIZE]; /* Needs to be static for putenv() */
+    xsnprintf(env, sizeof(env), "CFENGINE_TEST_OVERRIDE_WORKDIR=%s", CFWORKDIR);
+    putenv(env);
+
     char buf[CF_BUFSIZE];
     xsnprintf(buf, CF_BUFSIZE, "%s", GetStateDir());
     mkdir(buf, 0755);
@@ -34,7 +218,9 @@ int main()
 
     const UnitTest tests[] =
       {
-
+          unit_test(test_promise_runtime_hash),
+          unit_test(test_acquire_yield),
+          unit_test(test_expired_lock_holder_killed),
       };
     
     int ret = run_tests(tests);
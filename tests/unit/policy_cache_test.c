@@ -0,0 +1,231 @@
+/*
+   Copyright 2018 Northern.tech AS
+
+   This file is part of CFEngine 3 - written and maintained by Northern.tech AS.
+
+   This program is free software; you can redistribute it and/or modify it
+   under the terms of the GNU General Public License as published by the
+   Free Software Foundation; version 3.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA
+
+  To the extent this program is licensed as part of the Enterprise
+  versions of CFEngine, the applicable Commercial Open Source License
+  (COSL) may apply to this file if you as a licensee so wish it. See
+  included file COSL.txt.
+*/
+
+#include <test.h>
+
+#include <cf3.defs.h>
+#include <policy_cache.h>
+#include <known_dirs.h>
+#include <fncall.h>
+#include <rlist.h>
+#include <json.h>
+#include <writer.h>
+#include <misc_lib.h>                                          /* xsnprintf */
+
+
+#define POLICY_FILE "/var/cfengine/inputs/promises.cf"
+#define DIGEST "SHA=0123456789abcdef"
+
+char CFWORKDIR[CF_BUFSIZE];
+
+static Policy *TestPolicy(void)
+{
+    Policy *policy = PolicyNew();
+
+    Rlist *args = NULL;
+    RlistAppendScalar(&args, "x");
+    Bundle *bundle = PolicyAppendBundle(policy, "ns1", "main", "agent",
+                                        args, POLICY_FILE);
+    RlistDestroy(args);
+    bundle->offset.line = 3;
+
+    PromiseType *tp = BundleAppendPromiseType(bundle, "files");
+    tp->offset.line = 4;
+
+    Rlist *promisees = NULL;
+    RlistAppendScalar(&promisees, "alice");
+    RlistAppendScalar(&promisees, "bob");
+    Promise *pp = PromiseTypeAppendPromise(tp, "/etc/motd",
+                                           (Rval) { promisees, RVAL_TYPE_LIST },
+                                           "linux", NULL);
+    pp->comment = xstrdup("the message of the day");
+    pp->offset.line = 5;
+
+    Constraint *cp = PromiseAppendConstraint(pp, "perms", RvalNew("m", RVAL_TYPE_SCALAR), true);
+    cp->offset.line = 6;
+
+    Rlist *fn_args = NULL;
+    RlistAppendScalar(&fn_args, "/tmp");
+    RlistAppendScalar(&fn_args, "");
+    PromiseAppendConstraint(pp, "create",
+                            (Rval) { FnCallNew("fileexists", fn_args), RVAL_TYPE_FNCALL },
+                            false);
+
+    JsonElement *json = JsonObjectCreate(2);
+    JsonObjectAppendString(json, "key", "value");
+    PromiseType *vars = BundleAppendPromiseType(bundle, "vars");
+    Promise *var = PromiseTypeAppendPromise(vars, "data",
+                                            (Rval) { NULL, RVAL_TYPE_NOPROMISEE },
+                                            NULL, NULL);
+    PromiseAppendConstraint(var, "data", (Rval) { json, RVAL_TYPE_CONTAINER }, false);
+
+    Body *body = PolicyAppendBody(policy, "default", "m", "perms", NULL, POLICY_FILE);
+    body->offset.line = 10;
+    BodyAppendConstraint(body, "mode", RvalNew("644", RVAL_TYPE_SCALAR), "any", false);
+    BodyAppendConstraint(body, "mode", RvalNew("600", RVAL_TYPE_SCALAR), "windows", false);
+
+    return policy;
+}
+
+static char *PolicyJsonString(const Policy *policy)
+{
+    JsonElement *json = PolicyToJson(policy);
+    Writer *w = StringWriter();
+    JsonWrite(w, json, 0);
+    JsonDestroy(json);
+    return StringWriterClose(w);
+}
+
+static void test_round_trip(void)
+{
+    Policy *policy = TestPolicy();
+    Buffer *data = BufferNew();
+    PolicyCacheSerialize(policy, data);
+
+    Policy *loaded = PolicyCacheDeserialize(BufferData(data), BufferSize(data),
+                                            POLICY_FILE);
+    assert_true(loaded != NULL);
+
+    char *expected = PolicyJsonString(policy);
+    char *actual = PolicyJsonString(loaded);
+    assert_string_equal(expected, actual);
+    free(expected);
+    free(actual);
+
+    /* Not part of the JSON. */
+    const Bundle *bundle = PolicyGetBundle(loaded, "ns1", "agent", "main");
+    assert_true(bundle != NULL);
+    assert_int_equal(bundle->offset.line, 3);
+    const PromiseType *tp = BundleGetPromiseType(bundle, "files");
+    assert_int_equal(tp->offset.line, 4);
+    const Promise *pp = SeqAt(tp->promises, 0);
+    assert_string_equal(pp->comment, "the message of the day");
+    assert_string_equal(pp->classes, "linux");
+    assert_true(pp->parent_promise_type == tp);
+    const Constraint *cp = SeqAt(pp->conlist, 0);
+    assert_int_equal(cp->offset.line, 6);
+    assert_true(cp->references_body);
+    assert_true(cp->parent.promise == pp);
+
+    const Body *body = PolicyGetBody(loaded, "default", "perms", "m");
+    assert_true(body != NULL);
+    assert_string_equal(body->source_path, POLICY_FILE);
+    assert_int_equal(SeqLength(body->conlist), 2);
+    assert_string_equal(((Constraint *) SeqAt(body->conlist, 1))->classes, "windows");
+
+    PolicyDestroy(loaded);
+    PolicyDestroy(policy);
+    BufferDestroy(data);
+}
+
+static void test_invalid_data(void)
+{
+    Policy *policy = TestPolicy();
+    Buffer *data = BufferNew();
+    PolicyCacheSerialize(policy, data);
+    PolicyDestroy(policy);
+
+    /* Every truncation is detected. */
+    for (size_t size = 0; size < BufferSize(data); size++)
+    {
+        assert_true(PolicyCacheDeserialize(BufferData(data), size, POLICY_FILE) == NULL);
+    }
+
+    /* So is trailing garbage, and a wrong magic. */
+    char *copy = xmalloc(BufferSize(data) + 1);
+    memcpy(copy, BufferData(data), BufferSize(data));
+    copy[BufferSize(data)] = 'x';
+    assert_true(PolicyCacheDeserialize(copy, BufferSize(data) + 1, POLICY_FILE) == NULL);
+    copy[0] = 'X';
+    assert_true(PolicyCacheDeserialize(copy, BufferSize(data), POLICY_FILE) == NULL);
+
+    free(copy);
+    BufferDestroy(data);
+}
+
+static void test_store_load(void)
+{
+    assert_true(PolicyCacheLoad(POLICY_FILE, DIGEST, AGENT_TYPE_AGENT) == NULL);
+
+    Policy *policy = TestPolicy();
+    assert_true(PolicyCacheStore(policy, DIGEST, AGENT_TYPE_AGENT));
+
+    /* Cached per agent type. */
+    assert_true(PolicyCacheLoad(POLICY_FILE, DIGEST, AGENT_TYPE_SERVER) == NULL);
+
+    Policy *loaded = PolicyCacheLoad(POLICY_FILE, DIGEST, AGENT_TYPE_AGENT);
+    assert_true(loaded != NULL);
+    char *expected = PolicyJsonString(policy);
+    char *actual = PolicyJsonString(loaded);
+    assert_string_equal(expected, actual);
+    free(expected);
+    free(actual);
+    PolicyDestroy(loaded);
+    PolicyDestroy(policy);
+
+    /* A corrupt cache file is a miss, and is removed. */
+    char path[CF_BUFSIZE];
+    xsnprintf(path, sizeof(path), "%s/%s/%s.%s", GetStateDir(),
+              POLICY_CACHE_DIR, DIGEST, CF_AGENTTYPES[AGENT_TYPE_AGENT]);
+    assert_int_equal(truncate(path, 20), 0);
+    assert_true(PolicyCacheLoad(POLICY_FILE, DIGEST, AGENT_TYPE_AGENT) == NULL);
+    assert_int_equal(access(path, F_OK), -1);
+}
+
+static void tests_setup(void)
+{
+    static char env[] = /* Needs to be static for putenv() */
+        "CFENGINE_TEST_OVERRIDE_WORKDIR=/tmp/policy_cache_test.XXXXXX";
+
+    char *workdir = strchr(env, '=') + 1; /* start of the path */
+    assert_true(mkdtemp(workdir) != NULL);
+    strlcpy(CFWORKDIR, workdir, CF_BUFSIZE);
+    putenv(env);
+    mkdir(GetStateDir(), 0700);
+}
+
+static void tests_teardown(void)
+{
+    char cmd[CF_BUFSIZE];
+    xsnprintf(cmd, CF_BUFSIZE, "rm -rf '%s'", CFWORKDIR);
+    system(cmd);
+}
+
+int main()
+{
+    PRINT_TEST_BANNER();
+    tests_setup();
+
+    const UnitTest tests[] =
+    {
+        unit_test(test_round_trip),
+        unit_test(test_invalid_data),
+        unit_test(test_store_load),
+    };
+
+    int ret = run_tests(tests);
+
+    tests_teardown();
+    return ret;
+}
@@ -0,0 +1,231 @@
+/*
+   Copyright 2018 Northern.tech AS
+
+   This file is part of CFEngine 3 - written and maintained by Northern.tech AS.
+
+   This program is free software; you can redistribute it and/or modify it
+   under the terms of the GNU General Public License as published by the
+   Free Software Foundation; version 3.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA
+
+  To the extent this program is licensed as part of the Enterprise
+  versions of CFEngine, the applicable Commercial Open Source License
+  (COSL) may apply to this file if you as a licensee so wish it. See
+  included file COSL.txt.
+*/
+
+#include <test.h>
+
+#include <cf3.defs.h>
+#include <policy_snapshot.h>
+#include <misc_lib.h>                                          /* xsnprintf */
+
+
+char POLICY_DIR[CF_BUFSIZE] = "/tmp/policy_snapshot_test.XXXXXX";
+
+#define CONTENTS_A "bundle agent a { }\n"
+#define CONTENTS_B "bundle agent b { reports: \"b\"; }\n"
+
+static void WriteTestFile(const char *relpath, const char *contents)
+{
+    char path[CF_BUFSIZE];
+    xsnprintf(path, sizeof(path), "%s/%s", POLICY_DIR, relpath);
+
+    FILE *fp = fopen(path, "w");
+    assert_true(fp != NULL);
+    assert_int_equal(fputs(contents, fp) >= 0, true);
+    assert_int_equal(fclose(fp), 0);
+}
+
+static PolicySnapshotIndex *LoadIndex(void)
+{
+    char index[CF_BUFSIZE];
+    xsnprintf(index, sizeof(index), "%s/%s",
+              POLICY_DIR, POLICY_SNAPSHOT_INDEX_FILE);
+    return PolicySnapshotIndexLoad(index);
+}
+
+static const PolicySnapshotEntry *FindEntry(const PolicySnapshotIndex *index,
+                                            const char *path)
+{
+    for (size_t i = 0; i < SeqLength(index->entries); i++)
+    {
+        const PolicySnapshotEntry *entry = SeqAt(index->entries, i);
+        if (strcmp(entry->path, path) == 0)
+        {
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+static void tests_setup(void)
+{
+    assert_true(mkdtemp(POLICY_DIR) != NULL);
+
+    char sub[CF_BUFSIZE];
+    xsnprintf(sub, sizeof(sub), "%s/lib", POLICY_DIR);
+    mkdir(sub, 0700);
+
+    WriteTestFile("promises.cf", CONTENTS_A);
+    WriteTestFile("lib/b.cf", CONTENTS_B);
+    WriteTestFile("lib/copy_of_a.cf", CONTENTS_A);
+    WriteTestFile("empty.dat", "");
+}
+
+static void tests_teardown(void)
+{
+    char cmd[CF_BUFSIZE];
+    xsnprintf(cmd, CF_BUFSIZE, "rm -rf '%s'", POLICY_DIR);
+    system(cmd);
+}
+
+static void test_write_and_load(void)
+{
+    assert_true(PolicySnapshotWrite(POLICY_DIR, "1234abcd"));
+
+    PolicySnapshotIndex *index = LoadIndex();
+    assert_true(index != NULL);
+    assert_string_equal(index->release_id, "1234abcd");
+    assert_int_equal(SeqLength(index->entries), 4);
+
+    /* Sorted by path. */
+    const PolicySnapshotEntry *first = SeqAt(index->entries, 0);
+    assert_string_equal(first->path, "empty.dat");
+
+    const PolicySnapshotEntry *a = FindEntry(index, "promises.cf");
+    const PolicySnapshotEntry *b = FindEntry(index, "lib/b.cf");
+    const PolicySnapshotEntry *copy = FindEntry(index, "lib/copy_of_a.cf");
+    const PolicySnapshotEntry *empty = FindEntry(index, "empty.dat");
+    assert_true(a != NULL && b != NULL && copy != NULL && empty != NULL);
+
+    assert_int_equal(a->size, strlen(CONTENTS_A));
+    assert_int_equal(b->size, strlen(CONTENTS_B));
+    assert_int_equal(empty->size, 0);
+
+    /* Identical contents are stored once. */
+    assert_string_equal(a->digest, copy->digest);
+    assert_int_equal(a->offset, copy->offset);
+    assert_true(strcmp(a->digest, b->digest) != 0);
+
+    char archive[CF_BUFSIZE];
+    xsnprintf(archive, sizeof(archive), "%s/%s",
+              POLICY_DIR, POLICY_SNAPSHOT_FILE);
+    struct stat sb;
+    assert_int_equal(stat(archive, &sb), 0);
+    assert_int_equal(sb.st_size, strlen(CONTENTS_A) + strlen(CONTENTS_B));
+
+    /* The member is found at its offset. */
+    char buf[CF_BUFSIZE] = "";
+    FILE *fp = fopen(archive, "rb");
+    assert_true(fp != NULL);
+    assert_int_equal(fseek(fp, b->offset, SEEK_SET), 0);
+    assert_int_equal(fread(buf, 1, b->size, fp), b->size);
+    fclose(fp);
+    assert_string_equal(buf, CONTENTS_B);
+
+    PolicySnapshotIndexDestroy(index);
+}
+
+static void test_snapshot_not_included_in_itself(void)
+{
+    assert_true(PolicySnapshotWrite(POLICY_DIR, "1"));
+    assert_true(PolicySnapshotWrite(POLICY_DIR, "2"));
+
+    PolicySnapshotIndex *index = LoadIndex();
+    assert_true(index != NULL);
+    assert_string_equal(index->release_id, "2");
+    assert_int_equal(SeqLength(index->entries), 4);
+    assert_true(FindEntry(index, POLICY_SNAPSHOT_FILE) == NULL);
+    assert_true(FindEntry(index, POLICY_SNAPSHOT_INDEX_FILE) == NULL);
+    PolicySnapshotIndexDestroy(index);
+}
+
+static void test_not_published_with_symlink_or_empty_dir(void)
+{
+    char path[CF_BUFSIZE], archive[CF_BUFSIZE];
+    xsnprintf(archive, sizeof(archive), "%s/%s",
+              POLICY_DIR, POLICY_SNAPSHOT_FILE);
+    struct stat sb;
+
+    /* Can't be carried, and the previous snapshot is outdated. */
+    assert_true(PolicySnapshotWrite(POLICY_DIR, "1"));
+    xsnprintf(path, sizeof(path), "%s/lib/link.cf", POLICY_DIR);
+    assert_int_equal(symlink("b.cf", path), 0);
+    assert_false(PolicySnapshotWrite(POLICY_DIR, "2"));
+    assert_true(LoadIndex() == NULL);
+    assert_int_equal(stat(archive, &sb), -1);
+    assert_int_equal(unlink(path), 0);
+
+    assert_true(PolicySnapshotWrite(POLICY_DIR, "3"));
+    xsnprintf(path, sizeof(path), "%s/lib/empty", POLICY_DIR);
+    assert_int_equal(mkdir(path, 0700), 0);
+    assert_false(PolicySnapshotWrite(POLICY_DIR, "4"));
+    assert_true(LoadIndex() == NULL);
+    assert_int_equal(stat(archive, &sb), -1);
+    assert_int_equal(rmdir(path), 0);
+
+    assert_true(PolicySnapshotWrite(POLICY_DIR, "5"));
+    PolicySnapshotIndex *index = LoadIndex();
+    assert_true(index != NULL);
+    assert_int_equal(SeqLength(index->entries), 4);
+    PolicySnapshotIndexDestroy(index);
+}
+
+static void test_load_rejects_unsafe_paths(void)
+{
+    const char *const bad[] = {
+        "SHA=00 0 1 0600 ../outside.cf\n",
+        "SHA=00 0 1 0600 /etc/passwd\n",
+        "SHA=00 0 1 0600 lib/../../outside.cf\n",
+        "SHA=00 0 1 0600 lib//b.cf\n",
+        "SHA=00 -1 1 0600 promises.cf\n",
+        "garbage\n",
+    };
+
+    for (size_t i = 0; i < sizeof(bad) / sizeof(bad[0]); i++)
+    {
+        char contents[CF_BUFSIZE];
+        xsnprintf(contents, sizeof(contents), "release_id 1\n%s", bad[i]);
+        WriteTestFile(POLICY_SNAPSHOT_INDEX_FILE, contents);
+        assert_true(LoadIndex() == NULL);
+    }
+
+    WriteTestFile(POLICY_SNAPSHOT_INDEX_FILE,
+                  "release_id 1\nSHA=00 0 1 0600 lib/b.cf\n");
+    PolicySnapshotIndex *index = LoadIndex();
+    assert_true(index != NULL);
+    assert_int_equal(SeqLength(index->entries), 1);
+    PolicySnapshotIndexDestroy(index);
+
+    /* No release ID. */
+    WriteTestFile(POLICY_SNAPSHOT_INDEX_FILE, "");
+    assert_true(LoadIndex() == NULL);
+}
+
+int main()
+{
+    tests_setup();
+
+    const UnitTest tests[] =
+        {
+            unit_test(test_write_and_load),
+            unit_test(test_snapshot_not_included_in_itself),
+            unit_test(test_not_published_with_symlink_or_empty_dir),
+            unit_test(test_load_rejects_unsafe_paths),
+        };
+
+    PRINT_TEST_BANNER();
+    int ret = run_tests(tests);
+
+    tests_teardown();
+    return ret;
+}
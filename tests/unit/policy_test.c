@@ -352,6 +352,84 @@ static void test_util_bundle_qualified_name(void)
     free(b);
 }
 
+static void test_util_promise_constraint_lookup(void)
+{
+    Policy *policy = PolicyNew();
+    Bundle *bundle = PolicyAppendBundle(policy, NamespaceDefault(), "bundle", "agent", NULL, NULL);
+    PromiseType *promise_type = BundleAppendPromiseType(bundle, "files");
+    Promise *pp = PromiseTypeAppendPromise(promise_type, "/tmp/foo", (Rval) { NULL, RVAL_TYPE_NOPROMISEE }, "any", NULL);
+
+    /* Enough constraints to get them indexed. */
+    for (int i = 0; i < 40; i++)
+    {
+        char lval[16], value[16];
+        xsnprintf(lval, sizeof(lval), "lval%d", i);
+        xsnprintf(value, sizeof(value), "value%d", i);
+        PromiseAppendConstraint(pp, lval, RvalNew(value, RVAL_TYPE_SCALAR), false);
+
+        for (int j = 0; j <= i; j++)
+        {
+            xsnprintf(lval, sizeof(lval), "lval%d", j);
+            xsnprintf(value, sizeof(value), "value%d", j);
+            assert_string_equal(value, PromiseGetConstraintAsRval(pp, lval, RVAL_TYPE_SCALAR));
+        }
+    }
+
+    assert_true(PromiseGetConstraint(pp, "missing") == NULL);
+    assert_true(PromiseGetConstraintAsRval(pp, "lval3", RVAL_TYPE_LIST) == NULL);
+    assert_true(PromiseGetConstraintWithType(pp, "lval3", RVAL_TYPE_LIST) == NULL);
+    assert_true(PromiseGetConstraintWithType(pp, "lval3", RVAL_TYPE_SCALAR) != NULL);
+
+    /* Appending an existing lval replaces the constraint in place. */
+    PromiseAppendConstraint(pp, "lval7", RvalNew("yes", RVAL_TYPE_SCALAR), false);
+    assert_int_equal(40, SeqLength(pp->conlist));
+    assert_string_equal("yes", PromiseGetConstraintAsRval(pp, "lval7", RVAL_TYPE_SCALAR));
+    assert_true(PromiseGetConstraint(pp, "lval7") == SeqAt(pp->conlist, 7));
+
+    PolicyDestroy(policy);
+}
+
+static void test_util_bundle_body_lookup(void)
+{
+    Policy *a = PolicyNew();
+    Bundle *main_bundle = PolicyAppendBundle(a, NamespaceDefault(), "main", "agent", NULL, NULL);
+    Bundle *edit_main = PolicyAppendBundle(a, NamespaceDefault(), "main", "edit_line", NULL, NULL);
+    Bundle *ns_main = PolicyAppendBundle(a, "ns", "main", "agent", NULL, NULL);
+    Body *perms = PolicyAppendBody(a, NamespaceDefault(), "p", "perms", NULL, NULL);
+
+    Policy *b = PolicyNew();
+    Bundle *other = PolicyAppendBundle(b, NamespaceDefault(), "other", "agent", NULL, NULL);
+    Body *ns_perms = PolicyAppendBody(b, "ns", "ns:p", "perms", NULL, NULL);
+    Body *action = PolicyAppendBody(b, NamespaceDefault(), "p", "action", NULL, NULL);
+
+    Policy *policy = PolicyMerge(a, b);
+
+    /* First match in policy order, optionally filtered by namespace. */
+    assert_true(PolicyGetBundle(policy, NULL, "agent", "main") == main_bundle);
+    assert_true(PolicyGetBundle(policy, NULL, NULL, "main") == main_bundle);
+    assert_true(PolicyGetBundle(policy, NULL, "edit_line", "main") == edit_main);
+    assert_true(PolicyGetBundle(policy, "ns", "agent", "main") == ns_main);
+    assert_true(PolicyGetBundle(policy, "ns", "agent", "ns:main") == ns_main);
+    assert_true(PolicyGetBundle(policy, NULL, "agent", "other") == other);
+    assert_true(PolicyGetBundle(policy, NULL, "agent", "missing") == NULL);
+    assert_true(PolicyGetBundle(policy, "ns", "agent", "other") == NULL);
+
+    assert_true(PolicyGetBody(policy, NULL, "perms", "p") == perms);
+    assert_true(PolicyGetBody(policy, "ns", "perms", "p") == ns_perms);
+    assert_true(PolicyGetBody(policy, NULL, "action", "p") == action);
+    assert_true(PolicyGetBody(policy, NULL, "action", "missing") == NULL);
+
+    assert_true(EvalContextFindFirstMatchingBody(policy, "perms", "ns", "ns:p") == ns_perms);
+    assert_true(EvalContextFindFirstMatchingBody(policy, "perms", "default", "p") == perms);
+    assert_true(EvalContextFindFirstMatchingBody(policy, "perms", "ns", "p") == NULL);
+
+    assert_int_equal(3, SeqLength(PolicyGetBundlesNamed(policy, "main")));
+    assert_int_equal(3, SeqLength(PolicyGetBodiesNamed(policy, "p")));
+    assert_true(PolicyGetBundlesNamed(policy, "p") == NULL);
+
+    PolicyDestroy(policy);
+}
+
 static void test_util_qualified_name_components(void)
 {
     {
@@ -472,6 +550,8 @@ int main()
 
         unit_test(test_util_bundle_qualified_name),
         unit_test(test_util_qualified_name_components),
+        unit_test(test_util_promise_constraint_lookup),
+        unit_test(test_util_bundle_body_lookup),
 
         unit_test(test_constraint_comment_nonscalar),
 
@@ -0,0 +1,166 @@
+/*
+   Copyright 2018 Northern.tech AS
+
+   This file is part of CFEngine 3 - written and maintained by Northern.tech AS.
+
+   This program is free software; you can redistribute it and/or modify it
+   under the terms of the GNU General Public License as published by the
+   Free Software Foundation; version 3.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA
+
+  To the extent this program is licensed as part of the Enterprise
+  versions of CFEngine, the applicable Commercial Open Source License
+  (COSL) may apply to this file if you as a licensee so wish it. See
+  included file COSL.txt.
+*/
+
+#include <test.h>
+
+#include <cf3.defs.h>
+#include <profiler.h>
+#include <json.h>
+#include <writer.h>
+
+
+/* Long enough for every frame to show up in microseconds. */
+#define FRAME_USEC 2000
+
+static Policy *TestPolicy(void)
+{
+    Policy *policy = PolicyNew();
+    Bundle *bundle = PolicyAppendBundle(policy, "default", "main", "agent",
+                                        NULL, "/var/cfengine/inputs/promises.cf");
+    PromiseType *tp = BundleAppendPromiseType(bundle, "files");
+    Promise *pp = PromiseTypeAppendPromise(tp, "/tmp/a;b\nc",
+                                           (Rval) { NULL, RVAL_TYPE_NOPROMISEE },
+                                           NULL, NULL);
+    pp->offset.line = 7;
+    return policy;
+}
+
+static void EvaluateTestPolicy(const Policy *policy)
+{
+    const Bundle *bundle = SeqAt(policy->bundles, 0);
+    const PromiseType *tp = SeqAt(bundle->promise_types, 0);
+    const Promise *pp = SeqAt(tp->promises, 0);
+
+    ProfilerEnterBundle(bundle);
+    ProfilerEnterPromiseType(tp);
+
+    /* Evaluated twice, with two iterations the first time. */
+    for (int i = 0; i < 2; i++)
+    {
+        ProfilerEnterPromise(pp);
+        ProfilerPromiseIteration();
+        if (i == 0)
+        {
+            ProfilerPromiseIteration();
+        }
+        usleep(FRAME_USEC);
+
+        ProfilerEnterFunction("readfile");
+        usleep(FRAME_USEC);
+        ProfilerLeave();
+
+        ProfilerLeave();
+    }
+
+    ProfilerLeave();
+    ProfilerLeave();
+}
+
+static void test_folded(void)
+{
+    Policy *policy = TestPolicy();
+    ProfilerStart();
+    EvaluateTestPolicy(policy);
+
+    Writer *w = StringWriter();
+    ProfilerWriteFolded(w, "cf-agent", false);
+    char *folded = StringWriterClose(w);
+
+    /* Frame names have neither ';' nor newlines. */
+    assert_true(strstr(folded, "\ncf-agent;default:main;files;/tmp/a_b_c ") != NULL);
+    assert_true(strstr(folded, "\ncf-agent;default:main;files;/tmp/a_b_c;readfile() ") != NULL);
+
+    /* One line per frame, and the same promise is the same frame. */
+    size_t lines = 0;
+    for (const char *c = folded; *c != '\0'; c++)
+    {
+        lines += (*c == '\n');
+    }
+    assert_true(lines <= 5);
+
+    free(folded);
+    ProfilerStop();
+    PolicyDestroy(policy);
+}
+
+static void test_summary(void)
+{
+    Policy *policy = TestPolicy();
+    ProfilerStart();
+    EvaluateTestPolicy(policy);
+    JsonElement *summary = ProfilerSummary(10);
+
+    JsonElement *promises = JsonObjectGetAsArray(summary, "promises");
+    assert_int_equal(JsonLength(promises), 1);
+    JsonElement *promise = JsonArrayGetAsObject(promises, 0);
+    assert_string_equal(JsonObjectGetAsString(promise, "bundle"), "main");
+    assert_string_equal(JsonObjectGetAsString(promise, "promiseType"), "files");
+    assert_string_equal(JsonObjectGetAsString(promise, "promiser"), "/tmp/a;b\nc");
+    assert_int_equal(JsonPrimitiveGetAsInteger(JsonObjectGet(promise, "line")), 7);
+    assert_int_equal(JsonPrimitiveGetAsInteger(JsonObjectGet(promise, "evaluations")), 2);
+    assert_int_equal(JsonPrimitiveGetAsInteger(JsonObjectGet(promise, "iterations")), 3);
+
+    /* The time of the function is not the promise's own. */
+    double wall = JsonPrimitiveGetAsReal(JsonObjectGet(promise, "wallMs"));
+    double self_wall = JsonPrimitiveGetAsReal(JsonObjectGet(promise, "selfWallMs"));
+    assert_true(wall >= 4 * FRAME_USEC / 1000.0);
+    assert_true(self_wall >= 2 * FRAME_USEC / 1000.0);
+    assert_true(self_wall < wall);
+
+    JsonElement *functions = JsonObjectGetAsArray(summary, "functions");
+    assert_int_equal(JsonLength(functions), 1);
+    JsonElement *function = JsonArrayGetAsObject(functions, 0);
+    assert_string_equal(JsonObjectGetAsString(function, "name"), "readfile");
+    assert_int_equal(JsonPrimitiveGetAsInteger(JsonObjectGet(function, "calls")), 2);
+
+    JsonDestroy(summary);
+    ProfilerStop();
+    PolicyDestroy(policy);
+}
+
+static void test_disabled(void)
+{
+    Policy *policy = TestPolicy();
+    assert_false(ProfilerIsEnabled());
+    EvaluateTestPolicy(policy);
+
+    JsonElement *summary = ProfilerSummary(10);
+    assert_int_equal(JsonLength(JsonObjectGetAsArray(summary, "promises")), 0);
+    assert_int_equal(JsonLength(JsonObjectGetAsArray(summary, "functions")), 0);
+    JsonDestroy(summary);
+    PolicyDestroy(policy);
+}
+
+int main()
+{
+    PRINT_TEST_BANNER();
+    const UnitTest tests[] =
+    {
+        unit_test(test_folded),
+        unit_test(test_summary),
+        unit_test(test_disabled),
+    };
+
+    return run_tests(tests);
+}
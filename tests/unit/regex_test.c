@@ -4,6 +4,7 @@
 #include <matching.h>
 #include <match_scope.h>
 #include <eval_context.h>
+#include <regex.h>
 
 static void test_full_text_match(void)
 {
@@ -43,6 +44,130 @@ static void test_block_text_match2(void)
     EvalContextDestroy(ctx);
 }
 
+static void test_regex_cache(void)
+{
+    int start, end;
+
+    for (int i = 0; i < 3; i++)
+    {
+        assert_true(StringMatch("[a-z]+", "1234abcd6789", &start, &end));
+        assert_int_equal(start, 4);
+        assert_int_equal(end, 8);
+        assert_true(StringMatchFull("[0-9]+[a-z]+[0-9]+", "1234abcd6789"));
+        assert_false(StringMatchFull("[a-z]+", "1234abcd6789"));
+    }
+
+    /* Not a match, the offsets are reset. */
+    assert_false(StringMatch("x", "1234", &start, &end));
+    assert_int_equal(start, 0);
+    assert_int_equal(end, 0);
+
+    /* Invalid patterns are cached too, they are only compiled once. */
+    unsigned long hits, misses, hits_after, misses_after;
+    assert_false(StringMatch("(", "(", NULL, NULL));
+    RegexCache_GetStats(&hits, &misses);
+    assert_false(StringMatch("(", "(", NULL, NULL));
+    assert_true(CachedRegexAcquire("(") == NULL);
+    RegexCache_GetStats(&hits_after, &misses_after);
+    assert_int_equal(hits_after, hits + 2);
+    assert_int_equal(misses_after, misses);
+
+    /* Matched with the cached, studied pattern itself. */
+    CachedRegex *cached = CachedRegexAcquire("ab+c");
+    assert_true(cached != NULL);
+    assert_true(StringMatchFullWithCachedRegex(cached, "abbbc"));
+    assert_false(StringMatchFullWithCachedRegex(cached, "abbbcd"));
+    assert_true(StringMatchWithCachedRegex(cached, "xabcx", &start, &end));
+    assert_int_equal(start, 1);
+    assert_int_equal(end, 4);
+    CachedRegexRelease(cached);
+    CachedRegexRelease(NULL);
+
+    /* Each caller gets its own copy, which it frees. */
+    pcre *rx1 = CompileRegex("ab+c");
+    pcre *rx2 = CompileRegex("ab+c");
+    assert_true(rx1 != NULL && rx2 != NULL && rx1 != rx2);
+    pcre_free(rx1);
+    assert_true(StringMatchFullWithPrecompiledRegex(rx2, "abbbc"));
+    pcre_free(rx2);
+
+    /* More patterns than fit in the cache. */
+    for (int i = 0; i < 3000; i++)
+    {
+        char regex[64];
+        char str[64];
+        snprintf(regex, sizeof(regex), "p%d_[0-9]+", i);
+        snprintf(str, sizeof(str), "p%d_%d", i, i * 7);
+        assert_true(StringMatchFull(regex, str));
+    }
+    assert_true(StringMatchFull("[0-9]+[a-z]+[0-9]+", "1234abcd6789"));
+
+    Seq *captures = StringMatchCaptures("(?<word>[a-z]+)([0-9])", "..ab1", true);
+    assert_true(captures != NULL);
+    assert_int_equal(SeqLength(captures), 6);
+    assert_string_equal(BufferData(SeqAt(captures, 2)), "word");
+    assert_string_equal(BufferData(SeqAt(captures, 3)), "ab");
+    SeqDestroy(captures);
+
+    RegexCache_LogStats(LOG_LEVEL_VERBOSE);
+
+    /* Still in use, freed once released. */
+    cached = CachedRegexAcquire("ab+c");
+    RegexCache_Clear();
+    assert_true(StringMatchFullWithCachedRegex(cached, "abc"));
+    CachedRegexRelease(cached);
+    assert_true(StringMatchFull("ab+c", "abc"));
+}
+
+static void test_regex_set(void)
+{
+    const char *const regexes[] = {
+        "foo[0-9]+",
+        "(",                                                   /* invalid */
+        "a|ab",                   /* StringMatchFull() doesn't match "ab" */
+        "(x)\\1",                           /* matched on its own */
+        "(?<name>b+)c",
+        "(?<name>d+)e",              /* duplicate name, can't be merged */
+        ".*",
+    };
+    Seq *seq = SeqNew(10, NULL);
+    for (size_t i = 0; i < sizeof(regexes) / sizeof(regexes[0]); i++)
+    {
+        SeqAppend(seq, (void *) regexes[i]);
+    }
+
+    RegexSet *set = RegexSetNew(seq);
+    assert_int_equal(RegexSetLength(set), 7);
+
+    assert_int_equal(RegexSetMatchFull(set, "foo123"), 0);
+    assert_int_equal(RegexSetMatchFull(set, "a"), 2);
+    assert_int_equal(RegexSetMatchFull(set, "ab"), 6);
+    assert_int_equal(RegexSetMatchFull(set, "xx"), 3);
+    assert_int_equal(RegexSetMatchFull(set, "bbc"), 4);
+    assert_int_equal(RegexSetMatchFull(set, "dde"), 5);
+    assert_int_equal(RegexSetMatchFull(set, "line1\nline2"), 6);
+    RegexSetDestroy(set);
+
+    /* Without the catch-all, and without the duplicate name. */
+    SeqRemove(seq, 6);
+    SeqRemove(seq, 5);
+    set = RegexSetNew(seq);
+    assert_int_equal(RegexSetMatchFull(set, "foo123"), 0);
+    assert_int_equal(RegexSetMatchFull(set, "foo"), -1);
+    assert_int_equal(RegexSetMatchFull(set, "ab"), -1);
+    assert_int_equal(RegexSetMatchFull(set, "xy"), -1);
+    assert_int_equal(RegexSetMatchFull(set, "bbc"), 4);
+    assert_int_equal(RegexSetMatchFull(set, "bbc\n"), -1);
+    RegexSetDestroy(set);
+
+    SeqClear(seq);
+    set = RegexSetNew(seq);
+    assert_int_equal(RegexSetMatchFull(set, ""), -1);
+    RegexSetDestroy(set);
+
+    SeqDestroy(seq);
+}
+
 int main()
 {
     PRINT_TEST_BANNER();
@@ -52,6 +177,8 @@ int main()
         unit_test(test_full_text_match2),
         unit_test(test_block_text_match),
         unit_test(test_block_text_match2),
+        unit_test(test_regex_cache),
+        unit_test(test_regex_set),
     };
 
     return run_tests(tests);
@@ -0,0 +1,248 @@
+/*
+   Copyright 2018 Northern.tech AS
+
+   This file is part of CFEngine 3 - written and maintained by Northern.tech AS.
+
+   This program is free software; you can redistribute it and/or modify it
+   under the terms of the GNU General Public License as published by the
+   Free Software Foundation; version 3.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA
+
+  To the extent this program is licensed as part of the Enterprise
+  versions of CFEngine, the applicable Commercial Open Source License
+  (COSL) may apply to this file if you as a licensee so wish it. See
+  included file COSL.txt.
+*/
+
+#include <test.h>
+
+#include <cf3.defs.h>
+#include <server_file_cache.h>
+#include <misc_lib.h>                                          /* xsnprintf */
+
+
+char TEST_DIR[CF_BUFSIZE] = "/tmp/server_file_cache_test.XXXXXX";
+
+static void WriteTestFile(const char *path, const char *contents,
+                          time_t mtime)
+{
+    FILE *fp = fopen(path, "w");
+    assert_true(fp != NULL);
+    assert_int_equal(fputs(contents, fp) >= 0, true);
+    assert_int_equal(fclose(fp), 0);
+
+    struct utimbuf times = { .actime = mtime, .modtime = mtime };
+    assert_int_equal(utime(path, &times), 0);
+}
+
+static void TestFilePath(char *path, size_t path_size, const char *name)
+{
+    xsnprintf(path, path_size, "%s/%s", TEST_DIR, name);
+}
+
+static void tests_setup(void)
+{
+    assert_true(mkdtemp(TEST_DIR) != NULL);
+}
+
+static void tests_teardown(void)
+{
+    char cmd[CF_BUFSIZE];
+    xsnprintf(cmd, CF_BUFSIZE, "rm -rf '%s'", TEST_DIR);
+    system(cmd);
+}
+
+static void test_acquire_uninitialised(void)
+{
+    char path[CF_BUFSIZE];
+    TestFilePath(path, sizeof(path), "uninit");
+    WriteTestFile(path, "contents\n", 1000);
+
+    struct stat sb;
+    assert_int_equal(stat(path, &sb), 0);
+
+    const char *data;
+    size_t size;
+    assert_true(FileCache_Acquire(path, &sb, &data, &size) == NULL);
+}
+
+static void test_acquire_hit_and_change(void)
+{
+    FileCache_Init(1024 * 1024);
+
+    char path[CF_BUFSIZE];
+    TestFilePath(path, sizeof(path), "promises.cf");
+    WriteTestFile(path, "first\n", 1000);
+
+    struct stat sb;
+    assert_int_equal(stat(path, &sb), 0);
+
+    const char *data;
+    size_t size;
+    FileCacheEntry *e1 = FileCache_Acquire(path, &sb, &data, &size);
+    assert_true(e1 != NULL);
+    assert_int_equal(size, strlen("first\n"));
+    assert_memory_equal(data, "first\n", size);
+    FileCache_Release(e1);
+
+    /* Served from memory even if the file is gone. */
+    unlink(path);
+    FileCacheEntry *e2 = FileCache_Acquire(path, &sb, &data, &size);
+    assert_true(e2 == e1);
+    assert_memory_equal(data, "first\n", size);
+
+    /* Rewritten file with a new mtime, the old contents are still in use. */
+    WriteTestFile(path, "second!\n", 2000);
+    struct stat sb2;
+    assert_int_equal(stat(path, &sb2), 0);
+
+    const char *data2;
+    size_t size2;
+    FileCacheEntry *e3 = FileCache_Acquire(path, &sb2, &data2, &size2);
+    assert_true(e3 != NULL);
+    assert_int_equal(size2, strlen("second!\n"));
+    assert_memory_equal(data2, "second!\n", size2);
+    assert_memory_equal(data, "first\n", size);
+
+    FileCache_Release(e2);
+    FileCache_Release(e3);
+
+    FileCache_Destroy();
+}
+
+static void SetTestFileMtime(const char *path, time_t sec, long nsec)
+{
+    const struct timespec times[2] = {
+        { .tv_sec = sec, .tv_nsec = nsec },
+        { .tv_sec = sec, .tv_nsec = nsec },
+    };
+    assert_int_equal(utimensat(AT_FDCWD, path, times, 0), 0);
+}
+
+static void test_rewrite_same_second_same_size(void)
+{
+    FileCache_Init(1024 * 1024);
+
+    char path[CF_BUFSIZE];
+    TestFilePath(path, sizeof(path), "same.cf");
+    WriteTestFile(path, "first\n", 1000);
+    SetTestFileMtime(path, 1000, 100);
+
+    struct stat sb;
+    assert_int_equal(stat(path, &sb), 0);
+
+    const char *data;
+    size_t size;
+    FileCacheEntry *e1 = FileCache_Acquire(path, &sb, &data, &size);
+    assert_true(e1 != NULL);
+    assert_memory_equal(data, "first\n", size);
+    FileCache_Release(e1);
+
+    /* Rewritten in place, same size, within the same second. */
+    WriteTestFile(path, "other\n", 1000);
+    SetTestFileMtime(path, 1000, 200);
+
+    struct stat sb2;
+    assert_int_equal(stat(path, &sb2), 0);
+    assert_int_equal(sb2.st_ino, sb.st_ino);
+    assert_int_equal(sb2.st_mtime, sb.st_mtime);
+    assert_int_equal(sb2.st_size, sb.st_size);
+
+    FileCacheEntry *e2 = FileCache_Acquire(path, &sb2, &data, &size);
+    assert_true(e2 != NULL);
+    assert_int_equal(size, strlen("other\n"));
+    assert_memory_equal(data, "other\n", size);
+    FileCache_Release(e2);
+
+    FileCache_Destroy();
+}
+
+static void test_eviction(void)
+{
+    /* Room for exactly 16 files of 100 bytes. */
+    FileCache_Init(16 * 100);
+
+    char contents[101];
+    memset(contents, 'x', 100);
+    contents[100] = '\0';
+
+    char paths[17][CF_BUFSIZE];
+    struct stat sbs[17];
+    for (int i = 0; i < 17; i++)
+    {
+        char name[32];
+        xsnprintf(name, sizeof(name), "file%d", i);
+        TestFilePath(paths[i], sizeof(paths[i]), name);
+        WriteTestFile(paths[i], contents, 1000);
+        assert_int_equal(stat(paths[i], &sbs[i]), 0);
+    }
+
+    const char *data;
+    size_t size;
+    for (int i = 0; i < 16; i++)
+    {
+        FileCacheEntry *entry =
+            FileCache_Acquire(paths[i], &sbs[i], &data, &size);
+        assert_true(entry != NULL);
+        assert_int_equal(size, 100);
+        FileCache_Release(entry);
+    }
+
+    /* Make file0 recently used, file1 is now the least recently used. */
+    FileCacheEntry *entry = FileCache_Acquire(paths[0], &sbs[0], &data, &size);
+    assert_true(entry != NULL);
+    FileCache_Release(entry);
+
+    entry = FileCache_Acquire(paths[16], &sbs[16], &data, &size);
+    assert_true(entry != NULL);
+    FileCache_Release(entry);
+
+    /* Only cached entries can be served once the files are gone. */
+    unlink(paths[0]);
+    unlink(paths[1]);
+    entry = FileCache_Acquire(paths[0], &sbs[0], &data, &size);
+    assert_true(entry != NULL);
+    FileCache_Release(entry);
+    assert_true(FileCache_Acquire(paths[1], &sbs[1], &data, &size) == NULL);
+
+    /* Too large for the cache. */
+    char big[CF_BUFSIZE];
+    TestFilePath(big, sizeof(big), "big");
+    char big_contents[1024];
+    memset(big_contents, 'y', sizeof(big_contents) - 1);
+    big_contents[sizeof(big_contents) - 1] = '\0';
+    WriteTestFile(big, big_contents, 1000);
+    struct stat big_sb;
+    assert_int_equal(stat(big, &big_sb), 0);
+    assert_true(FileCache_Acquire(big, &big_sb, &data, &size) == NULL);
+
+    FileCache_LogStats(LOG_LEVEL_VERBOSE);
+    FileCache_Destroy();
+}
+
+int main()
+{
+    tests_setup();
+
+    const UnitTest tests[] =
+        {
+            unit_test(test_acquire_uninitialised),
+            unit_test(test_acquire_hit_and_change),
+            unit_test(test_rewrite_same_second_same_size),
+            unit_test(test_eviction),
+        };
+
+    PRINT_TEST_BANNER();
+    int ret = run_tests(tests);
+
+    tests_teardown();
+    return ret;
+}
@@ -0,0 +1,107 @@
+#include <test.h>
+
+#include <string_intern.h>
+#include <string_lib.h>
+#include <alloc.h>
+
+static void test_intern(void)
+{
+    char *a = xstrdup("some_variable");
+    char *b = xstrdup("some_variable");
+
+    const char *ia = StringIntern(a);
+    const char *ib = StringIntern(b);
+    assert_true(ia != a);
+    assert_true(ia == ib);
+    assert_string_equal(ia, "some_variable");
+
+    /* The interned copy outlives the original. */
+    free(a);
+    free(b);
+    assert_string_equal(ia, "some_variable");
+    assert_true(StringIntern(ia) == ia);
+
+    assert_true(StringIntern("other_variable") != ia);
+    assert_true(StringIntern(NULL) == NULL);
+}
+
+static void test_find(void)
+{
+    assert_true(StringInternFind("never_interned_before") == NULL);
+    assert_true(StringInternFind(NULL) == NULL);
+
+    const char *interned = StringIntern("interned_now");
+    assert_true(StringInternFind("interned_now") == interned);
+}
+
+static void test_hash(void)
+{
+    const char *strings[] = { "", "a", "default", "sys", "this", "fqhost" };
+
+    for (size_t i = 0; i < sizeof(strings) / sizeof(strings[0]); i++)
+    {
+        const char *interned = StringIntern(strings[i]);
+        assert_int_equal(StringInternHash(interned),
+                         StringHash(strings[i], 0));
+    }
+}
+
+static void test_release(void)
+{
+    const char *a = StringIntern("released_name");
+    const char *b = StringIntern("released_name");
+    assert_true(a == b);
+    assert_true(StringInternRetain(a) == a);
+
+    StringInternRelease(a);
+    StringInternRelease(b);
+    assert_true(StringInternFind("released_name") == a);
+
+    /* Freed with the last reference. */
+    StringInternRelease(a);
+    assert_true(StringInternFind("released_name") == NULL);
+
+    StringInternRetain(NULL);
+    StringInternRelease(NULL);
+
+    const char *again = StringIntern("released_name");
+    assert_string_equal(again, "released_name");
+    assert_int_equal(StringInternHash(again), StringHash("released_name", 0));
+    StringInternRelease(again);
+}
+
+static void test_many(void)
+{
+    const char *interned[2000];
+    for (int i = 0; i < 2000; i++)
+    {
+        char name[32];
+        snprintf(name, sizeof(name), "name_%d", i);
+        interned[i] = StringIntern(name);
+    }
+
+    for (int i = 0; i < 2000; i++)
+    {
+        char name[32];
+        snprintf(name, sizeof(name), "name_%d", i);
+        assert_true(StringInternFind(name) == interned[i]);
+        assert_string_equal(interned[i], name);
+    }
+
+    StringIntern_LogStats(LOG_LEVEL_VERBOSE);
+}
+
+int main()
+{
+    PRINT_TEST_BANNER();
+    const UnitTest tests[] =
+    {
+        unit_test(test_intern),
+        unit_test(test_find),
+        unit_test(test_hash),
+        unit_test(test_release),
+        unit_test(test_many),
+    };
+
+    return run_tests(tests);
+}
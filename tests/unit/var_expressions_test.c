@@ -1,6 +1,7 @@
 #include <test.h>
 
 #include <var_expressions.h>
+#include <string_intern.h>
 
 static void test_plain_variable_with_no_stuff_in_it(void)
 {
@@ -181,6 +182,47 @@ static void test_to_string_unqualified(void)
     }
 }
 
+static void test_interned(void)
+{
+    VarRef *a = VarRefParse("ns:scope.lval[x]");
+    VarRef *b = VarRefParseFromScope("lval[x]", "ns:scope");
+
+    /* Names are shared, indices are not. */
+    assert_true(a->ns == b->ns);
+    assert_true(a->scope == b->scope);
+    assert_true(a->lval == b->lval);
+    assert_true(a->indices[0] != b->indices[0]);
+    assert_true(VarRefEqual_untyped(a, b));
+    assert_int_equal(VarRefHash_untyped(a, 0), VarRefHash_untyped(b, 0));
+
+    VarRefSetMeta(a, true);
+    assert_string_equal("scope_meta", a->scope);
+    assert_false(VarRefEqual_untyped(a, b));
+    VarRefSetMeta(a, false);
+    assert_true(a->scope == b->scope);
+
+    VarRefDestroy(a);
+    VarRefDestroy(b);
+
+    /* No namespace is the default one. */
+    a = VarRefParse("default:scope.lval");
+    b = VarRefParse("scope.lval");
+    assert_true(b->ns == NULL);
+    assert_true(VarRefEqual_untyped(a, b));
+    assert_int_equal(VarRefHash_untyped(a, 0), VarRefHash_untyped(b, 0));
+    VarRefDestroy(a);
+    VarRefDestroy(b);
+
+    /* Names are freed with the last VarRef using them. */
+    a = VarRefParse("unique_scope_name.unique_lval_name");
+    b = VarRefCopy(a);
+    VarRefDestroy(a);
+    assert_true(StringInternFind("unique_lval_name") == b->lval);
+    VarRefDestroy(b);
+    assert_true(StringInternFind("unique_scope_name") == NULL);
+    assert_true(StringInternFind("unique_lval_name") == NULL);
+}
+
 int main()
 {
     PRINT_TEST_BANNER();
@@ -198,6 +240,7 @@ int main()
         unit_test(test_special_scope),
         unit_test(test_to_string_qualified),
         unit_test(test_to_string_unqualified),
+        unit_test(test_interned),
     };
 
     return run_tests(tests);